@@ -9,6 +9,7 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 20:10 ty       checker descriptors for EVENT_CHECK_TABLE
  08/05/13 15:19 jec      modifications to suit new portable type definitions
  01/15/12 12:00 jec      new header for local types
  10/16/11 17:17 jec      started coding
@@ -23,6 +24,20 @@ typedef bool CheckFunc (void);
 
 typedef CheckFunc (*pCheckFunc);
 
+typedef struct
+{
+  pCheckFunc Checker;
+  uint16_t   Period;      // fewest timer ticks between calls, 0 for every pass
+}ES_CheckDesc_t;
+
+// EVENT_CHECK_TABLE rows expand through one of these, picked by the Kind
+// column, so INTERRUPT rows drop out of the table. The extra level lets Kind
+// be a macro (BEACON_CHECK_KIND) that expands before it is pasted
+#define ES_CHECK_ROW(Checker, Period, Kind) ES_CHECK_PASTE(Checker, Period, Kind)
+#define ES_CHECK_PASTE(Checker, Period, Kind) ES_CHECK_ROW_##Kind(Checker, Period)
+#define ES_CHECK_ROW_POLLED(Checker, Period) { Checker, Period },
+#define ES_CHECK_ROW_INTERRUPT(Checker, Period)
+
 bool ES_CheckUserEvents(void);
 
 #endif  // ES_CheckEvents_H
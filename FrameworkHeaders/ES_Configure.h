@@ -9,6 +9,51 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 23:59  ty      the profiler, run budget, trace, startup & ISR stats
+                         are off by default, HostSim turns them on
+ 10/14/26 23:59  ty      added BeaconDetectService ahead of MainLogicFSM,
+                         timer 1 is its PRINT_FREQUENCY_TIMER
+ 10/14/26 23:59  ty      added PulseCaptureService ahead of MainLogicFSM,
+                         ES_PULSE_CAPTURED, ES_PULSE_MEASURED & its ISR rows
+ 10/14/26 23:59  ty      added ES_URGENT_EVENT_TABLE & ES_URGENT_QUEUE_SIZE
+ 10/14/26 23:59  ty      the queues are twice as deep, in the same RAM now
+                         that an entry is packed
+ 10/14/26 23:59  ty      added USE_HIL_HARNESS
+ 10/14/26 23:58  ty      added USE_FRAMED_COMMANDS
+ 10/14/26 23:55  ty      added ES_TICK_HOOK, for the input debounce
+ 10/14/26 23:50  ty      Check4InputChanges in place of Check4BeaconDetected
+ 10/14/26 23:40  ty      added ES_STARTUP_STATS
+ 10/14/26 23:30  ty      added ES_EMERGENCY_STOP, the CN ISR row is for
+                         the stop input too
+ 10/14/26 23:10  ty      added the short timer ISR rows
+ 10/14/26 23:00  ty      added ES_DEFER_POOL_SIZE & ES_DEFER_POOL_QUOTA
+ 10/14/26 22:50  ty      added SPIBusService ahead of CommandRetrieveService,
+                         timer 0 is its SPI_BUS_TIMER & the SPI1Command
+                         ISR row is gone
+ 10/14/26 22:40  ty      added ES_SPI_TRANSFER_DONE & the SPI DMA ISR rows
+ 10/14/26 22:30  ty      added TelemetryService as service 1 & its timer
+ 10/14/26 22:20  ty      added ES_LOG_LEVEL & ES_LOG_MAX_LEVEL
+ 10/14/26 21:40  ty      added SerialCommandService as service 1,
+                         ES_SERIAL_RX & USE_UART_RX_ISR
+ 10/14/26 21:30  ty      added ES_ISR_STATS & ES_ISR_TABLE
+ 10/14/26 21:20  ty      added ES_TRACE_DISPATCH & ES_TRACE_DEPTH
+ 10/14/26 20:50  ty      MAX_NUM_SERVICES can be 32
+ 10/14/26 20:30  ty      the services come from ES_SERVICE_TABLE rather than
+                         the SERV_n_ definitions & NUM_SERVICES
+ 10/14/26 20:10  ty      EVENT_CHECK_LIST became EVENT_CHECK_TABLE, with a
+                         poll period & kind for each checker
+ 10/14/26 19:50  ty      added ES_RUN_BUDGET & the service deadline
+ 10/14/26 18:50  ty      added ES_EVENT_WIDE
+ 10/14/26 18:20  ty      added USE_CN_INPUT_EVENTS
+ 10/14/26 18:00  ty      added ES_TAPE_LOST, ES_LINE_POSITION & LINE_LOST_TIMER
+ 10/14/26 17:40  ty      added ES_AD_BLOCK_READY
+ 10/14/26 17:20  ty      added SpeedControlService as service 4 &
+                         ES_MOVE_COMPLETE
+ 10/14/26 16:50  ty      added ES_QUEUE_SIZING_MODE
+ 10/14/26 16:10  ty      added ES_PROFILE_DISPATCH & ES_NUM_EVENT_TYPES
+ 10/14/26 11:20  ty      added ES_NUM_TIMERS, timers 16-31 &
+                         ES_TIMER_32BIT_DURATIONS
+ 10/14/26 10:05  ty      added SERV_n_QUEUE_KIND to pick the queue kind
  12/19/16 20:19  jec     removed EVENT_CHECK_HEADER definition. This goes with
                          the V2.3 move to a single wrapper for event checking
                          headers
@@ -26,227 +71,137 @@
 
 /****************************************************************************/
 // The maximum number of services sets an upper bound on the number of
-// services that the framework will handle. Reasonable values are 8 and 16
-// corresponding to an 8-bit(uint8_t) and 16-bit(uint16_t) Ready variable size
+// services that the framework will handle. It can be 16 or 32, for a 16 bit
+// (uint16_t) or a 32 bit (uint32_t) Ready variable & subscriber masks. Leave
+// it at 16 unless ES_SERVICE_TABLE has more rows than that
 #define MAX_NUM_SERVICES 16
 
 /****************************************************************************/
-// This macro determines that nuber of services that are *actually* used in
-// a particular application. It will vary in value from 1 to MAX_NUM_SERVICES
-#define NUM_SERVICES 4
+// Uncomment to have ES_Run time every call to a run function, and the time
+// each event waited in its queue, by service & event type (see
+// ES_Profiler.c). The tables take 20 bytes per service/event type pair,
+// several K for this table, so it is off unless something is being measured.
+// tools/memory_budget.json is for the build with this & the instrumentation
+// below all left off
+// #define ES_PROFILE_DISPATCH
 
 /****************************************************************************/
-// These are the definitions for Service 0, the lowest priority service.
-// Every Events and Services application must have a Service 0. Further
-// services are added in numeric sequence (1,2,3,...) with increasing
-// priorities
-// the header file with the public function prototypes
-#define SERV_0_HEADER "TestHarnessService0.h"
-// the name of the Init function
-#define SERV_0_INIT InitTestHarnessService0
-// the name of the run function
-#define SERV_0_RUN RunTestHarnessService0
-// How big should this services Queue be?
-#define SERV_0_QUEUE_SIZE 5
+// Uncomment to have ES_Run give the event checkers & the UART a turn at
+// least every ES_RUN_BUDGET_DISPATCHES run function calls, or ES_RUN_BUDGET_US
+// of dispatching, even while queues are still busy, so a burst of events
+// can't starve them. Any run function that takes longer than
+// ES_SERVICE_DEADLINE_US is counted as an overrun against its service (see
+// ES_ReportRunStats, 'b' in TestHarnessService0).
+// #define ES_RUN_BUDGET
+#define ES_RUN_BUDGET_DISPATCHES 8
+#define ES_RUN_BUDGET_US 2000
+#define ES_SERVICE_DEADLINE_US 500
 
 /****************************************************************************/
-// The following sections are used to define the parameters for each of the
-// services. You only need to fill out as many as the number of services
-// defined by NUM_SERVICES
-/****************************************************************************/
-// These are the definitions for Service 1
-#if NUM_SERVICES > 1
-// the header file with the public function prototypes
-#define SERV_1_HEADER "CommandRetrieveService.h"
-// the name of the Init function
-#define SERV_1_INIT InitCommandRetrieveService
-// the name of the run function
-#define SERV_1_RUN RunCommandRetrieveService
-// How big should this services Queue be?
-#define SERV_1_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 2
-#if NUM_SERVICES > 2
-// the header file with the public function prototypes
-#define SERV_2_HEADER "MainLogicFSM.h"
-// the name of the Init function
-#define SERV_2_INIT InitMainLogicFSM
-// the name of the run function
-#define SERV_2_RUN RunMainLogicFSM
-// How big should this services Queue be?
-#define SERV_2_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 3
-#if NUM_SERVICES > 3
-// the header file with the public function prototypes
-#define SERV_3_HEADER "DCMotorService.h"
-// the name of the Init function
-#define SERV_3_INIT InitDCMotorService
-// the name of the run function
-#define SERV_3_RUN RunDCMotorService
-// How big should this services Queue be?
-#define SERV_3_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 4
-#if NUM_SERVICES > 4
-// the header file with the public function prototypes
-#define SERV_4_HEADER "BeaconDetectService.h"
-// the name of the Init function
-#define SERV_4_INIT InitBeaconDetectService
-// the name of the run function
-#define SERV_4_RUN RunBeaconDetectService
-// How big should this services Queue be?
-#define SERV_4_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 5
-#if NUM_SERVICES > 5
-// the header file with the public function prototypes
-#define SERV_5_HEADER "TestHarnessService5.h"
-// the name of the Init function
-#define SERV_5_INIT InitTestHarnessService5
-// the name of the run function
-#define SERV_5_RUN RunTestHarnessService5
-// How big should this services Queue be?
-#define SERV_5_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 6
-#if NUM_SERVICES > 6
-// the header file with the public function prototypes
-#define SERV_6_HEADER "TestHarnessService6.h"
-// the name of the Init function
-#define SERV_6_INIT InitTestHarnessService6
-// the name of the run function
-#define SERV_6_RUN RunTestHarnessService6
-// How big should this services Queue be?
-#define SERV_6_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 7
-#if NUM_SERVICES > 7
-// the header file with the public function prototypes
-#define SERV_7_HEADER "TestHarnessService7.h"
-// the name of the Init function
-#define SERV_7_INIT InitTestHarnessService7
-// the name of the run function
-#define SERV_7_RUN RunTestHarnessService7
-// How big should this services Queue be?
-#define SERV_7_QUEUE_SIZE 3
-#endif
+// Uncomment to have ES_Run keep a record of the last ES_TRACE_DEPTH
+// dispatches: when, which service, the event & how long it ran. The record
+// is dumped as a binary frame by _fassert, & by 't' in TestHarnessService0,
+// for tools/binlog_decode.py (see ES_Trace.c). It takes 12 bytes per entry.
+// ES_TRACE_DEPTH must be a power of 2
+// #define ES_TRACE_DISPATCH
+#define ES_TRACE_DEPTH 32
 
 /****************************************************************************/
-// These are the definitions for Service 8
-#if NUM_SERVICES > 8
-// the header file with the public function prototypes
-#define SERV_8_HEADER "TestHarnessService8.h"
-// the name of the Init function
-#define SERV_8_INIT InitTestHarnessService8
-// the name of the run function
-#define SERV_8_RUN RunTestHarnessService8
-// How big should this services Queue be?
-#define SERV_8_QUEUE_SIZE 3
-#endif
+// The log level of a module that doesn't set LOG_MODULE_LEVEL, & the most
+// that any module gets (see ES_Log.h). LOG_LEVEL_INFO gives the state
+// changes, LOG_LEVEL_DEBUG adds the per poll & per command chatter. Set
+// ES_LOG_MAX_LEVEL to LOG_LEVEL_WARN or below for a competition build
+#define ES_LOG_LEVEL LOG_LEVEL_INFO
+#define ES_LOG_MAX_LEVEL LOG_LEVEL_DEBUG
 
 /****************************************************************************/
-// These are the definitions for Service 9
-#if NUM_SERVICES > 9
-// the header file with the public function prototypes
-#define SERV_9_HEADER "TestHarnessService9.h"
-// the name of the Init function
-#define SERV_9_INIT InitTestHarnessService9
-// the name of the run function
-#define SERV_9_RUN RunTestHarnessService9
-// How big should this services Queue be?
-#define SERV_9_QUEUE_SIZE 3
-#endif
+// Uncomment to have ES_Initialize time each service's init function &
+// ES_Run note when the last service has run its ES_INIT, from which point
+// the application is up (see ES_ReportStartup, 'u' in TestHarnessService0).
+// It takes 4 bytes per service
+// #define ES_STARTUP_STATS
 
 /****************************************************************************/
-// These are the definitions for Service 10
-#if NUM_SERVICES > 10
-// the header file with the public function prototypes
-#define SERV_10_HEADER "TestHarnessService10.h"
-// the name of the Init function
-#define SERV_10_INIT InitTestHarnessService10
-// the name of the run function
-#define SERV_10_RUN RunTestHarnessService10
-// How big should this services Queue be?
-#define SERV_10_QUEUE_SIZE 3
-#endif
+// Uncomment to have each ISR in ES_ISR_TABLE record its entry latency &
+// its duration, min/max & a histogram of each (see ES_IsrStats.c, 'i' in
+// TestHarnessService0). It takes 64 bytes per row. Left off, the
+// calls in the ISRs compile away. One X(Name, Label) row per vector, the
+// ISR uses ES_ISR(Name) & Label is for the report
+// #define ES_ISR_STATS
+#define ES_ISR_TABLE(X)                     \
+  X(Timer3Rollover,  "T3 capture time")     \
+  X(BeaconCapture,   "IC1 beacon")          \
+  X(LeftEncoder,     "IC2 left encoder")    \
+  X(RightEncoder,    "IC5 right encoder")   \
+  X(PulseCapture3,   "IC3 pulse capture")   \
+  X(PulseCapture4,   "IC4 pulse capture")   \
+  X(PWMCommit,       "T2 PWM commit")       \
+  X(ControlLoop,     "T4 control loop")     \
+  X(SPI1Transfer,    "SPI1 DMA transfer")   \
+  X(SPI2Transfer,    "SPI2 DMA transfer")   \
+  X(SysTick,         "core timer tick")     \
+  X(UARTRx,          "U1 receive")          \
+  X(ADCStream,       "ADC stream")          \
+  X(InputChange,     "CN beacon & stop")    \
+  X(ShortTimerA,     "T5 short timer A")    \
+  X(ShortTimerB,     "T1 short timer B")
 
 /****************************************************************************/
-// These are the definitions for Service 11
-#if NUM_SERVICES > 11
-// the header file with the public function prototypes
-#define SERV_11_HEADER "TestHarnessService11.h"
-// the name of the Init function
-#define SERV_11_INIT InitTestHarnessService11
-// the name of the run function
-#define SERV_11_RUN RunTestHarnessService11
-// How big should this services Queue be?
-#define SERV_11_QUEUE_SIZE 3
-#endif
+// Uncomment to build every service queue ES_QUEUE_SIZING_DEPTH deep, no
+// matter what ES_SERVICE_TABLE says. Run the application through its paces
+// then use ES_ReportQueueStats ('q' in TestHarnessService0) to get the
+// measured high water marks & a suggested QueueSize for each service.
+// ES_QUEUE_SIZING_DEPTH must be a power of 2 if any queue is the SPSC kind
+//#define ES_QUEUE_SIZING_MODE
+#define ES_QUEUE_SIZING_DEPTH 32
 
 /****************************************************************************/
-// These are the definitions for Service 12
-#if NUM_SERVICES > 12
-// the header file with the public function prototypes
-#define SERV_12_HEADER "TestHarnessService12.h"
-// the name of the Init function
-#define SERV_12_INIT InitTestHarnessService12
-// the name of the run function
-#define SERV_12_RUN RunTestHarnessService12
-// How big should this services Queue be?
-#define SERV_12_QUEUE_SIZE 3
-#endif
+// The events that services set aside with ES_DeferToPool wait in one pool
+// of ES_DEFER_POOL_SIZE entries, rather than each service keeping its own
+// deferral queue for its worst case. No one service may hold more than
+// ES_DEFER_POOL_QUOTA of them, so a burst to one can't starve the rest. The
+// pool takes 6 bytes per entry (12 with ES_EVENT_WIDE)
+#define ES_DEFER_POOL_SIZE 8
+#define ES_DEFER_POOL_QUOTA 4
 
 /****************************************************************************/
-// These are the definitions for Service 13
-#if NUM_SERVICES > 13
-// the header file with the public function prototypes
-#define SERV_13_HEADER "TestHarnessService13.h"
-// the name of the Init function
-#define SERV_13_INIT InitTestHarnessService13
-// the name of the run function
-#define SERV_13_RUN RunTestHarnessService13
-// How big should this services Queue be?
-#define SERV_13_QUEUE_SIZE 3
-#endif
+// This is the table of services, one X(Name, QueueSize, QueueKind) row each.
+// The first row, Service 0, is the lowest priority & every Events and
+// Services application must have one. Each row after it has a higher
+// priority than the one before.
+// Name is the base name of the service: the framework calls InitName &
+// RunName, TIMERn_RESP_FUNC entries post with ES_TIMER_POSTS_TO(Name) &
+// the service's header goes in ES_ServiceHeaders.h. QueueKind is one of the
+// ES_QUEUE_KIND_ values in ES_Queue.h. Each entry takes 4 bytes (8 with
+// ES_EVENT_WIDE) & each queue 6 more for its state
+#define ES_SERVICE_TABLE(X)                                   \
+  X(TestHarnessService0,   10, ES_QUEUE_KIND_CRITICAL)        \
+  X(TelemetryService,       6, ES_QUEUE_KIND_CRITICAL)        \
+  X(SerialCommandService,   6, ES_QUEUE_KIND_CRITICAL)        \
+  X(SPIBusService,          6, ES_QUEUE_KIND_CRITICAL)        \
+  X(CommandRetrieveService, 6, ES_QUEUE_KIND_CRITICAL)        \
+  X(PulseCaptureService,    2, ES_QUEUE_KIND_CRITICAL)        \
+  X(BeaconDetectService,    4, ES_QUEUE_KIND_CRITICAL)        \
+  X(MainLogicFSM,           6, ES_QUEUE_KIND_CRITICAL)        \
+  X(DCMotorService,         6, ES_QUEUE_KIND_CRITICAL)        \
+  X(SpeedControlService,    6, ES_QUEUE_KIND_CRITICAL)
 
-/****************************************************************************/
-// These are the definitions for Service 14
-#if NUM_SERVICES > 14
-// the header file with the public function prototypes
-#define SERV_14_HEADER "TestHarnessService14.h"
-// the name of the Init function
-#define SERV_14_INIT InitTestHarnessService14
-// the name of the run function
-#define SERV_14_RUN RunTestHarnessService14
-// How big should this services Queue be?
-#define SERV_14_QUEUE_SIZE 3
-#endif
+// Nothing to edit here. The priority of each service, SERV_PRIORITY(Name),
+// & the number of services come from the table
+#define SERV_PRIORITY(Name) SERV_PRIORITY_##Name
+#define ES_SERVICE_ID_ROW(Name, QueueSize, QueueKind) SERV_PRIORITY(Name),
+typedef enum
+{
+  ES_SERVICE_TABLE(ES_SERVICE_ID_ROW)
+  NUM_SERVICES
+}ES_ServiceId_t;
 
 /****************************************************************************/
-// These are the definitions for Service 15
-#if NUM_SERVICES > 15
-// the header file with the public function prototypes
-#define SERV_15_HEADER "TestHarnessService15.h"
-// the name of the Init function
-#define SERV_15_INIT InitTestHarnessService15
-// the name of the run function
-#define SERV_15_RUN RunTestHarnessService15
-// How big should this services Queue be?
-#define SERV_15_QUEUE_SIZE 3
-#endif
+// Uncomment to give every event a 32 bit EventData field as well as the 16
+// bit parameter, for a time stamp or a payload that won't fit in the
+// parameter. It costs 4 bytes for every queue entry, so leave it off
+// unless something uses it. See ES_Events.h
+// #define ES_EVENT_WIDE
 
 /****************************************************************************/
 // Name/define the events of interest
@@ -266,9 +221,32 @@ typedef enum
   ES_COMMAND_RETRIEVED,     /* signals a new command byte from SPI */
   ES_BEACON_DETECTED,       /* signals a beacon detection */
   ES_TAPE_DETECTED,          /* signals a tape detection */
-  ES_NEW_COMMAND            /* New command received from command generator */
+  ES_NEW_COMMAND,           /* New command received from command generator */
+  ES_MOVE_COMPLETE,         /* speed control finished a move with a distance */
+  ES_AD_BLOCK_READY,        /* a block of streamed A/D samples is complete */
+  ES_TAPE_LOST,             /* the tape array is no longer over the line */
+  ES_LINE_POSITION,         /* new line position, (int16_t)EventParam */
+  ES_SERIAL_RX,             /* the UART receive ISR has new bytes waiting */
+  ES_SPI_TRANSFER_DONE,     /* an SPI transfer is over, param is its tag */
+  ES_EMERGENCY_STOP,        /* the stop input went active, motors already 0 */
+  ES_PULSE_CAPTURED,        /* a capture ISR has pulses for the service */
+  ES_PULSE_MEASURED,        /* a pulse, param is its channel, data its width */
+  ES_NUM_EVENT_TYPES        /* not an event, must stay last. Sizes tables */
 }ES_EventType_t;
 
+/****************************************************************************/
+// The urgent events, one X(EventType) row each. However they are posted or
+// published, they go in the service's express lane, which ES_Run empties,
+// highest priority service first, before it takes anything from the normal
+// queues. Each lane is FIFO & holds ES_URGENT_QUEUE_SIZE events (4 bytes
+// each, 8 with ES_EVENT_WIDE). Keep this to the events that a sensor or the
+// stop input raise, that must be handled next
+#define ES_URGENT_EVENT_TABLE(X)                              \
+  X(ES_EMERGENCY_STOP)                                        \
+  X(ES_TAPE_DETECTED)                                         \
+  X(ES_TAPE_LOST)
+#define ES_URGENT_QUEUE_SIZE 2
+
 /****************************************************************************/
 // These are the definitions for the Distribution lists. Each definition
 // should be a comma separated list of post functions to indicate which
@@ -300,25 +278,81 @@ typedef enum
 #endif
 
 /****************************************************************************/
-// This is the list of event checking functions
-#define EVENT_CHECK_LIST Check4Keystroke, Check4TapeDetected, Check4BeaconDetected
+// Beacon edges come from the change notice ISR in Ports.c rather than the
+// polled input scan. Comment out to put the beacon back in
+// DIGITAL_INPUT_TABLE (Ports.h)
+#define USE_CN_INPUT_EVENTS
+
+/****************************************************************************/
+// Keystrokes come from the UART receive ISR in terminal.c, through
+// SerialCommandService, rather than Check4Keystroke polling the UART.
+// Comment out to go back to Check4Keystroke
+#define USE_UART_RX_ISR
+
+/****************************************************************************/
+// The command generator sends frames (CommandFrame.h), a sync, an opcode,
+// its arguments & a CRC-8, rather than a 0xFF flag & then the command
+// byte. Uncomment for a generator that speaks the framed protocol
+//#define USE_FRAMED_COMMANDS
+
+/****************************************************************************/
+// TestHarnessService0 runs the HIL regression script of HilHarness.h on 'h'
+// & prints the log as golden rows on 'g'. It takes TIMER_A of the short
+// timers while a run is going. See HilHarness.h
+//#define USE_HIL_HARNESS
+
+/****************************************************************************/
+// This is the table of event checking functions, one X(Checker, Period, Kind)
+// row each. Period is the fewest timer ticks (mS) between calls, 0 to call
+// it on every pass. Kind is POLLED, or INTERRUPT for an input whose events
+// come from an ISR; INTERRUPT rows are left out of the polling entirely.
+// ES_CheckUserEvents takes the rows round robin, starting after the last
+// checker that found an event, so a busy checker can't starve the rest
+#ifdef USE_UART_RX_ISR
+#define KEYSTROKE_CHECK_KIND INTERRUPT
+#else
+#define KEYSTROKE_CHECK_KIND POLLED
+#endif
+
+#define EVENT_CHECK_TABLE(X)                          \
+  X(Check4Keystroke,      0, KEYSTROKE_CHECK_KIND)    \
+  X(Check4TapeDetected,   2, POLLED)                  \
+  X(Check4InputChanges,   0, POLLED)
+
+/****************************************************************************/
+// An application function for the tick ISR to call once a tick, after the
+// time is updated, for sampling that needs a steady rate. It runs at the
+// tick's IPL, so keep it short. With ES_TICKLESS_IDLE it isn't called for
+// the ticks the CPU idles through. Comment out for none
+#define ES_TICK_HOOK DebounceScannedInputs
+
+/****************************************************************************/
+// The number of timers that the timer module supports (16 or 32)
+#define ES_NUM_TIMERS 32
+
+// uncomment this to count timers with 32 bits rather than 16, this allows
+// times longer than 65.5 seconds (at a 1mS tick) at the cost of RAM
+//#define ES_TIMER_32BIT_DURATIONS
 
 /****************************************************************************/
 // These are the definitions for the post functions to be executed when the
-// corresponding timer expires. All 16 must be defined. If you are not using
-// a timer, then you should use TIMER_UNUSED
+// corresponding timer expires. All ES_NUM_TIMERS must be defined. If you are
+// not using a timer, then you should use TIMER_UNUSED
 // Unlike services, any combination of timers may be used and there is no
 // priority in servicing them
+// A timer that posts to a service names it with ES_TIMER_POSTS_TO, which
+// won't compile unless the service is in ES_SERVICE_TABLE
 #define TIMER_UNUSED ((pPostFunc)0)
-#define TIMER0_RESP_FUNC PostCommandRetrieveService
-// #define TIMER1_RESP_FUNC PostBeaconDetectService
-#define TIMER1_RESP_FUNC TIMER_UNUSED
-#define TIMER2_RESP_FUNC PostMainLogicFSM
-#define TIMER3_RESP_FUNC PostMainLogicFSM
-#define TIMER4_RESP_FUNC PostMainLogicFSM
+#define ES_TIMER_POSTS_TO(Name) \
+  ((SERV_PRIORITY(Name) < NUM_SERVICES) ? Post##Name : TIMER_UNUSED)
+#define TIMER0_RESP_FUNC ES_TIMER_POSTS_TO(SPIBusService)
+#define TIMER1_RESP_FUNC ES_TIMER_POSTS_TO(BeaconDetectService)
+#define TIMER2_RESP_FUNC ES_TIMER_POSTS_TO(MainLogicFSM)
+#define TIMER3_RESP_FUNC ES_TIMER_POSTS_TO(MainLogicFSM)
+#define TIMER4_RESP_FUNC ES_TIMER_POSTS_TO(MainLogicFSM)
 #define TIMER5_RESP_FUNC TIMER_UNUSED
-#define TIMER6_RESP_FUNC TIMER_UNUSED
-#define TIMER7_RESP_FUNC TIMER_UNUSED
+#define TIMER6_RESP_FUNC ES_TIMER_POSTS_TO(MainLogicFSM)
+#define TIMER7_RESP_FUNC ES_TIMER_POSTS_TO(TelemetryService)
 #define TIMER8_RESP_FUNC TIMER_UNUSED
 #define TIMER9_RESP_FUNC TIMER_UNUSED
 #define TIMER10_RESP_FUNC TIMER_UNUSED
@@ -326,7 +360,23 @@ typedef enum
 #define TIMER12_RESP_FUNC TIMER_UNUSED
 #define TIMER13_RESP_FUNC TIMER_UNUSED
 #define TIMER14_RESP_FUNC TIMER_UNUSED
-#define TIMER15_RESP_FUNC PostTestHarnessService0
+#define TIMER15_RESP_FUNC ES_TIMER_POSTS_TO(TestHarnessService0)
+#define TIMER16_RESP_FUNC TIMER_UNUSED
+#define TIMER17_RESP_FUNC TIMER_UNUSED
+#define TIMER18_RESP_FUNC TIMER_UNUSED
+#define TIMER19_RESP_FUNC TIMER_UNUSED
+#define TIMER20_RESP_FUNC TIMER_UNUSED
+#define TIMER21_RESP_FUNC TIMER_UNUSED
+#define TIMER22_RESP_FUNC TIMER_UNUSED
+#define TIMER23_RESP_FUNC TIMER_UNUSED
+#define TIMER24_RESP_FUNC TIMER_UNUSED
+#define TIMER25_RESP_FUNC TIMER_UNUSED
+#define TIMER26_RESP_FUNC TIMER_UNUSED
+#define TIMER27_RESP_FUNC TIMER_UNUSED
+#define TIMER28_RESP_FUNC TIMER_UNUSED
+#define TIMER29_RESP_FUNC TIMER_UNUSED
+#define TIMER30_RESP_FUNC TIMER_UNUSED
+#define TIMER31_RESP_FUNC TIMER_UNUSED
 
 /****************************************************************************/
 // Give the timer numbers symbolc names to make it easier to move them
@@ -336,12 +386,14 @@ typedef enum
 // These symbolic names should be changed to be relevant to your application
 
 #define SERVICE0_TIMER 15
-#define COMMAND_SPI_TIMER 0
-// #define PRINT_FREQUENCY_TIMER 1
+#define SPI_BUS_TIMER 0
+#define PRINT_FREQUENCY_TIMER 1
 #define SIMPLE_MOVE_TIMER 2
 #define TAPE_SEARCH_TIMER 3
 #define BEACON_ALIGN_TIMER 4
 #define AD_TIMER 5
+#define LINE_LOST_TIMER 6
+#define TELEMETRY_TIMER 7
 
 
 #endif /* ES_CONFIGURE_H */
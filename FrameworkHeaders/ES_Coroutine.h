@@ -0,0 +1,98 @@
+/****************************************************************************
+ Module
+     ES_Coroutine.h
+ Description
+     stackless coroutines, for a sequence of steps run from a service's
+     events & written as one routine, top to bottom
+ Notes
+     A coroutine is a function of (ES_Co_t *, ES_Event_t) that returns
+     ES_CO_WAITING or ES_CO_DONE, with its body between ES_CO_BEGIN &
+     ES_CO_END. Its owner calls it with each event the sequence is waiting
+     on. An await ends the call it is in & the routine picks up after it on
+     the first later call whose event the await is waiting for, so every
+     await sees a new event, never the one it was reached on.
+
+     The body is one switch with a case at each await (the protothread
+     trick), & the ES_Co_t holds only the line to resume at, so an await
+     costs a compare & a jump & there is no stack per coroutine. That does
+     mean:
+       - locals don't keep their values across an await, keep anything a
+         later step needs in a static or the owner's variables
+       - an await can't be inside a switch of the routine's own
+       - one routine per line, the macros use __LINE__
+
+     ES_CO_AWAIT_TIMEOUT runs one of the ES_Timers, which the owner has to
+     route its ES_TIMEOUT to the routine as for any other event.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 23:59 ty      first pass
+*****************************************************************************/
+#ifndef ES_COROUTINE_H
+#define ES_COROUTINE_H
+
+#include "ES_Types.h"
+#include "ES_Events.h"
+#include "ES_Timers.h"
+
+typedef struct
+{
+  uint16_t Resume;  // __LINE__ of the await to go on from, 0 at the start
+}ES_Co_t;
+
+typedef enum
+{
+  ES_CO_WAITING,
+  ES_CO_DONE
+}ES_CoStatus_t;
+
+// Resume once the routine has run off its end, or exited
+#define ES_CO_FINISHED 0xFFFFu
+
+// (re)starts a coroutine from the top, on its next call
+#define ES_CO_INIT(pCo) ((pCo)->Resume = 0)
+#define ES_CO_IS_DONE(pCo) ((pCo)->Resume == ES_CO_FINISHED)
+
+#define ES_CO_BEGIN(pCo) switch ((pCo)->Resume) { case 0:
+
+#define ES_CO_END(pCo)                                                        \
+  }                                                                           \
+  (pCo)->Resume = ES_CO_FINISHED;                                             \
+  return ES_CO_DONE
+
+// waits for the next call on which Condition is true
+#define ES_CO_AWAIT(pCo, Condition)                                           \
+  do                                                                          \
+  {                                                                           \
+    (pCo)->Resume = __LINE__;                                                 \
+    return ES_CO_WAITING;                                                     \
+  case __LINE__:                                                              \
+    if (!(Condition))                                                         \
+    {                                                                         \
+      return ES_CO_WAITING;                                                   \
+    }                                                                         \
+  } while (0)
+
+// waits for the next event of type Type
+#define ES_CO_AWAIT_EVENT(pCo, ThisEvent, Type)                               \
+  ES_CO_AWAIT(pCo, (ThisEvent).EventType == (Type))
+
+// starts Timer for Ms & waits for it to run out
+#define ES_CO_AWAIT_TIMEOUT(pCo, ThisEvent, Timer, Ms)                        \
+  do                                                                          \
+  {                                                                           \
+    ES_Timer_InitTimer((Timer), (Ms));                                        \
+    ES_CO_AWAIT(pCo, ((ThisEvent).EventType == ES_TIMEOUT) &&                 \
+        ((ThisEvent).EventParam == (Timer)));                                 \
+  } while (0)
+
+// ends the routine here, as if it had run off the end
+#define ES_CO_EXIT(pCo)                                                       \
+  do                                                                          \
+  {                                                                           \
+    (pCo)->Resume = ES_CO_FINISHED;                                           \
+    return ES_CO_DONE;                                                        \
+  } while (0)
+
+#endif /* ES_COROUTINE_H */
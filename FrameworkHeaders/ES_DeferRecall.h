@@ -1,35 +1,41 @@
 #ifndef DEFER_RECALL_H
 #define DEFER_RECALL_H
 
+#include "ES_Configure.h"
 #include "ES_Queue.h"
 #include "ES_Events.h"
 
+// one service's use of the shared deferral pool (see ES_DeferToPool)
+typedef struct
+{
+  uint8_t  Count;     // events it has in the pool now
+  uint8_t  HighWater; // the most it has ever had at once
+  uint16_t Drops;     // defers refused because of the pool or its quota
+} ES_DeferStats_t;
+
 /****************************************************************************
  Function
    ES_InitDeferralQueueWith  (wrapper for ES_InitQueue )
    this is a straight re-naming to aid readability
  Parameters
-   EF_Event * pBlock : pointer to the block of memory to use for the Queue
-   unsigned char BlockSize: size of the block pointed to by pBlock
+   const ES_Queue_t * pQueue : the queue, from ES_DEFINE_QUEUE
  Returns
    max number of entries in the created queue
  Description
-   Initializes a queue structure at the beginning of the block of memory
+   Empties the queue
  Notes
-   you should pass it a block that is at least sizeof(ES_Queue_t) larger than
-   the number of entries that you want in the queue. Since the size of an
-   ES_Event (at 4 bytes; 2 enum, 2 param) is greater than the
-   sizeof(ES_Queue_t), you only need to declare an array of ES_Event
-   with 1 more element than you need for the actual queue.
+   declare the queue with ES_DEFINE_QUEUE(Name, Entries,
+   ES_QUEUE_KIND_CRITICAL) & pass &Name, each entry takes 4 bytes (8 with
+   ES_EVENT_WIDE)
 ****************************************************************************/
-#define ES_InitDeferralQueueWith(a, b) ES_InitQueue(a, b)
+#define ES_InitDeferralQueueWith(a) ES_InitQueue(a)
 
 /****************************************************************************
  Function
    ES_DeferEvent  (wrapper for ES_EnQueueLIFO)
    this is a straight re-naming to aid readability
  Parameters
-   ES_Event * pBlock : pointer to the block of memory in use as the Queue
+   const ES_Queue_t * pQueue : the queue
    ES_Event Event2Add : event to be added to the Queue
  Returns
    bool : true if the add was successful, false if not
@@ -43,8 +49,7 @@
      ES_RecallEvents
  Parameters
       uint8_t WhichService, number of the service to post Recalled event to
-      ES_Event * pBlock, pointer to the block of memory that implements the
-        Defer/Recall queue
+      const ES_Queue_t * pQueue, the Defer/Recall queue
  Returns
      bool true if an event was recalled, false if no event was left in queue
  Description
@@ -56,6 +61,45 @@
  Author
      J. Edward Carryer, 11/20/13 16:49
 ****************************************************************************/
-bool ES_RecallEvents(uint8_t WhichService, ES_Event_t *pBlock);
+bool ES_RecallEvents(uint8_t WhichService, const ES_Queue_t *pQueue);
+
+/****************************************************************************
+ Function
+     ES_DeferToPool
+ Parameters
+     uint8_t WhichService, the service that is setting the event aside
+     ES_Event_t ThisEvent, the event to set aside
+ Returns
+     bool true if it was kept, false if the pool is full or the service
+     already holds ES_DEFER_POOL_QUOTA events
+ Description
+     sets an event aside in the deferral pool that every service shares,
+     until ES_RecallFromPool(WhichService)
+ Notes
+     from the main loop only, not from an ISR
+ Author
+     Tianyu, 10/14/26 23:00
+****************************************************************************/
+bool ES_DeferToPool(uint8_t WhichService, ES_Event_t ThisEvent);
+
+/****************************************************************************
+ Function
+     ES_RecallFromPool
+ Parameters
+     uint8_t WhichService, the service to recall the events of
+ Returns
+     bool true if there were events & they went back in its queue
+ Description
+     puts all of the service's events from the pool back at the front of
+     its queue in one go, in the order they were deferred, so that they are
+     the next ones it runs. They leave the pool only if they all fit
+ Author
+     Tianyu, 10/14/26 23:00
+****************************************************************************/
+bool ES_RecallFromPool(uint8_t WhichService);
+
+uint8_t ES_GetDeferredCount(uint8_t WhichService);
+void ES_FlushDeferred(uint8_t WhichService);
+bool ES_GetDeferStats(uint8_t WhichService, ES_DeferStats_t *pStats);
 
 #endif
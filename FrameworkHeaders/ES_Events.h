@@ -4,10 +4,23 @@
  Description
      header file with definitions for the event structure
  Notes
+     With ES_EVENT_WIDE defined in ES_Configure.h the event has a 32 bit
+     EventData as well. Which event types fill it in, and whether it is a
+     time stamp (and in which clock) or a payload, is up to the poster, the
+     same as EventParam. Use ES_EVENT_SET_DATA & ES_EVENT_GET_DATA so the
+     code builds either way; without ES_EVENT_WIDE the set does nothing
+     and the get gives 0, and the event stays its usual size.
+
+     The queues keep events as ES_PackedEvent_t, with the type in a byte
+     rather than the enum, so an entry is 4 bytes (8 with ES_EVENT_WIDE)
+     rather than 8 (12). ES_PackEvent & ES_UnpackEvent convert, the rest of
+     the framework & the services only see ES_Event_t.
 
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 23:59 ty       added ES_PackedEvent_t for the queue entries
+ 10/14/26 18:50 ty       added the EventData field for ES_EVENT_WIDE
  10/19/17 14:22 jec      changed include to ES_Cpnfigre to get definition of
                          ES_EventTyp_t
  08/05/13 15:19 jec      modifications to suit new portable type definitions
@@ -28,6 +41,58 @@ typedef struct ES_Event
 {
   ES_EventType_t EventType;      // what kind of event?
   uint16_t EventParam;          // parameter value for use w/ this event
+#ifdef ES_EVENT_WIDE
+  uint32_t EventData;           // time stamp or wide payload
+#endif
 }ES_Event_t;
 
+#ifdef ES_EVENT_WIDE
+#define ES_EVENT_SET_DATA(Event, Data) ((Event).EventData = (uint32_t)(Data))
+#define ES_EVENT_GET_DATA(Event) ((Event).EventData)
+#else
+#define ES_EVENT_SET_DATA(Event, Data) ((void)0)
+#define ES_EVENT_GET_DATA(Event) ((uint32_t)0)
+#endif
+
+// an event as a queue keeps it, Spare pads the param to its alignment
+typedef struct
+{
+  uint8_t  EventType;
+  uint8_t  Spare;
+  uint16_t EventParam;
+#ifdef ES_EVENT_WIDE
+  uint32_t EventData;
+#endif
+}ES_PackedEvent_t;
+
+// the type has to fit its byte
+#if ES_NUM_EVENT_TYPES > 256
+#error "Too many event types to pack the type in a byte"
+#endif
+
+static inline ES_PackedEvent_t ES_PackEvent(ES_Event_t Event)
+{
+  ES_PackedEvent_t Packed;
+
+  Packed.EventType = (uint8_t)Event.EventType;
+  Packed.Spare = 0;
+  Packed.EventParam = Event.EventParam;
+#ifdef ES_EVENT_WIDE
+  Packed.EventData = Event.EventData;
+#endif
+  return Packed;
+}
+
+static inline ES_Event_t ES_UnpackEvent(ES_PackedEvent_t Packed)
+{
+  ES_Event_t Event;
+
+  Event.EventType = (ES_EventType_t)Packed.EventType;
+  Event.EventParam = Packed.EventParam;
+#ifdef ES_EVENT_WIDE
+  Event.EventData = Packed.EventData;
+#endif
+  return Event;
+}
+
 #endif /* ES_Events_H */
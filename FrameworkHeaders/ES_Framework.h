@@ -8,6 +8,15 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 23:59 ty       added ES_PostToServiceUrgent & ES_IsUrgentEvent
+ 10/14/26 23:40 ty       added the startup timing functions
+ 10/14/26 22:50 ty       added ES_PostBlockToServiceLIFO
+ 10/14/26 21:10 ty       added ES_FlushServiceQueue
+ 10/14/26 20:50 ty       ES_Publish returns an ES_ServiceMask_t
+ 10/14/26 19:50 ty       added the run function budget statistics
+ 10/14/26 19:30 ty       added ES_Subscribe, ES_Unsubscribe & ES_Publish
+ 10/14/26 19:10 ty       added ES_PostToServiceCoalesce
+ 10/14/26 16:50 ty       added the queue statistics functions
  11/02/13 17:06 jec      added ES_PostToServiceLIFO prototype
  08/05/13 15:00 jec      added #include for ES_Port.h to get portability stuff
  10/17/06 07:41 jec      started coding
@@ -19,6 +28,8 @@
 #include "ES_Types.h"
 #include "ES_Port.h"
 #include "ES_Events.h"
+#include "ES_Queue.h"
+#include "ES_LookupTables.h"
 
 // These includes are not strictly necessary for the framework, but simplify
 // the use of the framework by requiring only 2 include files
@@ -40,10 +51,37 @@ typedef enum
   FailedOther
 }ES_Return_t;
 
+// worst case & deadline overruns for one service's run function, in
+// _HW_GetCycleCount counts. Only kept in the ES_RUN_BUDGET build
+typedef struct
+{
+  uint32_t MaxCycles;       // longest run so far
+  uint16_t Overruns;        // runs longer than ES_SERVICE_DEADLINE_US
+  ES_EventType_t LastOverrunType; // event being run the last time
+}ES_RunStats_t;
+
 ES_Return_t ES_Initialize(TimerRate_t NewRate);
 ES_Return_t ES_Run(void);
 bool ES_PostAll(ES_Event_t ThisEvent);
 bool ES_PostToService(uint8_t WhichService, ES_Event_t ThisEvent);
 bool ES_PostToServiceLIFO(uint8_t WhichService, ES_Event_t TheEvent);
+bool ES_PostBlockToServiceLIFO(uint8_t WhichService,
+    const ES_Event_t *pEvents, uint8_t Count);
+bool ES_PostToServiceCoalesce(uint8_t WhichService, ES_Event_t TheEvent);
+bool ES_PostToServiceUrgent(uint8_t WhichService, ES_Event_t TheEvent);
+bool ES_IsUrgentEvent(ES_EventType_t WhichEvent);
+bool ES_Subscribe(uint8_t WhichService, ES_EventType_t WhichEvent);
+bool ES_Unsubscribe(uint8_t WhichService, ES_EventType_t WhichEvent);
+ES_ServiceMask_t ES_Publish(ES_Event_t ThisEvent);
+uint8_t ES_FlushServiceQueue(uint8_t WhichService);
+bool ES_GetServiceQueueStats(uint8_t WhichService, ES_QueueStats_t *pStats);
+void ES_ReportQueueStats(void);
+bool ES_GetRunStats(uint8_t WhichService, ES_RunStats_t *pStats);
+uint16_t ES_GetForcedBackgroundPasses(void);
+void ES_ReportRunStats(void);
+void ES_ResetRunStats(void);
+bool ES_GetInitCycles(uint8_t WhichService, uint32_t *pCycles);
+uint32_t ES_GetStartupCycles(void);
+void ES_ReportStartup(void);
 
 #endif   // ES_Framework_H
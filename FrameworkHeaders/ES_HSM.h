@@ -0,0 +1,76 @@
+/****************************************************************************
+ Module
+     ES_HSM.h
+ Description
+     header file for the table driven hierarchical state machine runtime
+ Notes
+     A state is a const ES_HSMState_t. Each one names its parent (NULL at
+     the top), optional entry, exit & during actions, an optional initial
+     child, and a table of rows that map an event type to a handler.
+
+     ES_HSM_Dispatch offers the event to the current (leaf) state first. The
+     state's during action runs, then its rows are searched in order. A
+     handler returns true if it consumed the event, false lets the search go
+     on, so a handler doubles as a guard. An event no row in a state
+     consumes goes on to the parent, so behaviour shared by several states
+     (e.g. a new command preempting whatever is running) lives once, in the
+     parent.
+
+     A handler asks for a transition with ES_HSM_Transition. It is taken
+     once the handler returns, in the same dispatch: exit actions from the
+     current leaf up to the common parent, then entry actions down to the
+     target and on through the target's initial children. A transition to
+     the current state, or to one of its parents, leaves and re-enters it.
+     Entry & exit actions must not ask for transitions.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 18:40 ty       started coding
+*****************************************************************************/
+#ifndef ES_HSM_H
+#define ES_HSM_H
+
+#include "ES_Types.h"
+#include "ES_Events.h"
+
+struct ES_HSM;
+struct ES_HSMState;
+
+typedef void ES_HSMAction_t (void);
+typedef void ES_HSMDuring_t (ES_Event_t);
+typedef bool ES_HSMHandler_t (struct ES_HSM *, ES_Event_t);
+
+typedef struct
+{
+  ES_EventType_t  EventType;
+  ES_HSMHandler_t *pHandler;
+}ES_HSMRow_t;
+
+typedef struct ES_HSMState
+{
+  const struct ES_HSMState  *pParent;
+  const struct ES_HSMState  *pInitial;  // child entered after this, or NULL
+  ES_HSMAction_t            *pEntry;
+  ES_HSMAction_t            *pExit;
+  ES_HSMDuring_t            *pDuring;
+  const ES_HSMRow_t         *pRows;
+  uint8_t                   NumRows;
+  uint8_t                   Id;         // for the owner's Query function
+}ES_HSMState_t;
+
+typedef struct ES_HSM
+{
+  const ES_HSMState_t *pCurrent;  // always a leaf
+  const ES_HSMState_t *pTarget;   // transition asked for in this dispatch
+}ES_HSM_t;
+
+// number of rows in a state's table, for ES_HSMState_t.NumRows
+#define ES_HSM_NUM_ROWS(Rows) ((uint8_t)(sizeof(Rows) / sizeof((Rows)[0])))
+
+void ES_HSM_Init(ES_HSM_t *pMachine, const ES_HSMState_t *pInitial);
+bool ES_HSM_Dispatch(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+void ES_HSM_Transition(ES_HSM_t *pMachine, const ES_HSMState_t *pTarget);
+const ES_HSMState_t *ES_HSM_GetState(const ES_HSM_t *pMachine);
+
+#endif // ES_HSM_H
@@ -0,0 +1,234 @@
+/****************************************************************************
+ Module
+     ES_IsrStats.h
+ Description
+     header file for the ISR latency & duration statistics kept when
+     ES_ISR_STATS is defined in ES_Configure.h
+ Notes
+     Each ISR in ES_ISR_TABLE brackets its body like this:
+
+       ES_IsrStats_Enter(ES_ISR(ControlLoop), <latency>);
+       ...
+       ES_IsrStats_Exit(ES_ISR(ControlLoop));
+
+     The latency is in core timer counts, from whatever raised the
+     interrupt (a compare match, a period match, a capture) to the call to
+     ES_IsrStats_Enter, so it includes the ISR's prologue. For a timer
+     period match it is the timer's count scaled up to core timer counts,
+     for the core timer it is Count - Compare. An ISR without a time
+     reference passes ES_ISR_LATENCY_UNKNOWN & only gets a duration. An ISR
+     that only finds its trigger time part way through, the input captures,
+     passes ES_ISR_LATENCY_UNKNOWN to Enter & calls ES_IsrStats_NoteLatency
+     once it knows, with the time since the trigger at that point.
+
+     The duration runs from ES_IsrStats_Enter to ES_IsrStats_Exit, so it
+     includes the time spent in any higher priority ISR that nested inside.
+
+     These are inline as they go into the ISRs, they are a few loads &
+     stores & one CLZ each. Each row is only written from its own ISR,
+     which can't nest with itself, so they need no critical region.
+     Without ES_ISR_STATS they compile away, arguments & all.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 21:30 ty      first pass
+*****************************************************************************/
+#ifndef ES_ISR_STATS_H
+#define ES_ISR_STATS_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+#include "ES_Port.h"
+
+#ifdef ES_ISR_STATS
+
+// the id of a row of ES_ISR_TABLE
+#define ES_ISR(Name) ES_ISR_##Name
+#define ES_ISR_ID_ROW(Name, Label) ES_ISR(Name),
+typedef enum
+{
+  ES_ISR_TABLE(ES_ISR_ID_ROW)
+  ES_NUM_ISRS
+}ES_IsrId_t;
+
+#define ES_ISR_LATENCY_UNKNOWN 0xFFFFFFFFu
+
+// histogram bucket 0 counts anything under 1 << ES_ISR_HIST_SHIFT core timer
+// counts, each bucket after it twice the width of the one before, the last
+// one everything from 1 << (ES_ISR_HIST_SHIFT + ES_ISR_HIST_BUCKETS - 2) up.
+// So with these: <0.8uS, <1.6uS, <3.2uS ... <51.2uS, >=51.2uS
+#define ES_ISR_HIST_BUCKETS 8
+#define ES_ISR_HIST_SHIFT 4
+
+typedef struct
+{
+  uint32_t Count;           // calls to Enter
+  uint32_t LatencyCount;    // of those, how many had a latency
+  uint32_t MinLatency;
+  uint32_t MaxLatency;
+  uint32_t MinDuration;
+  uint32_t MaxDuration;
+  uint32_t EntryStamp;      // cycle count at the last Enter
+  uint64_t SumDuration;
+  uint16_t LatencyHist[ES_ISR_HIST_BUCKETS];    // saturate at 0xFFFF
+  uint16_t DurationHist[ES_ISR_HIST_BUCKETS];
+}ES_IsrStats_t;
+
+extern ES_IsrStats_t ES_IsrStatsTable[ES_NUM_ISRS];
+
+// called by the application, normally from a keystroke
+bool ES_IsrStats_Get(ES_IsrId_t Which, ES_IsrStats_t *pStats);
+const char *ES_IsrStats_GetLabel(ES_IsrId_t Which);
+void ES_IsrStats_Report(void);
+void ES_IsrStats_Reset(void);
+
+/****************************************************************************
+ Function
+   ES_IsrStats_Bucket
+
+ Parameters
+   uint32_t : a latency or duration in core timer counts
+
+ Returns
+   uint8_t : the histogram bucket for it
+ Author
+   Tianyu, 10/14/26 21:30
+****************************************************************************/
+static inline uint8_t ES_IsrStats_Bucket(uint32_t Cycles)
+{
+  uint8_t Bucket;
+
+  if ((Cycles >> ES_ISR_HIST_SHIFT) == 0)
+  {
+    return 0;
+  }
+#ifdef _PORT_HAS_CLZ_
+  Bucket = (uint8_t)(32 - ES_ISR_HIST_SHIFT -
+      __builtin_clz((unsigned int)Cycles));
+#else
+  Cycles >>= ES_ISR_HIST_SHIFT;
+  for (Bucket = 0; Cycles != 0; Bucket++)
+  {
+    Cycles >>= 1;
+  }
+#endif
+  return (Bucket < ES_ISR_HIST_BUCKETS) ? Bucket : (ES_ISR_HIST_BUCKETS - 1);
+}
+
+/****************************************************************************
+ Function
+   ES_IsrStats_NoteLatency
+
+ Parameters
+   ES_IsrId_t : which ISR
+   uint32_t : core timer counts from the trigger to now
+
+ Returns
+   nothing
+
+ Description
+   records the latency of the current entry to this ISR, taking off the
+   time since ES_IsrStats_Enter
+ Notes
+   for an ISR that has to read its trigger time out of the hardware first.
+   Call it at most once per entry
+ Author
+   Tianyu, 10/14/26 21:30
+****************************************************************************/
+static inline void ES_IsrStats_NoteLatency(ES_IsrId_t Which,
+    uint32_t CyclesSinceTrigger)
+{
+  ES_IsrStats_t *pStats = &ES_IsrStatsTable[Which];
+  uint32_t SinceEnter = _HW_GetCycleCount() - pStats->EntryStamp;
+  uint32_t Latency = (CyclesSinceTrigger > SinceEnter) ?
+      (CyclesSinceTrigger - SinceEnter) : 0;
+  uint16_t *pBin = &pStats->LatencyHist[ES_IsrStats_Bucket(Latency)];
+
+  if ((pStats->LatencyCount == 0) || (Latency < pStats->MinLatency))
+  {
+    pStats->MinLatency = Latency;
+  }
+  if (Latency > pStats->MaxLatency)
+  {
+    pStats->MaxLatency = Latency;
+  }
+  pStats->LatencyCount++;
+  if (*pBin != 0xFFFF)
+  {
+    (*pBin)++;
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_IsrStats_Enter
+
+ Parameters
+   ES_IsrId_t : which ISR
+   uint32_t : core timer counts from the trigger to now, or
+              ES_ISR_LATENCY_UNKNOWN
+
+ Returns
+   nothing
+
+ Description
+   call first thing in the ISR, starts the duration measurement
+ Author
+   Tianyu, 10/14/26 21:30
+****************************************************************************/
+static inline void ES_IsrStats_Enter(ES_IsrId_t Which, uint32_t LatencyCycles)
+{
+  ES_IsrStatsTable[Which].EntryStamp = _HW_GetCycleCount();
+  ES_IsrStatsTable[Which].Count++;
+  if (LatencyCycles != ES_ISR_LATENCY_UNKNOWN)
+  {
+    ES_IsrStats_NoteLatency(Which, LatencyCycles);
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_IsrStats_Exit
+
+ Parameters
+   ES_IsrId_t : which ISR
+
+ Returns
+   nothing
+
+ Description
+   call last thing in the ISR, records the duration
+ Author
+   Tianyu, 10/14/26 21:30
+****************************************************************************/
+static inline void ES_IsrStats_Exit(ES_IsrId_t Which)
+{
+  ES_IsrStats_t *pStats = &ES_IsrStatsTable[Which];
+  uint32_t Duration = _HW_GetCycleCount() - pStats->EntryStamp;
+  uint16_t *pBin = &pStats->DurationHist[ES_IsrStats_Bucket(Duration)];
+
+  if ((pStats->Count == 1) || (Duration < pStats->MinDuration))
+  {
+    pStats->MinDuration = Duration;
+  }
+  if (Duration > pStats->MaxDuration)
+  {
+    pStats->MaxDuration = Duration;
+  }
+  pStats->SumDuration += Duration;
+  if (*pBin != 0xFFFF)
+  {
+    (*pBin)++;
+  }
+}
+
+#else
+
+#define ES_IsrStats_Enter(Which, LatencyCycles) ((void)0)
+#define ES_IsrStats_NoteLatency(Which, CyclesSinceTrigger) ((void)0)
+#define ES_IsrStats_Exit(Which) ((void)0)
+
+#endif /* ES_ISR_STATS */
+
+#endif /* ES_ISR_STATS_H */
@@ -0,0 +1,78 @@
+/****************************************************************************
+ Module
+     ES_Log.h
+ Description
+     leveled text logging over DB_printf, filtered at compile time
+ Notes
+     A module logs with LOG_ERROR, LOG_WARN, LOG_INFO & LOG_DEBUG, which
+     take the same arguments as DB_printf. Each one above the module's level
+     becomes ((void)0), format string, arguments & all, so a level that is
+     off costs no code, no flash for the string & no time on the UART. An
+     argument with a side effect is dropped along with the call.
+
+     The module's level is ES_LOG_LEVEL from ES_Configure.h, unless it
+     defines LOG_MODULE_LEVEL before it includes this file:
+
+       #define LOG_MODULE_LEVEL LOG_LEVEL_DEBUG
+       #include "ES_Log.h"
+
+     Either way it is capped at ES_LOG_MAX_LEVEL, so that one line in
+     ES_Configure.h quiets every module for a competition build.
+
+     LOG_ENABLED(Level) is true when that level is on, for the odd block
+     that only computes something to log it.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 22:20 ty      first pass
+*****************************************************************************/
+#ifndef ES_LOG_H
+#define ES_LOG_H
+
+#include "ES_Configure.h"
+#include "dbprintf.h"
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_MODULE_LEVEL
+#define LOG_MODULE_LEVEL ES_LOG_LEVEL
+#endif
+
+#if LOG_MODULE_LEVEL < ES_LOG_MAX_LEVEL
+#define LOG_THIS_LEVEL LOG_MODULE_LEVEL
+#else
+#define LOG_THIS_LEVEL ES_LOG_MAX_LEVEL
+#endif
+
+#define LOG_ENABLED(Level) (LOG_THIS_LEVEL >= (Level))
+
+#if LOG_THIS_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) DB_printf(__VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#if LOG_THIS_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) DB_printf(__VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_THIS_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) DB_printf(__VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_THIS_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) DB_printf(__VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#endif /* ES_LOG_H */
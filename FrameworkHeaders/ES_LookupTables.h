@@ -17,13 +17,33 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 20:50 ty       masks are ES_ServiceMask_t, 32 bits when
+                         MAX_NUM_SERVICES is over 16
+ 10/14/26 09:10 ty       ES_GetMSBitSet now uses the CLZ instruction when the
+                         port defines _PORT_HAS_CLZ_, table walk kept as
+                         ES_GetMSBitSetByTable. Added include guard
  10/20/13 21:19 jec      got rid of BitNum2ClrMask and replaced with #define
                          replaced Byte2MSBNum with function ES_GetMSBSet
                          replaced Byte2MSBNum array with Nybble2MSBNum
  08/05/13 15:45 jec      added #include for ES_Types.h since we depend on it
  01/15/12 13:03 jec      started coding
 *****************************************************************************/
+#ifndef ES_LOOKUPTABLES_H
+#define ES_LOOKUPTABLES_H
+
 #include "ES_Types.h"
+#include "ES_Port.h"
+#include "ES_Configure.h"
+
+/*
+  one bit per service, as in Ready. Only as wide as MAX_NUM_SERVICES needs so
+  that a 16 service build doesn't pay for the wider masks
+*/
+#if MAX_NUM_SERVICES > 16
+typedef uint32_t ES_ServiceMask_t;
+#else
+typedef uint16_t ES_ServiceMask_t;
+#endif
 /*
   Since we moved up to 16 timers & services, this table got too big to justify
   having a separate table for the clear and set masks, so just #define the
@@ -32,10 +52,10 @@
 #define BitNum2ClrMask ~BitNum2SetMask
 
 /*
-  this table is used to go from a bit number (0-7) to the mask used to set
-  that bit in a byte.
+  this table is used to go from a bit number (0 to MAX_NUM_SERVICES - 1) to the
+  mask used to set that bit in a service mask.
 */
-extern uint16_t const BitNum2SetMask[];
+extern ES_ServiceMask_t const BitNum2SetMask[MAX_NUM_SERVICES];
 
 /*
   this table is used to go from an unsigned 4bit value to the most significant
@@ -48,16 +68,49 @@ extern uint8_t const Nybble2MSBitNum[15];
 
 /****************************************************************************
  Function
-   ES_GetMSBSet
+   ES_GetMSBitSetByTable
  Parameters
-   uint16_t  Val2Check The number to find the MSB in
+   ES_ServiceMask_t  Val2Check The number to find the MSB in
  Returns
    bit number of the MSB that is set in Val2Check, 128 if Val2Check = 0
  Description
-   find the MSB that is set in Val2Check and returns that bit number
+   portable version that finds the MSB set by walking Val2Check a nybble at
+   a time through the Nybble2MSBitNum table
  Notes
+   always compiled so that the two versions can be compared on the target
+ Author
+   J. Edward Carryer, 10/20/13, 17:03
+****************************************************************************/
+uint8_t ES_GetMSBitSetByTable(ES_ServiceMask_t Val2Check);
 
+/****************************************************************************
+ Function
+   ES_GetMSBitSet
+ Parameters
+   ES_ServiceMask_t  Val2Check The number to find the MSB in
+ Returns
+   bit number of the MSB that is set in Val2Check, 128 if Val2Check = 0
+ Description
+   find the MSB that is set in Val2Check and returns that bit number
+ Notes
+   This sits in the path of every dispatch in ES_Run and every tick in
+   ES_Timer_Tick_Resp. If the port has a count leading zeros instruction
+   (_PORT_HAS_CLZ_ in ES_Port.h) it is done inline with that, otherwise
+   we fall back to the table walk.
+   __builtin_clz(0) is undefined, so the zero case is tested explicitly.
+   CLZ works on the whole 32 bit register, so the 32 service build costs
+   the same single instruction as the 16 service one.
  Author
    J. Edward Carryer, 10/20/13, 17:03
 ****************************************************************************/
-uint8_t ES_GetMSBitSet(uint16_t Val2Check);
+#ifdef _PORT_HAS_CLZ_
+static inline uint8_t ES_GetMSBitSet(ES_ServiceMask_t Val2Check)
+{
+  return (0 == Val2Check) ? 128U :
+         (uint8_t)(31 - __builtin_clz((unsigned int)Val2Check));
+}
+#else
+#define ES_GetMSBitSet(Val2Check) ES_GetMSBitSetByTable(Val2Check)
+#endif
+
+#endif /* ES_LOOKUPTABLES_H */
@@ -9,6 +9,12 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 23:55 ty      the ES_TICK_HOOK prototype
+ 10/14/26 21:00 ty      added the ES_HOST_SIM build, see ES_Port_Host.c
+ 10/14/26 19:50 ty      added _HW_CYCLES_PER_US
+ 10/14/26 12:30 ty      added the ES_TICKLESS_IDLE build option
+ 10/14/26 09:10 ty      added _PORT_HAS_CLZ_ to select the CLZ based priority
+                        resolution & _HW_GetCycleCount for timing measurements
  10/26/17 18:39 jec     moves definition of ALL_BITS to here
  10/14/15 21:50 jec     added prototype for ES_Timer_GetTime
  01/18/15 13:24 jec     clean up and adapt to use TI driver lib functions
@@ -83,6 +89,42 @@ extern  uint8_t _INTCON_temp;
 #define ExitCritical()
 #endif
 
+// The M4K core implements the MIPS32 CLZ (count leading zeros) instruction.
+// Defining this lets ES_GetMSBitSet() resolve the highest priority ready
+// service/active timer with a single instruction rather than walking the
+// Nybble2MSBitNum table. Comment it out to fall back to the portable
+// table-driven version in ES_LookupTables.c
+#define _PORT_HAS_CLZ_
+
+// free running counter for timing measurements. On the PIC32 this is the
+// core timer, which increments at 1/2 of the instruction clock (20MHz)
+#ifndef ES_HOST_SIM
+#define _HW_GetCycleCount() _CP0_GET_COUNT()
+#else
+// on the host the core timer is simulated time, which stands still while
+// the services run, so measure them with the host's clock, in the same units
+uint32_t _HW_GetHostCycleCount(void);
+#define _HW_GetCycleCount() _HW_GetHostCycleCount()
+#endif
+#define _HW_CYCLES_PER_US 20
+
+// the application's tick function, when ES_Configure.h names one
+#ifdef ES_TICK_HOOK
+void ES_TICK_HOOK(void);
+#endif
+
+// Uncomment to build the tickless idle mode. When there is nothing to do,
+// ES_Run calls _HW_IdleUntilNextEvent which moves the core timer compare out
+// to the next timer expiration and idles the CPU (wait) until an interrupt.
+// Event checkers only run when something wakes the CPU, so this only makes
+// sense when the inputs that matter are interrupt driven. The sleep is capped
+// at ES_TICKLESS_MAX_IDLE_TICKS so that polled checkers still get run
+//#define ES_TICKLESS_IDLE
+#ifdef ES_HOST_SIM
+#define ES_TICKLESS_IDLE  // the host port moves simulated time on from here
+#endif
+#define ES_TICKLESS_MAX_IDLE_TICKS 20
+
 /* Rate constants for programming the SysTick Period to generate tick interrupts.
    These assume that we are using the M4K core timer running at 20MHz. Even
    thought the processor clock is 40MHz the core timer increments every other 
@@ -119,6 +161,11 @@ bool _HW_Process_Pending_Ints(void);
 uint16_t _HW_GetTickCount(void);
 void _HW_ConsoleInit(void);
 void _HW_SysTickIntHandler(void);
+#ifdef ES_TICKLESS_IDLE
+void _HW_IdleUntilNextEvent(void);
+void _HW_GetIdleStats(uint32_t *pIdleCounts, uint32_t *pNumIdles,
+    uint32_t *pMaxWakeLatency);
+#endif
 
 // and the one Framework function that we define here
 uint16_t ES_Timer_GetTime(void);
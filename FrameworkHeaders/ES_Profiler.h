@@ -0,0 +1,41 @@
+/****************************************************************************
+ Module
+     ES_Profiler.h
+ Description
+     header file for the dispatch profiler used by ES_Run when
+     ES_PROFILE_DISPATCH is defined in ES_Configure.h
+ Notes
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 21:10 ty      added ES_Profile_NoteFlush
+ 10/14/26 21:00 ty      added ES_Profile_GetDispatchCount
+ 10/14/26 16:10 ty      first pass
+*****************************************************************************/
+#ifndef ES_PROFILER_H
+#define ES_PROFILER_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+
+#ifdef ES_PROFILE_DISPATCH
+
+// how many post time stamps are kept per service. Only needs to cover the
+// deepest queue, events posted past this are dispatched without a wait time
+#define ES_PROFILE_STAMP_DEPTH 8
+
+// called by the framework
+void ES_Profile_NotePost(uint8_t WhichService, bool AtFront);
+void ES_Profile_NoteFlush(uint8_t WhichService);
+void ES_Profile_Record(uint8_t WhichService, ES_EventType_t WhichEvent,
+    uint32_t DispatchStart, uint32_t RunCycles);
+
+// called by the application, normally from a keystroke
+void ES_Profile_Report(void);
+void ES_Profile_Reset(void);
+uint32_t ES_Profile_GetDispatchCount(void);
+
+#endif /* ES_PROFILE_DISPATCH */
+
+#endif /* ES_PROFILER_H */
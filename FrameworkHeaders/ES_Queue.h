@@ -5,10 +5,27 @@
      header file for use with the Queue functions of the Events  & Services
      Framework
  Notes
+     A queue is an ES_Queue_t descriptor, which stays put (it can be const),
+     pointing at an array of packed entries & at the ES_QueueState_t that
+     holds its indices & statistics. The header used to take the first
+     element of the block, an event's worth of RAM, and each entry a whole
+     ES_Event_t. Now an entry is an ES_PackedEvent_t, half the size, so the
+     same RAM holds a queue twice as deep. ES_DEFINE_QUEUE declares the
+     three of them for a queue of its own.
 
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 23:59 ty       the queue functions take an ES_Queue_t descriptor,
+                         the entries are ES_PackedEvent_t & the header is
+                         no longer in the block. ES_InitQueue takes the
+                         kind from the descriptor, ES_InitQueueKind is gone
+ 10/14/26 22:50 ty       added ES_EnQueueFrontBlock
+ 10/14/26 19:30 ty       added ES_EnQueueFIFOInCritical
+ 10/14/26 19:10 ty       added ES_EnQueueCoalesce
+ 10/14/26 16:50 ty       added ES_QueueStats_t, ES_GetQueueStats &
+                         ES_ClearQueueStats
+ 10/14/26 10:05 ty       added queue kinds & ES_InitQueueKind
  08/05/13 15:19 jec      modifications to suit new portable type definitions
  01/15/12 09:36 jec      converted to use new types from ES_Types.h
  10/17/11 07:49 jec      new header to match the rest of the framework
@@ -20,14 +37,86 @@
 #include "ES_Types.h"
 #include "ES_Events.h"
 
+/* kinds of queue, the QueueKind column of ES_SERVICE_TABLE in ES_Configure.h */
+// every insertion & removal is done inside a critical region
+#define ES_QUEUE_KIND_CRITICAL 0
+// lock-free single producer/single consumer, for a queue that is posted to
+// by only one ISR (or only from the main loop). Size must be a power of 2.
+#define ES_QUEUE_KIND_SPSC 1
+
+// the indices & statistics of a queue, only for ES_Queue.c to touch.
+// CurrentIndex is the 'read-from' index & NumEntries the number waiting.
+// The lock-free kind's Head is only written by the producer, Tail only by
+// the consumer. Both are free running, the entry index comes from masking
+// with (QueueSize - 1) & the number of entries is (Head - Tail) in 8 bit
+// math, which is why its QueueSize must be a power of 2 no bigger than 128
+typedef struct
+{
+  union
+  {
+    struct
+    {
+      uint8_t CurrentIndex;
+      uint8_t NumEntries;
+    } Critical;
+    struct
+    {
+      volatile uint8_t Tail;
+      volatile uint8_t Head;
+    } SPSC;
+  } Ends;
+  uint8_t HighWater;            // most entries ever in the queue at once
+  uint8_t LastDropType;
+  uint16_t DropCount;           // failed posts, sticks at 0xFFFF
+}ES_QueueState_t;
+
+// what a queue is, the entries & the state it works in
+typedef struct
+{
+  ES_PackedEvent_t *pEntries;
+  ES_QueueState_t  *pState;
+  uint8_t QueueSize;            // entries in pEntries
+  uint8_t QueueKind;            // ES_QUEUE_KIND_xxx
+}ES_Queue_t;
+
+// declares a queue Name of Size entries, with its entries & state
+#define ES_DEFINE_QUEUE(Name, Size, Kind)                                   \
+  static ES_PackedEvent_t Name##Entries[Size];                              \
+  static ES_QueueState_t Name##State;                                       \
+  static const ES_Queue_t Name = { Name##Entries, &Name##State, (Size),     \
+      (Kind) }
+
+/* statistics kept in the state of every queue */
+typedef struct
+{
+  uint8_t QueueSize;            // max number of entries
+  uint8_t QueueKind;            // ES_QUEUE_KIND_xxx
+  uint8_t NumEntries;           // entries in the queue right now
+  uint8_t HighWater;            // most entries ever in the queue at once
+  uint16_t DropCount;           // posts that found the queue full (sticks
+                                // at 0xFFFF)
+  ES_EventType_t LastDropType;  // type of the last event that was dropped
+}ES_QueueStats_t;
+
 /* prototypes for public functions */
 
-uint8_t ES_InitQueue(ES_Event_t *pBlock, uint8_t BlockSize);
-bool ES_EnQueueFIFO(ES_Event_t *pBlock, ES_Event_t Event2Add);
-bool ES_EnQueueLIFO(ES_Event_t *pBlock, ES_Event_t Event2Add);
-uint8_t ES_DeQueue(ES_Event_t *pBlock, ES_Event_t *pReturnEvent);
+uint8_t ES_InitQueue(const ES_Queue_t *pQueue);
+bool ES_EnQueueFIFO(const ES_Queue_t *pQueue, ES_Event_t Event2Add);
+bool ES_EnQueueFIFOInCritical(const ES_Queue_t *pQueue, ES_Event_t Event2Add);
+bool ES_EnQueueLIFO(const ES_Queue_t *pQueue, ES_Event_t Event2Add);
+bool ES_EnQueueLIFOInCritical(const ES_Queue_t *pQueue, ES_Event_t Event2Add);
+bool ES_EnQueueFrontBlock(const ES_Queue_t *pQueue, const ES_Event_t *pEvents,
+    uint8_t Count);
+bool ES_EnQueueFrontBlockInCritical(const ES_Queue_t *pQueue,
+    const ES_Event_t *pEvents, uint8_t Count);
+bool ES_EnQueueCoalesce(const ES_Queue_t *pQueue, ES_Event_t Event2Add);
+bool ES_EnQueueCoalesceInCritical(const ES_Queue_t *pQueue,
+    ES_Event_t Event2Add);
+uint8_t ES_DeQueue(const ES_Queue_t *pQueue, ES_Event_t *pReturnEvent);
 //void EF_FlushQueue( unsigned char * pBlock );
-bool ES_IsQueueEmpty(ES_Event_t *pBlock);
+bool ES_IsQueueEmpty(const ES_Queue_t *pQueue);
+void ES_GetQueueStats(const ES_Queue_t *pQueue, ES_QueueStats_t *pStats);
+void ES_ClearQueueStats(const ES_Queue_t *pQueue);
 
 #endif /*ES_Queue_H */
 
@@ -4,72 +4,30 @@
  Description
      This file serves to keep the clutter down in ES_Framework.h
  Notes
+     one #include for each service in ES_SERVICE_TABLE. A service missing
+     from here shows up as an undeclared Init/Run/Post function
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 23:59 ty       added BeaconDetectService
+ 10/14/26 23:59 ty       added PulseCaptureService
+ 10/14/26 22:50 ty       added SPIBusService
+ 10/14/26 22:30 ty       added TelemetryService
+ 10/14/26 21:40 ty       added SerialCommandService
+ 10/14/26 20:30 ty       lists the service headers directly, the services
+                         come from ES_SERVICE_TABLE in ES_Configure.h
  01/15/12 10:35 jec      started coding
 *****************************************************************************/
 
 #include "ES_Configure.h"
 
-#include SERV_0_HEADER
-
-#if NUM_SERVICES > 1
-#include SERV_1_HEADER
-#endif
-
-#if NUM_SERVICES > 2
-#include SERV_2_HEADER
-#endif
-
-#if NUM_SERVICES > 3
-#include SERV_3_HEADER
-#endif
-
-#if NUM_SERVICES > 4
-#include SERV_4_HEADER
-#endif
-
-#if NUM_SERVICES > 5
-#include SERV_5_HEADER
-#endif
-
-#if NUM_SERVICES > 6
-#include SERV_6_HEADER
-#endif
-
-#if NUM_SERVICES > 7
-#include SERV_7_HEADER
-#endif
-
-#if NUM_SERVICES > 8
-#include SERV_8_HEADER
-#endif
-
-#if NUM_SERVICES > 9
-#include SERV_9_HEADER
-#endif
-
-#if NUM_SERVICES > 10
-#include SERV_10_HEADER
-#endif
-
-#if NUM_SERVICES > 11
-#include SERV_11_HEADER
-#endif
-
-#if NUM_SERVICES > 12
-#include SERV_12_HEADER
-#endif
-
-#if NUM_SERVICES > 13
-#include SERV_13_HEADER
-#endif
-
-#if NUM_SERVICES > 14
-#include SERV_14_HEADER
-#endif
-
-#if NUM_SERVICES > 15
-#include SERV_15_HEADER
-#endif
+#include "TestHarnessService0.h"
+#include "TelemetryService.h"
+#include "SerialCommandService.h"
+#include "SPIBusService.h"
+#include "CommandRetrieveService.h"
+#include "PulseCaptureService.h"
+#include "BeaconDetectService.h"
+#include "MainLogicFSM.h"
+#include "DCMotorService.h"
+#include "SpeedControlService.h"
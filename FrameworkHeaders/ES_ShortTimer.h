@@ -0,0 +1,47 @@
+/****************************************************************************
+ Module
+     ES_ShortTimer.h
+ Description
+     one-shot timeouts with 1uS resolution, for sub-mS timing that the
+     ES_Timers tick can't give
+ Notes
+     Two timers, TIMER_A on Timer5 & TIMER_B on Timer1, the only ones the
+     PWM, the capture time base & the control loop leave free. Each one
+     posts ES_SHORT_TIMEOUT, with TIMER_A or TIMER_B as the EventParam, to
+     the service given to ES_ShortTimerInit. Both count PBCLK/8, so a tick
+     is 0.4uS, & a timeout longer than the 16 bit period (26mS) runs as a
+     few equal periods. A timeout under SHORT_TIMER_MIN_US is posted at
+     once, the interrupt would take longer than that.
+
+     ES_ShortTimerStop cancels a timeout that hasn't run out. One that
+     already has may be in the queue, as with ES_Timer_StopTimer.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 23:10 ty      first pass, for the PIC32 port of ES_ShortTimer.c
+*****************************************************************************/
+#ifndef ES_SHORT_TIMER_H
+#define ES_SHORT_TIMER_H
+
+#include "ES_Types.h"
+
+// the EventParam of ES_SHORT_TIMEOUT
+#define TIMER_A 0
+#define TIMER_B 1
+
+// pass for a timer that no service uses
+#define SHORT_TIMER_UNUSED 0xFF
+
+// must match the peripheral bus clock that the configuration bits give
+#define SHORT_TIMER_PBCLK_HZ 20000000u
+// shorter than this in uS & the timeout is posted from ES_ShortTimerStart
+#define SHORT_TIMER_MIN_US 11
+// both timers' interrupts, the IPL of the ISRs must match
+#define SHORT_TIMER_PRIORITY 5
+
+void ES_ShortTimerInit(uint8_t TimeAPrio, uint8_t TimeBPrio);
+void ES_ShortTimerStart(uint32_t Which, uint16_t TimeoutValue);
+void ES_ShortTimerStop(uint32_t Which);
+
+#endif /* ES_SHORT_TIMER_H */
@@ -0,0 +1,31 @@
+/****************************************************************************
+ Module
+     ES_Time.h
+ Description
+     64 bit monotonic time, in core timer counts & uS, for timestamps &
+     intervals longer or finer than the 16 bit mS of ES_Timer_GetTime
+ Notes
+     The 32 bit core timer count wraps every 214S at 20MHz. ES_Time
+     extends it with one 32 bit word, the number of half wraps, which
+     ES_Time_Update brings up to date. The tick ISR calls that every tick,
+     & a reader copes with the count being up to half a wrap (107S) ahead
+     of the word, so neither side needs a critical region & both
+     ES_Time_NowCycles & ES_Time_NowUs can be called from any ISR.
+
+     In the ES_HOST_SIM build the count is the simulated time.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 23:20 ty      first pass
+*****************************************************************************/
+#ifndef ES_TIME_H
+#define ES_TIME_H
+
+#include "ES_Types.h"
+
+uint64_t ES_Time_NowCycles(void);
+uint64_t ES_Time_NowUs(void);
+void ES_Time_Update(void);
+
+#endif /* ES_TIME_H */
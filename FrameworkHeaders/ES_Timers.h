@@ -14,6 +14,8 @@
  History
  When           Who	What/Why
  -------------- ---	--------
+ 10/14/26 12:30 ty   added ES_Timer_GetTicksToNextExpiry
+ 10/14/26 11:20 ty   times are now ES_TimerTime_t, 16 or 32 bits
  10/13/15 20:48 jec  removed prototype for IsTimerActive, I had removed the code
                      a couple of years ago
  08/13/13 12:03 jec  added prototype for ES_Timer_Tick_Resp as part of
@@ -31,9 +33,17 @@
 #ifndef ES_Timers_H
 #define ES_Timers_H
 
+#include "ES_Configure.h"
 #include "ES_Port.h"
 #include "ES_Types.h"
 
+// the type used for timer durations, see ES_TIMER_32BIT_DURATIONS
+#ifdef ES_TIMER_32BIT_DURATIONS
+typedef uint32_t ES_TimerTime_t;
+#else
+typedef uint16_t ES_TimerTime_t;
+#endif
+
 typedef enum
 {
   ES_Timer_ERR        = -1,
@@ -44,11 +54,12 @@ typedef enum
 
 void ES_Timer_Init(TimerRate_t Rate);
 void ES_Timer_Tick_Resp(void);
-ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint16_t NewTime);
-ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint16_t NewTime);
+ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, ES_TimerTime_t NewTime);
+ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, ES_TimerTime_t NewTime);
 ES_TimerReturn_t ES_Timer_StartTimer(uint8_t Num);
 ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num);
 uint16_t ES_Timer_GetTime(void);
+ES_TimerTime_t ES_Timer_GetTicksToNextExpiry(void);
 
 #endif   /* ES_Timers_H */
 /*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,56 @@
+/****************************************************************************
+ Module
+     ES_Trace.h
+ Description
+     header file for the dispatch trace kept by ES_Run when ES_TRACE_DISPATCH
+     is defined in ES_Configure.h
+ Notes
+     A dump goes out as one binary frame, mixed in with the printf text the
+     same way the binlog frames are, & tools/binlog_decode.py prints it:
+
+       ES_TRACE_FRAME_MARK, then little endian 32 bit words:
+       header = ES_TRACE_FRAME_MARK << 24 | NumEntries << 16 | Reason
+       total  = dispatches recorded since reset, so the decoder can tell
+                how many were lost off the front of the ring
+       now    = core timer count when the dump was made
+       NumEntries x 3 words, oldest first:
+         start  = core timer count when the event was taken from the queue
+         what   = Service << 24 | EventType << 16 | EventParam
+         run    = core timer counts spent in the run function
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 21:20 ty      first pass
+*****************************************************************************/
+#ifndef ES_TRACE_H
+#define ES_TRACE_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+#include "ES_Events.h"
+
+#ifdef ES_TRACE_DISPATCH
+
+// not a 7 bit ASCII character, & not the binlog mark
+#define ES_TRACE_FRAME_MARK 0xB2
+
+// why the dump was made, the low byte of the header word
+#define ES_TRACE_DUMP_KEY 0
+#define ES_TRACE_DUMP_ASSERT 1
+
+// the size of a full dump on the wire
+#define ES_TRACE_FRAME_BYTES (1 + 4 * (3 + 3 * ES_TRACE_DEPTH))
+
+typedef void ES_TracePutByte_t(uint8_t TheByte);
+
+// called by the framework
+void ES_Trace_Record(uint8_t WhichService, ES_Event_t ThisEvent,
+    uint32_t DispatchStart, uint32_t RunCycles);
+
+// called by the application, normally from a keystroke, or an assert
+void ES_Trace_Dump(ES_TracePutByte_t *pPutByte, uint8_t Reason);
+
+#endif /* ES_TRACE_DISPATCH */
+
+#endif /* ES_TRACE_H */
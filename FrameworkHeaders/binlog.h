@@ -0,0 +1,78 @@
+/****************************************************************************
+ Module
+     binlog.h
+ Description
+     header file for the binary, deferred-format trace logger
+ Notes
+     A call to one of the BINLOGn() macros copies the address of its format
+     string, a core timer time stamp and up to 4 raw 32 bit arguments into a
+     RAM ring. No formatting happens on the target. BinLog_Drain(), called
+     from the idle path in ES_Run, moves whole records into the terminal
+     transmit buffer as binary frames mixed in with the normal printf text.
+     tools/binlog_decode.py pulls the format strings out of the .elf and
+     rebuilds the text on the host.
+
+     The format strings are the same ones that DB_printf takes: %d %u %x %c
+     and %s, where a %s argument must point to a string constant in flash.
+     Every argument is passed as a 32 bit value.
+
+     Comment out BINLOG_ENABLED and the macros turn back into DB_printf
+     calls, so the call sites don't need to change to get text back.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 15:05 ty      first pass
+*****************************************************************************/
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include "ES_Port.h"
+#include "dbprintf.h"
+
+// comment this out to send the BINLOGn() calls through DB_printf instead
+#define BINLOG_ENABLED
+
+// size of the record ring in 32 bit words, must be a power of 2. A record
+// takes 3 words plus one per argument, so 256 words holds at least 36 of
+// the largest records
+#define BINLOG_RING_WORDS 256
+
+// marks the start of a binary frame in the UART stream. It is not a legal
+// 7 bit ASCII character so printf text can never be mistaken for a frame.
+// It is also the top byte of every record header word
+#define BINLOG_FRAME_MARK 0xB1
+
+// the most arguments a single record can carry
+#define BINLOG_MAX_ARGS 4
+
+#ifdef BINLOG_ENABLED
+
+#define BINLOG0(fmt) \
+  BinLog_Write((fmt), 0, 0, 0, 0, 0)
+#define BINLOG1(fmt, a) \
+  BinLog_Write((fmt), 1, (uint32_t)(a), 0, 0, 0)
+#define BINLOG2(fmt, a, b) \
+  BinLog_Write((fmt), 2, (uint32_t)(a), (uint32_t)(b), 0, 0)
+#define BINLOG3(fmt, a, b, c) \
+  BinLog_Write((fmt), 3, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), 0)
+#define BINLOG4(fmt, a, b, c, d) \
+  BinLog_Write((fmt), 4, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), \
+      (uint32_t)(d))
+
+void BinLog_Write(const char *pFormat, uint8_t NumArgs, uint32_t Arg0,
+    uint32_t Arg1, uint32_t Arg2, uint32_t Arg3);
+void BinLog_Drain(void);
+bool BinLog_IsEmpty(void);
+uint32_t BinLog_GetDropCount(void);
+
+#else
+
+#define BINLOG0(fmt)              DB_printf(fmt)
+#define BINLOG1(fmt, a)           DB_printf((fmt), (a))
+#define BINLOG2(fmt, a, b)        DB_printf((fmt), (a), (b))
+#define BINLOG3(fmt, a, b, c)     DB_printf((fmt), (a), (b), (c))
+#define BINLOG4(fmt, a, b, c, d)  DB_printf((fmt), (a), (b), (c), (d))
+
+#endif /* BINLOG_ENABLED */
+
+#endif /* BINLOG_H */
@@ -6,8 +6,12 @@
 #define CIRCULAR_BUFFER_H_
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
-// sets the upper limit on the number of circular buffers that we can init
+// the number of handles in the pool, one for each call to circular_buf_init.
+// Now that is the terminal transmit & receive buffers, add one here for each
+// new buffer. circular_buf_init returns NULL once the pool is used up
 #define MAX_CIRC_BUFFERS 2
 
 /// Opaque circular buffer structure
@@ -19,7 +23,8 @@ typedef circular_buf_t* cbuf_handle_t;
 /// Pass in a storage buffer and size, returns a circular buffer handle
 /// Requires: buffer is not NULL, size > 0 (size > 1 for the threadsafe
 //  version, because it holds size - 1 elements)
-/// Ensures: cbuf has been created and is returned in an empty state
+/// Ensures: cbuf has been created and is returned in an empty state, or
+/// NULL if all MAX_CIRC_BUFFERS handles are already in use
 cbuf_handle_t circular_buf_init(uint8_t* buffer, size_t size);
 
 /// Free a circular buffer structure
@@ -67,7 +72,49 @@ size_t circular_buf_capacity(cbuf_handle_t cbuf);
 /// Returns the current number of elements in the buffer
 size_t circular_buf_size(cbuf_handle_t cbuf);
 
-//TODO: int circular_buf_get_range(circular_buf_t cbuf, uint8_t *data, size_t len);
-//TODO: int circular_buf_put_range(circular_buf_t cbuf, uint8_t * data, size_t len);
+/// Look at the oldest data in place, without removing it
+/// Requires: cbuf is valid and created by circular_buf_init
+/// Sets *pData to point at the oldest byte and returns the number of bytes
+/// that can be read from there without wrapping (0 if the buffer is empty)
+size_t circular_buf_peek_linear(cbuf_handle_t cbuf, uint8_t ** pData);
+
+/// Look at the data in place, starting offset bytes past the oldest
+/// Requires: cbuf is valid and created by circular_buf_init
+/// Sets *pData to point at that byte and returns the number of bytes that
+/// can be read from there without wrapping (0 if offset >= the size). The
+/// bytes after a wrap are the span at offset + the returned length
+size_t circular_buf_peek(cbuf_handle_t cbuf, size_t offset, uint8_t ** pData);
+
+/// Remove len bytes that were consumed in place (see circular_buf_peek_linear)
+/// Requires: cbuf is valid and created by circular_buf_init,
+/// len <= circular_buf_size(cbuf)
+void circular_buf_advance_tail(cbuf_handle_t cbuf, size_t len);
+
+/// Find the free space in place, to write into with memcpy or DMA
+/// Requires: cbuf is valid and created by circular_buf_init
+/// Sets *pSpace to point at the next free byte and returns the number of
+/// bytes that can be written from there without wrapping (0 if full)
+size_t circular_buf_space_linear(cbuf_handle_t cbuf, uint8_t ** pSpace);
+
+/// Add len bytes that were written in place (see circular_buf_space_linear)
+/// Requires: cbuf is valid and created by circular_buf_init,
+/// len <= the length returned by circular_buf_space_linear
+void circular_buf_advance_head(cbuf_handle_t cbuf, size_t len);
+
+/// Add up to len bytes, never overwriting
+/// Requires: cbuf is valid and created by circular_buf_init
+/// Returns the number of bytes added, less than len if the buffer filled
+size_t circular_buf_put_n(cbuf_handle_t cbuf, const uint8_t * data, size_t len);
+
+/// Retrieve up to len bytes
+/// Requires: cbuf is valid and created by circular_buf_init
+/// Returns the number of bytes retrieved, less than len if it ran out
+size_t circular_buf_get_n(cbuf_handle_t cbuf, uint8_t * data, size_t len);
+
+/// The _n, _linear & advance functions are safe with one producer & one
+/// consumer in different contexts (an ISR & the foreground): the producer
+/// only moves head, the consumer only moves tail, and each does so after
+/// the data has been copied. circular_buf_put, which moves tail when the
+/// buffer is full, and circular_buf_reset are not.
 
 #endif //CIRCULAR_BUFFER_H_
\ No newline at end of file
@@ -13,6 +13,7 @@ extern "C" {
 #endif
     
 #include "ES_Port.h"
+#include "ES_Configure.h"   // for USE_UART_RX_ISR
 
 // a few handy shortcuts for terminal control    
 #define clrScrn() printf("\x1b[2J")
@@ -20,19 +21,69 @@ extern "C" {
 #define clrLine() printf("\x1b[K")
     
 #define XMIT_BUFFER_SIZE 1024
+
+// uncomment to have DMA channel 0 move the transmit buffer to UART1 in the
+// background, rather than moving it a byte at a time from the idle loop
+//#define TERMINAL_DMA_TX
+
+// with this defined, printf waits for room when the transmit buffer is full
+// rather than overwriting the oldest output
+#define TERMINAL_TX_BACKPRESSURE
+
+// UART1 runs at TERMINAL_DEFAULT_BAUD from Terminal_HWInit until
+// Terminal_SetBaud or the auto-baud changes it. U1BRG is worked out from
+// TERMINAL_PBCLK_HZ, which must match the peripheral bus clock that the
+// configuration bits give. A rate that can't be made to within
+// TERMINAL_BAUD_TOLERANCE (in tenths of a percent) is refused. With a
+// 20MHz PBCLK that is up to 460800, 921600 needs a 40MHz PBCLK
+#define TERMINAL_PBCLK_HZ 20000000u
+#define TERMINAL_DEFAULT_BAUD 115200u
+#define TERMINAL_BAUD_TOLERANCE 25
+
+// uncomment to have Terminal_HWInit start the auto-baud, the UART then
+// takes its rate from the first byte that comes in, which must be 'U'
+//#define TERMINAL_AUTOBAUD
+
+// With USE_UART_RX_ISR (ES_Configure.h) the UART1 receive interrupt moves
+// each byte into a buffer this big, & calls the function given to
+// Terminal_SetRxNotify. At 115200 a byte comes every 87uS, the 4 deep
+// hardware FIFO overruns if the ISR is held off for more than about 350uS
+#define RECV_BUFFER_SIZE 256
+#define TERMINAL_RX_PRIORITY 2
     
 // map the generic functions for testing the serial port to actual functions
 // for this platform.
+#ifdef USE_UART_RX_ISR
+#define IsNewKeyReady() Terminal_IsRxData()
+#define kbhit() Terminal_IsRxData()
+#else
 #define IsNewKeyReady() (U1STAbits.URXDA)
+#define kbhit() (U1STAbits.URXDA)
+#endif
 #define GetNewKey Terminal_ReadByte
 //#define putch Terminal_WriteByte
-#define kbhit() (U1STAbits.URXDA)
+
+// called from the receive ISR after it has put new bytes in the buffer
+typedef void (*Terminal_RxNotify_t)(void);
     
 void Terminal_HWInit(void);
 uint8_t Terminal_ReadByte(void);
 void Terminal_WriteByte(uint8_t txByte);
 bool Terminal_IsRxData(void);
 void Terminal_MoveBuffer2UART( void );
+bool Terminal_IsXmitBufferEmpty( void );
+uint32_t Terminal_GetXmitOverflowCount( void );
+size_t Terminal_GetXmitSpace( void );
+size_t Terminal_ReadBytes(uint8_t *pDest, size_t maxBytes);
+uint32_t Terminal_GetRecvOverrunCount( void );
+bool Terminal_IsBaudSupported(uint32_t baud);
+bool Terminal_SetBaud(uint32_t baud);
+uint32_t Terminal_GetBaud(void);
+void Terminal_StartAutoBaud(void);
+bool Terminal_IsAutoBaudDone(void);
+#ifdef USE_UART_RX_ISR
+void Terminal_SetRxNotify(Terminal_RxNotify_t pNotify);
+#endif
 
 #ifdef __XC16__  // DEPRICATED, USE FOR xc16 of xc32 v1.34 or lower
 int write(int handle, void *buffer, unsigned int len);
@@ -8,6 +8,8 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 20:10 ty      checkers come from EVENT_CHECK_TABLE, each with a
+                        poll period, & are taken round robin
                 jec     out all user modifications into ES_Configure
  10/16/11 12:32 jec      started coding
 *****************************************************************************/
@@ -16,18 +18,28 @@
 #include "ES_Events.h"
 #include "ES_General.h"
 #include "ES_CheckEvents.h"
+#include "ES_Port.h"
 
 // Include the header files for the module(s) with your event checkers.
 // This gets you the prototypes for the event checking functions.
 
 #include "EventCheckWrapper.h"
 
-// Fill in this array with the names of your event checking functions
+// The checkers, with their poll periods, come from EVENT_CHECK_TABLE in
+// ES_Configure.h
 
-static CheckFunc *const ES_EventList[] = {
-  EVENT_CHECK_LIST
+static const ES_CheckDesc_t ES_EventList[] = {
+  EVENT_CHECK_TABLE(ES_CHECK_ROW)
 };
 
+#define NUM_CHECKERS ARRAY_SIZE(ES_EventList)
+
+// when each checker was last called, in timer ticks
+static uint16_t LastCalled[NUM_CHECKERS];
+
+// where the next pass starts, just after the last checker that found an event
+static uint8_t NextChecker;
+
 // Implementation for public functions
 
 /****************************************************************************
@@ -39,30 +51,39 @@ static CheckFunc *const ES_EventList[] = {
    bool: true if any of the user event checkers returned true, false otherwise
  Description
    loop through the EF_EventList array executing the event checking functions
+   that are due, starting after the last one that found an event
  Notes
-
+   stops at the first checker that finds an event, so that it gets processed
+   first. The next pass picks up with the checker after it, rather than going
+   back to the top of the list.
+   A checker with a Period is called again once at least Period ticks have
+   gone by, it may be more when the loop is busy.
  Author
    J. Edward Carryer, 10/25/11, 08:55
 ****************************************************************************/
 bool ES_CheckUserEvents(void)
 {
-  uint8_t i;
+  uint8_t  i;
+  uint8_t  Which = NextChecker;
+  uint16_t Now = ES_Timer_GetTime();
+
   // loop through the array executing the event checking functions
-  for (i = 0; i < ARRAY_SIZE(ES_EventList); i++)
+  for (i = 0; i < NUM_CHECKERS; i++)
   {
-    if (ES_EventList[i]() == true)
+    if ((ES_EventList[Which].Period == 0) ||
+        ((uint16_t)(Now - LastCalled[Which]) >= ES_EventList[Which].Period))
     {
-      break; // found a new event, so process it first
+      LastCalled[Which] = Now;
+      if (ES_EventList[Which].Checker() == true)
+      {
+        // found a new event, so process it first
+        NextChecker = (Which + 1 < NUM_CHECKERS) ? (Which + 1) : 0;
+        return true;
+      }
     }
+    Which = (Which + 1 < NUM_CHECKERS) ? (Which + 1) : 0;
   }
-  if (i == ARRAY_SIZE(ES_EventList))   // if no new events
-  {
-    return false;
-  }
-  else
-  {
-    return true;
-  }
+  return false; // no new events
 }
 
 /*------------------------------- Footnotes -------------------------------*/
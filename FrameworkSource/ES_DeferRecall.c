@@ -6,12 +6,22 @@
      This is a module implementing  the management of event deferal and recall
       queues
  Notes
-
+     Besides the queues a service declares for itself, there is one pool of
+     ES_DEFER_POOL_SIZE events that any service can defer to. The entries
+     are kept in the order they arrived, each tagged with its service, &
+     ES_DEFER_POOL_QUOTA caps how many one service can hold. The pool is only
+     touched from the main loop, so it needs no critical region of its own;
+     the recall splices into the service's queue in one. The pool keeps
+     its events packed, as the queues do.
 
  History
  When           Who     What/Why
  -------------- ---     --------
 
+ 10/14/26 23:59 ty      RecallEvents takes the queue's descriptor, the pool
+                        entries are ES_PackedEvent_t
+ 10/14/26 23:00 ty      shared deferral pool with per service accounting &
+                        a batched recall
  10/11/14 14:58 jec     converted RecallEvent to RecallEvents to pull all
                         deferred events off the deferral queue
  11/02/13 16:38 jec      Began Coding
@@ -27,12 +37,23 @@
 /*--------------------------- External Variables --------------------------*/
 
 /*----------------------------- Module Defines ----------------------------*/
+#if ES_DEFER_POOL_QUOTA > ES_DEFER_POOL_SIZE
+#error "ES_DEFER_POOL_QUOTA can't be more than ES_DEFER_POOL_SIZE"
+#endif
 
 /*------------------------------ Module Types -----------------------------*/
+typedef struct
+{
+  ES_PackedEvent_t Event;
+  uint8_t          Service;
+} PoolEntry_t;
 
 /*---------------------------- Module Functions ---------------------------*/
 
 /*---------------------------- Module Variables ---------------------------*/
+static PoolEntry_t     Pool[ES_DEFER_POOL_SIZE];
+static uint8_t         PoolCount;
+static ES_DeferStats_t DeferStats[NUM_SERVICES];
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -40,8 +61,7 @@
      ES_RecallEvents
  Parameters
       uint8_t WhichService, number of the service to post Recalled event to
-      ES_Event * pBlock, pointer to the block of memory that implements the
-        Defer/Recall queue
+      const ES_Queue_t * pQueue, the Defer/Recall queue
  Returns
      bool true if an event was recalled, false if no event was left in queue
  Description
@@ -53,14 +73,14 @@
  Author
      J. Edward Carryer, 11/20/13 16:49
 ****************************************************************************/
-bool ES_RecallEvents(uint8_t WhichService, ES_Event_t *pBlock)
+bool ES_RecallEvents(uint8_t WhichService, const ES_Queue_t *pQueue)
 {
   ES_Event_t  RecalledEvent;
   bool      WereEventsPulled = false;
   // recall any events from the queue
   do
   {
-    ES_DeQueue(pBlock, &RecalledEvent);
+    ES_DeQueue(pQueue, &RecalledEvent);
     if (RecalledEvent.EventType != ES_NO_EVENT)
     {
       ES_PostToServiceLIFO(WhichService, RecalledEvent);
@@ -70,6 +90,161 @@ bool ES_RecallEvents(uint8_t WhichService, ES_Event_t *pBlock)
   return WereEventsPulled;
 }
 
+/****************************************************************************
+ Function
+     ES_DeferToPool
+ Parameters
+     uint8_t WhichService, the service that is setting the event aside
+     ES_Event_t ThisEvent, the event to set aside
+ Returns
+     bool true if it was kept, false if the pool is full or the service
+     already holds ES_DEFER_POOL_QUOTA events
+ Description
+     adds the event at the end of the pool, tagged with its service
+ Notes
+     from the main loop only, not from an ISR
+ Author
+     Tianyu, 10/14/26 23:00
+****************************************************************************/
+bool ES_DeferToPool(uint8_t WhichService, ES_Event_t ThisEvent)
+{
+  ES_DeferStats_t *pStats;
+
+  if (WhichService >= NUM_SERVICES)
+  {
+    return false;
+  }
+  pStats = &DeferStats[WhichService];
+  if ((PoolCount >= ES_DEFER_POOL_SIZE) ||
+      (pStats->Count >= ES_DEFER_POOL_QUOTA))
+  {
+    pStats->Drops++;
+    return false;
+  }
+  Pool[PoolCount].Event = ES_PackEvent(ThisEvent);
+  Pool[PoolCount].Service = WhichService;
+  PoolCount++;
+  pStats->Count++;
+  if (pStats->Count > pStats->HighWater)
+  {
+    pStats->HighWater = pStats->Count;
+  }
+  return true;
+}
+
+/****************************************************************************
+ Function
+     ES_RecallFromPool
+ Parameters
+     uint8_t WhichService, the service to recall the events of
+ Returns
+     bool true if there were events & they went back in its queue
+ Description
+     gathers the service's events, oldest first, & posts them as one block
+     to the front of its queue (ES_PostBlockToServiceLIFO). Only when that
+     works are they taken out of the pool, closing up the gaps so that the
+     rest stay in order
+ Author
+     Tianyu, 10/14/26 23:00
+****************************************************************************/
+bool ES_RecallFromPool(uint8_t WhichService)
+{
+  ES_Event_t Recalled[ES_DEFER_POOL_QUOTA];
+  uint8_t    NumRecalled = 0;
+  uint8_t    From;
+
+  if ((WhichService >= NUM_SERVICES) || (DeferStats[WhichService].Count == 0))
+  {
+    return false;
+  }
+  for (From = 0; From < PoolCount; From++)
+  {
+    if (Pool[From].Service == WhichService)
+    {
+      Recalled[NumRecalled++] = ES_UnpackEvent(Pool[From].Event);
+    }
+  }
+  if (!ES_PostBlockToServiceLIFO(WhichService, Recalled, NumRecalled))
+  {
+    // still in the pool, for the next recall
+    return false;
+  }
+  ES_FlushDeferred(WhichService);
+  return true;
+}
+
+/****************************************************************************
+ Function
+     ES_GetDeferredCount
+ Parameters
+     uint8_t WhichService
+ Returns
+     uint8_t the number of events the service has in the pool
+ Author
+     Tianyu, 10/14/26 23:00
+****************************************************************************/
+uint8_t ES_GetDeferredCount(uint8_t WhichService)
+{
+  if (WhichService >= NUM_SERVICES)
+  {
+    return 0;
+  }
+  return DeferStats[WhichService].Count;
+}
+
+/****************************************************************************
+ Function
+     ES_FlushDeferred
+ Parameters
+     uint8_t WhichService
+ Returns
+     nothing
+ Description
+     drops all of the service's events from the pool without posting them
+ Author
+     Tianyu, 10/14/26 23:00
+****************************************************************************/
+void ES_FlushDeferred(uint8_t WhichService)
+{
+  uint8_t From;
+  uint8_t To = 0;
+
+  if (WhichService >= NUM_SERVICES)
+  {
+    return;
+  }
+  for (From = 0; From < PoolCount; From++)
+  {
+    if (Pool[From].Service != WhichService)
+    {
+      Pool[To++] = Pool[From];
+    }
+  }
+  PoolCount = To;
+  DeferStats[WhichService].Count = 0;
+}
+
+/****************************************************************************
+ Function
+     ES_GetDeferStats
+ Parameters
+     uint8_t WhichService
+     ES_DeferStats_t * pStats, where to put its pool accounting
+ Returns
+     bool false if there is no such service
+ Author
+     Tianyu, 10/14/26 23:00
+****************************************************************************/
+bool ES_GetDeferStats(uint8_t WhichService, ES_DeferStats_t *pStats)
+{
+  if (WhichService >= NUM_SERVICES)
+  {
+    return false;
+  }
+  *pStats = DeferStats[WhichService];
+  return true;
+}
+
 /*------------------------------- Footnotes -------------------------------*/
 
 /*------------------------------ End of file ------------------------------*/
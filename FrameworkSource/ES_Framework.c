@@ -8,6 +8,38 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 23:59 ty      the posts set the Ready bit in the same critical
+                        region as the add
+ 10/14/26 23:59 ty      an express lane per service for the urgent events,
+                        which ES_Run empties before any normal queue
+ 10/14/26 23:59 ty      each queue is an ES_Queue_t over packed entries, with
+                        its state apart, so no entry goes on a header
+ 10/14/26 23:40 ty      ES_Initialize sets up every queue before it runs
+                        any init function, so a post from an init or an ISR
+                        finds its queue ready whatever the order. Startup
+                        timing (ES_STARTUP_STATS)
+ 10/14/26 22:50 ty      added ES_PostBlockToServiceLIFO for the batched
+                        recall of deferred events
+ 10/14/26 21:20 ty      record each dispatch in the trace (ES_TRACE_DISPATCH)
+ 10/14/26 21:10 ty      added ES_FlushServiceQueue
+ 10/14/26 20:50 ty      Ready & the subscriber masks are ES_ServiceMask_t,
+                        up to 32 services
+ 10/14/26 20:30 ty      ServDescList & the queues are generated from
+                        ES_SERVICE_TABLE, the queues share one block
+ 10/14/26 19:50 ty      run budget so a busy dispatch loop still gives the
+                        event checkers & the UART a turn. Run functions
+                        are checked against ES_SERVICE_DEADLINE_US
+ 10/14/26 19:30 ty      event type subscriptions & ES_Publish, ES_PostAll
+                        no longer stops at the first full queue
+ 10/14/26 19:10 ty      added ES_PostToServiceCoalesce
+ 10/14/26 16:50 ty      queue statistics report & ES_QUEUE_SIZING_MODE
+ 10/14/26 16:10 ty      hooks for the dispatch profiler (ES_PROFILE_DISPATCH)
+ 10/14/26 15:05 ty      drain the binary log from the idle path
+ 10/14/26 12:30 ty      idle the CPU when there is nothing to do in the
+                        ES_TICKLESS_IDLE build
+ 10/14/26 10:05 ty      queues are initialized with the kind from
+                        SERV_n_QUEUE_KIND. ES_Run re-checks a queue after
+                        clearing its Ready bit so an ISR post can't get lost
  08/21/17 13:18 jec     added conditional call to initialize the port lines
                         for the hardware debugging of the framework/apps
  12/19/16 20:18 jec      changed includes to accomodate the change to a fixed
@@ -34,6 +66,10 @@
 #include "../FrameworkHeaders/ES_Timers.h"
 #include "../FrameworkHeaders/ES_General.h"
 #include "../FrameworkHeaders/ES_CheckEvents.h"
+#include "../FrameworkHeaders/binlog.h"
+#include "../FrameworkHeaders/ES_Profiler.h"
+#include "../FrameworkHeaders/ES_Trace.h"
+#include "../FrameworkHeaders/dbprintf.h"
 // Include the header files for the Service modules.
 // This gets you the prototypes for the public service functions.
 
@@ -66,176 +102,116 @@ typedef struct
 
 typedef struct
 {
-  ES_Event_t *pMem;       // pointer to the memory
-  uint8_t Size;         // how big is it
+  ES_Queue_t Queue;     // the entries, state, size & kind
+  uint8_t ConfigSize;   // QueueSize from ES_SERVICE_TABLE, for the report
 }ES_QueueDesc_t;
 
+// In the sizing mode every queue gets the same, deep, array of entries so
+// that the high water marks show what each one really needs
+#ifdef ES_QUEUE_SIZING_MODE
+#define QUEUE_ENTRIES(Size) (ES_QUEUE_SIZING_DEPTH)
+#else
+#define QUEUE_ENTRIES(Size) (Size)
+#endif
+
 /*---------------------------- Module Functions ---------------------------*/
 //static bool CheckSystemEvents( void );
+static ES_ServiceMask_t PostToMask(ES_ServiceMask_t WhichServices,
+    ES_Event_t ThisEvent);
+#ifdef ES_RUN_BUDGET
+static void NoteRunTime(uint8_t WhichService, ES_EventType_t WhichEvent,
+    uint32_t RunCycles);
+#endif
 
 /*---------------------------- Module Variables ---------------------------*/
 /****************************************************************************/
-// You fill in this array with the names of the service init & run functions
-// for each service that you use.
-// The order is: InitFunction, RunFunction
-// The first entry, at index 0, is the lowest priority, with increasing
-// priority with higher indices
+// The service init & run functions, in priority order, generated from
+// ES_SERVICE_TABLE in ES_Configure.h. Index 0 is the lowest priority.
+#define SERV_DESC_ROW(Name, QueueSize, QueueKind) { Init##Name, Run##Name },
 
 static ES_ServDesc_t const ServDescList[] =
-{ { SERV_0_INIT, SERV_0_RUN } /* lowest priority  always present */
-#if NUM_SERVICES > 1
-  , { SERV_1_INIT, SERV_1_RUN }
-#endif
-#if NUM_SERVICES > 2
-  , { SERV_2_INIT, SERV_2_RUN }
-#endif
-#if NUM_SERVICES > 3
-  , { SERV_3_INIT, SERV_3_RUN }
-#endif
-#if NUM_SERVICES > 4
-  , { SERV_4_INIT, SERV_4_RUN }
-#endif
-#if NUM_SERVICES > 5
-  , { SERV_5_INIT, SERV_5_RUN }
-#endif
-#if NUM_SERVICES > 6
-  , { SERV_6_INIT, SERV_6_RUN }
-#endif
-#if NUM_SERVICES > 7
-  , { SERV_7_INIT, SERV_7_RUN }
-#endif
-#if NUM_SERVICES > 8
-  , { SERV_8_INIT, SERV_8_RUN }
-#endif
-#if NUM_SERVICES > 9
-  , { SERV_9_INIT, SERV_9_RUN }
-#endif
-#if NUM_SERVICES > 10
-  , { SERV_10_INIT, SERV_10_RUN }
-#endif
-#if NUM_SERVICES > 11
-  , { SERV_11_INIT, SERV_11_RUN }
-#endif
-#if NUM_SERVICES > 12
-  , { SERV_12_INIT, SERV_12_RUN }
-#endif
-#if NUM_SERVICES > 13
-  , { SERV_13_INIT, SERV_13_RUN }
-#endif
-#if NUM_SERVICES > 14
-  , { SERV_14_INIT, SERV_14_RUN }
-#endif
-#if NUM_SERVICES > 15
-  , { SERV_15_INIT, SERV_15_RUN }
-#endif
+{
+  ES_SERVICE_TABLE(SERV_DESC_ROW)
 };
 
+// ServDescList[NUM_SERVICES] & Ready have to line up
+typedef char ES_CheckServiceCount[(NUM_SERVICES <= MAX_NUM_SERVICES) ? 1 : -1];
+
+// a bit for every service in ES_SERVICE_TABLE
+#define ALL_SERVICES_MASK ((ES_ServiceMask_t)(((ES_ServiceMask_t)~0U) >> \
+    (sizeof(ES_ServiceMask_t) * 8 - NUM_SERVICES)))
+
 /****************************************************************************/
-// The queues for the services
+// The entries of the queues for the services, one member per service so
+// that they are packed back to back in one block, each exactly the size it
+// asked for, & the state of each queue
 
-static ES_Event_t Queue0[SERV_0_QUEUE_SIZE + 1];
-#if NUM_SERVICES > 1
-static ES_Event_t Queue1[SERV_1_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 2
-static ES_Event_t Queue2[SERV_2_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 3
-static ES_Event_t Queue3[SERV_3_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 4
-static ES_Event_t Queue4[SERV_4_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 5
-static ES_Event_t Queue5[SERV_5_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 6
-static ES_Event_t Queue6[SERV_6_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 7
-static ES_Event_t Queue7[SERV_7_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 8
-static ES_Event_t Queue8[SERV_8_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 9
-static ES_Event_t Queue9[SERV_9_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 10
-static ES_Event_t Queue10[SERV_10_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 11
-static ES_Event_t Queue11[SERV_11_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 12
-static ES_Event_t Queue12[SERV_12_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 13
-static ES_Event_t Queue13[SERV_13_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 14
-static ES_Event_t Queue14[SERV_14_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 15
-static ES_Event_t Queue15[SERV_15_QUEUE_SIZE + 1];
-#endif
+#define QUEUE_STORAGE_ROW(Name, QueueSize, QueueKind) \
+  ES_PackedEvent_t Name[QUEUE_ENTRIES(QueueSize)];
+
+static struct
+{
+  ES_SERVICE_TABLE(QUEUE_STORAGE_ROW)
+} Queues;
+
+static ES_QueueState_t QueueStates[NUM_SERVICES];
+
+/****************************************************************************/
+// Each service's express lane for the ES_URGENT_EVENT_TABLE events, all the
+// same size & always the critical kind, as an ISR may post into any of them
+
+static ES_PackedEvent_t UrgentEntries[NUM_SERVICES][ES_URGENT_QUEUE_SIZE];
+static ES_QueueState_t  UrgentStates[NUM_SERVICES];
+
+#define URGENT_DESC_ROW(Name, QueueSize, QueueKind) \
+  { UrgentEntries[SERV_PRIORITY(Name)], &UrgentStates[SERV_PRIORITY(Name)], \
+  ES_URGENT_QUEUE_SIZE, ES_QUEUE_KIND_CRITICAL },
+
+static ES_Queue_t const UrgentQueues[NUM_SERVICES] = {
+  ES_SERVICE_TABLE(URGENT_DESC_ROW)
+};
+
+typedef char ES_CheckUrgentSize[((ES_URGENT_QUEUE_SIZE > 0) &&
+    (ES_URGENT_QUEUE_SIZE <= 255)) ? 1 : -1];
 
 /****************************************************************************/
 // array of queue descriptors for posting by priority level
 
+#define QUEUE_DESC_ROW(Name, QueueSize, QueueKind) \
+  { { Queues.Name, &QueueStates[SERV_PRIORITY(Name)], \
+  ARRAY_SIZE(Queues.Name), QueueKind }, QueueSize },
+
 static ES_QueueDesc_t const EventQueues[NUM_SERVICES] = {
-  { Queue0, ARRAY_SIZE(Queue0) }
-#if NUM_SERVICES > 1
-  , { Queue1, ARRAY_SIZE(Queue1) }
-#endif
-#if NUM_SERVICES > 2
-  , { Queue2, ARRAY_SIZE(Queue2) }
-#endif
-#if NUM_SERVICES > 3
-  , { Queue3, ARRAY_SIZE(Queue3) }
-#endif
-#if NUM_SERVICES > 4
-  , { Queue4, ARRAY_SIZE(Queue4) }
-#endif
-#if NUM_SERVICES > 5
-  , { Queue5, ARRAY_SIZE(Queue5) }
-#endif
-#if NUM_SERVICES > 6
-  , { Queue6, ARRAY_SIZE(Queue6) }
-#endif
-#if NUM_SERVICES > 7
-  , { Queue7, ARRAY_SIZE(Queue7) }
-#endif
-#if NUM_SERVICES > 8
-  , { Queue8, ARRAY_SIZE(Queue8) }
-#endif
-#if NUM_SERVICES > 9
-  , { Queue9, ARRAY_SIZE(Queue9) }
-#endif
-#if NUM_SERVICES > 10
-  , { Queue10, ARRAY_SIZE(Queue10) }
-#endif
-#if NUM_SERVICES > 11
-  , { Queue11, ARRAY_SIZE(Queue11) }
-#endif
-#if NUM_SERVICES > 12
-  , { Queue12, ARRAY_SIZE(Queue12) }
-#endif
-#if NUM_SERVICES > 13
-  , { Queue13, ARRAY_SIZE(Queue13) }
-#endif
-#if NUM_SERVICES > 14
-  , { Queue14, ARRAY_SIZE(Queue14) }
-#endif
-#if NUM_SERVICES > 15
-  , { Queue15, ARRAY_SIZE(Queue15) }
-#endif
+  ES_SERVICE_TABLE(QUEUE_DESC_ROW)
 };
 
 /****************************************************************************/
 // Variable used to keep track of which queues have events in them
 
-uint16_t Ready;
+ES_ServiceMask_t Ready;
+// & which express lanes do
+static ES_ServiceMask_t UrgentReady;
+
+// for each event type, a bit for every service subscribed to it
+static ES_ServiceMask_t Subscribers[ES_NUM_EVENT_TYPES];
+
+#ifdef ES_RUN_BUDGET
+#define RUN_BUDGET_CYCLES (ES_RUN_BUDGET_US * _HW_CYCLES_PER_US)
+#define SERVICE_DEADLINE_CYCLES (ES_SERVICE_DEADLINE_US * _HW_CYCLES_PER_US)
+
+static ES_RunStats_t RunStats[NUM_SERVICES];
+// times ES_Run broke out of a busy dispatch loop to run the checkers
+static uint16_t ForcedPasses;
+#endif
+
+#ifdef ES_STARTUP_STATS
+// how long each init function took, & the count when ES_Initialize began
+static uint32_t InitCycles[NUM_SERVICES];
+static uint32_t StartCount;
+// the services still to dispatch their ES_INIT, & all of it once they have
+static ES_ServiceMask_t NotUp;
+static uint32_t StartupCycles;
+#endif
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -249,13 +225,25 @@ uint16_t Ready;
  Description
    Initialize all the services and tests for NULL pointers in the array
  Notes
-
+   Two passes. The first checks every service & sets up every queue, the
+   second runs the init functions. So an init, or an ISR one of them
+   enables, can post to any service no matter where it is in the table.
+   An init should only bring up its own hardware & post its ES_INIT,
+   anything that needs another service goes in its ES_INIT handling,
+   which ES_Run only gets to once every init is done.
  Author
    J. Edward Carryer, 10/23/11,
 ****************************************************************************/
 ES_Return_t ES_Initialize(TimerRate_t NewRate)
 {
   uint8_t i;
+#ifdef ES_STARTUP_STATS
+  uint32_t InitStart;
+
+  StartCount = _HW_GetCycleCount();
+  NotUp = ALL_SERVICES_MASK;
+  StartupCycles = 0;
+#endif
   ES_Timer_Init(NewRate);  // start up the timer subsystem
   // loop through the list testing for NULL pointers and
   for (i = 0; i < ARRAY_SIZE(ServDescList); i++)
@@ -266,12 +254,25 @@ ES_Return_t ES_Initialize(TimerRate_t NewRate)
       return FailedPointer; // protect against NULL pointers
     }
     // and initializing the event queues (must happen before running inits)
-    ES_InitQueue(EventQueues[i].pMem, EventQueues[i].Size);
-    // executing the init functions
+    if ((ES_InitQueue(&EventQueues[i].Queue) == 0) ||
+        (ES_InitQueue(&UrgentQueues[i]) == 0))
+    {
+      return FailedInit; // queue size doesn't suit the requested kind
+    }
+  }
+  // then executing the init functions
+  for (i = 0; i < ARRAY_SIZE(ServDescList); i++)
+  {
+#ifdef ES_STARTUP_STATS
+    InitStart = _HW_GetCycleCount();
+#endif
     if (ServDescList[i].InitFunc(i) != true)
     {
       return FailedInit; // this is a failed initialization
     }
+#ifdef ES_STARTUP_STATS
+    InitCycles[i] = _HW_GetCycleCount() - InitStart;
+#endif
   }
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
   _HW_DebugLines_Init();
@@ -293,6 +294,9 @@ ES_Return_t ES_Initialize(TimerRate_t NewRate)
    while all the queues are empty, it searches for system generated or
    user generated events or moves bytes from buffer to UART.
  Notes
+   an event in any express lane is run before any in a normal queue, so a
+   low priority service with an urgent event goes ahead of a higher
+   priority one with only normal events waiting
    this function only returns in case of an error
  Author
    J. Edward Carryer, 10/23/11,
@@ -302,28 +306,103 @@ ES_Return_t ES_Run(void)
   // make these static to improve speed
   uint8_t         HighestPrior;
   static ES_Event_t ThisEvent;
+  ES_Event_t      RunResult;
+#if defined(ES_PROFILE_DISPATCH) || defined(ES_RUN_BUDGET) || \
+  defined(ES_TRACE_DISPATCH)
+  uint32_t        DispatchStart;
+#endif
+#ifdef ES_RUN_BUDGET
+  uint32_t        RunCycles;
+  uint32_t        SliceStart = _HW_GetCycleCount();
+  uint8_t         SliceDispatches = 0;
+#endif
 
   while (1)  // stay here unless we detect an error condition
   { // loop through the list executing the run functions for services
     // with a non-empty queue. Process any pending ints before testing
     // Ready
-    while ((_HW_Process_Pending_Ints()) && (Ready != 0))
+    while ((_HW_Process_Pending_Ints()) && ((Ready | UrgentReady) != 0))
     {
-      HighestPrior = ES_GetMSBitSet(Ready);
-      if (ES_DeQueue(EventQueues[HighestPrior].pMem, &ThisEvent) == 0)
+#if defined(ES_PROFILE_DISPATCH) || defined(ES_RUN_BUDGET) || \
+  defined(ES_TRACE_DISPATCH)
+      DispatchStart = _HW_GetCycleCount();
+#endif
+      if (UrgentReady != 0)
+      {
+        HighestPrior = ES_GetMSBitSet(UrgentReady);
+        if (ES_DeQueue(&UrgentQueues[HighestPrior], &ThisEvent) == 0)
+        {
+          EnterCritical();
+          UrgentReady &= BitNum2ClrMask[HighestPrior];
+          if (!ES_IsQueueEmpty(&UrgentQueues[HighestPrior]))
+          {
+            UrgentReady |= BitNum2SetMask[HighestPrior];
+          }
+          ExitCritical();
+        }
+      }
+      else
       {
-        Ready &= BitNum2ClrMask[HighestPrior]; // mark queue as now empty
+        HighestPrior = ES_GetMSBitSet(Ready);
+        if (ES_DeQueue(&EventQueues[HighestPrior].Queue, &ThisEvent) == 0)
+        {
+          EnterCritical();
+          Ready &= BitNum2ClrMask[HighestPrior]; // mark queue as now empty
+          // an ISR may have posted since we pulled the last event out,
+          // if so put the Ready bit back rather than strand the event
+          if (!ES_IsQueueEmpty(&EventQueues[HighestPrior].Queue))
+          {
+            Ready |= BitNum2SetMask[HighestPrior];
+          }
+          ExitCritical();
+        }
       }
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
       _HW_DebugSetLine1();
 #endif
-      if (ServDescList[HighestPrior].RunFunc(ThisEvent).EventType !=
-          ES_NO_EVENT)
+      RunResult = ServDescList[HighestPrior].RunFunc(ThisEvent);
+#ifdef ES_STARTUP_STATS
+      if ((NotUp != 0) && (ThisEvent.EventType == ES_INIT))
+      {
+        NotUp &= BitNum2ClrMask[HighestPrior];
+        if (NotUp == 0)
+        {
+          StartupCycles = _HW_GetCycleCount() - StartCount;
+        }
+      }
+#endif
+#ifdef ES_RUN_BUDGET
+      RunCycles = _HW_GetCycleCount() - DispatchStart;
+      NoteRunTime(HighestPrior, ThisEvent.EventType, RunCycles);
+#endif
+#ifdef ES_PROFILE_DISPATCH
+      ES_Profile_Record(HighestPrior, ThisEvent.EventType, DispatchStart,
+          _HW_GetCycleCount() - DispatchStart);
+#endif
+#ifdef ES_TRACE_DISPATCH
+      ES_Trace_Record(HighestPrior, ThisEvent, DispatchStart,
+          _HW_GetCycleCount() - DispatchStart);
+#endif
+      if (RunResult.EventType != ES_NO_EVENT)
       {
         return FailedRun;
       }
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
       _HW_DebugClearLine1();
+#endif
+#ifdef ES_RUN_BUDGET
+      // the checkers normally only run once every queue is empty. If this
+      // slice of dispatching has used up its budget give them, & the UART,
+      // a turn now. Anything they post is picked up on the next pass
+      if ((++SliceDispatches >= ES_RUN_BUDGET_DISPATCHES) ||
+          ((_HW_GetCycleCount() - SliceStart) >= RUN_BUDGET_CYCLES))
+      {
+        ForcedPasses++;
+        ES_CheckUserEvents();
+        Terminal_MoveBuffer2UART();
+        SliceStart = _HW_GetCycleCount();
+        SliceDispatches = 0;
+      }
 #endif
     }
 
@@ -333,10 +412,24 @@ ES_Return_t ES_Run(void)
     // all the queues are empty, so look for new user detected events
     if (!ES_CheckUserEvents()) // no new user events
     {
+#ifdef BINLOG_ENABLED
+      BinLog_Drain(); // move binary log records into the transmit buffer
+#endif
       Terminal_MoveBuffer2UART(); // try moving bytes, if available, to UART
+#ifdef ES_TICKLESS_IDLE
+      if ((Ready | UrgentReady) == 0)
+      {
+        _HW_IdleUntilNextEvent(); // nothing to do until an interrupt
+      }
+#endif
     }
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
     _HW_DebugClearLine2();
+#endif
+#ifdef ES_RUN_BUDGET
+    // the checkers just ran, start a new slice
+    SliceStart = _HW_GetCycleCount();
+    SliceDispatches = 0;
 #endif
   }
 }
@@ -351,33 +444,95 @@ ES_Return_t ES_Run(void)
  Description
    posts to all of the services' queues
  Notes
-
+   a full queue doesn't stop the rest getting the event
  Author
    J. Edward Carryer, 01/15/12,
 ****************************************************************************/
 bool ES_PostAll(ES_Event_t ThisEvent)
 {
-  uint8_t i;
-  // loop through the list executing the post functions
-  for (i = 0; i < ARRAY_SIZE(EventQueues); i++)
+  return PostToMask(ALL_SERVICES_MASK, ThisEvent) == 0;
+}
+
+/****************************************************************************
+ Function
+   ES_Subscribe
+ Parameters
+   uint8_t : Which service (index into ServDescList)
+   ES_EventType_t : the event type it wants
+ Returns
+   boolean : False if the service or the event type is out of range
+ Description
+   adds the service to the subscribers for the event type, so it gets a copy
+   of every ES_Publish of that type
+ Notes
+   usually called from the service's Init function
+ Author
+   Tianyu, 10/14/26 19:30
+****************************************************************************/
+bool ES_Subscribe(uint8_t WhichService, ES_EventType_t WhichEvent)
+{
+  if ((WhichService >= NUM_SERVICES) || (WhichEvent >= ES_NUM_EVENT_TYPES))
   {
-    if (ES_EnQueueFIFO(EventQueues[i].pMem, ThisEvent) != true)
-    {
-      break; // this is a failed post
-    }
-    else
-    {
-      Ready |= BitNum2SetMask[i]; // show queue as non-empty
-    }
+    return false;
   }
-  if (i == ARRAY_SIZE(EventQueues))    // if no failures
+  EnterCritical();  // an ISR may be publishing
+  Subscribers[WhichEvent] |= BitNum2SetMask[WhichService];
+  ExitCritical();
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_Unsubscribe
+ Parameters
+   uint8_t : Which service (index into ServDescList)
+   ES_EventType_t : the event type it no longer wants
+ Returns
+   boolean : False if the service or the event type is out of range
+ Description
+   takes the service off the subscribers for the event type
+ Notes
+
+ Author
+   Tianyu, 10/14/26 19:30
+****************************************************************************/
+bool ES_Unsubscribe(uint8_t WhichService, ES_EventType_t WhichEvent)
+{
+  if ((WhichService >= NUM_SERVICES) || (WhichEvent >= ES_NUM_EVENT_TYPES))
   {
-    return true;
+    return false;
   }
-  else
+  EnterCritical();
+  Subscribers[WhichEvent] &= BitNum2ClrMask[WhichService];
+  ExitCritical();
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_Publish
+ Parameters
+   ES_Event : The Event to be posted
+ Returns
+   ES_ServiceMask_t : a bit (as in Ready) for each subscriber whose queue was full,
+              0 if every subscriber got the event
+ Description
+   posts the event to every service subscribed to its type
+ Notes
+   all of the posts, and setting their Ready bits, happen in one critical
+   region, so ES_Run sees the event in every queue or in none. A full queue
+   only costs that subscriber the event. An SPSC queue must only get
+   published events from its one producer
+ Author
+   Tianyu, 10/14/26 19:30
+****************************************************************************/
+ES_ServiceMask_t ES_Publish(ES_Event_t ThisEvent)
+{
+  if (ThisEvent.EventType >= ES_NUM_EVENT_TYPES)
   {
-    return false;
+    return 0;
   }
+  return PostToMask(Subscribers[ThisEvent.EventType], ThisEvent);
 }
 
 /****************************************************************************
@@ -391,23 +546,39 @@ bool ES_PostAll(ES_Event_t ThisEvent)
  Description
    posts to one of the services' queues
  Notes
-   used by the timer library to associate a timer with a state machine
+   used by the timer library to associate a timer with a state machine.
+   An urgent event goes in the service's express lane instead
  Author
    J. Edward Carryer, 01/16/12,
 ****************************************************************************/
 bool ES_PostToService(uint8_t WhichService, ES_Event_t TheEvent)
 {
-  if ((WhichService < ARRAY_SIZE(EventQueues)) &&
-      (ES_EnQueueFIFO(EventQueues[WhichService].pMem, TheEvent) ==
-        true))
+  bool Posted = false;
+
+  if (ES_IsUrgentEvent(TheEvent.EventType))
   {
-    Ready |= BitNum2SetMask[WhichService]; // show queue as non-empty
-    return true;
+    return ES_PostToServiceUrgent(WhichService, TheEvent);
   }
-  else
+  if (WhichService < ARRAY_SIZE(EventQueues))
   {
-    return false;
+    // the add & the Ready bit in one critical region, so an ISR post in
+    // between can't lose either one
+    EnterCritical();
+    Posted = ES_EnQueueFIFOInCritical(&EventQueues[WhichService].Queue,
+        TheEvent);
+    if (Posted == true)
+    {
+      Ready |= BitNum2SetMask[WhichService]; // show queue as non-empty
+    }
+    ExitCritical();
+  }
+#ifdef ES_PROFILE_DISPATCH
+  if (Posted == true)
+  {
+    ES_Profile_NotePost(WhichService, false);
   }
+#endif
+  return Posted;
 }
 
 /****************************************************************************
@@ -427,22 +598,509 @@ bool ES_PostToService(uint8_t WhichService, ES_Event_t TheEvent)
 ****************************************************************************/
 bool ES_PostToServiceLIFO(uint8_t WhichService, ES_Event_t TheEvent)
 {
-  if ((WhichService < ARRAY_SIZE(EventQueues)) &&
-      (ES_EnQueueLIFO(EventQueues[WhichService].pMem, TheEvent) ==
-        true))
+  bool Posted = false;
+
+  if (WhichService < ARRAY_SIZE(EventQueues))
+  {
+    // the add & the Ready bit in one critical region, so an ISR post in
+    // between can't lose either one
+    EnterCritical();
+    Posted = ES_EnQueueLIFOInCritical(&EventQueues[WhichService].Queue,
+        TheEvent);
+    if (Posted == true)
+    {
+      Ready |= BitNum2SetMask[WhichService]; // show queue as non-empty
+    }
+    ExitCritical();
+  }
+#ifdef ES_PROFILE_DISPATCH
+  if (Posted == true)
+  {
+    ES_Profile_NotePost(WhichService, true);
+  }
+#endif
+  return Posted;
+}
+
+/****************************************************************************
+ Function
+   ES_PostBlockToServiceLIFO
+ Parameters
+   uint8_t : Which service to post to (index into ServDescList)
+   const ES_Event * : The Events to be posted, oldest first
+   uint8_t : how many there are
+ Returns
+   boolean : False if they don't all fit, then none were posted
+ Description
+   Posts the events to the front of one of the services' queues, in their
+   own order, in one critical region (see ES_EnQueueFrontBlock)
+ Notes
+   used by the batched recall of ES_DeferRecall.c, from the main loop
+ Author
+   Tianyu, 10/14/26 22:50
+****************************************************************************/
+bool ES_PostBlockToServiceLIFO(uint8_t WhichService,
+    const ES_Event_t *pEvents, uint8_t Count)
+{
+  uint8_t i;
+
+  if ((WhichService >= ARRAY_SIZE(EventQueues)) || (Count == 0))
+  {
+    return false;
+  }
+  EnterCritical();
+  if (ES_EnQueueFrontBlockInCritical(&EventQueues[WhichService].Queue,
+      pEvents, Count) == false)
+  {
+    ExitCritical();
+    return false;
+  }
+  Ready |= BitNum2SetMask[WhichService]; // show queue as non-empty
+  ExitCritical();
+#ifdef ES_PROFILE_DISPATCH
+  for (i = 0; i < Count; i++)
+  {
+    ES_Profile_NotePost(WhichService, true);
+  }
+#else
+  (void)i;
+#endif
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_PostToServiceCoalesce
+ Parameters
+   uint8_t : Which service to post to (index into ServDescList)
+   ES_Event : The Event to be posted
+ Returns
+   boolean : False if the post function failed during execution
+ Description
+   posts to one of the services' queues, merging into an event of the same
+   type if one is already waiting (see ES_EnQueueCoalesce)
+ Notes
+   for periodic updates where only the latest value matters
+ Author
+   Tianyu, 10/14/26 19:10
+****************************************************************************/
+bool ES_PostToServiceCoalesce(uint8_t WhichService, ES_Event_t TheEvent)
+{
+  bool Posted = false;
+
+  if (WhichService < ARRAY_SIZE(EventQueues))
+  {
+    // the add & the Ready bit in one critical region, so an ISR post in
+    // between can't lose either one
+    EnterCritical();
+    Posted = ES_EnQueueCoalesceInCritical(&EventQueues[WhichService].Queue,
+        TheEvent);
+    if (Posted == true)
+    {
+      Ready |= BitNum2SetMask[WhichService]; // show queue as non-empty
+    }
+    ExitCritical();
+  }
+#ifdef ES_PROFILE_DISPATCH
+  if (Posted == true)
   {
-    Ready |= BitNum2SetMask[WhichService]; // show queue as non-empty
+    ES_Profile_NotePost(WhichService, false);
+  }
+#endif
+  return Posted;
+}
+
+/****************************************************************************
+ Function
+   ES_PostToServiceUrgent
+ Parameters
+   uint8_t : Which service to post to (index into ServDescList)
+   ES_Event : The Event to be posted
+ Returns
+   boolean : False if the service's express lane is full
+ Description
+   posts to the back of one of the services' express lanes, so that it is
+   run after the urgent events already waiting & ahead of everything else
+ Notes
+   ES_PostToService & ES_Publish call this for the ES_URGENT_EVENT_TABLE
+   events, it can be called for any other event that has to jump the
+   queue. A full lane is a drop, in its own statistics, the event is not
+   put in the normal queue where it would be run after the ones behind it
+ Author
+   Tianyu, 10/14/26 23:59
+****************************************************************************/
+bool ES_PostToServiceUrgent(uint8_t WhichService, ES_Event_t TheEvent)
+{
+  bool Posted = false;
+
+  if (WhichService < ARRAY_SIZE(UrgentQueues))
+  {
+    EnterCritical();
+    Posted = ES_EnQueueFIFOInCritical(&UrgentQueues[WhichService], TheEvent);
+    if (Posted == true)
+    {
+      UrgentReady |= BitNum2SetMask[WhichService]; // show lane as non-empty
+    }
+    ExitCritical();
+  }
+#ifdef ES_PROFILE_DISPATCH
+  if (Posted == true)
+  {
+    ES_Profile_NotePost(WhichService, false);
+  }
+#endif
+  return Posted;
+}
+
+/****************************************************************************
+ Function
+   ES_IsUrgentEvent
+ Parameters
+   ES_EventType_t : the event type
+ Returns
+   boolean : True if it is in ES_URGENT_EVENT_TABLE
+ Author
+   Tianyu, 10/14/26 23:59
+****************************************************************************/
+#define URGENT_CASE(Type) case Type:
+
+bool ES_IsUrgentEvent(ES_EventType_t WhichEvent)
+{
+  switch (WhichEvent)
+  {
+    ES_URGENT_EVENT_TABLE(URGENT_CASE)
     return true;
+
+    default:
+      return false;
   }
-  else
+}
+
+/****************************************************************************
+ Function
+   ES_FlushServiceQueue
+ Parameters
+   uint8_t : Which service's queue (index into ServDescList)
+ Returns
+   uint8_t : the number of events thrown away
+ Description
+   empties a service's queue & express lane without running the service,
+   for test code that posts outside of ES_Run
+ Notes
+   the events are pulled out one at a time, like ES_Run does, so an ISR
+   post in the middle is either flushed or left with its Ready bit set
+ Author
+   Tianyu, 10/14/26 21:10
+****************************************************************************/
+uint8_t ES_FlushServiceQueue(uint8_t WhichService)
+{
+  ES_Event_t Discard;
+  uint8_t    NumFlushed = 0;
+
+  if (WhichService >= ARRAY_SIZE(EventQueues))
+  {
+    return 0;
+  }
+  while (!ES_IsQueueEmpty(&EventQueues[WhichService].Queue))
+  {
+    ES_DeQueue(&EventQueues[WhichService].Queue, &Discard);
+    NumFlushed++;
+  }
+  while (!ES_IsQueueEmpty(&UrgentQueues[WhichService]))
+  {
+    ES_DeQueue(&UrgentQueues[WhichService], &Discard);
+    NumFlushed++;
+  }
+  EnterCritical();
+  Ready &= BitNum2ClrMask[WhichService];
+  if (!ES_IsQueueEmpty(&EventQueues[WhichService].Queue))
+  {
+    Ready |= BitNum2SetMask[WhichService];
+  }
+  UrgentReady &= BitNum2ClrMask[WhichService];
+  if (!ES_IsQueueEmpty(&UrgentQueues[WhichService]))
+  {
+    UrgentReady |= BitNum2SetMask[WhichService];
+  }
+  ExitCritical();
+#ifdef ES_PROFILE_DISPATCH
+  ES_Profile_NoteFlush(WhichService);
+#endif
+  return NumFlushed;
+}
+
+/****************************************************************************
+ Function
+   ES_GetServiceQueueStats
+ Parameters
+   uint8_t : Which service's queue (index into ServDescList)
+   ES_QueueStats_t * : where to put the statistics
+ Returns
+   boolean : False if WhichService is not a service
+ Description
+   copies out the depth, high water mark & drop statistics for a queue
+ Notes
+
+ Author
+   Tianyu, 10/14/26 16:50
+****************************************************************************/
+bool ES_GetServiceQueueStats(uint8_t WhichService, ES_QueueStats_t *pStats)
+{
+  if (WhichService >= ARRAY_SIZE(EventQueues))
+  {
+    return false;
+  }
+  ES_GetQueueStats(&EventQueues[WhichService].Queue, pStats);
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_ReportQueueStats
+ Parameters
+   None
+ Returns
+   Nothing
+ Description
+   prints the statistics for every service's queue, & for each express
+   lane that has been used. In the
+   ES_QUEUE_SIZING_MODE build it also prints a suggested QueueSize
+   based on the high water mark seen so far.
+ Notes
+   the suggestion leaves one entry of headroom above the high water mark and
+   rounds SPSC queues up to a power of 2. It is only as good as the run that
+   it was measured on, so exercise everything (especially bursts of
+   ES_COMMAND_RETRIEVED) before trusting it.
+ Author
+   Tianyu, 10/14/26 16:50
+****************************************************************************/
+void ES_ReportQueueStats(void)
+{
+  ES_QueueStats_t Stats;
+  uint8_t         i;
+
+  DB_printf("\r\nSvc Size Kind Now High Drops LastDrop\r\n");
+  for (i = 0; i < ARRAY_SIZE(EventQueues); i++)
+  {
+    ES_GetQueueStats(&EventQueues[i].Queue, &Stats);
+    DB_printf("%d   %d    %d    %d   %d    %d     %d\r\n", i,
+        Stats.QueueSize, Stats.QueueKind, Stats.NumEntries, Stats.HighWater,
+        Stats.DropCount, Stats.LastDropType);
+    ES_GetQueueStats(&UrgentQueues[i], &Stats);
+    if (Stats.HighWater != 0)
+    {
+      DB_printf("    urgent  %d   %d    %d     %d\r\n", Stats.NumEntries,
+          Stats.HighWater, Stats.DropCount, Stats.LastDropType);
+    }
+    ES_GetQueueStats(&EventQueues[i].Queue, &Stats);
+#ifdef ES_QUEUE_SIZING_MODE
+    {
+      uint8_t Suggested = Stats.HighWater + 1;
+
+      if (ES_QUEUE_KIND_SPSC == Stats.QueueKind)
+      {
+        uint8_t Pow2 = 1;
+        while (Pow2 < Suggested)
+        {
+          Pow2 <<= 1;
+        }
+        Suggested = Pow2;
+      }
+      if (Stats.DropCount != 0)
+      {
+        DB_printf("    dropped events, raise ES_QUEUE_SIZING_DEPTH\r\n");
+      }
+      else
+      {
+        DB_printf("    service %d QueueSize is %d, suggest %d\r\n", i,
+            EventQueues[i].ConfigSize, Suggested);
+      }
+    }
+#endif
+  }
+}
+
+#ifdef ES_RUN_BUDGET
+/****************************************************************************
+ Function
+   ES_GetRunStats
+ Parameters
+   uint8_t : which service
+   ES_RunStats_t * : where to put the statistics
+ Returns
+   bool : false if the service number is out of range
+ Description
+   copies out the worst case run time & deadline overruns for one service
+ Author
+   Tianyu, 10/14/26 19:50
+****************************************************************************/
+bool ES_GetRunStats(uint8_t WhichService, ES_RunStats_t *pStats)
+{
+  if (WhichService >= ARRAY_SIZE(RunStats))
+  {
+    return false;
+  }
+  *pStats = RunStats[WhichService];
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_GetForcedBackgroundPasses
+ Parameters
+   None
+ Returns
+   uint16_t : how many times ES_Run ran the event checkers because the
+   dispatch budget ran out, rather than because the queues were empty
+ Author
+   Tianyu, 10/14/26 19:50
+****************************************************************************/
+uint16_t ES_GetForcedBackgroundPasses(void)
+{
+  return ForcedPasses;
+}
+
+/****************************************************************************
+ Function
+   ES_ReportRunStats
+ Parameters
+   None
+ Returns
+   Nothing
+ Description
+   prints the worst case run time (uS) & the deadline overruns for every
+   service, then the number of forced passes through the event checkers
+ Author
+   Tianyu, 10/14/26 19:50
+****************************************************************************/
+void ES_ReportRunStats(void)
+{
+  uint8_t i;
+
+  DB_printf("\r\nSvc MaxuS Overruns LastType (deadline %duS)\r\n",
+      ES_SERVICE_DEADLINE_US);
+  for (i = 0; i < ARRAY_SIZE(RunStats); i++)
+  {
+    DB_printf("%d   %d     %d        %d\r\n", i,
+        RunStats[i].MaxCycles / _HW_CYCLES_PER_US, RunStats[i].Overruns,
+        RunStats[i].LastOverrunType);
+  }
+  DB_printf("Forced checker passes %d\r\n", ForcedPasses);
+}
+
+/****************************************************************************
+ Function
+   ES_ResetRunStats
+ Parameters
+   None
+ Returns
+   Nothing
+ Description
+   clears the run time statistics & the forced pass count
+ Author
+   Tianyu, 10/14/26 19:50
+****************************************************************************/
+void ES_ResetRunStats(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < ARRAY_SIZE(RunStats); i++)
+  {
+    RunStats[i].MaxCycles = 0;
+    RunStats[i].Overruns = 0;
+    RunStats[i].LastOverrunType = ES_NO_EVENT;
+  }
+  ForcedPasses = 0;
+}
+#endif /* ES_RUN_BUDGET */
+
+#ifdef ES_STARTUP_STATS
+/****************************************************************************
+ Function
+   ES_GetInitCycles
+ Parameters
+   uint8_t : Which service
+   uint32_t * : where its init function's time goes, in _HW_GetCycleCount
+   counts
+ Returns
+   boolean : False if WhichService is out of range
+ Author
+   Tianyu, 10/14/26 23:40
+****************************************************************************/
+bool ES_GetInitCycles(uint8_t WhichService, uint32_t *pCycles)
+{
+  if (WhichService >= ARRAY_SIZE(InitCycles))
   {
     return false;
   }
+  *pCycles = InitCycles[WhichService];
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_GetStartupCycles
+ Parameters
+   None
+ Returns
+   uint32_t : _HW_GetCycleCount counts from the start of ES_Initialize to
+   the last service's ES_INIT being run, 0 until then
+ Author
+   Tianyu, 10/14/26 23:40
+****************************************************************************/
+uint32_t ES_GetStartupCycles(void)
+{
+  return StartupCycles;
+}
+
+/****************************************************************************
+ Function
+   ES_ReportStartup
+ Parameters
+   None
+ Returns
+   Nothing
+ Description
+   prints how long (uS) each service's init function took, then the time
+   from the start of ES_Initialize to every service being up
+ Author
+   Tianyu, 10/14/26 23:40
+****************************************************************************/
+void ES_ReportStartup(void)
+{
+  uint8_t i;
+
+  DB_printf("\r\nSvc InituS\r\n");
+  for (i = 0; i < ARRAY_SIZE(InitCycles); i++)
+  {
+    DB_printf("%d   %d\r\n", i, InitCycles[i] / _HW_CYCLES_PER_US);
+  }
+  DB_printf("Up %duS after ES_Initialize began\r\n",
+      StartupCycles / _HW_CYCLES_PER_US);
 }
+#endif /* ES_STARTUP_STATS */
 
 //*********************************
 // private functions
 //*********************************
+#ifdef ES_RUN_BUDGET
+static void NoteRunTime(uint8_t WhichService, ES_EventType_t WhichEvent,
+    uint32_t RunCycles)
+{
+  ES_RunStats_t *pStats = &RunStats[WhichService];
+
+  if (RunCycles > pStats->MaxCycles)
+  {
+    pStats->MaxCycles = RunCycles;
+  }
+  if (RunCycles > SERVICE_DEADLINE_CYCLES)
+  {
+    pStats->Overruns++;
+    pStats->LastOverrunType = WhichEvent;
+  }
+}
+#endif
+
 #if 0
 /****************************************************************************
  Function
@@ -473,5 +1131,67 @@ static bool CheckSystemEvents(void)
 }
 
 #endif
+
+/****************************************************************************
+ Function
+   PostToMask
+ Parameters
+   ES_ServiceMask_t : a bit for each service to post to
+   ES_Event : The Event to be posted
+ Returns
+   ES_ServiceMask_t : the bits for the services whose queues were full
+ Description
+   posts to each service in the mask, highest priority first, & marks the
+   ones that took the event as ready, all with interrupts off
+ Notes
+   an urgent event goes in the express lanes
+
+ Author
+   Tianyu, 10/14/26 19:30
+****************************************************************************/
+static ES_ServiceMask_t PostToMask(ES_ServiceMask_t WhichServices,
+    ES_Event_t ThisEvent)
+{
+  ES_ServiceMask_t Posted = 0;
+  ES_ServiceMask_t Failed = 0;
+  bool             IsUrgent = ES_IsUrgentEvent(ThisEvent.EventType);
+  uint8_t          i;
+
+  EnterCritical();
+  while (WhichServices != 0)
+  {
+    i = ES_GetMSBitSet(WhichServices);
+    WhichServices &= BitNum2ClrMask[i];
+    if (ES_EnQueueFIFOInCritical(IsUrgent ? &UrgentQueues[i] :
+        &EventQueues[i].Queue, ThisEvent) == true)
+    {
+      Posted |= BitNum2SetMask[i];
+    }
+    else
+    {
+      Failed |= BitNum2SetMask[i];
+    }
+  }
+  if (IsUrgent)
+  {
+    UrgentReady |= Posted;  // show the lanes as non-empty
+  }
+  else
+  {
+    Ready |= Posted;  // show the queues as non-empty
+  }
+  ExitCritical();
+
+#ifdef ES_PROFILE_DISPATCH
+  while (Posted != 0)
+  {
+    i = ES_GetMSBitSet(Posted);
+    Posted &= BitNum2ClrMask[i];
+    ES_Profile_NotePost(i, false);
+  }
+#endif
+  return Failed;
+}
+
 /*------------------------------- Footnotes -------------------------------*/
 /*------------------------------ End of file ------------------------------*/
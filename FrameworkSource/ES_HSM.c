@@ -0,0 +1,223 @@
+/****************************************************************************
+ Module
+     ES_HSM.c
+
+ Description
+     This is a module implementing a table driven hierarchical state machine
+     runtime, see ES_HSM.h for how a machine is laid out
+ Notes
+     The runtime keeps no state of its own, everything is in the ES_HSM_t
+     the caller owns, so any number of machines can use it. The state
+     tables are const & stay in flash.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 18:40 ty       started coding
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_HSM.h"
+#include <stddef.h>
+
+/*--------------------------- External Variables --------------------------*/
+
+/*----------------------------- Module Defines ----------------------------*/
+
+/*------------------------------ Module Types -----------------------------*/
+
+/*---------------------------- Module Functions ---------------------------*/
+static bool IsWithin(const ES_HSMState_t *pState,
+    const ES_HSMState_t *pAncestor);
+static void EnterDownTo(const ES_HSMState_t *pCommon,
+    const ES_HSMState_t *pState);
+static void TakeTransition(ES_HSM_t *pMachine, const ES_HSMState_t *pTarget);
+
+/*---------------------------- Module Variables ---------------------------*/
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     ES_HSM_Init
+ Parameters
+     ES_HSM_t *pMachine, the machine to start
+     const ES_HSMState_t *pInitial, the state to start in
+ Returns
+     nothing
+ Description
+     runs the entry actions from the top state down to pInitial (and on
+     through its initial children) & makes that the current state
+ Notes
+     None.
+ Author
+     Tianyu, 10/14/26 18:40
+****************************************************************************/
+void ES_HSM_Init(ES_HSM_t *pMachine, const ES_HSMState_t *pInitial)
+{
+  pMachine->pCurrent = NULL;
+  pMachine->pTarget = NULL;
+  TakeTransition(pMachine, pInitial);
+}
+
+/****************************************************************************
+ Function
+     ES_HSM_Dispatch
+ Parameters
+     ES_HSM_t *pMachine, the machine to run
+     ES_Event_t ThisEvent, the event to process
+ Returns
+     bool true if a state consumed the event, false if it reached the top
+     unhandled
+ Description
+     offers the event to the current state, then to each parent in turn
+     until a handler consumes it, then takes any transition the handler
+     asked for
+ Notes
+     None.
+ Author
+     Tianyu, 10/14/26 18:40
+****************************************************************************/
+bool ES_HSM_Dispatch(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  const ES_HSMState_t *pState = pMachine->pCurrent;
+  bool                Consumed = false;
+  uint8_t             Row;
+
+  pMachine->pTarget = NULL;
+  while ((pState != NULL) && (Consumed == false))
+  {
+    if (pState->pDuring != NULL)
+    {
+      pState->pDuring(ThisEvent);
+    }
+    for (Row = 0; (Row < pState->NumRows) && (Consumed == false); Row++)
+    {
+      if (pState->pRows[Row].EventType == ThisEvent.EventType)
+      {
+        Consumed = pState->pRows[Row].pHandler(pMachine, ThisEvent);
+      }
+    }
+    pState = pState->pParent;
+  }
+
+  if (pMachine->pTarget != NULL)
+  {
+    TakeTransition(pMachine, pMachine->pTarget);
+  }
+  return Consumed;
+}
+
+/****************************************************************************
+ Function
+     ES_HSM_Transition
+ Parameters
+     ES_HSM_t *pMachine, the machine being dispatched
+     const ES_HSMState_t *pTarget, the state to go to
+ Returns
+     nothing
+ Description
+     called from a handler to ask for a transition, taken when the handler
+     returns. If it is called more than once in a dispatch the last call wins
+ Notes
+     None.
+ Author
+     Tianyu, 10/14/26 18:40
+****************************************************************************/
+void ES_HSM_Transition(ES_HSM_t *pMachine, const ES_HSMState_t *pTarget)
+{
+  pMachine->pTarget = pTarget;
+}
+
+/****************************************************************************
+ Function
+     ES_HSM_GetState
+ Parameters
+     const ES_HSM_t *pMachine, the machine to look at
+ Returns
+     const ES_HSMState_t *, the current (leaf) state
+ Description
+     for the owner's Query function, which usually returns pCurrent->Id
+ Notes
+     None.
+ Author
+     Tianyu, 10/14/26 18:40
+****************************************************************************/
+const ES_HSMState_t *ES_HSM_GetState(const ES_HSM_t *pMachine)
+{
+  return pMachine->pCurrent;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+// true if pAncestor is pState or one of its parents
+static bool IsWithin(const ES_HSMState_t *pState,
+    const ES_HSMState_t *pAncestor)
+{
+  while (pState != NULL)
+  {
+    if (pState == pAncestor)
+    {
+      return true;
+    }
+    pState = pState->pParent;
+  }
+  return false;
+}
+
+// entry actions from just below pCommon down to pState, outermost first.
+// Recurses once per level of the hierarchy
+static void EnterDownTo(const ES_HSMState_t *pCommon,
+    const ES_HSMState_t *pState)
+{
+  if (pState->pParent != pCommon)
+  {
+    EnterDownTo(pCommon, pState->pParent);
+  }
+  if (pState->pEntry != NULL)
+  {
+    pState->pEntry();
+  }
+}
+
+static void TakeTransition(ES_HSM_t *pMachine, const ES_HSMState_t *pTarget)
+{
+  const ES_HSMState_t *pCommon;
+  const ES_HSMState_t *pState;
+
+  // the lowest parent of the target that also holds the current state,
+  // everything below it is left & entered again
+  pCommon = pTarget->pParent;
+  while ((pCommon != NULL) && !IsWithin(pMachine->pCurrent, pCommon))
+  {
+    pCommon = pCommon->pParent;
+  }
+
+  for (pState = pMachine->pCurrent; pState != pCommon;
+      pState = pState->pParent)
+  {
+    if (pState->pExit != NULL)
+    {
+      pState->pExit();
+    }
+  }
+
+  EnterDownTo(pCommon, pTarget);
+  pState = pTarget;
+  while (pState->pInitial != NULL)
+  {
+    pState = pState->pInitial;
+    if (pState->pEntry != NULL)
+    {
+      pState->pEntry();
+    }
+  }
+  pMachine->pCurrent = pState;
+  pMachine->pTarget = NULL;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,178 @@
+/****************************************************************************
+ Module
+   ES_IsrStats.c
+
+ Revision
+   1.0.1
+
+ Description
+   The table behind ES_IsrStats_Enter/_NoteLatency/_Exit, & the query,
+   report & reset for it. The recording itself is inline in ES_IsrStats.h,
+   so that it goes straight into the ISRs.
+
+ Notes
+   The rows are written by the ISRs, so everything here that reads or
+   clears one does it in a critical region, one row at a time, to get a
+   consistent copy without holding the interrupts off for the whole table.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 21:30 ty      first pass
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <string.h>
+
+#include "ES_Configure.h"
+#include "ES_Port.h"
+#include "ES_IsrStats.h"
+#include "dbprintf.h"
+
+#ifdef ES_ISR_STATS
+
+/*---------------------------- Module Functions ---------------------------*/
+static void PrintHist(const char *pName, const uint16_t *pHist);
+
+/*---------------------------- Module Variables ---------------------------*/
+ES_IsrStats_t ES_IsrStatsTable[ES_NUM_ISRS];
+
+#define ES_ISR_LABEL_ROW(Name, Label) Label,
+static const char * const IsrLabels[ES_NUM_ISRS] = {
+  ES_ISR_TABLE(ES_ISR_LABEL_ROW)
+};
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_IsrStats_Get
+
+ Parameters
+   ES_IsrId_t : which ISR
+   ES_IsrStats_t * : where to put a copy of its stats
+
+ Returns
+   bool : false if Which is not in ES_ISR_TABLE
+
+ Description
+   takes a consistent copy of one row, for an application that wants to
+   act on the numbers rather than print them
+ Author
+   Tianyu, 10/14/26 21:30
+****************************************************************************/
+bool ES_IsrStats_Get(ES_IsrId_t Which, ES_IsrStats_t *pStats)
+{
+  if ((unsigned)Which >= ES_NUM_ISRS)
+  {
+    return false;
+  }
+  EnterCritical();
+  *pStats = ES_IsrStatsTable[Which];
+  ExitCritical();
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_IsrStats_GetLabel
+
+ Parameters
+   ES_IsrId_t : which ISR
+
+ Returns
+   const char * : its label from ES_ISR_TABLE, "?" if it isn't there
+ Author
+   Tianyu, 10/14/26 21:30
+****************************************************************************/
+const char *ES_IsrStats_GetLabel(ES_IsrId_t Which)
+{
+  return ((unsigned)Which < ES_NUM_ISRS) ? IsrLabels[Which] : "?";
+}
+
+/****************************************************************************
+ Function
+   ES_IsrStats_Report
+
+ Parameters
+   nothing
+
+ Returns
+   nothing
+
+ Description
+   prints the min/max/mean & the histograms of every ISR that has run
+ Notes
+   the histogram buckets are printed as counts, bucket 0 first, see
+   ES_ISR_HIST_SHIFT for the edges
+ Author
+   Tianyu, 10/14/26 21:30
+****************************************************************************/
+void ES_IsrStats_Report(void)
+{
+  uint8_t       Which;
+  ES_IsrStats_t Stats;
+
+  DB_printf("\r\nISR stats (core timer counts, 20/uS), histogram buckets "
+      "<%d, then doubling\r\n", 1 << ES_ISR_HIST_SHIFT);
+  for (Which = 0; Which < ES_NUM_ISRS; Which++)
+  {
+    (void)ES_IsrStats_Get((ES_IsrId_t)Which, &Stats);
+    if (Stats.Count == 0)
+    {
+      continue;
+    }
+    DB_printf("%s: %u calls, duration %u/%u/%u min/max/mean\r\n",
+        IsrLabels[Which], Stats.Count, Stats.MinDuration, Stats.MaxDuration,
+        (uint32_t)(Stats.SumDuration / Stats.Count));
+    PrintHist("duration", Stats.DurationHist);
+    if (Stats.LatencyCount != 0)
+    {
+      DB_printf("  latency %u/%u min/max\r\n", Stats.MinLatency,
+          Stats.MaxLatency);
+      PrintHist("latency", Stats.LatencyHist);
+    }
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_IsrStats_Reset
+
+ Parameters
+   nothing
+
+ Returns
+   nothing
+
+ Description
+   clears the stats so that a new measurement can be started
+ Author
+   Tianyu, 10/14/26 21:30
+****************************************************************************/
+void ES_IsrStats_Reset(void)
+{
+  uint8_t Which;
+
+  for (Which = 0; Which < ES_NUM_ISRS; Which++)
+  {
+    EnterCritical();
+    memset(&ES_IsrStatsTable[Which], 0, sizeof(ES_IsrStatsTable[Which]));
+    ExitCritical();
+  }
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+static void PrintHist(const char *pName, const uint16_t *pHist)
+{
+  uint8_t i;
+
+  DB_printf("  %s hist", pName);
+  for (i = 0; i < ES_ISR_HIST_BUCKETS; i++)
+  {
+    DB_printf(" %u", pHist[i]);
+  }
+  DB_printf("\r\n");
+}
+
+#endif /* ES_ISR_STATS */
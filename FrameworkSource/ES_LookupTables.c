@@ -18,6 +18,11 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 20:50 ty       BitNum2SetMask covers bits 16-31 when
+                         MAX_NUM_SERVICES is over 16
+ 10/14/26 09:10 ty       renamed the table walk to ES_GetMSBitSetByTable, the
+                         CLZ version lives inline in ES_LookupTables.h. TEST
+                         harness now checks & times both against the core timer
  10/20/13 17:03 jec      converted Byte2MSBitNum array to a Nybble sized array
                          (15 entries) and made function GetMSBitSet() to figure
                          out the MSB set. This was done to facilitate moving to
@@ -33,6 +38,7 @@
 #include "ES_Types.h"
 #include "ES_General.h"
 #include "ES_Timers.h"
+#include "ES_LookupTables.h"
 #include "bitdefs.h"
 
 /*----------------------------- Module Defines ----------------------------*/
@@ -56,12 +62,16 @@ uint16_t const BitNum2ClrMask[] = {
 */
 
 /*
-  this table is used to go from a bit number (0-15) to the mask used to set
-  that bit in a byte.
+  this table is used to go from a bit number (0 to MAX_NUM_SERVICES - 1) to
+  the mask used to set that bit in a service mask.
 */
-uint16_t const BitNum2SetMask[] = {
+ES_ServiceMask_t const BitNum2SetMask[MAX_NUM_SERVICES] = {
   BIT0HI, BIT1HI, BIT2HI, BIT3HI, BIT4HI, BIT5HI, BIT6HI, BIT7HI, BIT8HI, BIT9HI,
   BIT10HI, BIT11HI, BIT12HI, BIT13HI, BIT14HI, BIT15HI
+#if MAX_NUM_SERVICES > 16
+  , BIT16HI, BIT17HI, BIT18HI, BIT19HI, BIT20HI, BIT21HI, BIT22HI, BIT23HI,
+  BIT24HI, BIT25HI, BIT26HI, BIT27HI, BIT28HI, BIT29HI, BIT30HI, BIT31HI
+#endif
 };
 
 /*
@@ -76,7 +86,7 @@ uint8_t const Nybble2MSBitNum[15] = {
 };
 
 /*------------------------------ Module Code ------------------------------*/
-uint8_t ES_GetMSBitSet(uint16_t Val2Check)
+uint8_t ES_GetMSBitSetByTable(ES_ServiceMask_t Val2Check)
 {
   int8_t  LoopCntr;
   uint8_t Nybble2Test;
@@ -107,21 +117,89 @@ uint8_t ES_GetMSBitSet(uint16_t Val2Check)
 #ifdef TEST
 #include <stdio.h>
 
+// number of back to back lookups timed for each Ready pattern
+#define NUM_TIMING_PASSES 1000
+
+/*
+  Ready patterns to time: a single low priority service, a single high
+  priority service & a bursty mix like the one we see when commands are
+  arriving while the motors & timers are busy.
+*/
+static const uint16_t TimingPatterns[] = {
+  0x0001, 0x8000, 0x000E, 0x0105, 0x1040
+};
+
+static void FlushConsole(void)
+{
+  uint16_t i;
+  // the UART is fed from the transmit buffer, give it time to drain
+  for (i = 0; i < 2000; i++)
+  {
+    Terminal_MoveBuffer2UART();
+  }
+}
+
 void main(void)
 {
-  uint16_t  Counter = 0;
+  uint16_t  Counter;
   uint8_t   MSBit;
+  uint8_t   WhichPattern;
+  uint32_t  StartTime;
+  uint32_t  TableCycles;
+  uint32_t  ClzCycles;
+  uint16_t  Pass;
+  volatile uint8_t Sink;  // keep the optimizer from dropping the lookups
+
+  _HW_PIC32Init();
 
   puts( "Testing the MSB Look-up function\n\r");
   puts( __TIME__ " " __DATE__);
   puts( "\n\r");
-  MSBit = ES_GetMSBitSet(Counter);
-    printf("the MSB set in %u is bit %d\n\r", Counter, MSBit);
+  FlushConsole();
 
-  for (Counter = 1; Counter != 0; Counter++)
+  // first, make sure that the two versions agree on every possible value
+  Counter = 0;
+  do
   {
     MSBit = ES_GetMSBitSet(Counter);
-    printf("the MSB set in %u is bit %d\n\r", Counter, MSBit);
+    if (MSBit != ES_GetMSBitSetByTable(Counter))
+    {
+      printf("mismatch at %u: %d vs %d\n\r", Counter, MSBit,
+          ES_GetMSBitSetByTable(Counter));
+      FlushConsole();
+    }
+    Counter++;
+  } while (Counter != 0);
+  puts("all 65536 values checked\n\r");
+  FlushConsole();
+
+  // now time them, reported in core timer counts (2 instruction cycles each)
+  for (WhichPattern = 0; WhichPattern < ARRAY_SIZE(TimingPatterns);
+      WhichPattern++)
+  {
+    StartTime = _HW_GetCycleCount();
+    for (Pass = 0; Pass < NUM_TIMING_PASSES; Pass++)
+    {
+      Sink = ES_GetMSBitSetByTable(TimingPatterns[WhichPattern]);
+    }
+    TableCycles = _HW_GetCycleCount() - StartTime;
+
+    StartTime = _HW_GetCycleCount();
+    for (Pass = 0; Pass < NUM_TIMING_PASSES; Pass++)
+    {
+      Sink = ES_GetMSBitSet(TimingPatterns[WhichPattern]);
+    }
+    ClzCycles = _HW_GetCycleCount() - StartTime;
+
+    printf("Ready=0x%x table: %u counts, ES_GetMSBitSet: %u counts per %u\n\r",
+        TimingPatterns[WhichPattern], TableCycles, ClzCycles,
+        NUM_TIMING_PASSES);
+    FlushConsole();
+  }
+  (void)Sink;
+  for ( ; ; )
+  {
+    ;
   }
 }
 
@@ -13,6 +13,11 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 23:55 ty      the tick ISR calls ES_TICK_HOOK
+ 10/14/26 23:20 ty      the tick ISR keeps ES_Time's 64 bit time up to date
+ 10/14/26 21:30 ty      the tick ISR reports to ES_IsrStats
+ 10/14/26 15:05 ty      don't idle while the binary log has records to send
+ 10/14/26 12:30 ty      added the tickless idle mode (ES_TICKLESS_IDLE)
  08/06/21 15:43 jec     no changes just a test of using GIT from within MPLABX
  08/06/21 13:04 jec     cleaned things up in preparation for the 2021 AY
  10/05/20 18:52 ram     started work on port to PIC32MX170F256B
@@ -70,11 +75,15 @@
 #include <stdint.h>         // for exact size data types
 #include <stdbool.h>        // for the bool data type
 
+#include "ES_Configure.h"   // for ES_TICK_HOOK
 #include "ES_Port.h"        // the header file for this module
 #include "ES_Types.h"       // framework type definitions
 #include "ES_Timers.h"      // framework timer prototypes
 
 #include "terminal.h"       // terminal prototypes for init function
+#include "binlog.h"         // to hold off idle until the log is drained
+#include "ES_Time.h"         // 64 bit time, updated every tick
+#include "ES_IsrStats.h"     // ISR latency & duration
 
 // TickCount is used to track the number of timer ints that have occurred
 // since the last check. It should really never be more than 1, but just to
@@ -94,6 +103,16 @@ static volatile uint16_t SysTickCounter = 0;
 // ensure the interrupts occur periodically
 static volatile TimerRate_t tickPeriod; 
 
+#ifdef ES_TICKLESS_IDLE
+#if ES_TICKLESS_MAX_IDLE_TICKS > 200
+#error ES_TICKLESS_MAX_IDLE_TICKS must fit in TickCount
+#endif
+// statistics on the tickless idle, in core timer counts
+static uint32_t TotalIdleCounts;
+static uint32_t NumIdles;
+static uint32_t MaxWakeLatency;
+#endif
+
 // This variable is used to store the state of the interrupt mask when
 // doing EnterCritical/ExitCritical pairs
 // uint8_t _INTCON_temp;
@@ -154,6 +173,7 @@ void _HW_Timer_Init(const TimerRate_t Rate)
     _CP0_SET_DEBUG(_CP0_GET_DEBUG() | _CP0_DEBUG_COUNTDM_MASK);
     // copy over rate value to module var
     tickPeriod = Rate;
+    ES_Time_Update();
         
     // get the current sys clock time
     uint32_t currTime = _CP0_GET_COUNT();
@@ -205,6 +225,7 @@ void __ISR(_CORE_TIMER_VECTOR, IPL3AUTO ) _HW_SysTickIntHandler(void)
   static uint32_t deltaTime; // static for speed
   static uint8_t intsThatShouldHaveHappened;
   
+  ES_IsrStats_Enter(ES_ISR(SysTick), _CP0_GET_COUNT() - _CP0_GET_COMPARE());
   // clear interrupt flag using the atomic write to the CLR version of the
   // interrupt flag register
   IFS0CLR = _IFS0_CTIF_MASK;
@@ -257,11 +278,17 @@ void __ISR(_CORE_TIMER_VECTOR, IPL3AUTO ) _HW_SysTickIntHandler(void)
   // and keep our tick counters going
   TickCount += intsThatShouldHaveHappened;
   SysTickCounter += intsThatShouldHaveHappened;
+  ES_Time_Update();
+#ifdef ES_TICK_HOOK
+  // once, whatever the number of ticks that were missed
+  ES_TICK_HOOK();
+#endif
 
 #ifdef LED_DEBUG
   // Toggle debug line
   LATBbits.LATB15 = ~LATBbits.LATB15;
 #endif
+  ES_IsrStats_Exit(ES_ISR(SysTick));
 }
 
 /****************************************************************************
@@ -284,6 +311,147 @@ uint16_t _HW_GetTickCount(void)
   return SysTickCounter;
 }
 
+#ifdef ES_TICKLESS_IDLE
+/****************************************************************************
+ Function
+     _HW_IdleUntilNextEvent
+ Parameters
+     none
+ Returns
+     None.
+ Description
+     Called from ES_Run when there are no events to process. Moves the core
+     timer compare out to the tick on which the next framework timer will
+     expire (or ES_TICKLESS_MAX_IDLE_TICKS, whichever comes first) and idles
+     the CPU until something interrupts. On the way out, TickCount &
+     SysTickCounter are credited with the ticks that went by and the compare
+     is put back on the first tick boundary that has not yet been counted.
+ Notes
+     Interrupts are disabled across the wait. On the PIC32 an interrupt
+     request still ends the wait with interrupts off, it just doesn't vector
+     until they are re-enabled. That closes the window where an interrupt
+     arrives after we decide to idle but before the wait executes, and it
+     means the core timer ISR never sees the stretched compare value.
+     The CPU Idle mode (OSCCON.SLPEN = 0, the reset default) keeps the
+     peripheral clocks running, so the UART, PWM & input capture go on.
+ Author
+     Tianyu, 10/14/26 12:30
+****************************************************************************/
+void _HW_IdleUntilNextEvent(void)
+{
+  uint32_t IdleTicks;
+  uint32_t NextTick;
+  uint32_t WakeDeadline;
+  uint32_t IdleStart;
+  uint32_t Now;
+  uint32_t TicksElapsed;
+
+  // don't starve the UART, ES_Run will be back here once it has drained
+  if (!Terminal_IsXmitBufferEmpty())
+  {
+    return;
+  }
+#ifdef BINLOG_ENABLED
+  if (!BinLog_IsEmpty())
+  {
+    return;
+  }
+#endif
+  IdleTicks = ES_Timer_GetTicksToNextExpiry();
+  if ((IdleTicks == 0) || (IdleTicks > ES_TICKLESS_MAX_IDLE_TICKS))
+  {
+    IdleTicks = ES_TICKLESS_MAX_IDLE_TICKS;
+  }
+
+  EnterCritical();
+  if (TickCount != 0) // a tick came in, let ES_Run process it first
+  {
+    ExitCritical();
+    return;
+  }
+  // the compare always holds the next tick boundary, the timer expires on
+  // the IdleTicks'th boundary from here
+  NextTick      = _CP0_GET_COMPARE();
+  WakeDeadline  = NextTick + ((IdleTicks - 1) * tickPeriod);
+  _CP0_SET_COMPARE(WakeDeadline);
+  IdleStart = _CP0_GET_COUNT();
+
+  _wait();
+
+  Now = _CP0_GET_COUNT();
+  // count the tick boundaries that went by while we were idle
+  if ((int32_t)(Now - NextTick) >= 0)
+  {
+    TicksElapsed = ((Now - NextTick) / tickPeriod) + 1;
+  }
+  else
+  {
+    TicksElapsed = 0;
+  }
+  NextTick += TicksElapsed * tickPeriod;
+  // same 12 cycle margin as in the tick ISR, if the next boundary is too
+  // close to program safely, count it now and program the one after
+  if ((NextTick - Now) < 12)
+  {
+    NextTick += tickPeriod;
+    TicksElapsed++;
+  }
+  _CP0_SET_COMPARE(NextTick);
+  // we accounted for any core timer match that woke us, so don't let the
+  // ISR count it a second time
+  IFS0CLR = _IFS0_CTIF_MASK;
+  TickCount       += TicksElapsed;
+  SysTickCounter  += TicksElapsed;
+
+  TotalIdleCounts += Now - IdleStart;
+  NumIdles++;
+  // if it was the deadline that woke us, note how long it took to get here
+  if (((int32_t)(Now - WakeDeadline) >= 0) &&
+      ((Now - WakeDeadline) < tickPeriod) &&
+      ((Now - WakeDeadline) > MaxWakeLatency))
+  {
+    MaxWakeLatency = Now - WakeDeadline;
+  }
+  ExitCritical();
+}
+
+/****************************************************************************
+ Function
+     _HW_GetIdleStats
+ Parameters
+     uint32_t *pIdleCounts : total core timer counts spent idle
+     uint32_t *pNumIdles : number of times we went idle
+     uint32_t *pMaxWakeLatency : longest time, in core timer counts, from a
+                                 timer deadline to getting back to work
+ Returns
+     None.
+ Description
+     reports how the tickless idle is doing. The idle fraction is the
+     first number over the elapsed time, which is what to compare against
+     the supply current measured on the bench.
+ Notes
+     any of the pointers may be NULL
+ Author
+     Tianyu, 10/14/26 12:30
+****************************************************************************/
+void _HW_GetIdleStats(uint32_t *pIdleCounts, uint32_t *pNumIdles,
+    uint32_t *pMaxWakeLatency)
+{
+  if (pIdleCounts != NULL)
+  {
+    *pIdleCounts = TotalIdleCounts;
+  }
+  if (pNumIdles != NULL)
+  {
+    *pNumIdles = NumIdles;
+  }
+  if (pMaxWakeLatency != NULL)
+  {
+    *pMaxWakeLatency = MaxWakeLatency;
+  }
+}
+#endif /* ES_TICKLESS_IDLE */
+
 /****************************************************************************
  Function
      _HW_Process_Pending_Ints
@@ -0,0 +1,405 @@
+/****************************************************************************
+ Module
+   ES_Port_Host.c
+
+ Revision
+   1.0.1
+
+ Description
+   Host port of the Events & Services Framework, in place of ES_Port.c &
+   terminal.c when the application is built with ES_HOST_SIM to run on a
+   PC (make bench). The peripherals are simulated by HostSim/HostSim.c &
+   driven from a trace, the console is stdin/stdout.
+
+ Notes
+   The host build always uses the tickless idle: ES_Run calls
+   _HW_IdleUntilNextEvent when it has nothing to do, and that is where
+   the simulated time moves on, to the next tick or the next thing in the
+   trace, whichever comes first. The time ES_Run spends between idles is
+   measured with the host's clock, as is everything _HW_GetCycleCount
+   times, so the dispatch stats come out in host time.
+
+   Once the trace is done it prints the throughput, the ISR costs, the
+   queue high water marks & the dispatch profile and exits.
+
+   The trace comes from HOSTSIM_TRACE in the environment, stdin if that
+   isn't set.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 23:55 ty      ES_TICK_HOOK is called for each tick
+ 10/14/26 23:20 ty      each idle updates ES_Time, as the tick ISR does
+ 10/14/26 22:10 ty      the baud rate functions, there is no rate to set
+ 10/14/26 22:00 ty      the receive notify is called when the trace has
+                        brought keys in (USE_UART_RX_ISR)
+ 10/14/26 21:00 ty      first pass, from ES_Port.c
+ ***************************************************************************/
+#include <xc.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ES_Configure.h"
+#include "ES_Port.h"
+#include "ES_Types.h"
+#include "ES_Timers.h"
+#include "ES_Framework.h"
+#include "ES_Profiler.h"
+#include "ES_Time.h"
+
+#include "terminal.h"
+#include "binlog.h"
+#include "HostSim.h"
+
+// the C library's printf for the report, DB_printf has no 64 bit or
+// floating point formats
+#undef printf
+
+static uint8_t  TickCount;
+static uint16_t SysTickCounter = 0;
+static uint32_t tickPeriod;
+static uint64_t NextTick;
+
+// statistics on the idle, in simulated counts
+static uint32_t TotalIdleCounts;
+static uint32_t NumIdles;
+
+// host time spent outside of the idle, in nS
+static uint64_t BusyNs;
+static uint64_t LastWake;
+
+#ifdef USE_UART_RX_ISR
+static Terminal_RxNotify_t pRxNotify;
+#endif
+
+// only remembered, for Terminal_GetBaud
+static uint32_t TerminalBaud = TERMINAL_DEFAULT_BAUD;
+
+static void ReportAndExit(void);
+
+/****************************************************************************
+ Function
+    _HW_PIC32Init
+ Parameters
+    none
+ Returns
+     None.
+ Description
+    Loads the trace & starts the simulated time
+ Author
+     Tianyu, 10/14/26 21:00
+****************************************************************************/
+void _HW_PIC32Init(void)
+{
+  if (!HostSim_Init(getenv("HOSTSIM_TRACE")))
+  {
+    exit(2);
+  }
+  LastWake = HostSim_HostNanoseconds();
+}
+
+/****************************************************************************
+ Function
+     _HW_Timer_Init
+ Parameters
+     unsigned char Rate set to one of the TMR_RATE_XX values to set the
+     tick rate
+ Returns
+     None.
+ Description
+     sets the tick period, in simulated core timer counts
+ Author
+     Tianyu, 10/14/26 21:00
+****************************************************************************/
+void _HW_Timer_Init(const TimerRate_t Rate)
+{
+  tickPeriod = Rate;
+  NextTick = HostSim_Now() + Rate;
+}
+
+/****************************************************************************
+ Function
+    _HW_GetTickCount()
+ Parameters
+    none
+ Returns
+    uint16_t   count of number of system ticks that have occurred.
+ Author
+     Tianyu, 10/14/26 21:00
+****************************************************************************/
+uint16_t _HW_GetTickCount(void)
+{
+  return SysTickCounter;
+}
+
+/****************************************************************************
+ Function
+     _HW_GetHostCycleCount
+ Parameters
+     none
+ Returns
+     uint32_t, the host's clock in 20MHz counts, for _HW_GetCycleCount
+ Author
+     Tianyu, 10/14/26 21:00
+****************************************************************************/
+uint32_t _HW_GetHostCycleCount(void)
+{
+  return (uint32_t)(HostSim_HostNanoseconds() * _HW_CYCLES_PER_US / 1000u);
+}
+
+/****************************************************************************
+ Function
+     _HW_IdleUntilNextEvent
+ Parameters
+     none
+ Returns
+     None.
+ Description
+     Called from ES_Run when there are no events to process. Runs the
+     simulation up to the next tick, or to the first stimulus or timer
+     interrupt before it, and credits the ticks that went by
+ Notes
+     Exits through ReportAndExit once the trace is done
+ Author
+     Tianyu, 10/14/26 21:00
+****************************************************************************/
+void _HW_IdleUntilNextEvent(void)
+{
+  uint64_t IdleStart;
+
+#ifdef BINLOG_ENABLED
+  if (!BinLog_IsEmpty())
+  {
+    return;
+  }
+#endif
+  if (TickCount != 0) // a tick is waiting, let ES_Run process it first
+  {
+    return;
+  }
+  BusyNs += HostSim_HostNanoseconds() - LastWake;
+  if (HostSim_IsTraceDone())
+  {
+    ReportAndExit();
+  }
+  IdleStart = HostSim_Now();
+
+  (void)HostSim_RunUntil((tickPeriod != 0) ? NextTick : UINT64_MAX);
+
+  while ((tickPeriod != 0) && (HostSim_Now() >= NextTick))
+  {
+    NextTick += tickPeriod;
+    TickCount++;
+    SysTickCounter++;
+#ifdef ES_TICK_HOOK
+    ES_TICK_HOOK();
+#endif
+  }
+  ES_Time_Update();
+  TotalIdleCounts += (uint32_t)(HostSim_Now() - IdleStart);
+  NumIdles++;
+#ifdef USE_UART_RX_ISR
+  // stands in for Terminal_RxISR, the keys stay in HostSim's FIFO
+  if (HostSim_IsKeyReady() && (pRxNotify != NULL))
+  {
+    pRxNotify();
+  }
+#endif
+  LastWake = HostSim_HostNanoseconds();
+}
+
+/****************************************************************************
+ Function
+     _HW_GetIdleStats
+ Parameters
+     uint32_t *pIdleCounts : total simulated counts spent idle
+     uint32_t *pNumIdles : number of times we went idle
+     uint32_t *pMaxWakeLatency : always 0, the simulation wakes on time
+ Returns
+     None.
+ Notes
+     any of the pointers may be NULL
+ Author
+     Tianyu, 10/14/26 21:00
+****************************************************************************/
+void _HW_GetIdleStats(uint32_t *pIdleCounts, uint32_t *pNumIdles,
+    uint32_t *pMaxWakeLatency)
+{
+  if (pIdleCounts != NULL)
+  {
+    *pIdleCounts = TotalIdleCounts;
+  }
+  if (pNumIdles != NULL)
+  {
+    *pNumIdles = NumIdles;
+  }
+  if (pMaxWakeLatency != NULL)
+  {
+    *pMaxWakeLatency = 0;
+  }
+}
+
+/****************************************************************************
+ Function
+     _HW_Process_Pending_Ints
+ Parameters
+     none
+ Returns
+     always true.
+ Description
+     runs the framework timers for the ticks credited by the idle
+ Author
+     Tianyu, 10/14/26 21:00
+****************************************************************************/
+bool _HW_Process_Pending_Ints(void)
+{
+  while (TickCount > 0)
+  {
+    ES_Timer_Tick_Resp();
+    TickCount--;
+  }
+  return true;  // always return true to allow loop test in ES_Run to proceed
+}
+
+/****************************************************************************
+ Function
+     _HW_ConsoleInit
+ Parameters
+     none
+ Returns
+     none.
+ Author
+     Tianyu, 10/14/26 21:00
+ ****************************************************************************/
+void _HW_ConsoleInit(void)
+{
+  Terminal_HWInit();
+}
+
+/****************************************************************************
+ The terminal.c functions, on stdout. Bytes come in from the trace
+ ****************************************************************************/
+void Terminal_HWInit(void)
+{
+  setvbuf(stdout, NULL, _IOFBF, BUFSIZ);
+}
+
+uint8_t Terminal_ReadByte(void)
+{
+  return HostSim_ReadKey();
+}
+
+void Terminal_WriteByte(uint8_t txByte)
+{
+  putchar(txByte);
+}
+
+bool Terminal_IsRxData(void)
+{
+  return HostSim_IsKeyReady();
+}
+
+void Terminal_MoveBuffer2UART(void)
+{
+}
+
+bool Terminal_IsXmitBufferEmpty(void)
+{
+  return true;
+}
+
+uint32_t Terminal_GetXmitOverflowCount(void)
+{
+  return 0;
+}
+
+size_t Terminal_GetXmitSpace(void)
+{
+  return BUFSIZ;
+}
+
+size_t Terminal_ReadBytes(uint8_t *pDest, size_t maxBytes)
+{
+  size_t NumRead = 0;
+
+  while ((NumRead < maxBytes) && HostSim_IsKeyReady())
+  {
+    pDest[NumRead++] = HostSim_ReadKey();
+  }
+  return NumRead;
+}
+
+uint32_t Terminal_GetRecvOverrunCount(void)
+{
+  return 0;
+}
+
+bool Terminal_IsBaudSupported(uint32_t baud)
+{
+  return baud != 0;
+}
+
+bool Terminal_SetBaud(uint32_t baud)
+{
+  if (!Terminal_IsBaudSupported(baud))
+  {
+    return false;
+  }
+  TerminalBaud = baud;
+  return true;
+}
+
+uint32_t Terminal_GetBaud(void)
+{
+  return TerminalBaud;
+}
+
+void Terminal_StartAutoBaud(void)
+{
+}
+
+bool Terminal_IsAutoBaudDone(void)
+{
+  return true;
+}
+
+#ifdef USE_UART_RX_ISR
+void Terminal_SetRxNotify(Terminal_RxNotify_t pNotify)
+{
+  pRxNotify = pNotify;
+}
+#endif
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+static void ReportAndExit(void)
+{
+  uint64_t SimUs = HostSim_Now() / HOST_COUNTS_PER_US;
+
+  printf("\r\n---- HostSim bench ----\r\n");
+  HostSim_Report();
+  printf("ES_Run busy %llu uS on the host, idle %u times\r\n",
+      (unsigned long long)(BusyNs / 1000u), NumIdles);
+#ifdef ES_PROFILE_DISPATCH
+  {
+    uint32_t Dispatches = ES_Profile_GetDispatchCount();
+
+    printf("%u dispatches, %.0f per simulated S, %.0f per busy host S\r\n",
+        Dispatches, (SimUs != 0) ? Dispatches * 1e6 / SimUs : 0.0,
+        (BusyNs != 0) ? Dispatches * 1e9 / BusyNs : 0.0);
+  }
+  ES_Profile_Report();
+#else
+  (void)SimUs;
+#endif
+  ES_ReportQueueStats();
+#ifdef ES_RUN_BUDGET
+  ES_ReportRunStats();
+#endif
+  fflush(stdout);
+  exit(0);
+}
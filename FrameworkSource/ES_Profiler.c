@@ -0,0 +1,388 @@
+/****************************************************************************
+ Module
+   ES_Profiler.c
+
+ Revision
+   1.0.1
+
+ Description
+   On-chip profiler for the service dispatch in ES_Run. For each service &
+   event type it keeps the number of dispatches, the min/max/mean number of
+   core timer counts spent in the run function and the min/max/mean time
+   the event waited in the queue between being posted and being dispatched.
+
+ Notes
+   All times are in core timer counts (20 per uS, see _HW_GetCycleCount).
+   The run time includes any time spent in ISRs that interrupt the run
+   function, so a large max with a small mean usually means an interrupt
+   landed in the middle of it.
+
+   The post times are kept in a small ring per service that mirrors the
+   order of the service's queue: FIFO posts go on the end & LIFO posts on
+   the front. The time stamp is taken just after the event goes into the
+   queue, so if an ISR posts to the same service in the few instructions
+   between the enqueue & the time stamp, the two stamps trade places. Since
+   they are only a few counts apart, this doesn't disturb the stats.
+
+   Events found in the queue with no matching time stamp (the stamp ring
+   was full when they were posted) are counted, but don't update the wait
+   time stats.
+
+   To keep a cell to 20 bytes the times are kept in 16 bit units of
+   PROFILE_TIME_UNIT core timer counts (0.8uS), good to ~52mS, & a longer
+   one counts as the most that fits. A cell stops at PROFILE_COUNT_MAX
+   dispatches, which keeps its 32 bit sums from wrapping, so its mean is of
+   the first 65535. The total dispatch count is kept apart, in 32 bits.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 23:59 ty      16 bit counts & times, a cell is 20 bytes, not 40
+ 10/14/26 21:10 ty      added ES_Profile_NoteFlush
+ 10/14/26 21:00 ty      added ES_Profile_GetDispatchCount
+ 10/14/26 16:10 ty      first pass
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Port.h"
+#include "ES_Profiler.h"
+#include "dbprintf.h"
+
+#ifdef ES_PROFILE_DISPATCH
+
+/*----------------------------- Module Defines ----------------------------*/
+#if (ES_PROFILE_STAMP_DEPTH & (ES_PROFILE_STAMP_DEPTH - 1)) != 0
+#error "ES_PROFILE_STAMP_DEPTH must be a power of 2"
+#endif
+
+#define STAMP_MASK (ES_PROFILE_STAMP_DEPTH - 1)
+
+// the cells keep times in units of 2^PROFILE_TIME_SHIFT core timer counts
+#define PROFILE_TIME_SHIFT 4
+#define PROFILE_TIME_UNIT (1u << PROFILE_TIME_SHIFT)
+#define PROFILE_TIME_MAX 0xFFFFu
+#define PROFILE_COUNT_MAX 0xFFFFu
+
+typedef struct
+{
+  uint16_t  Count;
+  uint16_t  MinRun;
+  uint16_t  MaxRun;
+  uint16_t  WaitCount;  // dispatches that had a post time stamp
+  uint16_t  MinWait;
+  uint16_t  MaxWait;
+  uint32_t  SumRun;
+  uint32_t  SumWait;
+}ProfileCell_t;
+
+typedef struct
+{
+  uint32_t  Stamp[ES_PROFILE_STAMP_DEPTH];
+  uint8_t   Head;   // oldest stamp, the next to be dispatched
+  uint8_t   Count;  // number of valid stamps
+}StampRing_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void ResetCell(ProfileCell_t *pCell);
+static uint16_t ToUnits(uint32_t Cycles);
+static uint32_t Mean(uint32_t Sum, uint16_t Count);
+
+/*---------------------------- Module Variables ---------------------------*/
+static ProfileCell_t  ProfileTable[NUM_SERVICES][ES_NUM_EVENT_TYPES];
+static StampRing_t    PostStamps[NUM_SERVICES];
+// dispatches of event types outside of the ES_EventType_t enum
+static uint32_t       UnknownEventCount;
+// every dispatch, the cells' counts stop at PROFILE_COUNT_MAX
+static uint32_t       DispatchCount;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_Profile_NotePost
+
+ Parameters
+   uint8_t : which service the event was just posted to
+   bool : true for a LIFO post, false for FIFO
+
+ Returns
+   nothing
+
+ Description
+   records the time an event went into a service's queue
+ Notes
+   called by ES_PostToService & ES_PostToServiceLIFO after a good post,
+   which may be from an ISR
+ Author
+   Tianyu, 10/14/26 16:10
+****************************************************************************/
+void ES_Profile_NotePost(uint8_t WhichService, bool AtFront)
+{
+  StampRing_t *pRing = &PostStamps[WhichService];
+  uint32_t    Now = _HW_GetCycleCount();
+
+  EnterCritical();
+  if (pRing->Count < ES_PROFILE_STAMP_DEPTH)
+  {
+    if (AtFront)
+    {
+      pRing->Head = (pRing->Head - 1) & STAMP_MASK;
+      pRing->Stamp[pRing->Head] = Now;
+    }
+    else
+    {
+      pRing->Stamp[(pRing->Head + pRing->Count) & STAMP_MASK] = Now;
+    }
+    pRing->Count++;
+  }
+  ExitCritical();
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_NoteFlush
+
+ Parameters
+   uint8_t : the service whose queue was just emptied
+
+ Returns
+   nothing
+
+ Description
+   drops the post time stamps of events that will never be dispatched
+ Notes
+   called by ES_FlushServiceQueue
+ Author
+   Tianyu, 10/14/26 21:10
+****************************************************************************/
+void ES_Profile_NoteFlush(uint8_t WhichService)
+{
+  EnterCritical();
+  PostStamps[WhichService].Count = 0;
+  ExitCritical();
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_Record
+
+ Parameters
+   uint8_t : the service that was run
+   ES_EventType_t : the type of the event that it was run with
+   uint32_t : the cycle count when the event was taken from the queue
+   uint32_t : the number of cycles the run function took
+
+ Returns
+   nothing
+
+ Description
+   updates the stats for one dispatch
+ Notes
+   only called from ES_Run
+ Author
+   Tianyu, 10/14/26 16:10
+****************************************************************************/
+void ES_Profile_Record(uint8_t WhichService, ES_EventType_t WhichEvent,
+    uint32_t DispatchStart, uint32_t RunCycles)
+{
+  StampRing_t   *pRing = &PostStamps[WhichService];
+  ProfileCell_t *pCell;
+  uint32_t      PostTime = 0;
+  bool          HaveStamp = false;
+  uint16_t      Run;
+
+  // the oldest stamp belongs to the event that was just dispatched
+  EnterCritical();
+  if (pRing->Count > 0)
+  {
+    PostTime = pRing->Stamp[pRing->Head];
+    pRing->Head = (pRing->Head + 1) & STAMP_MASK;
+    pRing->Count--;
+    HaveStamp = true;
+  }
+  ExitCritical();
+
+  DispatchCount++;
+  if ((unsigned)WhichEvent >= ES_NUM_EVENT_TYPES)
+  {
+    UnknownEventCount++;
+    return;
+  }
+  pCell = &ProfileTable[WhichService][WhichEvent];
+  // full, the sums could wrap from here on
+  if (pCell->Count == PROFILE_COUNT_MAX)
+  {
+    return;
+  }
+
+  Run = ToUnits(RunCycles);
+  if ((pCell->Count == 0) || (Run < pCell->MinRun))
+  {
+    pCell->MinRun = Run;
+  }
+  pCell->Count++;
+  if (Run > pCell->MaxRun)
+  {
+    pCell->MaxRun = Run;
+  }
+  pCell->SumRun += Run;
+
+  if (HaveStamp)
+  {
+    // unsigned math handles wrap
+    uint16_t Wait = ToUnits(DispatchStart - PostTime);
+
+    if ((pCell->WaitCount == 0) || (Wait < pCell->MinWait))
+    {
+      pCell->MinWait = Wait;
+    }
+    pCell->WaitCount++;
+    if (Wait > pCell->MaxWait)
+    {
+      pCell->MaxWait = Wait;
+    }
+    pCell->SumWait += Wait;
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_Report
+
+ Parameters
+   nothing
+
+ Returns
+   nothing
+
+ Description
+   prints a line of stats for each service/event pair that has been run
+ Notes
+   this is a lot of output, it relies on the terminal waiting for room in
+   the transmit buffer (TERMINAL_TX_BACKPRESSURE) so nothing gets lost
+ Author
+   Tianyu, 10/14/26 16:10
+****************************************************************************/
+void ES_Profile_Report(void)
+{
+  uint8_t Service;
+  uint8_t Event;
+
+  DB_printf("\r\nDispatch profile (core timer counts, 20/uS, in steps of 16)\r\n");
+  DB_printf("Svc Evt      Count   RunMin   RunMax  RunMean"
+      "  WaitMin  WaitMax WaitMean\r\n");
+  for (Service = 0; Service < NUM_SERVICES; Service++)
+  {
+    for (Event = 0; Event < ES_NUM_EVENT_TYPES; Event++)
+    {
+      ProfileCell_t *pCell = &ProfileTable[Service][Event];
+
+      if (pCell->Count == 0)
+      {
+        continue;
+      }
+      DB_printf("%d   %d   %u %u %u %u", Service, Event, pCell->Count,
+          (uint32_t)pCell->MinRun << PROFILE_TIME_SHIFT,
+          (uint32_t)pCell->MaxRun << PROFILE_TIME_SHIFT,
+          Mean(pCell->SumRun, pCell->Count));
+      if (pCell->WaitCount != 0)
+      {
+        DB_printf(" %u %u %u\r\n",
+            (uint32_t)pCell->MinWait << PROFILE_TIME_SHIFT,
+            (uint32_t)pCell->MaxWait << PROFILE_TIME_SHIFT,
+            Mean(pCell->SumWait, pCell->WaitCount));
+      }
+      else
+      {
+        DB_printf(" - - -\r\n");
+      }
+    }
+  }
+  if (UnknownEventCount != 0)
+  {
+    DB_printf("%u dispatches of unknown event types\r\n", UnknownEventCount);
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_Reset
+
+ Parameters
+   nothing
+
+ Returns
+   nothing
+
+ Description
+   clears the stats so that a new measurement can be started
+ Notes
+   leaves the post time stamps alone since they match what is in the queues
+ Author
+   Tianyu, 10/14/26 16:10
+****************************************************************************/
+void ES_Profile_Reset(void)
+{
+  uint8_t Service;
+  uint8_t Event;
+
+  for (Service = 0; Service < NUM_SERVICES; Service++)
+  {
+    for (Event = 0; Event < ES_NUM_EVENT_TYPES; Event++)
+    {
+      ResetCell(&ProfileTable[Service][Event]);
+    }
+  }
+  UnknownEventCount = 0;
+  DispatchCount = 0;
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_GetDispatchCount
+
+ Parameters
+   nothing
+
+ Returns
+   uint32_t, the number of dispatches recorded since the last reset
+
+ Description
+   the total over every service & event type, for throughput measurements
+ Author
+   Tianyu, 10/14/26 21:00
+****************************************************************************/
+uint32_t ES_Profile_GetDispatchCount(void)
+{
+  return DispatchCount;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+static void ResetCell(ProfileCell_t *pCell)
+{
+  pCell->Count = 0;
+  pCell->MinRun = 0;
+  pCell->MaxRun = 0;
+  pCell->SumRun = 0;
+  pCell->WaitCount = 0;
+  pCell->MinWait = 0;
+  pCell->MaxWait = 0;
+  pCell->SumWait = 0;
+}
+
+// a time in the cells' units, the most they hold if it is longer
+static uint16_t ToUnits(uint32_t Cycles)
+{
+  Cycles >>= PROFILE_TIME_SHIFT;
+  return (Cycles < PROFILE_TIME_MAX) ? (uint16_t)Cycles :
+      (uint16_t)PROFILE_TIME_MAX;
+}
+
+// in core timer counts
+static uint32_t Mean(uint32_t Sum, uint16_t Count)
+{
+  return (Sum / Count) << PROFILE_TIME_SHIFT;
+}
+
+#endif /* ES_PROFILE_DISPATCH */
@@ -3,12 +3,39 @@
  Module
      ES_Queue.c
  Description
-     Implements a FIFO circular buffer of EF_Event in a block of memory
+     Implements a FIFO circular buffer of packed events, described by an
+     ES_Queue_t
  Notes
+     Two kinds of queue share the same layout, an array of ES_PackedEvent_t
+     entries & an ES_QueueState_t, both found through the descriptor. The
+     original kind protects every insertion and removal with a critical
+     region. The SPSC kind is lock-free: it has a power of 2 size and
+     separate head/tail indices so that a single producer (typically one
+     ISR) can post into it while the single consumer (ES_Run) is pulling
+     events out, without either one masking interrupts. The kind is in the
+     descriptor so the public functions can dispatch on it.
+     Both kinds also keep a high water mark, a count of the posts that found
+     the queue full and the type of the last event that was dropped, in the
+     state (see ES_GetQueueStats).
+     Events are packed on the way in & unpacked on the way out, so only
+     this module sees ES_PackedEvent_t.
 
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 23:59 ty       InCritical versions of the LIFO, front block &
+                         coalescing adds, so a post can set its Ready bit
+                         in the same critical region
+ 10/14/26 23:59 ty       the queue is an ES_Queue_t descriptor with the state
+                         apart from the entries, which are ES_PackedEvent_t
+ 10/14/26 22:50 ty       added ES_EnQueueFrontBlock for the batched recall
+ 10/14/26 19:30 ty       added ES_EnQueueFIFOInCritical for publishing to
+                         several queues in one critical region
+ 10/14/26 19:10 ty       added ES_EnQueueCoalesce
+ 10/14/26 18:50 ty       clear EventData in the empty queue event
+ 10/14/26 16:50 ty       added high water / drop statistics to the header
+ 10/14/26 10:05 ty       added the lock-free single producer/single consumer
+                         queue kind & ES_InitQueueKind
  01/15/12 09:34 jec      converted to use the new C99 types from types.h
  08/09/11 18:16 jec      started coding
 *****************************************************************************/
@@ -18,20 +45,28 @@
 #include "../FrameworkHeaders/ES_Port.h" /* get the macros for EnterCritical and ExitCritical */
 
 /*----------------------------- Module Defines ----------------------------*/
-// QueueSize is max number of entries in the queue
-// CurrentIndex is the 'read-from' index,
-// actually CurrentIndex + sizeof(EF_Queue_t)
-// entries are made to CurrentIndex + NumEntries + sizeof(ES_Queue_t)
-typedef struct
-{
-  uint8_t QueueSize;
-  uint8_t CurrentIndex;
-  uint8_t NumEntries;
-}ES_Queue_t;
+// the ends of each kind of queue, in its state
+#define CRIT(pQueue) ((pQueue)->pState->Ends.Critical)
+#define SPSC(pQueue) ((pQueue)->pState->Ends.SPSC)
+
+#define MAX_SPSC_QUEUE_SIZE 128
 
-typedef ES_Queue_t *pQueue_t;
+// the point of packing, a queue entry has to be smaller than an event
+typedef char PackedEventIsSmaller[(sizeof(ES_PackedEvent_t) <
+    sizeof(ES_Event_t)) ? 1 : -1];
+
+// keeps the compiler from moving the entry copy across the index update
+// the M4K core does not re-order stores, so a compiler barrier is enough
+#define QUEUE_BARRIER() __asm__ volatile ("" ::: "memory")
 
 /*---------------------------- Module Functions ---------------------------*/
+static bool EnQueueSPSC(const ES_Queue_t *pQueue, ES_Event_t Event2Add);
+static bool EnQueueSPSCLIFO(const ES_Queue_t *pQueue, ES_Event_t Event2Add);
+static uint8_t DeQueueSPSC(const ES_Queue_t *pQueue, ES_Event_t *pReturnEvent);
+static uint8_t NumWaiting(const ES_Queue_t *pQueue);
+static void ClearStats(ES_QueueState_t *pState);
+static void NoteDepth(ES_QueueState_t *pState, uint8_t Depth);
+static void NoteDrop(ES_QueueState_t *pState, ES_EventType_t DroppedType);
 
 /*---------------------------- Module Variables ---------------------------*/
 
@@ -40,75 +75,111 @@ typedef ES_Queue_t *pQueue_t;
  Function
    ES_InitQueue
  Parameters
-   EF_Event * pBlock : pointer to the block of memory to use for the Queue
-   unsigned char BlockSize: size of the block pointed to by pBlock
+   const ES_Queue_t * pQueue : the queue to set up
  Returns
-   max number of entries in the created queue
+   max number of entries in the created queue, 0 if its entries can not be
+   used for its kind of queue
  Description
-   Initializes a queue structure at the beginning of the block of memory
+   Empties the queue & clears its statistics
  Notes
-   you should pass it a block that is at least sizeof(ES_Queue_t) larger than
-   the number of entries that you want in the queue. Since the size of an
-   ES_Event (at 4 bytes; 2 enum, 2 param) is greater than the
-   sizeof(ES_Queue_t), you only need to declare an array of ES_Event
-   with 1 more element than you need for the actual queue.
+   for the SPSC kind, QueueSize must be a power of 2 <= 128. Every entry
+   of pEntries is used, there is no header in it
  Author
    J. Edward Carryer, 08/09/11, 18:40
 ****************************************************************************/
-uint8_t ES_InitQueue(ES_Event_t *pBlock, uint8_t BlockSize)
+uint8_t ES_InitQueue(const ES_Queue_t *pQueue)
 {
-  pQueue_t pThisQueue;
-  // initialize the Queue by setting up initial values for elements
-  pThisQueue = (pQueue_t)pBlock;
-  // use all but the structure overhead as the Queue
-  pThisQueue->QueueSize     = BlockSize - 1;
-  pThisQueue->CurrentIndex  = 0;
-  pThisQueue->NumEntries    = 0;
-  return pThisQueue->QueueSize;
+  uint8_t QueueSize = pQueue->QueueSize;
+
+  if (ES_QUEUE_KIND_SPSC == pQueue->QueueKind)
+  {
+    if ((QueueSize == 0) || (QueueSize > MAX_SPSC_QUEUE_SIZE) ||
+        ((QueueSize & (QueueSize - 1)) != 0))
+    {
+      return 0; // can't build a lock-free queue this size
+    }
+    SPSC(pQueue).Head = 0;
+    SPSC(pQueue).Tail = 0;
+  }
+  else
+  {
+    CRIT(pQueue).CurrentIndex = 0;
+    CRIT(pQueue).NumEntries = 0;
+  }
+  ClearStats(pQueue->pState);
+  return QueueSize;
 }
 
 /****************************************************************************
  Function
    ES_EnQueueFIFO
  Parameters
-   ES_Event * pBlock : pointer to the block of memory in use as the Queue
+   const ES_Queue_t * pQueue : the queue
    ES_Event Event2Add : event to be added to the Queue
  Returns
    bool : true if the add was successful, false if not
  Description
    if it will fit, adds Event2Add to the Queue
  Notes
-
+   dispatches to the lock-free version for SPSC queues
   Author
    J. Edward Carryer, 08/09/11, 18:59
 ****************************************************************************/
-bool ES_EnQueueFIFO(ES_Event_t *pBlock, ES_Event_t Event2Add)
+bool ES_EnQueueFIFO(const ES_Queue_t *pQueue, ES_Event_t Event2Add)
 {
-  pQueue_t pThisQueue;
-  pThisQueue = (pQueue_t)pBlock;
-  // index will go from 0 to QueueSize-1 so use '<' to test if there is space
-  if (pThisQueue->NumEntries < pThisQueue->QueueSize) // save the new event, use % to create circular buffer in block
-  {   
-    EnterCritical();  // save interrupt state, turn ints off
-// 1+ to step past the Queue struct at the beginning of the block
-	pBlock[1 + ((pThisQueue->CurrentIndex + pThisQueue->NumEntries)
-          % pThisQueue->QueueSize)] = Event2Add;
-    pThisQueue->NumEntries++; // inc number of entries
-    ExitCritical();    // restore saved interrupt state
+  bool ReturnVal;
 
-    return true;
+  if (ES_QUEUE_KIND_SPSC == pQueue->QueueKind)
+  {
+    return EnQueueSPSC(pQueue, Event2Add);
   }
-  else
+  EnterCritical();  // save interrupt state, turn ints off
+  ReturnVal = ES_EnQueueFIFOInCritical(pQueue, Event2Add);
+  ExitCritical();    // restore saved interrupt state
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   ES_EnQueueFIFOInCritical
+ Parameters
+   const ES_Queue_t * pQueue : the queue
+   ES_Event Event2Add : event to be added to the Queue
+ Returns
+   bool : true if the add was successful, false if not
+ Description
+   ES_EnQueueFIFO for a caller that already has interrupts off, so that
+   several queues can be posted to in one critical region
+ Notes
+   SPSC queues are still added to lock-free, the caller must be their
+   one producer
+  Author
+   Tianyu, 10/14/26 19:30
+****************************************************************************/
+bool ES_EnQueueFIFOInCritical(const ES_Queue_t *pQueue, ES_Event_t Event2Add)
+{
+  if (ES_QUEUE_KIND_SPSC == pQueue->QueueKind)
   {
-    return false;
+    return EnQueueSPSC(pQueue, Event2Add);
+  }
+  // index will go from 0 to QueueSize-1 so use '<' to test if there is space
+  if (CRIT(pQueue).NumEntries < pQueue->QueueSize) // save the new event, use % to create circular buffer
+  {
+    pQueue->pEntries[(CRIT(pQueue).CurrentIndex + CRIT(pQueue).NumEntries)
+        % pQueue->QueueSize] = ES_PackEvent(Event2Add);
+    CRIT(pQueue).NumEntries++; // inc number of entries
+    NoteDepth(pQueue->pState, CRIT(pQueue).NumEntries);
+    return true;
   }
+  NoteDrop(pQueue->pState, Event2Add.EventType);
+  return false;
 }
 
 /****************************************************************************
  Function
    ES_EnQueueLIFO
  Parameters
-   ES_Event * pBlock : pointer to the block of memory in use as the Queue
+   const ES_Queue_t * pQueue : the queue
    ES_Event Event2Add : event to be added to the Queue
  Returns
    bool : true if the add was successful, false if not
@@ -117,48 +188,243 @@ bool ES_EnQueueFIFO(ES_Event_t *pBlock, ES_Event_t Event2Add)
    it the next event to be removed by a DeQueue operation, that is a
    Last In First Out operation.
  Notes
-
+   for SPSC queues this must only be called from the consumer's context
+   (the main loop), which is where the Defer/Recall functions run
   Author
    J. Edward Carryer, 11/02/13, 14:30
 ****************************************************************************/
-bool ES_EnQueueLIFO(ES_Event_t *pBlock, ES_Event_t Event2Add)
+bool ES_EnQueueLIFO(const ES_Queue_t *pQueue, ES_Event_t Event2Add)
 {
-  pQueue_t pThisQueue;
-  pThisQueue = (pQueue_t)pBlock;
+  bool ReturnVal;
+
+  if (ES_QUEUE_KIND_SPSC == pQueue->QueueKind)
+  {
+    return EnQueueSPSCLIFO(pQueue, Event2Add);
+  }
+  EnterCritical();  // save interrupt state, turn ints off
+  ReturnVal = ES_EnQueueLIFOInCritical(pQueue, Event2Add);
+  ExitCritical();    // restore saved interrupt state
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   ES_EnQueueLIFOInCritical
+ Parameters
+   const ES_Queue_t * pQueue : the queue
+   ES_Event Event2Add : event to be added to the Queue
+ Returns
+   bool : true if the add was successful, false if not
+ Description
+   ES_EnQueueLIFO for a caller that already has interrupts off, so that
+   the post can mark the queue ready in the same critical region
+ Notes
+   the same SPSC restriction as ES_EnQueueLIFO
+  Author
+   Tianyu, 10/14/26 23:59
+****************************************************************************/
+bool ES_EnQueueLIFOInCritical(const ES_Queue_t *pQueue, ES_Event_t Event2Add)
+{
+  if (ES_QUEUE_KIND_SPSC == pQueue->QueueKind)
+  {
+    return EnQueueSPSCLIFO(pQueue, Event2Add);
+  }
   // index will go from 0 to QueueSize-1 so use '<' to test if there is space
-  if (pThisQueue->NumEntries < pThisQueue->QueueSize)
+  if (CRIT(pQueue).NumEntries < pQueue->QueueSize)
   {
-#ifdef POST_FROM_INTS
-    EnterCritical();  // save interrupt state, turn ints off
-#endif
     // OK, there is space note that the queue now has 1 more entry
-    pThisQueue->NumEntries++;
+    CRIT(pQueue).NumEntries++;
     // Check to see if we need to wrap around as we back up index
-    if (pThisQueue->CurrentIndex == 0)
+    if (CRIT(pQueue).CurrentIndex == 0)
     {
-      pThisQueue->CurrentIndex = pThisQueue->QueueSize - 1;
+      CRIT(pQueue).CurrentIndex = pQueue->QueueSize - 1;
     }
     else
     {
-      pThisQueue->CurrentIndex--;
+      CRIT(pQueue).CurrentIndex--;
     }
-    pBlock[1 + pThisQueue->CurrentIndex] = Event2Add;
-#ifdef POST_FROM_INTS
-    ExitCritical();    // restore saved interrupt state
-#endif
+    pQueue->pEntries[CRIT(pQueue).CurrentIndex] = ES_PackEvent(Event2Add);
+    NoteDepth(pQueue->pState, CRIT(pQueue).NumEntries);
     return true;
   }
-  else    // in case no room on the queue
+  NoteDrop(pQueue->pState, Event2Add.EventType);
+  return false;
+}
+
+/****************************************************************************
+ Function
+   ES_EnQueueFrontBlock
+ Parameters
+   const ES_Queue_t * pQueue : the queue
+   const ES_Event * pEvents : the events to add, oldest first
+   uint8_t Count : how many there are
+ Returns
+   bool : true if they were all added, false if they don't all fit, in
+   which case none are
+ Description
+   puts the events at the extraction point in one critical region, so they
+   are the next to be removed, in the order they are in pEvents, ahead of
+   anything already waiting. A batch of ES_EnQueueLIFO's that an ISR post
+   can't get in the middle of
+ Notes
+   a batch that doesn't fit is not a drop, the caller still has it. For
+   SPSC queues this must only be called from the consumer's context, as
+   for ES_EnQueueLIFO
+ Author
+   Tianyu, 10/14/26 22:50
+****************************************************************************/
+bool ES_EnQueueFrontBlock(const ES_Queue_t *pQueue, const ES_Event_t *pEvents,
+    uint8_t Count)
+{
+  bool ReturnVal;
+
+  EnterCritical();
+  ReturnVal = ES_EnQueueFrontBlockInCritical(pQueue, pEvents, Count);
+  ExitCritical();
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   ES_EnQueueFrontBlockInCritical
+ Parameters
+   const ES_Queue_t * pQueue : the queue
+   const ES_Event * pEvents : the events to add, oldest first
+   uint8_t Count : how many there are
+ Returns
+   bool : true if they were all added, false if none were
+ Description
+   ES_EnQueueFrontBlock for a caller that already has interrupts off
+ Author
+   Tianyu, 10/14/26 23:59
+****************************************************************************/
+bool ES_EnQueueFrontBlockInCritical(const ES_Queue_t *pQueue,
+    const ES_Event_t *pEvents, uint8_t Count)
+{
+  bool      ReturnVal = false;
+  uint8_t   i;
+
+  if (ES_QUEUE_KIND_SPSC == pQueue->QueueKind)
+  {
+    if (Count <= (uint8_t)(pQueue->QueueSize - NumWaiting(pQueue)))
+    {
+      // newest first, each one goes in ahead of the one before
+      for (i = Count; i > 0; i--)
+      {
+        (void)EnQueueSPSCLIFO(pQueue, pEvents[i - 1]);
+      }
+      ReturnVal = true;
+    }
+  }
+  else if (Count <= (uint8_t)(pQueue->QueueSize - CRIT(pQueue).NumEntries))
   {
-    return false;
+    for (i = Count; i > 0; i--)
+    {
+      if (CRIT(pQueue).CurrentIndex == 0)
+      {
+        CRIT(pQueue).CurrentIndex = pQueue->QueueSize - 1;
+      }
+      else
+      {
+        CRIT(pQueue).CurrentIndex--;
+      }
+      pQueue->pEntries[CRIT(pQueue).CurrentIndex] =
+          ES_PackEvent(pEvents[i - 1]);
+    }
+    CRIT(pQueue).NumEntries += Count;
+    NoteDepth(pQueue->pState, CRIT(pQueue).NumEntries);
+    ReturnVal = true;
   }
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   ES_EnQueueCoalesce
+ Parameters
+   const ES_Queue_t * pQueue : the queue
+   ES_Event Event2Add : event to be added to the Queue
+ Returns
+   bool : true if the event was merged or added, false if it was dropped
+ Description
+   if an event of the same type is already waiting, replaces its parameter
+   (and EventData) with the new one & leaves it where it is in the queue,
+   otherwise adds Event2Add at the end like ES_EnQueueFIFO
+ Notes
+   for events where only the latest value matters, so a burst of updates
+   takes one slot instead of filling the queue. A merge doesn't count
+   towards the high water mark. The consumer of an SPSC queue copies
+   entries out without a lock, so those are never merged into, this is a
+   plain ES_EnQueueFIFO for them
+ Author
+   Tianyu, 10/14/26 19:10
+****************************************************************************/
+bool ES_EnQueueCoalesce(const ES_Queue_t *pQueue, ES_Event_t Event2Add)
+{
+  bool ReturnVal;
+
+  if (ES_QUEUE_KIND_SPSC == pQueue->QueueKind)
+  {
+    return EnQueueSPSC(pQueue, Event2Add);
+  }
+  EnterCritical();  // the search & the add have to be one step
+  ReturnVal = ES_EnQueueCoalesceInCritical(pQueue, Event2Add);
+  ExitCritical();
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   ES_EnQueueCoalesceInCritical
+ Parameters
+   const ES_Queue_t * pQueue : the queue
+   ES_Event Event2Add : event to be added to the Queue
+ Returns
+   bool : true if the event was merged or added, false if it was dropped
+ Description
+   ES_EnQueueCoalesce for a caller that already has interrupts off
+ Author
+   Tianyu, 10/14/26 23:59
+****************************************************************************/
+bool ES_EnQueueCoalesceInCritical(const ES_Queue_t *pQueue,
+    ES_Event_t Event2Add)
+{
+  ES_PackedEvent_t  *pEntry;
+  uint8_t           Index;
+  uint8_t           i;
+  bool              ReturnVal = false;
+
+  if (ES_QUEUE_KIND_SPSC == pQueue->QueueKind)
+  {
+    return EnQueueSPSC(pQueue, Event2Add);
+  }
+  Index = CRIT(pQueue).CurrentIndex;
+  for (i = 0; i < CRIT(pQueue).NumEntries; i++)
+  {
+    pEntry = &pQueue->pEntries[Index];
+    if (pEntry->EventType == (uint8_t)Event2Add.EventType)
+    {
+      *pEntry = ES_PackEvent(Event2Add);
+      ReturnVal = true;
+      break;
+    }
+    if (++Index >= pQueue->QueueSize)
+    {
+      Index = 0;
+    }
+  }
+  if (ReturnVal == false)
+  {
+    ReturnVal = ES_EnQueueFIFOInCritical(pQueue, Event2Add);
+  }
+  return ReturnVal;
 }
 
 /****************************************************************************
  Function
    ES_DeQueue
  Parameters
-   unsigned char * pBlock : pointer to the block of memory in use as the Queue
+   const ES_Queue_t * pQueue : the queue
    ES_Event * pReturnEvent : used to return the event pulled from the queue
  Returns
    The number of entries remaining in the Queue
@@ -166,31 +432,35 @@ bool ES_EnQueueLIFO(ES_Event_t *pBlock, ES_Event_t Event2Add)
    pulls next available entry from Queue, EF_NO_EVENT if Queue was empty and
    copies it to *pReturnEvent.
  Notes
-
+   dispatches to the lock-free version for SPSC queues
  Author
    J. Edward Carryer, 08/09/11, 19:11
 ****************************************************************************/
-uint8_t ES_DeQueue(ES_Event_t *pBlock, ES_Event_t *pReturnEvent)
+uint8_t ES_DeQueue(const ES_Queue_t *pQueue, ES_Event_t *pReturnEvent)
 {
-  pQueue_t  pThisQueue;
   uint8_t   NumLeft;
 
-  pThisQueue = (pQueue_t)pBlock;
-  if (pThisQueue->NumEntries > 0)
+  if (ES_QUEUE_KIND_SPSC == pQueue->QueueKind)
+  {
+    return DeQueueSPSC(pQueue, pReturnEvent);
+  }
+  if (CRIT(pQueue).NumEntries > 0)
   {
 #ifdef POST_FROM_INTS
     EnterCritical();  // save interrupt state, turn ints off
 #endif
-    *pReturnEvent = pBlock[1 + pThisQueue->CurrentIndex];
+    *pReturnEvent = ES_UnpackEvent(
+        pQueue->pEntries[CRIT(pQueue).CurrentIndex]);
     // inc the index
-    pThisQueue->CurrentIndex++;
+    CRIT(pQueue).CurrentIndex++;
     // this way we only do the modulo operation when we really need to
-    if (pThisQueue->CurrentIndex >= pThisQueue->QueueSize)
+    if (CRIT(pQueue).CurrentIndex >= pQueue->QueueSize)
     {
-      pThisQueue->CurrentIndex = (uint8_t)(pThisQueue->CurrentIndex % pThisQueue->QueueSize);
+      CRIT(pQueue).CurrentIndex = (uint8_t)(CRIT(pQueue).CurrentIndex %
+          pQueue->QueueSize);
     }
     //dec number of elements since we took 1 out
-    NumLeft = --pThisQueue->NumEntries;
+    NumLeft = --CRIT(pQueue).NumEntries;
 #ifdef POST_FROM_INTS
     ExitCritical();    // restore saved interrupt state
 #endif
@@ -200,6 +470,7 @@ uint8_t ES_DeQueue(ES_Event_t *pBlock, ES_Event_t *pReturnEvent)
   {
     (*pReturnEvent).EventType   = ES_NO_EVENT;
     (*pReturnEvent).EventParam  = 0;
+    ES_EVENT_SET_DATA(*pReturnEvent, 0);
     NumLeft                     = 0;
   }
   return NumLeft;
@@ -209,7 +480,7 @@ uint8_t ES_DeQueue(ES_Event_t *pBlock, ES_Event_t *pReturnEvent)
  Function
    ES_IsQueueEmpty
  Parameters
-   unsigned char * pBlock : pointer to the block of memory in use as the Queue
+   const ES_Queue_t * pQueue : the queue
  Returns
    bool : true if Queue is empty
  Description
@@ -219,50 +490,219 @@ uint8_t ES_DeQueue(ES_Event_t *pBlock, ES_Event_t *pReturnEvent)
  Author
    J. Edward Carryer, 08/10/11, 13:29
 ****************************************************************************/
-bool ES_IsQueueEmpty(ES_Event_t *pBlock)
+bool ES_IsQueueEmpty(const ES_Queue_t *pQueue)
 {
-  pQueue_t pThisQueue;
-
-  pThisQueue = (pQueue_t)pBlock;
-  return pThisQueue->NumEntries == 0;
+  return NumWaiting(pQueue) == 0;
 }
 
-#if 0
 /****************************************************************************
  Function
-   QueueFlushQueue
+   ES_GetQueueStats
  Parameters
-   unsigned char * pBlock : pointer to the block of memory in use as the Queue
+   const ES_Queue_t * pQueue : the queue
+   ES_QueueStats_t * pStats : where to put the statistics
  Returns
    nothing
  Description
-   flushes the Queue by reinitializing the indecies
+   copies out the size, current depth, high water mark & drop statistics
  Notes
+   the fields are read one at a time, so a post from an ISR while this is
+   running may show up in some of them and not others
+ Author
+   Tianyu, 10/14/26 16:50
+****************************************************************************/
+void ES_GetQueueStats(const ES_Queue_t *pQueue, ES_QueueStats_t *pStats)
+{
+  pStats->NumEntries    = NumWaiting(pQueue);
+  pStats->QueueSize     = pQueue->QueueSize;
+  pStats->QueueKind     = pQueue->QueueKind;
+  pStats->HighWater     = pQueue->pState->HighWater;
+  pStats->DropCount     = pQueue->pState->DropCount;
+  pStats->LastDropType  = (ES_EventType_t)pQueue->pState->LastDropType;
+}
 
+/****************************************************************************
+ Function
+   ES_ClearQueueStats
+ Parameters
+   const ES_Queue_t * pQueue : the queue
+ Returns
+   nothing
+ Description
+   starts a new measurement of the high water mark & drops
+ Notes
+   the high water mark restarts at the current depth
  Author
-   J. Edward Carryer, 08/12/06, 19:24
+   Tianyu, 10/14/26 16:50
 ****************************************************************************/
-void QueueFlushQueue(uint8_t *pBlock)
+void ES_ClearQueueStats(const ES_Queue_t *pQueue)
 {
-  pQueue_t pThisQueue;
-  // doing this with a Queue structure is not strictly necessary
-  // but makes it clearer what is going on.
-  pThisQueue                = (pQueue_t)pBlock;
-  pThisQueue->CurrentIndex  = 0;
-  pThisQueue->NumEntries    = 0;
-  return;
+  EnterCritical();
+  ClearStats(pQueue->pState);
+  pQueue->pState->HighWater = NumWaiting(pQueue);
+  ExitCritical();
 }
 
-#endif
 /***************************************************************************
  private functions
  ***************************************************************************/
+/****************************************************************************
+ Function
+   EnQueueSPSC
+ Parameters
+   const ES_Queue_t * pQueue : the queue
+   ES_Event Event2Add : event to be added to the Queue
+ Returns
+   bool : true if the add was successful, false if not
+ Description
+   producer side of the lock-free queue. The entry is written before Head
+   is advanced, so the consumer never sees a partially copied event.
+ Notes
+   only one context (one ISR, or the main loop) may post to a given SPSC
+   queue
+ Author
+   Tianyu, 10/14/26 10:05
+****************************************************************************/
+static bool EnQueueSPSC(const ES_Queue_t *pQueue, ES_Event_t Event2Add)
+{
+  uint8_t Head = SPSC(pQueue).Head;
+
+  if ((uint8_t)(Head - SPSC(pQueue).Tail) >= pQueue->QueueSize)
+  {
+    NoteDrop(pQueue->pState, Event2Add.EventType);
+    return false; // full
+  }
+  pQueue->pEntries[Head & (pQueue->QueueSize - 1)] = ES_PackEvent(Event2Add);
+  QUEUE_BARRIER();
+  SPSC(pQueue).Head = Head + 1;
+  // Tail may move while we look at it, which can only make this smaller
+  NoteDepth(pQueue->pState, (uint8_t)(Head + 1 - SPSC(pQueue).Tail));
+  return true;
+}
+
+/****************************************************************************
+ Function
+   EnQueueSPSCLIFO
+ Parameters
+   const ES_Queue_t * pQueue : the queue
+   ES_Event Event2Add : event to be added to the Queue
+ Returns
+   bool : true if the add was successful, false if not
+ Description
+   puts Event2Add at the extraction point of a lock-free queue
+ Notes
+   This moves Tail, so it is a consumer side operation. A producer that
+   reads Tail while this is going on sees either the old value or the new
+   one, both of which make the queue look at least as full as it is.
+ Author
+   Tianyu, 10/14/26 10:05
+****************************************************************************/
+static bool EnQueueSPSCLIFO(const ES_Queue_t *pQueue, ES_Event_t Event2Add)
+{
+  uint8_t NewTail;
+
+  if ((uint8_t)(SPSC(pQueue).Head - SPSC(pQueue).Tail) >= pQueue->QueueSize)
+  {
+    NoteDrop(pQueue->pState, Event2Add.EventType);
+    return false; // full
+  }
+  NewTail = SPSC(pQueue).Tail - 1;
+  pQueue->pEntries[NewTail & (pQueue->QueueSize - 1)] =
+      ES_PackEvent(Event2Add);
+  QUEUE_BARRIER();
+  SPSC(pQueue).Tail = NewTail;
+  NoteDepth(pQueue->pState, (uint8_t)(SPSC(pQueue).Head - NewTail));
+  return true;
+}
+
+/****************************************************************************
+ Function
+   DeQueueSPSC
+ Parameters
+   const ES_Queue_t * pQueue : the queue
+   ES_Event * pReturnEvent : used to return the event pulled from the queue
+ Returns
+   The number of entries remaining in the Queue
+ Description
+   consumer side of the lock-free queue. The entry is copied out before Tail
+   is advanced, so the producer can not overwrite it while we are reading.
+ Notes
+
+ Author
+   Tianyu, 10/14/26 10:05
+****************************************************************************/
+static uint8_t DeQueueSPSC(const ES_Queue_t *pQueue, ES_Event_t *pReturnEvent)
+{
+  uint8_t Tail = SPSC(pQueue).Tail;
+
+  if (SPSC(pQueue).Head == Tail)
+  {
+    (*pReturnEvent).EventType   = ES_NO_EVENT;
+    (*pReturnEvent).EventParam  = 0;
+    ES_EVENT_SET_DATA(*pReturnEvent, 0);
+    return 0;
+  }
+  *pReturnEvent = ES_UnpackEvent(
+      pQueue->pEntries[Tail & (pQueue->QueueSize - 1)]);
+  QUEUE_BARRIER();
+  Tail++;
+  SPSC(pQueue).Tail = Tail;
+  return (uint8_t)(SPSC(pQueue).Head - Tail);
+}
+
+// the entries waiting in either kind of queue
+static uint8_t NumWaiting(const ES_Queue_t *pQueue)
+{
+  if (ES_QUEUE_KIND_SPSC == pQueue->QueueKind)
+  {
+    return (uint8_t)(SPSC(pQueue).Head - SPSC(pQueue).Tail);
+  }
+  return CRIT(pQueue).NumEntries;
+}
+
+/****************************************************************************
+ Function
+   ClearStats, NoteDepth & NoteDrop
+ Description
+   maintain the statistics in the queue state.
+ Notes
+   For the critical kind, NoteDepth & NoteDrop are called with interrupts
+   off. For the SPSC kind only the producer updates them (apart from the
+   rare LIFO recall), so they stay lock-free and at worst a high water
+   update from a recall is lost.
+ Author
+   Tianyu, 10/14/26 16:50
+****************************************************************************/
+static void ClearStats(ES_QueueState_t *pState)
+{
+  pState->HighWater     = 0;
+  pState->LastDropType  = ES_NO_EVENT;
+  pState->DropCount     = 0;
+}
+
+static void NoteDepth(ES_QueueState_t *pState, uint8_t Depth)
+{
+  if (Depth > pState->HighWater)
+  {
+    pState->HighWater = Depth;
+  }
+}
+
+static void NoteDrop(ES_QueueState_t *pState, ES_EventType_t DroppedType)
+{
+  if (pState->DropCount != 0xFFFF)
+  {
+    pState->DropCount++;
+  }
+  pState->LastDropType = (uint8_t)DroppedType;
+}
+
 #ifdef TEST
 
 #include <stdio.h>
 #include "ES_General.h"
 
-static ES_Event   TestQueue[3 + 1];
+ES_DEFINE_QUEUE(TestQueue, 3, ES_QUEUE_KIND_CRITICAL);
 volatile uint8_t  NumLeft; // for debugging visibility
 
 void main(void)
@@ -270,21 +710,21 @@ void main(void)
   ES_Event  MyEvent;
   bool      bReturn;
 
-  ES_InitQueue(TestQueue, ARRAY_SIZE(TestQueue));
+  ES_InitQueue(&TestQueue);
   MyEvent.EventType   = 0;
   MyEvent.EventParam  = 1;
-  bReturn             = ES_EnQueueFIFO(TestQueue, MyEvent);
+  bReturn             = ES_EnQueueFIFO(&TestQueue, MyEvent);
   bReturn             += 1; // keep that sily optimizer away
 
   // Try stuffing one on using the LIFO rule
   MyEvent.EventType   = 10;
   MyEvent.EventParam  = 11;
-  bReturn             = ES_EnQueueLIFO(TestQueue, MyEvent);
+  bReturn             = ES_EnQueueLIFO(&TestQueue, MyEvent);
   bReturn             += 1; // keep that sily optimizer away
 
   // at this point, the events in the queue should be 11,0
   // so pull off the 11, leaving 1 entry
-  NumLeft = ES_DeQueue(TestQueue, &MyEvent);
+  NumLeft = ES_DeQueue(&TestQueue, &MyEvent);
   if (NumLeft != 1)
   {
     bReturn = 0;
@@ -292,23 +732,23 @@ void main(void)
 
   MyEvent.EventType   = 2;
   MyEvent.EventParam  = 3;
-  bReturn             = ES_EnQueueFIFO(TestQueue, MyEvent);
+  bReturn             = ES_EnQueueFIFO(&TestQueue, MyEvent);
   bReturn             += 1; // keep that sily optimizer away
 
   MyEvent.EventType   = 4;
   MyEvent.EventParam  = 5;
-  bReturn             = ES_EnQueueFIFO(TestQueue, MyEvent);
+  bReturn             = ES_EnQueueFIFO(&TestQueue, MyEvent);
   bReturn             += 1; // keep that sily optimizer away
 
   // queue is now full so this one should fail
   MyEvent.EventType   = 6;
   MyEvent.EventParam  = 7;
-  bReturn             = ES_EnQueueFIFO(TestQueue, MyEvent);
+  bReturn             = ES_EnQueueFIFO(&TestQueue, MyEvent);
   bReturn             += 1; // keep that sily optimizer away
 
   // at this point, the events in the queue should be 0,2,4
   // so pull off the 0, leaving 2 entries
-  NumLeft = ES_DeQueue(TestQueue, &MyEvent);
+  NumLeft = ES_DeQueue(&TestQueue, &MyEvent);
   if (NumLeft != 2)
   {
     bReturn = 0;
@@ -316,12 +756,12 @@ void main(void)
   // Try stuffing one on using the LIFO rule
   MyEvent.EventType   = 8;
   MyEvent.EventParam  = 9;
-  bReturn             = ES_EnQueueLIFO(TestQueue, MyEvent);
+  bReturn             = ES_EnQueueLIFO(&TestQueue, MyEvent);
   bReturn             += 1; // keep that sily optimizer away
 
   // at this point, the events in the queue should be 8,2,4
   // so pull off the 8, leaving 2 entries
-  NumLeft = ES_DeQueue(TestQueue, &MyEvent);
+  NumLeft = ES_DeQueue(&TestQueue, &MyEvent);
   NumLeft += 3; //to keep the compiler from optimizing away the last save
 
   while (1)
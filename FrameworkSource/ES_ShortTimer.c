@@ -1,187 +1,307 @@
-//#define DEBUG
 /****************************************************************************
  Module
    ES_ShortTimer.c
 
  Revision
-   1.0.1
+   2.0.0
 
  Description
    This is a library to provide for the creation of short time-outs
    (shorter than the resolution of the ES_Timer library).
 
  Notes
-   This module uses the Tiva Peripheral Driver Library functions and
-   the ability that it provides to 'hook' a function into an interrupt
-   response routine without modifying the vector table directly.
-   Uses timers A & B on 16/32 bit Timer Module 5
+   Uses Timer5 for TIMER_A & Timer1 for TIMER_B, both at PBCLK/8 so that a
+   tick is 0.4uS. A timeout is turned into ticks & split into as few equal
+   periods as fit the 16 bit period register, each at least half of it
+   long, so the ISR always has plenty of time to load the next one before
+   the timer gets there. The ISR posts ES_SHORT_TIMEOUT after the last.
+
+   Everything the ISR uses is set while its interrupt is off, so neither
+   side needs a critical region.
 
  History
  When           Who     What/Why
  -------------- ---     --------
  10/11/15 10:30 jec     first pass
  10/11/15 18:10 jec     converted to post events to the framework
-
+ 10/14/26 23:10 ty      ported from the TM4C123 Timer5 A/B pair to PIC32
+                        Timer5 & Timer1, added ES_ShortTimerStop & timeouts
+                        past the 16 bit period. A timeout under
+                        SHORT_TIMER_MIN_US no longer starts the timer too
 ****************************************************************************/
-// the common headers for I/O, C99 types
-#include <stdio.h>
-#include <stdint.h>
-#include <stdbool.h>
-#include "BITDEFS.H"
-
-// the headers to access the GPIO subsystem
-#include "inc/hw_memmap.h"
-#include "inc/hw_types.h"
-#include "inc/hw_gpio.h"
-#include "inc/hw_sysctl.h"
-#include "inc/hw_timer.h"
-#include "inc/hw_ints.h"
-
-// the headers to access the TivaWare Library
-#include "driverlib/sysctl.h"
-#include "driverlib/pin_map.h"
-#include "driverlib/gpio.h"
-#include "driverlib/timer.h"
-#include "driverlib/interrupt.h"
+/*----------------------------- Include Files -----------------------------*/
+#include <xc.h>
+#include <sys/attribs.h>
 
 // the header to get the timing functions
 #include "ES_ShortTimer.h"
 
 // the framework headers
-#include "ES_Framework.h"
 #include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
+#include "ES_IsrStats.h"
 
-// module level functions
+/*----------------------------- Module Defines ----------------------------*/
+// PBCLK/8 on both, the Type B (Timer5) & Type A (Timer1) codes for it differ
+#define SHORT_TIMER_PRESCALE 8
+#define TYPE_B_DIV_8 0b011
+#define TYPE_A_DIV_8 0b01
 
-// define for the timer pre-scaler. this sets the resolution of the
-// timing functions
-// the current values are based on a 40mHz clock rate to give 1uS resolution
-#define PRE_1uS 40
+// 2.5 ticks per uS at a 20MHz PBCLK, so count in tenths
+#define TICKS_PER_10_US \
+  ((SHORT_TIMER_PBCLK_HZ / SHORT_TIMER_PRESCALE) / 100000u)
+// core timer counts per tick, for the ISR latency
+#define TICKS_TO_CORE \
+  (_HW_CYCLES_PER_US * SHORT_TIMER_PRESCALE / (SHORT_TIMER_PBCLK_HZ / \
+  1000000u))
 
-void ShortTimerAHandler(void);
-void ShortTimerBHandler(void);
+// the longest period, PRx + 1
+#define MAX_PERIOD_TICKS 0x10000u
 
-// module level variables
+#define NUM_SHORT_TIMERS 2
 
-static uint8_t  Timer_A_Priority  = SHORT_TIMER_UNUSED;
-static uint8_t  Timer_B_Priority  = SHORT_TIMER_UNUSED;
+/*------------------------------ Module Types -----------------------------*/
+typedef struct
+{
+  uint8_t  Priority;    // service to post to, SHORT_TIMER_UNUSED for none
+  uint8_t  PeriodsLeft; // after the one that is running
+  uint32_t TicksLeft;   // in those periods
+} ShortTimer_t;
 
-//******************************
-// ES_ShortTimerInit()
-// Initialize the timer subsystem and log the services to which the timeout
-// messages will be posted
-//******************************
+/*---------------------------- Module Functions ---------------------------*/
+static void StopHardware(uint32_t Which);
+static void StartHardware(uint32_t Which, uint32_t PeriodTicks);
+static uint32_t NextPeriod(volatile ShortTimer_t *pTimer);
+static void RunOut(uint32_t Which);
+static void PostTimeout(uint32_t Which);
+
+/*---------------------------- Module Variables ---------------------------*/
+static volatile ShortTimer_t ShortTimers[NUM_SHORT_TIMERS] = {
+  { SHORT_TIMER_UNUSED, 0, 0 },
+  { SHORT_TIMER_UNUSED, 0, 0 }
+};
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     ES_ShortTimerInit
+ Parameters
+     uint8_t TimeAPrio, the service that TIMER_A posts to
+     uint8_t TimeBPrio, the service that TIMER_B posts to
+     either can be SHORT_TIMER_UNUSED
+ Returns
+     nothing
+ Description
+     Sets up each timer that is used for PBCLK/8 off, & logs the services
+     to which the timeouts will be posted
+ Author
+     Tianyu, 10/14/26 23:10
+****************************************************************************/
 void ES_ShortTimerInit(uint8_t TimeAPrio, uint8_t TimeBPrio)
 {
-#ifdef DEBUG
-// set up I/O lines for debugging
-  SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);
-  GPIOPinTypeGPIOOutput(GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1);
-// start with the lines low
-  GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1, BIT0LO & BIT1LO);
-#endif
-
-// enable the clock to the timer module
-  SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER5);
-// configure as 2 16 bit timers
-  TimerConfigure(TIMER5_BASE, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_ONE_SHOT |
-      TIMER_CFG_B_ONE_SHOT);
-// set prescale to get 1uS resolution
-  TimerPrescaleSet(TIMER5_BASE, TIMER_BOTH, PRE_1uS);
-// log the service to which the timeout will be posted
-  Timer_A_Priority  = TimeAPrio;
-  Timer_B_Priority  = TimeBPrio;
+  ShortTimers[TIMER_A].Priority = TimeAPrio;
+  ShortTimers[TIMER_B].Priority = TimeBPrio;
+
+  if (TimeAPrio != SHORT_TIMER_UNUSED)
+  {
+    StopHardware(TIMER_A);
+    T5CONbits.TCS = 0;    // PBCLK
+    T5CONbits.TGATE = 0;
+    T5CONbits.TCKPS = TYPE_B_DIV_8;
+    IPC5bits.T5IP = SHORT_TIMER_PRIORITY;
+  }
+  if (TimeBPrio != SHORT_TIMER_UNUSED)
+  {
+    StopHardware(TIMER_B);
+    T1CONbits.TCS = 0;    // PBCLK
+    T1CONbits.TGATE = 0;
+    T1CONbits.TCKPS = TYPE_A_DIV_8;
+    IPC1bits.T1IP = SHORT_TIMER_PRIORITY;
+  }
 }
 
+/****************************************************************************
+ Function
+     ES_ShortTimerStart
+ Parameters
+     uint32_t Which, TIMER_A or TIMER_B
+     uint16_t TimeoutValue, in uS
+ Returns
+     nothing
+ Description
+     (Re)starts the timer, ES_SHORT_TIMEOUT is posted when it runs out. A
+     timeout under SHORT_TIMER_MIN_US is posted now
+ Author
+     Tianyu, 10/14/26 23:10
+****************************************************************************/
 void ES_ShortTimerStart(uint32_t Which, uint16_t TimeoutValue)
 {
+  volatile ShortTimer_t *pTimer;
+  uint32_t Ticks;
+
   if ((Which != TIMER_A) && (Which != TIMER_B))
   {
     return;
   }
+  pTimer = &ShortTimers[Which];
+  if (pTimer->Priority == SHORT_TIMER_UNUSED)
+  {
+    return;
+  }
+  // a timeout that is still running is replaced, not added to
+  StopHardware(Which);
+
   // for very short delays. just immediatly post. There is 10us of overhead
-  if (TimeoutValue < 11)
+  if (TimeoutValue < SHORT_TIMER_MIN_US)
   {
-    if (Which == TIMER_A)
-    {
-      ShortTimerAHandler();
-    }
-    else
-    {
-      ShortTimerBHandler();
-    }
+    PostTimeout(Which);
+    return;
+  }
+  Ticks = ((uint32_t)TimeoutValue * TICKS_PER_10_US) / 10;
+  pTimer->PeriodsLeft = (uint8_t)((Ticks + MAX_PERIOD_TICKS - 1) /
+      MAX_PERIOD_TICKS);
+  pTimer->TicksLeft = Ticks;
+  StartHardware(Which, NextPeriod(pTimer));
+}
+
+/****************************************************************************
+ Function
+     ES_ShortTimerStop
+ Parameters
+     uint32_t Which, TIMER_A or TIMER_B
+ Returns
+     nothing
+ Description
+     Cancels the timeout if it hasn't run out, it won't be posted
+ Notes
+     one that has already run out may be waiting in the service's queue
+ Author
+     Tianyu, 10/14/26 23:10
+****************************************************************************/
+void ES_ShortTimerStop(uint32_t Which)
+{
+  if ((Which != TIMER_A) && (Which != TIMER_B))
+  {
+    return;
   }
-  TimerLoadSet(TIMER5_BASE, Which, TimeoutValue);
+  StopHardware(Which);
+}
+
+/****************************************************************************
+ Function
+     ShortTimerAISR, ShortTimerBISR
+ Description
+     Load the next period, or post the timeout after the last one
+ Notes
+     The IPL must match SHORT_TIMER_PRIORITY
+ Author
+     Tianyu, 10/14/26 23:10
+****************************************************************************/
+void __ISR(_TIMER_5_VECTOR, IPL5SOFT) ShortTimerAISR(void)
+{
+  // TMR5 has counted up from 0 since the period match
+  ES_IsrStats_Enter(ES_ISR(ShortTimerA), (uint32_t)TMR5 * TICKS_TO_CORE);
+  IFS0CLR = _IFS0_T5IF_MASK;
+  RunOut(TIMER_A);
+  ES_IsrStats_Exit(ES_ISR(ShortTimerA));
+}
 
-  if (Which == TIMER_A) // local enable
+void __ISR(_TIMER_1_VECTOR, IPL5SOFT) ShortTimerBISR(void)
+{
+  ES_IsrStats_Enter(ES_ISR(ShortTimerB), (uint32_t)TMR1 * TICKS_TO_CORE);
+  IFS0CLR = _IFS0_T1IF_MASK;
+  RunOut(TIMER_B);
+  ES_IsrStats_Exit(ES_ISR(ShortTimerB));
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+// interrupt off first, then a flag that is already set can't get through
+static void StopHardware(uint32_t Which)
+{
+  if (Which == TIMER_A)
   {
-    TimerIntEnable(TIMER5_BASE, TIMER_TIMA_TIMEOUT);
-    // NVIC Enable
-    IntEnable(INT_TIMER5A_TM4C123);
+    IEC0CLR = _IEC0_T5IE_MASK;
+    T5CONbits.ON = 0;
+    IFS0CLR = _IFS0_T5IF_MASK;
   }
   else
   {
-    // local enable
-    TimerIntEnable(TIMER5_BASE, TIMER_TIMB_TIMEOUT);
-    // NVIC Enable
-    IntEnable(INT_TIMER5B_TM4C123);
+    IEC0CLR = _IEC0_T1IE_MASK;
+    T1CONbits.ON = 0;
+    IFS0CLR = _IFS0_T1IF_MASK;
   }
+  ShortTimers[Which].PeriodsLeft = 0;
+}
 
-  TimerEnable(TIMER5_BASE, Which);
-
-#ifdef DEBUG
-// raise I/O line to show we started
+static void StartHardware(uint32_t Which, uint32_t PeriodTicks)
+{
   if (Which == TIMER_A)
   {
-    GPIOPinWrite(GPIO_PORTB_BASE, BIT0HI, BIT0HI);
+    TMR5 = 0;
+    PR5 = PeriodTicks - 1;
+    IEC0SET = _IEC0_T5IE_MASK;
+    T5CONbits.ON = 1;
   }
   else
   {
-    GPIOPinWrite(GPIO_PORTB_BASE, BIT1HI, BIT1HI);
+    TMR1 = 0;
+    PR1 = PeriodTicks - 1;
+    IEC0SET = _IEC0_T1IE_MASK;
+    T1CONbits.ON = 1;
   }
-#endif
-  return;
 }
 
-void ShortTimerAHandler(void)
+// the ticks in the next period, the ones left shared as evenly as they go,
+// & counts it off
+static uint32_t NextPeriod(volatile ShortTimer_t *pTimer)
 {
-  ES_Event_t ThisEvent;
+  uint32_t Period;
 
-// start by clearing the source of the interrupt
-  TimerIntClear(TIMER5_BASE, TIMER_TIMA_TIMEOUT);
-#ifdef DEBUG
-// lower I/O line to show we arrived
-  GPIOPinWrite(GPIO_PORTB_BASE, BIT0HI, BIT0LO);
-#endif
+  Period = (pTimer->TicksLeft + pTimer->PeriodsLeft - 1) / pTimer->PeriodsLeft;
+  pTimer->TicksLeft -= Period;
+  pTimer->PeriodsLeft--;
+  return Period;
+}
 
-// post the timeout for this timer
-  ThisEvent.EventType   = ES_SHORT_TIMEOUT;
-  ThisEvent.EventParam  = TIMER_A;
-// protect against timer that was not correctly initialized
-  if (Timer_A_Priority != SHORT_TIMER_UNUSED)
+// from the ISR, at the end of a period
+static void RunOut(uint32_t Which)
+{
+  volatile ShortTimer_t *pTimer = &ShortTimers[Which];
+
+  if (pTimer->PeriodsLeft != 0)
   {
-    ES_PostToService(Timer_A_Priority, ThisEvent);
+    // the timer is already counting the next period up from 0, each one is
+    // over half of the 16 bits so it is still well short of this
+    if (Which == TIMER_A)
+    {
+      PR5 = NextPeriod(pTimer) - 1;
+    }
+    else
+    {
+      PR1 = NextPeriod(pTimer) - 1;
+    }
+    return;
   }
+  StopHardware(Which);
+  PostTimeout(Which);
 }
 
-void ShortTimerBHandler(void)
+static void PostTimeout(uint32_t Which)
 {
   ES_Event_t ThisEvent;
 
-// start by clearing the source of the interrupt
-  TimerIntClear(TIMER5_BASE, TIMER_TIMB_TIMEOUT);
-#ifdef DEBUG
-// lower I/O line to show we arrived
-  GPIOPinWrite(GPIO_PORTB_BASE, BIT1HI, BIT1LO);
-#endif
-
-// post the timeout for this timer
+  // post the timeout for this timer
   ThisEvent.EventType   = ES_SHORT_TIMEOUT;
-  ThisEvent.EventParam  = TIMER_B;
-// protect against timer that was not correctly initialized
-  if (Timer_B_Priority != SHORT_TIMER_UNUSED)
+  ThisEvent.EventParam  = (uint16_t)Which;
+  // protect against timer that was not correctly initialized
+  if (ShortTimers[Which].Priority != SHORT_TIMER_UNUSED)
   {
-    ES_PostToService(Timer_B_Priority, ThisEvent);
+    ES_PostToService(ShortTimers[Which].Priority, ThisEvent);
   }
 }
 
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,110 @@
+/****************************************************************************
+ Module
+     ES_Time.c
+
+ Description
+     64 bit time from the 32 bit core timer count (see ES_Time.h)
+
+ Notes
+     HalfWraps is bits 62..31 of the 64 bit time when it was last updated,
+     so its bit 0 is what bit 31 of the count was then. If bit 31 of the
+     count read now is different, the count has gone on into the next half
+     wrap since. A reader must read HalfWraps before the count: the other
+     way round an update in between could leave HalfWraps ahead of the
+     count it is put with.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+
+ 10/14/26 23:20 ty      first pass
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <xc.h>
+
+#include "ES_Port.h"
+#include "ES_Time.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define HALF_WRAP_SHIFT 31
+#define LOW_MASK 0x7FFFFFFFu
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint64_t Extend(uint32_t Halves, uint32_t Count);
+
+/*---------------------------- Module Variables ---------------------------*/
+// only ES_Time_Update writes it, one 32 bit store so a reader sees it whole
+static volatile uint32_t HalfWraps;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     ES_Time_NowCycles
+ Parameters
+     none
+ Returns
+     uint64_t core timer counts (20MHz) since reset
+ Description
+     reads the count & extends it to 64 bits
+ Notes
+     safe from any context, interrupts stay on
+ Author
+     Tianyu, 10/14/26 23:20
+****************************************************************************/
+uint64_t ES_Time_NowCycles(void)
+{
+  uint32_t Halves = HalfWraps;
+
+  return Extend(Halves, _CP0_GET_COUNT());
+}
+
+/****************************************************************************
+ Function
+     ES_Time_NowUs
+ Parameters
+     none
+ Returns
+     uint64_t uS since reset
+ Author
+     Tianyu, 10/14/26 23:20
+****************************************************************************/
+uint64_t ES_Time_NowUs(void)
+{
+  return ES_Time_NowCycles() / _HW_CYCLES_PER_US;
+}
+
+/****************************************************************************
+ Function
+     ES_Time_Update
+ Parameters
+     none
+ Returns
+     nothing
+ Description
+     brings HalfWraps up to date with the count
+ Notes
+     must be called at least every 107S, & only from one context. The tick
+     ISR calls it
+ Author
+     Tianyu, 10/14/26 23:20
+****************************************************************************/
+void ES_Time_Update(void)
+{
+  HalfWraps = (uint32_t)(Extend(HalfWraps, _CP0_GET_COUNT()) >>
+      HALF_WRAP_SHIFT);
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+static uint64_t Extend(uint32_t Halves, uint32_t Count)
+{
+  if (((Halves ^ (Count >> HALF_WRAP_SHIFT)) & 1) != 0)
+  {
+    Halves++;   // into the next half wrap since the update
+  }
+  return ((uint64_t)Halves << HALF_WRAP_SHIFT) | (Count & LOW_MASK);
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -3,16 +3,25 @@
      ES_Timers.c
 
  Description
-     This is a module implementing  8 16 bit timers all using the RTI
-     timebase
+     This is a module implementing ES_NUM_TIMERS (16 or 32) timers, of 16
+     or 32 bits, all using the RTI timebase
 
  Notes
      Everything is done in terms of RTI Ticks, which can change from
      application to application.
+     The active timers are kept in a delta list, sorted by expiration time,
+     where each timer holds the number of ticks between its own expiration
+     and that of the timer ahead of it. On each tick only the head of the
+     list is decremented, so the cost of a tick is proportional to the
+     number of timers that expire on it, not the number that are running.
+     The cost moves to starting & stopping a timer, which walk the list.
 
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 12:30 ty       added ES_Timer_GetTicksToNextExpiry for tickless idle
+ 10/14/26 11:20 ty       replaced the per tick scan of every active timer with
+                         a delta list, up to 32 timers, optional 32 bit times
  10/27/14 14:02 jec      moved ticking of 'time' to ES_Port to allow it to tick
                          even while blocking. required change to ES_GetTime too
  10/20/13 10:48 jec      moved definition of BITS_PER_BYTE to ES_General.h
@@ -52,46 +61,48 @@
 #include "../FrameworkHeaders/ES_Port.h"
 /*--------------------------- External Variables --------------------------*/
 
-/*----------------------------- Module Defines ----------------------------*/
-
 /*------------------------------ Module Types -----------------------------*/
 
 /*
-   the size of Tflag sets the number of timers, uint8 = 8, uint16 = 16 ...)
-   to add more timers, you will need to change the data type and modify
-   the initialization of TMR_TimerArray and TMR_MaskArray
+   Tflag_t holds one active flag per timer, so it must have at least
+   ES_NUM_TIMERS bits
 */
-
+#if ES_NUM_TIMERS > 16
+typedef uint32_t Tflag_t;
+#else
 typedef uint16_t Tflag_t;
+#endif
+
+typedef ES_TimerTime_t Timer_t; // 16 or 32 bits, see ES_Configure.h
+
+/*----------------------------- Module Defines ----------------------------*/
+// marks the end of the delta list
+#define NO_TIMER 0xFF
 
-typedef uint16_t Timer_t; // sets size of timers to 16 bits
+#define TIMER_MASK(Num) (((Tflag_t)1) << (Num))
 
 /*---------------------------- Module Functions ---------------------------*/
+static void InsertTimer(uint8_t Num, Timer_t NewTime);
+static Timer_t RemoveTimer(uint8_t Num);
 
 /*---------------------------- Module Variables ---------------------------*/
-static Timer_t TMR_TimerArray[sizeof(Tflag_t) * BITS_PER_BYTE] =
-{
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0
-};
+/*
+  For an active timer, this is the number of ticks between its expiration
+  and the expiration of the timer ahead of it in the list. For an inactive
+  timer, it is the number of ticks it will count when (re)started, 0 if it
+  has expired.
+*/
+static Timer_t TMR_TimerArray[ES_NUM_TIMERS];
+
+// the next timer in the delta list for each active timer
+static uint8_t TMR_NextTimer[ES_NUM_TIMERS];
+
+// the first timer to expire, NO_TIMER if none are active
+static uint8_t TMR_ListHead = NO_TIMER;
 
 static Tflag_t TMR_ActiveFlags;
 
-static pPostFunc const Timer2PostFunc[sizeof(Tflag_t) * BITS_PER_BYTE] =
+static pPostFunc const Timer2PostFunc[ES_NUM_TIMERS] =
 {
   TIMER0_RESP_FUNC,
   TIMER1_RESP_FUNC,
@@ -109,6 +120,24 @@ static pPostFunc const Timer2PostFunc[sizeof(Tflag_t) * BITS_PER_BYTE] =
   TIMER13_RESP_FUNC,
   TIMER14_RESP_FUNC,
   TIMER15_RESP_FUNC
+#if ES_NUM_TIMERS > 16
+  , TIMER16_RESP_FUNC,
+  TIMER17_RESP_FUNC,
+  TIMER18_RESP_FUNC,
+  TIMER19_RESP_FUNC,
+  TIMER20_RESP_FUNC,
+  TIMER21_RESP_FUNC,
+  TIMER22_RESP_FUNC,
+  TIMER23_RESP_FUNC,
+  TIMER24_RESP_FUNC,
+  TIMER25_RESP_FUNC,
+  TIMER26_RESP_FUNC,
+  TIMER27_RESP_FUNC,
+  TIMER28_RESP_FUNC,
+  TIMER29_RESP_FUNC,
+  TIMER30_RESP_FUNC,
+  TIMER31_RESP_FUNC
+#endif
 };
 
 /*------------------------------ Module Code ------------------------------*/
@@ -139,18 +168,19 @@ void ES_Timer_Init(TimerRate_t Rate)
      ES_Timer_SetTimer
  Parameters
      unsigned char Num, the number of the timer to set.
-     unsigned int NewTime, the new time to set on that timer
+     ES_TimerTime_t NewTime, the new time to set on that timer
  Returns
      ES_Timer_ERR if requested timer does not exist or has no service
      ES_Timer_OK  otherwise
  Description
      sets the time for a timer, but does not make it active.
  Notes
-     None.
+     As before, setting the time on a timer that is already running replaces
+     the time it has left, and it keeps running.
  Author
      J. Edward Carryer, 02/24/97 17:11
 ****************************************************************************/
-ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint16_t NewTime)
+ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, ES_TimerTime_t NewTime)
 {
   /* tried to set a timer that doesn't exist */
   if ((Num >= ARRAY_SIZE(TMR_TimerArray)) ||
@@ -160,7 +190,16 @@ ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint16_t NewTime)
   {
     return ES_Timer_ERR;
   }
-  TMR_TimerArray[Num] = NewTime;
+  if (TMR_ActiveFlags & TIMER_MASK(Num))
+  {
+    // re-file it in the list at its new expiration time
+    RemoveTimer(Num);
+    InsertTimer(Num, NewTime);
+  }
+  else
+  {
+    TMR_TimerArray[Num] = NewTime;
+  }
   return ES_Timer_OK;
 }
 
@@ -172,23 +211,31 @@ ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint16_t NewTime)
  Returns
      ES_Timer_ERR for error ES_Timer_OK for success
  Description
-     simply sets the active flag in TMR_ActiveFlags to (re)start a
-     stopped timer.
+     (re)starts a stopped timer with the time that it had left or the time
+     set with ES_Timer_SetTimer
  Notes
-     None.
+     starting a timer that is already running has no effect
  Author
      J. Edward Carryer, 02/24/97 14:45
 ****************************************************************************/
 ES_TimerReturn_t ES_Timer_StartTimer(uint8_t Num)
 {
   /* tried to set a timer that doesn't exist */
-  if ((Num >= ARRAY_SIZE(TMR_TimerArray)) ||
-      /* tried to set a timer with no time on it */
-      (TMR_TimerArray[Num] == 0))
+  if (Num >= ARRAY_SIZE(TMR_TimerArray))
   {
     return ES_Timer_ERR;
   }
-  TMR_ActiveFlags |= BitNum2SetMask[Num];  /* set timer as active */
+  if (TMR_ActiveFlags & TIMER_MASK(Num))
+  {
+    return ES_Timer_OK; /* already counting */
+  }
+  /* tried to set a timer with no time on it */
+  if (TMR_TimerArray[Num] == 0)
+  {
+    return ES_Timer_ERR;
+  }
+  InsertTimer(Num, TMR_TimerArray[Num]);
+  TMR_ActiveFlags |= TIMER_MASK(Num);  /* set timer as active */
   return ES_Timer_OK;
 }
 
@@ -200,8 +247,8 @@ ES_TimerReturn_t ES_Timer_StartTimer(uint8_t Num)
  Returns
      ES_Timer_ERR for error (timer doesn't exist) ES_Timer_OK for success.
  Description
-     simply clears the bit in TMR_ActiveFlags associated with this
-     timer. This will cause it to stop counting.
+     takes the timer out of the list of active timers, saving the time that
+     it had left so that ES_Timer_StartTimer can resume it.
  Notes
      None.
  Author
@@ -213,7 +260,11 @@ ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num)
   {
     return ES_Timer_ERR;    /* tried to set a timer that doesn't exist */
   }
-  TMR_ActiveFlags &= BitNum2ClrMask[Num];  /* set timer as inactive */
+  if (TMR_ActiveFlags & TIMER_MASK(Num))
+  {
+    TMR_TimerArray[Num] = RemoveTimer(Num);
+    TMR_ActiveFlags &= ~TIMER_MASK(Num);  /* set timer as inactive */
+  }
   return ES_Timer_OK;
 }
 
@@ -222,7 +273,7 @@ ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num)
      ES_Timer_InitTimer
  Parameters
      unsigned char Num, the number of the timer to start
-     unsigned int NewTime, the number of ticks to be counted
+     ES_TimerTime_t NewTime, the number of ticks to be counted
  Returns
      ES_Timer_ERR if the requested timer does not exist, ES_Timer_OK otherwise.
  Description
@@ -233,7 +284,7 @@ ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num)
  Author
      J. Edward Carryer, 02/24/97 14:51
 ****************************************************************************/
-ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint16_t NewTime)
+ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, ES_TimerTime_t NewTime)
 {
   /* tried to set a timer that doesn't exist */
   if ((Num >= ARRAY_SIZE(TMR_TimerArray)) ||
@@ -244,8 +295,12 @@ ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint16_t NewTime)
   {
     return ES_Timer_ERR;
   }
-  TMR_TimerArray[Num] = NewTime;
-  TMR_ActiveFlags     |= BitNum2SetMask[Num]; /* set timer as active */
+  if (TMR_ActiveFlags & TIMER_MASK(Num))
+  {
+    RemoveTimer(Num); // restarting a running timer
+  }
+  InsertTimer(Num, NewTime);
+  TMR_ActiveFlags |= TIMER_MASK(Num); /* set timer as active */
   return ES_Timer_OK;
 }
 
@@ -270,6 +325,30 @@ uint16_t ES_Timer_GetTime(void)
   return _HW_GetTickCount();
 }
 
+/****************************************************************************
+ Function
+     ES_Timer_GetTicksToNextExpiry
+ Parameters
+     None.
+ Returns
+     ES_TimerTime_t the number of ticks until the next timer expires, 0 if
+     no timers are running
+ Description
+     With the delta list, this is simply the count on the head of the list.
+ Notes
+     used by the tickless idle code in ES_Port.c
+ Author
+     Tianyu, 10/14/26 12:30
+****************************************************************************/
+ES_TimerTime_t ES_Timer_GetTicksToNextExpiry(void)
+{
+  if (TMR_ListHead == NO_TIMER)
+  {
+    return 0;
+  }
+  return TMR_TimerArray[TMR_ListHead];
+}
+
 /****************************************************************************
  Function
      ES_Timer_Tick_Resp
@@ -279,46 +358,132 @@ uint16_t ES_Timer_GetTime(void)
      None.
  Description
      This is the new Tick response routine to support the timer module.
-     It will increment time, to maintain the functionality of the
-     GetTime() timer and it will check through the active timers,
-     decrementing each active timers count, if the count goes to 0, it
-     will post an event to the corresponding SM and clear the active flag to
-     prevent further counting.
+     It decrements the count on the timer at the head of the delta list.
+     When that reaches 0, it and every timer behind it with a delta of 0
+     have expired, so each is taken off the list and an ES_TIMEOUT is
+     posted to the corresponding SM.
  Notes
-     Called from _Timer_Int_Resp in ES_Port.c.
+     Called from _Timer_Int_Resp in ES_Port.c. That runs from the main loop,
+     as do all of the other timer functions, so there is no need to protect
+     the list.
  Author
      J. Edward Carryer, 02/24/97 15:06
 ****************************************************************************/
 void ES_Timer_Tick_Resp(void)
 {
-  static Tflag_t  NeedsProcessing;
   static uint8_t  NextTimer2Process;
   static ES_Event_t NewEvent;
 
-  if (TMR_ActiveFlags != 0) /* if !=0 , then at least 1 timer is active */
+  if (TMR_ListHead != NO_TIMER) /* then at least 1 timer is active */
   {
-    // start by getting a list of all the active timers
-    NeedsProcessing = TMR_ActiveFlags;
-    do
+    if (--TMR_TimerArray[TMR_ListHead] == 0)
     {
-      // find the MSB that is set
-      NextTimer2Process = ES_GetMSBitSet(NeedsProcessing);
-      /* decrement that timer, check if timed out */
-      if (--TMR_TimerArray[NextTimer2Process] == 0)
+      NewEvent.EventType = ES_TIMEOUT;
+      do
       {
-        NewEvent.EventType  = ES_TIMEOUT;
-        NewEvent.EventParam = NextTimer2Process;
+        NextTimer2Process = TMR_ListHead;
+        /* take it off the list and stop counting */
+        TMR_ListHead      = TMR_NextTimer[NextTimer2Process];
+        TMR_ActiveFlags   &= ~TIMER_MASK(NextTimer2Process);
         /* post the timeout event to the right Service */
+        NewEvent.EventParam = NextTimer2Process;
         Timer2PostFunc[NextTimer2Process](NewEvent);
-        /* and stop counting */
-        TMR_ActiveFlags &= BitNum2ClrMask[NextTimer2Process];
-      }
-      // mark off the active timer that we just processed
-      NeedsProcessing &= BitNum2ClrMask[NextTimer2Process];
-    } while (NeedsProcessing != 0);
+      } while ((TMR_ListHead != NO_TIMER) &&
+               (TMR_TimerArray[TMR_ListHead] == 0));
+    }
   }
 }
 
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+     InsertTimer
+ Parameters
+     uint8_t Num, the timer to put in the list
+     Timer_t NewTime, the number of ticks until it expires
+ Returns
+     None.
+ Description
+     files the timer in the delta list. Timers that expire on the same tick
+     stay in the order in which they were started.
+ Notes
+     the timer must not already be in the list
+ Author
+     Tianyu, 10/14/26 11:20
+****************************************************************************/
+static void InsertTimer(uint8_t Num, Timer_t NewTime)
+{
+  uint8_t Prev = NO_TIMER;
+  uint8_t Curr = TMR_ListHead;
+
+  // walk past everyone that expires at or before us
+  while ((Curr != NO_TIMER) && (TMR_TimerArray[Curr] <= NewTime))
+  {
+    NewTime -= TMR_TimerArray[Curr];
+    Prev    = Curr;
+    Curr    = TMR_NextTimer[Curr];
+  }
+  TMR_TimerArray[Num] = NewTime;
+  TMR_NextTimer[Num]  = Curr;
+  if (Curr != NO_TIMER)
+  {
+    // the one behind us now counts from our expiration
+    TMR_TimerArray[Curr] -= NewTime;
+  }
+  if (Prev == NO_TIMER)
+  {
+    TMR_ListHead = Num;
+  }
+  else
+  {
+    TMR_NextTimer[Prev] = Num;
+  }
+}
+
+/****************************************************************************
+ Function
+     RemoveTimer
+ Parameters
+     uint8_t Num, the timer to take out of the list
+ Returns
+     Timer_t the number of ticks that the timer had left
+ Description
+     unlinks the timer from the delta list, folding its delta into the timer
+     behind it
+ Notes
+     the timer must be in the list
+ Author
+     Tianyu, 10/14/26 11:20
+****************************************************************************/
+static Timer_t RemoveTimer(uint8_t Num)
+{
+  uint8_t Prev      = NO_TIMER;
+  uint8_t Curr      = TMR_ListHead;
+  Timer_t TimeLeft  = 0;
+
+  while (Curr != Num)
+  {
+    TimeLeft  += TMR_TimerArray[Curr];
+    Prev      = Curr;
+    Curr      = TMR_NextTimer[Curr];
+  }
+  TimeLeft += TMR_TimerArray[Num];
+  if (TMR_NextTimer[Num] != NO_TIMER)
+  {
+    TMR_TimerArray[TMR_NextTimer[Num]] += TMR_TimerArray[Num];
+  }
+  if (Prev == NO_TIMER)
+  {
+    TMR_ListHead = TMR_NextTimer[Num];
+  }
+  else
+  {
+    TMR_NextTimer[Prev] = TMR_NextTimer[Num];
+  }
+  return TimeLeft;
+}
+
 /*------------------------------- Footnotes -------------------------------*/
 /*------------------------------ End of file ------------------------------*/
-
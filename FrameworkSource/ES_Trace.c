@@ -0,0 +1,149 @@
+/****************************************************************************
+ Module
+   ES_Trace.c
+
+ Revision
+   1.0.1
+
+ Description
+   Always-on record of the last ES_TRACE_DEPTH dispatches made by ES_Run:
+   when each event was taken from its queue, which service ran it, the
+   event type & parameter, and how long the run function took. Dumped as
+   a binary frame on a keystroke or from _fassert, so that there is a
+   record of what led up to a failure.
+
+ Notes
+   ES_Trace_Record is only called from ES_Run, so the ring has one writer
+   & needs no critical region. It is a handful of stores, well under a uS,
+   so it can stay in competition builds.
+
+   ES_Trace_Dump reads the ring without stopping the recording. From a run
+   function (the keystroke) nothing can record while it runs. From an
+   assert nothing will again.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 21:20 ty      first pass
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Port.h"
+#include "ES_Trace.h"
+
+#ifdef ES_TRACE_DISPATCH
+
+/*----------------------------- Module Defines ----------------------------*/
+#if (ES_TRACE_DEPTH & (ES_TRACE_DEPTH - 1)) != 0
+#error "ES_TRACE_DEPTH must be a power of 2"
+#endif
+#if ES_TRACE_DEPTH > 255
+#error "ES_TRACE_DEPTH must fit in the 8 bit entry count of a dump"
+#endif
+
+#define TRACE_MASK (ES_TRACE_DEPTH - 1)
+
+// the event type gets 8 bits of an entry
+typedef char ES_CheckTraceEventTypes[(ES_NUM_EVENT_TYPES <= 256) ? 1 : -1];
+
+typedef struct
+{
+  uint32_t Start;
+  uint32_t What;        // Service << 24 | EventType << 16 | EventParam
+  uint32_t RunCycles;
+}TraceEntry_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void PutWord(ES_TracePutByte_t *pPutByte, uint32_t Word);
+
+/*---------------------------- Module Variables ---------------------------*/
+static TraceEntry_t TraceRing[ES_TRACE_DEPTH];
+// free running, the next entry to write is (NumRecorded & TRACE_MASK)
+static uint32_t NumRecorded;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_Trace_Record
+
+ Parameters
+   uint8_t : the service that was run
+   ES_Event_t : the event that it was run with
+   uint32_t : the cycle count when the event was taken from the queue
+   uint32_t : the number of cycles the run function took
+
+ Returns
+   nothing
+
+ Description
+   writes one entry over the oldest in the ring
+ Notes
+   called by ES_Run after every run function, before it checks the result
+   so a failing dispatch is the last entry
+ Author
+   Tianyu, 10/14/26 21:20
+****************************************************************************/
+void ES_Trace_Record(uint8_t WhichService, ES_Event_t ThisEvent,
+    uint32_t DispatchStart, uint32_t RunCycles)
+{
+  TraceEntry_t *pEntry = &TraceRing[NumRecorded & TRACE_MASK];
+
+  pEntry->Start = DispatchStart;
+  pEntry->What = ((uint32_t)WhichService << 24) |
+      ((uint32_t)(ThisEvent.EventType & 0xFF) << 16) | ThisEvent.EventParam;
+  pEntry->RunCycles = RunCycles;
+  NumRecorded++;
+}
+
+/****************************************************************************
+ Function
+   ES_Trace_Dump
+
+ Parameters
+   ES_TracePutByte_t * : where to send the bytes of the frame
+   uint8_t : ES_TRACE_DUMP_KEY, ES_TRACE_DUMP_ASSERT or an application code
+
+ Returns
+   nothing
+
+ Description
+   sends the ring, oldest entry first, as one frame (see ES_Trace.h)
+ Notes
+   the caller makes sure that pPutByte won't drop any of the
+   ES_TRACE_FRAME_BYTES
+ Author
+   Tianyu, 10/14/26 21:20
+****************************************************************************/
+void ES_Trace_Dump(ES_TracePutByte_t *pPutByte, uint8_t Reason)
+{
+  uint32_t Total = NumRecorded;
+  uint8_t  NumEntries = (Total < ES_TRACE_DEPTH) ? (uint8_t)Total :
+      ES_TRACE_DEPTH;
+  uint32_t Index;
+
+  pPutByte(ES_TRACE_FRAME_MARK);
+  PutWord(pPutByte, ((uint32_t)ES_TRACE_FRAME_MARK << 24) |
+      ((uint32_t)NumEntries << 16) | Reason);
+  PutWord(pPutByte, Total);
+  PutWord(pPutByte, _HW_GetCycleCount());
+  for (Index = Total - NumEntries; Index != Total; Index++)
+  {
+    PutWord(pPutByte, TraceRing[Index & TRACE_MASK].Start);
+    PutWord(pPutByte, TraceRing[Index & TRACE_MASK].What);
+    PutWord(pPutByte, TraceRing[Index & TRACE_MASK].RunCycles);
+  }
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+// least significant byte first, like the binlog frames
+static void PutWord(ES_TracePutByte_t *pPutByte, uint32_t Word)
+{
+  pPutByte((uint8_t)Word);
+  pPutByte((uint8_t)(Word >> 8));
+  pPutByte((uint8_t)(Word >> 16));
+  pPutByte((uint8_t)(Word >> 24));
+}
+
+#endif /* ES_TRACE_DISPATCH */
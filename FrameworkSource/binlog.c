@@ -0,0 +1,264 @@
+/****************************************************************************
+ Module
+   binlog.c
+
+ Revision
+   1.0.1
+
+ Description
+   A binary, deferred-format trace logger. The call sites hand over the
+   address of a format string and the raw argument values, the formatting is
+   done on the host by tools/binlog_decode.py using the strings in the .elf
+
+ Notes
+   Record layout in the ring (all 32 bit words):
+     header   : BINLOG_FRAME_MARK<<24 | NumArgs<<16 | sequence number
+     format   : address of the format string (0 for a drop report)
+     time     : core timer count (20MHz) when the record was written
+     args     : NumArgs raw argument values
+
+   On the wire, each record goes out as the single byte BINLOG_FRAME_MARK
+   followed by the words of the record, least significant byte first.
+
+   BinLog_Write may be called from ISRs as well as from the run functions,
+   the reservation is done with interrupts off. Like the rest of the
+   framework, it must not be called from inside a critical region since
+   those can't be nested. If there is not room for the whole record, it is
+   dropped & counted. The next drain sends a drop report so that the gap
+   shows up in the decoded output and the sequence numbers show where.
+
+   BinLog_Drain must only be called from the foreground (ES_Run does this).
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26 23:59 ty      cast the format address through uintptr_t
+ 10/14/26 15:05 ty      first pass
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Port.h"
+#include "terminal.h"
+#include "binlog.h"
+
+#ifdef BINLOG_ENABLED
+
+/*----------------------------- Module Defines ----------------------------*/
+#if (BINLOG_RING_WORDS & (BINLOG_RING_WORDS - 1)) != 0
+#error "BINLOG_RING_WORDS must be a power of 2"
+#endif
+
+#define RING_MASK (BINLOG_RING_WORDS - 1)
+
+// header, format & time stamp
+#define RECORD_OVERHEAD_WORDS 3
+
+#define HEADER_NUM_ARGS(Header) (((Header) >> 16) & 0x07)
+
+// keep the compiler from moving the record stores past the index update
+#define BINLOG_BARRIER() __asm__ volatile ("" ::: "memory")
+
+/*---------------------------- Module Functions ---------------------------*/
+static bool SendDropReport(void);
+static void SendWord(uint32_t Word);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint32_t BinLogRing[BINLOG_RING_WORDS];
+// free running word indices, the ring index is (Index & RING_MASK)
+static volatile uint16_t RingHead; // next word to write, owned by writers
+static volatile uint16_t RingTail; // next word to drain, owned by BinLog_Drain
+static uint16_t SequenceNum;
+
+static volatile uint32_t DropCount;
+static uint32_t ReportedDropCount;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   BinLog_Write
+
+ Parameters
+   const char * the DB_printf style format string, must be a constant
+   uint8_t the number of arguments that follow that are used (0-4)
+   uint32_t x 4 the raw argument values
+
+ Returns
+   nothing
+
+ Description
+   copies one record into the ring, or counts it as dropped if it won't fit
+ Notes
+   normally called through the BINLOGn() macros
+ Author
+   Tianyu, 10/14/26 15:05
+****************************************************************************/
+void BinLog_Write(const char *pFormat, uint8_t NumArgs, uint32_t Arg0,
+    uint32_t Arg1, uint32_t Arg2, uint32_t Arg3)
+{
+  uint32_t  TimeStamp;
+  uint16_t  Head;
+  uint8_t   RecordWords;
+
+  if (NumArgs > BINLOG_MAX_ARGS)
+  {
+    NumArgs = BINLOG_MAX_ARGS;
+  }
+  RecordWords = RECORD_OVERHEAD_WORDS + NumArgs;
+
+  EnterCritical();
+  Head = RingHead;
+  if ((uint16_t)(BINLOG_RING_WORDS - (uint16_t)(Head - RingTail)) < RecordWords)
+  {
+    DropCount++;
+    ExitCritical();
+    return;
+  }
+  TimeStamp = _HW_GetCycleCount();
+  BinLogRing[Head++ & RING_MASK] = ((uint32_t)BINLOG_FRAME_MARK << 24) |
+      ((uint32_t)NumArgs << 16) | SequenceNum++;
+  // the whole address on the PIC32, its low 32 bits on a 64 bit host
+  BinLogRing[Head++ & RING_MASK] = (uint32_t)(uintptr_t)pFormat;
+  BinLogRing[Head++ & RING_MASK] = TimeStamp;
+  // fall through to copy only as many arguments as were used
+  switch (NumArgs)
+  {
+    case 4:
+      BinLogRing[(Head + 3) & RING_MASK] = Arg3;
+    case 3:
+      BinLogRing[(Head + 2) & RING_MASK] = Arg2;
+    case 2:
+      BinLogRing[(Head + 1) & RING_MASK] = Arg1;
+    case 1:
+      BinLogRing[Head & RING_MASK] = Arg0;
+    default:
+      break;
+  }
+  BINLOG_BARRIER();
+  RingHead = Head + NumArgs;
+  ExitCritical();
+}
+
+/****************************************************************************
+ Function
+   BinLog_Drain
+
+ Parameters
+   nothing
+
+ Returns
+   nothing
+
+ Description
+   moves as many whole records as will fit into the terminal transmit buffer
+ Notes
+   never splits a frame and never waits for room in the transmit buffer
+ Author
+   Tianyu, 10/14/26 15:05
+****************************************************************************/
+void BinLog_Drain(void)
+{
+  uint16_t  Tail;
+  uint32_t  Header;
+  uint8_t   RecordWords;
+  uint8_t   i;
+
+  // let the host know about any gap before sending what came after it
+  if ((DropCount != ReportedDropCount) && !SendDropReport())
+  {
+    return;
+  }
+
+  Tail = RingTail;
+  while (Tail != RingHead)
+  {
+    BINLOG_BARRIER();
+    Header = BinLogRing[Tail & RING_MASK];
+    RecordWords = RECORD_OVERHEAD_WORDS + HEADER_NUM_ARGS(Header);
+    if (Terminal_GetXmitSpace() < (1 + (sizeof(uint32_t) * RecordWords)))
+    {
+      break;  // try again on the next pass through the idle loop
+    }
+    Terminal_WriteByte(BINLOG_FRAME_MARK);
+    for (i = 0; i < RecordWords; i++)
+    {
+      SendWord(BinLogRing[(Tail + i) & RING_MASK]);
+    }
+    Tail += RecordWords;
+    BINLOG_BARRIER();
+    RingTail = Tail;  // hand the space back to the writers
+  }
+}
+
+/****************************************************************************
+ Function
+   BinLog_IsEmpty
+
+ Parameters
+   nothing
+
+ Returns
+   bool true if there is nothing waiting to be drained
+
+ Description
+   lets the idle code know that it would be holding up the log if it slept
+ Author
+   Tianyu, 10/14/26 15:05
+****************************************************************************/
+bool BinLog_IsEmpty(void)
+{
+  return (RingHead == RingTail) && (DropCount == ReportedDropCount);
+}
+
+/****************************************************************************
+ Function
+   BinLog_GetDropCount
+
+ Parameters
+   nothing
+
+ Returns
+   uint32_t the number of records that found the ring full since reset
+
+ Description
+   a non-zero count means BINLOG_RING_WORDS is too small for the logging rate
+ Author
+   Tianyu, 10/14/26 15:05
+****************************************************************************/
+uint32_t BinLog_GetDropCount(void)
+{
+  return DropCount;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+// a drop report is a record with a null format & the running drop count as
+// its only argument. It does not go through the ring, since the ring is
+// probably what was full
+static bool SendDropReport(void)
+{
+  uint32_t Drops = DropCount;
+
+  if (Terminal_GetXmitSpace() <
+      (1 + (sizeof(uint32_t) * (RECORD_OVERHEAD_WORDS + 1))))
+  {
+    return false;
+  }
+  Terminal_WriteByte(BINLOG_FRAME_MARK);
+  // sequence number of 0xFFFF is never checked by the decoder for reports
+  SendWord(((uint32_t)BINLOG_FRAME_MARK << 24) | (1UL << 16) | 0xFFFF);
+  SendWord(0);
+  SendWord(_HW_GetCycleCount());
+  SendWord(Drops);
+  ReportedDropCount = Drops;
+  return true;
+}
+
+static void SendWord(uint32_t Word)
+{
+  Terminal_WriteByte((uint8_t)Word);
+  Terminal_WriteByte((uint8_t)(Word >> 8));
+  Terminal_WriteByte((uint8_t)(Word >> 16));
+  Terminal_WriteByte((uint8_t)(Word >> 24));
+}
+
+#endif /* BINLOG_ENABLED */
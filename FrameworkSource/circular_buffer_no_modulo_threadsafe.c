@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 #include <assert.h>
 
 #include "circular_buffer.h"
@@ -14,8 +15,9 @@
 // The definition of our circular buffer structure is hidden from the user
 struct circular_buf_t {
   uint8_t * buffer;
-	size_t head;
-	size_t tail;
+	// volatile as each is moved by one side & read by the other
+	volatile size_t head;
+	volatile size_t tail;
 	size_t max; //of the buffer
 };
 
@@ -37,20 +39,18 @@ static void advance_pointer(cbuf_handle_t cbuf)
     }
   }
 
-  if(++(cbuf->head) == cbuf->max)
-	{
-		cbuf->head = 0;
-	}
+  // one store, of a value that is already wrapped, so that the consumer
+  // never sees head == max
+  cbuf->head = ((cbuf->head + 1) == cbuf->max) ? 0 : (cbuf->head + 1);
 }
 
 static void retreat_pointer(cbuf_handle_t cbuf)
 {
 	assert(cbuf);
 
-	if(++(cbuf->tail) == cbuf->max)
-	{
-		cbuf->tail = 0;
-	}
+	// one store, of a value that is already wrapped, so that the producer
+	// never sees tail == max
+	cbuf->tail = ((cbuf->tail + 1) == cbuf->max) ? 0 : (cbuf->tail + 1);
 }
 
 #pragma mark - APIs -
@@ -64,9 +64,15 @@ cbuf_handle_t circular_buf_init(uint8_t* buffer, size_t size)
   // so we'll use an array of structures and make sure that we don't allocate
   // more than we have room for.
   
-	cbuf_handle_t cbuf = &frameworkCircularBuffers[numBuffersAllocated];
+	cbuf_handle_t cbuf;
+
+  // assert is compiled out here, so this has to be a real test
+  if(numBuffersAllocated >= MAX_CIRC_BUFFERS)
+  {
+    return NULL;
+  }
+	cbuf = &frameworkCircularBuffers[numBuffersAllocated];
   numBuffersAllocated++;
-	assert(MAX_CIRC_BUFFERS >= numBuffersAllocated);
 
 	cbuf->buffer = buffer;
 	cbuf->max = size;
@@ -98,22 +104,16 @@ size_t circular_buf_size(cbuf_handle_t cbuf)
 {
 	assert(cbuf);
 
-	size_t size = cbuf->max;
+	// read each once, the other side may be moving one of them. A full
+	// buffer holds max - 1, which this gives without a special case
+	size_t head = cbuf->head;
+	size_t tail = cbuf->tail;
 
-	if(!circular_buf_full(cbuf))
+	if(head >= tail)
 	{
-		if(cbuf->head >= cbuf->tail)
-		{
-			size = (cbuf->head - cbuf->tail);
-		}
-		else
-		{
-			size = (cbuf->max + cbuf->head - cbuf->tail);
-		}
-
+		return (head - tail);
 	}
-
-	return size;
+	return (cbuf->max + head - tail);
 }
 
 size_t circular_buf_capacity(cbuf_handle_t cbuf)
@@ -182,4 +182,128 @@ bool circular_buf_full(circular_buf_t* cbuf)
 	}
 
 	return head == cbuf->tail;
-}
\ No newline at end of file
+}
+
+size_t circular_buf_peek_linear(cbuf_handle_t cbuf, uint8_t ** pData)
+{
+  return circular_buf_peek(cbuf, 0, pData);
+}
+
+size_t circular_buf_peek(cbuf_handle_t cbuf, size_t offset, uint8_t ** pData)
+{
+  size_t head;
+  size_t start;
+
+  assert(cbuf && pData && cbuf->buffer);
+
+  head = cbuf->head;
+  start = cbuf->tail + offset;
+  if(start >= cbuf->max)
+  {
+    start -= cbuf->max;
+  }
+  *pData = &cbuf->buffer[start];
+  if(offset >= circular_buf_size(cbuf))
+  {
+    return 0;
+  }
+  // the readable bytes stop at head, or at the end of the storage if the
+  // data wraps around
+  if(head >= start)
+  {
+    return head - start;
+  }
+  return cbuf->max - start;
+}
+
+void circular_buf_advance_tail(cbuf_handle_t cbuf, size_t len)
+{
+  size_t tail;
+
+  assert(cbuf && (len <= circular_buf_size(cbuf)));
+
+  // work it out before storing it, the producer must never see tail == max
+  tail = cbuf->tail + len;
+  if(tail >= cbuf->max)
+  {
+    tail -= cbuf->max;
+  }
+  cbuf->tail = tail;
+}
+
+size_t circular_buf_space_linear(cbuf_handle_t cbuf, uint8_t ** pSpace)
+{
+  size_t head;
+  size_t tail;
+
+  assert(cbuf && pSpace && cbuf->buffer);
+
+  head = cbuf->head;
+  tail = cbuf->tail;
+  *pSpace = &cbuf->buffer[head];
+  // the free bytes stop one short of tail, or at the end of the storage
+  if(tail > head)
+  {
+    return tail - head - 1;
+  }
+  // with tail at 0 the last slot has to stay open
+  return cbuf->max - head - ((tail == 0) ? 1 : 0);
+}
+
+void circular_buf_advance_head(cbuf_handle_t cbuf, size_t len)
+{
+  size_t head;
+
+  assert(cbuf && (len <= (cbuf->max - 1 - circular_buf_size(cbuf))));
+
+  head = cbuf->head + len;
+  if(head >= cbuf->max)
+  {
+    head -= cbuf->max;
+  }
+  cbuf->head = head;
+}
+
+size_t circular_buf_put_n(cbuf_handle_t cbuf, const uint8_t * data, size_t len)
+{
+  size_t done = 0;
+  size_t chunk;
+  uint8_t * pSpace;
+
+  assert(cbuf && (data || (len == 0)));
+
+  // at most two spans, up to the end of the storage then from the start
+  while((done < len) &&
+        ((chunk = circular_buf_space_linear(cbuf, &pSpace)) != 0))
+  {
+    if(chunk > (len - done))
+    {
+      chunk = len - done;
+    }
+    memcpy(pSpace, &data[done], chunk);
+    circular_buf_advance_head(cbuf, chunk);
+    done += chunk;
+  }
+  return done;
+}
+
+size_t circular_buf_get_n(cbuf_handle_t cbuf, uint8_t * data, size_t len)
+{
+  size_t done = 0;
+  size_t chunk;
+  uint8_t * pData;
+
+  assert(cbuf && (data || (len == 0)));
+
+  while((done < len) && ((chunk = circular_buf_peek_linear(cbuf, &pData)) != 0))
+  {
+    if(chunk > (len - done))
+    {
+      chunk = len - done;
+    }
+    memcpy(&data[done], pData, chunk);
+    circular_buf_advance_tail(cbuf, chunk);
+    done += chunk;
+  }
+  return done;
+}
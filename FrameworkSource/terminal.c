@@ -17,34 +17,91 @@
  -------------- ---     --------
  08/29/20 14:46 ram     first pass
  10/05/20 19:38 ram     starting work on PIC32 port
+ 10/14/26 12:30 ty      added Terminal_IsXmitBufferEmpty for the tickless idle
+ 10/14/26 13:40 ty      added the DMA transmit mode, overflow count &
+                        backpressure when the transmit buffer is full
+ 10/14/26 15:05 ty      added Terminal_GetXmitSpace for the binary logger
+ 10/14/26 21:20 ty      _fassert dumps the dispatch trace (ES_TRACE_DISPATCH)
+ 10/14/26 21:40 ty      the FIFO is filled from the buffer a span at a time
+ 10/14/26 21:50 ty      receive interrupt & buffer (USE_UART_RX_ISR), the
+                        receive overruns are counted
+ 10/14/26 22:10 ty      the baud rate is worked out from the PBCLK & can be
+                        changed at run time, added the auto-baud
  ***************************************************************************/
 
 /*----------------------------- Include Files -----------------------------*/
 
 // Hardware
 #include <xc.h>
+#include <sys/kmem.h>   // for KVA_TO_PA
+#include <sys/attribs.h> // for the ISR macros
 #include <stdio.h>
 
 #include "ES_General.h"
 #include "ES_Port.h"
 #include "circular_buffer.h"
 #include "dbprintf.h"
+#include "ES_Trace.h"
+#include "ES_IsrStats.h"
 
 //this module
 #include "terminal.h"
 /*----------------------------- Module Defines ----------------------------*/
-#define BAUD_CONST 42 // sets up baud rate for 115200
-//#define BAUD_CONST 21 // sets up baud rate for 230400
+// with BRGH set the UART bit clock is PBCLK / (4 * (U1BRG + 1))
+#define BRG_DIVIDER 4
+
+// the rate Terminal_HWInit starts with is checked here rather than at run time
+#define DEFAULT_BRG_PLUS_1 ((TERMINAL_PBCLK_HZ + \
+    (BRG_DIVIDER / 2) * TERMINAL_DEFAULT_BAUD) / \
+    (BRG_DIVIDER * TERMINAL_DEFAULT_BAUD))
+#define DEFAULT_ACTUAL_BAUD \
+    (TERMINAL_PBCLK_HZ / (BRG_DIVIDER * DEFAULT_BRG_PLUS_1))
+#if (DEFAULT_BRG_PLUS_1 < 1) || (DEFAULT_BRG_PLUS_1 > 0x10000) || \
+    (DEFAULT_ACTUAL_BAUD * 1000 > \
+        TERMINAL_DEFAULT_BAUD * (1000 + TERMINAL_BAUD_TOLERANCE)) || \
+    (DEFAULT_ACTUAL_BAUD * 1000 < \
+        TERMINAL_DEFAULT_BAUD * (1000 - TERMINAL_BAUD_TOLERANCE))
+#error "TERMINAL_DEFAULT_BAUD can't be made from TERMINAL_PBCLK_HZ"
+#endif
 
 /*---------------------------- Module Functions ---------------------------*/
 /* prototypes for private functions for this service.They should be functions
    relevant to the behavior of this service
 */
+static void PutXmitByte(uint8_t txByte);
+static bool BaudToBRG(uint32_t baud, uint16_t *pBRG);
+#ifdef ES_TRACE_DISPATCH
+static void PutBytePolled(uint8_t txByte);
+#endif
+#ifdef TERMINAL_DMA_TX
+static void InitXmitDMA(void);
+#endif
 
 /*---------------------------- Module Variables ---------------------------*/
 static uint8_t xmitBuffer[XMIT_BUFFER_SIZE];
 static cbuf_handle_t xmitBufferHandle;
 
+#ifdef USE_UART_RX_ISR
+static uint8_t recvBuffer[RECV_BUFFER_SIZE];
+static cbuf_handle_t recvBufferHandle;
+static Terminal_RxNotify_t pRxNotify;
+#endif
+
+// bytes lost on the way in: hardware FIFO overruns, framing errors and, with
+// the receive ISR, bytes that found the receive buffer full
+static volatile uint32_t recvOverrunCount;
+
+// number of times a byte found the transmit buffer full. With
+// TERMINAL_TX_BACKPRESSURE these were waited out, otherwise each one cost
+// the oldest byte in the buffer
+static uint32_t xmitOverflowCount;
+
+#ifdef TERMINAL_DMA_TX
+// bytes handed to the DMA that are still sitting in the circular buffer,
+// they are taken out once the block transfer completes
+static size_t bytesInFlight;
+#endif
+
 /*------------------------------ Module Code ------------------------------*/
 /*******************************************************************************
  * Function: TerminalInit
@@ -90,8 +147,8 @@ void Terminal_HWInit(void)
   U1MODEbits.BRGH = 1;
   // Diable TX inversion, everything else we don't care about
   U1STA = 0;
-  // Set the baud rate based on the constant
-  U1BRG = BAUD_CONST;
+  // Set the baud rate from the default
+  U1BRG = DEFAULT_BRG_PLUS_1 - 1;
   
   // redirect printf to UART1 using X32 built in cross over
   __XC_UART = 1; 
@@ -103,6 +160,24 @@ void Terminal_HWInit(void)
   
   // now initialize the circular buffer for transmitting
   xmitBufferHandle = circular_buf_init( xmitBuffer, ARRAY_SIZE(xmitBuffer) );
+
+#ifdef USE_UART_RX_ISR
+  // and the one for receiving, filled by Terminal_RxISR. U1STA = 0 above
+  // left URXISEL at 00, an interrupt as each byte arrives
+  recvBufferHandle = circular_buf_init( recvBuffer, ARRAY_SIZE(recvBuffer) );
+  IPC8bits.U1IP = TERMINAL_RX_PRIORITY;
+  IPC8bits.U1IS = 0;
+  IFS1CLR = _IFS1_U1RXIF_MASK | _IFS1_U1EIF_MASK;
+  IEC1SET = _IEC1_U1RXIE_MASK | _IEC1_U1EIE_MASK;
+#endif
+
+#ifdef TERMINAL_DMA_TX
+  InitXmitDMA();
+#endif
+
+#ifdef TERMINAL_AUTOBAUD
+  Terminal_StartAutoBaud();
+#endif
   
   return;
 }
@@ -116,13 +191,50 @@ void Terminal_HWInit(void)
  ******************************************************************************/
 uint8_t Terminal_ReadByte(void)
 {
+#ifdef USE_UART_RX_ISR
+  uint8_t rxByte;
+
+  // wait for the ISR to bring something in
+  while(circular_buf_get(recvBufferHandle, &rxByte) != 0)
+  {}
+  return rxByte;
+#else
   // wait for there to be something
   while(!(U1STAbits.URXDA))
   {}
-  // if there was an overrun, clear it to reset the unit
-  if(U1STAbits.OERR) U1STAbits.OERR = 0;
+  // if there was an overrun, clear it to reset the unit. The bytes that
+  // didn't fit in the FIFO are gone, count them
+  if(U1STAbits.OERR)
+  {
+    recvOverrunCount++;
+    U1STAbits.OERR = 0;
+  }
   // return the content of the receive register
   return U1RXREG;
+#endif
+}
+
+/*******************************************************************************
+ * Function: Terminal_ReadBytes
+ * Arguments: where to put the bytes, the most to take
+ * Returns the number of bytes taken, 0 if there were none waiting
+ * 
+ * Created by: Tianyu, 10/14/26 21:50
+ * Description: takes whatever has come in, up to maxBytes, without waiting
+ ******************************************************************************/
+size_t Terminal_ReadBytes(uint8_t *pDest, size_t maxBytes)
+{
+#ifdef USE_UART_RX_ISR
+  return circular_buf_get_n(recvBufferHandle, pDest, maxBytes);
+#else
+  size_t numRead = 0;
+
+  while((numRead < maxBytes) && Terminal_IsRxData())
+  {
+    pDest[numRead++] = Terminal_ReadByte();
+  }
+  return numRead;
+#endif
 }
 /*******************************************************************************
  * Function: Terminal_Write
@@ -141,7 +253,7 @@ void Terminal_WriteByte(uint8_t txByte)
   // write the byte to the register
   U1TXREG = txByte;
 #else
-  circular_buf_put(xmitBufferHandle, txByte);
+  PutXmitByte(txByte);
 #endif  
   return;
 }
@@ -156,13 +268,17 @@ void Terminal_WriteByte(uint8_t txByte)
  ******************************************************************************/
 bool Terminal_IsRxData(void)
 {
-  
+#ifdef USE_UART_RX_ISR
+    return !circular_buf_empty(recvBufferHandle);
+#else
     if(U1STAbits.FERR != 0 ){
         U1RXREG; // in case of a framing error, read the data reg to clear err
+        recvOverrunCount++;
         return false;
     }
     // Return Rx Data bit from status register
     return U1STAbits.URXDA;
+#endif
 }
 
 /*******************************************************************************
@@ -177,7 +293,7 @@ bool Terminal_IsRxData(void)
  ******************************************************************************/
 void _mon_putc (char c)
 {
-  circular_buf_put(xmitBufferHandle, c);
+  PutXmitByte(c);
 }
 
 /*******************************************************************************
@@ -190,17 +306,267 @@ void _mon_putc (char c)
  *              circular buffer and stuffs them into the UART1 buffer
  *              until we either run out of bytes in the circular buffer
  *              or we run out of space in the UART FIFO
+ *              In the DMA mode, it instead checks if the last block has
+ *              gone out and, if so, hands the next contiguous run of bytes
+ *              in the circular buffer to the DMA channel.
  ******************************************************************************/
 void Terminal_MoveBuffer2UART( void )
 {
-  while ( (!circular_buf_empty(xmitBufferHandle)) && (!U1STAbits.UTXBF))
+#ifdef TERMINAL_DMA_TX
+  uint8_t *pNextBlock;
+  size_t  blockSize;
+
+  if (bytesInFlight != 0)
+  {
+    // the channel turns itself off at the end of the block
+    if (DCH0CONbits.CHEN)
+    {
+      return;
+    }
+    circular_buf_advance_tail(xmitBufferHandle, bytesInFlight);
+    bytesInFlight = 0;
+  }
+  blockSize = circular_buf_peek_linear(xmitBufferHandle, &pNextBlock);
+  if (blockSize != 0)
+  {
+    DCH0INTCLR  = 0x00FF00FF;       // clear the flags from the last block
+    DCH0SSA     = KVA_TO_PA(pNextBlock);
+    DCH0SSIZ    = blockSize;
+    bytesInFlight = blockSize;
+    DCH0CONbits.CHEN    = 1;
+    // the UART only raises a TX event as a byte leaves the FIFO, so force
+    // the first transfer to get things going
+    DCH0ECONbits.CFORCE = 1;
+  }
+#else
+  uint8_t *pNextBlock;
+  size_t  blockSize;
+  size_t  sent;
+
+  // straight from the buffer storage, a span at a time, rather than a
+  // circular_buf_get per byte
+  while ( (!U1STAbits.UTXBF) &&
+          ((blockSize = circular_buf_peek_linear(xmitBufferHandle,
+                                                 &pNextBlock)) != 0))
+  {
+    for (sent = 0; (sent < blockSize) && (!U1STAbits.UTXBF); sent++)
+    {
+      U1TXREG = pNextBlock[sent];
+    }
+    circular_buf_advance_tail(xmitBufferHandle, sent);
+  }
+#endif
+}
+
+/*******************************************************************************
+ * Function: Terminal_IsXmitBufferEmpty
+ * Arguments: none
+ * Returns true if there are no bytes waiting to be moved to the UART
+ * 
+ * Created by: Tianyu, 10/14/26 12:30
+ * Description: lets the idle code know that it would be holding up output if
+ *              it stopped calling Terminal_MoveBuffer2UART
+ ******************************************************************************/
+bool Terminal_IsXmitBufferEmpty( void )
+{
+  return circular_buf_empty(xmitBufferHandle);
+}
+
+/*******************************************************************************
+ * Function: Terminal_GetXmitOverflowCount
+ * Arguments: none
+ * Returns the number of times that a byte found the transmit buffer full
+ * 
+ * Created by: Tianyu, 10/14/26 13:40
+ * Description: a non-zero count means the buffer is too small for the amount
+ *              of printing being done. With TERMINAL_TX_BACKPRESSURE each one
+ *              cost a wait, otherwise each one cost a byte of output.
+ ******************************************************************************/
+uint32_t Terminal_GetXmitOverflowCount( void )
+{
+  return xmitOverflowCount;
+}
+
+/*******************************************************************************
+ * Function: Terminal_GetXmitSpace
+ * Arguments: none
+ * Returns the number of bytes that can be written before the buffer is full
+ * 
+ * Created by: Tianyu, 10/14/26 15:05
+ * Description: lets a writer that must not block (or split a frame) check for
+ *              room before it starts writing
+ ******************************************************************************/
+size_t Terminal_GetXmitSpace( void )
+{
+  // the circular buffer always keeps one slot open to tell full from empty
+  return (circular_buf_capacity(xmitBufferHandle) - 1) -
+      circular_buf_size(xmitBufferHandle);
+}
+
+/*******************************************************************************
+ * Function: Terminal_GetRecvOverrunCount
+ * Arguments: none
+ * Returns the number of received bytes that were lost
+ *
+ * Created by: Tianyu, 10/14/26 21:50
+ * Description: counts hardware FIFO overruns, framing errors and, with the
+ *              receive ISR, bytes that found the receive buffer full. An
+ *              overrun loses an unknown number of bytes but counts 1
+ ******************************************************************************/
+uint32_t Terminal_GetRecvOverrunCount( void )
+{
+  return recvOverrunCount;
+}
+
+/*******************************************************************************
+ * Function: Terminal_IsBaudSupported
+ * Arguments: the baud rate
+ * Returns true if U1BRG can be set to within TERMINAL_BAUD_TOLERANCE of it
+ *
+ * Created by: Tianyu, 10/14/26 22:10
+ * Description: lets a caller check a rate before it says that it will change
+ ******************************************************************************/
+bool Terminal_IsBaudSupported(uint32_t baud)
+{
+  uint16_t brg;
+
+  return BaudToBRG(baud, &brg);
+}
+
+/*******************************************************************************
+ * Function: Terminal_SetBaud
+ * Arguments: the new baud rate
+ * Returns false, with the rate unchanged, if it can't be made
+ *
+ * Created by: Tianyu, 10/14/26 22:10
+ * Description: lets everything already in the transmit buffer go out at the
+ *              old rate, then changes U1BRG. Waits for the buffer to drain,
+ *              which at 115200 is up to XMIT_BUFFER_SIZE * 87uS
+ ******************************************************************************/
+bool Terminal_SetBaud(uint32_t baud)
+{
+  uint16_t brg;
+
+  if (!BaudToBRG(baud, &brg))
+  {
+    return false;
+  }
+  while (!Terminal_IsXmitBufferEmpty())
   {
-    uint8_t byte2Xmit;
-    circular_buf_get(xmitBufferHandle, &byte2Xmit);
-    U1TXREG = byte2Xmit;
+    Terminal_MoveBuffer2UART();
   }
+  // and for the last byte to leave the shift register
+  while (!U1STAbits.TRMT)
+  {}
+  U1BRG = brg;
+  return true;
 }
 
+/*******************************************************************************
+ * Function: Terminal_GetBaud
+ * Arguments: none
+ * Returns the baud rate that U1BRG gives
+ *
+ * Created by: Tianyu, 10/14/26 22:10
+ * Description: the actual rate, not the one asked for. After the auto-baud
+ *              it is the rate that was measured
+ ******************************************************************************/
+uint32_t Terminal_GetBaud(void)
+{
+  return TERMINAL_PBCLK_HZ / (BRG_DIVIDER * ((uint32_t)U1BRG + 1));
+}
+
+/*******************************************************************************
+ * Function: Terminal_StartAutoBaud
+ * Arguments: none
+ * Returns nothing
+ *
+ * Created by: Tianyu, 10/14/26 22:10
+ * Description: has the UART measure the next byte that comes in, which must
+ *              be 'U' (0x55), & set U1BRG from it. Output still goes at the
+ *              old rate in the meantime, so the other end should stop
+ *              listening until it has sent the 'U'
+ ******************************************************************************/
+void Terminal_StartAutoBaud(void)
+{
+  U1MODEbits.ABAUD = 1;
+}
+
+/*******************************************************************************
+ * Function: Terminal_IsAutoBaudDone
+ * Arguments: none
+ * Returns true once the 'U' has been measured, or if none was asked for
+ *
+ * Created by: Tianyu, 10/14/26 22:10
+ * Description: the UART clears ABAUD when it has set U1BRG
+ ******************************************************************************/
+bool Terminal_IsAutoBaudDone(void)
+{
+  return (U1MODEbits.ABAUD == 0);
+}
+
+#ifdef USE_UART_RX_ISR
+/*******************************************************************************
+ * Function: Terminal_SetRxNotify
+ * Arguments: function to call, NULL for none
+ * Returns nothing
+ *
+ * Created by: Tianyu, 10/14/26 21:50
+ * Description: the function is called from Terminal_RxISR, at
+ *              TERMINAL_RX_PRIORITY, each time it has put new bytes in the
+ *              receive buffer. It should do no more than post an event
+ ******************************************************************************/
+void Terminal_SetRxNotify(Terminal_RxNotify_t pNotify)
+{
+  pRxNotify = pNotify;
+}
+
+/*******************************************************************************
+ * Function: Terminal_RxISR
+ * Arguments: none
+ * Returns nothing
+ *
+ * Created by: Tianyu, 10/14/26 21:50
+ * Description: empties the UART1 receive FIFO into the receive buffer.
+ *              Bytes with a framing error are dropped. The FIFO is emptied
+ *              before an overrun is cleared, as clearing OERR also empties
+ *              it. The transmit flag is left alone, the DMA may be using it
+ ******************************************************************************/
+void __ISR(_UART_1_VECTOR, IPL2SOFT) Terminal_RxISR(void)
+{
+  bool newBytes = false;
+
+  ES_IsrStats_Enter(ES_ISR(UARTRx), ES_ISR_LATENCY_UNKNOWN);
+  while(U1STAbits.URXDA)
+  {
+    // FERR is for the byte at the top of the FIFO, read it first
+    bool framingError = (U1STAbits.FERR != 0);
+    uint8_t rxByte = (uint8_t)U1RXREG;
+
+    if (framingError || (circular_buf_put2(recvBufferHandle, rxByte) != 0))
+    {
+      recvOverrunCount++;
+    }
+    else
+    {
+      newBytes = true;
+    }
+  }
+  if(U1STAbits.OERR)
+  {
+    recvOverrunCount++;
+    U1STACLR = _U1STA_OERR_MASK;
+  }
+  IFS1CLR = _IFS1_U1RXIF_MASK | _IFS1_U1EIF_MASK;
+
+  if (newBytes && (NULL != pRxNotify))
+  {
+    pRxNotify();
+  }
+  ES_IsrStats_Exit(ES_ISR(UARTRx));
+}
+#endif
+
 void __attribute__((noreturn)) _fassert(int nLineNumber,
                                         const char * sFileName,
                                         const char * sFailedExpression,
@@ -208,6 +574,15 @@ void __attribute__((noreturn)) _fassert(int nLineNumber,
 {
   DB_printf("Assert \"%s\" Failed at Line: %d, in File: %s \n\r", 
             sFailedExpression, nLineNumber, sFileName, sFunction);
+#ifdef ES_TRACE_DISPATCH
+    // get the message out ahead of the trace, then send the trace straight
+    // to the UART, it may not fit in what is left of the buffer
+    while (!Terminal_IsXmitBufferEmpty())
+    {
+        Terminal_MoveBuffer2UART();
+    }
+    ES_Trace_Dump(PutBytePolled, ES_TRACE_DUMP_ASSERT);
+#endif
     // now pump the bytes out of the buffer into the UART
     while(1) 
     {
@@ -217,6 +592,118 @@ void __attribute__((noreturn)) _fassert(int nLineNumber,
 /***************************************************************************
  private functions
  ***************************************************************************/
+/*******************************************************************************
+ * Function: BaudToBRG
+ * Arguments: the baud rate, where to put the U1BRG value for it
+ * Returns false if the nearest U1BRG is more than TERMINAL_BAUD_TOLERANCE out
+ *
+ * Created by: Tianyu, 10/14/26 22:10
+ * Description: rounds to the nearest divider rather than down, it is the
+ *              error either side that matters to the receiver
+ ******************************************************************************/
+static bool BaudToBRG(uint32_t baud, uint16_t *pBRG)
+{
+  uint32_t divider;
+  uint32_t actual;
+  uint32_t error;
+
+  if ((baud == 0) || (baud > TERMINAL_PBCLK_HZ / BRG_DIVIDER))
+  {
+    return false;
+  }
+  divider = (TERMINAL_PBCLK_HZ + (BRG_DIVIDER / 2) * baud) /
+      (BRG_DIVIDER * baud);
+  if (divider > 0x10000)
+  {
+    return false;
+  }
+  actual = TERMINAL_PBCLK_HZ / (BRG_DIVIDER * divider);
+  error = (actual > baud) ? (actual - baud) : (baud - actual);
+  if ((uint64_t)error * 1000 > (uint64_t)baud * TERMINAL_BAUD_TOLERANCE)
+  {
+    return false;
+  }
+  *pBRG = (uint16_t)(divider - 1);
+  return true;
+}
+
+/*******************************************************************************
+ * Function: PutXmitByte
+ * Arguments: byte to put in the transmit buffer
+ * Returns nothing
+ * 
+ * Created by: Tianyu, 10/14/26 13:40
+ * Description: common path for printf & Terminal_WriteByte into the transmit
+ *              buffer. Counts the overflows and, with backpressure, keeps
+ *              the UART going until there is room.
+ ******************************************************************************/
+static void PutXmitByte(uint8_t txByte)
+{
+  if (circular_buf_full(xmitBufferHandle))
+  {
+    xmitOverflowCount++;
+#ifdef TERMINAL_TX_BACKPRESSURE
+    do
+    {
+      Terminal_MoveBuffer2UART();
+    } while (circular_buf_full(xmitBufferHandle));
+#elif defined(TERMINAL_DMA_TX)
+    // the oldest bytes may be in the middle of a DMA transfer, so drop the
+    // new one rather than overwrite them
+    return;
+#endif
+  }
+  circular_buf_put(xmitBufferHandle, txByte);
+#ifdef TERMINAL_DMA_TX
+  // if the channel is idle, start it on what we have so far
+  Terminal_MoveBuffer2UART();
+#endif
+}
+
+#ifdef ES_TRACE_DISPATCH
+/*******************************************************************************
+ * Function: PutBytePolled
+ * Arguments: byte to send
+ * Returns nothing
+ *
+ * Created by: Tianyu, 10/14/26 21:20
+ * Description: waits for room in the UART FIFO and writes the byte, for the
+ *              trace dump from _fassert once the buffer has been drained
+ ******************************************************************************/
+static void PutBytePolled(uint8_t txByte)
+{
+  while(U1STAbits.UTXBF)
+  {}
+  U1TXREG = txByte;
+}
+#endif
+
+#ifdef TERMINAL_DMA_TX
+/*******************************************************************************
+ * Function: InitXmitDMA
+ * Arguments: None
+ * Returns nothing
+ * 
+ * Created by: Tianyu, 10/14/26 13:40
+ * Description: sets up DMA channel 0 to move 1 byte into U1TXREG each time the
+ *              UART1 TX event fires (UTXISEL = 00, space in the TX FIFO). The
+ *              source address and size are set for each block as it starts.
+ ******************************************************************************/
+static void InitXmitDMA(void)
+{
+  DMACONbits.ON         = 1;    // turn on the DMA controller
+  DCH0CON               = 0;    // channel off, priority 0, no auto-enable
+  DCH0ECON              = 0;
+  DCH0ECONbits.CHSIRQ   = _UART1_TX_IRQ;  // start a cell on UART1 TX
+  DCH0ECONbits.SIRQEN   = 1;
+  DCH0DSA               = KVA_TO_PA(&U1TXREG);
+  DCH0DSIZ              = 1;
+  DCH0CSIZ              = 1;    // 1 byte per TX event
+  DCH0INTCLR            = 0x00FF00FF;   // no channel interrupts, flags clear
+  bytesInFlight         = 0;
+}
+#endif
+
 // module test harness:
 #ifdef TEST
 int main(void)
@@ -0,0 +1,1246 @@
+/****************************************************************************
+ Module
+   HostSim.c
+
+ Revision
+   0.1
+
+ Description
+   Simulated PIC32 peripherals for running the application on the host:
+   the register storage behind the HostSim xc.h, timers that count the
+   simulated time, the input capture & UART receive FIFOs, the SPI1
+   follower & the DMA transfers it paces, the A/D result buffer, and the
+   trace that drives them.
+
+ Notes
+   HostSim_RunUntil is the only place simulated time moves. It steps to
+   the earliest of the next stimulus, the next rollover of a timer whose
+   interrupt is enabled, and the limit it is given, and runs whatever is
+   due there. ES_Port_Host.c calls it from the idle hook with the next
+   tick as the limit.
+
+   A timer counts from its base regardless of ON, a write to TMRx moves
+   the base, & so does setting ON, to count on from what TMRx holds. Rollovers of timers with the interrupt off aren't simulated,
+   so their IF bit never sets.
+
+   An SPI1 transfer through the DMA, from SPIOperate_Transfer, all happens
+   the next time round, one reply from the follower for each word sent.
+   The channels are told apart by their start IRQ, as on the chip. The
+   addresses in them are handles from HostSim_KvaToPa, the only way a host
+   pointer fits in a 32 bit register.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  The pulse capture ISRs on IC3 & IC4
+ 10/14/26       Tianyu  Setting a timer's ON moves its base, so a one-shot
+                        runs its whole period
+ 10/14/26       Tianyu  Timer1 is simulated too, for the short timers
+ 10/14/26       Tianyu  The SPI1 follower answers transfers run through the
+                        DMA, "spi" sets its replies rather than filling the
+                        receive FIFO
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "HostSim.h"
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+#define IC_FIFO_DEPTH 4
+#define KEY_FIFO_DEPTH 64
+#define MAX_STIM_VALUES 16
+#define TRACE_LINE_LEN 256
+#define DRAIN_US 100000       // run on after the last stimulus
+#define NUM_IC 5
+#define NUM_TIMER_SLOTS 6     // Timer1..Timer5 at their own numbers
+#define NUM_DMA_CHANNELS 4
+#define NUM_DMA_HANDLES 32    // distinct buffers a DMA can be pointed at
+
+typedef enum
+{
+  STIM_KEY,
+  STIM_SPI,
+  STIM_EDGE,
+  STIM_ADC,
+  STIM_END,
+  NUM_STIM_KINDS
+} StimKind_t;
+
+static const char *const StimNames[NUM_STIM_KINDS] = {
+  "key", "spi", "edge", "adc", "end"
+};
+
+typedef struct
+{
+  StimKind_t Kind;
+  uint64_t   Next;        // in counts
+  uint64_t   Period;      // in counts, for a repeat
+  uint32_t   Remaining;   // occurrences left, Next included
+  uint8_t    NumValues;
+  uint16_t   Values[MAX_STIM_VALUES];
+} Stimulus_t;
+
+// interrupt sources the simulation can raise
+typedef enum
+{
+  HOST_SRC_T1,
+  HOST_SRC_T2,
+  HOST_SRC_T3,
+  HOST_SRC_T4,
+  HOST_SRC_T5,
+  HOST_SRC_IC1,
+  HOST_SRC_IC2,
+  HOST_SRC_IC3,
+  HOST_SRC_IC4,
+  HOST_SRC_IC5,
+  HOST_SRC_DMA1,
+  HOST_SRC_ADC,
+  NUM_HOST_SOURCES
+} HostSource_t;
+
+typedef struct
+{
+  const char   *Name;
+  HostIntReg_t Flags;     // the IFS word, the IEC word is the one after
+  uint32_t     Mask;
+} SourceDesc_t;
+
+static const SourceDesc_t Sources[NUM_HOST_SOURCES] = {
+  { "Timer1", HOST_IFS0, _IFS0_T1IF_MASK },
+  { "Timer2", HOST_IFS0, _IFS0_T2IF_MASK },
+  { "Timer3", HOST_IFS0, _IFS0_T3IF_MASK },
+  { "Timer4", HOST_IFS0, _IFS0_T4IF_MASK },
+  { "Timer5", HOST_IFS0, _IFS0_T5IF_MASK },
+  { "IC1", HOST_IFS0, _IFS0_IC1IF_MASK },
+  { "IC2", HOST_IFS0, _IFS0_IC2IF_MASK },
+  { "IC3", HOST_IFS0, _IFS0_IC3IF_MASK },
+  { "IC4", HOST_IFS0, _IFS0_IC4IF_MASK },
+  { "IC5", HOST_IFS0, _IFS0_IC5IF_MASK },
+  { "SPI1 DMA", HOST_IFS1, _IFS1_DMA1IF_MASK },
+  { "ADC", HOST_IFS0, _IFS0_AD1IF_MASK },
+};
+
+// the application's ISRs, by name, for each source. The first one that is
+// linked in is used. An ISR added to the application goes here too
+#define HOST_ISR_TABLE(X)                 \
+  X(HOST_SRC_T1,   ShortTimerBISR)        \
+  X(HOST_SRC_T2,   PWMCommitISR)          \
+  X(HOST_SRC_T2,   Timer2ISR)             \
+  X(HOST_SRC_T3,   Timer3ISR)             \
+  X(HOST_SRC_T4,   ControlLoopISR)        \
+  X(HOST_SRC_T5,   ShortTimerAISR)        \
+  X(HOST_SRC_IC1,  InputCaptureISR)       \
+  X(HOST_SRC_IC2,  LeftEncoderISR)        \
+  X(HOST_SRC_IC3,  PulseCapture3ISR)      \
+  X(HOST_SRC_IC4,  PulseCapture4ISR)      \
+  X(HOST_SRC_IC5,  RightEncoderISR)       \
+  X(HOST_SRC_DMA1, SPI1TransferISR)       \
+  X(HOST_SRC_ADC,  ADC_StreamISR)
+
+#define HOST_ISR_DECLARE(Source, Name) \
+  extern void Name(void) __attribute__((weak));
+HOST_ISR_TABLE(HOST_ISR_DECLARE)
+
+typedef struct
+{
+  HostSource_t Source;
+  void (*pISR)(void);
+} ISRBinding_t;
+
+#define HOST_ISR_BINDING(Source, Name) { Source, Name },
+static const ISRBinding_t ISRBindings[] = {
+  HOST_ISR_TABLE(HOST_ISR_BINDING)
+};
+
+typedef struct
+{
+  int64_t  Base;        // time the count was 0
+  uint64_t LastRollover;  // the last one that was run
+  uint32_t Cell;        // what TMRx reads as
+  uint32_t LastRead;    // to spot a write to Cell
+  bool     WasOn;       // ON the last time round, to spot it being set
+} TimerModel_t;
+
+typedef struct
+{
+  uint32_t Entries[IC_FIFO_DEPTH];
+  uint8_t  Head;
+  uint8_t  Count;
+  uint32_t Cell;
+} CaptureFifo_t;
+
+typedef struct
+{
+  volatile uint32_t *pCon;
+  volatile uint32_t *pEcon;
+  volatile uint32_t *pInt;
+  volatile uint32_t *pSsa;
+  volatile uint32_t *pDsa;
+  volatile uint32_t *pDsiz;
+  volatile uint32_t *pCsiz;
+} DmaChannel_t;
+
+typedef struct
+{
+  uint32_t Calls;
+  uint32_t Missing;     // raised & enabled, but no ISR linked in
+  uint64_t HostNs;
+} SourceStats_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static volatile uint32_t *IntWord(HostIntReg_t Which);
+static void ApplyPendingOp(void);
+static void RaiseInterrupt(HostSource_t Source);
+static uint64_t TimerStep(uint8_t Which);
+static uint64_t TimerPeriod(uint8_t Which);
+static volatile HostBits_t *TimerCon(uint8_t Which);
+static bool TimerInterruptEnabled(uint8_t Which);
+static void NoteTimersOn(void);
+static uint64_t NextRollover(uint8_t Which);
+static void RunStimulus(Stimulus_t *pStim);
+static void Capture(uint8_t Channel);
+static bool RunSPI1Dma(void);
+static int8_t FindDmaChannel(uint32_t StartIRQ);
+static uint8_t NextSPIReply(void);
+static bool ParseTrace(FILE *pFile, const char *pPath);
+static bool ParseLine(char *pLine, Stimulus_t *pStim, bool *pIsEnd,
+    uint64_t *pEndAt);
+
+/*---------------------------- Module Variables ---------------------------*/
+// the plain registers the xc.h declares
+#define HOST_SFR_DEFINE(Name) volatile uint32_t Name;
+HOST_SFR_LIST(HOST_SFR_DEFINE)
+#define HOST_BITS_DEFINE(Name) volatile HostBits_t Name;
+HOST_BITS_LIST(HOST_BITS_DEFINE)
+volatile HostOCCON_t HostOCCON[5];
+volatile HostSPICON_t HostSPICON[2];
+volatile HostSPICON2_t HostSPICON2[2];
+volatile uint32_t HostADC1BUF[16 * 4];
+
+static volatile HostIntRegs_t IntRegs;
+static volatile uint32_t PendingWord;
+static volatile uint32_t *pPendingReg;
+static HostIntOp_t PendingOp;
+
+static uint64_t Now;
+static uint32_t CoreCompare;
+static uint32_t CoreDebug;
+
+static TimerModel_t Timers[NUM_TIMER_SLOTS];
+static const uint16_t Prescales[8] = { 1, 2, 4, 8, 16, 32, 64, 256 };
+// Timer1 is the Type A timer, with its own 2 bit TCKPS
+static const uint16_t TypeAPrescales[4] = { 1, 8, 64, 256 };
+
+static volatile HostICCONbits_t ICCon[NUM_IC + 1];
+static CaptureFifo_t ICFifo[NUM_IC + 1];
+static const HostSource_t ICSources[NUM_IC + 1] = {
+  NUM_HOST_SOURCES, HOST_SRC_IC1, HOST_SRC_IC2, HOST_SRC_IC3, HOST_SRC_IC4,
+  HOST_SRC_IC5
+};
+
+#define HOST_DMA_CHANNEL(n)                                                   \
+  { &DCH##n##CON, &DCH##n##ECON, &DCH##n##INT, &DCH##n##SSA, &DCH##n##DSA,    \
+    &DCH##n##DSIZ, &DCH##n##CSIZ }
+static const DmaChannel_t DmaChannels[NUM_DMA_CHANNELS] = {
+  HOST_DMA_CHANNEL(0), HOST_DMA_CHANNEL(1), HOST_DMA_CHANNEL(2),
+  HOST_DMA_CHANNEL(3)
+};
+// the block done interrupt of each channel, if the simulation has it
+static const HostSource_t DmaSources[NUM_DMA_CHANNELS] = {
+  NUM_HOST_SOURCES, HOST_SRC_DMA1, NUM_HOST_SOURCES, NUM_HOST_SOURCES
+};
+// handle n + 1 is the pointer in slot n, 0 is no pointer
+static const volatile void *DmaAddresses[NUM_DMA_HANDLES];
+static uint8_t NumDmaAddresses;
+
+static volatile HostSPISTATbits_t SPI1Stat;
+static uint32_t SPICell;
+// what the follower answers, in turn, the last one over & over
+static uint8_t  SPIReplies[MAX_STIM_VALUES];
+static uint8_t  NumSPIReplies;
+static uint8_t  NextReply;
+
+static volatile HostU1STAbits_t U1Stat;
+static uint8_t  KeyFifo[KEY_FIFO_DEPTH];
+static uint8_t  KeyHead;
+static uint8_t  KeyCount;
+
+static Stimulus_t *pStimuli;
+static uint32_t    NumStimuli;
+static uint64_t    EndAt;
+
+static uint32_t      StimCounts[NUM_STIM_KINDS];
+static uint32_t      DroppedInputs;
+static SourceStats_t SourceStats[NUM_HOST_SOURCES];
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     HostSim_Init
+
+ Parameters
+     const char *pTracePath - the trace to replay, NULL or "-" for stdin
+
+ Returns
+     bool, false if the trace couldn't be read
+
+ Description
+     Loads the whole trace and starts the simulated time at 0
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool HostSim_Init(const char *pTracePath)
+{
+  FILE *pFile = stdin;
+  bool  Loaded;
+
+  if ((pTracePath != NULL) && (strcmp(pTracePath, "-") != 0))
+  {
+    pFile = fopen(pTracePath, "r");
+    if (pFile == NULL)
+    {
+      fprintf(stderr, "HostSim: can't open %s\n", pTracePath);
+      return false;
+    }
+  }
+  else
+  {
+    pTracePath = "stdin";
+  }
+  Now = 0;
+  Loaded = ParseTrace(pFile, pTracePath);
+  if (pFile != stdin)
+  {
+    fclose(pFile);
+  }
+  return Loaded;
+}
+
+/****************************************************************************
+ Function
+     HostSim_Now
+
+ Returns
+     uint64_t, the simulated time in core timer counts
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint64_t HostSim_Now(void)
+{
+  return Now;
+}
+
+/****************************************************************************
+ Function
+     HostSim_RunUntil
+
+ Parameters
+     uint64_t Limit - the simulated time not to go past
+
+ Returns
+     bool, true if it stopped short of Limit to run a stimulus or an
+     interrupt, false if nothing was due & the time is now Limit
+
+ Description
+     Moves the simulated time on to the next thing that happens, at most
+     to Limit, and runs it
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool HostSim_RunUntil(uint64_t Limit)
+{
+  uint64_t    Next = Limit;
+  Stimulus_t *pDue = NULL;
+  uint8_t     DueTimer = 0;
+  uint32_t    i;
+  uint8_t     Which;
+
+  ApplyPendingOp();
+  NoteTimersOn();
+  if (RunSPI1Dma())
+  {
+    return true;
+  }
+  for (i = 0; i < NumStimuli; i++)
+  {
+    if ((pStimuli[i].Remaining != 0) && (pStimuli[i].Next <= Next))
+    {
+      Next = pStimuli[i].Next;
+      pDue = &pStimuli[i];
+    }
+  }
+  for (Which = 1; Which <= 5; Which++)
+  {
+    if (TimerInterruptEnabled(Which) && (NextRollover(Which) <= Next))
+    {
+      Next = NextRollover(Which);
+      DueTimer = Which;
+      pDue = NULL;
+    }
+  }
+  if (Next > Now)
+  {
+    Now = Next;
+  }
+  if (DueTimer != 0)
+  {
+    Timers[DueTimer].LastRollover = Now;
+    RaiseInterrupt((HostSource_t)(HOST_SRC_T1 + DueTimer - 1));
+    return true;
+  }
+  if (pDue != NULL)
+  {
+    RunStimulus(pDue);
+    return true;
+  }
+  return false;
+}
+
+/****************************************************************************
+ Function
+     HostSim_IsTraceDone
+
+ Returns
+     bool, true once the simulated time has reached the end of the trace
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool HostSim_IsTraceDone(void)
+{
+  return Now >= EndAt;
+}
+
+/****************************************************************************
+ Function
+     HostSim_IsKeyReady
+
+ Returns
+     bool, true if a byte has arrived on the simulated UART
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool HostSim_IsKeyReady(void)
+{
+  return KeyCount != 0;
+}
+
+/****************************************************************************
+ Function
+     HostSim_ReadKey
+
+ Returns
+     uint8_t, the oldest byte from the simulated UART, 0 if there is none
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint8_t HostSim_ReadKey(void)
+{
+  uint8_t Key;
+
+  if (KeyCount == 0)
+  {
+    return 0;
+  }
+  Key = KeyFifo[KeyHead];
+  KeyHead = (uint8_t)((KeyHead + 1) % KEY_FIFO_DEPTH);
+  KeyCount--;
+  return Key;
+}
+
+/****************************************************************************
+ Function
+     HostSim_HostNanoseconds
+
+ Returns
+     uint64_t, the host's monotonic clock
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint64_t HostSim_HostNanoseconds(void)
+{
+  struct timespec Time;
+
+  clock_gettime(CLOCK_MONOTONIC, &Time);
+  return (uint64_t)Time.tv_sec * 1000000000u + (uint64_t)Time.tv_nsec;
+}
+
+/****************************************************************************
+ Function
+     HostSim_Report
+
+ Description
+     Prints what was replayed & what the ISRs cost on the host
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void HostSim_Report(void)
+{
+  uint8_t i;
+
+  printf("simulated time %llu uS\r\n",
+      (unsigned long long)(Now / HOST_COUNTS_PER_US));
+  printf("stimuli:");
+  for (i = 0; i < STIM_END; i++)
+  {
+    printf(" %s %u", StimNames[i], StimCounts[i]);
+  }
+  printf(", %u inputs lost to full FIFOs\r\n", DroppedInputs);
+  printf("ISR          calls   host nS/call\r\n");
+  for (i = 0; i < NUM_HOST_SOURCES; i++)
+  {
+    if ((SourceStats[i].Calls == 0) && (SourceStats[i].Missing == 0))
+    {
+      continue;
+    }
+    printf("%-10s %7u %10llu", Sources[i].Name, SourceStats[i].Calls,
+        (unsigned long long)(SourceStats[i].Calls ?
+        SourceStats[i].HostNs / SourceStats[i].Calls : 0));
+    if (SourceStats[i].Missing != 0)
+    {
+      printf("   %u raised with no ISR linked in", SourceStats[i].Missing);
+    }
+    printf("\r\n");
+  }
+}
+
+/****************************************************************************
+ Function
+     HostSim_IntRegs
+
+ Returns
+     the interrupt flag & enable words, after any pending SET/CLR/INV
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+volatile HostIntRegs_t *HostSim_IntRegs(void)
+{
+  ApplyPendingOp();
+  return &IntRegs;
+}
+
+/****************************************************************************
+ Function
+     HostSim_IntOp
+
+ Parameters
+     HostIntReg_t Which - the IFS/IEC word
+     HostIntOp_t Op - SET, CLR or INV
+
+ Returns
+     the word the application writes its mask to, applied on the next
+     access to the interrupt registers
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+volatile uint32_t *HostSim_IntOp(HostIntReg_t Which, HostIntOp_t Op)
+{
+  ApplyPendingOp();
+  pPendingReg = IntWord(Which);
+  PendingOp = Op;
+  PendingWord = 0;
+  return &PendingWord;
+}
+
+/****************************************************************************
+ Function
+     HostSim_TMR
+
+ Parameters
+     uint8_t Which - timer 1..5
+
+ Returns
+     the TMRx word, holding the count at the simulated time
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+volatile uint32_t *HostSim_TMR(uint8_t Which)
+{
+  TimerModel_t *pTimer = &Timers[Which];
+
+  if (pTimer->Cell != pTimer->LastRead)
+  {
+    // written since the last access, count on from the new value
+    pTimer->Base = (int64_t)Now - (int64_t)pTimer->Cell * TimerStep(Which);
+  }
+  pTimer->Cell = (uint32_t)((((int64_t)Now - pTimer->Base) /
+      TimerStep(Which)) % TimerPeriod(Which));
+  pTimer->LastRead = pTimer->Cell;
+  return &pTimer->Cell;
+}
+
+/****************************************************************************
+ Function
+     HostSim_ICCONbits
+
+ Parameters
+     uint8_t Which - input capture 1..5
+
+ Returns
+     the ICxCON bits, with ICBNE up to date
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+volatile HostICCONbits_t *HostSim_ICCONbits(uint8_t Which)
+{
+  ICCon[Which].ICBNE = (ICFifo[Which].Count != 0);
+  return &ICCon[Which];
+}
+
+/****************************************************************************
+ Function
+     HostSim_ICBUF
+
+ Parameters
+     uint8_t Which - input capture 1..5
+
+ Returns
+     the ICxBUF word, holding the oldest capture, which is taken out of
+     the FIFO
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+volatile uint32_t *HostSim_ICBUF(uint8_t Which)
+{
+  CaptureFifo_t *pFifo = &ICFifo[Which];
+
+  if (pFifo->Count != 0)
+  {
+    pFifo->Cell = pFifo->Entries[pFifo->Head];
+    pFifo->Head = (uint8_t)((pFifo->Head + 1) % IC_FIFO_DEPTH);
+    pFifo->Count--;
+  }
+  return &pFifo->Cell;
+}
+
+/****************************************************************************
+ Function
+     HostSim_SPI1STATbits
+
+ Returns
+     the SPI1STAT bits. Transfers finish at once & the DMA takes what comes
+     in, so both sides are always empty
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+volatile HostSPISTATbits_t *HostSim_SPI1STATbits(void)
+{
+  SPI1Stat.SPIRBE = 1;
+  SPI1Stat.SPIRBF = 0;
+  SPI1Stat.RXBUFELM = 0;
+  SPI1Stat.SPITBE = 1;
+  SPI1Stat.SPITBF = 0;
+  SPI1Stat.SRMT = 1;
+  SPI1Stat.SPIBUSY = 0;
+  return &SPI1Stat;
+}
+
+/****************************************************************************
+ Function
+     HostSim_SPI1BUF
+
+ Returns
+     the SPI1BUF word. What the application writes to it goes nowhere, the
+     follower only answers the DMA
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+volatile uint32_t *HostSim_SPI1BUF(void)
+{
+  return &SPICell;
+}
+
+/****************************************************************************
+ Function
+     HostSim_KvaToPa
+
+ Parameters
+     const volatile void *pAddress - what a DMA channel is to point at
+
+ Returns
+     uint32_t, the handle that stands in for its physical address
+
+ Description
+     The same pointer always gets the same handle. Once every slot is used
+     the oldest is given out again, by then it has long been finished with
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint32_t HostSim_KvaToPa(const volatile void *pAddress)
+{
+  static uint8_t NextSlot;
+  uint8_t i;
+
+  for (i = 0; i < NumDmaAddresses; i++)
+  {
+    if (DmaAddresses[i] == pAddress)
+    {
+      return i + 1u;
+    }
+  }
+  if (NumDmaAddresses < NUM_DMA_HANDLES)
+  {
+    NextSlot = NumDmaAddresses++;
+  }
+  else
+  {
+    NextSlot = (uint8_t)((NextSlot + 1) % NUM_DMA_HANDLES);
+  }
+  DmaAddresses[NextSlot] = pAddress;
+  return NextSlot + 1u;
+}
+
+/****************************************************************************
+ Function
+     HostSim_U1STAbits
+
+ Returns
+     the U1STA bits, URXDA set while there are keys waiting. The simulated
+     UART transmits at once
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+volatile HostU1STAbits_t *HostSim_U1STAbits(void)
+{
+  U1Stat.URXDA = (KeyCount != 0);
+  U1Stat.TRMT = 1;
+  U1Stat.UTXBF = 0;
+  return &U1Stat;
+}
+
+/****************************************************************************
+ Function
+     _CP0_GET_COUNT etc
+
+ Description
+     The core timer is the simulated time. The compare & debug registers
+     only hold what was written, ES_Port_Host.c has its own tick
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint32_t _CP0_GET_COUNT(void)
+{
+  return (uint32_t)Now;
+}
+
+void _CP0_SET_COUNT(uint32_t Count)
+{
+  (void)Count;    // the simulated time only moves forward
+}
+
+uint32_t _CP0_GET_COMPARE(void)
+{
+  return CoreCompare;
+}
+
+void _CP0_SET_COMPARE(uint32_t Compare)
+{
+  CoreCompare = Compare;
+}
+
+uint32_t _CP0_GET_DEBUG(void)
+{
+  return CoreDebug;
+}
+
+void _CP0_SET_DEBUG(uint32_t Debug)
+{
+  CoreDebug = Debug;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+static volatile uint32_t *IntWord(HostIntReg_t Which)
+{
+  switch (Which)
+  {
+    case HOST_IFS0: return &IntRegs.Ifs0.w;
+    case HOST_IFS1: return &IntRegs.Ifs1.w;
+    case HOST_IEC0: return &IntRegs.Iec0.w;
+    default:        return &IntRegs.Iec1.w;
+  }
+}
+
+static void ApplyPendingOp(void)
+{
+  volatile uint32_t *pReg = pPendingReg;
+
+  if (pReg == NULL)
+  {
+    return;
+  }
+  pPendingReg = NULL;
+  switch (PendingOp)
+  {
+    case HOST_OP_SET: *pReg |= PendingWord;  break;
+    case HOST_OP_CLR: *pReg &= ~PendingWord; break;
+    default:          *pReg ^= PendingWord;  break;
+  }
+}
+
+static void RaiseInterrupt(HostSource_t Source)
+{
+  const SourceDesc_t *pDesc = &Sources[Source];
+  void (*pISR)(void) = NULL;
+  uint64_t Start;
+  size_t   i;
+
+  ApplyPendingOp();
+  *IntWord(pDesc->Flags) |= pDesc->Mask;
+  // IEC0 follows IFS0 & IEC1 follows IFS1
+  if ((*IntWord((HostIntReg_t)(pDesc->Flags + 2)) & pDesc->Mask) == 0)
+  {
+    return;
+  }
+  for (i = 0; i < sizeof(ISRBindings) / sizeof(ISRBindings[0]); i++)
+  {
+    if ((ISRBindings[i].Source == Source) && (ISRBindings[i].pISR != NULL))
+    {
+      pISR = ISRBindings[i].pISR;
+      break;
+    }
+  }
+  if (pISR == NULL)
+  {
+    SourceStats[Source].Missing++;
+    *IntWord(pDesc->Flags) &= ~pDesc->Mask;  // or it would stay pending
+    return;
+  }
+  Start = HostSim_HostNanoseconds();
+  pISR();
+  ApplyPendingOp();
+  SourceStats[Source].HostNs += HostSim_HostNanoseconds() - Start;
+  SourceStats[Source].Calls++;
+}
+
+static volatile HostBits_t *TimerCon(uint8_t Which)
+{
+  switch (Which)
+  {
+    case 1:  return &T1CONbits;
+    case 2:  return &T2CONbits;
+    case 3:  return &T3CONbits;
+    case 4:  return &T4CONbits;
+    default: return &T5CONbits;
+  }
+}
+
+// counts per timer count
+static uint64_t TimerStep(uint8_t Which)
+{
+  if (Which == 1)
+  {
+    return TypeAPrescales[T1CONbits.TCKPS & 3];
+  }
+  // in the 32 bit pair Timer2 sets the prescale for both
+  if ((Which == 3) && T2CONbits.T32)
+  {
+    Which = 2;
+  }
+  return Prescales[TimerCon(Which)->TCKPS & 7];
+}
+
+// timer counts per rollover
+static uint64_t TimerPeriod(uint8_t Which)
+{
+  static volatile uint32_t *const Periods[NUM_TIMER_SLOTS] = {
+    NULL, &PR1, &PR2, &PR3, &PR4, &PR5
+  };
+  uint32_t Period = *Periods[Which];
+
+  if ((Which == 2) && T2CONbits.T32)
+  {
+    // PR2 holds all 32 bits here, the part splits them across PR3:PR2
+    return (uint64_t)((Period > 0xFFFF) ? Period :
+        (((PR3 & 0xFFFF) << 16) | Period)) + 1;
+  }
+  // a period register that was never set counts the full 16 bits
+  return (uint64_t)(((Period & 0xFFFF) == 0) ? 0xFFFF : (Period & 0xFFFF)) +
+      1;
+}
+
+static bool TimerInterruptEnabled(uint8_t Which)
+{
+  static const uint32_t Masks[NUM_TIMER_SLOTS] = {
+    0, _IEC0_T1IE_MASK, _IEC0_T2IE_MASK, _IEC0_T3IE_MASK, _IEC0_T4IE_MASK,
+    _IEC0_T5IE_MASK
+  };
+
+  // Timer3's half of the 32 bit pair doesn't count on its own
+  if ((Which == 3) && T2CONbits.T32)
+  {
+    return false;
+  }
+  return TimerCon(Which)->ON && ((IntRegs.Iec0.w & Masks[Which]) != 0);
+}
+
+// a timer that has been turned on since the last time counts from now, so
+// a one-shot started with TMRx already reading 0 still runs its full period
+static void NoteTimersOn(void)
+{
+  uint8_t Which;
+
+  for (Which = 1; Which <= 5; Which++)
+  {
+    TimerModel_t *pTimer = &Timers[Which];
+    bool          IsOn = TimerCon(Which)->ON;
+
+    if (IsOn && !pTimer->WasOn)
+    {
+      pTimer->Base = (int64_t)Now - (int64_t)pTimer->Cell * TimerStep(Which);
+      pTimer->LastRead = pTimer->Cell;
+    }
+    pTimer->WasOn = IsOn;
+  }
+}
+
+// the first rollover from now on that hasn't been run yet
+static uint64_t NextRollover(uint8_t Which)
+{
+  int64_t  Span = (int64_t)(TimerStep(Which) * TimerPeriod(Which));
+  int64_t  Elapsed = (int64_t)Now - Timers[Which].Base;
+  uint64_t Rollover;
+
+  Rollover = (uint64_t)(Timers[Which].Base + ((Elapsed + Span - 1) / Span) *
+      Span);
+  if ((Rollover == Timers[Which].LastRollover) || (Elapsed == 0))
+  {
+    Rollover += (uint64_t)Span;
+  }
+  return Rollover;
+}
+
+static void RunStimulus(Stimulus_t *pStim)
+{
+  uint8_t i;
+
+  StimCounts[pStim->Kind]++;
+  switch (pStim->Kind)
+  {
+    case STIM_KEY:
+      if (KeyCount < KEY_FIFO_DEPTH)
+      {
+        KeyFifo[(KeyHead + KeyCount) % KEY_FIFO_DEPTH] =
+            (uint8_t)pStim->Values[0];
+        KeyCount++;
+      }
+      else
+      {
+        DroppedInputs++;
+      }
+      break;
+
+    case STIM_SPI:
+      // the follower has something new to say, from its next reply on
+      for (i = 0; i < pStim->NumValues; i++)
+      {
+        SPIReplies[i] = (uint8_t)pStim->Values[i];
+      }
+      NumSPIReplies = pStim->NumValues;
+      NextReply = 0;
+      break;
+
+    case STIM_EDGE:
+      Capture((uint8_t)pStim->Values[0]);
+      break;
+
+    case STIM_ADC:
+      // the library reads the half the converter isn't filling
+      for (i = 0; i < pStim->NumValues; i++)
+      {
+        HostADC1BUF[4 * i] = pStim->Values[i];
+      }
+      AD1CON2bits.BUFS = 1;
+      RaiseInterrupt(HOST_SRC_ADC);
+      break;
+
+    default:
+      break;
+  }
+  pStim->Remaining--;
+  pStim->Next += pStim->Period;
+}
+
+// runs the whole of an SPI1 transfer if both of its channels are on,
+// true if it did
+static bool RunSPI1Dma(void)
+{
+  int8_t   Rx = FindDmaChannel(_SPI1_RX_IRQ);
+  int8_t   Tx = FindDmaChannel(_SPI1_TX_IRQ);
+  uint8_t *pDest;
+  uint32_t WordBytes;
+  uint32_t Offset;
+  uint32_t Byte;
+
+  if ((Rx < 0) || (Tx < 0))
+  {
+    return false;
+  }
+  WordBytes = *DmaChannels[Rx].pCsiz;
+  pDest = (*DmaChannels[Rx].pDsa == 0) ? NULL :
+      (uint8_t *)DmaAddresses[*DmaChannels[Rx].pDsa - 1];
+  // the follower sends each word low byte first, its reply repeated
+  for (Offset = 0; (pDest != NULL) && (WordBytes != 0) &&
+       (Offset < *DmaChannels[Rx].pDsiz); Offset += WordBytes)
+  {
+    uint8_t Reply = NextSPIReply();
+
+    for (Byte = 0; Byte < WordBytes; Byte++)
+    {
+      pDest[Offset + Byte] = (Byte == 0) ? Reply : 0;
+    }
+    SPICell = Reply;
+  }
+  *DmaChannels[Tx].pCon &= ~_DCH0CON_CHEN_MASK;
+  *DmaChannels[Tx].pInt |= _DCH0INT_CHBCIF_MASK;
+  *DmaChannels[Rx].pCon &= ~_DCH0CON_CHEN_MASK;
+  *DmaChannels[Rx].pInt |= _DCH0INT_CHBCIF_MASK;
+  if (((*DmaChannels[Rx].pInt & _DCH0INT_CHBCIE_MASK) != 0) &&
+      (DmaSources[Rx] != NUM_HOST_SOURCES))
+  {
+    RaiseInterrupt(DmaSources[Rx]);
+  }
+  return true;
+}
+
+// the enabled channel started by StartIRQ, -1 if there isn't one
+static int8_t FindDmaChannel(uint32_t StartIRQ)
+{
+  int8_t Which;
+
+  for (Which = 0; Which < NUM_DMA_CHANNELS; Which++)
+  {
+    if (((*DmaChannels[Which].pCon & _DCH0CON_CHEN_MASK) != 0) &&
+        (((*DmaChannels[Which].pEcon >> _DCH0ECON_CHSIRQ_POSITION) & 0xFF) ==
+         StartIRQ))
+    {
+      return Which;
+    }
+  }
+  return -1;
+}
+
+// 0 until the first "spi" stimulus, as the generator has nothing to say
+static uint8_t NextSPIReply(void)
+{
+  uint8_t Reply;
+
+  if (NumSPIReplies == 0)
+  {
+    return 0;
+  }
+  Reply = SPIReplies[NextReply];
+  if (NextReply < (NumSPIReplies - 1))
+  {
+    NextReply++;
+  }
+  return Reply;
+}
+
+static void Capture(uint8_t Channel)
+{
+  CaptureFifo_t *pFifo = &ICFifo[Channel];
+  uint32_t Captured;
+
+  // a capture of Timer2 in the 32 bit pair is the whole count
+  if (ICCon[Channel].ICC32 || ICCon[Channel].ICTMR)
+  {
+    Captured = *HostSim_TMR(2);
+  }
+  else
+  {
+    Captured = *HostSim_TMR(3);
+  }
+  if (!ICCon[Channel].ICC32)
+  {
+    Captured &= 0xFFFF;
+  }
+  if (pFifo->Count < IC_FIFO_DEPTH)
+  {
+    pFifo->Entries[(pFifo->Head + pFifo->Count) % IC_FIFO_DEPTH] = Captured;
+    pFifo->Count++;
+  }
+  else
+  {
+    ICCon[Channel].ICOV = 1;
+    DroppedInputs++;
+  }
+  RaiseInterrupt(ICSources[Channel]);
+}
+
+static bool ParseTrace(FILE *pFile, const char *pPath)
+{
+  char       Line[TRACE_LINE_LEN];
+  Stimulus_t Stim;
+  uint32_t   LineNum = 0;
+  uint32_t   Allocated = 0;
+  bool       IsEnd;
+  bool       HaveEnd = false;
+  uint64_t   LastAt = 0;
+  uint64_t   At;
+
+  while (fgets(Line, sizeof(Line), pFile) != NULL)
+  {
+    LineNum++;
+    if (!ParseLine(Line, &Stim, &IsEnd, &At))
+    {
+      fprintf(stderr, "HostSim: %s:%u: can't read \"%s\"\n", pPath, LineNum,
+          strtok(Line, "\r\n"));
+      return false;
+    }
+    if (IsEnd)
+    {
+      EndAt = At;
+      HaveEnd = true;
+      continue;
+    }
+    if (Stim.Remaining == 0)
+    {
+      continue;   // a blank line or a comment
+    }
+    if (NumStimuli == Allocated)
+    {
+      Allocated = Allocated ? Allocated * 2 : 64;
+      pStimuli = realloc(pStimuli, Allocated * sizeof(Stimulus_t));
+      if (pStimuli == NULL)
+      {
+        fprintf(stderr, "HostSim: out of memory\n");
+        return false;
+      }
+    }
+    pStimuli[NumStimuli++] = Stim;
+    At = Stim.Next + (uint64_t)(Stim.Remaining - 1) * Stim.Period;
+    if (At > LastAt)
+    {
+      LastAt = At;
+    }
+  }
+  if (!HaveEnd)
+  {
+    EndAt = LastAt + (uint64_t)DRAIN_US * HOST_COUNTS_PER_US;
+  }
+  return true;
+}
+
+static bool ParseLine(char *pLine, Stimulus_t *pStim, bool *pIsEnd,
+    uint64_t *pEndAt)
+{
+  char   *pToken;
+  char   *pEnd;
+  double  TimeUs;
+  uint8_t Kind;
+
+  memset(pStim, 0, sizeof(*pStim));
+  *pIsEnd = false;
+  pEnd = strchr(pLine, '#');
+  if (pEnd != NULL)
+  {
+    *pEnd = '\0';
+  }
+  pToken = strtok(pLine, " \t\r\n");
+  if (pToken == NULL)
+  {
+    return true;
+  }
+  TimeUs = strtod(pToken, &pEnd);
+  if ((*pEnd != '\0') || (TimeUs < 0))
+  {
+    return false;
+  }
+  pStim->Next = (uint64_t)(TimeUs * HOST_COUNTS_PER_US);
+  pToken = strtok(NULL, " \t\r\n");
+  if (pToken == NULL)
+  {
+    return false;
+  }
+  for (Kind = 0; Kind < NUM_STIM_KINDS; Kind++)
+  {
+    if (strcmp(pToken, StimNames[Kind]) == 0)
+    {
+      break;
+    }
+  }
+  if (Kind == NUM_STIM_KINDS)
+  {
+    return false;
+  }
+  if (Kind == STIM_END)
+  {
+    *pIsEnd = true;
+    *pEndAt = pStim->Next;
+    return strtok(NULL, " \t\r\n") == NULL;
+  }
+  pStim->Kind = (StimKind_t)Kind;
+  pStim->Remaining = 1;
+
+  while ((pToken = strtok(NULL, " \t\r\n")) != NULL)
+  {
+    if (strcmp(pToken, "*") == 0)
+    {
+      char *pCount = strtok(NULL, " \t\r\n");
+      char *pPeriod = strtok(NULL, " \t\r\n");
+
+      if ((pCount == NULL) || (pPeriod == NULL))
+      {
+        return false;
+      }
+      pStim->Remaining = (uint32_t)strtoul(pCount, NULL, 0);
+      pStim->Period = (uint64_t)(strtod(pPeriod, NULL) * HOST_COUNTS_PER_US);
+      if ((pStim->Remaining == 0) ||
+          ((pStim->Remaining > 1) && (pStim->Period == 0)) ||
+          (strtok(NULL, " \t\r\n") != NULL))
+      {
+        return false;
+      }
+      break;
+    }
+    if (pStim->NumValues == MAX_STIM_VALUES)
+    {
+      return false;
+    }
+    if ((Kind == STIM_KEY) && (strlen(pToken) == 1))
+    {
+      pStim->Values[pStim->NumValues++] = (uint8_t)pToken[0];
+      continue;
+    }
+    pStim->Values[pStim->NumValues++] =
+        (uint16_t)strtoul(pToken, &pEnd, 0);
+    if (*pEnd != '\0')
+    {
+      return false;
+    }
+  }
+
+  switch (pStim->Kind)
+  {
+    case STIM_KEY:
+      return pStim->NumValues == 1;
+    case STIM_EDGE:
+      return (pStim->NumValues == 1) && (pStim->Values[0] >= 1) &&
+             (pStim->Values[0] <= NUM_IC);
+    default:
+      return pStim->NumValues != 0;
+  }
+}
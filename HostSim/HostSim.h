@@ -0,0 +1,60 @@
+/****************************************************************************
+ Module
+     HostSim.h
+
+ Description
+     Header file for the host simulation of the PIC32 peripherals, used by
+     ES_Port_Host.c to run the application on a PC against a recorded trace.
+
+ Notes
+     Time is simulated, in core timer counts (20MHz, the same as PBCLK). It
+     only moves on when ES_Run idles, so on the host every dispatch takes no
+     simulated time and the host's own clock is what measures them.
+
+     A trace is a text file, one stimulus per line, in time order:
+
+       <time uS> key <char>|0x<hex>    a byte arrives on the UART
+       <time uS> spi <byte>...         the SPI1 follower's replies from
+                                        now on, one for each word the DMA
+                                        sends, the last one repeated
+       <time uS> edge <IC channel>     a capture on IC1..IC5, of the time
+                                        base that channel is set up for
+       <time uS> adc <count>...        one scan set of A/D results
+       <time uS> end                   stop here, rather than 100mS after
+                                        the last stimulus
+
+     Any stimulus can be followed by "* <count> <period uS>" to repeat it.
+     Repeats may overlap the lines after them. # starts a comment.
+
+     The ISR that a stimulus or a timer rollover runs is found by name, see
+     HOST_ISR_TABLE in HostSim.c. They run one at a time, between passes of
+     ES_Run, so there is no nesting by priority.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  "spi" sets the follower's replies
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef HostSim_H
+#define HostSim_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// core timer counts per microsecond, the simulated time's unit
+#define HOST_COUNTS_PER_US 20
+
+bool HostSim_Init(const char *pTracePath);
+uint64_t HostSim_Now(void);
+bool HostSim_RunUntil(uint64_t Limit);
+bool HostSim_IsTraceDone(void);
+
+bool HostSim_IsKeyReady(void);
+uint8_t HostSim_ReadKey(void);
+
+uint64_t HostSim_HostNanoseconds(void);
+void HostSim_Report(void);
+
+#endif /* HostSim_H */
@@ -0,0 +1,43 @@
+/****************************************************************************
+ Module
+     sys/attribs.h (host simulation)
+
+ Description
+     Turns the ISR attributes into plain functions for the HostSim build,
+     HostSim.c calls them itself, see HOST_ISR_TABLE there.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef HOST_SYS_ATTRIBS_H
+#define HOST_SYS_ATTRIBS_H
+
+#define __ISR(Vector, ...)
+
+#define _CORE_TIMER_VECTOR       0
+#define _EXTERNAL_0_VECTOR       3
+#define _TIMER_1_VECTOR          4
+#define _INPUT_CAPTURE_1_VECTOR  5
+#define _OUTPUT_COMPARE_1_VECTOR 6
+#define _EXTERNAL_1_VECTOR       7
+#define _TIMER_2_VECTOR          8
+#define _INPUT_CAPTURE_2_VECTOR  9
+#define _TIMER_3_VECTOR          12
+#define _INPUT_CAPTURE_3_VECTOR  13
+#define _TIMER_4_VECTOR          16
+#define _INPUT_CAPTURE_4_VECTOR  17
+#define _EXTERNAL_4_VECTOR       19
+#define _TIMER_5_VECTOR          20
+#define _INPUT_CAPTURE_5_VECTOR  21
+#define _ADC_VECTOR              23
+#define _SPI_1_VECTOR            31
+#define _UART_1_VECTOR           32
+#define _CHANGE_NOTICE_VECTOR    34
+#define _DMA_0_VECTOR            36
+#define _DMA_1_VECTOR            37
+#define _DMA_3_VECTOR            39
+
+#endif /* HOST_SYS_ATTRIBS_H */
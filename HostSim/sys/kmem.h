@@ -0,0 +1,25 @@
+/****************************************************************************
+ Module
+     sys/kmem.h (host simulation)
+
+ Description
+     The address conversion the DMA setup uses. A host pointer doesn't fit
+     the 32 bit register, so HostSim hands out a small number for each one
+     & turns it back into the pointer when it runs the transfer.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  The "physical" address is a HostSim handle
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef HOST_SYS_KMEM_H
+#define HOST_SYS_KMEM_H
+
+#include <stdint.h>
+
+uint32_t HostSim_KvaToPa(const volatile void *pAddress);
+#define KVA_TO_PA(v) HostSim_KvaToPa((const volatile void *)(v))
+
+#endif /* HOST_SYS_KMEM_H */
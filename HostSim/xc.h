@@ -0,0 +1,477 @@
+/****************************************************************************
+ Module
+     xc.h (host simulation)
+
+ Description
+     Stands in for the XC32 device header when the application is built for
+     the host (ES_HOST_SIM). Every SFR the application touches is a plain
+     variable, except for the few that behave like hardware rather than
+     memory, which go through HostSim accessors:
+
+       IFSx/IECx & their SET/CLR/INV  - one set of words, the bit views
+                                         alias them
+       TMR1..TMR5                      - count from the simulated time
+       ICxBUF, ICxCONbits.ICBNE        - the input capture FIFOs
+       SPI1BUF, SPI1STATbits.SPIRBE    - the SPI1 receive buffer, the
+                                         DMA empties it at once
+       U1STAbits.URXDA                 - the simulated UART's key FIFO
+       ADC1BUF0..                      - loaded a scan set at a time
+
+     The bit views of the other registers are not tied to their words, the
+     application only ever uses one or the other. Bit positions only matter
+     where a word & a bit view are shared, and there they follow the
+     PIC32MX170F256B data sheet.
+
+ Notes
+     This header is only on the include path of the HostSim build, the
+     MPLAB X project never sees it.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  IC3 & IC4 capture like the other modules, for the
+                        pulse capture service
+ 10/14/26       Tianyu  Added CNPUASET & CNPUBSET for the scanned inputs
+ 10/14/26       Tianyu  Added the PMD registers for the power manager, a
+                        peripheral that is switched off keeps running
+ 10/14/26       Tianyu  Added the NVM registers for the parameter store,
+                        a flash write does nothing
+ 10/14/26       Tianyu  Added CNPUBbits for the stop input
+ 10/14/26       Tianyu  TMR1 counts from the simulated time
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef HOST_XC_H
+#define HOST_XC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*------------------------ registers that are memory ------------------------*/
+// the DMA channels too. HostSim runs a transfer paced by SPI1, no other
+// channel ever moves its data
+#define HOST_DCH_SFRS(X, n)                                                  \
+  X(DCH##n##CON) X(DCH##n##ECON) X(DCH##n##ECONSET) X(DCH##n##INT)            \
+  X(DCH##n##SSA) X(DCH##n##DSA) X(DCH##n##SSIZ) X(DCH##n##DSIZ)              \
+  X(DCH##n##CSIZ)
+
+#define HOST_SFR_LIST(X)                                                     \
+  X(T1CON) X(T2CON) X(T3CON) X(T4CON) X(T5CON)                               \
+  X(T2CONSET) X(T2CONCLR) X(T3CONSET) X(T3CONCLR)                            \
+  X(PR1) X(PR2) X(PR3) X(PR4) X(PR5)                                         \
+  X(IC1CON) X(IC2CON) X(IC3CON) X(IC4CON) X(IC5CON)                          \
+  X(IC1R) X(IC2R) X(IC3R) X(IC4R) X(IC5R)                                    \
+  X(OC1R) X(OC2R) X(OC3R) X(OC4R) X(OC5R)                                    \
+  X(OC1RS) X(OC2RS) X(OC3RS) X(OC4RS) X(OC5RS)                               \
+  X(RPA0R) X(RPA1R) X(RPA2R) X(RPA3R) X(RPA4R)                               \
+  X(RPB0R) X(RPB1R) X(RPB2R) X(RPB3R) X(RPB4R) X(RPB5R) X(RPB6R) X(RPB7R)    \
+  X(RPB8R) X(RPB9R) X(RPB10R) X(RPB11R) X(RPB12R) X(RPB13R) X(RPB14R)        \
+  X(RPB15R)                                                                  \
+  X(SDI1R) X(SDI2R) X(SS1R) X(SS2R) X(U1RXR) X(U2RXR)                        \
+  X(INT1R) X(INT2R) X(INT3R) X(INT4R)                                        \
+  X(TRISA) X(TRISB) X(TRISASET) X(TRISACLR) X(TRISBSET) X(TRISBCLR)           \
+  X(LATA) X(LATB) X(LATASET) X(LATACLR) X(LATAINV)                           \
+  X(LATBSET) X(LATBCLR) X(LATBINV)                                           \
+  X(PORTA) X(PORTB)                                                          \
+  X(ANSELA) X(ANSELB) X(ANSELASET) X(ANSELACLR) X(ANSELBSET) X(ANSELBCLR)    \
+  X(CNENA) X(CNENB) X(CNCONA) X(CNCONB) X(CNSTATA) X(CNSTATB)                \
+  X(CNPUA) X(CNPUB) X(CNPUASET) X(CNPUBSET) X(CNPDA) X(CNPDB)                \
+  X(U1MODE) X(U1STA) X(U1BRG) X(U1TXREG) X(U1RXREG)                          \
+  X(AD1CON1) X(AD1CON2) X(AD1CON3) X(AD1CON1SET) X(AD1CON2SET) X(AD1CHS)     \
+  X(AD1CSSL)                                                                 \
+  X(SPI1BRG) X(SPI2BRG) X(SPI1STATCLR) X(SPI2STATCLR) X(SPI2BUF)             \
+  X(DMACONSET) HOST_DCH_SFRS(X, 0) HOST_DCH_SFRS(X, 1) HOST_DCH_SFRS(X, 2)   \
+  HOST_DCH_SFRS(X, 3)                                                        \
+  X(INTCON) X(IPC0) X(IPC1) X(IPC2) X(IPC3) X(IPC4) X(IPC5) X(IPC6)          \
+  X(IPC7) X(IPC8) X(IPC9)                                                    \
+  X(NVMCON) X(NVMCONSET) X(NVMCONCLR) X(NVMKEY) X(NVMADDR) X(NVMDATA)      \
+  X(PMD1) X(PMD2) X(PMD3) X(PMD4) X(PMD5) X(PMD6)                            \
+  X(PMD1SET) X(PMD2SET) X(PMD3SET) X(PMD4SET) X(PMD5SET) X(PMD6SET)          \
+  X(PMD1CLR) X(PMD2CLR) X(PMD3CLR) X(PMD4CLR) X(PMD5CLR) X(PMD6CLR)          \
+  X(SYSKEY) X(CFGCON) X(CFGCONCLR)
+
+#define HOST_SFR_DECLARE(Name) extern volatile uint32_t Name;
+HOST_SFR_LIST(HOST_SFR_DECLARE)
+
+/*------------------ bit views that don't alias their word ------------------*/
+// one layout for all of them, a field per bit name used anywhere
+#define HOST_BIT_FIELDS(X)                                                   \
+  X(ON) X(TCS) X(TCKPS) X(T32) X(TGATE)                                      \
+  X(ICTMR) X(ICM) X(ICI) X(ICC32) X(ICOV) X(ICBNE)                           \
+  X(MVEC) X(INT0EP) X(INT1EP) X(INT2EP) X(INT3EP) X(INT4EP)                  \
+  X(CTIP) X(CTIS) X(INT0IP) X(INT0IS) X(T1IP) X(T1IS)                        \
+  X(IC1IP) X(IC1IS) X(IC2IP) X(IC2IS) X(IC3IP) X(IC3IS) X(IC4IP) X(IC4IS)    \
+  X(IC5IP) X(IC5IS) X(T2IP) X(T2IS) X(T3IP) X(T3IS) X(T4IP) X(T4IS)          \
+  X(T5IP) X(T5IS) X(OC1IP) X(OC1IS) X(AD1IP) X(AD1IS) X(SPI1IP) X(SPI1IS)    \
+  X(U1IP) X(U1IS) X(CNIP) X(CNIS) X(DMA0IP) X(DMA0IS)                        \
+  X(DMA1IP) X(DMA1IS) X(DMA3IP) X(DMA3IS)                                    \
+  X(ASAM) X(CLRASAM) X(SSRC) X(FORM) X(DONE) X(SAMP)                         \
+  X(BUFM) X(BUFS) X(CSCNA) X(SMPI) X(VCFG) X(ADCS) X(SAMC) X(ADRC)           \
+  X(SRXISEL) X(STXISEL) X(SPITBF) X(SPITBE) X(SPIROV) X(SPIBUSY) X(SRMT)     \
+  X(SPIRBE)                                                                  \
+  X(BRGH) X(UTXEN) X(URXEN) X(UTXBF) X(TRMT) X(OERR) X(FERR)                 \
+  X(UTXISEL) X(URXISEL) X(PDSEL) X(STSEL)                                    \
+  X(CNIEA0) X(CNIEA1) X(CNIEA2) X(CNIEA3) X(CNIEA4)                          \
+  X(CNIEB0) X(CNIEB1) X(CNIEB2) X(CNIEB3) X(CNIEB4) X(CNIEB5) X(CNIEB6)      \
+  X(CNIEB7) X(CNIEB8) X(CNIEB9) X(CNIEB10) X(CNIEB11) X(CNIEB12)             \
+  X(CNIEB13) X(CNIEB14) X(CNIEB15) X(CNPUB7)                                 \
+  X(TRISA0) X(TRISA1) X(TRISA2) X(TRISA3) X(TRISA4)                          \
+  X(TRISB0) X(TRISB1) X(TRISB2) X(TRISB3) X(TRISB4) X(TRISB5) X(TRISB6)      \
+  X(TRISB7) X(TRISB8) X(TRISB9) X(TRISB10) X(TRISB11) X(TRISB12)             \
+  X(TRISB13) X(TRISB14) X(TRISB15)                                           \
+  X(LATA0) X(LATA1) X(LATA2) X(LATA3) X(LATA4)                               \
+  X(LATB0) X(LATB1) X(LATB2) X(LATB3) X(LATB4) X(LATB5) X(LATB6) X(LATB7)    \
+  X(LATB8) X(LATB9) X(LATB10) X(LATB11) X(LATB12) X(LATB13) X(LATB14)        \
+  X(LATB15)                                                                  \
+  X(RA0) X(RA1) X(RA2) X(RA3) X(RA4)                                         \
+  X(RB0) X(RB1) X(RB2) X(RB3) X(RB4) X(RB5) X(RB6) X(RB7) X(RB8) X(RB9)      \
+  X(RB10) X(RB11) X(RB12) X(RB13) X(RB14) X(RB15)                            \
+  X(ANSA0) X(ANSA1) X(ANSB0) X(ANSB1) X(ANSB2) X(ANSB3) X(ANSB12)            \
+  X(ANSB13) X(ANSB14) X(ANSB15)
+
+#define HOST_BIT_FIELD(Name) uint32_t Name;
+typedef struct
+{
+  HOST_BIT_FIELDS(HOST_BIT_FIELD)
+} HostBits_t;
+
+#define HOST_BITS_LIST(X)                                                    \
+  X(T1CONbits) X(T2CONbits) X(T3CONbits) X(T4CONbits) X(T5CONbits)           \
+  X(INTCONbits) X(IPC0bits) X(IPC1bits) X(IPC2bits) X(IPC3bits) X(IPC4bits)  \
+  X(IPC5bits) X(IPC6bits) X(IPC7bits) X(IPC8bits) X(IPC9bits)                \
+  X(AD1CON1bits) X(AD1CON2bits) X(AD1CON3bits)                               \
+  X(SPI2STATbits) X(U1MODEbits)                                              \
+  X(CNENAbits) X(CNENBbits) X(CNCONAbits) X(CNCONBbits) X(CNPUBbits)         \
+  X(TRISAbits) X(TRISBbits) X(LATAbits) X(LATBbits) X(PORTAbits)             \
+  X(PORTBbits) X(ANSELAbits) X(ANSELBbits)
+
+#define HOST_BITS_DECLARE(Name) extern volatile HostBits_t Name;
+HOST_BITS_LIST(HOST_BITS_DECLARE)
+
+/*--------------- registers the libraries reach through pointers ------------*/
+// PWM_PIC32.c & PIC32_SPI_HAL.c cast the address of the word to these, so
+// they have to fit in it
+typedef struct
+{
+  uint32_t OCM:3;
+  uint32_t OCTSEL:1;
+  uint32_t OCFLT:1;
+  uint32_t OC32:1;
+  uint32_t :7;
+  uint32_t SIDL:1;
+  uint32_t :1;
+  uint32_t ON:1;
+  uint32_t :16;
+} __OC1CONbits_t;
+
+typedef struct
+{
+  uint32_t SRXISEL:2;
+  uint32_t STXISEL:2;
+  uint32_t DISSDI:1;
+  uint32_t MSTEN:1;
+  uint32_t CKP:1;
+  uint32_t SSEN:1;
+  uint32_t CKE:1;
+  uint32_t SMP:1;
+  uint32_t MODE16:1;
+  uint32_t MODE32:1;
+  uint32_t DISSDO:1;
+  uint32_t SIDL:1;
+  uint32_t :1;
+  uint32_t ON:1;
+  uint32_t ENHBUF:1;
+  uint32_t SPIFE:1;
+  uint32_t :5;
+  uint32_t MCLKSEL:1;
+  uint32_t FRMCNT:3;
+  uint32_t FRMSYPW:1;
+  uint32_t MSSEN:1;
+  uint32_t FRMPOL:1;
+  uint32_t FRMSYNC:1;
+  uint32_t FRMEN:1;
+} __SPI1CONbits_t;
+
+typedef struct
+{
+  uint32_t AUDMOD:2;
+  uint32_t :1;
+  uint32_t AUDMONO:1;
+  uint32_t :3;
+  uint32_t AUDEN:1;
+  uint32_t IGNTUR:1;
+  uint32_t IGNROV:1;
+  uint32_t SPITUREN:1;
+  uint32_t SPIROVEN:1;
+  uint32_t FRMERREN:1;
+  uint32_t :2;
+  uint32_t SPISGNEXT:1;
+  uint32_t :16;
+} __SPI1CON2bits_t;
+
+typedef union { uint32_t w; __OC1CONbits_t b; } HostOCCON_t;
+typedef union { uint32_t w; __SPI1CONbits_t b; } HostSPICON_t;
+typedef union { uint32_t w; __SPI1CON2bits_t b; } HostSPICON2_t;
+
+extern volatile HostOCCON_t HostOCCON[5];
+#define OC1CON      (HostOCCON[0].w)
+#define OC2CON      (HostOCCON[1].w)
+#define OC3CON      (HostOCCON[2].w)
+#define OC4CON      (HostOCCON[3].w)
+#define OC5CON      (HostOCCON[4].w)
+#define OC1CONbits  (HostOCCON[0].b)
+#define OC2CONbits  (HostOCCON[1].b)
+#define OC3CONbits  (HostOCCON[2].b)
+#define OC4CONbits  (HostOCCON[3].b)
+#define OC5CONbits  (HostOCCON[4].b)
+
+extern volatile HostSPICON_t HostSPICON[2];
+extern volatile HostSPICON2_t HostSPICON2[2];
+#define SPI1CON      (HostSPICON[0].w)
+#define SPI2CON      (HostSPICON[1].w)
+#define SPI1CONbits  (HostSPICON[0].b)
+#define SPI2CONbits  (HostSPICON[1].b)
+#define SPI1CON2     (HostSPICON2[0].w)
+#define SPI2CON2     (HostSPICON2[1].w)
+
+/*------------------------- interrupt flags & enables -----------------------*/
+// bit positions of the IFS/IEC words, the same for both
+typedef struct
+{
+  uint32_t CTIF:1, CS0IF:1, CS1IF:1, INT0IF:1, T1IF:1, IC1EIF:1, IC1IF:1,
+      OC1IF:1, INT1IF:1, T2IF:1, IC2EIF:1, IC2IF:1, OC2IF:1, INT2IF:1,
+      T3IF:1, IC3EIF:1, IC3IF:1, OC3IF:1, INT3IF:1, T4IF:1, IC4EIF:1,
+      IC4IF:1, OC4IF:1, INT4IF:1, T5IF:1, IC5EIF:1, IC5IF:1, OC5IF:1,
+      AD1IF:1, FSCMIF:1, RTCCIF:1, FCEIF:1;
+} HostIFS0bits_t;
+
+typedef struct
+{
+  uint32_t CMP1IF:1, CMP2IF:1, CMP3IF:1, USBIF:1, SPI1EIF:1, SPI1RXIF:1,
+      SPI1TXIF:1, U1EIF:1, U1RXIF:1, U1TXIF:1, I2C1BIF:1, I2C1SIF:1,
+      I2C1MIF:1, CNAIF:1, CNBIF:1, CNCIF:1, PMPIF:1, PMPEIF:1, SPI2EIF:1,
+      SPI2RXIF:1, SPI2TXIF:1, U2EIF:1, U2RXIF:1, U2TXIF:1, I2C2BIF:1,
+      I2C2SIF:1, I2C2MIF:1, CTMUIF:1, DMA0IF:1, DMA1IF:1, DMA2IF:1,
+      DMA3IF:1;
+} HostIFS1bits_t;
+
+typedef struct
+{
+  uint32_t CTIE:1, CS0IE:1, CS1IE:1, INT0IE:1, T1IE:1, IC1EIE:1, IC1IE:1,
+      OC1IE:1, INT1IE:1, T2IE:1, IC2EIE:1, IC2IE:1, OC2IE:1, INT2IE:1,
+      T3IE:1, IC3EIE:1, IC3IE:1, OC3IE:1, INT3IE:1, T4IE:1, IC4EIE:1,
+      IC4IE:1, OC4IE:1, INT4IE:1, T5IE:1, IC5EIE:1, IC5IE:1, OC5IE:1,
+      AD1IE:1, FSCMIE:1, RTCCIE:1, FCEIE:1;
+} HostIEC0bits_t;
+
+typedef struct
+{
+  uint32_t CMP1IE:1, CMP2IE:1, CMP3IE:1, USBIE:1, SPI1EIE:1, SPI1RXIE:1,
+      SPI1TXIE:1, U1EIE:1, U1RXIE:1, U1TXIE:1, I2C1BIE:1, I2C1SIE:1,
+      I2C1MIE:1, CNAIE:1, CNBIE:1, CNCIE:1, PMPIE:1, PMPEIE:1, SPI2EIE:1,
+      SPI2RXIE:1, SPI2TXIE:1, U2EIE:1, U2RXIE:1, U2TXIE:1, I2C2BIE:1,
+      I2C2SIE:1, I2C2MIE:1, CTMUIE:1, DMA0IE:1, DMA1IE:1, DMA2IE:1,
+      DMA3IE:1;
+} HostIEC1bits_t;
+
+typedef struct
+{
+  union { uint32_t w; HostIFS0bits_t b; } Ifs0;
+  union { uint32_t w; HostIFS1bits_t b; } Ifs1;
+  union { uint32_t w; HostIEC0bits_t b; } Iec0;
+  union { uint32_t w; HostIEC1bits_t b; } Iec1;
+} HostIntRegs_t;
+
+typedef enum { HOST_IFS0, HOST_IFS1, HOST_IEC0, HOST_IEC1 } HostIntReg_t;
+typedef enum { HOST_OP_SET, HOST_OP_CLR, HOST_OP_INV } HostIntOp_t;
+
+// a write to a SET/CLR/INV register lands in a pending word, every access
+// to the flags & enables applies it first
+volatile HostIntRegs_t *HostSim_IntRegs(void);
+volatile uint32_t *HostSim_IntOp(HostIntReg_t Which, HostIntOp_t Op);
+
+#define IFS0      (HostSim_IntRegs()->Ifs0.w)
+#define IFS1      (HostSim_IntRegs()->Ifs1.w)
+#define IEC0      (HostSim_IntRegs()->Iec0.w)
+#define IEC1      (HostSim_IntRegs()->Iec1.w)
+#define IFS0bits  (HostSim_IntRegs()->Ifs0.b)
+#define IFS1bits  (HostSim_IntRegs()->Ifs1.b)
+#define IEC0bits  (HostSim_IntRegs()->Iec0.b)
+#define IEC1bits  (HostSim_IntRegs()->Iec1.b)
+#define IFS0SET   (*HostSim_IntOp(HOST_IFS0, HOST_OP_SET))
+#define IFS0CLR   (*HostSim_IntOp(HOST_IFS0, HOST_OP_CLR))
+#define IFS0INV   (*HostSim_IntOp(HOST_IFS0, HOST_OP_INV))
+#define IFS1SET   (*HostSim_IntOp(HOST_IFS1, HOST_OP_SET))
+#define IFS1CLR   (*HostSim_IntOp(HOST_IFS1, HOST_OP_CLR))
+#define IFS1INV   (*HostSim_IntOp(HOST_IFS1, HOST_OP_INV))
+#define IEC0SET   (*HostSim_IntOp(HOST_IEC0, HOST_OP_SET))
+#define IEC0CLR   (*HostSim_IntOp(HOST_IEC0, HOST_OP_CLR))
+#define IEC0INV   (*HostSim_IntOp(HOST_IEC0, HOST_OP_INV))
+#define IEC1SET   (*HostSim_IntOp(HOST_IEC1, HOST_OP_SET))
+#define IEC1CLR   (*HostSim_IntOp(HOST_IEC1, HOST_OP_CLR))
+#define IEC1INV   (*HostSim_IntOp(HOST_IEC1, HOST_OP_INV))
+
+#define HOST_IFS0_MASK(Bit)  (1u << (Bit))
+#define _IFS0_CTIF_MASK     HOST_IFS0_MASK(0)
+#define _IFS0_INT0IF_MASK   HOST_IFS0_MASK(3)
+#define _IFS0_T1IF_MASK     HOST_IFS0_MASK(4)
+#define _IFS0_IC1IF_MASK    HOST_IFS0_MASK(6)
+#define _IFS0_OC1IF_MASK    HOST_IFS0_MASK(7)
+#define _IFS0_INT1IF_MASK   HOST_IFS0_MASK(8)
+#define _IFS0_T2IF_MASK     HOST_IFS0_MASK(9)
+#define _IFS0_IC2IF_MASK    HOST_IFS0_MASK(11)
+#define _IFS0_T3IF_MASK     HOST_IFS0_MASK(14)
+#define _IFS0_IC3IF_MASK    HOST_IFS0_MASK(16)
+#define _IFS0_T4IF_MASK     HOST_IFS0_MASK(19)
+#define _IFS0_IC4IF_MASK    HOST_IFS0_MASK(21)
+#define _IFS0_INT4IF_MASK   HOST_IFS0_MASK(23)
+#define _IFS0_T5IF_MASK     HOST_IFS0_MASK(24)
+#define _IFS0_IC5IF_MASK    HOST_IFS0_MASK(26)
+#define _IFS0_AD1IF_MASK    HOST_IFS0_MASK(28)
+#define _IEC0_CTIE_MASK     _IFS0_CTIF_MASK
+#define _IEC0_INT0IE_MASK   _IFS0_INT0IF_MASK
+#define _IEC0_T1IE_MASK     _IFS0_T1IF_MASK
+#define _IEC0_IC1IE_MASK    _IFS0_IC1IF_MASK
+#define _IEC0_OC1IE_MASK    _IFS0_OC1IF_MASK
+#define _IEC0_INT1IE_MASK   _IFS0_INT1IF_MASK
+#define _IEC0_T2IE_MASK     _IFS0_T2IF_MASK
+#define _IEC0_IC2IE_MASK    _IFS0_IC2IF_MASK
+#define _IEC0_T3IE_MASK     _IFS0_T3IF_MASK
+#define _IEC0_IC3IE_MASK    _IFS0_IC3IF_MASK
+#define _IEC0_T4IE_MASK     _IFS0_T4IF_MASK
+#define _IEC0_IC4IE_MASK    _IFS0_IC4IF_MASK
+#define _IEC0_INT4IE_MASK   _IFS0_INT4IF_MASK
+#define _IEC0_T5IE_MASK     _IFS0_T5IF_MASK
+#define _IEC0_IC5IE_MASK    _IFS0_IC5IF_MASK
+#define _IEC0_AD1IE_MASK    _IFS0_AD1IF_MASK
+#define _IFS1_SPI1EIF_MASK  (1u << 4)
+#define _IFS1_SPI1RXIF_MASK (1u << 5)
+#define _IFS1_SPI1TXIF_MASK (1u << 6)
+#define _IFS1_U1EIF_MASK    (1u << 7)
+#define _IFS1_U1RXIF_MASK   (1u << 8)
+#define _IFS1_U1TXIF_MASK   (1u << 9)
+#define _IFS1_CNBIF_MASK    (1u << 14)
+#define _IFS1_SPI2RXIF_MASK (1u << 19)
+#define _IFS1_DMA0IF_MASK   (1u << 28)
+#define _IFS1_DMA1IF_MASK   (1u << 29)
+#define _IFS1_DMA3IF_MASK   (1u << 31)
+#define _IEC1_SPI1EIE_MASK  _IFS1_SPI1EIF_MASK
+#define _IEC1_SPI1RXIE_MASK _IFS1_SPI1RXIF_MASK
+#define _IEC1_SPI1TXIE_MASK _IFS1_SPI1TXIF_MASK
+#define _IEC1_U1RXIE_MASK   _IFS1_U1RXIF_MASK
+#define _IEC1_CNBIE_MASK    _IFS1_CNBIF_MASK
+#define _IEC1_SPI2RXIE_MASK _IFS1_SPI2RXIF_MASK
+#define _IEC1_DMA0IE_MASK   _IFS1_DMA0IF_MASK
+#define _IEC1_DMA1IE_MASK   _IFS1_DMA1IF_MASK
+#define _IEC1_DMA3IE_MASK   _IFS1_DMA3IF_MASK
+#define _SPI1STAT_SPIROV_MASK (1u << 6)
+#define _SPI2STAT_SPIROV_MASK (1u << 6)
+
+// DMA start IRQs & the bits the SPI HAL uses
+#define _SPI1_RX_IRQ 37
+#define _SPI1_TX_IRQ 38
+#define _SPI2_RX_IRQ 51
+#define _SPI2_TX_IRQ 52
+#define _DMACON_ON_MASK (1u << 15)
+#define _DCH0CON_CHEN_MASK (1u << 7)
+#define _DCH0ECON_SIRQEN_MASK (1u << 4)
+#define _DCH0ECON_CFORCE_MASK (1u << 7)
+#define _DCH0ECON_CHSIRQ_POSITION 8
+#define _DCH0INT_CHBCIF_MASK (1u << 3)
+#define _DCH0INT_CHBCIE_MASK (1u << 19)
+#define _NVMCON_WR_MASK (1u << 15)
+#define _NVMCON_WREN_MASK (1u << 14)
+#define _NVMCON_WRERR_MASK (1u << 13)
+#define _NVMCON_LVDERR_MASK (1u << 12)
+#define _CFGCON_PMDLOCK_MASK (1u << 12)
+#define _PMD1_AD1MD_MASK  (1u << 0)
+#define _PMD1_CTMUMD_MASK (1u << 8)
+#define _PMD1_CVRMD_MASK  (1u << 12)
+#define _PMD2_CMP1MD_MASK (1u << 0)
+#define _PMD2_CMP2MD_MASK (1u << 1)
+#define _PMD2_CMP3MD_MASK (1u << 2)
+#define _PMD3_IC1MD_MASK  (1u << 0)
+#define _PMD3_IC3MD_MASK  (1u << 2)
+#define _PMD3_IC4MD_MASK  (1u << 3)
+#define _PMD3_OC1MD_MASK  (1u << 16)
+#define _PMD3_OC2MD_MASK  (1u << 17)
+#define _PMD3_OC3MD_MASK  (1u << 18)
+#define _PMD3_OC4MD_MASK  (1u << 19)
+#define _PMD3_OC5MD_MASK  (1u << 20)
+#define _PMD4_T2MD_MASK   (1u << 1)
+#define _PMD5_U2MD_MASK   (1u << 1)
+#define _PMD5_SPI2MD_MASK (1u << 9)
+#define _PMD5_I2C1MD_MASK (1u << 16)
+#define _PMD5_I2C2MD_MASK (1u << 17)
+#define _PMD6_REFOMD_MASK (1u << 0)
+#define _PMD6_PMPMD_MASK  (1u << 16)
+
+/*------------------------- registers that move on --------------------------*/
+volatile uint32_t *HostSim_TMR(uint8_t Which);
+#define TMR1 (*HostSim_TMR(1))
+#define TMR2 (*HostSim_TMR(2))
+#define TMR3 (*HostSim_TMR(3))
+#define TMR4 (*HostSim_TMR(4))
+#define TMR5 (*HostSim_TMR(5))
+
+// reading ICxBUF takes the oldest capture out of the FIFO, ICBNE is worked
+// out every time the bits are looked at
+typedef struct
+{
+  uint32_t ICM, ICBNE, ICOV, ICTMR, ICI, ICC32, SIDL, ON, FEDGE;
+} HostICCONbits_t;
+volatile HostICCONbits_t *HostSim_ICCONbits(uint8_t Which);
+volatile uint32_t *HostSim_ICBUF(uint8_t Which);
+#define IC1CONbits (*HostSim_ICCONbits(1))
+#define IC2CONbits (*HostSim_ICCONbits(2))
+#define IC3CONbits (*HostSim_ICCONbits(3))
+#define IC4CONbits (*HostSim_ICCONbits(4))
+#define IC5CONbits (*HostSim_ICCONbits(5))
+#define IC1BUF (*HostSim_ICBUF(1))
+#define IC2BUF (*HostSim_ICBUF(2))
+#define IC3BUF (*HostSim_ICBUF(3))
+#define IC4BUF (*HostSim_ICBUF(4))
+#define IC5BUF (*HostSim_ICBUF(5))
+
+typedef struct
+{
+  uint32_t SPIRBF, SPITBF, SPITBE, SPIRBE, SPIROV, SRMT, SPITUR, SPIBUSY,
+      TXBUFELM, RXBUFELM;
+} HostSPISTATbits_t;
+volatile HostSPISTATbits_t *HostSim_SPI1STATbits(void);
+volatile uint32_t *HostSim_SPI1BUF(void);
+#define SPI1STATbits (*HostSim_SPI1STATbits())
+#define SPI1BUF (*HostSim_SPI1BUF())
+
+typedef struct
+{
+  uint32_t URXDA, OERR, FERR, PERR, RIDLE, ADDEN, URXISEL, TRMT, UTXBF,
+      UTXEN, UTXBRK, URXEN, UTXINV, UTXISEL;
+} HostU1STAbits_t;
+volatile HostU1STAbits_t *HostSim_U1STAbits(void);
+#define U1STAbits (*HostSim_U1STAbits())
+
+// 16 result words 4 words apart, as on the part
+extern volatile uint32_t HostADC1BUF[16 * 4];
+#define ADC1BUF0 (HostADC1BUF[0])
+#define ADC1BUF8 (HostADC1BUF[8 * 4])
+
+/*------------------------------- core timer --------------------------------*/
+// the core timer counts the simulated time at 20MHz
+uint32_t _CP0_GET_COUNT(void);
+void _CP0_SET_COUNT(uint32_t Count);
+uint32_t _CP0_GET_COMPARE(void);
+void _CP0_SET_COMPARE(uint32_t Compare);
+uint32_t _CP0_GET_DEBUG(void);
+void _CP0_SET_DEBUG(uint32_t Debug);
+#define _CP0_DEBUG_COUNTDM_MASK (1u << 25)
+
+// the simulation has no interrupts to turn off, the ISRs run between passes
+// of ES_Run
+#define __builtin_disable_interrupts() ((void)0)
+#define __builtin_enable_interrupts() ((void)0)
+#define _wait() ((void)0)
+#define _nop() ((void)0)
+#define __reentrant
+
+#endif /* HOST_XC_H */
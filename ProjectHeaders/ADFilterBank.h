@@ -0,0 +1,52 @@
+/****************************************************************************
+ Module
+     ADFilterBank.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the fixed-point filter bank over the A/D scan set.
+
+ Notes
+     Each channel runs a moving average, then a first order IIR, then a
+     hysteresis band on the value it reports. Lengths and the IIR constant
+     are powers of 2 so every step is an add, subtract or shift. Channels
+     are numbered in scan order, the lowest numbered ANx pin is channel 0,
+     the same as ADC_MultiRead.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef ADFilterBank_H
+#define ADFilterBank_H
+
+#include "ES_Types.h"
+
+// same limit as PIC32_AD_Lib, the A/D result buffer holds 8 channels
+#define AD_FILTER_MAX_CHANNELS 8
+
+// longest moving average is 1 << AD_FILTER_MAX_AVERAGE_SHIFT samples
+#define AD_FILTER_MAX_AVERAGE_SHIFT 4
+
+// longest IIR time constant, y += (x - y) >> IIRShift
+#define AD_FILTER_MAX_IIR_SHIFT 7
+
+typedef struct
+{
+  uint8_t  AverageShift;  // average over 1 << AverageShift samples, 0 = off
+  uint8_t  IIRShift;      // IIR smoothing, 0 = off
+  uint16_t Hysteresis;    // counts the output must move before it is reported
+} ADFilterConfig_t;
+
+bool ADFilter_Init(uint8_t NumChannels);
+bool ADFilter_Configure(uint8_t Channel, const ADFilterConfig_t *pConfig);
+uint8_t ADFilter_AddSet(const uint16_t *pSet);
+uint8_t ADFilter_AddBlock(const uint16_t *pBlock, uint8_t NumSets);
+uint16_t ADFilter_GetValue(uint8_t Channel);
+uint16_t ADFilter_GetFiltered(uint8_t Channel);
+
+#endif /* ADFilterBank_H */
@@ -0,0 +1,53 @@
+/****************************************************************************
+ Module
+     BeaconBearing.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the beacon bearing estimator, which finds the heading
+     of the beacon from the sightings made during a turn on the spot.
+
+ Notes
+     MainLogicFSM starts a sweep of BEARING_SWEEP_CAPTURES, a full turn,
+     hands each ES_BEACON_DETECTED that BeaconDetect_TakeSighting keeps to
+     BeaconBearing_AddSighting, with its edge time, & asks for the peak
+     once the sweep is done. Headings are in encoder captures of
+     the sweep, from where it started, the way SpeedControlService measures
+     a turn.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  AddSighting takes the edge time
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef BeaconBearing_H
+#define BeaconBearing_H
+
+#include "ES_Types.h"
+#include "SpeedControlService.h"
+
+// one full turn, so the beacon is passed wherever it is
+#define BEARING_SWEEP_CAPTURES TURN_CAPTURES(360)
+
+// bins round the sweep, each is 360 / BEARING_NUM_BINS degrees
+#define BEARING_NUM_BINS 32
+// bins either side of the fullest that go into the centroid
+#define BEARING_PEAK_HALF_WIDTH 2
+
+// fewer sightings than this in a sweep & there is no bearing
+#define BEARING_MIN_SIGHTINGS 3
+
+// the strength of a sighting from a sender that doesn't give one
+#define BEARING_FULL_STRENGTH 255
+
+void BeaconBearing_StartSweep(void);
+void BeaconBearing_AddSighting(uint8_t Strength, uint32_t EdgeTime);
+bool BeaconBearing_GetPeak(uint32_t *pCaptures);
+uint16_t BeaconBearing_GetSightings(void);
+uint32_t BeaconBearing_GetHeading(void);
+
+#endif /* BeaconBearing_H */
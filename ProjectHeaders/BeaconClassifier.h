@@ -0,0 +1,64 @@
+/****************************************************************************
+ Module
+     BeaconClassifier.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the multi-beacon period histogram classifier used by
+     BeaconDetectService.
+
+ Notes
+     The beacons are listed in BeaconTable in BeaconClassifier.c. The period
+     window for each one is worked out by the compiler from its frequency,
+     so adding a beacon costs no run time divides.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  BEACON_TICK_HZ follows the capture time base
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef BeaconClassifier_H
+#define BeaconClassifier_H
+
+#include "ES_Types.h"
+#include "CaptureTimebase.h"
+
+// rate of the time stamps handed to BeaconClassifier_AddEdge
+#define BEACON_TICK_HZ CAPTURE_TIMEBASE_HZ
+
+// number of periods in a classification window, must be a power of 2
+#define BEACON_WINDOW_SHIFT 5
+#define BEACON_WINDOW_EDGES (1 << BEACON_WINDOW_SHIFT)
+
+// a period is counted for a beacon if it is within this many percent
+#define BEACON_TOLERANCE_PCT 4
+
+// confidence (0-255, the share of the window in the winning bin) needed
+// before a detection is reported
+#define BEACON_MIN_CONFIDENCE 160
+
+// beacon IDs, in the same order as BeaconTable
+typedef enum
+{
+  BEACON_ID_1427HZ = 0,   // the Lab 8 beacon
+  BEACON_ID_909HZ,
+  BEACON_ID_2000HZ,
+  BEACON_ID_3333HZ,
+  NUM_BEACON_IDS
+} BeaconId_t;
+
+// packing of the ES_BEACON_DETECTED EventParam
+#define BEACON_PARAM(Id, Confidence) \
+    ((uint16_t)(((uint16_t)(Id) << 8) | (uint8_t)(Confidence)))
+#define BEACON_PARAM_ID(Param) ((BeaconId_t)((Param) >> 8))
+#define BEACON_PARAM_CONFIDENCE(Param) ((uint8_t)((Param) & 0xFF))
+
+void BeaconClassifier_Reset(void);
+bool BeaconClassifier_AddEdge(uint32_t EdgeTime);
+bool BeaconClassifier_GetResult(BeaconId_t *pId, uint8_t *pConfidence);
+
+#endif /* BeaconClassifier_H */
@@ -11,19 +11,48 @@
      between edges is used to calculate frequency. When frequency is close
      to 1427Hz, an ES_BEACON_DETECTED event is posted.
 
+     The frequency is reported every BEACON_REPORT_MS, at LOG_INFO only when
+     it has moved by more than BEACON_REPORT_DEADBAND_HZ or come or gone, &
+     at LOG_DEBUG the rest of the time.
+
+     The beacon input pin publishes its own ES_BEACON_DETECTED, from the
+     change notice ISR (Ports.c), with a confidence of 0 in its EventParam.
+     BeaconDetect_TakeSighting fuses the two for a subscriber: while the
+     capture path has had a detection in the last BEACON_LOCK_MS the pin's
+     events are dropped, its time stamps are the better ones, & when it
+     hasn't the pin's are taken, so a beacon the classifier can't lock onto
+     is still seen.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Throttled frequency reports, BeaconDetect_TakeSighting
+ 02/03/26       Tianyu  Initial creation for Lab 8 beacon detection
  ****************************************************************************/
 
 #ifndef BeaconDetectService_H
 #define BeaconDetectService_H
 
 #include "ES_Types.h"
+#include "ES_Events.h"
 #include <xc.h>
 
+// how often the frequency is worked out & reported
+#define BEACON_REPORT_MS 250
+// a change smaller than this isn't worth a line of the log
+#define BEACON_REPORT_DEADBAND_HZ 10
+
+// the capture path is taken to have the beacon for this long after its
+// last detection, a few windows at the slowest beacon
+#define BEACON_LOCK_MS 150
+
 // Public Function Prototypes
 
 bool InitBeaconDetectService(uint8_t Priority);
 bool PostBeaconDetectService(ES_Event_t ThisEvent);
 ES_Event_t RunBeaconDetectService(ES_Event_t ThisEvent);
 
+bool BeaconDetect_TakeSighting(ES_Event_t ThisEvent, uint32_t *pEdgeTime);
+
 
 #endif /* BeaconDetectService_H */
@@ -0,0 +1,79 @@
+/****************************************************************************
+ Module
+     CaptureTimebase.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the shared 32 bit input capture time base.
+
+ Notes
+     Timer3 free runs at PBCLK/8 over its full 16 bits and its rollovers are
+     counted to make a 32 bit time. Every input capture channel that selects
+     Timer3 (ICTMR = 0) turns its 16 bit ICxBUF values into 32 bit time
+     stamps with CaptureTimebase_Extend, from any interrupt priority, with
+     no critical region.
+
+     A capture has to be extended within one Timer3 period (26mS) of being
+     taken, which any ISR that drains its FIFO will easily meet.
+
+     The 32 bit time wraps every 28 minutes, so compare time stamps by
+     subtracting them, never with < or >.
+
+     With CAPTURE_TIMEBASE_32BIT defined, Timer2 & Timer3 are paired into
+     one 32 bit timer at PBCLK/1 instead, the captures are 32 bits (ICC32)
+     and there is no rollover interrupt at all. Extend just hands the
+     capture back. On the PIC32MX170 the output compares can only run from
+     Timer2 or Timer3, so this can't be used while the OC PWM is, see
+     DCMotorService.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Added CAPTURE_TIMEBASE_NOW & CAPTURE_TIMEBASE_TO_CORE
+ 10/14/26       Tianyu  Added CAPTURE_TIMEBASE_32BIT, Timer2/3 paired
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef CaptureTimebase_H
+#define CaptureTimebase_H
+
+#include "ES_Types.h"
+#include "CommonDefinitions.h"
+
+// Uncomment to pair Timer2 & Timer3 & capture 32 bits at PBCLK/1
+// #define CAPTURE_TIMEBASE_32BIT
+
+#ifdef CAPTURE_TIMEBASE_32BIT
+#define CAPTURE_TIMEBASE_PRESCALE 1
+#define CAPTURE_TIMEBASE_ICC32 1    // for ICxCONbits.ICC32
+typedef uint32_t CaptureRaw_t;      // what comes out of ICxBUF
+#else
+#define CAPTURE_TIMEBASE_PRESCALE 8
+#define CAPTURE_TIMEBASE_ICC32 0
+typedef uint16_t CaptureRaw_t;
+#endif
+
+#define CAPTURE_TIMEBASE_HZ (PBCLK_FREQ / CAPTURE_TIMEBASE_PRESCALE)
+
+// the raw time base as it is now, to compare with an ICxBUF value, & a
+// difference of raw times in core timer counts. Needs <xc.h>
+#ifdef CAPTURE_TIMEBASE_32BIT
+#define CAPTURE_TIMEBASE_NOW() ((CaptureRaw_t)TMR2)
+#else
+#define CAPTURE_TIMEBASE_NOW() ((CaptureRaw_t)TMR3)
+#endif
+#define CAPTURE_TIMEBASE_TO_CORE(Ticks) \
+  ((uint32_t)(Ticks) * (CORE_TIMER_FREQ / CAPTURE_TIMEBASE_HZ))
+
+// the 16 bit build's rollover interrupt has to be at or above every ISR that reads the
+// time, so that none of them can land between it clearing T3IF & counting.
+// It is a handful of instructions every 26mS
+#define CAPTURE_TIMEBASE_PRIORITY 7
+
+void CaptureTimebase_Init(void);
+uint32_t CaptureTimebase_GetTime(void);
+uint32_t CaptureTimebase_Extend(CaptureRaw_t Captured);
+
+#endif /* CaptureTimebase_H */
@@ -0,0 +1,76 @@
+/****************************************************************************
+ Module
+     CommandFrame.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the framed command protocol of the SPI command link,
+     & its parser.
+
+ Notes
+     A frame is COMMAND_FRAME_SYNC, an opcode, the opcode's argument bytes
+     & a CRC-8 (Crc_Crc8) of the opcode & the arguments:
+
+       SYNC  OPCODE  ARG0 .. ARGn-1  CRC
+
+     Each opcode is a row of COMMAND_FRAME_TABLE, which gives the number of
+     argument bytes it takes. 16 bit arguments are low byte first. A frame
+     that decodes gives a CommandRequest_t for CommandPipeline.
+
+     The parser is fed one byte at a time & does the same small amount of
+     work for every byte, so the replies can be run through it as they
+     come. Bytes between frames are skipped until the next sync. A frame
+     with a bad CRC, an opcode that isn't in the table right after a sync
+     or arguments that don't make a command is dropped & counted, & the
+     parser looks for the next sync.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef CommandFrame_H
+#define CommandFrame_H
+
+#include "ES_Types.h"
+#include "CommandPipeline.h"
+
+#define COMMAND_FRAME_SYNC 0xA5
+
+// One X(Name, Opcode, ArgBytes) row for each kind of frame, each needs a
+// Decode<Name> in CommandFrame.c
+//  Command:     the command byte, run as CommandTable has it
+//  CommandArgs: the command byte, the speed in wheel RPM (Q8.8, up to
+//               SPEED_FULL_RPM) & the distance in encoder captures, 0
+//               for the table's own
+#define COMMAND_FRAME_TABLE(X) \
+  X(Command,     0x01, 1)      \
+  X(CommandArgs, 0x02, 5)
+
+// the most argument bytes any opcode takes
+#define COMMAND_FRAME_MAX_ARGS 5
+// sync, opcode, arguments & CRC
+#define COMMAND_FRAME_MAX_BYTES (COMMAND_FRAME_MAX_ARGS + 3)
+
+typedef struct
+{
+  uint8_t  State;
+  uint8_t  Opcode;
+  uint8_t  ArgBytes;    // the opcode takes
+  uint8_t  NumArgs;     // come in so far
+  uint8_t  Crc;
+  uint8_t  Args[COMMAND_FRAME_MAX_ARGS];
+  uint16_t BadFrames;
+} CommandFrameParser_t;
+
+// Public Function Prototypes
+
+void CommandFrame_InitParser(CommandFrameParser_t *pParser);
+bool CommandFrame_Parse(CommandFrameParser_t *pParser, uint8_t Byte,
+                        CommandRequest_t *pRequest);
+uint8_t CommandFrame_BytesToGo(const CommandFrameParser_t *pParser);
+
+#endif /* CommandFrame_H */
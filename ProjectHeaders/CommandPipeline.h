@@ -0,0 +1,58 @@
+/****************************************************************************
+ Module
+     CommandPipeline.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the ring of retrieved commands waiting to be run.
+
+ Notes
+     CommandRetrieveService puts each new command in the ring and
+     MainLogicFSM takes them out in order as its sequencer gets to them.
+     SerialCommandService also puts commands. Every writer is a service,
+     so one can't come in part way through another & no side needs a
+     critical region.
+
+     Each entry is a CommandRequest_t, the command byte & the arguments a
+     command frame can give it (CommandFrame.h). A plain command byte has
+     none, it runs as CommandTable has it.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Added CommandPipeline_Peek & CommandPipeline_Discard,
+                        for a stop to skip the commands ahead of it
+ 10/14/26       Tianyu  Entries carry speed & distance arguments
+ 10/14/26       Tianyu  CommandRetrieveService writes from its run function
+ 10/14/26       Tianyu  SerialCommandService is a second writer
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef CommandPipeline_H
+#define CommandPipeline_H
+
+#include "ES_Types.h"
+
+// commands that can wait, must be a power of 2
+#define COMMAND_PIPELINE_DEPTH 8
+
+// a command & its arguments, an argument of 0 leaves the CommandTable's
+typedef struct
+{
+  uint8_t  Command;   // a validated command byte
+  uint16_t SpeedQ8;   // wheel RPM, Q8.8
+  uint16_t Distance;  // encoder captures, a move with one ends by itself
+} CommandRequest_t;
+
+void CommandPipeline_Init(void);
+bool CommandPipeline_Put(uint8_t Command);
+bool CommandPipeline_PutRequest(const CommandRequest_t *pRequest);
+bool CommandPipeline_Take(CommandRequest_t *pRequest);
+bool CommandPipeline_Peek(uint8_t Index, CommandRequest_t *pRequest);
+void CommandPipeline_Discard(uint8_t Count);
+uint8_t CommandPipeline_Count(void);
+uint16_t CommandPipeline_GetDropped(void);
+
+#endif /* CommandPipeline_H */
@@ -9,10 +9,18 @@
      Header file for the SPI Command Retrieve Service.
 
  Notes
+     CommandRetrieve_PollFast puts the command generator back on its
+     fastest poll, for a caller that knows a command is wanted soon.
+
+     CommandRetrieve_Inject runs a byte through the same framing, or frame
+     parser, as a reply to a poll, for the HIL harness. Call it from a
+     service, never an ISR.
 
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       Tianyu  Added CommandRetrieve_Inject
+ 10/14/26       Tianyu  Added CommandRetrieve_PollFast
  02/03/26       Tianyu  Initial creation for Lab 8 command retrieval
 *****************************************************************************/
 
@@ -27,4 +35,7 @@ bool InitCommandRetrieveService(uint8_t Priority);
 bool PostCommandRetrieveService(ES_Event_t ThisEvent);
 ES_Event_t RunCommandRetrieveService(ES_Event_t ThisEvent);
 
+void CommandRetrieve_PollFast(void);
+void CommandRetrieve_Inject(uint8_t Reply);
+
 #endif /* CommandRetrieveService_H */
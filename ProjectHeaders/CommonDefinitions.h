@@ -12,6 +12,14 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       Tianyu  Dropped TIMING_PIN_LAT, RB15 is PulseCaptureService's
+ 10/14/26       Tianyu  BEACON_ALIGN_MS covers a whole sweep & the turn
+                        back to the beacon
+ 10/14/26       Tianyu  Added CORE_TIMER_FREQ
+ 10/14/26       Tianyu  Commands defined once in COMMAND_LIST, which
+                        generates Command_t & the 256 entry CommandTable
+ 10/14/26       Tianyu  Added LINE_LOST_MS
+ 10/14/26       Tianyu  PWM ticks rescaled for the PWM library's 1:8 Timer2
  01/28/26       Tianyu  Initial creation for Lab 7
 ****************************************************************************/
 
@@ -35,29 +43,67 @@ typedef enum {
   PRESCALE_256
 } Prescale_t;
 
+// What MainLogicFSM does with a command, picks the state that runs it.
+// 0 is kept for bytes that aren't commands
 typedef enum
 {
-    CMD_STOP = 0x00,
-    CMD_ROTATE_CW_90 = 0x02,
-    CMD_ROTATE_CW_45 = 0x03,
-    CMD_ROTATE_CCW_90 = 0x04,
-    CMD_ROTATE_CCW_45 = 0x05,
-    CMD_DRIVE_FWD_HALF = 0x08,
-    CMD_DRIVE_FWD_FULL = 0x09,
-    CMD_DRIVE_REV_HALF = 0x10,
-    CMD_DRIVE_REV_FULL = 0x11,
-    CMD_ALIGN_BEACON = 0x20,
-    CMD_SEARCH_TAPE = 0x40
-    
+  CMD_ACTION_INVALID = 0,
+  CMD_ACTION_STOP,
+  CMD_ACTION_MOVE,
+  CMD_ACTION_ALIGN_BEACON,
+  CMD_ACTION_SEARCH_TAPE,
+  NUM_CMD_ACTIONS
+} CommandAction_t;
+
+// Every command, add new ones here. Speeds (wheel RPM, Q16.16) and
+// distances (encoder captures) are in SpeedControlService.h terms, the
+// names are only expanded in CommonDefinitions.c. A move with a distance
+// is a turn, it ends by itself. The backstop is its timer, 0 for none.
+//
+//  Name                Byte  Action                   Speed           Left     Right    Distance                Backstop (ms)
+#define COMMAND_LIST(X) \
+  X(CMD_STOP,           0x00, CMD_ACTION_STOP,         0,              FORWARD, FORWARD, SPEED_CONTROL_NO_LIMIT, 0)                 \
+  X(CMD_ROTATE_CW_90,   0x02, CMD_ACTION_MOVE,         SPEED_TURN_RPM, FORWARD, REVERSE, TURN_CAPTURES(90),      SIMPLE_MOVE_90_MS) \
+  X(CMD_ROTATE_CW_45,   0x03, CMD_ACTION_MOVE,         SPEED_TURN_RPM, FORWARD, REVERSE, TURN_CAPTURES(45),      SIMPLE_MOVE_45_MS) \
+  X(CMD_ROTATE_CCW_90,  0x04, CMD_ACTION_MOVE,         SPEED_TURN_RPM, REVERSE, FORWARD, TURN_CAPTURES(90),      SIMPLE_MOVE_90_MS) \
+  X(CMD_ROTATE_CCW_45,  0x05, CMD_ACTION_MOVE,         SPEED_TURN_RPM, REVERSE, FORWARD, TURN_CAPTURES(45),      SIMPLE_MOVE_45_MS) \
+  X(CMD_DRIVE_FWD_HALF, 0x08, CMD_ACTION_MOVE,         SPEED_HALF_RPM, FORWARD, FORWARD, SPEED_CONTROL_NO_LIMIT, 0)                 \
+  X(CMD_DRIVE_FWD_FULL, 0x09, CMD_ACTION_MOVE,         SPEED_FULL_RPM, FORWARD, FORWARD, SPEED_CONTROL_NO_LIMIT, 0)                 \
+  X(CMD_DRIVE_REV_HALF, 0x10, CMD_ACTION_MOVE,         SPEED_HALF_RPM, REVERSE, REVERSE, SPEED_CONTROL_NO_LIMIT, 0)                 \
+  X(CMD_DRIVE_REV_FULL, 0x11, CMD_ACTION_MOVE,         SPEED_FULL_RPM, REVERSE, REVERSE, SPEED_CONTROL_NO_LIMIT, 0)                 \
+  X(CMD_ALIGN_BEACON,   0x20, CMD_ACTION_ALIGN_BEACON, SPEED_TURN_RPM, FORWARD, REVERSE, SPEED_CONTROL_NO_LIMIT, BEACON_ALIGN_MS)   \
+  X(CMD_SEARCH_TAPE,    0x40, CMD_ACTION_SEARCH_TAPE,  SPEED_FULL_RPM, FORWARD, FORWARD, SPEED_CONTROL_NO_LIMIT, 0)
+
+#define COMMAND_ENUM(Name, Byte, Action, Speed, Left, Right, Distance, \
+    BackstopMs) Name = Byte,
+
+typedef enum
+{
+  COMMAND_LIST(COMMAND_ENUM)
 } Command_t;
 
-extern const uint8_t validCommandBytes[11];
+// One per byte, bytes that aren't commands are all 0 (CMD_ACTION_INVALID)
+typedef struct
+{
+  uint8_t  Action;      // CommandAction_t
+  uint8_t  DirLeft;
+  uint8_t  DirRight;
+  uint32_t Speed;       // wheel RPM, Q16.16
+  uint32_t Distance;    // encoder captures, SPEED_CONTROL_NO_LIMIT to run on
+  uint16_t BackstopMs;  // 0 for no timer
+} CommandDesc_t;
+
+extern const CommandDesc_t CommandTable[256];
+
+#define COMMAND_IS_VALID(Byte) \
+  (CommandTable[(uint8_t)(Byte)].Action != CMD_ACTION_INVALID)
 
 // Prescale lookup table (maps enum to hardware register bits)
 extern const uint8_t PrescaleLookup[];
 
 // System clock configuration
 #define PBCLK_FREQ 20000000         // 20 MHz peripheral bus clock
+#define CORE_TIMER_FREQ 20000000    // the core timer runs at SYSCLK/2
 
 // Motor specifications
 #define MAX_RPM 32                 // Maximum motor RPM
@@ -74,12 +120,10 @@ extern const uint8_t PrescaleLookup[];
 #define SECONDS_PER_MINUTE 60       // Conversion factor for RPM calculations
 
 // PWM configuration (shared between DCMotorService and SpeedControlService)
-#define DUTY_MAX_TICKS 2000        // Maximum duty cycle ticks (100%)
-#define PWM_PERIOD_TICKS 1999        // PWM period in timer ticks (for 5kHz at 20MHz PBCLK with 1:2 prescale)
+#define DUTY_MAX_TICKS 500         // Maximum duty cycle ticks (100%)
+#define PWM_PERIOD_TICKS 499        // PWM period in timer ticks (for 5kHz at 20MHz PBCLK with the PWM library's 1:8 prescale)
 #define DUTY_MIN_TICKS 0            // Minimum duty cycle ticks (0%)
 
-#define TIMING_PIN_LAT LATBbits.LATB15
-
 // Motor Indexes
 #define LEFT_MOTOR 0
 #define RIGHT_MOTOR 1
@@ -89,14 +133,16 @@ extern const uint8_t PrescaleLookup[];
 #define REVERSE 1
 
 // Speed Levels (duty cycle ticks)
-#define HALF_SPEED 1500   // 50% duty cycle
-#define FULL_SPEED 2000   // 100% duty cycle
-
-// Timer Durations (ms)
-#define SIMPLE_MOVE_90_MS 1500
-#define SIMPLE_MOVE_45_MS 750
-#define BEACON_ALIGN_MS 5000
+#define HALF_SPEED 375    // 75% duty cycle
+#define FULL_SPEED 500    // 100% duty cycle
+
+// Timer Durations (ms). Turns end on distance (SpeedControlService), the
+// turn times are only a backstop in case an encoder isn't counting
+#define SIMPLE_MOVE_90_MS 3000
+#define SIMPLE_MOVE_45_MS 1500
+#define BEACON_ALIGN_MS 15000
 #define TAPE_SEARCH_MS 10000
+#define LINE_LOST_MS 300      // line following gives up after losing it this long
 
 // Debug Pin
 #define DEBUG_OUTPUT_PIN_LAT LATBbits.LATB15
@@ -118,7 +164,8 @@ extern const uint8_t PrescaleLookup[];
 
  Description
      Converts encoder period measurement to RPM. Shared by EncoderService
-     and SpeedControlService.
+     and SpeedControlService. Uses floats, so it is best kept for printing;
+     the control loop should use FP_PeriodToRPM in FixedPointUnits.h
 ****************************************************************************/
 float PeriodToRPM(uint32_t period);
 
@@ -134,7 +181,8 @@ float PeriodToRPM(uint32_t period);
 
  Description
      Converts ADC value to desired RPM setpoint. Shared by ADService
-     and SpeedControlService.
+     and SpeedControlService. See FP_ADToRPM in FixedPointUnits.h for the
+     fixed point version
 ****************************************************************************/
 float ADToRPM(uint16_t adcValue);
 
@@ -0,0 +1,38 @@
+/****************************************************************************
+ Module
+     Crc.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the CRCs shared by the telemetry frames, the
+     parameter store & the command frames.
+
+ Notes
+     CRC-16/CCITT-FALSE: polynomial 0x1021, starting from 0xFFFF, no
+     reflection & no final XOR. "123456789" gives 0x29B1.
+
+     CRC-8/SMBUS: polynomial 0x07, starting from 0x00, no reflection & no
+     final XOR. "123456789" gives 0xF4. A byte at a time it is a constant
+     time step, for the command frame parser.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Added Crc_Crc8 for the command frames
+ 10/14/26       Tianyu  Initial creation, from TelemetryService's Crc16
+*****************************************************************************/
+
+#ifndef Crc_H
+#define Crc_H
+
+#include <stdint.h>
+
+#define CRC16_INITIAL 0xFFFF
+#define CRC8_INITIAL 0x00
+
+uint16_t Crc_Ccitt16(uint16_t Crc, const uint8_t *pData, uint16_t Length);
+uint8_t Crc_Crc8(uint8_t Crc, const uint8_t *pData, uint16_t Length);
+
+#endif /* Crc_H */
@@ -13,6 +13,14 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       Tianyu  Added DCMotor_PowerDown & DCMotor_PowerUp
+ 10/14/26       Tianyu  Added DCMotor_EmergencyStop & its release
+ 10/14/26       Tianyu  Added DCMotor_GetOutput
+ 10/14/26       Tianyu  Slew rate rescaled for 1:8 PWM ticks
+ 10/14/26       Tianyu  Added DCMotor_RampTo & DCMotor_SetSlewRate
+ 10/14/26       Tianyu  DCMotor_SetOutputs replaces DCMotor_ApplyDuty,
+                        MotorCommandWrapper reports a failed post
+ 10/14/26       Tianyu  Added DCMotor_ApplyDuty
  02/03/26       Tianyu  Updated for Lab 8 two-motor control
 *****************************************************************************/
 
@@ -21,12 +29,27 @@
 
 #include "ES_Types.h"
 
+// default slew rate for DCMotor_RampTo, duty ticks per mS (full scale in
+// about 50mS)
+#define MOTOR_SLEW_TICKS_PER_MS 10
+
 // Public Function Prototypes
 
 bool InitDCMotorService(uint8_t Priority);
 bool PostDCMotorService(ES_Event_t ThisEvent);
 ES_Event_t RunDCMotorService(ES_Event_t ThisEvent);
-void MotorCommandWrapper(uint16_t speedLeft, uint16_t speedRight,
+bool MotorCommandWrapper(uint16_t speedLeft, uint16_t speedRight,
                          uint8_t dirLeft, uint8_t dirRight);
+void DCMotor_SetOutputs(uint16_t dutyLeft, uint16_t dutyRight,
+                        uint8_t dirLeft, uint8_t dirRight);
+void DCMotor_RampTo(uint16_t dutyLeft, uint16_t dutyRight,
+                    uint8_t dirLeft, uint8_t dirRight);
+void DCMotor_SetSlewRate(uint16_t ticksPerMs);
+void DCMotor_GetOutput(uint8_t motor, uint16_t *pDuty, uint8_t *pDirection);
+void DCMotor_EmergencyStop(void);
+void DCMotor_ReleaseEmergencyStop(void);
+bool DCMotor_IsStopLatched(void);
+void DCMotor_PowerDown(void);
+void DCMotor_PowerUp(void);
 
 #endif /* DCMotorService_H */
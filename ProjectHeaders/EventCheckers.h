@@ -8,6 +8,7 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 23:50 ty       Check4InputChanges replaces Check4BeaconDetected
  10/18/15 11:50 jec      added #include for stdint & stdbool
  08/06/13 14:37 jec      started coding
 *****************************************************************************/
@@ -24,6 +25,6 @@
 bool Check4Keystroke(void);
 bool Check4TapeDetected(void);
 bool Check4CommandAvailable(void);
-bool Check4BeaconDetected(void);
+bool Check4InputChanges(void);
 
 #endif /* EventCheckers_H */
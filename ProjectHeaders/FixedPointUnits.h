@@ -0,0 +1,70 @@
+/****************************************************************************
+ Module
+     FixedPointUnits.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the divide-free, fixed-point unit conversions.
+
+ Notes
+     Speeds are unsigned Q16.16 (FP_Q16_t), 16 integer bits & 16 fraction
+     bits. All of the constants are worked out by the compiler from
+     PBCLK_FREQ, ENCODER_TIMER_PRESCALE & IC_ENCODER_EDGES_PER_REV in
+     CommonDefinitions.h, so changing those keeps the conversions right.
+
+     Angles are binary (FP_Angle_t), FP_ANGLE_TURN of them to a full turn,
+     so adding & subtracting them wraps the way an angle does. FP_Sin &
+     FP_Cos give a signed Q16.16 result, FP_TRIG_ONE is 1.0.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Added FP_Sin & FP_Cos for the odometry
+ 10/14/26       Tianyu  Added FP_Sqrt for the motion profiles
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef FixedPointUnits_H
+#define FixedPointUnits_H
+
+#include <stdint.h>
+#include "CommonDefinitions.h"
+
+typedef uint32_t FP_Q16_t;
+
+#define FP_Q16_SHIFT 16
+#define FP_Q16_ONE ((FP_Q16_t)1 << FP_Q16_SHIFT)
+#define FP_INT_TO_Q16(x) ((FP_Q16_t)(x) << FP_Q16_SHIFT)
+#define FP_Q16_TO_INT(x) ((uint32_t)(x) >> FP_Q16_SHIFT)
+// rounded to the nearest integer
+#define FP_Q16_ROUND(x) (((uint32_t)(x) + (FP_Q16_ONE >> 1)) >> FP_Q16_SHIFT)
+
+typedef uint16_t FP_Angle_t;
+
+#define FP_ANGLE_TURN 65536u
+#define FP_TRIG_ONE ((int32_t)1 << FP_Q16_SHIFT)
+
+// encoder timer ticks per second
+#define FP_ENCODER_TICK_HZ (PBCLK_FREQ / ENCODER_TIMER_PRESCALE)
+
+// RPM = FP_RPM_PERIOD_CONST / period, in Q16.16
+#define FP_RPM_PERIOD_CONST_Q16 \
+  ((uint32_t)((((uint64_t)FP_ENCODER_TICK_HZ * SECONDS_PER_MINUTE) << \
+      FP_Q16_SHIFT) / IC_ENCODER_EDGES_PER_REV))
+
+// RPM per A/D count, in Q16.16
+#define FP_RPM_PER_AD_COUNT_Q16 \
+  ((uint32_t)((((uint64_t)MAX_RPM << FP_Q16_SHIFT) + (ADC_MAX_VALUE / 2)) / \
+      ADC_MAX_VALUE))
+
+uint32_t FP_Divide(uint32_t Numerator, uint32_t Denominator);
+FP_Q16_t FP_PeriodToRPM(uint32_t Period);
+FP_Q16_t FP_ADToRPM(uint16_t ADValue);
+uint32_t FP_PeriodToHz(uint32_t Period, uint32_t TickHz);
+uint32_t FP_Sqrt(uint32_t Value);
+int32_t FP_Sin(FP_Angle_t Angle);
+int32_t FP_Cos(FP_Angle_t Angle);
+
+#endif /* FixedPointUnits_H */
@@ -0,0 +1,141 @@
+/****************************************************************************
+ Module
+     HilHarness.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the hardware in the loop regression harness run from
+     TestHarnessService0. It plays HIL_SCRIPT_TABLE into the framework,
+     logs every write of the motor registers with its time & compares the
+     log against HIL_GOLDEN_TABLE.
+
+ Notes
+     A script row is a command generator reply, run through the same
+     framing or frame parser as a polled one (CommandRetrieve_Inject), or
+     a synthetic beacon or tape edge, published as the event its checker
+     would publish. The rows are played from TIMER_A of ES_ShortTimer at
+     their AtUs from the start of the run, & how late each one went in is
+     kept, so the report can tell the harness's own jitter from a change
+     in the robot's.
+
+     DCMotorService calls HIL_MOTOR_WRITTEN after each write of OC1RS,
+     OC2RS or the direction pins. The ramps & the speed control loop write
+     the duty every few PWM periods, so a write is only logged if it
+     changes the pins, moves a duty register HIL_LOG_STEP or more from the
+     one logged before it or takes one to 0. That keeps a run to a few
+     dozen rows, & the steps come at much the same values from one run to
+     the next.
+
+     HIL_RUN_US after the start the log is compared row by row with the
+     golden trace. A row passes if its registers are within
+     HIL_DUTY_TOLERANCE & its time within HIL_TIME_TOLERANCE_US of the
+     golden row's. 'h' runs the script & reports, 'g' prints the last log
+     as HIL_GOLDEN_TABLE rows, to paste in here once a run is known good.
+
+     Run it straight after a reset, with the command generator unplugged,
+     the wheels off the ground & the tape sensors off the line, so the
+     only inputs are the script's. The golden rows below were recorded
+     with the HostSim build, which has no motors & whose LATBINV doesn't
+     change LATB, so record them again on the robot.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef HilHarness_H
+#define HilHarness_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+
+// the kinds of script row. Value is the reply byte, the beacon event's
+// EventParam (0 as from the plain input), 1 for found & 0 for lost, or the
+// (int16_t) line position
+#define HIL_SPI     0
+#define HIL_BEACON  1
+#define HIL_TAPE    2
+#define HIL_LINE    3
+
+// One X(AtUs, Kind, Value) row for each stimulus, in time order
+#define HIL_SCRIPT_TABLE(X)                                                   \
+  X(0,       HIL_SPI,    0xFF)                                                \
+  X(0,       HIL_SPI,    CMD_SEARCH_TAPE)                                     \
+  X(400000,  HIL_TAPE,   1)                                                   \
+  X(450000,  HIL_LINE,   200)                                                 \
+  X(500000,  HIL_LINE,   -200)                                                \
+  X(550000,  HIL_TAPE,   0)                                                   \
+  X(700000,  HIL_SPI,    0xFF)                                                \
+  X(700000,  HIL_SPI,    CMD_STOP)                                            \
+  X(900000,  HIL_SPI,    0xFF)                                                \
+  X(900000,  HIL_SPI,    CMD_ALIGN_BEACON)                                    \
+  X(1200000, HIL_BEACON, 0)                                                   \
+  X(1500000, HIL_SPI,    0xFF)                                                \
+  X(1500000, HIL_SPI,    CMD_STOP)
+
+// how long a run logs for, after the start
+#define HIL_RUN_US 2000000u
+
+// One X(AtUs, Oc1rs, Oc2rs, LatB) row for each logged write, LatB is the
+// four motor pins' bits of LATB
+#define HIL_GOLDEN_TABLE(X)                                                   \
+  X(0, 0, 0, 0)                                                               \
+  X(11200, 65, 65, 0)                                                         \
+  X(21200, 130, 130, 0)                                                       \
+  X(30600, 194, 194, 0)                                                       \
+  X(40000, 259, 259, 0)                                                       \
+  X(49000, 324, 324, 0)                                                       \
+  X(57600, 388, 388, 0)                                                       \
+  X(66200, 453, 453, 0)                                                       \
+  X(468200, 500, 388, 0)                                                      \
+  X(481000, 500, 323, 0)                                                      \
+  X(492600, 500, 259, 0)                                                      \
+  X(515000, 500, 323, 0)                                                      \
+  X(524200, 500, 388, 0)                                                      \
+  X(533000, 500, 452, 0)                                                      \
+  X(560200, 436, 500, 0)                                                      \
+  X(573000, 372, 500, 0)                                                      \
+  X(585200, 308, 500, 0)                                                      \
+  X(597000, 243, 500, 0)                                                      \
+  X(900000, 0, 0, 0)                                                          \
+  X(900000, 2, 498, 0)                                                        \
+  X(906400, 66, 434, 0)                                                       \
+  X(912800, 130, 370, 0)                                                      \
+  X(919200, 194, 306, 0)                                                      \
+  X(925600, 258, 242, 0)                                                      \
+  X(932000, 322, 178, 0)                                                      \
+  X(938400, 386, 114, 0)                                                      \
+  X(944800, 450, 50, 0)                                                       \
+  X(949800, 500, 0, 0)
+
+#define HIL_TIME_TOLERANCE_US 2000u
+#define HIL_DUTY_TOLERANCE 20u
+
+// the change of a duty register, in PWM ticks, that is logged
+#define HIL_LOG_STEP 64u
+
+// writes logged in a run, any more fail it
+#define HIL_LOG_DEPTH 64
+
+// Public Function Prototypes
+
+#ifdef USE_HIL_HARNESS
+
+void HilHarness_Start(void);
+bool HilHarness_IsRunning(void);
+void HilHarness_Step(void);
+void HilHarness_DumpGolden(void);
+void HilHarness_MotorWritten(uint16_t LatB);
+
+#define HIL_MOTOR_WRITTEN(LatB) HilHarness_MotorWritten(LatB)
+
+#else
+
+#define HIL_MOTOR_WRITTEN(LatB) ((void)0)
+
+#endif /* USE_HIL_HARNESS */
+
+#endif /* HilHarness_H */
@@ -13,6 +13,7 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       Tianyu  Added FollowingLine
  02/03/26       Tianyu  Initial creation for Lab 8 main logic
 *****************************************************************************/
 
@@ -27,7 +28,8 @@ typedef enum
   Stopped,
   SimpleMoving,
   SearchingForTape,
-  AligningWithBeacon
+  AligningWithBeacon,
+  FollowingLine
 } MainLogicState_t;
 
 bool InitMainLogicFSM(uint8_t Priority);
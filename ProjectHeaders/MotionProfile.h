@@ -0,0 +1,54 @@
+/****************************************************************************
+ Module
+     MotionProfile.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the trapezoidal speed profiles that the speed control
+     loop runs each wheel's moves on.
+
+ Notes
+     A profile gives the speed a wheel should have now. It climbs to the
+     cruise speed at PROFILE_ACCEL_RPM_PER_S & drops back at the same rate,
+     and in a move with a distance it never goes faster than the speed it
+     could still stop from in what is left, so the wheel brakes along
+     v = sqrt(2 a d) & arrives at PROFILE_END_RPM. A move too short to
+     reach its cruise speed turns into a triangle on its own.
+
+     MotionProfile_Step is called once a control loop pass, from the ISR.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef MotionProfile_H
+#define MotionProfile_H
+
+#include "ES_Types.h"
+#include "FixedPointUnits.h"
+
+// the rate MotionProfile_Step is called at, the control loop's
+#define PROFILE_RATE_HZ 1000
+
+// speeding up & slowing down, full speed in about 120mS
+#define PROFILE_ACCEL_RPM_PER_S 240
+// the speed at the end of a move, enough to get over the last capture
+#define PROFILE_END_RPM FP_INT_TO_Q16(8)
+
+typedef struct
+{
+  FP_Q16_t Cruise;    // the speed the move asked for
+  FP_Q16_t Setpoint;  // where the profile is now
+  uint32_t Goal;      // captures, SPEED_CONTROL_NO_LIMIT for no end
+} MotionProfile_t;
+
+void MotionProfile_Start(MotionProfile_t *pProfile, FP_Q16_t Cruise,
+                         uint32_t Goal, FP_Q16_t From);
+FP_Q16_t MotionProfile_Step(MotionProfile_t *pProfile, uint32_t Captures);
+FP_Q16_t MotionProfile_StopSpeed(uint32_t Remaining);
+
+#endif /* MotionProfile_H */
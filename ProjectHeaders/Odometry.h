@@ -0,0 +1,77 @@
+/****************************************************************************
+ Module
+     Odometry.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the dead reckoning of the robot's pose, (x, y, heading),
+     from the wheel encoders.
+
+ Notes
+     The pose is from where the robot was at reset, or at the last
+     Odometry_SetPose: x straight ahead of it, y to its left & the heading
+     counter-clockwise from x. X & Y are mm in signed Q16.16, good for 32m
+     either way. The heading is a 32 bit binary angle, 2^32 to a full turn,
+     so it wraps the way an angle does, the top 16 bits of it are an
+     FP_Angle_t.
+
+     Odometry_Step is called from the speed control loop ISR at
+     ODOMETRY_RATE_HZ, with each wheel's odometer, captures counted up or
+     down by the commanded direction. The encoders are single channel, so a
+     wheel pushed backwards while driven forwards counts forwards.
+
+     Odometry_GetPose can be called from anywhere below the control loop's
+     IPL. It takes a consistent copy without locking the loop out, it goes
+     again if a step came in part way through.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef Odometry_H
+#define Odometry_H
+
+#include "ES_Types.h"
+#include "FixedPointUnits.h"
+#include "SpeedControlService.h"
+
+// the rate Odometry_Step is called at, a whole number of control loop passes
+#define ODOMETRY_RATE_HZ 250
+
+// mm the middle of the axle moves per capture of one wheel, Q16.16. Half a
+// wheel circumference per capture, pi as 355/113
+#define ODOMETRY_HALF_MM_PER_CAPTURE_Q16 \
+  ((int32_t)((((uint64_t)WHEEL_DIAMETER_MM * 355) << FP_Q16_SHIFT) / \
+      (113 * 2 * IC_ENCODER_EDGES_PER_REV)))
+
+// heading change per capture of difference between the wheels, a circumference
+// per capture over the track is radians, this is it over 2 pi, times 2^32
+#define ODOMETRY_HEADING_PER_CAPTURE \
+  ((int32_t)(((uint64_t)WHEEL_DIAMETER_MM << 31) / \
+      ((uint64_t)IC_ENCODER_EDGES_PER_REV * WHEEL_TRACK_MM)))
+
+// a heading in whole degrees, 0 to 359
+#define ODOMETRY_HEADING_TO_DEG(Heading) \
+  ((uint32_t)(((uint64_t)(Heading) * 360) >> 32))
+// & as an FP_Angle_t, for FP_Sin & FP_Cos
+#define ODOMETRY_HEADING_TO_ANGLE(Heading) ((FP_Angle_t)((Heading) >> 16))
+
+typedef struct
+{
+  int32_t  X;        // mm, Q16.16
+  int32_t  Y;        // mm, Q16.16
+  uint32_t Heading;  // 2^32 to a turn, counter-clockwise from X
+} Pose_t;
+
+// Public Function Prototypes
+
+void Odometry_Init(int32_t OdometerLeft, int32_t OdometerRight);
+void Odometry_Step(int32_t OdometerLeft, int32_t OdometerRight);
+void Odometry_GetPose(Pose_t *pPose);
+void Odometry_SetPose(const Pose_t *pPose);
+
+#endif /* Odometry_H */
@@ -12,6 +12,7 @@
  When           Who     What/Why
  -------------- ---     --------
 
+ 10/14/26 17:40 ty      added the interrupt driven streaming mode
  10/20/20 17:38 jec     Began Coding
 ****************************************************************************/
 /*----------------------------- Include Files -----------------------------*/
@@ -21,7 +22,23 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// scan sets in each streaming block, must be a power of 2 so a block can
+// be averaged with a shift
+#define ADC_STREAM_BLOCK_SHIFT 4
+#define ADC_STREAM_BLOCK_SETS (1 << ADC_STREAM_BLOCK_SHIFT)
+// the ADC interrupt priority for streaming
+#define ADC_STREAM_PRIORITY 3
+
+// called from the ADC ISR each time a block is complete
+typedef void (*ADC_BlockReadyFunc_t)(void);
+
 bool ADC_ConfigAutoScan( uint16_t whichPins);
 void ADC_MultiRead(uint32_t *adcResults);
+bool ADC_ConfigStreaming( uint16_t whichPins, uint16_t setRateHz,
+                          ADC_BlockReadyFunc_t blockReadyFunc);
+const uint16_t *ADC_GetBlock(void);
+void ADC_ReleaseBlock(void);
+void ADC_AverageBlock(const uint16_t *pBlock, uint32_t *adcResults);
+uint16_t ADC_GetOverruns(void);
 
 #endif  //PIC_32_Lib_H
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define PIC32_SPI_HAL
 
 #include <stdbool.h> 
+#include <stdint.h>
 
 typedef enum { 
     SPI_SPI1 = 0, 
@@ -54,6 +55,19 @@ typedef enum {
     SPI_32BIT = 2
 } SPI_XferWidth_t;
 
+// DMA transfers (SPIOperate_Transfer). Each module has a pair of channels,
+// the receive channel's block interrupt ends the transfer:
+//   SPI1: DCH1 receive, DCH2 transmit
+//   SPI2: DCH3 receive, DCH0 transmit, so only without TERMINAL_DMA_TX
+// sent in place of the transmit data when the transmit buffer is NULL
+#define SPI_TRANSFER_FILL 0xFF
+// the DMA interrupt priority, the same as the SPI1 command ISR
+#define SPI_TRANSFER_PRIORITY 4
+
+// called from the DMA ISR when a transfer is complete, this is where the
+// caller posts its ES_SPI_TRANSFER_DONE, with the module as the EventParam
+typedef void (*SPI_XferDoneFunc_t)(SPI_Module_t WhichModule);
+
 /****************************************************************************
  Function
     SPISetup_BasicConfig
@@ -581,5 +595,59 @@ Example
 ****************************************************************************/
 bool SPIOperate_HasSS2_Risen(void);
 
+/****************************************************************************
+ Function
+    SPIOperate_Transfer
+
+ Parameters
+   SPI_Module_t: Which SPI module to run the transfer on
+   const void *: the data to send, or NULL to send SPI_TRANSFER_FILL
+   void *: where the data received goes, may be the same as the data to send
+   uint16_t: the length of the transfer in bytes, a multiple of the width
+   SPI_XferDoneFunc_t: called from the ISR when the transfer is complete,
+   may be NULL
+
+ Returns
+   bool: true if the transfer was started; false if the module is illegal
+   or has a transfer running, the receive buffer is NULL or the length is
+   not a whole number of words
+
+ Description
+   Starts a full-duplex transfer of Length bytes through the DMA & returns
+   at once. A word goes out each time the transmit buffer empties & each
+   word received is stored, so the transfer is over when the last word is
+   in, not when it was sent. The module must be enabled as the leader with
+   the width already set. Both buffers must stay put until the callback.
+   The module's own receive interrupt is held off while the transfer runs
+   & anything left in the receive buffer beforehand is thrown away. Slave
+   selects other than the module's own SS are up to the caller.
+
+Example
+   SPIOperate_Transfer(SPI_SPI1, Query, Reply, sizeof(Reply), ReplyDone);
+****************************************************************************/
+bool SPIOperate_Transfer(SPI_Module_t WhichModule, const void *pTxData,
+                         void *pRxData, uint16_t Length,
+                         SPI_XferDoneFunc_t pDoneFunc);
+
+/****************************************************************************
+ Function
+    SPIOperate_IsTransferBusy
+
+ Parameters
+   SPI_Module_t: Which SPI module to test
+
+ Returns
+   bool: true if a DMA transfer started on the module is still running;
+   otherwise, false
+
+ Description
+   For a caller polling rather than using the completion callback.
+
+Example
+   if(false == SPIOperate_IsTransferBusy(SPI_SPI1))
+       ;
+****************************************************************************/
+bool SPIOperate_IsTransferBusy(SPI_Module_t WhichModule);
+
 
 #endif //PIC32_SPI_HAL defined
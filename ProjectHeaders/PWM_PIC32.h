@@ -11,6 +11,8 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       ty      Added PWMOperate_SetPulseWidthOnChannels to update
+                        several channels in one call
  10/19/21       jec     Started port from Tiva version
 *****************************************************************************/
 #include <stdint.h>
@@ -48,6 +50,9 @@ typedef enum {
         PWM_RPB15
 } PWM_PinMap_t;
 
+// bit for a channel (1-5) in the channel mask for the multi-channel calls
+#define PWM_CHANNEL_BIT(channel) ((uint8_t)(1 << ((channel) - 1)))
+
 /****************************************************************************
  Function
     PWMSetup_BasicConfig
@@ -214,4 +219,34 @@ Example
 ****************************************************************************/
 bool PWMOperate_SetPulseWidthOnChannel( uint16_t NewPW, uint8_t channel);
 
+/****************************************************************************
+ Function
+   PWMOperate_SetPulseWidthOnChannels
+
+ Parameters
+   uint8_t: mask of the channels to update, built from PWM_CHANNEL_BIT
+   const uint16_t *: the new pulse widths, one for each channel in the mask,
+             lowest numbered channel first. 0 to one more than the period
+             of the channel's timer, which gives 100% duty
+
+ Returns
+   bool: true if all of the channels and pulse widths are legal; 
+   otherwise, false and no channel is changed
+  
+ Description
+   programs the rise time of several outputs in one call. Every value is
+   checked before any of them are written, so the channels change together
+   at the next period boundary of their timers, or not at all.
+
+ Note:
+   safe to call from an ISR
+
+Example
+   uint16_t Widths[2] = {100, 400};
+   PWMOperate_SetPulseWidthOnChannels(PWM_CHANNEL_BIT(1) | PWM_CHANNEL_BIT(2),
+                                      Widths);
+****************************************************************************/
+bool PWMOperate_SetPulseWidthOnChannels( uint8_t WhichChannels,
+                                         const uint16_t *pNewPWs);
+
 #endif //_PWM_PIC32_H
@@ -0,0 +1,74 @@
+/****************************************************************************
+ Module
+     ParamStore.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the parameter store, which keeps the calibration &
+     tuning values in a page of program flash so that a tuned robot boots
+     tuned.
+
+ Notes
+     Every parameter is a row of PARAM_TABLE, X(Name, Default, Min, Max,
+     Apply), a uint16_t that is always between Min & Max. Apply is called
+     with each new value from ParamStore_Set, or is NULL for a parameter
+     that its user reads each time it needs it. Services read theirs with
+     ParamStore_Get(PARAM_ID(Name)) in their init.
+
+     ParamStore_Init, before ES_Initialize, takes the values from the flash
+     block if its magic, version, count & CRC-16 are all good & every value
+     is in range, else it keeps the defaults. ParamStore_Set only changes
+     the RAM copy, ParamStore_Save writes it all back.
+
+     A save erases a flash page, which stalls the CPU for ~20mS with the
+     interrupts off. Only save with the motors stopped.
+
+     Changing the meaning of a row, or removing one, must bump
+     PARAM_STORE_VERSION so an old block isn't taken for a new one.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef ParamStore_H
+#define ParamStore_H
+
+#include "ES_Types.h"
+#include "CommonDefinitions.h"
+#include "DCMotorService.h"
+#include "TelemetryService.h"
+
+#define PARAM_STORE_VERSION 1
+
+// the SET names. SPEEDPCT scales the command speeds in percent & TURNTRIM
+// the turn distances in thousandths, to make up for the wheelbase & wheels
+//  Name      Default                  Min  Max             Apply
+#define PARAM_TABLE(X)                                                        \
+  X(SLEW,     MOTOR_SLEW_TICKS_PER_MS, 0,   DUTY_MAX_TICKS, DCMotor_SetSlewRate) \
+  X(TELEM,    TELEMETRY_PERIOD_MS,     0,   60000,          Telemetry_SetPeriod) \
+  X(LINELOST, LINE_LOST_MS,            10,  10000,          NULL)             \
+  X(SPEEDPCT, 100,                     10,  100,            NULL)             \
+  X(TURNTRIM, 1000,                    500, 1500,           NULL)
+
+#define PARAM_ID(Name) PARAM_##Name
+#define PARAM_ID_ROW(Name, Default, Min, Max, Apply) PARAM_ID(Name),
+typedef enum
+{
+  PARAM_TABLE(PARAM_ID_ROW)
+  NUM_PARAMS
+} ParamId_t;
+
+// Public Function Prototypes
+
+bool ParamStore_Init(void);
+uint16_t ParamStore_Get(ParamId_t Id);
+bool ParamStore_Set(ParamId_t Id, uint16_t Value);
+bool ParamStore_Find(const char *pName, ParamId_t *pId);
+void ParamStore_Defaults(void);
+bool ParamStore_Save(void);
+
+#endif /* ParamStore_H */
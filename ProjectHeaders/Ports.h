@@ -9,10 +9,21 @@
      Centralized port initialization and read helpers.
 
  Notes
+     The polled digital inputs are rows of DIGITAL_INPUT_TABLE. They are
+     read together, both ports in one pass, as a scan word with port B in
+     the low half & port A in the high half, each bit 1 while its input is
+     active. The tick debounces every input at once (DebounceScannedInputs)
+     & Check4InputChanges publishes a row's events when it has been stable
+     for its DebounceMs.
 
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       Tianyu  Scanned inputs are debounced, DebounceMs for each
+ 10/14/26       Tianyu  DIGITAL_INPUT_TABLE & the scanned inputs
+ 10/14/26       Tianyu  Added the stop input
+ 10/14/26       Tianyu  Added GetBeaconEdgeTime for the change notice ISR
+ 10/14/26       Tianyu  ReadTapeSensorPin replaced by TapeArray
  02/03/26       Tianyu  Initial creation for Lab 8 port management
 *****************************************************************************/
 
@@ -25,12 +36,69 @@
 
 void InitBeaconInputPin(void);
 bool ReadBeaconInputPin(void);
+#ifdef USE_CN_INPUT_EVENTS
+uint32_t GetBeaconEdgeTime(void);
+#endif
+
+void InitStopInputPin(void);
+bool ReadStopInputPin(void);
 
 void InitTapeSensorPin(void);
-bool ReadTapeSensorPin(void);
 
 void InitCommandSPIPins(void);
 
 void InitDebugOutputPin(void);
 
+// where a pin is in the scan word
+#define INPUT_RB(Bit) (Bit)
+#define INPUT_RA(Bit) (16 + (Bit))
+
+// One X(Name, Pin, ActiveLow, DebounceMs, OnEvent, OffEvent) row for each
+// polled digital input. An input only changes once it has read the new way
+// for DebounceMs ticks in a row, 1 to DEBOUNCE_MAX_MS. OnEvent is published
+// as it goes active & OffEvent as it goes inactive, either can be
+// ES_NO_EVENT. The EventParam is DIGITAL_INPUT(Name), the time in EventData
+// is the core timer count. An ActiveLow input gets its pull-up
+#ifdef USE_CN_INPUT_EVENTS
+// the change notice ISR in Ports.c has the beacon
+#define BEACON_INPUT_ROW(X)
+#else
+#define BEACON_INPUT_ROW(X) \
+  X(Beacon, INPUT_RB(2), false, 1, ES_BEACON_DETECTED, ES_NO_EVENT)
+#endif
+#define DIGITAL_INPUT_TABLE(X)                                                \
+  BEACON_INPUT_ROW(X)
+// e.g. a bump switch:
+//  X(FrontBumper, INPUT_RA(4), true, 5, ES_BUMPED, ES_NO_EVENT)
+
+// the counters are 4 bits
+#define DEBOUNCE_MAX_MS 15
+
+#define DIGITAL_INPUT(Name) DIGITAL_INPUT_##Name
+#define DIGITAL_INPUT_ID_ROW(Name, Pin, ActiveLow, DebounceMs, OnEvent,       \
+    OffEvent) \
+  DIGITAL_INPUT(Name),
+typedef enum
+{
+  DIGITAL_INPUT_TABLE(DIGITAL_INPUT_ID_ROW)
+  NUM_DIGITAL_INPUTS
+} DigitalInput_t;
+
+// every input in the table & the ones of them that are active low
+#define DIGITAL_INPUT_MASK_ROW(Name, Pin, ActiveLow, DebounceMs, OnEvent,     \
+    OffEvent) \
+  | (1u << (Pin))
+#define DIGITAL_INPUT_LOW_ROW(Name, Pin, ActiveLow, DebounceMs, OnEvent,      \
+    OffEvent) \
+  | ((ActiveLow) ? (1u << (Pin)) : 0u)
+#define DIGITAL_INPUT_SCAN_MASK \
+  (0u DIGITAL_INPUT_TABLE(DIGITAL_INPUT_MASK_ROW))
+#define DIGITAL_INPUT_LOW_MASK \
+  (0u DIGITAL_INPUT_TABLE(DIGITAL_INPUT_LOW_ROW))
+
+void InitScannedInputs(void);
+uint32_t ReadScannedInputs(void);
+void DebounceScannedInputs(void);
+uint32_t ReadDebouncedInputs(void);
+
 #endif /* Ports_H */
@@ -0,0 +1,65 @@
+/****************************************************************************
+ Module
+     PowerManager.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the power manager, which switches the clocks of the
+     peripherals off through the PMD registers whenever the robot's state
+     doesn't need them.
+
+ Notes
+     A peripheral that is off through its PMD bit loses its registers, so
+     each domain in POWER_DOMAIN_TABLE keeps a copy of them (the <Name>Regs
+     list in PowerManager.c) from when it goes off & writes them back when
+     it comes on again. The domain's interrupts in IEC0 are held off in
+     between. pOff runs before the copy is taken & pOn after it is written
+     back, for a domain whose outputs need looking after.
+
+     MainLogicFSM asks for the domains that each of its states needs with
+     PowerManager_Need. They all start on, so that the services can set
+     them up, & the peripherals the application never uses are switched
+     off for good by PowerManager_Init.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef PowerManager_H
+#define PowerManager_H
+
+#include "ES_Types.h"
+
+// One X(Name, Pmd1Mask, Pmd3Mask, Pmd4Mask, Iec0Mask, pOff, pOn) row for
+// each domain. The masks are only expanded in PowerManager.c, which also
+// needs a <Name>Regs list for each row
+#define POWER_DOMAIN_TABLE(X)                                                 \
+  X(Pwm,    0, _PMD3_OC1MD_MASK | _PMD3_OC2MD_MASK, _PMD4_T2MD_MASK, 0,       \
+    DCMotor_PowerDown, DCMotor_PowerUp)                                       \
+  X(Tape,   _PMD1_AD1MD_MASK, 0, 0, _IEC0_AD1IE_MASK, NULL, NULL)             \
+  X(Beacon, 0, _PMD3_IC1MD_MASK, 0, _IEC0_IC1IE_MASK, NULL, NULL)
+
+#define POWER_DOMAIN(Name) POWER_DOMAIN_##Name
+#define POWER_DOMAIN_ID_ROW(Name, Pmd1Mask, Pmd3Mask, Pmd4Mask, Iec0Mask,     \
+    pOff, pOn) POWER_DOMAIN(Name),
+typedef enum
+{
+  POWER_DOMAIN_TABLE(POWER_DOMAIN_ID_ROW)
+  NUM_POWER_DOMAINS
+} PowerDomain_t;
+
+typedef uint8_t PowerMask_t;
+#define POWER_MASK(Name) ((PowerMask_t)(1u << POWER_DOMAIN(Name)))
+#define POWER_NONE ((PowerMask_t)0)
+
+// Public Function Prototypes
+
+void PowerManager_Init(void);
+void PowerManager_Need(PowerMask_t Domains);
+PowerMask_t PowerManager_GetOn(void);
+
+#endif /* PowerManager_H */
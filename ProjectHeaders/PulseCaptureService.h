@@ -0,0 +1,86 @@
+/****************************************************************************
+ Module
+     PulseCaptureService.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the pulse width capture service, which times the
+     pulses on the PULSE_CAPTURE_TABLE inputs, such as an ultrasonic
+     rangefinder's echo or a sensor with a PWM output.
+
+ Notes
+     Each input has an Input Capture module of its own, capturing every
+     edge of it against the shared capture time base (CaptureTimebase.h).
+     The first edge captured is the leading one, each pulse's width is from
+     its leading edge to its trailing edge & its period from the leading
+     edge before. ES_PULSE_MEASURED is published once per pulse, not once
+     per edge, with the channel, PULSE_CHANNEL(Name), as its EventParam &
+     the width in time base ticks as its EventData (ES_EVENT_WIDE).
+
+     Pulses that come faster than the service runs are merged, a
+     subscriber gets the latest of them. PulseCapture_GetWidth always has
+     the latest, for a sensor that is read rather than listened to.
+
+     IC2 & IC5 are the wheel encoders' (SpeedControlService), so the table
+     has IC3 & IC4 in it. A row for IC2 or IC5 needs the encoder moved off
+     it, the two ISRs would share a vector. The PPS code is the ICxR value
+     for the pin, from the PIC32MX170 PPS input table.
+
+     Pins:
+       Sonar echo  - IC3 on RB1
+       PWM sensor  - IC4 on RB15
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef PulseCaptureService_H
+#define PulseCaptureService_H
+
+#include "ES_Types.h"
+#include "ES_Events.h"
+#include "CaptureTimebase.h"
+
+// One X(Name, Ic, Port, Bit, Pps, ActiveHigh) row per input, on ICIc from
+// R<Port><Bit>. ActiveHigh is true when the pulse is the high part
+#define PULSE_CAPTURE_TABLE(X)                                                \
+  X(Sonar,     3, B, 1,  0b0010, true)                                        \
+  X(PwmSensor, 4, B, 15, 0b0011, true)
+
+#define PULSE_CHANNEL(Name) PULSE_CHANNEL_##Name
+#define PULSE_CHANNEL_ID_ROW(Name, Ic, Port, Bit, Pps, ActiveHigh) \
+  PULSE_CHANNEL(Name),
+typedef enum
+{
+  PULSE_CAPTURE_TABLE(PULSE_CHANNEL_ID_ROW)
+  NUM_PULSE_CHANNELS
+} PulseChannel_t;
+
+// the PMD3 bits of the modules in the table, which PowerManager leaves on
+#define PULSE_CHANNEL_PMD_ROW(Name, Ic, Port, Bit, Pps, ActiveHigh) \
+  | _PMD3_IC##Ic##MD_MASK
+#define PULSE_CAPTURE_PMD3_MASK \
+  (0 PULSE_CAPTURE_TABLE(PULSE_CHANNEL_PMD_ROW))
+
+// all of the capture ISRs are at this IPL, which their __ISR must match
+#define PULSE_CAPTURE_PRIORITY 6
+
+// a width or period in time base ticks, in uS
+#define PULSE_TICKS_TO_US(Ticks) \
+  ((uint32_t)(((uint64_t)(Ticks) * 1000000u) / CAPTURE_TIMEBASE_HZ))
+
+// Public Function Prototypes
+
+bool InitPulseCaptureService(uint8_t Priority);
+bool PostPulseCaptureService(ES_Event_t ThisEvent);
+ES_Event_t RunPulseCaptureService(ES_Event_t ThisEvent);
+
+bool PulseCapture_GetWidth(PulseChannel_t Channel, uint32_t *pWidth,
+                           uint32_t *pPeriod);
+uint32_t PulseCapture_GetCount(PulseChannel_t Channel);
+
+#endif /* PulseCaptureService_H */
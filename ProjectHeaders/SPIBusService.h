@@ -0,0 +1,93 @@
+/****************************************************************************
+ Module
+     SPIBusService.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the service that owns the SPI bus & runs the
+     transactions of every follower on it, one after the other.
+
+ Notes
+     Each follower is a row of SPI_BUS_DEVICE_TABLE, with its own chip
+     select (a plain output, low for the whole transaction), bit time,
+     clock mode & width. The bus is set up for a device only when the
+     transaction before was for a different one.
+
+     A client either queues a one-off transaction with SPIBus_Queue or
+     sets one up to be queued for it every so many SPI_BUS_TICK_MS with
+     SPIBus_SetPoll, so every follower is polled from the one timer, which
+     only runs out when a poll is due. When a
+     transaction is over, ES_SPI_TRANSFER_DONE goes to its post function
+     with its Tag as the EventParam, then the next one in the queue starts
+     from the same ISR, so the bus doesn't wait on ES_Run between them.
+
+     The buffers belong to the client & must stay put until its event.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  SPI_BUS_TICK_MS is 20mS, for the adaptive poll, &
+                        the timer only runs out when a poll is due
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef SPIBusService_H
+#define SPIBusService_H
+
+#include "ES_Types.h"
+#include "ES_Events.h"
+#include "ES_PostList.h"
+#include "PIC32_SPI_HAL.h"
+
+// the bus & its output pin, SCK1 is fixed on RB14 & SDI1 is on RPB8
+#define SPI_BUS_MODULE SPI_SPI1
+#define SPI_BUS_SDO_PIN SPI_RPA1
+
+// the poll cadence, every poll is a whole number of these
+#define SPI_BUS_TICK_MS 20
+
+// transactions that can wait for the bus, must be a power of 2
+#define SPI_BUS_QUEUE_DEPTH 8
+
+// One X(Name, ChipSelect, BitTime_ns, ClockIdle, ActiveEdge, SamplePhase,
+// Width) row for each follower. Clients name a device SPI_BUS_DEVICE(Name)
+#define SPI_BUS_DEVICE_TABLE(X)                                               \
+  X(CommandGenerator, SPI_RPA0, 10000, SPI_CLK_HI, SPI_FIRST_EDGE,            \
+    SPI_SMP_MID, SPI_8BIT)
+// e.g. an IMU:
+//  X(Imu, SPI_RPB4, 200, SPI_CLK_HI, SPI_SECOND_EDGE, SPI_SMP_END, SPI_8BIT)
+
+#define SPI_BUS_DEVICE(Name) SPI_BUS_DEVICE_##Name
+#define SPI_BUS_DEVICE_ID_ROW(Name, ChipSelect, BitTime_ns, ClockIdle,        \
+    ActiveEdge, SamplePhase, Width) SPI_BUS_DEVICE(Name),
+typedef enum
+{
+  SPI_BUS_DEVICE_TABLE(SPI_BUS_DEVICE_ID_ROW)
+  NUM_SPI_BUS_DEVICES
+} SPIBus_Device_t;
+
+typedef struct
+{
+  SPIBus_Device_t Device;
+  const void *pTxData;    // NULL to send SPI_TRANSFER_FILL
+  void       *pRxData;    // may be the same as pTxData
+  uint16_t    Length;     // bytes, a whole number of the device's words
+  pPostFunc   pPostDone;  // gets ES_SPI_TRANSFER_DONE, NULL for no event
+  uint16_t    Tag;        // the EventParam of that event
+} SPIBus_Transaction_t;
+
+// Public Function Prototypes
+
+bool InitSPIBusService(uint8_t Priority);
+bool PostSPIBusService(ES_Event_t ThisEvent);
+ES_Event_t RunSPIBusService(ES_Event_t ThisEvent);
+
+bool SPIBus_Queue(const SPIBus_Transaction_t *pTransaction);
+bool SPIBus_SetPoll(const SPIBus_Transaction_t *pTransaction,
+                    uint8_t TicksPerPoll);
+void SPIBus_StopPoll(SPIBus_Device_t Device);
+uint16_t SPIBus_GetDropped(void);
+
+#endif /* SPIBusService_H */
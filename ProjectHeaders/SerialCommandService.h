@@ -0,0 +1,56 @@
+/****************************************************************************
+ Module
+     SerialCommandService.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the service that takes the console input from the
+     UART receive buffer & runs the command lines in it.
+
+ Notes
+     A command line is framed as
+
+       $<VERB> <args>[*hh]<CR or LF>
+
+     where hh, if present, is the XOR of every byte between the '$' and the
+     '*' in hex. The verbs are
+
+       CMD hh [hh ...]    queue command bytes, as if from the generator
+       SET <name> <value> change a parameter, see PARAM_TABLE
+       SAVE               write the parameters to flash, only while
+                          stopped
+       DEFAULTS           put the parameters back to their defaults
+       BAUD <rate>        change the console rate, after the reply
+       BAUD AUTO          start the auto-baud after the reply, then send
+                          'U' at the new rate
+
+     Each line is answered with "$OK" or "$ERR <why>". Anything that comes
+     in outside of a line is posted to every service as ES_NEW_KEY, as
+     Check4Keystroke did.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  SET names come from the parameter store, added SAVE
+                        & DEFAULTS
+ 10/14/26       Tianyu  Added BAUD
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef SerialCommandService_H
+#define SerialCommandService_H
+
+#include "ES_Types.h"
+
+// longest line, from after the '$' to before the CR/LF
+#define SERIAL_LINE_MAX 64
+
+// Public Function Prototypes
+
+bool InitSerialCommandService(uint8_t Priority);
+bool PostSerialCommandService(ES_Event_t ThisEvent);
+ES_Event_t RunSerialCommandService(ES_Event_t ThisEvent);
+
+#endif /* SerialCommandService_H */
@@ -0,0 +1,59 @@
+/****************************************************************************
+ Module
+     SpeedControlService.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the closed loop wheel speed control service.
+
+ Notes
+     Speeds are wheel RPM in Q16.16 (see FixedPointUnits.h). Distances are
+     in encoder captures, IC_ENCODER_EDGES_PER_REV of them per wheel turn.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef SpeedControlService_H
+#define SpeedControlService_H
+
+#include "ES_Types.h"
+#include "CommonDefinitions.h"
+#include "FixedPointUnits.h"
+
+// Chassis geometry, used to turn an angle into a wheel distance. Measure
+// these on the robot, a turn that comes up short means the track is too small
+#define WHEEL_DIAMETER_MM 70
+#define WHEEL_TRACK_MM 200   // distance between the wheel contact patches
+
+// encoder captures each wheel travels for an in-place turn of Deg degrees
+#define TURN_CAPTURES(Deg) \
+  ((uint32_t)(((uint64_t)WHEEL_TRACK_MM * (Deg) * IC_ENCODER_EDGES_PER_REV + \
+      (180 * WHEEL_DIAMETER_MM)) / (360 * WHEEL_DIAMETER_MM)))
+
+// Speed settings for the commands
+#define SPEED_FULL_RPM FP_INT_TO_Q16(MAX_RPM * 7 / 8) // leave room to regulate
+#define SPEED_HALF_RPM FP_INT_TO_Q16(MAX_RPM / 2)
+#define SPEED_TURN_RPM SPEED_FULL_RPM
+
+// pass as the distance for a move that runs until SpeedControl_Stop
+#define SPEED_CONTROL_NO_LIMIT 0
+
+// Public Function Prototypes
+
+bool InitSpeedControlService(uint8_t Priority);
+bool PostSpeedControlService(ES_Event_t ThisEvent);
+ES_Event_t RunSpeedControlService(ES_Event_t ThisEvent);
+
+void SpeedControl_StartMove(FP_Q16_t SpeedLeft, FP_Q16_t SpeedRight,
+                            uint8_t DirLeft, uint8_t DirRight,
+                            uint32_t Captures);
+void SpeedControl_Stop(void);
+FP_Q16_t SpeedControl_GetSpeed(uint8_t Wheel);
+uint32_t SpeedControl_GetDistance(uint8_t Wheel);
+
+#endif /* SpeedControlService_H */
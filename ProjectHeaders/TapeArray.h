@@ -0,0 +1,60 @@
+/****************************************************************************
+ Module
+     TapeArray.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the analog reflective tape sensor array.
+
+ Notes
+     The sensors are read through the A/D streaming mode, in scan order,
+     so the lowest numbered ANx pin is sensor 0. The line position is in
+     1/16 mm from the middle of the array, positive when the tape is to
+     the right of the robot.
+
+     Pins:
+       Sensor 0 (left)  - AN5 on RB3
+       Sensor 1 (right) - AN12 on RB12
+     Those are the only analog inputs this board has left, a wider array
+     needs its pins added to TAPE_PIN_MASK and TAPE_SENSOR_POSITIONS.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef TapeArray_H
+#define TapeArray_H
+
+#include "ES_Types.h"
+#include "bitdefs.h"
+
+#define TAPE_PIN_MASK (BIT5HI | BIT12HI)
+#define TAPE_NUM_SENSORS 2
+
+// sensor positions across the robot, in scan order, mm from the middle
+#define TAPE_SENSOR_POSITIONS { -12, 12 }
+
+// scan set rate, a block is ready every 16mS at 1kHz
+#define TAPE_SET_RATE_HZ 1000
+
+// A/D reading over the bare floor, taken off every reading before it is
+// weighted. The tape reads higher (dark tape, pulled up phototransistor)
+#define TAPE_FLOOR_COUNTS 200
+
+// summed signal, above the floor, to find the line & to lose it again
+#define TAPE_DETECT_COUNTS 300
+#define TAPE_LOST_COUNTS 150
+
+// line position fraction bits
+#define TAPE_POSITION_SHIFT 4
+
+bool TapeArray_Init(void);
+bool TapeArray_Update(void);
+bool TapeArray_LineSeen(void);
+int16_t TapeArray_GetPosition(void);
+
+#endif /* TapeArray_H */
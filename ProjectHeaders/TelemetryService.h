@@ -0,0 +1,66 @@
+/****************************************************************************
+ Module
+     TelemetryService.h
+
+ Revision
+     0.1
+
+ Description
+     Header file for the service that sends a packed status frame at a
+     fixed rate, for the host dashboard.
+
+ Notes
+     A frame goes out mixed in with the printf text, the same way the
+     binlog & trace frames do, & tools/binlog_decode.py prints it:
+
+       TELEMETRY_FRAME_MARK, payload length, payload, CRC-16
+
+     The CRC is CCITT (0x1021, from 0xFFFF) over the length & the payload,
+     sent low byte first like every other field. The payload, little
+     endian & with no padding:
+
+       u8  TELEMETRY_VERSION
+       u8  sequence number, the dashboard counts the gaps
+       u32 core timer count when the snapshot was taken
+       u16 frames skipped so far because the transmit buffer was full
+       u8  MainLogicState_t
+       u8  directions, bit 0 left & bit 1 right, set for REVERSE
+       u16 left, right duty ticks
+       u16 left, right measured speed, RPM
+       u8  BeaconId_t of the last window, u8 its confidence (0-255)
+       i16 line position, u8 1 if the line is seen
+       i16 x, i16 y, mm from the odometry, u16 heading, 65536 to a turn
+       u8  number of tape sensors, then a u16 filtered A/D reading each
+       u8  number of services, then for each one
+           u8 queue high water, u16 queue drops
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Version 2, with the odometry pose
+ 10/14/26       Tianyu  TELEMETRY_PERIOD_MS is the TELEM parameter's default
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+
+#ifndef TelemetryService_H
+#define TelemetryService_H
+
+#include "ES_Types.h"
+
+// not a 7 bit ASCII character, & not the binlog or trace mark
+#define TELEMETRY_FRAME_MARK 0xB3
+#define TELEMETRY_VERSION 2
+
+// the default of the TELEM parameter, frames per second is 1000 / the
+// period, 0 for none. At 115200 a frame is about 5mS of the link
+#define TELEMETRY_PERIOD_MS 100
+
+// Public Function Prototypes
+
+bool InitTelemetryService(uint8_t Priority);
+bool PostTelemetryService(ES_Event_t ThisEvent);
+ES_Event_t RunTelemetryService(ES_Event_t ThisEvent);
+
+void Telemetry_SetPeriod(uint16_t PeriodMs);
+
+#endif /* TelemetryService_H */
@@ -0,0 +1,283 @@
+/****************************************************************************
+ Module
+   ADFilterBank.c
+
+ Revision
+   0.1
+
+ Description
+   Filters every channel of the A/D scan set and reports a channel only
+   when its filtered value has moved by more than its hysteresis band, so
+   noise on an input doesn't turn into a stream of events.
+
+ Notes
+   Per sample, per channel: the moving average keeps a running sum over a
+   ring of the last 1 << AverageShift samples, the IIR is kept in Q8 so a
+   long time constant doesn't lose the small steps, and the hysteresis is
+   a compare against the last reported value. No multiplies or divides.
+
+   The first sample after ADFilter_Init or ADFilter_Configure fills the
+   average & the IIR, so a channel starts at its input rather than
+   ramping up from 0, and is always reported.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ADFilterBank.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define AVERAGE_MAX_LENGTH (1 << AD_FILTER_MAX_AVERAGE_SHIFT)
+#define IIR_FRACTION_BITS 8
+
+typedef struct
+{
+  ADFilterConfig_t Config;
+  uint16_t History[AVERAGE_MAX_LENGTH];
+  uint8_t  Next;          // oldest entry in History
+  uint32_t Sum;           // of the last 1 << AverageShift samples
+  uint32_t IIRQ8;         // IIR output in Q8
+  uint16_t Filtered;
+  uint16_t Reported;
+  bool     Started;
+} FilterChannel_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void ResetChannel(FilterChannel_t *pChannel);
+static bool FilterSample(FilterChannel_t *pChannel, uint16_t Sample);
+
+/*---------------------------- Module Variables ---------------------------*/
+static FilterChannel_t Channels[AD_FILTER_MAX_CHANNELS];
+static uint8_t NumActive;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     ADFilter_Init
+
+ Parameters
+     uint8_t NumChannels - how many channels are in the scan set
+
+ Returns
+     bool, false if there are more than AD_FILTER_MAX_CHANNELS
+
+ Description
+     Sets every channel to pass its input straight through (no average, no
+     IIR, no hysteresis) until it is configured
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool ADFilter_Init(uint8_t NumChannels)
+{
+  uint8_t i;
+
+  if (NumChannels > AD_FILTER_MAX_CHANNELS)
+  {
+    return false;
+  }
+  NumActive = NumChannels;
+  for (i = 0; i < AD_FILTER_MAX_CHANNELS; i++)
+  {
+    Channels[i].Config.AverageShift = 0;
+    Channels[i].Config.IIRShift = 0;
+    Channels[i].Config.Hysteresis = 0;
+    ResetChannel(&Channels[i]);
+  }
+  return true;
+}
+
+/****************************************************************************
+ Function
+     ADFilter_Configure
+
+ Parameters
+     uint8_t Channel - channel in scan order
+     const ADFilterConfig_t *pConfig - the filter settings
+
+ Returns
+     bool, false if the channel or a setting is out of range
+
+ Description
+     Sets up one channel & restarts its filter
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool ADFilter_Configure(uint8_t Channel, const ADFilterConfig_t *pConfig)
+{
+  if ((Channel >= NumActive) ||
+      (pConfig->AverageShift > AD_FILTER_MAX_AVERAGE_SHIFT) ||
+      (pConfig->IIRShift > AD_FILTER_MAX_IIR_SHIFT))
+  {
+    return false;
+  }
+  Channels[Channel].Config = *pConfig;
+  ResetChannel(&Channels[Channel]);
+  return true;
+}
+
+/****************************************************************************
+ Function
+     ADFilter_AddSet
+
+ Parameters
+     const uint16_t *pSet - one conversion of every channel, in scan order
+
+ Returns
+     uint8_t, a bit for each channel whose reported value changed, bit 0
+     for channel 0
+
+ Description
+     Runs one sample through each channel's filter
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint8_t ADFilter_AddSet(const uint16_t *pSet)
+{
+  uint8_t i;
+  uint8_t Changed = 0;
+
+  for (i = 0; i < NumActive; i++)
+  {
+    if (FilterSample(&Channels[i], pSet[i]))
+    {
+      Changed |= (uint8_t)(1 << i);
+    }
+  }
+  return Changed;
+}
+
+/****************************************************************************
+ Function
+     ADFilter_AddBlock
+
+ Parameters
+     const uint16_t *pBlock - NumSets sets back to back, as handed out by
+                              ADC_GetBlock
+     uint8_t NumSets
+
+ Returns
+     uint8_t, a bit for each channel whose reported value changed anywhere
+     in the block
+
+ Description
+     Runs a streamed block through the filters, one set at a time
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint8_t ADFilter_AddBlock(const uint16_t *pBlock, uint8_t NumSets)
+{
+  uint8_t Changed = 0;
+
+  while (NumSets-- > 0)
+  {
+    Changed |= ADFilter_AddSet(pBlock);
+    pBlock += NumActive;
+  }
+  return Changed;
+}
+
+/****************************************************************************
+ Function
+     ADFilter_GetValue
+
+ Parameters
+     uint8_t Channel - channel in scan order
+
+ Returns
+     uint16_t, the last reported value, 0 for a channel out of range
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint16_t ADFilter_GetValue(uint8_t Channel)
+{
+  return (Channel < NumActive) ? Channels[Channel].Reported : 0;
+}
+
+/****************************************************************************
+ Function
+     ADFilter_GetFiltered
+
+ Parameters
+     uint8_t Channel - channel in scan order
+
+ Returns
+     uint16_t, the filter output before the hysteresis band, 0 for a
+     channel out of range
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint16_t ADFilter_GetFiltered(uint8_t Channel)
+{
+  return (Channel < NumActive) ? Channels[Channel].Filtered : 0;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+static void ResetChannel(FilterChannel_t *pChannel)
+{
+  pChannel->Next = 0;
+  pChannel->Sum = 0;
+  pChannel->IIRQ8 = 0;
+  pChannel->Filtered = 0;
+  pChannel->Reported = 0;
+  pChannel->Started = false;
+}
+
+static bool FilterSample(FilterChannel_t *pChannel, uint16_t Sample)
+{
+  const ADFilterConfig_t *pConfig = &pChannel->Config;
+  uint8_t  Length = (uint8_t)(1 << pConfig->AverageShift);
+  uint16_t Value;
+  uint16_t Delta;
+  uint8_t  i;
+
+  if (!pChannel->Started)
+  {
+    // fill the history with the first sample so the average starts there
+    for (i = 0; i < Length; i++)
+    {
+      pChannel->History[i] = Sample;
+    }
+    pChannel->Sum = (uint32_t)Sample << pConfig->AverageShift;
+    pChannel->IIRQ8 = (uint32_t)Sample << IIR_FRACTION_BITS;
+  }
+
+  // moving average, drop the oldest sample & add the new one
+  pChannel->Sum += Sample;
+  pChannel->Sum -= pChannel->History[pChannel->Next];
+  pChannel->History[pChannel->Next] = Sample;
+  pChannel->Next = (uint8_t)((pChannel->Next + 1) & (Length - 1));
+  Value = (uint16_t)(pChannel->Sum >> pConfig->AverageShift);
+
+  // IIR, y += (x - y) >> IIRShift, in Q8
+  if (pConfig->IIRShift != 0)
+  {
+    int32_t Step = (((int32_t)Value << IIR_FRACTION_BITS) -
+        (int32_t)pChannel->IIRQ8) >> pConfig->IIRShift;
+
+    pChannel->IIRQ8 = (uint32_t)((int32_t)pChannel->IIRQ8 + Step);
+    Value = (uint16_t)((pChannel->IIRQ8 + (1 << (IIR_FRACTION_BITS - 1))) >>
+        IIR_FRACTION_BITS);
+  }
+  pChannel->Filtered = Value;
+
+  // hysteresis against what was last reported
+  Delta = (Value > pChannel->Reported) ? (Value - pChannel->Reported) :
+      (pChannel->Reported - Value);
+  if (!pChannel->Started || (Delta > pConfig->Hysteresis))
+  {
+    pChannel->Reported = Value;
+    pChannel->Started = true;
+    return true;
+  }
+  return false;
+}
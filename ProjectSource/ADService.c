@@ -12,23 +12,16 @@
 
  Notes
     When initializing the ADC service:
-        Configure ADC for potentiometer input
-        Set desiredSpeed = DEFAULT_SPEED
+        Configure ADC to stream the potentiometer input at AD_SET_RATE_HZ
+        Set desiredSpeed = 0 until the first block arrives
         Store desiredSpeed at module level
-        Configure a dedicated ADC sampling timer to expire at 10 Hz
-    Start the ADC sampling timer
 
-    When the ADC checking timer TMR_ADC expires:
-        Read ADC value
-        Convert ADC value → desiredSpeed
-        Clamp desiredSpeed to [MIN_SPEED, MAX_SPEED]
-
-        If |desiredSpeed − lastDesiredSpeed| > SPEED_DEADBAND:
+    When the ADC ISR posts ES_AD_BLOCK_READY:
+        Run the block (ADC_STREAM_BLOCK_SETS samples) through the filter
+        bank and release it
+        If the filtered pot reading moved past its hysteresis band:
         Update module-level desiredSpeed
         Post ES_MOTOR_ACTION_CHANGE(desiredSpeed)
-        Update lastDesiredSpeed
-
-    Restart the ADC sampling timer
 
     To provide the current desired speed to other services:
     Return the current value of the module-level speed variable
@@ -37,6 +30,10 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       Tianyu    Pot goes through ADFilterBank, posts only when the
+                          filtered reading leaves its hysteresis band
+ 10/14/26       Tianyu    Streams from the ADC ISR, one update per averaged
+                          block instead of a 100mS poll
  01/21/26       Tianyu    Updated for Lab 6 motor speed control
  01/14/26       Tianyu    Initial creation for Lab 5
 ****************************************************************************/
@@ -47,20 +44,28 @@
 #include "ADService.h"
 #include "DCMotorService.h"
 #include "PIC32_AD_Lib.h"
+#include "ADFilterBank.h"
 #include "dbprintf.h"
-#include <stdlib.h>
 
 /*----------------------------- Module Defines ----------------------------*/
-// Timer interval for checking the potentiometer (10Hz = 100ms)
-#define ADC_CHECK_INTERVAL 100
+// Rate the scan set is converted at, a block of ADC_STREAM_BLOCK_SETS
+// samples is ready every 16mS
+#define AD_SET_RATE_HZ 1000
 
 // A/D converter configuration
 #define POT_PIN_MASK BIT10HI  // Configure for AN10 (RB14) potentiometer input, pin 25 (Datasheet P4 Pin Diagrams)
+#define AD_NUM_CHANNELS 1     // pins in POT_PIN_MASK
+#define POT_CHANNEL 0         // the pot's place in the scan set
 
-#define SPEED_DEADBAND 0  // Minimum change in speed to trigger update
+// Pot filter, an 8 sample average into a 4 sample IIR, and a change of
+// more than 4 counts (about 0.4% of full scale) before a new speed is sent
+#define POT_AVERAGE_SHIFT 3
+#define POT_IIR_SHIFT 2
+#define POT_HYSTERESIS 4
 
 /*---------------------------- Module Functions ---------------------------*/
 /* Prototypes for private functions for this service */
+static void ADBlockReady(void);
 
 /*---------------------------- Module Variables ---------------------------*/
 // Module level Priority variable
@@ -69,10 +74,10 @@ static uint8_t MyPriority;
 // Module level variable to store the current desired speed
 // This can be accessed by other services via GetDesiredSpeed()
 static uint16_t CurrentDesiredSpeed;
-static uint16_t LastDesiredSpeed;
 
-// Buffer for A/D readings
-static uint32_t ADCResults[1];
+static const ADFilterConfig_t PotFilter = {
+  POT_AVERAGE_SHIFT, POT_IIR_SHIFT, POT_HYSTERESIS
+};
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -86,7 +91,7 @@ static uint32_t ADCResults[1];
      bool, false if error in initialization, true otherwise
 
  Description
-     Initializes the A/D converter and starts the ADC checking timer
+     Initializes the A/D converter and starts it streaming
 
  Author
      Tianyu, 01/14/26
@@ -101,23 +106,20 @@ bool InitADService(uint8_t Priority)
    Initialization code for ADC service
    *******************************************/
   
-  // Configure the analog-to-digital converter for the potentiometer input
-  if (!ADC_ConfigAutoScan(POT_PIN_MASK))
+  // No reading until the first block is in
+  CurrentDesiredSpeed = 0;
+
+  if (!ADFilter_Init(AD_NUM_CHANNELS) ||
+      !ADFilter_Configure(POT_CHANNEL, &PotFilter))
   {
-    return false; // Return false if ADC configuration fails
+    return false;
   }
 
-  ADC_MultiRead(ADCResults);
-  
-  // Set desiredSpeed = result read from ADC
-  // Store desiredSpeed at module level
-
-  CurrentDesiredSpeed = ADCResults[0];
-  LastDesiredSpeed = CurrentDesiredSpeed;
-  
-  // Configure a timer to check potentiometer regularly
-  // Start the ADC checking timer
-  ES_Timer_InitTimer(AD_TIMER, ADC_CHECK_INTERVAL);
+  // Stream the potentiometer input, the ISR tells us about each block
+  if (!ADC_ConfigStreaming(POT_PIN_MASK, AD_SET_RATE_HZ, ADBlockReady))
+  {
+    return false; // Return false if ADC configuration fails
+  }
   
   // Post the initial transition event
   ThisEvent.EventType = ES_INIT;
@@ -164,8 +166,8 @@ bool PostADService(ES_Event_t ThisEvent)
    ES_Event_t, ES_NO_EVENT if no error ES_ERROR otherwise
 
  Description
-   Handles timer events to read the A/D converter and update desired speed
-   when the ADC checking timer expires.
+   Averages each block of A/D samples as it completes and updates the
+   desired speed.
 
  Author
    Tianyu, 01/14/26
@@ -181,41 +183,34 @@ ES_Event_t RunADService(ES_Event_t ThisEvent)
       // No additional initialization needed here
       break;
       
-    case ES_TIMEOUT:
-      // Check if this timeout is for our ADC timer
-      if (ThisEvent.EventParam == AD_TIMER)
+    case ES_AD_BLOCK_READY:
+    {
+      const uint16_t *pBlock = ADC_GetBlock();
+
+      // a reminder after an overrun can find the block already handled
+      if (pBlock != NULL)
       {
-        // When the ADC checking timer expires:
-        
-        // Read the current voltage from the potentiometer
-        ADC_MultiRead(ADCResults);
-        
-        // DB_printf("Current ADC is %d\r\n",
-        // ADCResults[0]);
-
-        CurrentDesiredSpeed = ADCResults[0];
-        
+        // Filter the block, then hand it back for the ISR to fill
+        uint8_t changed = ADFilter_AddBlock(pBlock, ADC_STREAM_BLOCK_SETS);
+        ADC_ReleaseBlock();
+
 //        DB_printf("Current Desired Speed is %d\r\n",
-//          CurrentDesiredSpeed);
+//          ADFilter_GetFiltered(POT_CHANNEL));
 
-        // Post a ES_MOTOR_ACTION_CHANGE event with the new desired speed if it changed
-        int32_t speedDelta = (int32_t)CurrentDesiredSpeed - (int32_t)LastDesiredSpeed;
-        if (abs(speedDelta) > SPEED_DEADBAND)
+        // Post a ES_MOTOR_ACTION_CHANGE event only if the pot really moved
+        if (changed & (1 << POT_CHANNEL))
         {
-          // Update lastDesiredSpeed
-          LastDesiredSpeed = CurrentDesiredSpeed;
-          
+          CurrentDesiredSpeed = ADFilter_GetValue(POT_CHANNEL);
+
           // Post ES_MOTOR_ACTION_CHANGE event
           ES_Event_t SpeedChangedEvent;
           SpeedChangedEvent.EventType = ES_MOTOR_ACTION_CHANGE;
           SpeedChangedEvent.EventParam = CurrentDesiredSpeed;
           PostDCMotorService(SpeedChangedEvent);
         }
-        
-        // Restart the ADC checking timer
-        ES_Timer_InitTimer(AD_TIMER, ADC_CHECK_INTERVAL);
       }
       break;
+    }
       
     default:
       break;
@@ -254,5 +249,30 @@ uint16_t GetDesiredSpeed(void)
  Private Functions
  ***************************************************************************/
 
+/****************************************************************************
+ Function
+     ADBlockReady
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Called from the ADC ISR when a block is complete
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static void ADBlockReady(void)
+{
+  ES_Event_t ThisEvent;
+
+  ThisEvent.EventType = ES_AD_BLOCK_READY;
+  ThisEvent.EventParam = 0;
+  ES_PostToService(MyPriority, ThisEvent);
+}
+
 /*------------------------------- Footnotes -------------------------------*/
 /*------------------------------ End of file ------------------------------*/
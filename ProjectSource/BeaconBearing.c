@@ -0,0 +1,236 @@
+/****************************************************************************
+ Module
+   BeaconBearing.c
+
+ Revision
+   0.1
+
+ Description
+   Works out the heading of the beacon from a sweep. Each sighting is put
+   in the bin for the heading the robot had at the beacon edge, weighted by
+   its strength, & the peak is the centroid of the fullest few bins.
+
+ Notes
+   The heading of a sighting is the distance the wheels have turned, less
+   what they turned between the edge & the call: the caller passes the
+   edge time, from BeaconDetect_TakeSighting, & the turn rate is the
+   distance so far over the time since the sweep started. So the time the
+   event took to get here doesn't move the bearing, & the spin can be as
+   fast as the sightings allow.
+
+   The bins go round, a beacon across the start of the sweep has its
+   centroid worked out across the join.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  The edge time is passed in to AddSighting
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <xc.h>
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "BeaconBearing.h"
+#include "CommonDefinitions.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// bin positions are in 1/256ths of a bin
+#define BIN_FRACTION_SHIFT 8
+#define BIN_FRACTION_ONE (1u << BIN_FRACTION_SHIFT)
+
+#if ((2 * BEARING_PEAK_HALF_WIDTH) + 1) > BEARING_NUM_BINS
+#error "The peak is wider than the sweep"
+#endif
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint8_t BinIndex(int16_t Bin);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint16_t Bins[BEARING_NUM_BINS];
+static uint16_t NumSightings;
+static uint32_t SweepStart;   // core timer count
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     BeaconBearing_StartSweep
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Empties the bins, call as the sweep move is started
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void BeaconBearing_StartSweep(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < BEARING_NUM_BINS; i++)
+  {
+    Bins[i] = 0;
+  }
+  NumSightings = 0;
+  SweepStart = _CP0_GET_COUNT();
+}
+
+/****************************************************************************
+ Function
+     BeaconBearing_AddSighting
+
+ Parameters
+     uint8_t Strength - 1 to 255, BEARING_FULL_STRENGTH if there is no
+     measure of it
+     uint32_t EdgeTime - core timer count the beacon was seen at
+
+ Returns
+     None
+
+ Description
+     Bins a beacon sighting at the heading the robot had when it was made
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void BeaconBearing_AddSighting(uint8_t Strength, uint32_t EdgeTime)
+{
+  uint32_t Now = _CP0_GET_COUNT();
+  uint32_t Heading = BeaconBearing_GetHeading();
+  uint32_t SinceStart = Now - SweepStart;
+  uint32_t SinceEdge = Now - EdgeTime;
+  uint32_t Bin;
+
+  // an edge from before the sweep says nothing about it
+  if ((SinceStart == 0) || (SinceEdge > SinceStart))
+  {
+    return;
+  }
+  // take off what was turned since the edge, at the average rate
+  Heading -= (uint32_t)(((uint64_t)Heading * SinceEdge) / SinceStart);
+
+  Bin = ((Heading % BEARING_SWEEP_CAPTURES) * BEARING_NUM_BINS) /
+      BEARING_SWEEP_CAPTURES;
+  if ((uint32_t)Bins[Bin] + Strength <= 0xFFFF)
+  {
+    Bins[Bin] += Strength;
+  }
+  NumSightings++;
+}
+
+/****************************************************************************
+ Function
+     BeaconBearing_GetPeak
+
+ Parameters
+     uint32_t *pCaptures - where to put the beacon's heading
+
+ Returns
+     bool, false if the sweep didn't see the beacon enough for a bearing
+
+ Description
+     Finds the run of bins with the most in it round the sweep & gives the
+     centroid of that run, in captures from the start of the sweep
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool BeaconBearing_GetPeak(uint32_t *pCaptures)
+{
+  uint32_t BestSum = 0;
+  uint8_t  BestBin = 0;
+  uint32_t Sum;
+  int32_t  Moment;
+  int16_t  Offset;
+  uint8_t  i;
+  uint32_t Position;
+
+  if (NumSightings < BEARING_MIN_SIGHTINGS)
+  {
+    return false;
+  }
+  for (i = 0; i < BEARING_NUM_BINS; i++)
+  {
+    Sum = 0;
+    for (Offset = -BEARING_PEAK_HALF_WIDTH; Offset <= BEARING_PEAK_HALF_WIDTH;
+        Offset++)
+    {
+      Sum += Bins[BinIndex((int16_t)i + Offset)];
+    }
+    if (Sum > BestSum)
+    {
+      BestSum = Sum;
+      BestBin = i;
+    }
+  }
+  if (BestSum == 0)
+  {
+    return false;
+  }
+
+  // centroid of the run, relative to the middle of its centre bin
+  Moment = 0;
+  for (Offset = -BEARING_PEAK_HALF_WIDTH; Offset <= BEARING_PEAK_HALF_WIDTH;
+      Offset++)
+  {
+    Moment += (int32_t)Offset * Bins[BinIndex((int16_t)BestBin + Offset)];
+  }
+  Position = ((uint32_t)BestBin << BIN_FRACTION_SHIFT) +
+      (BIN_FRACTION_ONE / 2) + (BEARING_NUM_BINS << BIN_FRACTION_SHIFT);
+  Position += (uint32_t)((Moment * (int32_t)BIN_FRACTION_ONE) /
+      (int32_t)BestSum);
+  Position %= (BEARING_NUM_BINS << BIN_FRACTION_SHIFT);
+
+  *pCaptures = (uint32_t)(((uint64_t)Position * BEARING_SWEEP_CAPTURES) >>
+      BIN_FRACTION_SHIFT) / BEARING_NUM_BINS;
+  return true;
+}
+
+/****************************************************************************
+ Function
+     BeaconBearing_GetSightings
+
+ Returns
+     uint16_t, sightings binned since the sweep started
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint16_t BeaconBearing_GetSightings(void)
+{
+  return NumSightings;
+}
+
+/****************************************************************************
+ Function
+     BeaconBearing_GetHeading
+
+ Returns
+     uint32_t, captures turned since the current move started, the mean of
+     the two wheels
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint32_t BeaconBearing_GetHeading(void)
+{
+  return (SpeedControl_GetDistance(LEFT_MOTOR) +
+      SpeedControl_GetDistance(RIGHT_MOTOR) + 1) / 2;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+// a bin number off either end wraps round to the other
+static uint8_t BinIndex(int16_t Bin)
+{
+  return (uint8_t)((Bin + BEARING_NUM_BINS) % BEARING_NUM_BINS);
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
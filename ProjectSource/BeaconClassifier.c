@@ -0,0 +1,201 @@
+/****************************************************************************
+ Module
+   BeaconClassifier.c
+
+ Revision
+   0.1
+
+ Description
+   Tells the beacons apart by their frequency. Each period between edges is
+   dropped into a histogram with one bin per beacon. Once a window of
+   BEACON_WINDOW_EDGES periods has been seen, the fullest bin wins and its
+   share of the window is the confidence.
+
+ Notes
+   The per-edge path is a subtract and a few compares against period
+   limits that the compiler works out from the beacon frequencies. There
+   are no floats and no divides at run time; the window is a power of 2 so
+   the confidence is a shift.
+
+   Periods that don't fit any beacon (noise, two beacons in view, or the
+   gap while the robot turns from one beacon to the next) still count
+   toward the window, so they pull the confidence down rather than being
+   ignored.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "BeaconClassifier.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// shortest & longest period, in ticks, accepted for a beacon at Freq Hz
+#define PERIOD_MIN(Freq) \
+  ((uint32_t)(((uint64_t)BEACON_TICK_HZ * 100) / \
+      ((uint64_t)(Freq) * (100 + BEACON_TOLERANCE_PCT))))
+#define PERIOD_MAX(Freq) \
+  ((uint32_t)(((uint64_t)BEACON_TICK_HZ * 100) / \
+      ((uint64_t)(Freq) * (100 - BEACON_TOLERANCE_PCT))))
+
+#define BEACON_ENTRY(Freq) { PERIOD_MIN(Freq), PERIOD_MAX(Freq) }
+
+#if BEACON_WINDOW_SHIFT > 8
+#error "The window can be at most 256 periods for the confidence scaling"
+#endif
+
+typedef struct
+{
+  uint32_t MinPeriod;
+  uint32_t MaxPeriod;
+} BeaconBin_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+
+/*---------------------------- Module Variables ---------------------------*/
+// must stay in the same order as BeaconId_t
+static const BeaconBin_t BeaconTable[NUM_BEACON_IDS] = {
+  BEACON_ENTRY(1427),
+  BEACON_ENTRY(909),
+  BEACON_ENTRY(2000),
+  BEACON_ENTRY(3333)
+};
+
+static uint16_t BinCount[NUM_BEACON_IDS];
+static uint16_t NumPeriods;
+static uint32_t LastEdgeTime;
+static bool HaveLastEdge;
+
+static BeaconId_t LastWinner;
+static uint8_t LastConfidence;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     BeaconClassifier_Reset
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Starts a new window and forgets the last edge, for use after edges
+     have been lost
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void BeaconClassifier_Reset(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < NUM_BEACON_IDS; i++)
+  {
+    BinCount[i] = 0;
+  }
+  NumPeriods = 0;
+  HaveLastEdge = false;
+  LastConfidence = 0;
+}
+
+/****************************************************************************
+ Function
+     BeaconClassifier_AddEdge
+
+ Parameters
+     uint32_t EdgeTime, the time stamp of the edge in BEACON_TICK_HZ ticks
+
+ Returns
+     bool, true if this edge completed a window, the result is then
+     available from BeaconClassifier_GetResult
+
+ Description
+     Bins the period since the previous edge
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool BeaconClassifier_AddEdge(uint32_t EdgeTime)
+{
+  uint32_t period;
+  uint8_t i;
+  uint8_t winner;
+
+  if (!HaveLastEdge)
+  {
+    LastEdgeTime = EdgeTime;
+    HaveLastEdge = true;
+    return false;
+  }
+  period = EdgeTime - LastEdgeTime; // unsigned math takes care of the wrap
+  LastEdgeTime = EdgeTime;
+
+  for (i = 0; i < NUM_BEACON_IDS; i++)
+  {
+    if ((period >= BeaconTable[i].MinPeriod) &&
+        (period <= BeaconTable[i].MaxPeriod))
+    {
+      BinCount[i]++;
+      break;
+    }
+  }
+
+  if (++NumPeriods < BEACON_WINDOW_EDGES)
+  {
+    return false;
+  }
+
+  // end of the window, find the fullest bin and start over
+  winner = 0;
+  for (i = 0; i < NUM_BEACON_IDS; i++)
+  {
+    if (BinCount[i] > BinCount[winner])
+    {
+      winner = i;
+    }
+  }
+  LastWinner = (BeaconId_t)winner;
+  // scale the count in the window up to 0-256, and keep it in a byte
+  if (BinCount[winner] >= BEACON_WINDOW_EDGES)
+  {
+    LastConfidence = 255;
+  }
+  else
+  {
+    LastConfidence = (uint8_t)(BinCount[winner] << (8 - BEACON_WINDOW_SHIFT));
+  }
+
+  for (i = 0; i < NUM_BEACON_IDS; i++)
+  {
+    BinCount[i] = 0;
+  }
+  NumPeriods = 0;
+  return true;
+}
+
+/****************************************************************************
+ Function
+     BeaconClassifier_GetResult
+
+ Parameters
+     BeaconId_t *pId, set to the beacon that won the last window
+     uint8_t *pConfidence, set to the winner's share of the window (0-255)
+
+ Returns
+     bool, true if the confidence reached BEACON_MIN_CONFIDENCE
+
+ Description
+     Reports the result of the last complete window
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool BeaconClassifier_GetResult(BeaconId_t *pId, uint8_t *pConfidence)
+{
+  *pId = LastWinner;
+  *pConfidence = LastConfidence;
+  return LastConfidence >= BEACON_MIN_CONFIDENCE;
+}
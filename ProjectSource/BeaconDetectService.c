@@ -8,21 +8,15 @@
  Description
    This service handles input capture from a phototransistor circuit to
    measure beacon frequency. Uses interrupt-driven input capture to record
-   signal edge timing and detect 1427Hz beacon signal.
+   signal edge timing and detect 1427Hz beacon signal. The edges are also
+   run through BeaconClassifier to tell the beacons apart by frequency.
 
  Notes
     When initializing the Beacon Detection service:
         Set the Input Capture pin to digital, input mode
         Configure Input Capture pin as digital input
 
-        Configure a dedicated timer:
-            Disable the timer
-            Select internal PBCLK
-            Set timer prescaler
-            Clear TMRx
-            Load PRx with maximum period
-            Clear timer interrupt flag
-            Enable the timer
+        Start the shared capture time base (Timer3, see CaptureTimebase)
 
         Configure Input Capture module:
             Select timer as time base
@@ -30,30 +24,56 @@
             Clear input capture interrupt flag
             Enable input capture interrupt
 
-        Set PRINT_FREQUENCY_INTERVAL timeout to 100 ms
+        Set PRINT_FREQUENCY_TIMER timeout to BEACON_REPORT_MS
         Initialize LastCapturedTime to invalid value
 
-    Input Capture interrupt response routine:
-        Read ICxBUF into a local variable CapturedTime
-        Post an ES_NEW_SIGNAL_EDGE event
+    Input Capture interrupt response routine (every 4th capture):
+        While the IC FIFO is not empty (ICBNE)
+            Read ICxBUF, extend it to 32 bits with CaptureTimebase_Extend
+            Put it in the edge time stamp ring
         Clear the capture interrupt flag
+        If no ES_NEW_SIGNAL_EDGE is pending and either EDGE_BATCH_EDGES
+        edges are waiting or the oldest has waited EDGE_BATCH_MAX_MS
+            Post an ES_NEW_SIGNAL_EDGE event
 
     On ES_NEW_SIGNAL_EDGE event:
+        Take all of the time stamps out of the ring
+        Feed each one to the beacon classifier
+            When it completes a window with enough confidence,
+            note the middle of the window in core timer counts & the
+            time of the detection, then
+            publish ES_BEACON_DETECTED(beacon ID << 8 | confidence)
         If LastCapturedTime is valid:
-            Calculate time lapse:
-                (CapturedTime − LastCapturedTime + TimerMaximum) mod TimerMaximum
-            Calculate frequency from time lapse
-            If frequency is close to 1427 Hz, post ES_BEACON_DETECTED event
+            Calculate the mean period over the batch:
+                (newest time stamp - LastCapturedTime) / number of edges
+            Smooth it, for the frequency print out
 
-        Store CapturedTime into LastCapturedTime
+        Store the newest time stamp into LastCapturedTime
 
     On ES_TIMEOUT for PRINT_FREQUENCY_TIMER:
-        Calculate frequency from (current time − LastCapturedTime)
-        Print frequency value to screen
+        If no batch came in since the last one, the signal is gone:
+            frequency is 0, start the period & the classifier over
+        Else calculate frequency from the smoothed period
+        Print it at LOG_INFO if it moved by more than the deadband or
+        came or went, else at LOG_DEBUG
 
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       Tianyu  In the service table. Frequency reported every
+                        BEACON_REPORT_MS & logged on a change, sightings
+                        fused with the pin by BeaconDetect_TakeSighting.
+                        Dropped the RB15 timing pin, RB15 is IC4's now
+ 10/14/26       Tianyu  Prints go through ES_Log, the frequency at LOG_DEBUG
+ 10/14/26       Tianyu  InputCaptureISR reports to ES_IsrStats
+ 10/14/26       Tianyu  32 bit captures in the CAPTURE_TIMEBASE_32BIT build
+ 10/14/26       Tianyu  Timer3 & the rollover count moved to CaptureTimebase
+ 10/14/26       Tianyu  ES_BEACON_DETECTED is published to its subscribers
+ 10/14/26       Tianyu  ES_BEACON_DETECTED carries its edge time stamp
+ 10/14/26       Tianyu  CalculateFrequency uses FP_PeriodToHz, no divide
+ 10/14/26       Tianyu  Beacon ID & confidence from BeaconClassifier
+ 10/14/26       Tianyu  Drain the IC FIFO into a time stamp ring and compute
+                        the period in batches. Capture every edge at 1:8
  02/03/26       Tianyu  Initial creation for Lab 8 beacon detection
 ****************************************************************************/
 /*----------------------------- Include Files -----------------------------*/
@@ -62,39 +82,56 @@
 #include "ES_Timers.h"
 #include "BeaconDetectService.h"
 #include "MainLogicFSM.h"
-#include "dbprintf.h"
-#include "TimerConfig.h"
+#include "BeaconClassifier.h"
+#include "FixedPointUnits.h"
+#include "CaptureTimebase.h"
+#include "ES_Log.h"
+#include "ES_IsrStats.h"
+#include "Ports.h"
 #include <xc.h>
 #include <sys/attribs.h>
 
 /*----------------------------- Module Defines ----------------------------*/
 // Timer definitions
-#define PRINT_FREQUENCY_INTERVAL 100 // Print frequency every 100ms
+#define PRINT_FREQUENCY_INTERVAL BEACON_REPORT_MS
 
 // Input Capture pin configuration (IC1 on RB2/pin 6)
 #define IC_PIN_TRIS TRISBbits.TRISB2
 #define IC_PIN_ANSEL ANSELBbits.ANSB2
 
 
-// Timer configuration
-#define TIMER_PRESCALE 256
-#define PRESCALE_CHOSEN PRESCALE_256
-#define TIMER_MAX_PERIOD 0xFFFFFFFF // 32-bit timer maximum
+// Time stamps come from the capture time base, 2.5MHz gives ~1750 ticks per
+// beacon period (20MHz & ~14000 in the CAPTURE_TIMEBASE_32BIT build)
+#define TIMER_CLOCK CAPTURE_TIMEBASE_HZ
 
 // Frequency calculation constants
 #define INVALID_TIME 0xFFFFFFFF // Marker for invalid/uninitialized time
-#define IC_PRESCALE 16          // Input Capture prescale (captures every 16th edge)
-#define PBCLK_FREQ 20000000     // 20 MHz peripheral bus clock
+#define BEACON_IC_PRESCALE 1    // Input Capture prescale (captures every edge)
+
+// Edge batching. The time stamp ring must be a power of 2 and hold more than
+// one batch, so that the ISR can keep filling it while a batch waits in the
+// queue
+#define EDGE_RING_SIZE 32
+#define EDGE_RING_MASK (EDGE_RING_SIZE - 1)
+#define EDGE_BATCH_EDGES 8     // post after this many edges...
+#define EDGE_BATCH_MAX_MS 5    // ...or once the oldest edge is this old
+#define EDGE_BATCH_MAX_TICKS ((TIMER_CLOCK / 1000) * EDGE_BATCH_MAX_MS)
+
+#if TIMER_CLOCK != BEACON_TICK_HZ
+#error "BeaconClassifier expects time stamps at BEACON_TICK_HZ"
+#endif
+
+#if (EDGE_RING_SIZE & EDGE_RING_MASK) != 0
+#error "EDGE_RING_SIZE must be a power of 2"
+#endif
 
-// Beacon detection parameters
-#define TARGET_BEACON_FREQ 1427  // Target beacon frequency in Hz
-#define BEACON_FREQ_TOLERANCE 50 // ±50 Hz tolerance for beacon detection
 
 /*---------------------------- Module Functions ---------------------------*/
 /* Prototypes for private functions for this service */
-static void ConfigureICTimer(void);
 static void ConfigureInputCapture(void);
 static uint32_t CalculateFrequency(uint32_t timeLapse);
+static void ReportFrequency(void);
+static uint32_t WindowMiddleToCore(uint32_t EndTime);
 
 /*---------------------------- Module Variables ---------------------------*/
 // Module level Priority variable
@@ -102,13 +139,31 @@ static uint8_t MyPriority;
 
 // Time capture variables
 static uint32_t LastCapturedTime = INVALID_TIME;
-static volatile uint32_t CapturedTime = 0;
-static volatile uint16_t RolloverCounter = 0; // Counts Timer3 rollovers for extended timing
 
-// For time lapse smoothing
-static uint32_t SmoothedTimeLapse = 0;
+// Edge time stamp ring, EdgeHead is only written by the ISR and EdgeTail
+// only by the service, both are free running
+static volatile uint32_t EdgeRing[EDGE_RING_SIZE];
+static volatile uint8_t EdgeHead = 0;
+static volatile uint8_t EdgeTail = 0;
+// set by the ISR when it posts, cleared by the service when it drains
+static volatile bool EdgePostPending = false;
+// set by the ISR when an edge found the ring full
+static volatile bool EdgeOverrun = false;
+
+// For smoothing, the period is kept in 1/16ths of a timer tick
+#define PERIOD_FRACTION_BITS 4
+static uint32_t SmoothedPeriodX16 = 0;
 static bool FirstSample = true;
 
+// batches since the last report, none means the signal has gone
+static uint8_t BatchesSinceReport = 0;
+static uint32_t ReportedFrequency = 0;
+
+// the last detection, for BeaconDetect_TakeSighting
+static uint32_t DetectEdgeTime;   // core timer count
+static uint16_t DetectTime;       // ES_Timer_GetTime
+static bool HaveDetect = false;
+
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
  Function
@@ -121,7 +176,7 @@ static bool FirstSample = true;
      bool, false if error in initialization, true otherwise
 
  Description
-     Initializes the Input Capture module, phototransistor timer, and timing pin
+     Initializes the Input Capture module and the phototransistor timer
 
  Author
      Tianyu, 02/03/26
@@ -143,18 +198,20 @@ bool InitBeaconDetectService(uint8_t Priority)
   IC1R = 0b0100; // Map IC1 to RB2
   
   
-  // Configure the dedicated phototransistor timer
-  ConfigureICTimer();
-  
-  // Configure the Input Capture module
+  // Configure the Input Capture module, on the shared time base
   ConfigureInputCapture();
   
-  // Configure timing pin for performance measurement
-  ConfigureTimingPin();
-  
   // Initialize timing variables
   LastCapturedTime = INVALID_TIME;
-  CapturedTime = 0;
+  EdgeHead = 0;
+  EdgeTail = 0;
+  EdgePostPending = false;
+  EdgeOverrun = false;
+  FirstSample = true;
+  BatchesSinceReport = 0;
+  ReportedFrequency = 0;
+  HaveDetect = false;
+  BeaconClassifier_Reset();
   
   // Start the frequency print timer
   ES_Timer_InitTimer(PRINT_FREQUENCY_TIMER, PRINT_FREQUENCY_INTERVAL);
@@ -218,60 +275,87 @@ ES_Event_t RunBeaconDetectService(ES_Event_t ThisEvent)
   {
     case ES_INIT:
       // Initialization complete, nothing additional to do
-      DB_printf("Beacon Detection Service Initialized\r\n");
+      LOG_INFO("Beacon Detection Service Initialized\r\n");
       break;
       
     case ES_NEW_SIGNAL_EDGE:
     {
-        
-        // Latch current captured time
-        uint32_t CurrentCapturedTime = CapturedTime;
-      
-      // Calculate time lapse if we have a valid previous capture
-      if (LastCapturedTime != INVALID_TIME)
+      uint8_t   Tail = EdgeTail;
+      uint8_t   Head;
+      uint8_t   numEdges;
+      uint32_t  newestTime;
+      bool      hadOverrun;
+
+      // Snapshot the ring. Clear the pending flag first, so an edge that
+      // arrives after the snapshot gets its own post
+      EdgePostPending = false;
+      hadOverrun = EdgeOverrun;
+      EdgeOverrun = false;
+      Head = EdgeHead;
+      numEdges = (uint8_t)(Head - Tail);
+      if (numEdges == 0)
       {
-
-        // Calculate time lapse with wraparound handling
-        uint32_t timeLapse;
-        if (CurrentCapturedTime >= LastCapturedTime)
+        break;
+      }
+      if (hadOverrun)
+      {
+        // edges are missing ahead of this batch, don't bin the gap
+        BeaconClassifier_Reset();
+      }
+      for (; Tail != Head; Tail++)
+      {
+        if (BeaconClassifier_AddEdge(EdgeRing[Tail & EDGE_RING_MASK]))
         {
-          timeLapse = CurrentCapturedTime - LastCapturedTime;
-                  
-
+          BeaconId_t beaconId;
+          uint8_t confidence;
+
+          if (BeaconClassifier_GetResult(&beaconId, &confidence))
+          {
+            // Publish the beacon detected event, MainLogicFSM subscribes
+            ES_Event_t BeaconEvent;
+            BeaconEvent.EventType = ES_BEACON_DETECTED;
+            BeaconEvent.EventParam = BEACON_PARAM(beaconId, confidence);
+            // where the window was looking, in core timer counts, the
+            // same clock as the pin's edge times
+            DetectEdgeTime =
+                WindowMiddleToCore(EdgeRing[Tail & EDGE_RING_MASK]);
+            DetectTime = ES_Timer_GetTime();
+            HaveDetect = true;
+            ES_EVENT_SET_DATA(BeaconEvent, DetectEdgeTime);
+            ES_Publish(BeaconEvent);
+          }
         }
-        else
-        {
-          // Handle timer wraparound
-          timeLapse = (TIMER_MAX_PERIOD - LastCapturedTime) + CurrentCapturedTime + 1;
-        }    
-        
+      }
+      newestTime = EdgeRing[(uint8_t)(Head - 1) & EDGE_RING_MASK];
+      EdgeTail = Head; // hand the slots back to the ISR
+      if (BatchesSinceReport < UINT8_MAX)
+      {
+        BatchesSinceReport++;
+      }
+
+      // Calculate the mean period if we have a valid previous capture. Only
+      // the end points matter for this. Unsigned math takes care of the
+      // 32-bit wrap
+      if ((LastCapturedTime != INVALID_TIME) &&
+          ((newestTime - LastCapturedTime) <= (UINT32_MAX >> PERIOD_FRACTION_BITS)))
+      {
+        uint32_t span = newestTime - LastCapturedTime;
+        uint32_t periodX16 = (span << PERIOD_FRACTION_BITS) / numEdges;
+
         if (FirstSample)
         {
-          SmoothedTimeLapse = timeLapse;
+          SmoothedPeriodX16 = periodX16;
           FirstSample = false;
         }
         else
         {
-          SmoothedTimeLapse = (timeLapse + 5 * SmoothedTimeLapse) / 6;
-        }
-        
-        // Calculate frequency and check if it matches beacon frequency
-        uint32_t frequency = CalculateFrequency(SmoothedTimeLapse);
-        
-        // Check if frequency is close to target beacon frequency
-        if ((frequency >= (TARGET_BEACON_FREQ - BEACON_FREQ_TOLERANCE)) &&
-            (frequency <= (TARGET_BEACON_FREQ + BEACON_FREQ_TOLERANCE)))
-        {
-          // Post beacon detected event to MainLogicFSM
-          ES_Event_t BeaconEvent;
-          BeaconEvent.EventType = ES_BEACON_DETECTED;
-          BeaconEvent.EventParam = frequency;
-          PostMainLogicFSM(BeaconEvent);
+          SmoothedPeriodX16 = (periodX16 + 5 * SmoothedPeriodX16) / 6;
         }
       }
       
-      // Store current capture as the last capture for next calculation
-      LastCapturedTime = CurrentCapturedTime;
+      // Store the newest capture as the last capture for the next batch,
+      // unless edges were lost, in which case the next span would be wrong
+      LastCapturedTime = hadOverrun ? INVALID_TIME : newestTime;
       break;
     }
     
@@ -279,14 +363,8 @@ ES_Event_t RunBeaconDetectService(ES_Event_t ThisEvent)
       // Check if this is the frequency print timer
       if (ThisEvent.EventParam == PRINT_FREQUENCY_TIMER)
       {
-        // Calculate and print frequency
-        TIMING_PIN_LAT = 1; // Raise timing pin
-        uint32_t frequency = CalculateFrequency(SmoothedTimeLapse);
-        TIMING_PIN_LAT = 0; // Lower timing pin
-          
-        // Print frequency to screen
-        DB_printf("Frequency: %d Hz\r\n", frequency);
-        
+        ReportFrequency();
+
         // Restart the frequency print timer
         ES_Timer_InitTimer(PRINT_FREQUENCY_TIMER, PRINT_FREQUENCY_INTERVAL);
       }
@@ -301,52 +379,50 @@ ES_Event_t RunBeaconDetectService(ES_Event_t ThisEvent)
 
 /****************************************************************************
  Function
-     InputCaptureISR
+     BeaconDetect_TakeSighting
 
  Parameters
-     None
+     ES_Event_t ThisEvent - an ES_BEACON_DETECTED, from either source
+     uint32_t *pEdgeTime - where to put the core timer count the sighting
+                           was made at
 
  Returns
-     None
+     bool, false if the sighting is to be dropped
 
  Description
-     Input Capture interrupt response routine. Reads the captured time
-     and posts an event to the beacon detection service.
+     Fuses the capture path's detections with the beacon pin's. A
+     detection is timed at the middle of its window, from the captures. A
+     pin event is dropped while the capture path has the beacon, &
+     otherwise timed at the last edge the change notice ISR latched, or at
+     the call without USE_CN_INPUT_EVENTS
 
  Author
-     Tianyu, 02/03/26
+     Tianyu, 10/14/26
 ****************************************************************************/
-void __ISR(_INPUT_CAPTURE_1_VECTOR, IPL7SOFT) InputCaptureISR(void)
+bool BeaconDetect_TakeSighting(ES_Event_t ThisEvent, uint32_t *pEdgeTime)
 {
-
-  // Read the captured timer value from IC buffer
-  uint16_t capturedTimer16 = IC1BUF;
-      
-  // Clear the input capture interrupt flag
-  IFS0CLR = _IFS0_IC1IF_MASK;
-
-  // If T3IF is pending and captured value is after rollover (in lower half of timer range)
-  if (IFS0bits.T3IF && (capturedTimer16 < 0x8000))
+  // only the classifier's detections have a confidence
+  if (BEACON_PARAM_CONFIDENCE(ThisEvent.EventParam) != 0)
   {
-      // Increment the roll-over counter
-      RolloverCounter++;
-
-      // Clear the roll-over interrupt flag
-      IFS0CLR = _IFS0_T3IF_MASK;
+    *pEdgeTime = DetectEdgeTime;
+    return true;
   }
-
-  // Combine roll-over counter with captured timer value to create a full 32-bit time
-  CapturedTime = ((uint32_t)RolloverCounter << 16) | capturedTimer16;
-  
-  // Post event for the captured value
-  ES_Event_t NewEvent;
-  NewEvent.EventType = ES_NEW_SIGNAL_EDGE;
-  PostBeaconDetectService(NewEvent);
+  if (HaveDetect &&
+      ((uint16_t)(ES_Timer_GetTime() - DetectTime) < BEACON_LOCK_MS))
+  {
+    return false;
+  }
+#ifdef USE_CN_INPUT_EVENTS
+  *pEdgeTime = GetBeaconEdgeTime();
+#else
+  *pEdgeTime = _CP0_GET_COUNT();
+#endif
+  return true;
 }
 
 /****************************************************************************
  Function
-     Timer3ISR
+     InputCaptureISR
 
  Parameters
      None
@@ -355,84 +431,69 @@ void __ISR(_INPUT_CAPTURE_1_VECTOR, IPL7SOFT) InputCaptureISR(void)
      None
 
  Description
-     Timer3 interrupt response routine. Increments the rollover counter
-     to extend timing range beyond 16-bit timer. Works in collaboration
-     with Input Capture ISR to provide extended 32-bit timing for long
-     period measurements.
+     Input Capture interrupt response routine. Moves every capture waiting
+     in the IC FIFO into the edge time stamp ring and posts a batch to the
+     beacon detection service when one is ready.
+
+ Notes
+     Only posts when no post is already waiting, so the service queue holds
+     at most one ES_NEW_SIGNAL_EDGE no matter how fast the edges come.
 
  Author
      Tianyu, 02/03/26
 ****************************************************************************/
-void __ISR(_TIMER_3_VECTOR, IPL6SOFT) Timer3ISR(void)
+void __ISR(_INPUT_CAPTURE_1_VECTOR, IPL7SOFT) InputCaptureISR(void)
 {
-    // Disable interrupts globally to prevent race condition with IC ISR
-    __builtin_disable_interrupts();
-    
-    // If T3IF is pending (timer has rolled over)
-    if (IFS0bits.T3IF)
-    {
-        // Increment the roll-over counter to track timer wraparounds
-        RolloverCounter++;
+  uint8_t Head = EdgeHead;
+  uint32_t capturedTime = 0;
+
+  ES_IsrStats_Enter(ES_ISR(BeaconCapture), ES_ISR_LATENCY_UNKNOWN);
+  // drain the whole FIFO, the interrupt only comes every 4th capture
+  while (IC1CONbits.ICBNE)
+  {
+    // Extend the captured Timer3 value to a full 32-bit time
+    capturedTime = CaptureTimebase_Extend((CaptureRaw_t)IC1BUF);
 
-        // Clear the roll-over interrupt flag
-        IFS0CLR = _IFS0_T3IF_MASK;
+    if ((uint8_t)(Head - EdgeTail) < EDGE_RING_SIZE)
+    {
+      EdgeRing[Head & EDGE_RING_MASK] = capturedTime;
+      Head++;
     }
+    else
+    {
+      EdgeOverrun = true; // the service has fallen behind, drop the edge
+    }
+  }
+  EdgeHead = Head;
+
+  // Clear the input capture interrupt flag, now that the FIFO is empty
+  IFS0CLR = _IFS0_IC1IF_MASK;
+  // against the newest capture, the one that raised the interrupt unless
+  // the FIFO had backed up
+  ES_IsrStats_NoteLatency(ES_ISR(BeaconCapture),
+      CAPTURE_TIMEBASE_TO_CORE(CaptureTimebase_GetTime() - capturedTime));
 
-    // Re-enable interrupts globally
-    __builtin_enable_interrupts();
+  // Post a batch if it is big enough or has waited long enough
+  if (!EdgePostPending && (Head != EdgeTail))
+  {
+    uint8_t numEdges = (uint8_t)(Head - EdgeTail);
+    uint32_t oldestAge = capturedTime - EdgeRing[EdgeTail & EDGE_RING_MASK];
+
+    if ((numEdges >= EDGE_BATCH_EDGES) || (oldestAge >= EDGE_BATCH_MAX_TICKS))
+    {
+      ES_Event_t NewEvent;
+      NewEvent.EventType = ES_NEW_SIGNAL_EDGE;
+      NewEvent.EventParam = numEdges;
+      EdgePostPending = PostBeaconDetectService(NewEvent);
+    }
+  }
+  ES_IsrStats_Exit(ES_ISR(BeaconCapture));
 }
 
 /***************************************************************************
  private functions
  ***************************************************************************/
 
-/****************************************************************************
- Function
-     ConfigureICTimer
-
- Parameters
-     None
-
- Returns
-     None
-
- Description
-     Configures Timer3 as the time base for input capture with maximum period
-
- Author
-     Tianyu, 02/03/26
-****************************************************************************/
-static void ConfigureICTimer(void)
-{
-  // Disable the timer during configuration
-  T3CONbits.ON = 0;
-  
-  // Select internal PBCLK as clock source (default)
-  T3CONbits.TCS = 0;
-  
-  // Set timer prescaler using lookup table for readability
-  T3CONbits.TCKPS = PrescaleLookup[PRESCALE_CHOSEN];
-  
-  // Clear timer register
-  TMR3 = 0;
-  
-  // Load period register with maximum value for maximum range
-  PR3 = TIMER_MAX_PERIOD;
-  
-  // Clear timer interrupt flag
-  IFS0bits.T3IF = 0;
-
-  // Configure the interrupt priority and subpriority levels in the IPCx register
-  IPC3bits.T3IP = 6; // Priority 6
-  IPC3bits.T3IS = 0; // Subpriority 0
-
-  // Set the T3IE interrupt bit in the IEC0 register
-  IEC0bits.T3IE = 1;
-  
-  // Enable the timer
-  T3CONbits.ON = 1;
-}
-
 /****************************************************************************
  Function
      ConfigureInputCapture
@@ -445,24 +506,29 @@ static void ConfigureICTimer(void)
 
  Description
      Configures Input Capture module 1 to capture on rising edges using
-     Timer3 as the time base
+     Timer3, the shared capture time base
 
  Author
      Tianyu, 02/03/26
 ****************************************************************************/
 static void ConfigureInputCapture(void)
 {
-  // Disable base timer during configuration
-  T3CONbits.ON = 0;
+  // Make sure the time base is running, it may already be from the encoders
+  CaptureTimebase_Init();
 
   // Disable Input Capture module during configuration
   IC1CONbits.ON = 0;
   
   // Select Timer3 as time base (ICTMR = 0 means Timer3 for IC1)
   IC1CONbits.ICTMR = 0;
+
+  // 16 or 32 bit captures, to match the time base
+  IC1CONbits.ICC32 = CAPTURE_TIMEBASE_ICC32;
   
-  // Configure to capture on every 16th rising edge (ICM = 101)
-  IC1CONbits.ICM = 0b101;
+  // Configure to capture on every rising edge (ICM = 011) and interrupt on
+  // every 4th capture (ICI = 11), the ISR drains the FIFO
+  IC1CONbits.ICM = 0b011;
+  IC1CONbits.ICI = 0b11;
   
   // Clear the input capture interrupt flag
   IFS0CLR = _IFS0_IC1IF_MASK;
@@ -482,9 +548,6 @@ static void ConfigureInputCapture(void)
   
   // Enable the Input Capture module
   IC1CONbits.ON = 1;
-
-  // Enable the timer after IC configuration is complete
-  T3CONbits.ON = 1;
 }
 
 /****************************************************************************
@@ -492,10 +555,11 @@ static void ConfigureInputCapture(void)
      CalculateFrequency
 
  Parameters
-     uint32_t timeLapse - time between signal edges in timer ticks
+     uint32_t periodX16 - time between signal edges in 1/16ths of a timer
+                          tick
 
  Returns
-     uint32_t - calculated frequency in Hz
+     uint32_t - calculated frequency in Hz, rounded
 
  Description
      Calculates frequency based on the time between signal edges
@@ -503,22 +567,103 @@ static void ConfigureInputCapture(void)
  Author
      Tianyu, 02/03/26
 ****************************************************************************/
-static uint32_t CalculateFrequency(uint32_t timeLapse)
+static uint32_t CalculateFrequency(uint32_t periodX16)
 {
   // Prevent division by zero
-  if (timeLapse == 0)
+  if (periodX16 == 0)
   {
     return 0;
   }
   
-  // Calculate timer clock frequency
-  uint32_t timerClock = PBCLK_FREQ / TIMER_PRESCALE;
-  
-  // Calculate frequency in Hz
-  // frequency = timerClock / (timeLapse * IC_PRESCALE)
-  uint32_t frequency = timerClock / (timeLapse * IC_PRESCALE);
-  
-  return frequency;
+  // frequency = timerClock / (period * BEACON_IC_PRESCALE), with the
+  // fraction bits moved to the numerator. 2.5MHz * 16 still fits in 32 bits
+  uint32_t divisor = periodX16 * BEACON_IC_PRESCALE;
+
+  return FP_PeriodToHz(divisor, (uint32_t)TIMER_CLOCK << PERIOD_FRACTION_BITS);
+}
+
+/****************************************************************************
+ Function
+     ReportFrequency
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Works out the frequency for this report. It goes to the log at
+     LOG_INFO when it has moved by more than BEACON_REPORT_DEADBAND_HZ from
+     the last one logged there, or the signal has come or gone, & at
+     LOG_DEBUG otherwise. A report with no batch since the last one means
+     the signal has gone, & the period & the classifier start over, so the
+     gap isn't taken for a period when it comes back
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static void ReportFrequency(void)
+{
+  uint32_t frequency = 0;
+  uint32_t change;
+
+  if (BatchesSinceReport == 0)
+  {
+    LastCapturedTime = INVALID_TIME;
+    FirstSample = true;
+    HaveDetect = false;
+    BeaconClassifier_Reset();
+  }
+  else if (!FirstSample)
+  {
+    frequency = CalculateFrequency(SmoothedPeriodX16);
+  }
+  BatchesSinceReport = 0;
+
+  change = (frequency > ReportedFrequency) ?
+      (frequency - ReportedFrequency) : (ReportedFrequency - frequency);
+  if ((change > BEACON_REPORT_DEADBAND_HZ) ||
+      ((frequency == 0) != (ReportedFrequency == 0)))
+  {
+    LOG_INFO("Frequency: %u Hz\r\n", frequency);
+    ReportedFrequency = frequency;
+  }
+  else
+  {
+    LOG_DEBUG("Frequency: %u Hz\r\n", frequency);
+  }
+}
+
+/****************************************************************************
+ Function
+     WindowMiddleToCore
+
+ Parameters
+     uint32_t EndTime - time stamp of the edge that completed a window
+
+ Returns
+     uint32_t - the core timer count at the middle of the window
+
+ Description
+     The classifier's window is BEACON_WINDOW_EDGES periods, so its middle
+     is half that many smoothed periods before its last edge. Before there
+     is a period to go by it is the last edge
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static uint32_t WindowMiddleToCore(uint32_t EndTime)
+{
+  uint32_t now = _CP0_GET_COUNT();
+  uint32_t age = CaptureTimebase_GetTime() - EndTime;
+
+  if (!FirstSample)
+  {
+    age += (SmoothedPeriodX16 << (BEACON_WINDOW_SHIFT - 1)) >>
+        PERIOD_FRACTION_BITS;
+  }
+  return now - CAPTURE_TIMEBASE_TO_CORE(age);
 }
 
 /*------------------------------- Footnotes -------------------------------*/
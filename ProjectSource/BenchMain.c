@@ -0,0 +1,418 @@
+/****************************************************************************
+ Module
+     BenchMain.c
+
+ Revision
+     0.1
+
+ Description
+     Microbenchmarks of the framework primitives & the drivers, to build in
+     place of main.c. Prints one table over the UART & stops.
+
+ Notes
+     To build it for the board, exclude main.c from the project & include
+     this file instead. On the host, make microbench in HostSim/ does the
+     same.
+
+     All numbers are core timer counts (20 per uS, 2 CPU clocks each), with
+     the cost of reading the core timer taken off. Interrupts stay on, so
+     the max picks up whatever ISR landed in the measurement, the min &
+     mean are the ones to track from build to build.
+
+     ES_Initialize runs as usual so the service queues, timers & hardware
+     are the ones the application uses, but ES_Run never does. All of the
+     framework timers are stopped & the queues emptied before each test.
+
+     The SPI transfer polls for the reply with the SPI1 RX interrupt off &
+     gives up after BENCH_SPI_TIMEOUT_US, counted in the Lost column. With
+     no command generator there is no SS to answer to on the board, so
+     only the time to shift out & back is measured.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  The queue is an ES_Queue_t over packed entries
+ 10/14/26       Tianyu  Initial creation
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
+#include "ES_Timers.h"
+#include "ES_Queue.h"
+#include "terminal.h"
+#include "dbprintf.h"
+#include "PIC32_AD_Lib.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define BENCH_ITERATIONS 100
+#define BENCH_PRINTF_ITERATIONS 8
+#define BENCH_QUEUE_SIZE 4
+#define BENCH_NUM_TIMERS 32         // ES_Timers.c's timer count
+#define BENCH_TIMER_TICKS 30000     // long enough not to expire in a test
+#define BENCH_SPI_TIMEOUT_US 200
+#define BENCH_SPI_BYTE 0xAA
+#define BENCH_MAX_ADC_CHANNELS 16
+
+typedef struct
+{
+  const char *pName;
+  uint32_t   Param;      // test specific, e.g. the number of timers
+  uint32_t   Count;
+  uint32_t   Min;
+  uint32_t   Max;
+  uint64_t   Sum;
+  uint32_t   Lost;       // measurements that timed out
+} BenchResult_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void QuietFramework(void);
+static void WaitForUART(void);
+static void MeasureOverhead(void);
+static BenchResult_t *NewResult(const char *pName, uint32_t Param);
+static void NoteCycles(BenchResult_t *pResult, uint32_t Start, uint32_t Stop);
+static void PrintResult(const BenchResult_t *pResult);
+
+static void BenchQueue(uint8_t Kind);
+static void BenchPost(void);
+static void BenchTimerTick(uint8_t NumTimers, ES_TimerTime_t Ticks);
+static void BenchPrintf(void);
+static void BenchADC(void);
+static void BenchSPI(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint32_t Overhead;
+static uint8_t  UsableTimers[BENCH_NUM_TIMERS];
+static uint8_t  NumUsableTimers;
+static ES_PackedEvent_t BenchQueueEntries[BENCH_QUEUE_SIZE];
+static ES_QueueState_t  BenchQueueState;
+
+// the results are printed at the end, so that the DB_printf test's own
+// lines don't break up the table
+static BenchResult_t Results[20];
+static uint8_t NumResults;
+
+/*------------------------------ Module Code ------------------------------*/
+void main(void)
+{
+  uint8_t i;
+
+  _HW_PIC32Init();
+  if (ES_Initialize(ES_Timer_RATE_1mS) != Success)
+  {
+    DB_printf("\r\nES_Initialize failed\r\n");
+    for ( ; ;)
+    {
+      Terminal_MoveBuffer2UART();
+    }
+  }
+
+  // find the timers that have a service to post to
+  for (i = 0; i < BENCH_NUM_TIMERS; i++)
+  {
+    if (ES_Timer_InitTimer(i, BENCH_TIMER_TICKS) == ES_Timer_OK)
+    {
+      UsableTimers[NumUsableTimers++] = i;
+    }
+  }
+  QuietFramework();
+  MeasureOverhead();
+
+  BenchQueue(ES_QUEUE_KIND_CRITICAL);
+  BenchQueue(ES_QUEUE_KIND_SPSC);
+  BenchPost();
+  BenchTimerTick(0, BENCH_TIMER_TICKS);
+  BenchTimerTick(1, BENCH_TIMER_TICKS);
+  BenchTimerTick(NumUsableTimers, BENCH_TIMER_TICKS);
+  BenchTimerTick(1, 1);
+  BenchTimerTick(NumUsableTimers, 1);
+  BenchPrintf();
+  BenchADC();
+  BenchSPI();
+
+  DB_printf("\r\nBenchmark, core timer counts (20/uS) less %u to read the "
+      "timer\r\n", Overhead);
+  DB_printf("Test  Param  N  Min  Max  Mean  Lost\r\n");
+  for (i = 0; i < NumResults; i++)
+  {
+    PrintResult(&Results[i]);
+    WaitForUART();
+  }
+  WaitForUART();
+#ifdef ES_HOST_SIM
+  exit(0);
+#else
+  for ( ; ;)
+  {
+    ;
+  }
+#endif
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+// stop every framework timer & empty every queue
+static void QuietFramework(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < BENCH_NUM_TIMERS; i++)
+  {
+    ES_Timer_StopTimer(i);
+  }
+  for (i = 0; i < NUM_SERVICES; i++)
+  {
+    ES_FlushServiceQueue(i);
+  }
+}
+
+static void WaitForUART(void)
+{
+  while (!Terminal_IsXmitBufferEmpty())
+  {
+    Terminal_MoveBuffer2UART();
+  }
+}
+
+// the least it takes to read the core timer twice, taken off every result
+static void MeasureOverhead(void)
+{
+  uint32_t Start;
+  uint32_t Stop;
+  uint8_t  i;
+
+  Overhead = UINT32_MAX;
+  for (i = 0; i < 16; i++)
+  {
+    Start = _HW_GetCycleCount();
+    Stop = _HW_GetCycleCount();
+    if ((Stop - Start) < Overhead)
+    {
+      Overhead = Stop - Start;
+    }
+  }
+}
+
+// the next slot in Results, the last one is reused if they run out
+static BenchResult_t *NewResult(const char *pName, uint32_t Param)
+{
+  BenchResult_t *pResult = &Results[NumResults];
+
+  if (NumResults < ARRAY_SIZE(Results) - 1)
+  {
+    NumResults++;
+  }
+  pResult->pName = pName;
+  pResult->Param = Param;
+  pResult->Count = 0;
+  pResult->Min = UINT32_MAX;
+  pResult->Max = 0;
+  pResult->Sum = 0;
+  pResult->Lost = 0;
+  return pResult;
+}
+
+static void NoteCycles(BenchResult_t *pResult, uint32_t Start, uint32_t Stop)
+{
+  uint32_t Cycles = Stop - Start;
+
+  Cycles = (Cycles > Overhead) ? (Cycles - Overhead) : 0;
+  if (Cycles < pResult->Min)
+  {
+    pResult->Min = Cycles;
+  }
+  if (Cycles > pResult->Max)
+  {
+    pResult->Max = Cycles;
+  }
+  pResult->Sum += Cycles;
+  pResult->Count++;
+}
+
+static void PrintResult(const BenchResult_t *pResult)
+{
+  DB_printf("%s  %u  %u  %u  %u  %u  %u\r\n", pResult->pName, pResult->Param,
+      pResult->Count, (pResult->Count != 0) ? pResult->Min : 0, pResult->Max,
+      (pResult->Count != 0) ? (uint32_t)(pResult->Sum / pResult->Count) : 0,
+      pResult->Lost);
+}
+
+// an enqueue & a dequeue per iteration, so the indexes walk all the way
+// round the block
+static void BenchQueue(uint8_t Kind)
+{
+  bool IsSPSC = (Kind == ES_QUEUE_KIND_SPSC);
+  BenchResult_t *pPut = NewResult(IsSPSC ? "ES_EnQueueFIFO SPSC" :
+      "ES_EnQueueFIFO", BENCH_QUEUE_SIZE);
+  BenchResult_t *pGet = NewResult(IsSPSC ? "ES_DeQueue SPSC" : "ES_DeQueue",
+      BENCH_QUEUE_SIZE);
+  // the same entries for both kinds, so this one can't be const
+  ES_Queue_t Queue = { BenchQueueEntries, &BenchQueueState,
+      BENCH_QUEUE_SIZE, Kind };
+  ES_Event_t Event = { ES_NEW_KEY, 0 };
+  uint32_t   Start;
+  uint32_t   Stop;
+  uint16_t   i;
+
+  ES_InitQueue(&Queue);
+  for (i = 0; i < BENCH_ITERATIONS; i++)
+  {
+    Event.EventParam = i;
+    Start = _HW_GetCycleCount();
+    ES_EnQueueFIFO(&Queue, Event);
+    Stop = _HW_GetCycleCount();
+    NoteCycles(pPut, Start, Stop);
+
+    Start = _HW_GetCycleCount();
+    ES_DeQueue(&Queue, &Event);
+    Stop = _HW_GetCycleCount();
+    NoteCycles(pGet, Start, Stop);
+  }
+}
+
+// a post to the lowest priority service, its queue emptied each time
+static void BenchPost(void)
+{
+  BenchResult_t *pResult = NewResult("ES_PostToService", 0);
+  ES_Event_t Event = { ES_NEW_KEY, 0 };
+  uint32_t   Start;
+  uint32_t   Stop;
+  uint16_t   i;
+
+  for (i = 0; i < BENCH_ITERATIONS; i++)
+  {
+    ES_FlushServiceQueue(0);
+    Start = _HW_GetCycleCount();
+    ES_PostToService(0, Event);
+    Stop = _HW_GetCycleCount();
+    NoteCycles(pResult, Start, Stop);
+  }
+  ES_FlushServiceQueue(0);
+}
+
+// one tick with NumTimers running. With Ticks at 1 they all expire on it
+// & post their timeouts
+static void BenchTimerTick(uint8_t NumTimers, ES_TimerTime_t Ticks)
+{
+  BenchResult_t *pResult = NewResult((Ticks == 1) ?
+      "Tick_Resp expiring" : "ES_Timer_Tick_Resp", NumTimers);
+  uint32_t Start;
+  uint32_t Stop;
+  uint16_t i;
+  uint8_t  j;
+
+  QuietFramework();
+  for (j = 0; j < NumTimers; j++)
+  {
+    ES_Timer_InitTimer(UsableTimers[j], Ticks);
+  }
+  for (i = 0; i < BENCH_ITERATIONS; i++)
+  {
+    Start = _HW_GetCycleCount();
+    ES_Timer_Tick_Resp();
+    Stop = _HW_GetCycleCount();
+    NoteCycles(pResult, Start, Stop);
+    if (Ticks == 1)
+    {
+      QuietFramework();
+      for (j = 0; j < NumTimers; j++)
+      {
+        ES_Timer_InitTimer(UsableTimers[j], Ticks);
+      }
+    }
+  }
+  QuietFramework();
+}
+
+// typical lines from the application's reports, each into an empty
+// transmit buffer
+static void BenchPrintf(void)
+{
+  BenchResult_t *pNumbers = NewResult("DB_printf numbers", 3);
+  BenchResult_t *pString = NewResult("DB_printf string", 1);
+  uint32_t Start;
+  uint32_t Stop;
+  uint8_t  i;
+
+  DB_printf("\r\n");
+  for (i = 0; i < BENCH_PRINTF_ITERATIONS; i++)
+  {
+    WaitForUART();
+    Start = _HW_GetCycleCount();
+    DB_printf("%d   %d   %u\r\n", i, -42, 123456u);
+    Stop = _HW_GetCycleCount();
+    NoteCycles(pNumbers, Start, Stop);
+
+    WaitForUART();
+    Start = _HW_GetCycleCount();
+    DB_printf("Command %s received\r\n", "DRIVE_FWD_FULL");
+    Stop = _HW_GetCycleCount();
+    NoteCycles(pString, Start, Stop);
+  }
+  WaitForUART();
+}
+
+// a read of the latest result set, as the application has the A/D set up
+static void BenchADC(void)
+{
+  BenchResult_t *pResult = NewResult("ADC_MultiRead", 0);
+  uint32_t AdcResults[BENCH_MAX_ADC_CHANNELS];
+  uint32_t Start;
+  uint32_t Stop;
+  uint16_t i;
+
+  for (i = 0; i < BENCH_ITERATIONS; i++)
+  {
+    Start = _HW_GetCycleCount();
+    ADC_MultiRead(AdcResults);
+    Stop = _HW_GetCycleCount();
+    NoteCycles(pResult, Start, Stop);
+  }
+}
+
+// one 8 bit transfer on SPI1, set up by SPIBusService, from the
+// write to SPI1BUF to reading the reply
+static void BenchSPI(void)
+{
+  BenchResult_t *pResult = NewResult("SPI1 8 bit xfer", BENCH_SPI_BYTE);
+  uint32_t Start;
+  uint32_t Stop;
+  uint16_t i;
+  bool     WasEnabled = IEC1bits.SPI1RXIE;
+  volatile uint32_t Discard;
+
+  IEC1CLR = _IEC1_SPI1RXIE_MASK;
+  while (!SPI1STATbits.SPIRBE)
+  {
+    Discard = SPI1BUF;
+  }
+  for (i = 0; i < BENCH_ITERATIONS; i++)
+  {
+    Start = _HW_GetCycleCount();
+    SPI1BUF = BENCH_SPI_BYTE;
+    while (SPI1STATbits.SPIRBE &&
+        ((_HW_GetCycleCount() - Start) <
+        (BENCH_SPI_TIMEOUT_US * _HW_CYCLES_PER_US)))
+    {}
+    if (SPI1STATbits.SPIRBE)
+    {
+      pResult->Lost++;
+      continue;
+    }
+    Discard = SPI1BUF;
+    Stop = _HW_GetCycleCount();
+    NoteCycles(pResult, Start, Stop);
+  }
+  (void)Discard;
+  IFS1CLR = _IFS1_SPI1RXIF_MASK;
+  if (WasEnabled)
+  {
+    IEC1SET = _IEC1_SPI1RXIE_MASK;
+  }
+}
@@ -0,0 +1,209 @@
+/****************************************************************************
+ Module
+   CaptureTimebase.c
+
+ Revision
+   0.1
+
+ Description
+   Owns Timer3 as the free running time base for the input capture
+   channels and extends it to 32 bits.
+
+ Notes
+   Only the Timer3 ISR writes Rollovers. A reader takes Rollovers, the
+   rollover flag & TMR3 and goes again if Rollovers or the flag changed
+   while it was reading, so the three always belong together. If the flag
+   is set the rollover it stands for hasn't been counted yet (the reader
+   is at the Timer3 ISR priority, or the ISR just hasn't run), so it is
+   counted here. No reader can be above the Timer3 ISR, see
+   CAPTURE_TIMEBASE_PRIORITY, so the ISR clearing the flag & counting are
+   never seen half done.
+
+   A 16 bit capture is extended by stepping back from the current time by
+   how far TMR3 has moved since the capture. That is exact as long as the
+   capture is less than one Timer3 period old, so there is no guessing
+   from which half of the count the capture is in.
+
+   In the CAPTURE_TIMEBASE_32BIT build none of that is needed, TMR2 reads
+   the whole 32 bit count of the pair and the captures are already 32 bits.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Timer3ISR reports to ES_IsrStats
+ 10/14/26       Tianyu  CAPTURE_TIMEBASE_32BIT build on the Timer2/3 pair
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "CaptureTimebase.h"
+#include "ES_IsrStats.h"
+#include <xc.h>
+#include <sys/attribs.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+#define TIMER3_FULL_PERIOD 0xFFFF
+#define TIMER23_FULL_PERIOD 0xFFFFFFFF
+
+#if defined(CAPTURE_TIMEBASE_32BIT) && (CAPTURE_TIMEBASE_PRESCALE != 1)
+#error "CaptureTimebase_Init sets TCKPS for a 1:1 prescale"
+#elif !defined(CAPTURE_TIMEBASE_32BIT) && (CAPTURE_TIMEBASE_PRESCALE != 8)
+#error "CaptureTimebase_Init sets TCKPS for a 1:8 prescale"
+#endif
+
+/*---------------------------- Module Variables ---------------------------*/
+#ifndef CAPTURE_TIMEBASE_32BIT
+// upper 16 bits of the time, one count per Timer3 rollover
+static volatile uint16_t Rollovers;
+#endif
+static bool Running = false;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     CaptureTimebase_Init
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Starts Timer3 free running & its rollover interrupt. Every capture
+     user calls it, only the first call does anything
+
+ Notes
+     The PWM library also sets up Timer3 (PWMSetup_BasicConfig), so this
+     has to come after DCMotorService has configured the PWM
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void CaptureTimebase_Init(void)
+{
+  if (Running)
+  {
+    return;
+  }
+#ifdef CAPTURE_TIMEBASE_32BIT
+  // Timer2 is the master of the pair, Timer3's own settings are ignored
+  T2CONbits.ON = 0;
+  T3CONbits.ON = 0;
+  IEC0CLR = _IEC0_T2IE_MASK | _IEC0_T3IE_MASK;
+  T2CONbits.T32 = 1;
+  T2CONbits.TCS = 0;        // PBCLK
+  T2CONbits.TCKPS = 0;      // 1:1
+  TMR2 = 0;
+  PR2 = TIMER23_FULL_PERIOD;
+  T2CONbits.ON = 1;
+#else
+  T3CONbits.ON = 0;
+  T3CONbits.TCS = 0;        // PBCLK
+  T3CONbits.TCKPS = 0b011;  // 1:8
+  TMR3 = 0;
+  PR3 = TIMER3_FULL_PERIOD;
+  Rollovers = 0;
+
+  IFS0CLR = _IFS0_T3IF_MASK;
+  IPC3bits.T3IP = CAPTURE_TIMEBASE_PRIORITY;
+  IPC3bits.T3IS = 0;
+  IEC0SET = _IEC0_T3IE_MASK;
+
+  T3CONbits.ON = 1;
+#endif
+  Running = true;
+}
+
+/****************************************************************************
+ Function
+     CaptureTimebase_GetTime
+
+ Parameters
+     None
+
+ Returns
+     uint32_t, the current time in CAPTURE_TIMEBASE_HZ ticks
+
+ Description
+     Safe from the main loop & any ISR up to CAPTURE_TIMEBASE_PRIORITY
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint32_t CaptureTimebase_GetTime(void)
+{
+#ifdef CAPTURE_TIMEBASE_32BIT
+  return TMR2;
+#else
+  uint16_t Upper;
+  uint16_t Lower;
+  bool     Pending;
+
+  for ( ; ; )
+  {
+    Upper = Rollovers;
+    Pending = IFS0bits.T3IF;
+    Lower = TMR3;
+    // a rollover or the ISR in the middle of the reads, go again
+    if ((Pending == IFS0bits.T3IF) && (Upper == Rollovers))
+    {
+      break;
+    }
+  }
+  if (Pending)
+  {
+    Upper++;  // TMR3 has rolled over, the ISR just hasn't counted it
+  }
+  return ((uint32_t)Upper << 16) | Lower;
+#endif
+}
+
+/****************************************************************************
+ Function
+     CaptureTimebase_Extend
+
+ Parameters
+     CaptureRaw_t Captured - an ICxBUF value from a channel on the time
+                             base
+
+ Returns
+     uint32_t, the 32 bit time of the capture
+
+ Description
+     Call as the capture comes out of the FIFO, it has to be less than one
+     Timer3 period old
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint32_t CaptureTimebase_Extend(CaptureRaw_t Captured)
+{
+#ifdef CAPTURE_TIMEBASE_32BIT
+  return Captured;
+#else
+  uint32_t Now = CaptureTimebase_GetTime();
+
+  return Now - (uint16_t)((uint16_t)Now - Captured);
+#endif
+}
+
+/****************************************************************************
+ Function
+     Timer3ISR
+
+ Description
+     Counts a Timer3 rollover
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+#ifndef CAPTURE_TIMEBASE_32BIT
+void __ISR(_TIMER_3_VECTOR, IPL7SOFT) Timer3ISR(void)
+{
+  // TMR3 has counted up from 0 since the rollover
+  ES_IsrStats_Enter(ES_ISR(Timer3Rollover), CAPTURE_TIMEBASE_TO_CORE(TMR3));
+  IFS0CLR = _IFS0_T3IF_MASK;
+  Rollovers++;
+  ES_IsrStats_Exit(ES_ISR(Timer3Rollover));
+}
+#endif
@@ -0,0 +1,229 @@
+/****************************************************************************
+ Module
+   CommandFrame.c
+
+ Revision
+   0.1
+
+ Description
+   The parser for the framed command protocol, see CommandFrame.h.
+
+ Notes
+   The opcodes are looked up in a 256 entry table made from
+   COMMAND_FRAME_TABLE, each holding its argument bytes + 1 so that 0 is
+   an opcode that isn't in it, & the CRC is carried on a byte at a time,
+   so no byte costs more than another.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "CommandFrame.h"
+#include "CommonDefinitions.h"
+#include "SpeedControlService.h"
+#include "Crc.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+typedef enum
+{
+  FRAME_HUNT = 0,   // for the sync
+  FRAME_OPCODE,
+  FRAME_ARGS,
+  FRAME_CRC
+} FrameState_t;
+
+#define FRAME_CHECK_ROW(Name, Opcode, ArgBytes)                             \
+  typedef char Name##FrameFits[(((ArgBytes) <= COMMAND_FRAME_MAX_ARGS) &&   \
+      ((Opcode) != COMMAND_FRAME_SYNC)) ? 1 : -1];
+COMMAND_FRAME_TABLE(FRAME_CHECK_ROW)
+
+/*---------------------------- Module Functions ---------------------------*/
+#define FRAME_DECODE_PROTO(Name, Opcode, ArgBytes)                          \
+  static bool Decode##Name(const uint8_t *pArgs, CommandRequest_t *pRequest);
+COMMAND_FRAME_TABLE(FRAME_DECODE_PROTO)
+static bool Decode(uint8_t Opcode, const uint8_t *pArgs,
+                   CommandRequest_t *pRequest);
+static uint16_t Get16(const uint8_t *pSource);
+
+/*---------------------------- Module Variables ---------------------------*/
+#define FRAME_LENGTH_ROW(Name, Opcode, ArgBytes) [Opcode] = (ArgBytes) + 1,
+static const uint8_t ArgBytesPlus1[256] = {
+  COMMAND_FRAME_TABLE(FRAME_LENGTH_ROW)
+};
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     CommandFrame_InitParser
+
+ Parameters
+     CommandFrameParser_t *pParser - the parser to start
+
+ Returns
+     None
+
+ Description
+     Starts the parser looking for a sync, with no bad frames
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void CommandFrame_InitParser(CommandFrameParser_t *pParser)
+{
+  pParser->State = FRAME_HUNT;
+  pParser->BadFrames = 0;
+}
+
+/****************************************************************************
+ Function
+     CommandFrame_Parse
+
+ Parameters
+     CommandFrameParser_t *pParser - the parser to feed
+     uint8_t Byte - the next byte from the link
+     CommandRequest_t *pRequest - filled in when a frame is complete
+
+ Returns
+     bool, true if Byte completed a good frame & *pRequest holds it
+
+ Description
+     Moves the parser on by one byte
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool CommandFrame_Parse(CommandFrameParser_t *pParser, uint8_t Byte,
+                        CommandRequest_t *pRequest)
+{
+  switch (pParser->State)
+  {
+    case FRAME_HUNT:
+      if (Byte == COMMAND_FRAME_SYNC)
+      {
+        pParser->State = FRAME_OPCODE;
+      }
+      break;
+
+    case FRAME_OPCODE:
+      if (ArgBytesPlus1[Byte] == 0)
+      {
+        // a sync that was really an argument of something else, or noise.
+        // A sync now could still start the frame
+        if (Byte != COMMAND_FRAME_SYNC)
+        {
+          pParser->BadFrames++;
+          pParser->State = FRAME_HUNT;
+        }
+        break;
+      }
+      pParser->Opcode = Byte;
+      pParser->ArgBytes = ArgBytesPlus1[Byte] - 1;
+      pParser->NumArgs = 0;
+      pParser->Crc = Crc_Crc8(CRC8_INITIAL, &Byte, 1);
+      pParser->State = (pParser->ArgBytes != 0) ? FRAME_ARGS : FRAME_CRC;
+      break;
+
+    case FRAME_ARGS:
+      pParser->Args[pParser->NumArgs++] = Byte;
+      pParser->Crc = Crc_Crc8(pParser->Crc, &Byte, 1);
+      if (pParser->NumArgs == pParser->ArgBytes)
+      {
+        pParser->State = FRAME_CRC;
+      }
+      break;
+
+    case FRAME_CRC:
+      pParser->State = FRAME_HUNT;
+      if ((Byte == pParser->Crc) &&
+          Decode(pParser->Opcode, pParser->Args, pRequest))
+      {
+        return true;
+      }
+      pParser->BadFrames++;
+      break;
+
+    default:
+      pParser->State = FRAME_HUNT;
+      break;
+  }
+  return false;
+}
+
+/****************************************************************************
+ Function
+     CommandFrame_BytesToGo
+
+ Parameters
+     const CommandFrameParser_t *pParser - the parser to ask
+
+ Returns
+     uint8_t, the fewest bytes that could finish the frame it is part way
+     through, 0 if it is between frames
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint8_t CommandFrame_BytesToGo(const CommandFrameParser_t *pParser)
+{
+  switch (pParser->State)
+  {
+    case FRAME_OPCODE:
+      return 2;   // an opcode with no arguments & the CRC
+    case FRAME_ARGS:
+      return (uint8_t)(pParser->ArgBytes - pParser->NumArgs + 1);
+    case FRAME_CRC:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+// the opcode's decoder, false if the arguments don't make a command
+static bool Decode(uint8_t Opcode, const uint8_t *pArgs,
+                   CommandRequest_t *pRequest)
+{
+  switch (Opcode)
+  {
+#define FRAME_DECODE_CASE(Name, Opcode, ArgBytes)                           \
+    case Opcode:                                                            \
+      return Decode##Name(pArgs, pRequest);
+    COMMAND_FRAME_TABLE(FRAME_DECODE_CASE)
+#undef FRAME_DECODE_CASE
+
+    default:
+      return false;
+  }
+}
+
+static bool DecodeCommand(const uint8_t *pArgs, CommandRequest_t *pRequest)
+{
+  pRequest->Command = pArgs[0];
+  pRequest->SpeedQ8 = 0;
+  pRequest->Distance = 0;
+  return COMMAND_IS_VALID(pRequest->Command);
+}
+
+static bool DecodeCommandArgs(const uint8_t *pArgs, CommandRequest_t *pRequest)
+{
+  pRequest->Command = pArgs[0];
+  pRequest->SpeedQ8 = Get16(&pArgs[1]);
+  pRequest->Distance = Get16(&pArgs[3]);
+  // the speed loop needs the room above SPEED_FULL_RPM to regulate
+  return COMMAND_IS_VALID(pRequest->Command) &&
+      (((uint32_t)pRequest->SpeedQ8 << (FP_Q16_SHIFT - 8)) <= SPEED_FULL_RPM);
+}
+
+static uint16_t Get16(const uint8_t *pSource)
+{
+  return (uint16_t)(pSource[0] | ((uint16_t)pSource[1] << 8));
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,240 @@
+/****************************************************************************
+ Module
+   CommandPipeline.c
+
+ Revision
+   0.1
+
+ Description
+   Ring of retrieved commands, filled by CommandRetrieveService & emptied
+   by the MainLogicFSM sequencer.
+
+ Notes
+   The indices run free in 8 bits & are masked on use, so full and empty
+   are told apart without giving up a slot. Only Put writes In and only
+   Take & Discard write Out, and each writes its slot before moving its
+   index.
+
+   A command that arrives with the ring full is dropped & counted. The
+   reader only falls that far behind if it is stuck on a move.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Added CommandPipeline_Peek & CommandPipeline_Discard
+ 10/14/26       Tianyu  Entries are CommandRequest_t, CommandPipeline_PutRequest
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "CommandPipeline.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define PIPELINE_MASK (COMMAND_PIPELINE_DEPTH - 1)
+
+#if (COMMAND_PIPELINE_DEPTH & PIPELINE_MASK) != 0
+#error "COMMAND_PIPELINE_DEPTH must be a power of 2"
+#endif
+
+/*---------------------------- Module Variables ---------------------------*/
+static CommandRequest_t Commands[COMMAND_PIPELINE_DEPTH];
+static volatile uint8_t In;
+static volatile uint8_t Out;
+static volatile uint16_t Dropped;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     CommandPipeline_Init
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Empties the ring. Call before the SPI interrupt is enabled
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void CommandPipeline_Init(void)
+{
+  In = 0;
+  Out = 0;
+  Dropped = 0;
+}
+
+/****************************************************************************
+ Function
+     CommandPipeline_Put
+
+ Parameters
+     uint8_t Command - a validated command byte
+
+ Returns
+     bool, false if the ring was full & the command was dropped
+
+ Description
+     Adds a command with no arguments at the end of the ring
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool CommandPipeline_Put(uint8_t Command)
+{
+  CommandRequest_t Request;
+
+  Request.Command = Command;
+  Request.SpeedQ8 = 0;
+  Request.Distance = 0;
+  return CommandPipeline_PutRequest(&Request);
+}
+
+/****************************************************************************
+ Function
+     CommandPipeline_PutRequest
+
+ Parameters
+     const CommandRequest_t *pRequest - a validated command & its arguments
+
+ Returns
+     bool, false if the ring was full & the command was dropped
+
+ Description
+     Adds a command at the end of the ring
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool CommandPipeline_PutRequest(const CommandRequest_t *pRequest)
+{
+  uint8_t NextIn = In;
+
+  if ((uint8_t)(NextIn - Out) >= COMMAND_PIPELINE_DEPTH)
+  {
+    Dropped++;
+    return false;
+  }
+  Commands[NextIn & PIPELINE_MASK] = *pRequest;
+  In = (uint8_t)(NextIn + 1);
+  return true;
+}
+
+/****************************************************************************
+ Function
+     CommandPipeline_Take
+
+ Parameters
+     CommandRequest_t *pRequest - where to put the oldest command
+
+ Returns
+     bool, false if the ring was empty
+
+ Description
+     Removes the oldest command from the ring
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool CommandPipeline_Take(CommandRequest_t *pRequest)
+{
+  uint8_t NextOut = Out;
+
+  if (NextOut == In)
+  {
+    return false;
+  }
+  *pRequest = Commands[NextOut & PIPELINE_MASK];
+  Out = (uint8_t)(NextOut + 1);
+  return true;
+}
+
+/****************************************************************************
+ Function
+     CommandPipeline_Peek
+
+ Parameters
+     uint8_t Index - 0 for the oldest command
+     CommandRequest_t *pRequest - where to put the command
+
+ Returns
+     bool, false if fewer than Index + 1 commands are waiting
+
+ Description
+     Copies a waiting command without taking it out of the ring
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool CommandPipeline_Peek(uint8_t Index, CommandRequest_t *pRequest)
+{
+  uint8_t NextOut = Out;
+
+  if (Index >= (uint8_t)(In - NextOut))
+  {
+    return false;
+  }
+  *pRequest = Commands[(uint8_t)(NextOut + Index) & PIPELINE_MASK];
+  return true;
+}
+
+/****************************************************************************
+ Function
+     CommandPipeline_Discard
+
+ Parameters
+     uint8_t Count - commands to throw away, all of them if fewer wait
+
+ Returns
+     None
+
+ Description
+     Removes the oldest Count commands from the ring without running them
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void CommandPipeline_Discard(uint8_t Count)
+{
+  uint8_t NextOut = Out;
+  uint8_t Waiting = (uint8_t)(In - NextOut);
+
+  Out = (uint8_t)(NextOut + ((Count < Waiting) ? Count : Waiting));
+}
+
+/****************************************************************************
+ Function
+     CommandPipeline_Count
+
+ Parameters
+     None
+
+ Returns
+     uint8_t, commands waiting
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint8_t CommandPipeline_Count(void)
+{
+  return (uint8_t)(In - Out);
+}
+
+/****************************************************************************
+ Function
+     CommandPipeline_GetDropped
+
+ Parameters
+     None
+
+ Returns
+     uint16_t, commands dropped because the ring was full
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint16_t CommandPipeline_GetDropped(void)
+{
+  return Dropped;
+}
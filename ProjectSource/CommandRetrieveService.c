@@ -17,11 +17,56 @@
      - Subsequent queries return the same command byte until a new command arrives.
 
    This service should post ES_COMMAND_RETRIEVED(commandByte) to MainLogicService
-   when a valid command byte is received after a 0xFF flag.
+   when a valid command byte is received after a 0xFF flag. The command
+   itself is put in CommandPipeline first, MainLogicFSM runs them from
+   there in order.
+
+   The command generator is one of the devices on SPIBusService. Its poll
+   is a burst of COMMAND_QUERY_BURST query bytes & the replies come back
+   here as ES_SPI_TRANSFER_DONE to run through the 0xFF/command framing. If a 0xFF
+   was the last reply in the burst, one more query is queued right away,
+   so a new command is posted one SPI transaction after the flag rather
+   than one poll interval later. Only validated commands are posted to
+   MainLogicFSM.
+
+   With USE_FRAMED_COMMANDS (ES_Configure.h) the replies are run through
+   the CommandFrame parser instead, a byte at a time, & a frame that is
+   part way through at the end of a burst gets a follow-up for the bytes
+   it still needs. A frame can carry the command's speed & distance, & a
+   frame with a bad CRC never gets to the pipeline.
+
+   The poll interval adapts. It doubles, up to COMMAND_POLL_MAX_TICKS,
+   each time a poll only gets the byte the generator was already sending,
+   & drops back to COMMAND_POLL_MIN_TICKS when anything else comes back
+   (most often a 0xFF) or when MainLogicFSM calls CommandRetrieve_PollFast
+   because a move is about to end or has ended. Commands tend to come in
+   runs, so the fast polls are where they are wanted & an idle generator
+   costs a few transactions a second.
 
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       Tianyu  Added CommandRetrieve_Inject for the HIL harness
+ 10/14/26       Tianyu  USE_FRAMED_COMMANDS runs the replies through the
+                        CommandFrame parser. The LastCommand duplicate
+                        filter is gone, it only dropped real repeats, the
+                        0xFF flag already stops a byte being read twice
+ 10/14/26       Tianyu  The polls are set up from ES_INIT, not the init,
+                        with the first one queued at once, & the init no
+                        longer turns the interrupts on
+ 10/14/26       Tianyu  The poll interval backs off while the generator
+                        repeats itself, CommandRetrieve_PollFast, only a
+                        change of byte is logged
+ 10/14/26       Tianyu  The queries are SPIBusService transactions, so
+                        the SPI set up, SPI1Handler & COMMAND_SPI_USE_ISR
+                        are gone, the replies come as ES_SPI_TRANSFER_DONE
+ 10/14/26       Tianyu  The per poll print is LOG_DEBUG
+ 10/14/26       Tianyu  SPI1Handler reports to ES_IsrStats
+ 10/14/26       Tianyu  Command validation is a CommandTable lookup
+ 10/14/26       Tianyu  New commands go into CommandPipeline, the event is
+                        only posted once the command is queued
+ 10/14/26       Tianyu  Interrupt driven retrieval (COMMAND_SPI_USE_ISR) with
+                        the framing shared through ProcessCommandByte
  02/03/26       Tianyu  Initial creation for Lab 8 command retrieval
 ****************************************************************************/
 
@@ -31,38 +76,69 @@
 #include "ES_Timers.h"
 #include "CommandRetrieveService.h"
 #include "CommonDefinitions.h"
-#include "PIC32_SPI_HAL.h"
+#include "SPIBusService.h"
 #include "MainLogicFSM.h"
-#include "dbprintf.h"
-#include <xc.h>
-#include <sys/attribs.h>
+#include "CommandPipeline.h"
+#include "ES_Log.h"
+#include "binlog.h"
+#include "CommandFrame.h"
 
 
 /*----------------------------- Module Defines ----------------------------*/
-#define SPI_POLL_INTERVAL_MS 2000
-SPI_Module_t Module = SPI_SPI1;
+// SPI_BUS_TICK_MS ticks between polls, from the fastest to the slowest
+#define COMMAND_POLL_MIN_TICKS 1
+#define COMMAND_POLL_MAX_TICKS 16
+// query bytes in each poll, all sent with the chip select low. If the
+// command generator needs to see SS rise between bytes, set this to 1,
+// the query that follows a 0xFF is still queued at once
+#define COMMAND_QUERY_BURST 2
+
+#define QUERY_BYTE 0xAA
+#define NEW_COMMAND_FLAG 0xFF
+
+// the most bytes a follow-up asks for, the rest of a frame or the command
+#ifdef USE_FRAMED_COMMANDS
+#define COMMAND_FOLLOW_UP_MAX COMMAND_FRAME_MAX_BYTES
+#else
+#define COMMAND_FOLLOW_UP_MAX 1
+#endif
+#define COMMAND_QUERY_MAX ((COMMAND_QUERY_BURST > COMMAND_FOLLOW_UP_MAX) ? \
+    COMMAND_QUERY_BURST : COMMAND_FOLLOW_UP_MAX)
+
+// the Tags of our two transactions
+#define COMMAND_POLL_TAG 0
+#define COMMAND_FOLLOW_UP_TAG 1
 
 /*---------------------------- Module Functions ---------------------------*/
-static uint8_t ReadSPICommandByte(void);
+#ifdef USE_FRAMED_COMMANDS
+static uint8_t ProcessFrameByte(uint8_t frameByte);
+#else
 static bool IsValidCommandByte(uint8_t commandByte);
+static uint8_t ProcessCommandByte(uint8_t commandByte);
+#endif
+static void PutCommand(const CommandRequest_t *pRequest);
+static void SetPollTicks(uint8_t Ticks);
 
 /*---------------------------- Module Variables ---------------------------*/
 static uint8_t MyPriority;
+#ifdef USE_FRAMED_COMMANDS
+static CommandFrameParser_t Parser;
+#else
 static bool SawNewCommandFlag;
-static uint8_t LastCommand;
+#endif
 
-uint8_t QueryCommandGenerator(void);
+static uint8_t Queries[COMMAND_QUERY_MAX];
+// filled by SPIBusService, each is only read after its done event
+static uint8_t PollReplies[COMMAND_QUERY_BURST];
+static uint8_t FollowUpReplies[COMMAND_FOLLOW_UP_MAX];
+static uint8_t FollowUpLength;
+
+static SPIBus_Transaction_t PollQuery;
+static uint8_t PollTicks;
+// the last reply, a poll that only gets this again backs off
+static uint8_t LastReply;
 
 /*------------------------------ Module Code ------------------------------*/
-/*
-void __ISR(_SPI_1_VECTOR, IPL4SOFT) SPI1Handler(void){
-    uint8_t data = 0x0;
-    data = (uint8_t) SPIOperate_ReadData(Module);
-    IEC1CLR = _IEC1_SPI1RXIE_MASK | _IEC1_SPI1TXIE_MASK | _IEC1_SPI1EIE_MASK; 
-    
-    CurrentCommand = data;
-}
- * */
 /****************************************************************************
  Function
      InitCommandRetrieveService
@@ -74,7 +150,8 @@ void __ISR(_SPI_1_VECTOR, IPL4SOFT) SPI1Handler(void){
      bool, false if error in initialization, true otherwise
 
  Description
-     Initializes the SPI command retrieval service.
+     Initializes the SPI command retrieval service & the command
+     generator's poll, which goes to SPIBusService on ES_INIT.
 
  Author
      Tianyu, 02/03/26
@@ -82,64 +159,29 @@ void __ISR(_SPI_1_VECTOR, IPL4SOFT) SPI1Handler(void){
 bool InitCommandRetrieveService(uint8_t Priority)
 {
   ES_Event_t ThisEvent;
+  uint8_t i;
 
   MyPriority = Priority;
+#ifdef USE_FRAMED_COMMANDS
+  CommandFrame_InitParser(&Parser);
+#else
   SawNewCommandFlag = false;
+#endif
+  LastReply = 0;
+  FollowUpLength = 0;
+  CommandPipeline_Init();
 
-  /********************************************
-   Initialization code for SPI command retrieval
-   *******************************************/
-  // TODO: Configure SPI32 as leader (mode, clock, chip select)
-  // TODO: Initialize Ports/SPI pins via Ports.c if needed
-    
-    SPI_SamplePhase_t SamplePhase = SPI_SMP_MID;
-    uint32_t DesiredClock_ns = 10000;
-    SPI_Clock_t ClockIdle = SPI_CLK_HI;
-    SPI_ActiveEdge_t ChosenEdge = SPI_FIRST_EDGE;
-    SPI_XferWidth_t DataWidth = SPI_8BIT;
-    
-   
-    SPI_PinMap_t SSPin = SPI_RPA0; // Chip Select Pin
-    SPI_PinMap_t SDOPin = SPI_RPA1; // Chip Output Pin
-    SPI_PinMap_t SDIPin = SPI_RPB8; // Chip Input Pin
-
-    
-    TRISAbits.TRISA0 = 0;
-    TRISAbits.TRISA1 = 0;
-    
-    ANSELAbits.ANSA0 = 0;
-    ANSELAbits.ANSA1 = 0;
-    
-    SPI1CONbits.SRXISEL = 0b01;
-    
-    SPISetup_BasicConfig(Module);
-    SPISetup_SetLeader(Module, SamplePhase);
-    SPISetup_SetBitTime(Module, DesiredClock_ns);
-    SPISetup_MapSSOutput(Module, SSPin);
-    SPISetup_MapSDOutput(Module, SDOPin);
-    //SPISetup_MapSDInput(Module, SDIPin);
-    SDI1R = 0b0100;
-    TRISBbits.TRISB8 = 1;
-  
-    SPISetup_SetClockIdleState(Module, ClockIdle);
-    SPISetup_SetActiveEdge(Module, ChosenEdge);
-    SPISetup_SetXferWidth(Module, DataWidth);
-    SPISetEnhancedBuffer(Module, true);
-    
-    SPISetup_EnableSPI(Module);
-    /* Set up interrupt */
-    /*
-    INTCONbits.MVEC = 1;
-    IPC7bits.SPI1IP = 4;
-    IPC7bits.SPI1IS = 0;
-    
-    IFS1CLR =  _IFS1_SPI1RXIF_MASK;
-    IEC1SET = _IEC1_SPI1RXIE_MASK; 
-    */
-
-  // Start a periodic poll timer if polling is used
-  ES_Timer_InitTimer(COMMAND_SPI_TIMER, SPI_POLL_INTERVAL_MS);
-  __builtin_enable_interrupts();
+  for (i = 0; i < COMMAND_QUERY_MAX; i++)
+  {
+    Queries[i] = QUERY_BYTE;
+  }
+  PollQuery.Device = SPI_BUS_DEVICE(CommandGenerator);
+  PollQuery.pTxData = Queries;
+  PollQuery.pRxData = PollReplies;
+  PollQuery.Length = COMMAND_QUERY_BURST;
+  PollQuery.pPostDone = PostCommandRetrieveService;
+  PollQuery.Tag = COMMAND_POLL_TAG;
+  PollTicks = 0;
   // Post the initial transition event
   ThisEvent.EventType = ES_INIT;
   if (ES_PostToService(MyPriority, ThisEvent) == true)
@@ -181,7 +223,8 @@ bool PostCommandRetrieveService(ES_Event_t ThisEvent)
    ES_Event_t, ES_NO_EVENT if no error ES_ERROR otherwise
 
  Description
-   Service state machine for SPI command retrieval.
+   Runs the replies to each poll & follow-up query through the framing,
+   or the frame parser
 
  Author
      Tianyu, 02/03/26
@@ -194,57 +237,66 @@ ES_Event_t RunCommandRetrieveService(ES_Event_t ThisEvent)
   switch (ThisEvent.EventType)
   {
     case ES_INIT:
-      // No action needed beyond initialization
+      // every init is done, so SPIBusService is up. The first poll goes
+      // now rather than a poll period after startup
+      (void)SPIBus_Queue(&PollQuery);
+      SetPollTicks(COMMAND_POLL_MIN_TICKS);
       break;
 
-    case ES_TIMEOUT:
+    case ES_SPI_TRANSFER_DONE:
     {
-      if (ThisEvent.EventParam != COMMAND_SPI_TIMER)
+      const uint8_t *pReplies = PollReplies;
+      uint8_t NumReplies = COMMAND_QUERY_BURST;
+      uint8_t i;
+      uint8_t FollowUpBytes = 0;
+      bool IsNews = false;
+
+      if (ThisEvent.EventParam == COMMAND_FOLLOW_UP_TAG)
       {
-        break;
+        pReplies = FollowUpReplies;
+        NumReplies = FollowUpLength;
       }
-      // Pseudocode: poll SPI follower for command bytes
-      // Read byte from SPI (leader initiates query)
-      // IF byte == 0xFF
-      //     SawNewCommandFlag = true
-      // ELSE IF SawNewCommandFlag == true
-      //     IF byte is valid command
-      //         Post ES_COMMAND_RETRIEVED(commandByte) to MainLogicService
-      //     ELSE
-      //         Ignore or log invalid command
-      //     SawNewCommandFlag = false
-      // ELSE
-      //     Ignore (repeated old command value)
-
-        
-        uint8_t commandByte = (uint8_t) QueryCommandGenerator();
-        DB_printf("Received Command byte: 0x%x\r\n", commandByte);
-        if (commandByte == 0xFF)
-        {
-          SawNewCommandFlag = true;
-        }
-        else if (SawNewCommandFlag == true)
+      for (i = 0; i < NumReplies; i++)
+      {
+        if (pReplies[i] != LastReply)
         {
-          if (IsValidCommandByte(commandByte))
-          {
-            ES_Event_t CommandEvent;
-            if(commandByte != LastCommand) {
-                CommandEvent.EventType = ES_COMMAND_RETRIEVED;
-                CommandEvent.EventParam = commandByte;
-                PostMainLogicFSM(CommandEvent);
-                LastCommand = commandByte;
-            }
-            
-          }
-          else
-          {
-            DB_printf("Invalid command byte: 0x%x\r\n", commandByte);
-          }
-          SawNewCommandFlag = false;
-          LastCommand = 0xFF;
+          LOG_DEBUG("Received Command byte: 0x%x\r\n", pReplies[i]);
+          LastReply = pReplies[i];
+          IsNews = true;
         }
-
-      ES_Timer_InitTimer(COMMAND_SPI_TIMER, SPI_POLL_INTERVAL_MS);
+#ifdef USE_FRAMED_COMMANDS
+        FollowUpBytes = ProcessFrameByte(pReplies[i]);
+#else
+        FollowUpBytes = ProcessCommandByte(pReplies[i]);
+#endif
+      }
+      // fast while things are happening, slower the longer they aren't
+      if (IsNews)
+      {
+        SetPollTicks(COMMAND_POLL_MIN_TICKS);
+      }
+      else if ((ThisEvent.EventParam == COMMAND_POLL_TAG) &&
+          (PollTicks < COMMAND_POLL_MAX_TICKS))
+      {
+        SetPollTicks((2 * PollTicks < COMMAND_POLL_MAX_TICKS) ?
+            2 * PollTicks : COMMAND_POLL_MAX_TICKS);
+      }
+      // the replies to the next queries finish the command, don't wait a
+      // poll for them
+      if (FollowUpBytes != 0)
+      {
+        SPIBus_Transaction_t FollowUp;
+
+        FollowUpLength = (FollowUpBytes < COMMAND_FOLLOW_UP_MAX) ?
+            FollowUpBytes : COMMAND_FOLLOW_UP_MAX;
+        FollowUp.Device = SPI_BUS_DEVICE(CommandGenerator);
+        FollowUp.pTxData = Queries;
+        FollowUp.pRxData = FollowUpReplies;
+        FollowUp.Length = FollowUpLength;
+        FollowUp.pPostDone = PostCommandRetrieveService;
+        FollowUp.Tag = COMMAND_FOLLOW_UP_TAG;
+        SPIBus_Queue(&FollowUp);
+      }
       break;
     }
     default:
@@ -254,36 +306,177 @@ ES_Event_t RunCommandRetrieveService(ES_Event_t ThisEvent)
   return ReturnEvent;
 }
 
+/****************************************************************************
+ Function
+     CommandRetrieve_PollFast
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Goes back to the fastest poll, for when the next command is wanted
+     soon. It slows down again if the generator has nothing new to say
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void CommandRetrieve_PollFast(void)
+{
+  SetPollTicks(COMMAND_POLL_MIN_TICKS);
+}
+
+/****************************************************************************
+ Function
+     CommandRetrieve_Inject
+
+ Parameters
+     uint8_t Reply - a byte as the command generator would send it
+
+ Returns
+     None
+
+ Description
+     Runs the byte through the framing or frame parser as though it were
+     the reply to a poll. No follow-up is queued for it, the next
+     injected byte is the follow-up
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void CommandRetrieve_Inject(uint8_t Reply)
+{
+#ifdef USE_FRAMED_COMMANDS
+  (void)ProcessFrameByte(Reply);
+#else
+  (void)ProcessCommandByte(Reply);
+#endif
+}
+
 /*----------------------------- Module Helpers ----------------------------*/
 /****************************************************************************
  Function
-     ReadSPICommandByte
+     SetPollTicks
 
  Parameters
+     uint8_t Ticks - SPI_BUS_TICK_MS ticks between polls
+
+ Returns
      None
 
+ Description
+     Changes the poll interval, the next poll comes Ticks from now. Leaves
+     the poll alone if it is already at that rate, so that repeated calls
+     don't keep putting it off
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static void SetPollTicks(uint8_t Ticks)
+{
+  if (Ticks != PollTicks)
+  {
+    PollTicks = Ticks;
+    SPIBus_SetPoll(&PollQuery, PollTicks);
+  }
+}
+
+#ifdef USE_FRAMED_COMMANDS
+/****************************************************************************
+ Function
+     ProcessFrameByte
+
+ Parameters
+     uint8_t frameByte, the response to one query
+
  Returns
-     uint8_t command byte read from SPI
+     uint8_t, the bytes still needed to finish the frame it is part of, 0
+     between frames
 
  Description
-     Reads a byte from the SPI follower.
+     Feeds the byte to the frame parser & puts the command of a frame that
+     it completes in CommandPipeline
 
  Author
-     Tianyu, 02/03/26
+     Tianyu, 10/14/26
 ****************************************************************************/
-uint8_t QueryCommandGenerator(void)
+static uint8_t ProcessFrameByte(uint8_t frameByte)
 {
-  // TODO: Implement SPI read (leader initiates query)
-  // Pseudocode:
-  //   Assert chip select
-  //   Transfer dummy byte and read response
-  //   Deassert chip select
-  //   Return response byte
-    if(!SPI1STATbits.SPITBF) {
-        SPIOperate_SPI1_Send8Wait(0xAA);
+  CommandRequest_t Request;
+  uint16_t         BadFrames = Parser.BadFrames;
+
+  if (CommandFrame_Parse(&Parser, frameByte, &Request))
+  {
+    PutCommand(&Request);
+  }
+  else if (Parser.BadFrames != BadFrames)
+  {
+    BINLOG1("Bad command frame, %u so far\r\n", Parser.BadFrames);
+  }
+  return CommandFrame_BytesToGo(&Parser);
+}
+
+#else
+/****************************************************************************
+ Function
+     ProcessCommandByte
+
+ Parameters
+     uint8_t commandByte, the response to one query
+
+ Returns
+     uint8_t, 1 if the next response should be the new command, else 0
+
+ Description
+     Runs the 0xFF/new command framing and posts ES_COMMAND_RETRIEVED to
+     MainLogicFSM for a valid command that follows the flag. The same
+     command twice is two commands, each came after a flag of its own.
+     Pseudocode:
+       IF byte == 0xFF
+           SawNewCommandFlag = true
+       ELSE IF SawNewCommandFlag == true
+           IF byte is valid command
+               Put commandByte in CommandPipeline
+               Post ES_COMMAND_RETRIEVED(commandByte) to MainLogicService
+           ELSE IF byte isn't valid
+               Ignore or log invalid command
+           SawNewCommandFlag = false
+       ELSE
+           Ignore (repeated old command value)
+
+ Notes
+     the logging goes through the binary log, it used to run in the SPI ISR
+     & a full pipeline or a bad byte is no reason to hold up the run loop
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static uint8_t ProcessCommandByte(uint8_t commandByte)
+{
+  if (commandByte == NEW_COMMAND_FLAG)
+  {
+    SawNewCommandFlag = true;
+  }
+  else if (SawNewCommandFlag == true)
+  {
+    if (IsValidCommandByte(commandByte))
+    {
+      CommandRequest_t Request;
+
+      Request.Command = commandByte;
+      Request.SpeedQ8 = 0;
+      Request.Distance = 0;
+      PutCommand(&Request);
     }
-    uint8_t data = (uint8_t) SPIOperate_ReadData(Module);
-    return data;
+    else
+    {
+      BINLOG1("Invalid command byte: 0x%x\r\n", commandByte);
+    }
+    SawNewCommandFlag = false;
+  }
+  return SawNewCommandFlag ? 1 : 0;
 }
 
 /****************************************************************************
@@ -297,21 +490,46 @@ uint8_t QueryCommandGenerator(void)
      bool, true if the command byte is valid
 
  Description
-     Validates a command byte against the lookup table.
+     Validates a command byte against the CommandTable, one indexed load.
 
  Author
      Tianyu, 02/03/26
 ****************************************************************************/
 static bool IsValidCommandByte(uint8_t commandByte)
 {
-  // TODO: Implement command validation using CommonDefinitions lookup table
-    bool returnVal = false;
-    uint8_t index = 0;
-    
-    for(index; index < sizeof(validCommandBytes)/sizeof(validCommandBytes[0]); index++) {
-        if(commandByte == validCommandBytes[index]) {
-            returnVal = true;
-        }
-    }
-    return returnVal;
+    return COMMAND_IS_VALID(commandByte);
+}
+#endif /* USE_FRAMED_COMMANDS */
+
+/****************************************************************************
+ Function
+     PutCommand
+
+ Parameters
+     const CommandRequest_t *pRequest - a validated command
+
+ Returns
+     None
+
+ Description
+     Puts the command in CommandPipeline & posts ES_COMMAND_RETRIEVED, with
+     the command byte, to MainLogicFSM
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static void PutCommand(const CommandRequest_t *pRequest)
+{
+  ES_Event_t CommandEvent;
+
+  if (CommandPipeline_PutRequest(pRequest))
+  {
+    CommandEvent.EventType = ES_COMMAND_RETRIEVED;
+    CommandEvent.EventParam = pRequest->Command;
+    PostMainLogicFSM(CommandEvent);
+  }
+  else
+  {
+    BINLOG1("Command pipeline full, dropped 0x%x\r\n", pRequest->Command);
+  }
 }
@@ -13,7 +13,8 @@
    These functions provide consistent conversion between ADC values,
    encoder periods, and RPM measurements across all services.
 
-   LookUpTable for Commands
+   LookUpTable for Commands (CommandTable, built from COMMAND_LIST in
+   CommonDefinitions.h)
    Command Byte Description of action
    0x00 Stop, hold Position, do not move or rotate
    0x02 Rotate Clockwise by 90 degrees (allows 6 sec. to complete)
@@ -42,16 +43,20 @@
    Timer Durations (ms)
    SIMPLE_MOVE_90_MS = 6000
    SIMPLE_MOVE_45_MS = 3000
-   BEACON_ALIGN_MS = 5000
+   BEACON_ALIGN_MS = 15000
    TAPE_SEARCH_MS = 5000
 
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       Tianyu  CommandTable replaces validCommandBytes
  01/28/26       Tianyu  Initial creation for Lab 7
 ****************************************************************************/
 /*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
 #include "CommonDefinitions.h"
+#include "SpeedControlService.h"
 
 /*---------------------------- Module Variables ---------------------------*/
 
@@ -67,19 +72,13 @@ const uint8_t PrescaleLookup[] = {
   0b111  // 1:256 prescale
 };
 
-// Lookup table for Commands
-const uint8_t validCommandBytes[11] = {
-  0x00, // Stop
-  0x02, // Rotate Clockwise 90 degrees
-  0x03, // Rotate Clockwise 45 degrees
-  0x04, // Rotate Counter-clockwise 90 degrees
-  0x05, // Rotate Counter-clockwise 45 degrees
-  0x08, // Drive forward half speed
-  0x09, // Drive forward full speed
-  0x10, // Drive in reverse half speed
-  0x11, // Drive in reverse full speed
-  0x20, // Align with beacon
-  0x40  // Drive forward until tape detected
+// Lookup table for Commands, indexed by the command byte. Entries not in
+// COMMAND_LIST are left 0, CMD_ACTION_INVALID
+#define COMMAND_ENTRY(Name, Byte, Action, Speed, Left, Right, Distance, \
+    BackstopMs) [Byte] = { Action, Left, Right, Speed, Distance, BackstopMs },
+
+const CommandDesc_t CommandTable[256] = {
+  COMMAND_LIST(COMMAND_ENTRY)
 };
 
 /*------------------------------ Module Code ------------------------------*/
@@ -0,0 +1,93 @@
+/****************************************************************************
+ Module
+   Crc.c
+
+ Revision
+   0.1
+
+ Description
+   The CRCs shared by the telemetry frames, the parameter store & the
+   command frames, see Crc.h.
+
+ Notes
+   Bit at a time. Everything that is checked is under 100 bytes, so a table
+   isn't worth the flash.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Added Crc_Crc8
+ 10/14/26       Tianyu  Initial creation, from TelemetryService's Crc16
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "Crc.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define CRC16_POLY 0x1021
+#define CRC8_POLY 0x07
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     Crc_Ccitt16
+
+ Parameters
+     uint16_t Crc - CRC16_INITIAL, or the CRC so far to carry it on
+     const uint8_t *pData - the bytes to add
+     uint16_t Length - how many there are
+
+ Returns
+     uint16_t, the CRC once the bytes are added
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint16_t Crc_Ccitt16(uint16_t Crc, const uint8_t *pData, uint16_t Length)
+{
+  uint8_t Bit;
+
+  while (Length-- != 0)
+  {
+    Crc ^= (uint16_t)(*pData++) << 8;
+    for (Bit = 0; Bit < 8; Bit++)
+    {
+      Crc = (Crc & 0x8000) ? (uint16_t)((Crc << 1) ^ CRC16_POLY) :
+          (uint16_t)(Crc << 1);
+    }
+  }
+  return Crc;
+}
+
+/****************************************************************************
+ Function
+     Crc_Crc8
+
+ Parameters
+     uint8_t Crc - CRC8_INITIAL, or the CRC so far to carry it on
+     const uint8_t *pData - the bytes to add
+     uint16_t Length - how many there are
+
+ Returns
+     uint8_t, the CRC once the bytes are added
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint8_t Crc_Crc8(uint8_t Crc, const uint8_t *pData, uint16_t Length)
+{
+  uint8_t Bit;
+
+  while (Length-- != 0)
+  {
+    Crc ^= *pData++;
+    for (Bit = 0; Bit < 8; Bit++)
+    {
+      Crc = (Crc & 0x80) ? (uint8_t)((Crc << 1) ^ CRC8_POLY) :
+          (uint8_t)(Crc << 1);
+    }
+  }
+  return Crc;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
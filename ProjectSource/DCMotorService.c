@@ -37,11 +37,74 @@
     Clamp duty cycle ticks to safe range
     Write new duty cycle ticks to OCxRS
 
+    Direct writes (DCMotor_SetOutputs / DCMotor_RampTo):
+    Save the new duty/direction pair for both motors and enable the Timer2
+    interrupt. At the next period boundary, the ISR writes both OCxRS
+    registers, which the OC modules load together at the boundary after
+    that. If a direction changed, the direction pins are switched at that
+    second boundary, once the new OCxR values are in, so each motor sees
+    the new duty and direction starting in the same period. Both reverse
+    pins change in the one LATBINV write, so neither wheel ever turns the
+    new way while the other is still going the old one.
+    The event path (ES_MOTOR_ACTION_CHANGE) ends up in the same place, it is
+    only kept for changes that don't need to happen right away.
+
+    Ramps:
+    Each motor's output is kept as a signed duty (negative for REVERSE) in
+    1/256ths of a tick. For DCMotor_RampTo, the Timer2 ISR moves it toward
+    the target by the slew step every PWM period and stays enabled until
+    both motors get there. A reversal ramps down through 0 and back up, so
+    the direction pin only changes at low duty. DCMotor_SetOutputs jumps
+    straight to the target.
+
+    Emergency stop:
+    DCMotor_EmergencyStop is called from the change notice ISR when the
+    stop input goes active. It writes 0 duty to OCxRS there & then, so the
+    wheels lose drive at the next PWM boundary (within 200uS) without
+    waiting on any queue, and latches the stop. While it is latched every
+    new target is dropped, so neither the control loop nor the event path
+    can drive the motors again until MainLogicFSM has stopped everything
+    and calls DCMotor_ReleaseEmergencyStop. The direction pins are left
+    where they are & the duty is written for them, so a motor in REVERSE
+    gets 0 across it too rather than full drive the other way.
+    The CN ISR is below both the control loop & the Timer2 ISR, so neither
+    can come in between the latch being set & the registers being written.
+
+    Power down:
+    PowerManager switches Timer2, OC1 & OC2 off while the robot is stopped.
+    DCMotor_PowerDown runs first, it drops anything pending, zeroes the
+    outputs & takes RB4/RB11 off the OC outputs with all four pins low, so
+    both motors coast. DCMotor_PowerUp runs once the registers are back &
+    puts the outputs (0 unless a target came in meanwhile) & the pin
+    mapping back. ConfigurePWM isn't run again, it would reset Timer3 as
+    well.
 
 
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       Tianyu  Each write of the motor registers goes to the HIL
+                        harness log, HIL_MOTOR_WRITTEN
+ 10/14/26       Tianyu  Both direction pins are committed in one LATBINV
+                        write
+ 10/14/26       Tianyu  Added DCMotor_PowerDown & DCMotor_PowerUp for the
+                        power manager
+ 10/14/26       Tianyu  The slew rate starts from the parameter store
+ 10/14/26       Tianyu  DCMotor_EmergencyStop zeroes the duty from the
+                        stop input ISR & latches until released
+ 10/14/26       Tianyu  Added DCMotor_GetOutput for the telemetry
+ 10/14/26       Tianyu  PWMCommitISR reports to ES_IsrStats
+ 10/14/26       Tianyu  Refuses to build with CAPTURE_TIMEBASE_32BIT
+ 10/14/26       Tianyu  Posts coalesce, a waiting ES_MOTOR_ACTION_CHANGE
+                        is updated instead of queueing another
+ 10/14/26       Tianyu  Timer2/OC1/OC2 set up & written through the PWM_PIC32
+                        library, Timer2 now runs at PBCLK/8
+ 10/14/26       Tianyu  Per motor duty on the event path, slew rate limited
+                        ramps from the Timer2 ISR (DCMotor_RampTo)
+ 10/14/26       Tianyu  DCMotor_SetOutputs, both motors committed together
+                        from the Timer2 period interrupt
+ 10/14/26       Tianyu  DCMotor_ApplyDuty for the speed control loop
+ 10/14/26       Tianyu  Duty cycle trace goes through the binary log
  01/21/26       Tianyu  Updated for Lab 6 motor speed control
  01/15/26       Tianyu  Fixed position wrapping logic for unsigned type
  01/14/26       Tianyu  Initial creation for Lab 5
@@ -53,7 +116,14 @@
 #include "DCMotorService.h"
 #include "CommonDefinitions.h"
 #include "dbprintf.h"
+#include "binlog.h"
+#include "PWM_PIC32.h"
+#include "CaptureTimebase.h"
+#include "ES_IsrStats.h"
+#include "ParamStore.h"
+#include "HilHarness.h"
 #include <xc.h>
+#include <sys/attribs.h>
 
 /*----------------------------- Module Defines ----------------------------*/
 
@@ -66,16 +136,58 @@
 #define MOTOR_FORWARD_PIN_R   LATBbits.LATB11
 #define MOTOR_REVERSE_PIN_R   LATBbits.LATB13
 
+// the same pins as LATB bits, for the writes that have to be one
+#define MOTOR_REVERSE_MASK_L  (1u << 5)
+#define MOTOR_REVERSE_MASK_R  (1u << 13)
+#define MOTOR_REVERSE_MASKS   (MOTOR_REVERSE_MASK_L | MOTOR_REVERSE_MASK_R)
+#define MOTOR_PIN_MASKS       ((1u << 4) | (1u << 11) | MOTOR_REVERSE_MASKS)
+
 // PWM configuration (period defined in CommonDefinitions.h)
 #define INITIAL_DUTY_TICKS 0  // Initial duty cycle in ticks
+#define LEFT_PWM_CHANNEL  1   // OC1 on RB4
+#define RIGHT_PWM_CHANNEL 2   // OC2 on RB11
+#define NUM_PWM_CHANNELS  2
+#define MOTOR_PWM_CHANNELS \
+  (PWM_CHANNEL_BIT(LEFT_PWM_CHANNEL) | PWM_CHANNEL_BIT(RIGHT_PWM_CHANNEL))
 #define ENABLE_POT_AD
 
+// Timer2 interrupt priority for the output commit. It only has to run
+// within a PWM period (200uS) of the boundary
+#define PWM_COMMIT_PRIORITY 6
+
+// OC1 & OC2 can only be clocked from Timer2 or Timer3, the 32 bit capture
+// time base takes both
+#ifdef CAPTURE_TIMEBASE_32BIT
+#error "The motor PWM needs Timer2, CAPTURE_TIMEBASE_32BIT can't be used"
+#endif
+
+// PWM periods per mS, for the slew step. The PWM library runs Timer2 at
+// PBCLK/8
+#define PWM_TIMER_PRESCALE 8
+// core timer counts per Timer2 tick
+#define PWM_TICKS_TO_CORE (CORE_TIMER_FREQ / (PBCLK_FREQ / PWM_TIMER_PRESCALE))
+#define PWM_PERIODS_PER_MS \
+  (PBCLK_FREQ / PWM_TIMER_PRESCALE / (PWM_PERIOD_TICKS + 1) / 1000)
+
+// ramp outputs are signed duty ticks in Q8
+#define RAMP_FRACTION_BITS 8
+
+typedef struct
+{
+  uint16_t DutyTicks;
+  uint8_t  Direction;
+} MotorOutput_t;
+
 /*---------------------------- Module Functions ---------------------------*/
 /* Prototypes for private functions for this service */
-static void ConfigureTimeBase(uint8_t prescale);
-static void ConfigurePWM(void);
+static bool ConfigurePWM(void);
 static void ConfigureDCMotorPins(void);
 static uint16_t MapSpeedToDutyCycle(uint16_t desiredSpeed);
+static void WriteDutyRegisters(const MotorOutput_t *pOutputs);
+static void WriteDirectionPins(const MotorOutput_t *pOutputs);
+static void SetTargets(uint16_t dutyLeft, uint16_t dutyRight,
+                       uint8_t dirLeft, uint8_t dirRight, bool immediate);
+static int32_t StepToward(int32_t current, int32_t target, int32_t step);
 
 /*---------------------------- Module Variables ---------------------------*/
 // Module level Priority variable
@@ -83,6 +195,23 @@ static uint8_t MyPriority;
 static uint16_t DesiredSpeed[2];
 static uint8_t DesiredDirection[2];
 
+// Targets waiting for the next period boundary, guarded by EnterCritical.
+// Signed Q8 duty ticks, negative is REVERSE
+static int32_t PendingTarget[2];
+static volatile bool OutputsPending = false;
+static bool PendingImmediate = false;
+// Ramp state, only used by the Timer2 ISR once running
+static int32_t TargetQ8[2];
+static int32_t CurrentQ8[2];
+// slew step per PWM period in Q8 ticks, 0 for no limit
+static int32_t SlewStepQ8;
+// Outputs that have been written to OCxRS, and whether their direction
+// pins still have to be switched at the next boundary
+static MotorOutput_t CommittedOutputs[2];
+static volatile bool PinsPending = false;
+// set by DCMotor_EmergencyStop, new targets are dropped until it is released
+static volatile bool StopLatched = false;
+
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
  Function
@@ -110,16 +239,26 @@ bool InitDCMotorService(uint8_t Priority)
   DesiredSpeed[RIGHT_MOTOR] = 0;
   DesiredDirection[LEFT_MOTOR] = FORWARD;
   DesiredDirection[RIGHT_MOTOR] = FORWARD;
+  CommittedOutputs[LEFT_MOTOR].DutyTicks = INITIAL_DUTY_TICKS;
+  CommittedOutputs[LEFT_MOTOR].Direction = FORWARD;
+  CommittedOutputs[RIGHT_MOTOR] = CommittedOutputs[LEFT_MOTOR];
+  OutputsPending = false;
+  PinsPending = false;
+  TargetQ8[LEFT_MOTOR] = TargetQ8[RIGHT_MOTOR] = 0;
+  CurrentQ8[LEFT_MOTOR] = CurrentQ8[RIGHT_MOTOR] = 0;
+  DCMotor_SetSlewRate(ParamStore_Get(PARAM_ID(SLEW)));
   
   /********************************************
    Initialization code for DC Motor Control system
    *******************************************/
   // Initialize Output Compare Pins used
-  // TODO: Expand ConfigureDCMotorPins for both motors
   ConfigureDCMotorPins();
 
   // Configure PWM module (includes timer configuration)
-  ConfigurePWM();
+  if (!ConfigurePWM())
+  {
+    return false;
+  }
 
   // Post the initial transition event
   ThisEvent.EventType = ES_INIT;
@@ -146,13 +285,15 @@ bool InitDCMotorService(uint8_t Priority)
  Description
      Posts an event to this state machine's queue
  Notes
+     Coalescing: ES_MOTOR_ACTION_CHANGE only says the desired outputs
+     changed, so if one is already waiting the new post merges into it
 
  Author
      Tianyu, 01/14/26
 ****************************************************************************/
 bool PostDCMotorService(ES_Event_t ThisEvent)
 {
-  return ES_PostToService(MyPriority, ThisEvent);
+  return ES_PostToServiceCoalesce(MyPriority, ThisEvent);
 }
 
 /****************************************************************************
@@ -184,46 +325,15 @@ ES_Event_t RunDCMotorService(ES_Event_t ThisEvent)
       
     case ES_MOTOR_ACTION_CHANGE:
     {
-      // Pseudocode:
-      // FOR each motor in Motors[]
-      //   Map desired speed to duty ticks
-      //   Clamp duty ticks to safe range
-      //   IF motor.direction == FORWARD
-      //     Set forward pin HIGH, reverse pin LOW
-      //     Write duty ticks to OCxRS
-      //   ELSE (REVERSE)
-      //     Set forward pin LOW, reverse pin HIGH
-      //     Write duty ticks to OCxRS (or inverted if hardware requires)
-      // END FOR
-
-      uint16_t dutyCycle = MapSpeedToDutyCycle(DesiredSpeed[LEFT_MOTOR]);
-
-      if (DesiredDirection[0] == 0)
-      {
-        MOTOR_REVERSE_PIN_L = 0;
-        OC1RS = dutyCycle;
-        DB_printf("dutyCycle left 0:%u\r\n", dutyCycle);
-      }
-      else
-      {
-        MOTOR_REVERSE_PIN_L = 1;
-        OC1RS = PWM_PERIOD_TICKS - dutyCycle + 1;
-        DB_printf("dutyCycle left 1:%u\r\n", OC1RS);
-      }
-
-      // Hardware motor already inversed for right motor, when forward means same current go through left and right motor
-      if (DesiredDirection[1] == 0)
-      {
-        MOTOR_REVERSE_PIN_R = 0;
-        OC2RS = dutyCycle;
-        DB_printf("dutyCycle right 0:%u\r\n", dutyCycle);
-      }
-      else
-      {
-        MOTOR_REVERSE_PIN_R = 1;
-        OC2RS = PWM_PERIOD_TICKS - dutyCycle + 1;
-        DB_printf("dutyCycle right 1:%u\r\n", OC2RS);
-      }
+      uint16_t dutyLeft = MapSpeedToDutyCycle(DesiredSpeed[LEFT_MOTOR]);
+      uint16_t dutyRight = MapSpeedToDutyCycle(DesiredSpeed[RIGHT_MOTOR]);
+
+      // Hardware motor already inversed for right motor, when forward means
+      // same current go through left and right motor
+      DCMotor_RampTo(dutyLeft, dutyRight, DesiredDirection[LEFT_MOTOR],
+          DesiredDirection[RIGHT_MOTOR]);
+      BINLOG4("dutyCycle %u %u dir %u %u\r\n", dutyLeft, dutyRight,
+          DesiredDirection[LEFT_MOTOR], DesiredDirection[RIGHT_MOTOR]);
 
       break;
     }
@@ -244,19 +354,21 @@ ES_Event_t RunDCMotorService(ES_Event_t ThisEvent)
      uint8_t dirLeft, dirRight
 
  Returns
-     None
+     bool, false if the event could not be posted
 
  Description
      Writes desired speeds/directions into module variables and posts
-     ES_MOTOR_ACTION_CHANGE events to DCMotorService.
+     ES_MOTOR_ACTION_CHANGE events to DCMotorService. Use
+     DCMotor_SetOutputs for changes that have to happen right away.
 
  Author
      Tianyu, 02/03/26
 ****************************************************************************/
-void MotorCommandWrapper(uint16_t speedLeft, uint16_t speedRight,
+bool MotorCommandWrapper(uint16_t speedLeft, uint16_t speedRight,
                          uint8_t dirLeft, uint8_t dirRight)
 {
   ES_Event_t ThisEvent;
+  bool       Posted;
 
   DesiredSpeed[LEFT_MOTOR] = speedLeft;
   DesiredSpeed[RIGHT_MOTOR] = speedRight;
@@ -265,48 +377,133 @@ void MotorCommandWrapper(uint16_t speedLeft, uint16_t speedRight,
 
   ThisEvent.EventType = ES_MOTOR_ACTION_CHANGE;
   ThisEvent.EventParam = 0;
-  PostDCMotorService(ThisEvent);
+  Posted = PostDCMotorService(ThisEvent);
 
-  DB_printf("DesiredSpeed:%u %u, DesiredDirection: %u %u\r\n", DesiredSpeed[0], DesiredSpeed[1], DesiredDirection[0], DesiredDirection[1]);
+  BINLOG4("DesiredSpeed:%u %u, DesiredDirection: %u %u\r\n", DesiredSpeed[0],
+      DesiredSpeed[1], DesiredDirection[0], DesiredDirection[1]);
+  return Posted;
 }
 
-/***************************************************************************
- Private Functions
- ***************************************************************************/
+/****************************************************************************
+ Function
+     DCMotor_SetOutputs
+
+ Parameters
+     uint16_t dutyLeft, dutyRight - duty cycles in ticks (0 to DUTY_MAX_TICKS)
+     uint8_t dirLeft, dirRight - FORWARD or REVERSE
+
+ Returns
+     None
+
+ Description
+     Sets both motors without going through the event queue. The new
+     outputs start together within two PWM periods, a later call before
+     then replaces them.
+
+ Notes
+     Safe to call from an ISR, this is how SpeedControlService drives the
+     motors. Don't mix it with MotorCommandWrapper while a speed control
+     move is running, the control loop will overwrite the duty.
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void DCMotor_SetOutputs(uint16_t dutyLeft, uint16_t dutyRight,
+                        uint8_t dirLeft, uint8_t dirRight)
+{
+  SetTargets(dutyLeft, dutyRight, dirLeft, dirRight, true);
+}
+
+/****************************************************************************
+ Function
+     DCMotor_RampTo
+
+ Parameters
+     uint16_t dutyLeft, dutyRight - duty cycles in ticks (0 to DUTY_MAX_TICKS)
+     uint8_t dirLeft, dirRight - FORWARD or REVERSE
+
+ Returns
+     None
+
+ Description
+     Like DCMotor_SetOutputs, but each motor moves from where it is to the
+     new output at the slew rate set by DCMotor_SetSlewRate
+
+ Notes
+     Safe to call from an ISR. A later call retargets a ramp in progress
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void DCMotor_RampTo(uint16_t dutyLeft, uint16_t dutyRight,
+                    uint8_t dirLeft, uint8_t dirRight)
+{
+  SetTargets(dutyLeft, dutyRight, dirLeft, dirRight, false);
+}
 
 /****************************************************************************
  Function
-     ConfigureTimeBase
+     DCMotor_SetSlewRate
 
  Parameters
+     uint16_t ticksPerMs - largest change in duty per mS, 0 for no limit
+
+ Returns
      None
 
+ Description
+     Sets the slew rate used by DCMotor_RampTo
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void DCMotor_SetSlewRate(uint16_t ticksPerMs)
+{
+  int32_t step = ((int32_t)ticksPerMs << RAMP_FRACTION_BITS) /
+      PWM_PERIODS_PER_MS;
+
+  // a very slow rate still has to move
+  if ((ticksPerMs != 0) && (step == 0))
+  {
+    step = 1;
+  }
+  EnterCritical();
+  SlewStepQ8 = step;
+  ExitCritical();
+}
+
+/****************************************************************************
+ Function
+     DCMotor_GetOutput
+
+ Parameters
+     uint8_t motor - LEFT_MOTOR or RIGHT_MOTOR
+     uint16_t *pDuty - set to the duty ticks being driven, 0 to
+                       DUTY_MAX_TICKS whichever the direction
+     uint8_t *pDirection - set to FORWARD or REVERSE
+
  Returns
      None
 
  Description
-     Configures the timer used as the time base for PWM operation
+     Reports what was last committed to the hardware, part way through a
+     ramp that is neither the old nor the target output
 
  Author
-     Tianyu, 01/21/26
+     Tianyu, 10/14/26
 ****************************************************************************/
-static void ConfigureTimeBase(uint8_t prescale)
+void DCMotor_GetOutput(uint8_t motor, uint16_t *pDuty, uint8_t *pDirection)
 {
-  // Clear the ON control bit to disable the timer
-  T2CONbits.ON = 0;
-  // Clear teh TCS control bit to select the internal PBCLK source
-  T2CONbits.TCS = 0;
-  // Select the desired timer input clock prescale
-  T2CONbits.TCKPS = PrescaleLookup[prescale];
-  // Clear the timer register TMRx
-  TMR2 = 0;
-  // Enable the timer by setting the ON control bit
-  T2CONbits.ON = 1;
+  // the Timer2 ISR writes both fields
+  EnterCritical();
+  *pDuty = CommittedOutputs[motor].DutyTicks;
+  *pDirection = CommittedOutputs[motor].Direction;
+  ExitCritical();
 }
 
 /****************************************************************************
  Function
-     ConfigurePWM
+     DCMotor_EmergencyStop
 
  Parameters
      None
@@ -315,42 +512,296 @@ static void ConfigureTimeBase(uint8_t prescale)
      None
 
  Description
-     Configures the PWM Output Compare module for PWM operation
- 
+     Writes 0 duty to both motors now, cancels any ramp or commit that is
+     pending & drops new targets until DCMotor_ReleaseEmergencyStop
+
  Notes
-     This function configures both the timer base and the Output Compare module.
-     The timer configuration is done first to ensure proper initialization order.
+     Meant for an ISR. A direction change that was waiting for its
+     boundary is abandoned, the duty is written for the pins as they are
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void DCMotor_EmergencyStop(void)
+{
+  uint8_t motor;
+
+  EnterCritical();
+  StopLatched = true;
+  IEC0CLR = _IEC0_T2IE_MASK;
+  OutputsPending = false;
+  PinsPending = false;
+  for (motor = LEFT_MOTOR; motor <= RIGHT_MOTOR; motor++)
+  {
+    PendingTarget[motor] = 0;
+    TargetQ8[motor] = 0;
+    CurrentQ8[motor] = 0;
+    CommittedOutputs[motor].DutyTicks = 0;
+  }
+  CommittedOutputs[LEFT_MOTOR].Direction =
+      (LATB & MOTOR_REVERSE_MASK_L) ? REVERSE : FORWARD;
+  CommittedOutputs[RIGHT_MOTOR].Direction =
+      (LATB & MOTOR_REVERSE_MASK_R) ? REVERSE : FORWARD;
+  WriteDutyRegisters(CommittedOutputs);
+  HIL_MOTOR_WRITTEN((uint16_t)(LATB & MOTOR_PIN_MASKS));
+  ExitCritical();
+}
+
+/****************************************************************************
+ Function
+     DCMotor_ReleaseEmergencyStop
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Lets new targets through again. Call once whatever was driving the
+     motors has been stopped, the outputs stay at 0 until the next target
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void DCMotor_ReleaseEmergencyStop(void)
+{
+  StopLatched = false;
+}
+
+/****************************************************************************
+ Function
+     DCMotor_IsStopLatched
+
+ Parameters
+     None
+
+ Returns
+     bool, true from DCMotor_EmergencyStop until the release
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool DCMotor_IsStopLatched(void)
+{
+  return StopLatched;
+}
+
+/****************************************************************************
+ Function
+     DCMotor_PowerDown
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Zeroes both motors, cancels any ramp or commit that is pending & drives
+     all four motor pins low off the OC outputs, so Timer2, OC1 & OC2 can
+     have their clocks switched off
+
+ Notes
+     For PowerManager, a target set before DCMotor_PowerUp is committed
+     once the Timer2 interrupt can run again
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void DCMotor_PowerDown(void)
+{
+  uint8_t motor;
+
+  EnterCritical();
+  IEC0CLR = _IEC0_T2IE_MASK;
+  IFS0CLR = _IFS0_T2IF_MASK;
+  OutputsPending = false;
+  PinsPending = false;
+  for (motor = LEFT_MOTOR; motor <= RIGHT_MOTOR; motor++)
+  {
+    PendingTarget[motor] = 0;
+    TargetQ8[motor] = 0;
+    CurrentQ8[motor] = 0;
+    CommittedOutputs[motor].DutyTicks = 0;
+    CommittedOutputs[motor].Direction = FORWARD;
+  }
+  // back to the LATB bits, with both sides of each motor low
+  RPB4R = 0;
+  RPB11R = 0;
+  LATBCLR = MOTOR_PIN_MASKS;
+  HIL_MOTOR_WRITTEN((uint16_t)(LATB & MOTOR_PIN_MASKS));
+  ExitCritical();
+}
+
+/****************************************************************************
+ Function
+     DCMotor_PowerUp
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Writes the committed outputs to the OC & direction pins & maps RB4 &
+     RB11 back onto OC1 & OC2, once PowerManager has their registers back
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void DCMotor_PowerUp(void)
+{
+  EnterCritical();
+  WriteDutyRegisters(CommittedOutputs);
+  WriteDirectionPins(CommittedOutputs);
+  HIL_MOTOR_WRITTEN((uint16_t)(LATB & MOTOR_PIN_MASKS));
+  ExitCritical();
+  (void)PWMSetup_MapChannelToOutputPin(LEFT_PWM_CHANNEL, PWM_RPB4);
+  (void)PWMSetup_MapChannelToOutputPin(RIGHT_PWM_CHANNEL, PWM_RPB11);
+}
+
+/****************************************************************************
+ Function
+     PWMCommitISR
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Timer2 period interrupt, only enabled while there is something to
+     commit. Finishes the direction change for the outputs that were just
+     loaded into OCxR, then writes any new outputs to OCxRS for the next
+     boundary
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void __ISR(_TIMER_2_VECTOR, IPL6SOFT) PWMCommitISR(void)
+{
+  MotorOutput_t next[2];
+  bool          ramping = false;
+  uint8_t       motor;
+
+  // TMR2 has counted up from 0 since the period match
+  ES_IsrStats_Enter(ES_ISR(PWMCommit),
+      (uint32_t)TMR2 * PWM_TICKS_TO_CORE);
+  IFS0CLR = _IFS0_T2IF_MASK;
+
+  if (PinsPending)
+  {
+    WriteDirectionPins(CommittedOutputs);
+    PinsPending = false;
+  }
+
+  EnterCritical();
+  if (OutputsPending)
+  {
+    TargetQ8[LEFT_MOTOR] = PendingTarget[LEFT_MOTOR];
+    TargetQ8[RIGHT_MOTOR] = PendingTarget[RIGHT_MOTOR];
+    if (PendingImmediate)
+    {
+      CurrentQ8[LEFT_MOTOR] = TargetQ8[LEFT_MOTOR];
+      CurrentQ8[RIGHT_MOTOR] = TargetQ8[RIGHT_MOTOR];
+    }
+    OutputsPending = false;
+  }
+  ExitCritical();
+
+  for (motor = LEFT_MOTOR; motor <= RIGHT_MOTOR; motor++)
+  {
+    int32_t current = StepToward(CurrentQ8[motor], TargetQ8[motor],
+        SlewStepQ8);
+    int32_t magnitude = (current < 0) ? -current : current;
+
+    CurrentQ8[motor] = current;
+    if (current != TargetQ8[motor])
+    {
+      ramping = true;
+    }
+    // at 0 the direction doesn't matter, leave the pin alone
+    if (current > 0)
+    {
+      next[motor].Direction = FORWARD;
+    }
+    else if (current < 0)
+    {
+      next[motor].Direction = REVERSE;
+    }
+    else
+    {
+      next[motor].Direction = CommittedOutputs[motor].Direction;
+    }
+    next[motor].DutyTicks = (uint16_t)((magnitude +
+        (1 << (RAMP_FRACTION_BITS - 1))) >> RAMP_FRACTION_BITS);
+    if (next[motor].Direction != CommittedOutputs[motor].Direction)
+    {
+      PinsPending = true;
+    }
+    CommittedOutputs[motor] = next[motor];
+  }
+  WriteDutyRegisters(CommittedOutputs);
+  HIL_MOTOR_WRITTEN((uint16_t)(LATB & MOTOR_PIN_MASKS));
+
+  if (!PinsPending && !OutputsPending && !ramping)
+  {
+    IEC0CLR = _IEC0_T2IE_MASK;
+  }
+  ES_IsrStats_Exit(ES_ISR(PWMCommit));
+}
+
+/***************************************************************************
+ Private Functions
+ ***************************************************************************/
+
+/****************************************************************************
+ Function
+     ConfigurePWM
+
+ Parameters
+     None
+
+ Returns
+     bool, false if the PWM library rejected the setup
+
+ Description
+     Sets up OC1 & OC2 on Timer2 through the PWM library, then the Timer2
+     period interrupt used to commit new outputs
+
+ Notes
+     PWMSetup_BasicConfig also resets Timer3 to PBCLK/8, so anything else
+     using Timer3 has to be set up after this service
 
  Author
      Tianyu, 01/21/26
 ****************************************************************************/
-static void ConfigurePWM(void)
+static bool ConfigurePWM(void)
 {
-  // Step 1: Configure the timer base (must be done before OC config)
-  ConfigureTimeBase(PRESCALE_2);
-  // Keep timer off during configuration to avoid unintended pulses
-  T2CONbits.ON = 0;
-  // Disable the PWM Output Compare module before configuration
-  OC1CONbits.ON = 0;
-  OC2CONbits.ON = 0;
-
-  // Set the PWM period by writing to the timer period register
-  PR2 = PWM_PERIOD_TICKS;
-  // Write the OCxR register with the initial duty cycle
-  OC1RS = INITIAL_DUTY_TICKS;
-  // Configure the Output Compare module for PWM mode
-  OC1CONbits.OCM = 0b110; // PWM mode on OCx; Fault pin disabled
-  // Turn ON the Output Compare module
-  OC1CONbits.ON = 1;
-
-  OC2CONbits.OCM = 0b110;  // PWM Mode
-  OC2CONbits.OCTSEL = 0;   // Also use Timer 2
-  OC2RS = INITIAL_DUTY_TICKS;
-  OC2CONbits.ON = 1;
-
-  // Start the timer after PWM configuration is complete
-  TMR2 = 0;       // Clear timer register for clean start
-  T2CONbits.ON = 1;
+  bool ReturnVal;
+
+  // Timer2 & Timer3 at PBCLK/8, OC1 & OC2 in PWM mode at 0 duty
+  ReturnVal = PWMSetup_BasicConfig(NUM_PWM_CHANNELS);
+  ReturnVal = ReturnVal &&
+      PWMSetup_AssignChannelToTimer(LEFT_PWM_CHANNEL, _Timer2_) &&
+      PWMSetup_AssignChannelToTimer(RIGHT_PWM_CHANNEL, _Timer2_) &&
+      PWMSetup_SetPeriodOnTimer(PWM_PERIOD_TICKS, _Timer2_);
+
+  // The period interrupt commits new outputs, it is only enabled while
+  // there is something to commit
+  IEC0CLR = _IEC0_T2IE_MASK;
+  IFS0CLR = _IFS0_T2IF_MASK;
+  IPC2bits.T2IP = PWM_COMMIT_PRIORITY;
+  IPC2bits.T2IS = 0;
+
+  // nothing comes out until the pins are mapped, so do that last
+  ReturnVal = ReturnVal &&
+      PWMSetup_MapChannelToOutputPin(LEFT_PWM_CHANNEL, PWM_RPB4) &&
+      PWMSetup_MapChannelToOutputPin(RIGHT_PWM_CHANNEL, PWM_RPB11);
+  return ReturnVal;
 }
 
 /****************************************************************************
@@ -382,11 +833,6 @@ static void ConfigureDCMotorPins(void)
   MOTOR_REVERSE_PIN_L = 0;
   MOTOR_FORWARD_PIN_R = 0;
   MOTOR_REVERSE_PIN_R = 0;
-
-  // Map OC1 output to RB4
-  RPB4R = 0b0101;
-  // Map OC2 output to RB11
-  RPB11R = 0b0101;
 }
 
 /****************************************************************************
@@ -430,5 +876,145 @@ static uint16_t MapSpeedToDutyCycle(uint16_t desiredSpeed)
   return (uint16_t)dutyCycle;
 }
 
+/****************************************************************************
+ Function
+     SetTargets
+
+ Parameters
+     uint16_t dutyLeft, dutyRight - duty cycles in ticks
+     uint8_t dirLeft, dirRight - FORWARD or REVERSE
+     bool immediate - true to skip the ramp
+
+ Returns
+     None
+
+ Description
+     Hands new targets to the Timer2 ISR and makes sure it is running,
+     unless an emergency stop is latched
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static void SetTargets(uint16_t dutyLeft, uint16_t dutyRight,
+                       uint8_t dirLeft, uint8_t dirRight, bool immediate)
+{
+  int32_t left = (int32_t)MapSpeedToDutyCycle(dutyLeft) << RAMP_FRACTION_BITS;
+  int32_t right = (int32_t)MapSpeedToDutyCycle(dutyRight) << RAMP_FRACTION_BITS;
+
+  EnterCritical();
+  if (StopLatched)
+  {
+    ExitCritical();
+    return;
+  }
+  PendingTarget[LEFT_MOTOR] = (dirLeft == FORWARD) ? left : -left;
+  PendingTarget[RIGHT_MOTOR] = (dirRight == FORWARD) ? right : -right;
+  PendingImmediate = immediate;
+  OutputsPending = true;
+  if (!IEC0bits.T2IE)
+  {
+    // T2IF is set every period, clear it so the commit waits for a boundary
+    IFS0CLR = _IFS0_T2IF_MASK;
+    IEC0SET = _IEC0_T2IE_MASK;
+  }
+  ExitCritical();
+}
+
+/****************************************************************************
+ Function
+     StepToward
+
+ Parameters
+     int32_t current, target - signed Q8 duty ticks
+     int32_t step - largest change, 0 for no limit
+
+ Returns
+     int32_t - current moved toward target by at most step
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static int32_t StepToward(int32_t current, int32_t target, int32_t step)
+{
+  if (step == 0)
+  {
+    return target;
+  }
+  if (target > current)
+  {
+    return ((target - current) > step) ? (current + step) : target;
+  }
+  return ((current - target) > step) ? (current - step) : target;
+}
+
+/****************************************************************************
+ Function
+     WriteDutyRegisters
+
+ Parameters
+     const MotorOutput_t *pOutputs - left & right outputs
+
+ Returns
+     None
+
+ Description
+     Writes both OCxRS registers in one PWM library call, inverting the
+     duty for a motor in REVERSE since its reverse pin is then held high
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static void WriteDutyRegisters(const MotorOutput_t *pOutputs)
+{
+  uint16_t widths[NUM_PWM_CHANNELS];
+  uint8_t  motor;
+
+  // LEFT_MOTOR is on the lower numbered channel, so this is mask order
+  for (motor = LEFT_MOTOR; motor <= RIGHT_MOTOR; motor++)
+  {
+    widths[motor] = (pOutputs[motor].Direction == FORWARD) ?
+        pOutputs[motor].DutyTicks :
+        (PWM_PERIOD_TICKS - pOutputs[motor].DutyTicks + 1);
+  }
+  PWMOperate_SetPulseWidthOnChannels(MOTOR_PWM_CHANNELS, widths);
+}
+
+/****************************************************************************
+ Function
+     WriteDirectionPins
+
+ Parameters
+     const MotorOutput_t *pOutputs - left & right outputs
+
+ Returns
+     None
+
+ Description
+     Sets the reverse pin of each motor to match its direction, both in
+     one write
+
+ Notes
+     Nothing else drives these pins, so LATB can't change between the read
+     & the LATBINV
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static void WriteDirectionPins(const MotorOutput_t *pOutputs)
+{
+  uint32_t reverse = 0;
+
+  if (pOutputs[LEFT_MOTOR].Direction != FORWARD)
+  {
+    reverse |= MOTOR_REVERSE_MASK_L;
+  }
+  if (pOutputs[RIGHT_MOTOR].Direction != FORWARD)
+  {
+    reverse |= MOTOR_REVERSE_MASK_R;
+  }
+  // flip just the pins that differ, LATBbits would take a write for each
+  LATBINV = (LATB ^ reverse) & MOTOR_REVERSE_MASKS;
+}
+
 /*------------------------------- Footnotes -------------------------------*/
 /*------------------------------ End of file ------------------------------*/
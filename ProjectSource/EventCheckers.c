@@ -6,14 +6,26 @@
    0.1
 
  Description
-   Event checkers for beacon, tape, and keyboard input.
+   Event checkers for the digital inputs, tape, and keyboard input.
 
  Notes
    Use static variables to detect transitions.
 
+   Check4InputChanges covers every row of DIGITAL_INPUT_TABLE (Ports.h)
+   from one read of the debounced scan word, so a bouncing input only
+   gets here once it has settled. With nothing changed that is one XOR &
+   return, whatever the number of inputs, & each row that did change is
+   one bit test.
+
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       Tianyu  Check4InputChanges takes the debounced inputs
+ 10/14/26       Tianyu  Check4InputChanges replaces Check4BeaconDetected
+ 10/14/26       Tianyu  Tape & beacon events are published to their
+                        subscribers (ES_Publish)
+ 10/14/26       Tianyu  Check4TapeDetected reads the analog array, posts
+                        ES_TAPE_LOST & ES_LINE_POSITION too
  02/03/26       Tianyu  Initial creation for Lab 8 event checkers
 ****************************************************************************/
 
@@ -28,6 +40,8 @@
 #include "CommonDefinitions.h"
 #include "dbprintf.h"
 #include "Ports.h"
+#include "TapeArray.h"
+#include "MainLogicFSM.h"
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -75,27 +89,39 @@ bool Check4Keystroke(void)
    bool: true if a new tape event was detected & posted
 
  Description
-   Checks for a low-going transition on the tape sensor input.
+   Takes each new block from the tape array. Publishes ES_TAPE_DETECTED
+   when the line is found & ES_TAPE_LOST when it is lost, and while
+   MainLogicFSM is following the line, every new ES_LINE_POSITION.
 
  Author
    Tianyu, 02/03/26
 ****************************************************************************/
 bool Check4TapeDetected(void)
 {
-  static bool LastTapeState = true;
-  bool CurrentTapeState = ReadTapeSensorPin();
+  static bool LastTapeState = false;
+  bool CurrentTapeState;
+  ES_Event_t ThisEvent;
 
-  if ((CurrentTapeState == false) && (LastTapeState == true))
+  if (!TapeArray_Update())
   {
-    ES_Event_t ThisEvent;
-    ThisEvent.EventType = ES_TAPE_DETECTED;
-    ThisEvent.EventParam = 0;
-    PostMainLogicFSM(ThisEvent);
+    return false; // no new block
+  }
+  CurrentTapeState = TapeArray_LineSeen();
+  ThisEvent.EventParam = (uint16_t)TapeArray_GetPosition();
+
+  if (CurrentTapeState != LastTapeState)
+  {
+    ThisEvent.EventType = CurrentTapeState ? ES_TAPE_DETECTED : ES_TAPE_LOST;
+    ES_Publish(ThisEvent);
     LastTapeState = CurrentTapeState;
     return true;
   }
-
-  LastTapeState = CurrentTapeState;
+  if (CurrentTapeState && (QueryMainLogicFSM() == FollowingLine))
+  {
+    ThisEvent.EventType = ES_LINE_POSITION;
+    ES_Publish(ThisEvent);
+    return true;
+  }
   return false;
 }
 
@@ -124,39 +150,50 @@ bool Check4CommandAvailable(void)
 
 /****************************************************************************
  Function
-   Check4BeaconDetected
+   Check4InputChanges
 
  Parameters
    None
 
  Returns
-   bool: true if IR input is HIGH
+   bool: true if an input changed & an event was published
 
  Description
-   Beaon event checker. The IR beacon sensor is active HIGH.
+   Takes the debounced inputs of DIGITAL_INPUT_TABLE & publishes the
+   OnEvent or OffEvent of each one that changed since the last call
 
  Author
-   Tianyu, 02/04/26
+   Tianyu, 10/14/26
 ****************************************************************************/
-bool Check4BeaconDetected(void)
+bool Check4InputChanges(void)
 {
-  static bool LastBeaconState = false;
-  bool CurrentBeaconState = ReadBeaconInputPin();
+  static uint32_t LastInputs = 0;   // all inactive
+  uint32_t Inputs = ReadDebouncedInputs();
+  uint32_t Changed = Inputs ^ LastInputs;
+  bool     Found = false;
 
-  if ((CurrentBeaconState == true) && (LastBeaconState == false))
+  if (Changed == 0)
   {
-    DEBUG_OUTPUT_PIN_LAT = 1;
-    ES_Event_t ThisEvent;
-    ThisEvent.EventType = ES_BEACON_DETECTED;
-    ThisEvent.EventParam = 0;
-    PostMainLogicFSM(ThisEvent);
-    LastBeaconState = CurrentBeaconState;
-//    printf("Posting ES_BEACON_DETECTED event.\r\n");
-    DEBUG_OUTPUT_PIN_LAT = 0;
-    return true;
+    return false;
   }
+  LastInputs = Inputs;
+
+  // a bit test for each row, the table may be empty
+#define INPUT_CHANGE_ROW(Name, Pin, ActiveLow, DebounceMs, OnEvent, OffEvent)\
+  if (Changed & (1u << (Pin)))                                               \
+  {                                                                          \
+    ES_Event_t ThisEvent;                                                    \
+    ThisEvent.EventType = (Inputs & (1u << (Pin))) ? (OnEvent) : (OffEvent); \
+    if (ThisEvent.EventType != ES_NO_EVENT)                                  \
+    {                                                                        \
+      ThisEvent.EventParam = DIGITAL_INPUT(Name);                            \
+      ES_EVENT_SET_DATA(ThisEvent, _CP0_GET_COUNT());                        \
+      ES_Publish(ThisEvent);                                                 \
+      Found = true;                                                          \
+    }                                                                        \
+  }
+  DIGITAL_INPUT_TABLE(INPUT_CHANGE_ROW)
+#undef INPUT_CHANGE_ROW
 
-  LastBeaconState = CurrentBeaconState;
-  return false;
+  return Found;
 }
-
@@ -0,0 +1,438 @@
+/****************************************************************************
+ Module
+   FixedPointUnits.c
+
+ Revision
+   0.1
+
+ Description
+   Fixed-point unit conversions for the speed control and beacon timing
+   paths. Nothing in here uses floats or the divide instruction, so a 1kHz
+   control loop doesn't pull in the soft-float library or wait on DIVU.
+
+ Notes
+   FP_Divide gets 1/d from a 64 entry seed table, indexed by the top bits of
+   d once it has been normalized with CLZ, then improves it with two Newton
+   steps (each one doubles the number of good bits, 7 -> 14 -> 28). That
+   leaves the quotient at most a count or two off, and a check against the
+   remainder fixes that, so FP_Divide gives the same answer as '/'.
+
+   FP_Sqrt works out the root a bit at a time, 16 shifts & compares, so it
+   takes the same time whatever the value.
+
+   FP_Sin looks up a quarter wave, 64 steps of it, & interpolates between
+   the two entries either side of the angle, which is good to 6 counts in
+   65536. The other three quarters are the first one mirrored and/or
+   negated, FP_Cos is FP_Sin a quarter turn on.
+
+   The conversion constants are in FixedPointUnits.h, where the compiler
+   works them out.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Added FP_Sin & FP_Cos
+ 10/14/26       Tianyu  Added FP_Sqrt
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "FixedPointUnits.h"
+#include "ES_Port.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// The seed for entry i is 1/x at the middle of the range of normalized
+// x = d / 2^32 in [0.5, 1.0) that maps to it, x = (129 + 2i) / 256. The
+// seed is held in Q2.30, so 1/x = 256 / (129 + 2i) becomes this
+#define RECIP_SEED(i) \
+  ((uint32_t)((((uint64_t)1 << 38) + ((129 + 2 * (i)) / 2)) / (129 + 2 * (i))))
+
+#define SEED_INDEX_BITS 6
+#define SEED_INDEX_SHIFT (31 - SEED_INDEX_BITS)
+#define SEED_INDEX_MASK ((1 << SEED_INDEX_BITS) - 1)
+
+// 2.0 in Q2.30
+#define Q2_30_TWO ((uint32_t)1 << 31)
+
+// a quarter turn of FP_Angle_t, split into SINE_STEPS table steps
+#define QUARTER_TURN (FP_ANGLE_TURN / 4)
+#define SINE_STEP_BITS 6
+#define SINE_STEPS (1 << SINE_STEP_BITS)
+#define SINE_FRACTION_BITS (14 - SINE_STEP_BITS)
+#define SINE_FRACTION_MASK ((1 << SINE_FRACTION_BITS) - 1)
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint8_t CountLeadingZeros(uint32_t Value);
+static int32_t QuarterSine(uint16_t Angle);
+
+/*---------------------------- Module Variables ---------------------------*/
+static const uint32_t RecipSeed[1 << SEED_INDEX_BITS] = {
+  RECIP_SEED(0), RECIP_SEED(1), RECIP_SEED(2), RECIP_SEED(3),
+  RECIP_SEED(4), RECIP_SEED(5), RECIP_SEED(6), RECIP_SEED(7),
+  RECIP_SEED(8), RECIP_SEED(9), RECIP_SEED(10), RECIP_SEED(11),
+  RECIP_SEED(12), RECIP_SEED(13), RECIP_SEED(14), RECIP_SEED(15),
+  RECIP_SEED(16), RECIP_SEED(17), RECIP_SEED(18), RECIP_SEED(19),
+  RECIP_SEED(20), RECIP_SEED(21), RECIP_SEED(22), RECIP_SEED(23),
+  RECIP_SEED(24), RECIP_SEED(25), RECIP_SEED(26), RECIP_SEED(27),
+  RECIP_SEED(28), RECIP_SEED(29), RECIP_SEED(30), RECIP_SEED(31),
+  RECIP_SEED(32), RECIP_SEED(33), RECIP_SEED(34), RECIP_SEED(35),
+  RECIP_SEED(36), RECIP_SEED(37), RECIP_SEED(38), RECIP_SEED(39),
+  RECIP_SEED(40), RECIP_SEED(41), RECIP_SEED(42), RECIP_SEED(43),
+  RECIP_SEED(44), RECIP_SEED(45), RECIP_SEED(46), RECIP_SEED(47),
+  RECIP_SEED(48), RECIP_SEED(49), RECIP_SEED(50), RECIP_SEED(51),
+  RECIP_SEED(52), RECIP_SEED(53), RECIP_SEED(54), RECIP_SEED(55),
+  RECIP_SEED(56), RECIP_SEED(57), RECIP_SEED(58), RECIP_SEED(59),
+  RECIP_SEED(60), RECIP_SEED(61), RECIP_SEED(62), RECIP_SEED(63)
+};
+
+// sin(i * 90 / SINE_STEPS degrees) in Q16.16, rounded, the last entry is
+// 90 degrees itself so the interpolation has an entry past the end
+static const int32_t SineTable[SINE_STEPS + 1] = {
+  0, 1608, 3216, 4821, 6424, 8022, 9616, 11204,
+  12785, 14359, 15924, 17479, 19024, 20557, 22078, 23586,
+  25080, 26558, 28020, 29466, 30893, 32303, 33692, 35062,
+  36410, 37736, 39040, 40320, 41576, 42806, 44011, 45190,
+  46341, 47464, 48559, 49624, 50660, 51665, 52639, 53581,
+  54491, 55368, 56212, 57022, 57798, 58538, 59244, 59914,
+  60547, 61145, 61705, 62228, 62714, 63162, 63572, 63944,
+  64277, 64571, 64827, 65043, 65220, 65358, 65457, 65516,
+  65536
+};
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     FP_Divide
+
+ Parameters
+     uint32_t Numerator
+     uint32_t Denominator
+
+ Returns
+     uint32_t Numerator / Denominator, rounded down like '/'. 0xFFFFFFFF if
+     the Denominator is 0
+
+ Description
+     Divides with a reciprocal from the seed table and two Newton steps
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint32_t FP_Divide(uint32_t Numerator, uint32_t Denominator)
+{
+  uint8_t   Shift;
+  uint32_t  Normalized;
+  uint32_t  Recip;
+  uint32_t  Error;
+  uint64_t  Quotient;
+  int64_t   Remainder;
+
+  if (Denominator == 0)
+  {
+    return UINT32_MAX;
+  }
+
+  // x = Normalized / 2^32 is in [0.5, 1.0)
+  Shift = CountLeadingZeros(Denominator);
+  Normalized = Denominator << Shift;
+  Recip = RecipSeed[(Normalized >> SEED_INDEX_SHIFT) & SEED_INDEX_MASK];
+
+  // Newton step: y = y * (2 - x * y), all in Q2.30
+  Error = Q2_30_TWO - (uint32_t)(((uint64_t)Normalized * Recip) >> 32);
+  Recip = (uint32_t)(((uint64_t)Recip * Error) >> 30);
+  Error = Q2_30_TWO - (uint32_t)(((uint64_t)Normalized * Recip) >> 32);
+  Recip = (uint32_t)(((uint64_t)Recip * Error) >> 30);
+
+  // 1/d = y * 2^(Shift - 62)
+  Quotient = ((uint64_t)Numerator * Recip) >> (62 - Shift);
+
+  // fix up the last count or two using the remainder
+  Remainder = (int64_t)Numerator - (int64_t)(Quotient * Denominator);
+  while (Remainder < 0)
+  {
+    Quotient--;
+    Remainder += Denominator;
+  }
+  while (Remainder >= (int64_t)Denominator)
+  {
+    Quotient++;
+    Remainder -= Denominator;
+  }
+  return (uint32_t)Quotient;
+}
+
+/****************************************************************************
+ Function
+     FP_PeriodToRPM
+
+ Parameters
+     uint32_t Period - time between encoder edges in encoder timer ticks
+
+ Returns
+     FP_Q16_t - measured RPM in Q16.16, 0 for a period of 0
+
+ Description
+     Fixed point replacement for PeriodToRPM
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+FP_Q16_t FP_PeriodToRPM(uint32_t Period)
+{
+  if (Period == 0)
+  {
+    return 0;
+  }
+  return FP_Divide(FP_RPM_PERIOD_CONST_Q16, Period);
+}
+
+/****************************************************************************
+ Function
+     FP_ADToRPM
+
+ Parameters
+     uint16_t ADValue - A/D reading (0-1023)
+
+ Returns
+     FP_Q16_t - desired RPM in Q16.16
+
+ Description
+     Fixed point replacement for ADToRPM, a single multiply
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+FP_Q16_t FP_ADToRPM(uint16_t ADValue)
+{
+  return (FP_Q16_t)ADValue * FP_RPM_PER_AD_COUNT_Q16;
+}
+
+/****************************************************************************
+ Function
+     FP_PeriodToHz
+
+ Parameters
+     uint32_t Period - time for one cycle in timer ticks
+     uint32_t TickHz - the timer tick rate
+
+ Returns
+     uint32_t - frequency in Hz, rounded to the nearest Hz. 0 for a period
+     of 0
+
+ Description
+     frequency = TickHz / Period, without a divide
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint32_t FP_PeriodToHz(uint32_t Period, uint32_t TickHz)
+{
+  if (Period == 0)
+  {
+    return 0;
+  }
+  return FP_Divide(TickHz + (Period >> 1), Period);
+}
+
+/****************************************************************************
+ Function
+     FP_Sqrt
+
+ Parameters
+     uint32_t Value
+
+ Returns
+     uint32_t - the square root of Value, rounded down
+
+ Description
+     Integer square root. The root of a Q16.16 value comes out in Q8.8
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint32_t FP_Sqrt(uint32_t Value)
+{
+  uint32_t Root = 0;
+  uint32_t Bit = (uint32_t)1 << 30;
+
+  // binary digit by digit, one bit of the root for every 2 of the value
+  while (Bit != 0)
+  {
+    if (Value >= (Root + Bit))
+    {
+      Value -= Root + Bit;
+      Root = (Root >> 1) + Bit;
+    }
+    else
+    {
+      Root >>= 1;
+    }
+    Bit >>= 2;
+  }
+  return Root;
+}
+
+/****************************************************************************
+ Function
+     FP_Sin
+
+ Parameters
+     FP_Angle_t Angle - FP_ANGLE_TURN to a full turn
+
+ Returns
+     int32_t - sin(Angle) in Q16.16, -FP_TRIG_ONE to FP_TRIG_ONE
+
+ Description
+     Sine from the quarter wave table, with no floats
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+int32_t FP_Sin(FP_Angle_t Angle)
+{
+  uint16_t InQuarter = Angle & (QUARTER_TURN - 1);
+  int32_t  Sine;
+
+  // the second & fourth quarters run back down the table
+  if (Angle & QUARTER_TURN)
+  {
+    Sine = QuarterSine(QUARTER_TURN - InQuarter);
+  }
+  else
+  {
+    Sine = QuarterSine(InQuarter);
+  }
+  // & the second half is the first one negated
+  return (Angle & (2 * QUARTER_TURN)) ? -Sine : Sine;
+}
+
+/****************************************************************************
+ Function
+     FP_Cos
+
+ Parameters
+     FP_Angle_t Angle - FP_ANGLE_TURN to a full turn
+
+ Returns
+     int32_t - cos(Angle) in Q16.16, -FP_TRIG_ONE to FP_TRIG_ONE
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+int32_t FP_Cos(FP_Angle_t Angle)
+{
+  return FP_Sin((FP_Angle_t)(Angle + QUARTER_TURN));
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+// sin of 0 to a whole QUARTER_TURN, interpolated from SineTable
+static int32_t QuarterSine(uint16_t Angle)
+{
+  uint16_t Step = Angle >> SINE_FRACTION_BITS;
+  int32_t  Fraction = Angle & SINE_FRACTION_MASK;
+
+  if (Step >= SINE_STEPS)
+  {
+    return SineTable[SINE_STEPS];
+  }
+  return SineTable[Step] + (((SineTable[Step + 1] - SineTable[Step]) *
+      Fraction) >> SINE_FRACTION_BITS);
+}
+
+static uint8_t CountLeadingZeros(uint32_t Value)
+{
+#ifdef _PORT_HAS_CLZ_
+  return (uint8_t)__builtin_clz(Value);
+#else
+  uint8_t Count = 0;
+
+  while ((Value & 0x80000000u) == 0)
+  {
+    Value <<= 1;
+    Count++;
+  }
+  return Count;
+#endif
+}
+
+#ifdef TEST
+/* test harness, checks FP_Divide against '/', FP_Sqrt & the trig */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+int main(void)
+{
+  uint32_t  Num;
+  uint32_t  Den;
+  uint32_t  Seed = 12345;
+  uint32_t  i;
+  uint32_t  Failures = 0;
+
+  for (i = 0; i < 1000000; i++)
+  {
+    // a simple LCG, with the denominator spread over all bit lengths
+    Seed = Seed * 1664525u + 1013904223u;
+    Num = Seed;
+    Seed = Seed * 1664525u + 1013904223u;
+    Den = Seed >> (Seed & 31);
+    if (Den == 0)
+    {
+      continue;
+    }
+    if (FP_Divide(Num, Den) != (Num / Den))
+    {
+      if (Failures++ < 10)
+      {
+        printf("FP_Divide(%u, %u) = %u, not %u\r\n", Num, Den,
+            FP_Divide(Num, Den), Num / Den);
+      }
+    }
+  }
+  for (Den = 1; Den < 4096; Den++)
+  {
+    if ((FP_Divide(UINT32_MAX, Den) != (UINT32_MAX / Den)) ||
+        (FP_Divide(Den - 1, Den) != 0))
+    {
+      Failures++;
+    }
+  }
+  for (i = 0; i < 1000000; i++)
+  {
+    uint64_t Root;
+
+    Seed = Seed * 1664525u + 1013904223u;
+    Num = Seed >> (Seed & 31);
+    Root = FP_Sqrt(Num);
+    if (((Root * Root) > Num) || (((Root + 1) * (Root + 1)) <= Num))
+    {
+      if (Failures++ < 10)
+      {
+        printf("FP_Sqrt(%u) = %u\r\n", Num, (uint32_t)Root);
+      }
+    }
+  }
+  for (i = 0; i < FP_ANGLE_TURN; i++)
+  {
+    double Radians = (i * 2.0 * M_PI) / FP_ANGLE_TURN;
+    int32_t SineError = FP_Sin((FP_Angle_t)i) -
+        (int32_t)lround(sin(Radians) * FP_TRIG_ONE);
+    int32_t CosineError = FP_Cos((FP_Angle_t)i) -
+        (int32_t)lround(cos(Radians) * FP_TRIG_ONE);
+
+    if ((abs(SineError) > 6) || (abs(CosineError) > 6))
+    {
+      if (Failures++ < 10)
+      {
+        printf("FP_Sin(%u) = %d, FP_Cos = %d\r\n", i,
+            FP_Sin((FP_Angle_t)i), FP_Cos((FP_Angle_t)i));
+      }
+    }
+  }
+  printf("%u failures\r\n", Failures);
+  printf("RPM at period 771: %u/65536\r\n", FP_PeriodToRPM(771));
+  printf("RPM at AD 1023: %u/65536\r\n", FP_ADToRPM(1023));
+  return 0;
+}
+#endif
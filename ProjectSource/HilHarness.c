@@ -0,0 +1,431 @@
+/****************************************************************************
+ Module
+   HilHarness.c
+
+ Revision
+   0.1
+
+ Description
+   Plays HIL_SCRIPT_TABLE into the framework at its times, logs the motor
+   register writes that come of it & compares them with HIL_GOLDEN_TABLE
+   (see HilHarness.h).
+
+ Notes
+   The script is played from TestHarnessService0, which gets the
+   ES_SHORT_TIMEOUTs of TIMER_A & passes them on while a run is going.
+   Each timeout plays every row that is due, then starts the timer for the
+   next one, a HIL_MAX_WAIT_US at a time as the short timer only takes 16
+   bits of uS.
+
+   HilHarness_MotorWritten is called from the Timer2 ISR, the stop input's
+   CN ISR with the interrupts off & the power manager's hooks, also with
+   them off, so no call of it can come in part way through another. The
+   log is only read once Logging is false.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_ShortTimer.h"
+#include "ES_Time.h"
+#include "HilHarness.h"
+#include "CommonDefinitions.h"
+#include "CommandRetrieveService.h"
+#include "terminal.h"
+#include "dbprintf.h"
+#include <xc.h>
+
+#ifdef USE_HIL_HARNESS
+
+/*----------------------------- Module Defines ----------------------------*/
+// the longest the short timer is started for, under its 16 bit uS
+#define HIL_MAX_WAIT_US 60000u
+
+// worst case length of a printed golden row
+#define HIL_DUMP_ROW_BYTES 48
+
+// mismatches printed in a report, the rest are only counted
+#define HIL_MAX_REPORTED 8
+
+#define HIL_SCRIPT_ROW(AtUs, Kind, Value) { (AtUs), (Kind), (Value) },
+#define HIL_GOLDEN_ROW(AtUs, Oc1rs, Oc2rs, LatB) \
+  { (AtUs), (Oc1rs), (Oc2rs), (LatB) },
+
+#define NUM_SCRIPT_ROWS (sizeof(Script) / sizeof(Script[0]))
+#define NUM_GOLDEN_ROWS (sizeof(Golden) / sizeof(Golden[0]))
+
+/*------------------------------ Module Types -----------------------------*/
+typedef struct
+{
+  uint32_t AtUs;
+  uint8_t  Kind;
+  int16_t  Value;
+} HilStep_t;
+
+typedef struct
+{
+  uint32_t AtUs;
+  uint16_t Oc1rs;
+  uint16_t Oc2rs;
+  uint16_t LatB;
+} HilWrite_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void Play(const HilStep_t *pStep);
+static void Report(void);
+static bool WriteMatches(const HilWrite_t *pLogged, const HilWrite_t *pGolden,
+                         int32_t *pSkewUs);
+static bool IsStep(uint16_t Written, uint16_t Logged);
+static uint16_t Difference(uint16_t A, uint16_t B);
+
+/*---------------------------- Module Variables ---------------------------*/
+static const HilStep_t Script[] = {
+  HIL_SCRIPT_TABLE(HIL_SCRIPT_ROW)
+};
+
+static const HilWrite_t Golden[] = {
+  HIL_GOLDEN_TABLE(HIL_GOLDEN_ROW)
+};
+
+// written by HilHarness_MotorWritten while Logging
+static volatile HilWrite_t Log[HIL_LOG_DEPTH];
+static volatile uint8_t    NumLogged;
+static volatile bool       LogOverflow;
+static volatile bool       Logging = false;
+static volatile uint64_t   StartUs;
+
+static bool     Running = false;
+static uint8_t  NextRow;
+static uint32_t WorstLateUs;
+static uint8_t  DumpNext;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     HilHarness_Start
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Clears the log & starts a run, the rows at 0 are played now
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void HilHarness_Start(void)
+{
+  if (Running)
+  {
+    DB_printf("HIL run already going\r\n");
+    return;
+  }
+  NumLogged = 0;
+  LogOverflow = false;
+  NextRow = 0;
+  WorstLateUs = 0;
+  DumpNext = 0;
+  StartUs = ES_Time_NowUs();
+  Logging = true;
+  Running = true;
+  DB_printf("HIL run, %u rows over %uuS\r\n", (uint32_t)NUM_SCRIPT_ROWS,
+      HIL_RUN_US);
+  HilHarness_Step();
+}
+
+/****************************************************************************
+ Function
+     HilHarness_IsRunning
+
+ Parameters
+     None
+
+ Returns
+     bool, true from HilHarness_Start until the report
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool HilHarness_IsRunning(void)
+{
+  return Running;
+}
+
+/****************************************************************************
+ Function
+     HilHarness_Step
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Plays the rows that are due & starts TIMER_A for the next one, or
+     after HIL_RUN_US stops logging & reports
+
+ Notes
+     For each ES_SHORT_TIMEOUT of TIMER_A while HilHarness_IsRunning
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void HilHarness_Step(void)
+{
+  uint32_t NowUs = (uint32_t)(ES_Time_NowUs() - StartUs);
+  uint32_t DueUs;
+  uint32_t WaitUs;
+
+  if (!Running)
+  {
+    return;
+  }
+  while ((NextRow < NUM_SCRIPT_ROWS) && (Script[NextRow].AtUs <= NowUs))
+  {
+    if ((NowUs - Script[NextRow].AtUs) > WorstLateUs)
+    {
+      WorstLateUs = NowUs - Script[NextRow].AtUs;
+    }
+    Play(&Script[NextRow]);
+    NextRow++;
+  }
+  if (NowUs >= HIL_RUN_US)
+  {
+    Logging = false;
+    Running = false;
+    Report();
+    return;
+  }
+  DueUs = (NextRow < NUM_SCRIPT_ROWS) ? Script[NextRow].AtUs : HIL_RUN_US;
+  WaitUs = DueUs - NowUs;
+  if (WaitUs > HIL_MAX_WAIT_US)
+  {
+    WaitUs = HIL_MAX_WAIT_US;
+  }
+  ES_ShortTimerStart(TIMER_A, (uint16_t)WaitUs);
+}
+
+/****************************************************************************
+ Function
+     HilHarness_DumpGolden
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Prints the log of the last run as HIL_GOLDEN_TABLE rows, as many as
+     there is room for in the transmit buffer. Call again for the rest
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void HilHarness_DumpGolden(void)
+{
+  if (Logging)
+  {
+    DB_printf("HIL run still going\r\n");
+    return;
+  }
+  if (DumpNext == 0)
+  {
+    DB_printf("#define HIL_GOLDEN_TABLE(X) \\\r\n");
+  }
+  while ((DumpNext < NumLogged) &&
+         (Terminal_GetXmitSpace() >= HIL_DUMP_ROW_BYTES))
+  {
+    DB_printf("  X(%u, %u, %u, 0x%x)%s\r\n", Log[DumpNext].AtUs,
+        Log[DumpNext].Oc1rs, Log[DumpNext].Oc2rs, Log[DumpNext].LatB,
+        (DumpNext + 1 < NumLogged) ? " \\" : "");
+    DumpNext++;
+  }
+  if (DumpNext < NumLogged)
+  {
+    DB_printf("g for the rest\r\n");
+  }
+  else
+  {
+    DumpNext = 0;
+  }
+}
+
+/****************************************************************************
+ Function
+     HilHarness_MotorWritten
+
+ Parameters
+     uint16_t LatB - the motor pins' bits of LATB after the write
+
+ Returns
+     None
+
+ Description
+     Logs OC1RS, OC2RS & LatB with the time since the start, if the write
+     is a step from what was logged last (see HilHarness.h)
+
+ Notes
+     From an ISR or with the interrupts off, see the module notes
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void HilHarness_MotorWritten(uint16_t LatB)
+{
+  HilWrite_t Write;
+
+  if (!Logging)
+  {
+    return;
+  }
+  Write.Oc1rs = (uint16_t)OC1RS;
+  Write.Oc2rs = (uint16_t)OC2RS;
+  Write.LatB = LatB;
+  if ((NumLogged != 0) && (Log[NumLogged - 1].LatB == Write.LatB) &&
+      !IsStep(Write.Oc1rs, Log[NumLogged - 1].Oc1rs) &&
+      !IsStep(Write.Oc2rs, Log[NumLogged - 1].Oc2rs))
+  {
+    return;
+  }
+  if (NumLogged == HIL_LOG_DEPTH)
+  {
+    LogOverflow = true;
+    return;
+  }
+  Write.AtUs = (uint32_t)(ES_Time_NowUs() - StartUs);
+  Log[NumLogged] = Write;
+  NumLogged++;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+// feeds one row in the way its source would
+static void Play(const HilStep_t *pStep)
+{
+  ES_Event_t ThisEvent;
+
+  switch (pStep->Kind)
+  {
+    case HIL_SPI:
+      CommandRetrieve_Inject((uint8_t)pStep->Value);
+      break;
+
+    case HIL_BEACON:
+      ThisEvent.EventType = ES_BEACON_DETECTED;
+      ThisEvent.EventParam = (uint16_t)pStep->Value;
+      ES_EVENT_SET_DATA(ThisEvent, _CP0_GET_COUNT());
+      ES_Publish(ThisEvent);
+      break;
+
+    case HIL_TAPE:
+      ThisEvent.EventType = pStep->Value ? ES_TAPE_DETECTED : ES_TAPE_LOST;
+      ThisEvent.EventParam = 0;
+      ES_Publish(ThisEvent);
+      break;
+
+    case HIL_LINE:
+      ThisEvent.EventType = ES_LINE_POSITION;
+      ThisEvent.EventParam = (uint16_t)pStep->Value;
+      ES_Publish(ThisEvent);
+      break;
+
+    default:
+      break;
+  }
+}
+
+// compares the log with the golden trace row by row & prints the result
+static void Report(void)
+{
+  HilWrite_t Logged;
+  uint8_t    Failures = 0;
+  int32_t    WorstSkewUs = 0;
+  int32_t    SkewUs;
+  uint8_t    i;
+
+  for (i = 0; (i < NUM_GOLDEN_ROWS) || (i < NumLogged); i++)
+  {
+    if (i >= NumLogged)
+    {
+      if (Failures++ < HIL_MAX_REPORTED)
+      {
+        DB_printf("HIL row %u missing, wanted %u %u 0x%x at %uuS\r\n", i,
+            Golden[i].Oc1rs, Golden[i].Oc2rs, Golden[i].LatB,
+            Golden[i].AtUs);
+      }
+      continue;
+    }
+    Logged = Log[i];
+    if (i >= NUM_GOLDEN_ROWS)
+    {
+      if (Failures++ < HIL_MAX_REPORTED)
+      {
+        DB_printf("HIL row %u extra, %u %u 0x%x at %uuS\r\n", i,
+            Logged.Oc1rs, Logged.Oc2rs, Logged.LatB, Logged.AtUs);
+      }
+      continue;
+    }
+    if (!WriteMatches(&Logged, &Golden[i], &SkewUs))
+    {
+      if (Failures++ < HIL_MAX_REPORTED)
+      {
+        DB_printf("HIL row %u got %u %u 0x%x at %uuS, wanted %u %u 0x%x "
+            "at %uuS\r\n", i, Logged.Oc1rs, Logged.Oc2rs, Logged.LatB,
+            Logged.AtUs, Golden[i].Oc1rs, Golden[i].Oc2rs, Golden[i].LatB,
+            Golden[i].AtUs);
+      }
+    }
+    if (((SkewUs < 0) ? -SkewUs : SkewUs) >
+        ((WorstSkewUs < 0) ? -WorstSkewUs : WorstSkewUs))
+    {
+      WorstSkewUs = SkewUs;
+    }
+  }
+  if (LogOverflow)
+  {
+    DB_printf("HIL log full, writes past %u lost\r\n", HIL_LOG_DEPTH);
+    Failures++;
+  }
+  DB_printf("HIL %s: %u writes, %u failed, worst skew %duS, "
+      "stimuli up to %uuS late\r\n", (Failures == 0) ? "PASS" : "FAIL",
+      NumLogged, Failures, WorstSkewUs, WorstLateUs);
+}
+
+// true if the logged write is close enough to the golden one, with how
+// much later than it the logged one came
+static bool WriteMatches(const HilWrite_t *pLogged, const HilWrite_t *pGolden,
+                         int32_t *pSkewUs)
+{
+  *pSkewUs = (int32_t)(pLogged->AtUs - pGolden->AtUs);
+  return (pLogged->LatB == pGolden->LatB) &&
+         (Difference(pLogged->Oc1rs, pGolden->Oc1rs) <= HIL_DUTY_TOLERANCE) &&
+         (Difference(pLogged->Oc2rs, pGolden->Oc2rs) <= HIL_DUTY_TOLERANCE) &&
+         (((*pSkewUs < 0) ? -*pSkewUs : *pSkewUs) <=
+          (int32_t)HIL_TIME_TOLERANCE_US);
+}
+
+// true if a duty register has moved far enough to log
+static bool IsStep(uint16_t Written, uint16_t Logged)
+{
+  return (Difference(Written, Logged) >= HIL_LOG_STEP) ||
+         ((Written == 0) && (Logged != 0));
+}
+
+static uint16_t Difference(uint16_t A, uint16_t B)
+{
+  return (A > B) ? (A - B) : (B - A);
+}
+
+#endif /* USE_HIL_HARNESS */
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
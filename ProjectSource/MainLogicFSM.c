@@ -9,15 +9,90 @@
    Main logic state machine for command-driven robot behavior.
 
  Notes
+   Runs on the ES_HSM runtime, the state tables are below. A new command
+   is handled once, by the Active parent, for every state.
+
+   Commands are taken from CommandPipeline, ES_COMMAND_RETRIEVED is only
+   the notice that one is waiting. A turn has an end, so commands that
+   arrive during one wait in the pipeline & the next one starts the moment
+   the turn completes, straight from the turn, with no stop between. A
+   stop doesn't wait, it ends the turn at once, & the sequencer throws
+   away every command ahead of a stop rather than running them first. The
+   other moves only end on a sensor or a new command, so a command that
+   comes in during one starts at once, and a non-turn command that already
+   has another behind it in the pipeline is skipped. A beacon alignment
+   sees its search through: the notice of a command that comes in during
+   one waits in the shared deferral pool & is recalled as the alignment
+   ends, unless it is a stop, which ends the alignment there & then &
+   throws away what was deferred or queued ahead of it.
+
+   A beacon alignment doesn't stop on the first sighting, the events get
+   here too late for that. It turns a full sweep, binning each sighting at
+   the heading it was made (BeaconBearing), then turns back the short way
+   to the peak by distance, at the slower speed. The sweep & the turn back
+   are one coroutine (ES_Coroutine.h), AlignWithBeacon, which
+   AligningWithBeacon hands its sensor & move events to.
+
+   The stop input has already zeroed the motors from its ISR by the time
+   ES_EMERGENCY_STOP gets here. Active takes it in every state & goes to
+   Stopped, which stops the speed loop & only then releases the latch in
+   DCMotorService, so nothing can drive the wheels in between.
+
+   Each top level state asks PowerManager for the peripherals it needs as
+   it is entered, so the PWM is off while Stopped, the ADC only runs for
+   the tape states & the beacon capture only while aligning.
+
    States:
      - Stopped
      - SimpleMoving
      - SearchingForTape
      - AligningWithBeacon
+     - FollowingLine, entered when a tape search finds the tape. Steers
+       on the line position from the tape array until the line has been
+       lost for the LINELOST parameter or a new command comes in
 
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       Tianyu  A stop during an alignment is run there, with the
+                        deferred & queued commands thrown away
+ 10/14/26       Tianyu  A stop isn't held by a turn, & the commands ahead of
+                        a stop in the pipeline are thrown away
+ 10/14/26       Tianyu  Beacon sightings are fused & timed by
+                        BeaconDetect_TakeSighting
+ 10/14/26       Tianyu  The beacon alignment runs as a coroutine, in place
+                        of the SweepingForBeacon & ReturningToBeacon states
+ 10/14/26       Tianyu  A command's speed & distance can come with it
+                        from the pipeline
+ 10/14/26       Tianyu  The states switch the PWM, ADC & beacon capture on
+                        & off through PowerManager
+ 10/14/26       Tianyu  The machine starts, stopping the motors, on ES_INIT
+                        rather than in the init, once the motor services
+                        are up
+ 10/14/26       Tianyu  Command speeds & turn distances are scaled by the
+                        SPEEDPCT & TURNTRIM parameters, the line lost time
+                        is the LINELOST one
+ 10/14/26       Tianyu  ES_EMERGENCY_STOP goes to Stopped from any state
+ 10/14/26       Tianyu  Beacon alignment sweeps a full turn & turns back to
+                        the bearing of the peak, rather than stopping on
+                        the first sighting
+ 10/14/26       Tianyu  Commands that come in during a beacon alignment are
+                        deferred to the pool until it ends
+ 10/14/26       Tianyu  Stopping & starting a turn ask for fast command
+                        polls
+ 10/14/26       Tianyu  Prints go through ES_Log, timeouts at LOG_WARN
+ 10/14/26       Tianyu  Subscribes to the tape & beacon sensor events
+ 10/14/26       Tianyu  Commands run from CommandTable, the per command
+                        move functions are gone
+ 10/14/26       Tianyu  Commands run from CommandPipeline in order, a turn
+                        finishes before the next one & hands over without
+                        stopping
+ 10/14/26       Tianyu  Moved onto the ES_HSM table driven runtime, new
+                        commands preempt without re-posting
+ 10/14/26       Tianyu  Tape search hands over to line following on the
+                        analog tape array
+ 10/14/26       Tianyu  Moves run under SpeedControlService, turns end on
+                        distance (ES_MOVE_COMPLETE)
  02/03/26       Tianyu  Initial creation for Lab 8 main logic
 ****************************************************************************/
 
@@ -25,30 +100,167 @@
 #include "ES_Configure.h"
 #include "ES_Framework.h"
 #include "ES_Timers.h"
+#include "ES_HSM.h"
+#include "ES_Coroutine.h"
 #include "MainLogicFSM.h"
 #include "DCMotorService.h"
+#include "SpeedControlService.h"
 #include "CommonDefinitions.h"
-#include "dbprintf.h"
+#include "ES_Log.h"
 #include "Ports.h"
-#include "dbprintf.h"
+#include "TapeArray.h"
+#include "CommandPipeline.h"
+#include "CommandRetrieveService.h"
+#include "BeaconDetectService.h"
+#include "ES_DeferRecall.h"
+#include "BeaconBearing.h"
+#include "BeaconClassifier.h"
+#include "ParamStore.h"
+#include "PowerManager.h"
 
 /*----------------------------- Module Defines ----------------------------*/
+// Line following, the wheel speed difference is LINE_STEER_PER_MM for
+// each mm the line is off the middle of the array
+#define LINE_SPEED_RPM SPEED_HALF_RPM
+#define LINE_STEER_PER_MM FP_INT_TO_Q16(1)
+
+// the turn back to the beacon, slow enough to stop where it is told
+#define BEACON_RETURN_RPM SPEED_HALF_RPM
 
 /*---------------------------- Module Functions ---------------------------*/
-static void RotateCW90(void);
-static void RotateCW45(void);
-static void RotateCCW90(void);
-static void RotateCCW45(void);
-static void DriveForwardHalf(void);
-static void DriveForwardFull(void);
-static void DriveReverseHalf(void);
-static void DriveReverseFull(void);
-static void SearchForTape(void);
-static void AlignWithBeacon(void);
+// state actions & handlers
+static void EnterStopped(void);
+static void EnterSimpleMoving(void);
+static void ExitSimpleMoving(void);
+static void EnterSearchingForTape(void);
+static void ExitSearchingForTape(void);
+static void EnterAligningWithBeacon(void);
+static void ExitAligningWithBeacon(void);
+static void EnterFollowingLine(void);
+static void ExitFollowingLine(void);
+static bool OnCommand(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+static bool OnEmergencyStop(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+static bool OnCommandWhileMoving(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+static bool OnCommandWhileAligning(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+static bool OnMoveComplete(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+static bool OnSimpleMoveTimeout(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+static bool OnTapeFound(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+static bool OnTapeSearchTimeout(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+static bool OnAlignEvent(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+static bool OnBeaconAlignTimeout(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+static bool OnLinePosition(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+static bool OnLineLost(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+static bool OnLineFound(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+static bool OnLineLostTimeout(ES_HSM_t *pMachine, ES_Event_t ThisEvent);
+
+// sequencer
+static bool StartNextCommand(ES_HSM_t *pMachine);
+static void DropAheadOfStop(void);
+static const ES_HSMState_t *SelectCommand(const CommandRequest_t *pRequest);
+
+// sequences
+static ES_CoStatus_t AlignWithBeacon(ES_Co_t *pCo, ES_Event_t ThisEvent);
+
+// moves
+static void StartCommandMove(uint8_t BackstopTimer);
+static bool PlanReturnToBeacon(void);
+static void FollowLine(int16_t Position);
+
+/*------------------------------ State Tables -----------------------------*/
+/*
+   Active is the parent of every state & owns ES_COMMAND_RETRIEVED, so a new
+   command preempts whatever is running in the same dispatch. The exit
+   action of the state being left cleans up its timer. No state handles
+   ES_EMERGENCY_STOP itself.
+*/
+static const ES_HSMState_t ActiveState;
+
+static const ES_HSMRow_t ActiveRows[] = {
+  { ES_COMMAND_RETRIEVED, OnCommand },
+  { ES_EMERGENCY_STOP,    OnEmergencyStop }
+};
+static const ES_HSMState_t ActiveState = {
+  NULL, NULL, NULL, NULL, NULL,
+  ActiveRows, ES_HSM_NUM_ROWS(ActiveRows), Stopped // never the current state
+};
+
+static const ES_HSMState_t StoppedState = {
+  &ActiveState, NULL, EnterStopped, NULL, NULL,
+  NULL, 0, Stopped
+};
+
+static const ES_HSMRow_t SimpleMovingRows[] = {
+  { ES_COMMAND_RETRIEVED, OnCommandWhileMoving },
+  { ES_MOVE_COMPLETE, OnMoveComplete },
+  { ES_TIMEOUT,       OnSimpleMoveTimeout }
+};
+static const ES_HSMState_t SimpleMovingState = {
+  &ActiveState, NULL, EnterSimpleMoving, ExitSimpleMoving, NULL,
+  SimpleMovingRows, ES_HSM_NUM_ROWS(SimpleMovingRows), SimpleMoving
+};
+
+static const ES_HSMRow_t SearchingForTapeRows[] = {
+  { ES_TAPE_DETECTED, OnTapeFound },
+  { ES_TIMEOUT,       OnTapeSearchTimeout }
+};
+static const ES_HSMState_t SearchingForTapeState = {
+  &ActiveState, NULL, EnterSearchingForTape, ExitSearchingForTape, NULL,
+  SearchingForTapeRows, ES_HSM_NUM_ROWS(SearchingForTapeRows),
+  SearchingForTape
+};
+
+/*
+   AligningWithBeacon owns the backstop & the deferred commands, the steps
+   of the alignment itself are the AlignWithBeacon coroutine's.
+*/
+static const ES_HSMRow_t AligningWithBeaconRows[] = {
+  { ES_COMMAND_RETRIEVED, OnCommandWhileAligning },
+  { ES_BEACON_DETECTED, OnAlignEvent },
+  { ES_MOVE_COMPLETE,   OnAlignEvent },
+  { ES_TIMEOUT,         OnBeaconAlignTimeout }
+};
+static const ES_HSMState_t AligningWithBeaconState = {
+  &ActiveState, NULL, EnterAligningWithBeacon, ExitAligningWithBeacon, NULL,
+  AligningWithBeaconRows, ES_HSM_NUM_ROWS(AligningWithBeaconRows),
+  AligningWithBeacon
+};
+
+static const ES_HSMRow_t FollowingLineRows[] = {
+  { ES_LINE_POSITION, OnLinePosition },
+  { ES_TAPE_LOST,     OnLineLost },
+  { ES_TAPE_DETECTED, OnLineFound },
+  { ES_TIMEOUT,       OnLineLostTimeout }
+};
+static const ES_HSMState_t FollowingLineState = {
+  &ActiveState, NULL, EnterFollowingLine, ExitFollowingLine, NULL,
+  FollowingLineRows, ES_HSM_NUM_ROWS(FollowingLineRows), FollowingLine
+};
+
+// state that runs each CommandAction_t
+static const ES_HSMState_t *const ActionStates[NUM_CMD_ACTIONS] = {
+  [CMD_ACTION_INVALID]      = NULL,
+  [CMD_ACTION_STOP]         = &StoppedState,
+  [CMD_ACTION_MOVE]         = &SimpleMovingState,
+  [CMD_ACTION_ALIGN_BEACON] = &AligningWithBeaconState,
+  [CMD_ACTION_SEARCH_TAPE]  = &SearchingForTapeState
+};
 
 /*---------------------------- Module Variables ---------------------------*/
-static MainLogicState_t CurrentState;
+static ES_HSM_t Machine;
 static uint8_t MyPriority;
+// the command the next state starts on entry, set by SelectCommand, a copy
+// of its CommandTable entry with the request's arguments in it
+static const CommandDesc_t *pPendingCommand;
+static CommandDesc_t PendingCommand;
+static bool PendingIsTurn;
+// the move running in SimpleMoving is a turn, it ends on its own
+static bool MoveIsTurn;
+// the beacon alignment's place in its steps
+static ES_Co_t Alignment;
+// the turn from the end of the sweep back to the beacon
+static uint8_t  ReturnDirLeft;
+static uint8_t  ReturnDirRight;
+static uint32_t ReturnCaptures;
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -62,7 +274,8 @@ static uint8_t MyPriority;
      bool, false if error in initialization, true otherwise
 
  Description
-     Initializes the main logic state machine.
+     Sets up the sensors & subscriptions. The machine itself is started
+     by ES_INIT, once every init is done.
 
  Author
      Tianyu, 02/03/26
@@ -73,26 +286,40 @@ bool InitMainLogicFSM(uint8_t Priority)
 
   MyPriority = Priority;
 
+  // first, so it is ahead of anything the ISRs set up below can post
+  ThisEvent.EventType = ES_INIT;
+  if (!ES_PostToService(MyPriority, ThisEvent))
+  {
+    return false;
+  }
+
   /********************************************
    Initialization code for ports and sensors
    *******************************************/
   // TODO: Initialize ports via Ports.c/Ports.h
   InitBeaconInputPin();
+  InitStopInputPin();
+  InitScannedInputs();
   InitTapeSensorPin();
   InitCommandSPIPins();
   InitDebugOutputPin();
-
-  CurrentState = Stopped;
-
-  // Stop motors on startup
-  MotorCommandWrapper(0, 0, FORWARD, FORWARD);
-
-  ThisEvent.EventType = ES_INIT;
-  if (ES_PostToService(MyPriority, ThisEvent) == true)
+  if (!TapeArray_Init())
   {
-    return true;
+    return false;
   }
-  return false;
+
+  // the sensor events are published, not posted to us
+  ES_Subscribe(MyPriority, ES_TAPE_DETECTED);
+  ES_Subscribe(MyPriority, ES_TAPE_LOST);
+  ES_Subscribe(MyPriority, ES_LINE_POSITION);
+  ES_Subscribe(MyPriority, ES_BEACON_DETECTED);
+  ES_Subscribe(MyPriority, ES_EMERGENCY_STOP);
+
+  pPendingCommand = &CommandTable[CMD_STOP];
+  PendingIsTurn = false;
+  MoveIsTurn = false;
+  // Machine has no state until ES_INIT starts it
+  return true;
 }
 
 /****************************************************************************
@@ -127,7 +354,9 @@ bool PostMainLogicFSM(ES_Event_t ThisEvent)
    ES_Event_t, ES_NO_EVENT if no error ES_ERROR otherwise
 
  Description
-   State machine for command-driven robot behavior.
+   Starts the machine in Stopped on ES_INIT, then hands every event to the
+   state tables above. Events no state handles (stale timeouts) are
+   dropped.
 
  Author
      Tianyu, 02/03/26
@@ -136,159 +365,15 @@ ES_Event_t RunMainLogicFSM(ES_Event_t ThisEvent)
 {
   ES_Event_t ReturnEvent;
   ReturnEvent.EventType = ES_NO_EVENT;
-  
-//  DB_printf("Current State is %d \r\n", CurrentState);
 
-  switch (CurrentState)
+  if (ThisEvent.EventType == ES_INIT)
   {
-    case Stopped:
-      if (ThisEvent.EventType == ES_COMMAND_RETRIEVED)
-      {
-        switch (ThisEvent.EventParam)
-        {
-          case CMD_STOP:
-            MotorCommandWrapper(0, 0, FORWARD, FORWARD);
-            break;
-          case CMD_ROTATE_CW_90:
-            DB_printf("State: Rotating CW 90 deg\r\n");
-
-            RotateCW90();
-            CurrentState = SimpleMoving;
-            break;
-          case CMD_ROTATE_CW_45:
-            DB_printf("State:  Rotating CW 45 deg\r\n");
-
-            RotateCW45();
-            CurrentState = SimpleMoving;
-            break;
-          case CMD_ROTATE_CCW_90:
-              DB_printf("State: Rotating CCW 90 deg\r\n");
-            RotateCCW90();
-            CurrentState = SimpleMoving;
-            break;
-          case CMD_ROTATE_CCW_45:
-              DB_printf("State: Rotating CCW 45 deg\r\n");
-            RotateCCW45();
-            CurrentState = SimpleMoving;
-            break;
-          case CMD_DRIVE_FWD_HALF:
-              DB_printf("State: drive forwards half speed\r\n");
-            DriveForwardHalf();
-            CurrentState = SimpleMoving;
-            break;
-          case CMD_DRIVE_FWD_FULL:
-              DB_printf("State: drive forwards full speed\r\n");
-            DriveForwardFull();
-            CurrentState = SimpleMoving;
-            break;
-          case CMD_DRIVE_REV_HALF:
-              DB_printf("State: drive reverse half speed\r\n");
-            DriveReverseHalf();
-            CurrentState = SimpleMoving;
-            break;
-          case CMD_DRIVE_REV_FULL:
-              DB_printf("State: drive reverse full speed\r\n");
-            DriveReverseFull();
-            CurrentState = SimpleMoving;
-            break;
-          case CMD_ALIGN_BEACON:
-              DB_printf("State: aligning with beacon\r\n");
-            // If already HIGH, the ES_BEACON_DETECTED event will be posted immediately
-            if( ReadBeaconInputPin() == true ) {
-              ES_Event_t BeaconEvent;
-              BeaconEvent.EventType = ES_BEACON_DETECTED;
-              BeaconEvent.EventParam = 0;
-              PostMainLogicFSM(BeaconEvent);
-            }
-            else{
-              // If not detected, act to look for beacon signal
-              AlignWithBeacon();
-            }
-            CurrentState = AligningWithBeacon;
-            break;
-          case CMD_SEARCH_TAPE:
-              DB_printf("State: searching for tape \r\n");
-            // If already HIGH, the ES_TAPE_DETECTED event will be posted immediately
-            if( ReadTapeSensorPin() == true ) {
-              ES_Event_t TapeEvent;
-              TapeEvent.EventType = ES_TAPE_DETECTED;
-              TapeEvent.EventParam = 0;
-              PostMainLogicFSM(TapeEvent);
-            }
-            else{
-            // If not detected, act to look for line detect signal
-              SearchForTape();
-            }
-            CurrentState = SearchingForTape;
-            break;
-          default:
-            break;
-        }
-      }
-      break;
-
-    case SimpleMoving:
-      if (ThisEvent.EventType == ES_TIMEOUT &&
-          ThisEvent.EventParam == SIMPLE_MOVE_TIMER) // movement timer expired after a set amount of time
-      {
-          DB_printf("Motor Timeout Received while moving\r\n");
-        MotorCommandWrapper(0, 0, FORWARD, FORWARD);
-        CurrentState = Stopped;
-      }
-      else if (ThisEvent.EventType == ES_COMMAND_RETRIEVED) // while simple moving, new command received
-      {
-        DB_printf("New command received while moving\r\n");
-        CurrentState = Stopped;
-        PostMainLogicFSM(ThisEvent); //go back to stopped list to take action on new command
-      }
-      break;
-
-    case SearchingForTape:
-      if (ThisEvent.EventType == ES_TAPE_DETECTED) // detected tape
-      {
-          DB_printf("Tape detected\r\n");
-        MotorCommandWrapper(0, 0, FORWARD, FORWARD);
-        CurrentState = Stopped;
-      }
-      else if (ThisEvent.EventType == ES_TIMEOUT &&
-               ThisEvent.EventParam == TAPE_SEARCH_TIMER) // stop looking for tape after set time
-      {
-        MotorCommandWrapper(0, 0, FORWARD, FORWARD);
-        DB_printf("Tape Search Failed: Timeout");
-        CurrentState = Stopped;
-      }
-      else if (ThisEvent.EventType == ES_COMMAND_RETRIEVED)    // new command received while searching for tape
-      {
-        DB_printf("New command received while searching for tape\r\n");
-        CurrentState = Stopped;
-        PostMainLogicFSM(ThisEvent);
-      }
-      break;
-
-    case AligningWithBeacon:
-      if (ThisEvent.EventType == ES_BEACON_DETECTED) // found direction of beacon
-      {
-        DB_printf("Found beacon\r\n");
-        MotorCommandWrapper(0, 0, FORWARD, FORWARD); // change speed
-        CurrentState = Stopped;
-      }
-      else if (ThisEvent.EventType == ES_TIMEOUT &&
-               ThisEvent.EventParam == BEACON_ALIGN_TIMER) // set time passed, stop aligning towards beacon
-      {
-        MotorCommandWrapper(0, 0, FORWARD, FORWARD);
-        DB_printf("Beacon Search Failed: Timeout");
-        CurrentState = Stopped;
-      }
-      else if (ThisEvent.EventType == ES_COMMAND_RETRIEVED) // new command received while aligning for beacon
-      {
-        DB_printf("New command received while aligning with beacon\r\n");
-        CurrentState = Stopped;
-        PostMainLogicFSM(ThisEvent);
-      }
-      break;
-
-    default:
-      break;
+    // the motor services are up, Stopped stops the motors on entry
+    ES_HSM_Init(&Machine, &StoppedState);
+  }
+  else
+  {
+    ES_HSM_Dispatch(&Machine, ThisEvent);
   }
 
   return ReturnEvent;
@@ -312,113 +397,292 @@ ES_Event_t RunMainLogicFSM(ES_Event_t ThisEvent)
 ****************************************************************************/
 MainLogicState_t QueryMainLogicFSM(void)
 {
-  return CurrentState;
+  // before ES_INIT the motors are off too
+  if (ES_HSM_GetState(&Machine) == NULL)
+  {
+    return Stopped;
+  }
+  return (MainLogicState_t)ES_HSM_GetState(&Machine)->Id;
 }
 
-/*----------------------------- Helper Functions --------------------------*/
-/****************************************************************************
- Function
-     RotateCW90
+/*------------------------------ State Actions ----------------------------*/
+static void EnterStopped(void)
+{
+  SpeedControl_Stop();
+  // the loop is stopped, so an emergency stop has nothing left to hold off
+  DCMotor_ReleaseEmergencyStop();
+  // nothing to do until the next command, so look for it often
+  CommandRetrieve_PollFast();
+  // & nothing needs the PWM or the sensors until then
+  PowerManager_Need(POWER_NONE);
+}
 
- Parameters
-     None
+static void EnterSimpleMoving(void)
+{
+  PowerManager_Need(POWER_MASK(Pwm));
+  MoveIsTurn = PendingIsTurn;
+  StartCommandMove(SIMPLE_MOVE_TIMER);
+  // a turn is over in a moment & the next command runs from its end
+  if (MoveIsTurn)
+  {
+    CommandRetrieve_PollFast();
+  }
+}
 
- Returns
-     None
+static void ExitSimpleMoving(void)
+{
+  ES_Timer_StopTimer(SIMPLE_MOVE_TIMER);
+}
 
- Description
-     Open-loop 90 degree clockwise rotation.
+static void EnterSearchingForTape(void)
+{
+  PowerManager_Need(POWER_MASK(Pwm) | POWER_MASK(Tape));
+  StartCommandMove(TAPE_SEARCH_TIMER);
+}
 
- Author
-     Tianyu, 02/03/26
-****************************************************************************/
-static void RotateCW90(void)
+static void ExitSearchingForTape(void)
 {
-  // Pseudocode:
-  // MotorCommandWrapper(FULL_SPEED, FULL_SPEED, FORWARD, REVERSE)
-  // Initialize SIMPLE_MOVE_TIMER to 6000 ms
-  MotorCommandWrapper(FULL_SPEED, FULL_SPEED, FORWARD, REVERSE);
-  ES_Timer_InitTimer(SIMPLE_MOVE_TIMER, SIMPLE_MOVE_90_MS);
+  ES_Timer_StopTimer(TAPE_SEARCH_TIMER);
 }
 
-/****************************************************************************
- Function
-     RotateCW45
+static void EnterAligningWithBeacon(void)
+{
+  ES_Event_t StartEvent;
 
- Parameters
-     None
+  PowerManager_Need(POWER_MASK(Pwm) | POWER_MASK(Beacon));
+  if (pPendingCommand->BackstopMs != 0)
+  {
+    ES_Timer_InitTimer(BEACON_ALIGN_TIMER, pPendingCommand->BackstopMs);
+  }
+  // runs up to the end of the sweep, the rest comes from OnAlignEvent
+  StartEvent.EventType = ES_NO_EVENT;
+  StartEvent.EventParam = 0;
+  ES_CO_INIT(&Alignment);
+  (void)AlignWithBeacon(&Alignment, StartEvent);
+}
 
- Returns
-     None
+static void ExitAligningWithBeacon(void)
+{
+  ES_Timer_StopTimer(BEACON_ALIGN_TIMER);
+  // the commands that came in meanwhile are the next thing handled
+  ES_RecallFromPool(MyPriority);
+}
 
- Description
-     Open-loop 45 degree clockwise rotation.
+static void EnterFollowingLine(void)
+{
+  PowerManager_Need(POWER_MASK(Pwm) | POWER_MASK(Tape));
+  FollowLine(TapeArray_GetPosition());
+}
 
- Author
-     Tianyu, 02/03/26
-****************************************************************************/
-static void RotateCW45(void)
+static void ExitFollowingLine(void)
 {
-  // Pseudocode:
-  // MotorCommandWrapper(FULL_SPEED, FULL_SPEED, FORWARD, REVERSE)
-  // Initialize SIMPLE_MOVE_TIMER to 3000 ms
-  MotorCommandWrapper(FULL_SPEED, FULL_SPEED, FORWARD, REVERSE);
-  ES_Timer_InitTimer(SIMPLE_MOVE_TIMER, SIMPLE_MOVE_45_MS);
+  ES_Timer_StopTimer(LINE_LOST_TIMER);
 }
 
-/****************************************************************************
- Function
-     RotateCCW90
+/*----------------------------- Event Handlers ----------------------------*/
+static bool OnCommand(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  // the command comes from the pipeline, it may already have been run by a
+  // turn completing
+  StartNextCommand(pMachine);
+  return true;
+}
 
- Parameters
-     None
+static bool OnEmergencyStop(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  LOG_WARN("Emergency stop\r\n");
+  ES_HSM_Transition(pMachine, &StoppedState);
+  return true;
+}
 
- Returns
-     None
+static bool OnCommandWhileMoving(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  // a turn keeps the command waiting until it completes, a drive or a stop
+  // goes through to Active
+  if (CommandTable[(uint8_t)ThisEvent.EventParam].Action == CMD_ACTION_STOP)
+  {
+    return false;
+  }
+  return MoveIsTurn;
+}
 
- Description
-     Open-loop 90 degree counter-clockwise rotation.
+static bool OnCommandWhileAligning(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  CommandRequest_t Request;
 
- Author
-     Tianyu, 02/03/26
-****************************************************************************/
-static void RotateCCW90(void)
+  // a stop ends the alignment at once, anything else waits for it to end.
+  // The one notice runs every command in the pipeline, so only the first
+  // is kept. If the pool won't take it, preempt
+  if (CommandTable[(uint8_t)ThisEvent.EventParam].Action == CMD_ACTION_STOP)
+  {
+    // nothing deferred or queued ahead of the stop runs, the exit action's
+    // recall finds the pool empty
+    ES_FlushDeferred(MyPriority);
+    DropAheadOfStop();
+    if (CommandPipeline_Peek(0, &Request) &&
+        (CommandTable[Request.Command].Action == CMD_ACTION_STOP))
+    {
+      (void)CommandPipeline_Take(&Request);
+      (void)SelectCommand(&Request);
+    }
+    // Stopped stops the wheels as it is entered
+    ES_HSM_Transition(pMachine, &StoppedState);
+    return true;
+  }
+  if (ES_GetDeferredCount(MyPriority) != 0)
+  {
+    return true;
+  }
+  return ES_DeferToPool(MyPriority, ThisEvent);
+}
+
+static bool OnMoveComplete(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  // turn covered its distance, go straight on to the next command
+  if (!StartNextCommand(pMachine))
+  {
+    ES_HSM_Transition(pMachine, &StoppedState);
+  }
+  return true;
+}
+
+static bool OnSimpleMoveTimeout(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  if (ThisEvent.EventParam != SIMPLE_MOVE_TIMER)
+  {
+    return false;
+  }
+  // movement timer expired after a set amount of time
+  LOG_INFO("Motor Timeout Received while moving\r\n");
+  if (!StartNextCommand(pMachine))
+  {
+    ES_HSM_Transition(pMachine, &StoppedState);
+  }
+  return true;
+}
+
+static bool OnTapeFound(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  LOG_INFO("Tape detected\r\n");
+  ES_HSM_Transition(pMachine, &FollowingLineState);
+  return true;
+}
+
+static bool OnTapeSearchTimeout(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  if (ThisEvent.EventParam != TAPE_SEARCH_TIMER)
+  {
+    return false;
+  }
+  LOG_WARN("Tape Search Failed: Timeout");
+  ES_HSM_Transition(pMachine, &StoppedState);
+  return true;
+}
+
+static bool OnAlignEvent(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  // found it, or gave up, either way the alignment is over
+  if (AlignWithBeacon(&Alignment, ThisEvent) == ES_CO_DONE)
+  {
+    ES_HSM_Transition(pMachine, &StoppedState);
+  }
+  return true;
+}
+
+static bool OnBeaconAlignTimeout(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  if (ThisEvent.EventParam != BEACON_ALIGN_TIMER)
+  {
+    return false;
+  }
+  LOG_WARN("Beacon Search Failed: Timeout");
+  ES_HSM_Transition(pMachine, &StoppedState);
+  return true;
+}
+
+static bool OnLinePosition(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  // steer toward the line
+  FollowLine((int16_t)ThisEvent.EventParam);
+  return true;
+}
+
+static bool OnLineLost(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
 {
-  // Pseudocode:
-  // MotorCommandWrapper(FULL_SPEED, FULL_SPEED, REVERSE, FORWARD)
-  // Initialize SIMPLE_MOVE_TIMER to 6000 ms
-  MotorCommandWrapper(FULL_SPEED, FULL_SPEED, REVERSE, FORWARD);
-  ES_Timer_InitTimer(SIMPLE_MOVE_TIMER, SIMPLE_MOVE_90_MS);
+  // keep going for a bit, it may be a gap or a tight curve
+  ES_Timer_InitTimer(LINE_LOST_TIMER, ParamStore_Get(PARAM_ID(LINELOST)));
+  return true;
 }
 
+static bool OnLineFound(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  ES_Timer_StopTimer(LINE_LOST_TIMER);
+  FollowLine((int16_t)ThisEvent.EventParam);
+  return true;
+}
+
+static bool OnLineLostTimeout(ES_HSM_t *pMachine, ES_Event_t ThisEvent)
+{
+  if (ThisEvent.EventParam != LINE_LOST_TIMER)
+  {
+    return false;
+  }
+  LOG_WARN("Line lost\r\n");
+  ES_HSM_Transition(pMachine, &StoppedState);
+  return true;
+}
+
+/*------------------------------- Sequencer -------------------------------*/
 /****************************************************************************
  Function
-     RotateCCW45
+     StartNextCommand
 
  Parameters
-     None
+     ES_HSM_t *pMachine
 
  Returns
-     None
+     bool, false if there was no command to start
 
  Description
-     Open-loop 45 degree counter-clockwise rotation.
+     Takes commands from the pipeline until it finds one that should run:
+     a turn, or the last command waiting. Anything ahead of a stop is
+     thrown away first. Asks for the transition to its state. Going from one move to the next doesn't pass through Stopped,
+     so the speed loop carries the wheels straight from one to the next
 
  Author
-     Tianyu, 02/03/26
+     Tianyu, 10/14/26
 ****************************************************************************/
-static void RotateCCW45(void)
+static bool StartNextCommand(ES_HSM_t *pMachine)
 {
-  // Pseudocode:
-  // MotorCommandWrapper(FULL_SPEED, FULL_SPEED, REVERSE, FORWARD)
-  // Initialize SIMPLE_MOVE_TIMER to 3000 ms
-  MotorCommandWrapper(FULL_SPEED, FULL_SPEED, REVERSE, FORWARD); 
-  ES_Timer_InitTimer(SIMPLE_MOVE_TIMER, SIMPLE_MOVE_45_MS);
+  const ES_HSMState_t *pTarget = NULL;
+  const ES_HSMState_t *pNext;
+  CommandRequest_t Request;
+
+  DropAheadOfStop();
+  while (CommandPipeline_Take(&Request))
+  {
+    pNext = SelectCommand(&Request);
+    if (pNext != NULL)
+    {
+      pTarget = pNext;
+    }
+    if ((pTarget != NULL) &&
+        (PendingIsTurn || (CommandPipeline_Count() == 0)))
+    {
+      break;
+    }
+  }
+  if (pTarget == NULL)
+  {
+    return false;
+  }
+  ES_HSM_Transition(pMachine, pTarget);
+  return true;
 }
 
 /****************************************************************************
  Function
-     DriveForwardHalf
+     DropAheadOfStop
 
  Parameters
      None
@@ -427,137 +691,264 @@ static void RotateCCW45(void)
      None
 
  Description
-     Drive forward at half speed (open-loop).
+     Throws away the commands in the pipeline ahead of the newest stop, so
+     the stop takes effect now rather than after them. The stop & anything
+     that came in after it stay
 
  Author
-     Tianyu, 02/03/26
+     Tianyu, 10/14/26
 ****************************************************************************/
-static void DriveForwardHalf(void)
+static void DropAheadOfStop(void)
 {
-  // Pseudocode:
-  // MotorCommandWrapper(HALF_SPEED, HALF_SPEED, FORWARD, FORWARD)
-  // Optionally set SIMPLE_MOVE_TIMER
-  MotorCommandWrapper(HALF_SPEED, HALF_SPEED, FORWARD, FORWARD);
+  CommandRequest_t Request;
+  uint8_t          Ahead = 0;
+  uint8_t          i;
+
+  for (i = 0; CommandPipeline_Peek(i, &Request); i++)
+  {
+    if (CommandTable[Request.Command].Action == CMD_ACTION_STOP)
+    {
+      Ahead = i;
+    }
+  }
+  CommandPipeline_Discard(Ahead);
 }
 
 /****************************************************************************
  Function
-     DriveForwardFull
+     SelectCommand
 
  Parameters
-     None
+     const CommandRequest_t *pRequest - command from the pipeline
 
  Returns
-     None
+     const ES_HSMState_t *, the state that runs it, NULL for an unknown
+     command
 
  Description
-     Drive forward at full speed (open-loop).
+     Looks the command up in CommandTable & keeps its entry, with the
+     speed & distance the request gives in place of the table's, for the
+     entry action of the state that runs it
 
  Author
-     Tianyu, 02/03/26
+     Tianyu, 10/14/26
 ****************************************************************************/
-static void DriveForwardFull(void)
+static const ES_HSMState_t *SelectCommand(const CommandRequest_t *pRequest)
 {
-  // Pseudocode:
-  // MotorCommandWrapper(FULL_SPEED, FULL_SPEED, FORWARD, FORWARD)
-  // Optionally set SIMPLE_MOVE_TIMER
-  MotorCommandWrapper(FULL_SPEED, FULL_SPEED, FORWARD, FORWARD);
+  const CommandDesc_t *pCommand = &CommandTable[pRequest->Command];
+  const ES_HSMState_t *pTarget = ActionStates[pCommand->Action];
+
+  PendingIsTurn = false;
+  if (pTarget == NULL)
+  {
+    return NULL;
+  }
+  LOG_INFO("Command 0x%x\r\n", pRequest->Command);
+  PendingCommand = *pCommand;
+  if (pRequest->SpeedQ8 != 0)
+  {
+    PendingCommand.Speed = (uint32_t)pRequest->SpeedQ8 << (FP_Q16_SHIFT - 8);
+  }
+  if (pRequest->Distance != 0)
+  {
+    PendingCommand.Distance = pRequest->Distance;
+  }
+  pPendingCommand = &PendingCommand;
+  PendingIsTurn = (PendingCommand.Distance != SPEED_CONTROL_NO_LIMIT);
+
+  // already over the line, follow it straight away
+  if ((pTarget == &SearchingForTapeState) &&
+      (TapeArray_LineSeen() == true))
+  {
+    pTarget = &FollowingLineState;
+  }
+  return pTarget;
 }
 
+/*------------------------------- Sequences -------------------------------*/
 /****************************************************************************
  Function
-     DriveReverseHalf
+     AlignWithBeacon
 
  Parameters
-     None
+     ES_Co_t *pCo - the alignment's coroutine
+     ES_Event_t ThisEvent - a beacon sighting or a move completing
 
  Returns
-     None
+     ES_CoStatus_t, ES_CO_DONE once the robot faces the beacon or the sweep
+     saw none
 
  Description
-     Drive reverse at half speed (open-loop).
+     Turns a whole sweep, the way round the pending command gives, binning
+     each sighting at its heading. Then turns back the short way to the
+     peak, at the slower speed
 
  Author
-     Tianyu, 02/03/26
+     Tianyu, 10/14/26
 ****************************************************************************/
-static void DriveReverseHalf(void)
+static ES_CoStatus_t AlignWithBeacon(ES_Co_t *pCo, ES_Event_t ThisEvent)
 {
-  // Pseudocode:
-  // MotorCommandWrapper(HALF_SPEED, HALF_SPEED, REVERSE, REVERSE)
-  // Optionally set SIMPLE_MOVE_TIMER
-  MotorCommandWrapper(HALF_SPEED, HALF_SPEED, REVERSE, REVERSE);
+  ES_CO_BEGIN(pCo);
+
+  BeaconBearing_StartSweep();
+  SpeedControl_StartMove((FP_Q16_t)pPendingCommand->Speed,
+      (FP_Q16_t)pPendingCommand->Speed, pPendingCommand->DirLeft,
+      pPendingCommand->DirRight, BEARING_SWEEP_CAPTURES);
+  do
+  {
+    ES_CO_AWAIT(pCo, (ThisEvent.EventType == ES_BEACON_DETECTED) ||
+        (ThisEvent.EventType == ES_MOVE_COMPLETE));
+    if (ThisEvent.EventType == ES_BEACON_DETECTED)
+    {
+      uint8_t  Strength = BEACON_PARAM_CONFIDENCE(ThisEvent.EventParam);
+      uint32_t EdgeTime;
+
+      // the pin's events give no confidence, every edge counts the same
+      if (BeaconDetect_TakeSighting(ThisEvent, &EdgeTime))
+      {
+        BeaconBearing_AddSighting(Strength != 0 ? Strength :
+            BEARING_FULL_STRENGTH, EdgeTime);
+      }
+    }
+  } while (ThisEvent.EventType != ES_MOVE_COMPLETE);
+
+  if (!PlanReturnToBeacon())
+  {
+    ES_CO_EXIT(pCo);
+  }
+  if (ReturnCaptures != 0)
+  {
+    SpeedControl_StartMove((FP_Q16_t)BEACON_RETURN_RPM,
+        (FP_Q16_t)BEACON_RETURN_RPM, ReturnDirLeft, ReturnDirRight,
+        ReturnCaptures);
+    ES_CO_AWAIT_EVENT(pCo, ThisEvent, ES_MOVE_COMPLETE);
+    LOG_INFO("Found beacon\r\n");
+  }
+
+  ES_CO_END(pCo);
 }
 
+/*----------------------------- Helper Functions --------------------------*/
 /****************************************************************************
  Function
-     DriveReverseFull
+     StartCommandMove
 
  Parameters
-     None
+     uint8_t BackstopTimer - timer for the command's backstop
 
  Returns
      None
 
  Description
-     Drive reverse at full speed (open-loop).
+     Starts the wheels as the pending command's CommandTable entry says,
+     and its backstop timer if it has one. A turn ends when the wheels
+     cover its distance, the timer is only a backstop. The speed is scaled
+     by the SPEEDPCT parameter & a turn's distance by TURNTRIM.
 
  Author
-     Tianyu, 02/03/26
+     Tianyu, 10/14/26
 ****************************************************************************/
-static void DriveReverseFull(void)
+static void StartCommandMove(uint8_t BackstopTimer)
 {
-  // Pseudocode:
-  // MotorCommandWrapper(FULL_SPEED, FULL_SPEED, REVERSE, REVERSE)
-  // Optionally set SIMPLE_MOVE_TIMER
-  MotorCommandWrapper(FULL_SPEED, FULL_SPEED, REVERSE, REVERSE);
+  uint32_t Speed;
+  uint32_t Distance = pPendingCommand->Distance;
+
+  // SPEEDPCT is at most 100, so this is well inside 32 bits
+  Speed = (pPendingCommand->Speed * ParamStore_Get(PARAM_ID(SPEEDPCT))) /
+      100;
+  if (Distance != SPEED_CONTROL_NO_LIMIT)
+  {
+    Distance = (Distance * ParamStore_Get(PARAM_ID(TURNTRIM)) + 500) / 1000;
+  }
+  SpeedControl_StartMove((FP_Q16_t)Speed, (FP_Q16_t)Speed,
+      pPendingCommand->DirLeft, pPendingCommand->DirRight, Distance);
+  if (pPendingCommand->BackstopMs != 0)
+  {
+    ES_Timer_InitTimer(BackstopTimer, pPendingCommand->BackstopMs);
+  }
 }
 
 /****************************************************************************
  Function
-     SearchForTape
+     FollowLine
 
  Parameters
-     None
+     int16_t Position - line position from TapeArray_GetPosition
 
  Returns
      None
 
  Description
-     Drive forward until tape detected or timeout.
+     Drives forward, speeding up the wheel on the side the line is on so
+     the robot turns back over it
 
  Author
-     Tianyu, 02/03/26
+     Tianyu, 10/14/26
 ****************************************************************************/
-static void SearchForTape(void)
+static void FollowLine(int16_t Position)
 {
-  // Pseudocode:
-  // MotorCommandWrapper(FULL_SPEED, FULL_SPEED, FORWARD, FORWARD)
-  // Initialize TAPE_SEARCH_TIMER
-  MotorCommandWrapper(FULL_SPEED, FULL_SPEED, FORWARD, FORWARD);
-//  ES_Timer_InitTimer(TAPE_SEARCH_TIMER, TAPE_SEARCH_MS);
+  int32_t steer = ((int32_t)Position * (int32_t)LINE_STEER_PER_MM) >>
+      TAPE_POSITION_SHIFT;
+
+  // never ask a wheel to go backwards
+  if (steer > (int32_t)LINE_SPEED_RPM)
+  {
+    steer = (int32_t)LINE_SPEED_RPM;
+  }
+  else if (steer < -(int32_t)LINE_SPEED_RPM)
+  {
+    steer = -(int32_t)LINE_SPEED_RPM;
+  }
+  SpeedControl_StartMove((FP_Q16_t)((int32_t)LINE_SPEED_RPM + steer),
+      (FP_Q16_t)((int32_t)LINE_SPEED_RPM - steer), FORWARD, FORWARD,
+      SPEED_CONTROL_NO_LIMIT);
 }
 
 /****************************************************************************
  Function
-     AlignWithBeacon
+     PlanReturnToBeacon
 
  Parameters
      None
 
  Returns
-     None
+     bool, false if the sweep saw no beacon
 
  Description
-     Spin until beacon detected or timeout.
+     Works out the turn from where the sweep stopped back to its peak, the
+     short way round, into ReturnDirLeft, ReturnDirRight & ReturnCaptures
 
  Author
-     Tianyu, 02/03/26
+     Tianyu, 10/14/26
 ****************************************************************************/
-static void AlignWithBeacon(void)
+static bool PlanReturnToBeacon(void)
 {
-  // Pseudocode:
-  // MotorCommandWrapper(FULL_SPEED, FULL_SPEED, FORWARD, REVERSE)
-  // Initialize BEACON_ALIGN_TIMER
-  MotorCommandWrapper(FULL_SPEED, FULL_SPEED, FORWARD, REVERSE);
-  ES_Timer_InitTimer(BEACON_ALIGN_TIMER, BEACON_ALIGN_MS);
+  uint32_t Peak;
+  uint32_t Delta;
+
+  if (!BeaconBearing_GetPeak(&Peak))
+  {
+    LOG_WARN("Beacon Search Failed: %u sightings\r\n",
+        BeaconBearing_GetSightings());
+    return false;
+  }
+  // the way on from where the sweep stopped, then the short way round
+  Delta = (Peak + BEARING_SWEEP_CAPTURES -
+      (BeaconBearing_GetHeading() % BEARING_SWEEP_CAPTURES)) %
+      BEARING_SWEEP_CAPTURES;
+  if (Delta <= (BEARING_SWEEP_CAPTURES / 2))
+  {
+    ReturnDirLeft = pPendingCommand->DirLeft;
+    ReturnDirRight = pPendingCommand->DirRight;
+    ReturnCaptures = Delta;
+  }
+  else
+  {
+    ReturnDirLeft = (pPendingCommand->DirLeft == FORWARD) ? REVERSE : FORWARD;
+    ReturnDirRight = (pPendingCommand->DirRight == FORWARD) ? REVERSE : FORWARD;
+    ReturnCaptures = BEARING_SWEEP_CAPTURES - Delta;
+  }
+  LOG_INFO("Beacon at %u of %u, back %u\r\n", Peak,
+      (uint32_t)BEARING_SWEEP_CAPTURES, ReturnCaptures);
+  return true;
 }
@@ -0,0 +1,162 @@
+/****************************************************************************
+ Module
+   MotionProfile.c
+
+ Revision
+   0.1
+
+ Description
+   Trapezoidal speed profiles for the wheel moves, see MotionProfile.h.
+
+ Notes
+   The speed a wheel can still stop from with d revolutions to go is
+   sqrt(2 a d). In RPM, with a in RPM per second & d in captures, that is
+
+     v = sqrt(120 a d / IC_ENCODER_EDGES_PER_REV)
+
+   STOP_SQUARE_PER_CAPTURE_Q16 is everything under the root but d, in
+   Q16.16, so the root is one multiply & FP_Sqrt, which gives the speed in
+   Q8.8. Nothing here divides at run time.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "MotionProfile.h"
+#include "SpeedControlService.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// the change in setpoint each step
+#define ACCEL_STEP_Q16 \
+  ((FP_Q16_t)(((uint64_t)PROFILE_ACCEL_RPM_PER_S << FP_Q16_SHIFT) / \
+      PROFILE_RATE_HZ))
+
+// v^2 in RPM^2, Q16.16, for each capture still to go
+#define STOP_SQUARE_PER_CAPTURE_Q16 \
+  ((uint32_t)(((uint64_t)2 * SECONDS_PER_MINUTE * PROFILE_ACCEL_RPM_PER_S << \
+      FP_Q16_SHIFT) / IC_ENCODER_EDGES_PER_REV))
+
+// the root of a Q16.16 square is Q8.8
+#define ROOT_TO_Q16_SHIFT (FP_Q16_SHIFT / 2)
+
+#if ((2 * SECONDS_PER_MINUTE * PROFILE_ACCEL_RPM_PER_S) << FP_Q16_SHIFT) < \
+    IC_ENCODER_EDGES_PER_REV
+#error "PROFILE_ACCEL_RPM_PER_S is too small to brake with"
+#endif
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     MotionProfile_Start
+
+ Parameters
+     MotionProfile_t *pProfile - the wheel's profile
+     FP_Q16_t Cruise - speed for the move, RPM in Q16.16
+     uint32_t Goal - captures for the move, or SPEED_CONTROL_NO_LIMIT
+     FP_Q16_t From - the speed the wheel is already going in the move's
+                     direction, 0 from a stop or a reversal
+
+ Returns
+     None
+
+ Description
+     Starts a new move on the profile. Going on from From means one move
+     hands over to the next without slowing down in between
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void MotionProfile_Start(MotionProfile_t *pProfile, FP_Q16_t Cruise,
+                         uint32_t Goal, FP_Q16_t From)
+{
+  pProfile->Cruise = Cruise;
+  pProfile->Goal = Goal;
+  pProfile->Setpoint = From;
+}
+
+/****************************************************************************
+ Function
+     MotionProfile_Step
+
+ Parameters
+     MotionProfile_t *pProfile - the wheel's profile
+     uint32_t Captures - the wheel's distance so far in the move
+
+ Returns
+     FP_Q16_t - the speed for this control loop pass
+
+ Description
+     Moves the setpoint one step toward the cruise speed, then holds it
+     under the speed the wheel can still stop from
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+FP_Q16_t MotionProfile_Step(MotionProfile_t *pProfile, uint32_t Captures)
+{
+  FP_Q16_t Setpoint = pProfile->Setpoint;
+  FP_Q16_t Cruise = pProfile->Cruise;
+
+  if (Setpoint < Cruise)
+  {
+    Setpoint = ((Cruise - Setpoint) > ACCEL_STEP_Q16) ?
+        (Setpoint + ACCEL_STEP_Q16) : Cruise;
+  }
+  else if (Setpoint > Cruise)
+  {
+    Setpoint = ((Setpoint - Cruise) > ACCEL_STEP_Q16) ?
+        (Setpoint - ACCEL_STEP_Q16) : Cruise;
+  }
+
+  if (pProfile->Goal != SPEED_CONTROL_NO_LIMIT)
+  {
+    uint32_t Remaining = (Captures < pProfile->Goal) ?
+        (pProfile->Goal - Captures) : 0;
+    FP_Q16_t StopSpeed = MotionProfile_StopSpeed(Remaining);
+
+    if (Setpoint > StopSpeed)
+    {
+      Setpoint = StopSpeed;
+    }
+    // a wheel held at 0 short of the goal would never get there
+    if ((Setpoint < PROFILE_END_RPM) && (Cruise != 0))
+    {
+      Setpoint = PROFILE_END_RPM;
+    }
+  }
+  pProfile->Setpoint = Setpoint;
+  return Setpoint;
+}
+
+/****************************************************************************
+ Function
+     MotionProfile_StopSpeed
+
+ Parameters
+     uint32_t Remaining - captures to go
+
+ Returns
+     FP_Q16_t - the fastest the wheel can be going & still stop in them at
+     PROFILE_ACCEL_RPM_PER_S
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+FP_Q16_t MotionProfile_StopSpeed(uint32_t Remaining)
+{
+  uint64_t Square = (uint64_t)Remaining * STOP_SQUARE_PER_CAPTURE_Q16;
+
+  // far enough out that the root is past any speed the wheels can do
+  if (Square > UINT32_MAX)
+  {
+    Square = UINT32_MAX;
+  }
+  return FP_Sqrt((uint32_t)Square) << ROOT_TO_Q16_SHIFT;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
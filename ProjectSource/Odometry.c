@@ -0,0 +1,175 @@
+/****************************************************************************
+ Module
+   Odometry.c
+
+ Revision
+   0.1
+
+ Description
+   Dead reckoning of the robot's pose from the wheel odometers, stepped
+   from the speed control loop at ODOMETRY_RATE_HZ.
+
+ Notes
+   Each step takes the captures each wheel has moved since the last one.
+   Their sum is the distance the middle of the axle moved & their
+   difference the turn, & the move is taken as a straight line at the
+   heading halfway through the turn, which is as good as an arc for the
+   few degrees a step turns. The trig is FP_Sin & FP_Cos, no floats.
+
+   The pose is only written by Odometry_Step, in the control loop ISR, or
+   by Odometry_SetPose with that ISR locked out. Each write is bracketed by
+   two counts of Sequence, odd while the write is going on, so a reader
+   that sees it change or odd knows it was interrupted & reads again. The
+   loop never waits on a reader.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "Odometry.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+
+/*---------------------------- Module Functions ---------------------------*/
+
+/*---------------------------- Module Variables ---------------------------*/
+static volatile Pose_t   Pose;
+static volatile uint32_t Sequence;
+// the odometers at the last step
+static int32_t LastLeft;
+static int32_t LastRight;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     Odometry_Init
+
+ Parameters
+     int32_t OdometerLeft, OdometerRight - each wheel's odometer now
+
+ Returns
+     None
+
+ Description
+     Starts the pose at 0, 0 heading 0, from the odometers as they are.
+     Call before the control loop starts stepping it
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void Odometry_Init(int32_t OdometerLeft, int32_t OdometerRight)
+{
+  LastLeft = OdometerLeft;
+  LastRight = OdometerRight;
+  Sequence = 0;
+  Pose.X = 0;
+  Pose.Y = 0;
+  Pose.Heading = 0;
+}
+
+/****************************************************************************
+ Function
+     Odometry_Step
+
+ Parameters
+     int32_t OdometerLeft, OdometerRight - each wheel's odometer now
+
+ Returns
+     None
+
+ Description
+     Moves the pose on by the captures since the last step. Called from the
+     control loop ISR at ODOMETRY_RATE_HZ
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void Odometry_Step(int32_t OdometerLeft, int32_t OdometerRight)
+{
+  int32_t    Left = OdometerLeft - LastLeft;
+  int32_t    Right = OdometerRight - LastRight;
+  int32_t    Distance;
+  int32_t    Turn;
+  FP_Angle_t Midway;
+
+  // standing still, don't disturb the readers
+  if ((Left == 0) && (Right == 0))
+  {
+    return;
+  }
+  LastLeft = OdometerLeft;
+  LastRight = OdometerRight;
+
+  Distance = (Left + Right) * ODOMETRY_HALF_MM_PER_CAPTURE_Q16;
+  Turn = (Right - Left) * ODOMETRY_HEADING_PER_CAPTURE;
+  Midway = ODOMETRY_HEADING_TO_ANGLE(Pose.Heading + (uint32_t)(Turn / 2));
+
+  Sequence++;
+  Pose.X += (int32_t)(((int64_t)Distance * FP_Cos(Midway)) >> FP_Q16_SHIFT);
+  Pose.Y += (int32_t)(((int64_t)Distance * FP_Sin(Midway)) >> FP_Q16_SHIFT);
+  Pose.Heading += (uint32_t)Turn;
+  Sequence++;
+}
+
+/****************************************************************************
+ Function
+     Odometry_GetPose
+
+ Parameters
+     Pose_t *pPose - filled in with the latest pose
+
+ Returns
+     None
+
+ Description
+     Copies the pose without locking the control loop out, going again if
+     a step came in part way through the copy. Not from an ISR at or above
+     the control loop's IPL, which the step could never finish under
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void Odometry_GetPose(Pose_t *pPose)
+{
+  uint32_t Before;
+
+  do
+  {
+    Before = Sequence;
+    pPose->X = Pose.X;
+    pPose->Y = Pose.Y;
+    pPose->Heading = Pose.Heading;
+  } while ((Before & 1) || (Before != Sequence));
+}
+
+/****************************************************************************
+ Function
+     Odometry_SetPose
+
+ Parameters
+     const Pose_t *pPose - where the robot is now
+
+ Returns
+     None
+
+ Description
+     Moves the pose to a known one, such as a line or a beacon's bearing.
+     The steps carry on from there
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void Odometry_SetPose(const Pose_t *pPose)
+{
+  EnterCritical();
+  Sequence++;
+  Pose.X = pPose->X;
+  Pose.Y = pPose->Y;
+  Pose.Heading = pPose->Heading;
+  Sequence++;
+  ExitCritical();
+}
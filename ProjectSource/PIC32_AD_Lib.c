@@ -7,12 +7,23 @@
      This is a module implementing  the basic functions to use the A/D 
 	 converter on the PIC32MX170F256B
  Notes
+    Polled use is ADC_ConfigAutoScan then ADC_MultiRead whenever a reading
+    is wanted. For streaming, ADC_ConfigStreaming sets the conversion clock
+    so that the scan set repeats at a fixed rate, and the ADC interrupt
+    copies every set into one of two blocks of ADC_STREAM_BLOCK_SETS sets.
+    When a block fills, the ISR switches to the other one and calls the
+    block ready function. The block belongs to the caller from
+    ADC_GetBlock until ADC_ReleaseBlock; if the next block fills before
+    that, it is refilled in place and counted as an overrun, so conversion
+    never stops to wait on the reader.
 
 
  History
  When           Who     What/Why
  -------------- ---     --------
-
+ 10/14/26 21:30 ty      ADC_StreamISR reports to ES_IsrStats
+ 10/14/26 17:40 ty      added ADC_ConfigStreaming, ping-pong blocks filled
+                        from the ADC interrupt
  11/03/20 14:55 jec     cleaned up typos and clarified a comment
  10/27/20 16:10 jec     cleaned up the documentation to meet SPDL Standards
  10/20/20 16:38 jec     Began Coding
@@ -20,7 +31,10 @@
 /*----------------------------- Include Files -----------------------------*/
 #include "PIC32_AD_Lib.h"
 #include <xc.h>
+#include <sys/attribs.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "ES_IsrStats.h"
 
 /*--------------------------- External Variables --------------------------*/
 
@@ -28,6 +42,15 @@
 //  We configure the A/D to use 2 8-word buffers, so it is limited to 
 //  converting 8 channels. 
 #define MAX_CHANNELS 8
+// the standard PBClk rate for ME218
+#define PBCLK_RATE 20000000L
+// a 10 bit conversion takes 12 TAD after the sample time
+#define CONVERSION_TADS 12
+// largest sample time, in TAD, that fits in SAMC
+#define MAX_SAMPLE_TADS 31
+// TAD = 2 * (ADCS + 1) * TPB, must be at least 200nS, 4 TPB at 20MHz
+#define MIN_TAD_DIV 2
+#define MAX_TAD_DIV 256
 /*------------------------------ Module Types -----------------------------*/
 
 /*---------------------------- Module Functions ---------------------------*/
@@ -36,6 +59,16 @@ static uint8_t CountBits(uint16_t num2Count);
 /*---------------------------- Module Variables ---------------------------*/
 static uint8_t numChanInSet;   // used to iterate in read requests
 
+// streaming state, the ISR fills StreamBlocks[fillBlock] one set at a time
+static bool streaming = false;
+static uint16_t StreamBlocks[2][ADC_STREAM_BLOCK_SETS * MAX_CHANNELS];
+static uint8_t fillBlock;
+static uint8_t setsFilled;
+static volatile bool blockReady;   // the other block is full, not released
+static volatile uint16_t overruns;
+static const uint16_t * volatile pLatestSet;
+static ADC_BlockReadyFunc_t BlockReadyFunc;
+
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
  Function
@@ -66,6 +99,9 @@ bool ADC_ConfigAutoScan( uint16_t whichPins){
   }else // OK, looks good
   {
     AD1CON1bits.ON = 0; // disable ADC
+    // back to polled use if we had been streaming
+    IEC0CLR = _IEC0_AD1IE_MASK;
+    streaming = false;
  
     // AD1CON1<2>, ASAM     : 1 = Sampling begins immediately after last conversion completes
 	  // AD1CON1<4>, CLRASAM : 0 = buffer contents will be overwritten by the next conversion sequence
@@ -90,6 +126,8 @@ bool ADC_ConfigAutoScan( uint16_t whichPins){
     // AD1CON2 = 0x0402;    // to set everything above in one fell swoop
  
     // AD2CON2<5:2>, SMPI  : Interrupt flag set at after numChanInSet completed conversions
+    // (cleared first, the SET would otherwise OR in the last call's count)
+    AD1CON2bits.SMPI = 0;
     AD1CON2SET = (numChanInSet-1) << 2;
  
     // AD1CON3<7:0>, ADCS  : 1 = TPB * 2 * (ADCS<7:0> + 1) = 4 * TPB = TAD
@@ -135,6 +173,18 @@ uint8_t i;
 uint32_t LocalResult;
 volatile uint32_t *resultSet;
 
+if (streaming)
+{
+  // the ISR owns the result buffers, use the last set it copied out
+  IEC0CLR = _IEC0_AD1IE_MASK;
+  for (i=0; i < numChanInSet; i++)
+  {
+    adcResults[i] = (NULL == pLatestSet) ? 0 : pLatestSet[i];
+  }
+  IEC0SET = _IEC0_AD1IE_MASK;
+  return;
+}
+
 // stop automatic sampling during the read to be sure we get a coherent set
 AD1CON1bits.ASAM = 0;  
 
@@ -156,6 +206,214 @@ AD1CON1bits.ASAM = 1;  // restart automatic sampling
 IFS0CLR = _IFS0_AD1IF_MASK;  // clear ADC interrupt flag, see table 7-1, pg 68
 }
 
+/****************************************************************************
+ Function
+    ADC_ConfigStreaming
+ Parameters
+    uint16_t whichPins specifies which of the ANx pins will be converted,
+        as for ADC_ConfigAutoScan
+    uint16_t setRateHz how many times a second to convert the whole set
+    ADC_BlockReadyFunc_t blockReadyFunc called from the ISR each time a
+        block fills, even if the reader still has the last one, may be
+        NULL to poll ADC_GetBlock
+ Returns
+    bool true if no errors, false if there are too many pins or the rate
+        can't be reached with the ADC clock settings
+ Description
+    configures the A/D converter to scan the set continuously at a fixed
+    rate and stream the results into blocks from the ADC interrupt
+ Notes
+    The rate comes from the sample time & TAD, so it is only accurate to
+    a few percent. With 20MHz PBClk, one channel can run from about 900Hz
+    to about 190kHz, the range scales down with the number of channels.
+ Author
+    Tianyu, 10/14/26 17:40
+****************************************************************************/
+bool ADC_ConfigStreaming( uint16_t whichPins, uint16_t setRateHz,
+                          ADC_BlockReadyFunc_t blockReadyFunc)
+{
+  uint32_t convTicks;   // PBClk ticks for each conversion
+  uint32_t tadDiv;      // 2 * (ADCS + 1)
+  uint32_t tadsPerConv;
+
+  if ((0 == setRateHz) || (0 == CountBits(whichPins)) ||
+      (false == ADC_ConfigAutoScan(whichPins)))
+  {
+    return false;
+  }
+  convTicks = PBCLK_RATE / ((uint32_t)setRateHz * numChanInSet);
+  // the smallest TAD that lets the sample time fit in SAMC
+  tadDiv = (convTicks + (2 * (MAX_SAMPLE_TADS + CONVERSION_TADS)) - 1) /
+      (2 * (MAX_SAMPLE_TADS + CONVERSION_TADS));
+  if (MIN_TAD_DIV > tadDiv)
+  {
+    tadDiv = MIN_TAD_DIV;
+  }
+  tadsPerConv = convTicks / (2 * tadDiv);
+  if ((MAX_TAD_DIV < tadDiv) || (CONVERSION_TADS >= tadsPerConv))
+  {
+    return false;
+  }
+
+  AD1CON1bits.ON = 0; // disable ADC while we change the clock
+  AD1CON3bits.ADCS = tadDiv - 1;
+  AD1CON3bits.SAMC = tadsPerConv - CONVERSION_TADS;
+
+  fillBlock = 0;
+  setsFilled = 0;
+  blockReady = false;
+  overruns = 0;
+  pLatestSet = NULL;
+  BlockReadyFunc = blockReadyFunc;
+  streaming = true;
+
+  // interrupt once per set, SMPI was set by ADC_ConfigAutoScan
+  IFS0CLR = _IFS0_AD1IF_MASK;
+  IPC7bits.AD1IP = ADC_STREAM_PRIORITY;
+  IPC7bits.AD1IS = 0;
+  IEC0SET = _IEC0_AD1IE_MASK;
+
+  AD1CON1bits.ON = 1; // enable ADC
+  return true;
+}
+
+/****************************************************************************
+ Function
+    ADC_GetBlock
+ Parameters
+    None
+ Returns
+    const uint16_t * the oldest complete block, or NULL if there isn't one.
+        Set s of the block starts at [s * number of channels], lowest
+        numbered channel first
+ Description
+    Hands a complete block to the caller, it stays valid until
+    ADC_ReleaseBlock
+ Author
+    Tianyu, 10/14/26 17:40
+****************************************************************************/
+const uint16_t *ADC_GetBlock(void)
+{
+  // fillBlock only changes when blockReady goes from false to true
+  return blockReady ? StreamBlocks[fillBlock ^ 1] : NULL;
+}
+
+/****************************************************************************
+ Function
+    ADC_ReleaseBlock
+ Parameters
+    None
+ Returns
+    nothing
+ Description
+    Gives the block from ADC_GetBlock back to the ISR
+ Author
+    Tianyu, 10/14/26 17:40
+****************************************************************************/
+void ADC_ReleaseBlock(void)
+{
+  blockReady = false;
+}
+
+/****************************************************************************
+ Function
+    ADC_AverageBlock
+ Parameters
+    const uint16_t *pBlock a block from ADC_GetBlock
+    uint32_t *adcResults pointer to array to hold the averages, as for
+        ADC_MultiRead
+ Returns
+    nothing
+ Description
+    Averages each channel over all of the sets in the block
+ Author
+    Tianyu, 10/14/26 17:40
+****************************************************************************/
+void ADC_AverageBlock(const uint16_t *pBlock, uint32_t *adcResults)
+{
+  uint8_t i;
+  uint8_t set;
+  uint32_t sum;
+
+  for (i = 0; i < numChanInSet; i++)
+  {
+    sum = 0;
+    for (set = 0; set < ADC_STREAM_BLOCK_SETS; set++)
+    {
+      sum += pBlock[(set * numChanInSet) + i];
+    }
+    // round to nearest
+    adcResults[i] = (sum + (ADC_STREAM_BLOCK_SETS / 2)) >> ADC_STREAM_BLOCK_SHIFT;
+  }
+}
+
+/****************************************************************************
+ Function
+    ADC_GetOverruns
+ Parameters
+    None
+ Returns
+    uint16_t how many blocks have been refilled because the last one had
+        not been released yet
+ Author
+    Tianyu, 10/14/26 17:40
+****************************************************************************/
+uint16_t ADC_GetOverruns(void)
+{
+  return overruns;
+}
+
+/****************************************************************************
+ Function
+    ADC_StreamISR
+ Parameters
+    None
+ Returns
+    nothing
+ Description
+    Runs once per scan set, copies the set from the half of the result
+    buffer that the ADC just finished into the current block
+ Author
+    Tianyu, 10/14/26 17:40
+****************************************************************************/
+void __ISR(_ADC_VECTOR, IPL3SOFT) ADC_StreamISR(void)
+{
+  uint8_t i;
+  volatile uint32_t *resultSet;
+  uint16_t *pSet;
+
+  ES_IsrStats_Enter(ES_ISR(ADCStream), ES_ISR_LATENCY_UNKNOWN);
+  // same buffer choice as ADC_MultiRead
+  resultSet = (AD1CON2bits.BUFS == 1) ? &ADC1BUF0 : &ADC1BUF8;
+  pSet = &StreamBlocks[fillBlock][setsFilled * numChanInSet];
+  for (i = 0; i < numChanInSet; i++)
+  {
+    pSet[i] = (uint16_t)*(resultSet + (4 * i));
+  }
+  IFS0CLR = _IFS0_AD1IF_MASK;
+  pLatestSet = pSet;
+
+  if (ADC_STREAM_BLOCK_SETS == ++setsFilled)
+  {
+    setsFilled = 0;
+    if (blockReady)
+    {
+      // the reader still has the other block, write over this one
+      overruns++;
+    }else
+    {
+      fillBlock ^= 1;
+      blockReady = true;
+    }
+    // on an overrun too, in case the last notice was lost
+    if (NULL != BlockReadyFunc)
+    {
+      BlockReadyFunc();
+    }
+  }
+  ES_IsrStats_Exit(ES_ISR(ADCStream));
+}
+
 // count the number of bits set in v. Algorithm from K&R 
 static uint8_t CountBits(uint16_t num2Count)
 {
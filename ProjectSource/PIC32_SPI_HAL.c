@@ -8,13 +8,20 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+  10/14/26 22:40 ty     added the DMA transfers, SPIOperate_Transfer
   10/14/25 00:00 klg    added SPIOperate_HasSS1_Risen code
   10/03/21 12:32 jec    started coding
 *****************************************************************************/
 /*----------------------------- Include Files -----------------------------*/
 #include <xc.h>
+#include <sys/kmem.h>   // for KVA_TO_PA
+#include <sys/attribs.h>
 #include <stdbool.h> 
+#include <stddef.h>
+#include <string.h>
 #include "PIC32_SPI_HAL.h"
+#include "ES_IsrStats.h"
+#include "terminal.h"
 
 /*--------------------------- External Variables --------------------------*/
 
@@ -26,9 +33,49 @@
 #define MAP_SDO1 0b0011
 #define MAP_SDO2 0b0100
 
+// DMA channel priorities, the receive side must keep up with the transmit
+#define DMA_RX_PRIORITY 3
+#define DMA_TX_PRIORITY 2
+// SPIxCON interrupt modes for a DMA transfer
+#define SPI_RX_NOT_EMPTY 0b01
+#define SPI_TX_EMPTY 0b01
 
 
 /*------------------------------ Module Types -----------------------------*/
+// the registers of a DMA channel
+typedef struct
+{
+  volatile uint32_t *pCON;
+  volatile uint32_t *pECON;
+  volatile uint32_t *pECONSET;
+  volatile uint32_t *pINT;
+  volatile uint32_t *pSSA;
+  volatile uint32_t *pDSA;
+  volatile uint32_t *pSSIZ;
+  volatile uint32_t *pDSIZ;
+  volatile uint32_t *pCSIZ;
+} DMAChannel_t;
+
+// how a module's transfers are wired, indexed by SPI_Module_t
+typedef struct
+{
+  uint8_t  RxChannel;
+  uint8_t  TxChannel;
+  uint8_t  RxIRQ;
+  uint8_t  TxIRQ;
+  uint32_t SPIRxIntMask;    // the module's receive IFS1/IEC1 bit
+  uint32_t DoneIntMask;     // the receive channel's IFS1/IEC1 bit
+} DMAPair_t;
+
+// what a transfer changed, put back when it is done
+typedef struct
+{
+  SPI_XferDoneFunc_t pDoneFunc;
+  volatile bool      IsBusy;
+  bool               WasRxIntOn;
+  uint8_t            OldRxISEL;
+  uint8_t            OldTxISEL;
+} XferState_t;
 
 /*---------------------------- Module Functions ---------------------------*/
 static void selectModuleRegisters(SPI_Module_t WhichModule);
@@ -37,6 +84,8 @@ static bool isSS_OutputPinLegal(SPI_Module_t WhichModule,
                                 SPI_PinMap_t WhichPin);
 static bool isSDOPinLegal( SPI_PinMap_t WhichPin);
 static uint8_t isSDIPinLegal( SPI_Module_t WhichModule, SPI_PinMap_t WhichPin);
+static void discardReceived(SPI_Module_t WhichModule);
+static void finishTransfer(SPI_Module_t WhichModule);
 
 /*---------------------------- Module Variables ---------------------------*/
   // these will allow us to reference both SPI1 & SPI2 through these pointers
@@ -119,6 +168,21 @@ static SPI_PinMap_t const LegalSDOxPins[] = { SPI_NO_PIN, SPI_RPA1, SPI_RPA2,
                                               SPI_RPB11, SPI_RPB13 
 };
 
+#define DMA_CHANNEL_REGS(n) { &DCH##n##CON, &DCH##n##ECON, &DCH##n##ECONSET, \
+  &DCH##n##INT, &DCH##n##SSA, &DCH##n##DSA, &DCH##n##SSIZ, &DCH##n##DSIZ,     \
+  &DCH##n##CSIZ }
+// indexed by channel number
+static const DMAChannel_t DMAChannels[] = { DMA_CHANNEL_REGS(0),
+  DMA_CHANNEL_REGS(1), DMA_CHANNEL_REGS(2), DMA_CHANNEL_REGS(3)
+};
+
+static const DMAPair_t DMAPairs[] = {
+  { 1, 2, _SPI1_RX_IRQ, _SPI1_TX_IRQ, _IEC1_SPI1RXIE_MASK, _IEC1_DMA1IE_MASK },
+  { 3, 0, _SPI2_RX_IRQ, _SPI2_TX_IRQ, _IEC1_SPI2RXIE_MASK, _IEC1_DMA3IE_MASK }
+};
+
+static XferState_t XferStates[2];
+
 /*------------------------------ Module Code ------------------------------*/
 
 
@@ -743,10 +807,226 @@ bool SPIOperate_HasSS2_Risen(void)
   // not needed for ME218a
 }
 
+/****************************************************************************
+ Function
+    SPIOperate_Transfer
+
+ Description
+   Sets the receive channel to move each word from SPIxBUF into the receive
+   buffer & the transmit channel to move a word from the transmit buffer to
+   SPIxBUF each time it empties, then forces the first word out. With no
+   transmit data, the receive buffer is filled with SPI_TRANSFER_FILL & sent
+   from, each word goes out before the one received in its place comes in.
+****************************************************************************/
+bool SPIOperate_Transfer(SPI_Module_t WhichModule, const void *pTxData,
+                         void *pRxData, uint16_t Length,
+                         SPI_XferDoneFunc_t pDoneFunc)
+{
+  const DMAPair_t *pPair;
+  const DMAChannel_t *pRx;
+  const DMAChannel_t *pTx;
+  XferState_t *pState;
+  uint8_t WordBytes;
+
+  if (!isSPI_ModuleLegal(WhichModule) || (NULL == pRxData) || (0 == Length))
+  {
+    return false;
+  }
+#ifdef TERMINAL_DMA_TX
+  if (SPI_SPI2 == WhichModule)
+  {
+    return false;   // DCH0 is sending the terminal's output
+  }
+#endif
+  pState = &XferStates[WhichModule];
+  if (pState->IsBusy)
+  {
+    return false;
+  }
+  selectModuleRegisters(WhichModule);
+  WordBytes = pSPICON->MODE32 ? 4 : (pSPICON->MODE16 ? 2 : 1);
+  if (0 != (Length % WordBytes))
+  {
+    return false;
+  }
+  if (NULL == pTxData)
+  {
+    memset(pRxData, SPI_TRANSFER_FILL, Length);
+    pTxData = pRxData;
+  }
+  pPair = &DMAPairs[WhichModule];
+  pRx = &DMAChannels[pPair->RxChannel];
+  pTx = &DMAChannels[pPair->TxChannel];
+
+  // the module's own ISR would take the words from the DMA
+  pState->WasRxIntOn = (0 != (IEC1 & pPair->SPIRxIntMask));
+  IEC1CLR = pPair->SPIRxIntMask;
+  discardReceived(WhichModule);
+  pState->OldRxISEL = pSPICON->SRXISEL;
+  pState->OldTxISEL = pSPICON->STXISEL;
+  pSPICON->SRXISEL = SPI_RX_NOT_EMPTY;
+  pSPICON->STXISEL = SPI_TX_EMPTY;
+  pState->pDoneFunc = pDoneFunc;
+  pState->IsBusy = true;
+
+  DMACONSET = _DMACON_ON_MASK;
+  *pRx->pCON  = DMA_RX_PRIORITY;    // channel off while it is set up
+  *pRx->pECON = ((uint32_t)pPair->RxIRQ << _DCH0ECON_CHSIRQ_POSITION) |
+                _DCH0ECON_SIRQEN_MASK;
+  *pRx->pSSA  = KVA_TO_PA(pSPIBUF);
+  *pRx->pDSA  = KVA_TO_PA(pRxData);
+  *pRx->pSSIZ = WordBytes;
+  *pRx->pDSIZ = Length;
+  *pRx->pCSIZ = WordBytes;
+  *pRx->pINT  = _DCH0INT_CHBCIE_MASK;  // flags clear, interrupt at the end
+
+  *pTx->pCON  = DMA_TX_PRIORITY;
+  *pTx->pECON = ((uint32_t)pPair->TxIRQ << _DCH0ECON_CHSIRQ_POSITION) |
+                _DCH0ECON_SIRQEN_MASK;
+  *pTx->pSSA  = KVA_TO_PA(pTxData);
+  *pTx->pDSA  = KVA_TO_PA(pSPIBUF);
+  *pTx->pSSIZ = Length;
+  *pTx->pDSIZ = WordBytes;
+  *pTx->pCSIZ = WordBytes;
+  *pTx->pINT  = 0;
+
+  if (SPI_SPI1 == WhichModule)
+  {
+    IPC9bits.DMA1IP = SPI_TRANSFER_PRIORITY;
+    IPC9bits.DMA1IS = 0;
+  }else
+  {
+    IPC9bits.DMA3IP = SPI_TRANSFER_PRIORITY;
+    IPC9bits.DMA3IS = 0;
+  }
+  IFS1CLR = pPair->DoneIntMask;
+  IEC1SET = pPair->DoneIntMask;
+
+  *pRx->pCON = DMA_RX_PRIORITY | _DCH0CON_CHEN_MASK;
+  *pTx->pCON = DMA_TX_PRIORITY | _DCH0CON_CHEN_MASK;
+  // the transmit buffer is already empty, so there won't be an edge on
+  // its IRQ to start the first word
+  *pTx->pECONSET = _DCH0ECON_CFORCE_MASK;
+  return true;
+}
+
+/****************************************************************************
+ Function
+    SPIOperate_IsTransferBusy
+
+ Description
+   Reports on the last SPIOperate_Transfer for the module
+****************************************************************************/
+bool SPIOperate_IsTransferBusy(SPI_Module_t WhichModule)
+{
+  if (!isSPI_ModuleLegal(WhichModule))
+  {
+    return false;
+  }
+  return XferStates[WhichModule].IsBusy;
+}
+
+/****************************************************************************
+ Function
+    SPI1TransferISR
+
+ Description
+   The SPI1 receive channel (DCH1) has stored the last word of a transfer.
+   The IPL must match SPI_TRANSFER_PRIORITY
+****************************************************************************/
+void __ISR(_DMA_1_VECTOR, IPL4SOFT) SPI1TransferISR(void)
+{
+  ES_IsrStats_Enter(ES_ISR(SPI1Transfer), ES_ISR_LATENCY_UNKNOWN);
+  finishTransfer(SPI_SPI1);
+  ES_IsrStats_Exit(ES_ISR(SPI1Transfer));
+}
+
+/****************************************************************************
+ Function
+    SPI2TransferISR
+
+ Description
+   The SPI2 receive channel (DCH3) has stored the last word of a transfer.
+   The IPL must match SPI_TRANSFER_PRIORITY
+****************************************************************************/
+void __ISR(_DMA_3_VECTOR, IPL4SOFT) SPI2TransferISR(void)
+{
+  ES_IsrStats_Enter(ES_ISR(SPI2Transfer), ES_ISR_LATENCY_UNKNOWN);
+  finishTransfer(SPI_SPI2);
+  ES_IsrStats_Exit(ES_ISR(SPI2Transfer));
+}
 
 //*********************************
 // private functions
 //*********************************
+/****************************************************************************
+ Function
+    discardReceived
+
+ Description
+   Empties the module's receive buffer & clears an overflow, so the first
+   word the DMA takes is the first word of the transfer
+****************************************************************************/
+static void discardReceived(SPI_Module_t WhichModule)
+{
+  if (SPI_SPI1 == WhichModule)
+  {
+    while (!SPI1STATbits.SPIRBE)
+    {
+      (void)SPI1BUF;
+    }
+    SPI1STATCLR = _SPI1STAT_SPIROV_MASK;
+  }else
+  {
+    while (!SPI2STATbits.SPIRBE)
+    {
+      (void)SPI2BUF;
+    }
+    SPI2STATCLR = _SPI2STAT_SPIROV_MASK;
+  }
+}
+
+/****************************************************************************
+ Function
+    finishTransfer
+
+ Description
+   From the DMA ISR. Both channels have turned themselves off at the end
+   of their blocks. Puts back what SPIOperate_Transfer changed, without
+   selectModuleRegisters, whose pointers may be in use by the code that
+   was interrupted, then calls the callback
+****************************************************************************/
+static void finishTransfer(SPI_Module_t WhichModule)
+{
+  const DMAPair_t *pPair = &DMAPairs[WhichModule];
+  XferState_t *pState = &XferStates[WhichModule];
+
+  *DMAChannels[pPair->RxChannel].pINT = 0;
+  *DMAChannels[pPair->TxChannel].pINT = 0;
+  IEC1CLR = pPair->DoneIntMask;
+  IFS1CLR = pPair->DoneIntMask;
+
+  if (SPI_SPI1 == WhichModule)
+  {
+    SPI1CONbits.SRXISEL = pState->OldRxISEL;
+    SPI1CONbits.STXISEL = pState->OldTxISEL;
+  }else
+  {
+    SPI2CONbits.SRXISEL = pState->OldRxISEL;
+    SPI2CONbits.STXISEL = pState->OldTxISEL;
+  }
+  // the flag was set by the words the DMA took
+  IFS1CLR = pPair->SPIRxIntMask;
+  if (pState->WasRxIntOn)
+  {
+    IEC1SET = pPair->SPIRxIntMask;
+  }
+  pState->IsBusy = false;
+  if (NULL != pState->pDoneFunc)
+  {
+    pState->pDoneFunc(WhichModule);
+  }
+}
 /****************************************************************************
  Function
     selectModuleRegisters
@@ -12,6 +12,7 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       ty      Added PWMOperate_SetPulseWidthOnChannels
  10/19/21       jec     Started conversion from Tiva version
  *****************************************************************************/
 /*----------------------------- Include Files -----------------------------*/
@@ -298,6 +299,57 @@ bool PWMOperate_SetPulseWidthOnChannel( uint16_t NewPW, uint8_t whichChannel)
   return ReturnVal;
 }
 
+/****************************************************************************
+ Function
+   PWMOperate_SetPulseWidthOnChannels
+
+   Two passes over the mask, the first checks everything so that a bad
+   entry leaves all of the outputs as they were, the second writes.
+****************************************************************************/
+bool PWMOperate_SetPulseWidthOnChannels( uint8_t WhichChannels,
+                                         const uint16_t *pNewPWs)
+{
+  bool ReturnVal = true;
+  uint8_t channelIndex;
+  uint8_t remaining;
+  const uint16_t *pNext;
+  
+  // must have at least one channel, and all of them configured
+  if ((-1 == MaxConfiguredChannel) || (0 == WhichChannels) ||
+      (0 != (WhichChannels >> MaxConfiguredChannel)))
+  {
+    ReturnVal = false;
+  }else
+  {
+    pNext = pNewPWs;
+    for (channelIndex = 0, remaining = WhichChannels; 0 != remaining;
+         channelIndex++, remaining >>= 1)
+    {
+      // PR+1 is the 100% duty value, as in PWMOperate_SetDutyOnChannel
+      if ((remaining & 1) &&
+          (*pNext++ > (*ChannelTo_pTimer[channelIndex] + 1)))
+      {
+        ReturnVal = false;
+        break;
+      }
+    }
+  }
+  
+  if (true == ReturnVal)
+  {
+    pNext = pNewPWs;
+    for (channelIndex = 0, remaining = WhichChannels; 0 != remaining;
+         channelIndex++, remaining >>= 1)
+    {
+      if (remaining & 1)
+      {
+        *(ChannelTo_pOCRS_Reg[channelIndex]) = *pNext++;
+      }
+    }
+  }
+  return ReturnVal;
+}
+
 /****************************************************************************
  Function
     PWMSetup_SetPeriodOnTimer
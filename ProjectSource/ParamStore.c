@@ -0,0 +1,401 @@
+/****************************************************************************
+ Module
+   ParamStore.c
+
+ Revision
+   0.1
+
+ Description
+   The calibration & tuning parameters, a RAM copy that is loaded from a
+   reserved page of program flash at boot & written back on request, see
+   ParamStore.h.
+
+ Notes
+   The flash block is
+
+     Magic, Version, Count, Values[NUM_PARAMS], CRC-16 over all before it
+
+   padded to whole words, at the start of ParamPage. ParamPage is the last
+   page of program flash, at PARAM_PAGE_ADDRESS, on its own & on an erase
+   boundary so nothing else the linker places is lost when it is erased.
+   It is built erased, so a freshly programmed part boots with the defaults
+   until the first save. It is read through pParamFlash, a volatile view,
+   so a read after programming isn't folded to the erased image it was
+   built with. In the ES_HOST_SIM build it is an ordinary array.
+
+   Programming goes a word at a time through NVMCON, with the unlock keys
+   written with the interrupts off as the data sheet requires. The CPU
+   stalls while the flash it runs from is busy, so the interrupts being off
+   for the erase costs nothing more.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  ParamPage is in program flash, it was const
+                        volatile & so in RAM
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <xc.h>
+#include <sys/kmem.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
+#include "ParamStore.h"
+#include "Crc.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define PARAM_MAGIC 0x50524D53u   // "PRMS"
+
+// the PIC32MX1xx/2xx erase page
+#define PARAM_PAGE_BYTES 1024
+// the last page of the PIC32MX170F256B's 256K of program flash
+#define PARAM_PAGE_ADDRESS 0x9D03FC00u
+
+#ifdef ES_HOST_SIM
+#define PARAM_PAGE_PLACEMENT __attribute__((aligned(PARAM_PAGE_BYTES)))
+#else
+#define PARAM_PAGE_PLACEMENT \
+  __attribute__((space(prog), address(PARAM_PAGE_ADDRESS)))
+#endif
+
+#if (PARAM_PAGE_ADDRESS % PARAM_PAGE_BYTES) != 0
+#error "PARAM_PAGE_ADDRESS isn't on an erase page boundary"
+#endif
+
+#define NVMOP_WORD_PROGRAM 0x1
+#define NVMOP_PAGE_ERASE 0x4
+#define NVM_KEY_1 0xAA996655u
+#define NVM_KEY_2 0x556699AAu
+
+// the block is 10 bytes & 2 for each parameter
+#define PARAM_COUNT_ROW(Name, Default, Min, Max, Apply) + 1
+#if (10 + 2 * (0 PARAM_TABLE(PARAM_COUNT_ROW))) > PARAM_PAGE_BYTES
+#error "the parameter block doesn't fit its flash page"
+#endif
+
+/*------------------------------ Module Types -----------------------------*/
+typedef struct
+{
+  uint32_t Magic;
+  uint16_t Version;
+  uint16_t Count;
+  uint16_t Values[NUM_PARAMS];
+  uint16_t Crc;
+} ParamBlock_t;
+
+#define BLOCK_WORDS \
+  ((sizeof(ParamBlock_t) + sizeof(uint32_t) - 1) / sizeof(uint32_t))
+
+typedef union
+{
+  ParamBlock_t Block;
+  uint32_t     Words[BLOCK_WORDS];
+} ParamImage_t;
+
+typedef struct
+{
+  const char *pName;
+  uint16_t    Default;
+  uint16_t    Min;
+  uint16_t    Max;
+  void (*pApply)(uint16_t Value);
+} ParamDesc_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void LoadDefaults(void);
+static void BuildImage(ParamImage_t *pImage);
+static uint16_t BlockCrc(const ParamBlock_t *pBlock);
+static bool RunNvmOp(uint32_t NvmOp);
+
+/*---------------------------- Module Variables ---------------------------*/
+#define PARAM_DESC_ROW(Name, Default, Min, Max, Apply) \
+  { #Name, Default, Min, Max, Apply },
+static const ParamDesc_t Params[NUM_PARAMS] = {
+  PARAM_TABLE(PARAM_DESC_ROW)
+};
+
+#define PARAM_DEFAULT_ROW(Name, Default, Min, Max, Apply) Default,
+static uint16_t Values[NUM_PARAMS] = {
+  PARAM_TABLE(PARAM_DEFAULT_ROW)
+};
+
+// const & not volatile, so it is placed in flash rather than RAM
+static const uint32_t ParamPage[PARAM_PAGE_BYTES / sizeof(uint32_t)]
+    PARAM_PAGE_PLACEMENT = {
+  [0 ... (PARAM_PAGE_BYTES / sizeof(uint32_t)) - 1] = 0xFFFFFFFFu
+};
+// all reads go through here, the compiler would otherwise fold them to the
+// erased image
+static const volatile uint32_t *const pParamFlash = ParamPage;
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     ParamStore_Init
+
+ Parameters
+     None
+
+ Returns
+     bool, true if the values came from flash, false if it had no good
+     block & they are the defaults
+
+ Description
+     Loads the RAM copy from the flash block. Nothing is applied, the
+     services read their values when they are initialized
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool ParamStore_Init(void)
+{
+  ParamImage_t Image;
+  uint8_t      i;
+
+  for (i = 0; i < BLOCK_WORDS; i++)
+  {
+    Image.Words[i] = pParamFlash[i];
+  }
+  if ((Image.Block.Magic != PARAM_MAGIC) ||
+      (Image.Block.Version != PARAM_STORE_VERSION) ||
+      (Image.Block.Count != NUM_PARAMS) ||
+      (Image.Block.Crc != BlockCrc(&Image.Block)))
+  {
+    LoadDefaults();
+    return false;
+  }
+  for (i = 0; i < NUM_PARAMS; i++)
+  {
+    if ((Image.Block.Values[i] < Params[i].Min) ||
+        (Image.Block.Values[i] > Params[i].Max))
+    {
+      LoadDefaults();
+      return false;
+    }
+  }
+  memcpy(Values, Image.Block.Values, sizeof(Values));
+  return true;
+}
+
+/****************************************************************************
+ Function
+     ParamStore_Get
+
+ Parameters
+     ParamId_t Id - PARAM_ID(Name)
+
+ Returns
+     uint16_t, the parameter's value, 0 for an Id that isn't one
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint16_t ParamStore_Get(ParamId_t Id)
+{
+  if (Id >= NUM_PARAMS)
+  {
+    return 0;
+  }
+  return Values[Id];
+}
+
+/****************************************************************************
+ Function
+     ParamStore_Set
+
+ Parameters
+     ParamId_t Id - PARAM_ID(Name)
+     uint16_t Value - the new value
+
+ Returns
+     bool, false if the value is out of the parameter's range, or Id isn't
+     a parameter
+
+ Description
+     Changes the RAM copy & applies it, the flash keeps the old one until
+     ParamStore_Save
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool ParamStore_Set(ParamId_t Id, uint16_t Value)
+{
+  if ((Id >= NUM_PARAMS) || (Value < Params[Id].Min) ||
+      (Value > Params[Id].Max))
+  {
+    return false;
+  }
+  Values[Id] = Value;
+  if (Params[Id].pApply != NULL)
+  {
+    Params[Id].pApply(Value);
+  }
+  return true;
+}
+
+/****************************************************************************
+ Function
+     ParamStore_Find
+
+ Parameters
+     const char *pName - a name from PARAM_TABLE
+     ParamId_t *pId - where its Id goes
+
+ Returns
+     bool, false if there is no parameter of that name
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool ParamStore_Find(const char *pName, ParamId_t *pId)
+{
+  uint8_t i;
+
+  for (i = 0; i < NUM_PARAMS; i++)
+  {
+    if (strcmp(pName, Params[i].pName) == 0)
+    {
+      *pId = (ParamId_t)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+/****************************************************************************
+ Function
+     ParamStore_Defaults
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Puts every parameter back to its default & applies it. The flash is
+     left alone
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void ParamStore_Defaults(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < NUM_PARAMS; i++)
+  {
+    (void)ParamStore_Set((ParamId_t)i, Params[i].Default);
+  }
+}
+
+/****************************************************************************
+ Function
+     ParamStore_Save
+
+ Parameters
+     None
+
+ Returns
+     bool, false if the erase or a word failed to program
+
+ Description
+     Writes the RAM copy to the flash block. A block that already holds the
+     same values isn't rewritten
+
+ Notes
+     Stalls the CPU for the page erase, see ParamStore.h
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool ParamStore_Save(void)
+{
+  ParamImage_t Image;
+  uint8_t      i;
+
+  BuildImage(&Image);
+  for (i = 0; i < BLOCK_WORDS; i++)
+  {
+    if (pParamFlash[i] != Image.Words[i])
+    {
+      break;
+    }
+  }
+  if (i == BLOCK_WORDS)
+  {
+    return true;
+  }
+
+  NVMADDR = KVA_TO_PA(ParamPage);
+  if (!RunNvmOp(NVMOP_PAGE_ERASE))
+  {
+    return false;
+  }
+  for (i = 0; i < BLOCK_WORDS; i++)
+  {
+    NVMADDR = KVA_TO_PA(&ParamPage[i]);
+    NVMDATA = Image.Words[i];
+    if (!RunNvmOp(NVMOP_WORD_PROGRAM))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+// without applying them, the services aren't up yet
+static void LoadDefaults(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < NUM_PARAMS; i++)
+  {
+    Values[i] = Params[i].Default;
+  }
+}
+
+// the block for the RAM copy, the padding erased
+static void BuildImage(ParamImage_t *pImage)
+{
+  memset(pImage, 0xFF, sizeof(*pImage));
+  pImage->Block.Magic = PARAM_MAGIC;
+  pImage->Block.Version = PARAM_STORE_VERSION;
+  pImage->Block.Count = NUM_PARAMS;
+  memcpy(pImage->Block.Values, Values, sizeof(Values));
+  pImage->Block.Crc = BlockCrc(&pImage->Block);
+}
+
+static uint16_t BlockCrc(const ParamBlock_t *pBlock)
+{
+  return Crc_Ccitt16(CRC16_INITIAL, (const uint8_t *)pBlock,
+      (uint16_t)offsetof(ParamBlock_t, Crc));
+}
+
+// NVMADDR & NVMDATA are already set, false on a write or low voltage error
+static bool RunNvmOp(uint32_t NvmOp)
+{
+  NVMCON = _NVMCON_WREN_MASK | NvmOp;
+  EnterCritical();
+  NVMKEY = NVM_KEY_1;
+  NVMKEY = NVM_KEY_2;
+  NVMCONSET = _NVMCON_WR_MASK;
+  while (NVMCON & _NVMCON_WR_MASK)
+  {
+    ;
+  }
+  ExitCritical();
+  NVMCONCLR = _NVMCON_WREN_MASK;
+  return (NVMCON & (_NVMCON_WRERR_MASK | _NVMCON_LVDERR_MASK)) == 0;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -12,14 +12,104 @@
    Follow the idea of a centralized port module. Actual pin assignments
    should be updated for the target hardware.
 
+   With USE_CN_INPUT_EVENTS (ES_Configure.h), the beacon input uses the
+   port B change notice interrupt. The ISR time stamps each rising edge
+   with the core timer and publishes ES_BEACON_DETECTED itself, so the edge
+   latency is the interrupt latency rather than a trip round ES_Run, and
+   the beacon row comes out of DIGITAL_INPUT_TABLE. Without it the input
+   scan polls it as before.
+
+   The inputs of DIGITAL_INPUT_TABLE (Ports.h) aren't read one helper at a
+   time, ReadScannedInputs takes both ports & turns them into the scan
+   word with two masks the table gives at compile time, so the cost of a
+   read is the same however many inputs there are.
+
+   The scan word is debounced from the tick ISR (ES_TICK_HOOK) as a
+   vertical counter, bit n of Count0..Count3 being the 4 bit count of the
+   input at bit n, so every input is handled at once with a few bitwise
+   operations. An input's count runs while it reads differently from its
+   stable state & starts again when it agrees, & the input changes when
+   its count gets to its DebounceMs, which is spread over Window0..Window3
+   the same way.
+
+   The stop input (RB7, active low with the pull-up on, for a bumper or
+   the tape comparator) is always on the change notice. Its falling edge
+   zeroes the motor duty from the ISR with DCMotor_EmergencyStop before
+   anything is queued, then publishes ES_EMERGENCY_STOP so MainLogicFSM can
+   catch up & release the latch. Its edge is handled first in the ISR.
+
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26       Tianyu  DebounceScannedInputs, a vertical counter for the
+                        scanned inputs, from the tick
+ 10/14/26       Tianyu  InitScannedInputs & ReadScannedInputs for
+                        DIGITAL_INPUT_TABLE
+ 10/14/26       Tianyu  Stop input on the change notice, stops the motors
+                        from the ISR
+ 10/14/26       Tianyu  InputChangeISR reports to ES_IsrStats
+ 10/14/26       Tianyu  Beacon event is published rather than posted
+ 10/14/26       Tianyu  Beacon event carries the edge time in EventData
+ 10/14/26       Tianyu  Change notice interrupt for the beacon input
+ 10/14/26       Tianyu  Tape sensors are now an analog array (TapeArray.c)
  02/03/26       Tianyu  Initial creation for Lab 8 port management
 ****************************************************************************/
 
+#include "ES_Configure.h"
+#include "ES_Framework.h"
 #include "Ports.h"
 #include "CommonDefinitions.h"
+#include "ES_IsrStats.h"
+#include "DCMotorService.h"
+#include <sys/attribs.h>
+
+// change notice interrupt priority, below the motor & encoder ISRs
+#define CN_PRIORITY 2
+#define BEACON_PIN_MASK (1u << 2)   // RB2
+#define STOP_PIN_MASK (1u << 7)     // RB7, active low
+// a beacon flickers at its frequency, after posting wait this long
+// before posting again so the queue isn't flooded
+#define CORE_TICKS_PER_MS 20000
+#define BEACON_HOLDOFF_MS 10
+
+// the halves of the scan word
+#define SCAN_PORT_BITS 16
+#define SCAN_PORT_MASK 0xFFFFu
+
+// each input's DebounceMs, one bit of it in each of the 4 windows
+#define WINDOW_BIT(Pin, DebounceMs, Bit) \
+  ((((DebounceMs) >> (Bit)) & 1u) ? (1u << (Pin)) : 0u)
+#define WINDOW0_ROW(Name, Pin, ActiveLow, DebounceMs, OnEvent, OffEvent) \
+  | WINDOW_BIT(Pin, DebounceMs, 0)
+#define WINDOW1_ROW(Name, Pin, ActiveLow, DebounceMs, OnEvent, OffEvent) \
+  | WINDOW_BIT(Pin, DebounceMs, 1)
+#define WINDOW2_ROW(Name, Pin, ActiveLow, DebounceMs, OnEvent, OffEvent) \
+  | WINDOW_BIT(Pin, DebounceMs, 2)
+#define WINDOW3_ROW(Name, Pin, ActiveLow, DebounceMs, OnEvent, OffEvent) \
+  | WINDOW_BIT(Pin, DebounceMs, 3)
+#define WINDOW0 (0u DIGITAL_INPUT_TABLE(WINDOW0_ROW))
+#define WINDOW1 (0u DIGITAL_INPUT_TABLE(WINDOW1_ROW))
+#define WINDOW2 (0u DIGITAL_INPUT_TABLE(WINDOW2_ROW))
+#define WINDOW3 (0u DIGITAL_INPUT_TABLE(WINDOW3_ROW))
+
+#define DEBOUNCE_CHECK_ROW(Name, Pin, ActiveLow, DebounceMs, OnEvent,       \
+    OffEvent)                                                              \
+  typedef char Name##DebounceFits[(((DebounceMs) >= 1) &&                 \
+      ((DebounceMs) <= DEBOUNCE_MAX_MS)) ? 1 : -1];
+DIGITAL_INPUT_TABLE(DEBOUNCE_CHECK_ROW)
+
+static void ConfigureChangeNotify(void);
+
+static bool LastStopState;
+// the debounce, only the tick writes these
+static uint32_t Count0, Count1, Count2, Count3;
+static volatile uint32_t StableInputs;   // all inactive to start
+#ifdef USE_CN_INPUT_EVENTS
+static bool LastBeaconState;
+static volatile uint32_t BeaconEdgeTime;
+static uint32_t LastBeaconPostTime;
+static bool HaveBeaconPost;
+#endif
 
 /****************************************************************************
  Function
@@ -42,6 +132,10 @@ void InitBeaconInputPin(void)
   // Configure the beacon input pin (TRIS/ANSEL)
   TRISBbits.TRISB2 = 1;   // Set as input
   ANSELBbits.ANSB2 = 0;   // Set as digital
+#ifdef USE_CN_INPUT_EVENTS
+  CNENBbits.CNIEB2 = 1;
+  ConfigureChangeNotify();
+#endif
 }
 
 /****************************************************************************
@@ -71,7 +165,28 @@ bool ReadBeaconInputPin(void)
 
 /****************************************************************************
  Function
-     InitTapeSensorPin
+     ReadStopInputPin
+
+ Parameters
+     None
+
+ Returns
+     bool: true while the stop input is active
+
+ Description
+     Reads the stop input pin, which is active low
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool ReadStopInputPin(void)
+{
+  return ((PORTB & STOP_PIN_MASK) == 0);
+}
+
+/****************************************************************************
+ Function
+     InitStopInputPin
 
  Parameters
      None
@@ -80,41 +195,44 @@ bool ReadBeaconInputPin(void)
      None
 
  Description
-     Initializes the tape sensor input pin.
+     Initializes the stop input as a digital input with its pull-up, on the
+     change notice
 
  Author
-     Tianyu, 02/03/26
+     Tianyu, 10/14/26
 ****************************************************************************/
-void InitTapeSensorPin(void)
+void InitStopInputPin(void)
 {
-  // Configure the beacon input pin (TRIS/ANSEL)
-  TRISBbits.TRISB3 = 1;   // Set as input
-  ANSELBbits.ANSB3 = 0;   // Set as digital
+  TRISBbits.TRISB7 = 1;   // Set as input, RB7 has no analog function
+  CNPUBbits.CNPUB7 = 1;
+  CNENBbits.CNIEB7 = 1;
+  ConfigureChangeNotify();
 }
 
 /****************************************************************************
  Function
-     ReadTapeSensorPin
+     InitTapeSensorPin
 
  Parameters
      None
 
  Returns
-     bool: current tape sensor input state
+     None
 
  Description
-     Reads the tape sensor input pin.
+     Initializes the tape sensor array pins as analog inputs, they are
+     read through TapeArray.c
 
  Author
      Tianyu, 02/03/26
 ****************************************************************************/
-bool ReadTapeSensorPin(void)
+void InitTapeSensorPin(void)
 {
-  // Return the tape sensor input pin state
-  if (PORTBbits.RB3 == 1) {
-    return true;
-  }
-  return false;
+  // Configure the tape sensor pins (TRIS/ANSEL)
+  TRISBbits.TRISB3 = 1;   // AN5, left sensor
+  ANSELBbits.ANSB3 = 1;   // Set as analog
+  TRISBbits.TRISB12 = 1;  // AN12, right sensor
+  ANSELBbits.ANSB12 = 1;  // Set as analog
 }
 
 /****************************************************************************
@@ -161,3 +279,251 @@ void InitDebugOutputPin(void)
   DEBUG_OUTPUT_PIN_LAT = 0;  // Initialize low
   DEBUG_OUTPUT_PIN_ANSEL = 0; // Disable analog functionw
 }
+
+/****************************************************************************
+ Function
+     InitScannedInputs
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Sets up every pin of DIGITAL_INPUT_TABLE as a digital input, with its
+     pull-up if it is active low
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void InitScannedInputs(void)
+{
+  const uint32_t pinsB = DIGITAL_INPUT_SCAN_MASK & SCAN_PORT_MASK;
+  const uint32_t pinsA = DIGITAL_INPUT_SCAN_MASK >> SCAN_PORT_BITS;
+  const uint32_t lowB = DIGITAL_INPUT_LOW_MASK & SCAN_PORT_MASK;
+  const uint32_t lowA = DIGITAL_INPUT_LOW_MASK >> SCAN_PORT_BITS;
+
+  TRISBSET = pinsB;
+  ANSELBCLR = pinsB;
+  CNPUBSET = lowB;
+  TRISASET = pinsA;
+  ANSELACLR = pinsA;
+  CNPUASET = lowA;
+}
+
+/****************************************************************************
+ Function
+     ReadScannedInputs
+
+ Parameters
+     None
+
+ Returns
+     uint32_t: the scan word, a 1 for each input of DIGITAL_INPUT_TABLE
+     that is active
+
+ Description
+     Reads both ports once & lines them up as the scan word, see Ports.h
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint32_t ReadScannedInputs(void)
+{
+  uint32_t raw = (PORTB & SCAN_PORT_MASK) |
+      ((PORTA & SCAN_PORT_MASK) << SCAN_PORT_BITS);
+
+  return (raw ^ DIGITAL_INPUT_LOW_MASK) & DIGITAL_INPUT_SCAN_MASK;
+}
+
+/****************************************************************************
+ Function
+     DebounceScannedInputs
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Takes one sample of the scanned inputs & moves the debounce on by it,
+     the inputs that have read the new way for their DebounceMs change
+
+ Notes
+     ES_TICK_HOOK, called from the tick ISR
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void DebounceScannedInputs(void)
+{
+  uint32_t differ = ReadScannedInputs() ^ StableInputs;
+  uint32_t carry = differ;
+  uint32_t settled;
+
+  // an input that agrees with its stable state starts again from 0
+  Count0 &= differ;
+  Count1 &= differ;
+  Count2 &= differ;
+  Count3 &= differ;
+  // & the rest count up, the carry rippling through the bits
+  Count0 ^= carry;
+  carry &= ~Count0;
+  Count1 ^= carry;
+  carry &= ~Count1;
+  Count2 ^= carry;
+  carry &= ~Count2;
+  Count3 ^= carry;
+
+  settled = differ & ~((Count0 ^ WINDOW0) | (Count1 ^ WINDOW1) |
+      (Count2 ^ WINDOW2) | (Count3 ^ WINDOW3));
+  StableInputs ^= settled;
+  Count0 &= ~settled;
+  Count1 &= ~settled;
+  Count2 &= ~settled;
+  Count3 &= ~settled;
+}
+
+/****************************************************************************
+ Function
+     ReadDebouncedInputs
+
+ Parameters
+     None
+
+ Returns
+     uint32_t: the scan word as debounced, see ReadScannedInputs
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint32_t ReadDebouncedInputs(void)
+{
+  return StableInputs;
+}
+
+/****************************************************************************
+ Function
+     GetBeaconEdgeTime
+
+ Parameters
+     None
+
+ Returns
+     uint32_t: core timer count at the last rising edge of the beacon input
+
+ Description
+     Time stamp latched by InputChangeISR, including edges that fell in the
+     hold off and weren't posted
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+#ifdef USE_CN_INPUT_EVENTS
+uint32_t GetBeaconEdgeTime(void)
+{
+  return BeaconEdgeTime;
+}
+#endif
+
+/****************************************************************************
+ Function
+     InputChangeISR
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Port B change notice interrupt. Stops the motors on the falling edge
+     of the stop input & publishes ES_EMERGENCY_STOP, then latches the time
+     of a rising edge on the beacon input and publishes ES_BEACON_DETECTED
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void __ISR(_CHANGE_NOTICE_VECTOR, IPL2SOFT) InputChangeISR(void)
+{
+  uint32_t now = _CP0_GET_COUNT();
+  uint32_t portB = PORTB;   // reading the port clears the mismatch
+  bool     stopState = ((portB & STOP_PIN_MASK) == 0);
+#ifdef USE_CN_INPUT_EVENTS
+  bool     beaconState = ((portB & BEACON_PIN_MASK) != 0);
+#endif
+
+  ES_IsrStats_Enter(ES_ISR(InputChange), ES_ISR_LATENCY_UNKNOWN);
+  IFS1CLR = _IFS1_CNBIF_MASK;
+
+  if (stopState && !LastStopState)
+  {
+    ES_Event_t ThisEvent;
+
+    // the wheels first, the event is only the notice
+    DCMotor_EmergencyStop();
+    ThisEvent.EventType = ES_EMERGENCY_STOP;
+    ThisEvent.EventParam = 0;
+    ES_EVENT_SET_DATA(ThisEvent, now);
+    ES_Publish(ThisEvent);
+  }
+  LastStopState = stopState;
+
+#ifdef USE_CN_INPUT_EVENTS
+  if (beaconState && !LastBeaconState)
+  {
+    BeaconEdgeTime = now;
+    if (!HaveBeaconPost ||
+        ((now - LastBeaconPostTime) >= (BEACON_HOLDOFF_MS * CORE_TICKS_PER_MS)))
+    {
+      ES_Event_t ThisEvent;
+      ThisEvent.EventType = ES_BEACON_DETECTED;
+      ThisEvent.EventParam = 0;
+      ES_EVENT_SET_DATA(ThisEvent, now);   // core timer counts
+      ES_Publish(ThisEvent);
+      LastBeaconPostTime = now;
+      HaveBeaconPost = true;
+    }
+  }
+  LastBeaconState = beaconState;
+#endif
+  ES_IsrStats_Exit(ES_ISR(InputChange));
+}
+
+/****************************************************************************
+ Function
+     ConfigureChangeNotify
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Turns on the port B change notice for the pins enabled in CNENB, &
+     takes their starting states
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static void ConfigureChangeNotify(void)
+{
+  uint32_t portB;
+
+  IEC1CLR = _IEC1_CNBIE_MASK;
+  CNCONBbits.ON = 1;
+  // read the port to set the starting states & clear any mismatch
+  portB = PORTB;
+  LastStopState = ((portB & STOP_PIN_MASK) == 0);
+#ifdef USE_CN_INPUT_EVENTS
+  HaveBeaconPost = false;
+  LastBeaconState = ((portB & BEACON_PIN_MASK) != 0);
+#endif
+  IFS1CLR = _IFS1_CNBIF_MASK;
+  IPC8bits.CNIP = CN_PRIORITY;
+  IPC8bits.CNIS = 0;
+  IEC1SET = _IEC1_CNBIE_MASK;
+}
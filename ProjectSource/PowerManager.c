@@ -0,0 +1,258 @@
+/****************************************************************************
+ Module
+   PowerManager.c
+
+ Revision
+   0.1
+
+ Description
+   Switches the peripheral domains of POWER_DOMAIN_TABLE on & off through
+   the PMD registers, keeping their registers over the time they are off,
+   see PowerManager.h.
+
+ Notes
+   Registers are written back in the order of the domain's list with bit 15
+   clear, then the ones that were saved with it set are written again,
+   whole. Bit 15 is ON in every control register here, so with the control
+   registers last in each list nothing is switched on before it is set up.
+   For the rest the second write is harmless.
+
+   PMDL1WAY is off in the configuration bits, so PMDLOCK only has to be
+   cleared once.
+
+   Only called from MainLogicFSM & main, never from an ISR.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  IC3 & IC4 are only switched off if PulseCaptureService
+                        doesn't use them
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <xc.h>
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
+#include "PowerManager.h"
+#include "DCMotorService.h"
+#include "PulseCaptureService.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define REG_ON_BIT (1u << 15)
+
+#define SYS_KEY_1 0xAA996655u
+#define SYS_KEY_2 0x556699AAu
+
+// the peripherals the application never uses, off from the start
+#define NEVER_USED_PMD1 (_PMD1_CTMUMD_MASK | _PMD1_CVRMD_MASK)
+#define NEVER_USED_PMD2 \
+  (_PMD2_CMP1MD_MASK | _PMD2_CMP2MD_MASK | _PMD2_CMP3MD_MASK)
+#define NEVER_USED_PMD3 (((_PMD3_IC3MD_MASK | _PMD3_IC4MD_MASK) & \
+  ~PULSE_CAPTURE_PMD3_MASK) | \
+  _PMD3_OC3MD_MASK | _PMD3_OC4MD_MASK | _PMD3_OC5MD_MASK)
+#define NEVER_USED_PMD5 (_PMD5_U2MD_MASK | _PMD5_SPI2MD_MASK | \
+  _PMD5_I2C1MD_MASK | _PMD5_I2C2MD_MASK)
+#define NEVER_USED_PMD6 (_PMD6_REFOMD_MASK | _PMD6_PMPMD_MASK)
+
+// most registers any domain keeps
+#define MAX_DOMAIN_REGS 8
+
+/*------------------------------ Module Types -----------------------------*/
+typedef struct
+{
+  volatile uint32_t *const *pRegs;  // in the order they are written back
+  uint8_t  NumRegs;
+  uint32_t Pmd1Mask;
+  uint32_t Pmd3Mask;
+  uint32_t Pmd4Mask;
+  uint32_t Iec0Mask;
+  void (*pOff)(void);
+  void (*pOn)(void);
+} Domain_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void SwitchOff(PowerDomain_t Which);
+static void SwitchOn(PowerDomain_t Which);
+
+/*---------------------------- Module Variables ---------------------------*/
+// each domain's registers, the control registers last
+static volatile uint32_t *const PwmRegs[] = {
+  &PR2, &OC1R, &OC1RS, &OC2R, &OC2RS, &OC1CON, &OC2CON, &T2CON
+};
+static volatile uint32_t *const TapeRegs[] = {
+  &AD1CHS, &AD1CSSL, &AD1CON2, &AD1CON3, &AD1CON1
+};
+static volatile uint32_t *const BeaconRegs[] = {
+  &IC1CON
+};
+
+#define DOMAIN_ROW(Name, Pmd1Mask, Pmd3Mask, Pmd4Mask, Iec0Mask, pOff, pOn) \
+  { Name##Regs, ARRAY_SIZE(Name##Regs), Pmd1Mask, Pmd3Mask, Pmd4Mask,       \
+    Iec0Mask, pOff, pOn },
+static const Domain_t Domains[NUM_POWER_DOMAINS] = {
+  POWER_DOMAIN_TABLE(DOMAIN_ROW)
+};
+
+#define DOMAIN_REGS_CHECK(Name, Pmd1Mask, Pmd3Mask, Pmd4Mask, Iec0Mask,      \
+    pOff, pOn)                                                              \
+  typedef char Name##RegsFit[(ARRAY_SIZE(Name##Regs) <= MAX_DOMAIN_REGS) ?  \
+      1 : -1];
+POWER_DOMAIN_TABLE(DOMAIN_REGS_CHECK)
+
+static uint32_t    Saved[NUM_POWER_DOMAINS][MAX_DOMAIN_REGS];
+static uint32_t    SavedIec0[NUM_POWER_DOMAINS];
+static PowerMask_t OnDomains;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     PowerManager_Init
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Unlocks the PMD registers & switches off the peripherals that the
+     application never uses. Every domain is left on, call it before the
+     services set them up
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void PowerManager_Init(void)
+{
+  EnterCritical();
+  SYSKEY = 0;
+  SYSKEY = SYS_KEY_1;
+  SYSKEY = SYS_KEY_2;
+  CFGCONCLR = _CFGCON_PMDLOCK_MASK;
+  SYSKEY = 0;
+  ExitCritical();
+
+  PMD1SET = NEVER_USED_PMD1;
+  PMD2SET = NEVER_USED_PMD2;
+  PMD3SET = NEVER_USED_PMD3;
+  PMD5SET = NEVER_USED_PMD5;
+  PMD6SET = NEVER_USED_PMD6;
+  OnDomains = (PowerMask_t)((1u << NUM_POWER_DOMAINS) - 1);
+}
+
+/****************************************************************************
+ Function
+     PowerManager_Need
+
+ Parameters
+     PowerMask_t Domains - POWER_MASK()s of every domain to have on
+
+ Returns
+     None
+
+ Description
+     Switches on the domains in Domains that are off & off the ones that
+     aren't in it
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void PowerManager_Need(PowerMask_t Domains)
+{
+  PowerDomain_t Which;
+
+  for (Which = 0; Which < NUM_POWER_DOMAINS; Which++)
+  {
+    PowerMask_t Bit = (PowerMask_t)(1u << Which);
+
+    if ((Domains & Bit) && !(OnDomains & Bit))
+    {
+      SwitchOn(Which);
+      OnDomains |= Bit;
+    }
+    else if (!(Domains & Bit) && (OnDomains & Bit))
+    {
+      SwitchOff(Which);
+      OnDomains &= (PowerMask_t)~Bit;
+    }
+  }
+}
+
+/****************************************************************************
+ Function
+     PowerManager_GetOn
+
+ Parameters
+     None
+
+ Returns
+     PowerMask_t, the domains that are on
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+PowerMask_t PowerManager_GetOn(void)
+{
+  return OnDomains;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+static void SwitchOff(PowerDomain_t Which)
+{
+  const Domain_t *pDomain = &Domains[Which];
+  uint8_t         i;
+
+  if (pDomain->pOff != NULL)
+  {
+    pDomain->pOff();
+  }
+  // an interrupt that is already pending would find the registers gone
+  EnterCritical();
+  SavedIec0[Which] = IEC0 & pDomain->Iec0Mask;
+  IEC0CLR = pDomain->Iec0Mask;
+  IFS0CLR = pDomain->Iec0Mask;
+  ExitCritical();
+
+  for (i = 0; i < pDomain->NumRegs; i++)
+  {
+    Saved[Which][i] = *pDomain->pRegs[i];
+  }
+  PMD1SET = pDomain->Pmd1Mask;
+  PMD3SET = pDomain->Pmd3Mask;
+  PMD4SET = pDomain->Pmd4Mask;
+}
+
+static void SwitchOn(PowerDomain_t Which)
+{
+  const Domain_t *pDomain = &Domains[Which];
+  uint8_t         i;
+
+  PMD1CLR = pDomain->Pmd1Mask;
+  PMD3CLR = pDomain->Pmd3Mask;
+  PMD4CLR = pDomain->Pmd4Mask;
+  for (i = 0; i < pDomain->NumRegs; i++)
+  {
+    *pDomain->pRegs[i] = Saved[Which][i] & ~REG_ON_BIT;
+  }
+  for (i = 0; i < pDomain->NumRegs; i++)
+  {
+    if (Saved[Which][i] & REG_ON_BIT)
+    {
+      *pDomain->pRegs[i] = Saved[Which][i];
+    }
+  }
+
+  IFS0CLR = pDomain->Iec0Mask;
+  IEC0SET = SavedIec0[Which];
+  if (pDomain->pOn != NULL)
+  {
+    pDomain->pOn();
+  }
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,395 @@
+/****************************************************************************
+ Module
+   PulseCaptureService.c
+
+ Revision
+   0.1
+
+ Description
+   Times the pulses on the PULSE_CAPTURE_TABLE inputs & publishes each one
+   as ES_PULSE_MEASURED, see PulseCaptureService.h.
+
+ Notes
+   Each module runs in ICM = 110, every edge with the one set by FEDGE
+   first, so after it is switched on the captures are leading, trailing,
+   leading... & the ISR only has to keep count to know which is which. An
+   overflowed FIFO has lost edges, so the module is switched off & on
+   again to start the count afresh.
+
+   The ISRs note each finished pulse in the channel's state, set its bit
+   in PendingChannels & post ES_PULSE_CAPTURED to this service, coalesced,
+   so however many pulses come between two runs there is one event in the
+   queue. The run publishes ES_PULSE_MEASURED for each pending channel.
+
+   The capture ISRs are all at PULSE_CAPTURE_PRIORITY, with the encoders',
+   so they don't interrupt each other. The service reads a channel with a
+   retry on its count, as SpeedControlService does the encoders.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "PulseCaptureService.h"
+#include "CaptureTimebase.h"
+#include "ES_IsrStats.h"
+#include <xc.h>
+#include <sys/attribs.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+#if NUM_PULSE_CHANNELS > 8
+#error "PendingChannels has a bit for each pulse channel"
+#endif
+
+// ICM = 110, every edge, FEDGE first
+#define ICM_EVERY_EDGE 0b110
+
+typedef struct
+{
+  // written by the capture ISR
+  volatile uint32_t LeadStamp;  // time of the last leading edge
+  volatile uint32_t LeadPeriod; // from the leading edge before it, 0 for none
+  volatile uint32_t Width;      // time base ticks, leading to trailing
+  volatile uint32_t Period;     // leading edge to leading edge, 0 for none
+  volatile uint32_t Count;      // pulses measured
+  volatile bool     HaveLead;   // LeadStamp is from this run of the module
+  volatile bool     NextIsLead;
+} PulseChannelState_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void NoteEdge(PulseChannel_t Channel, CaptureRaw_t Captured);
+static void RestartChannel(PulseChannel_t Channel);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint8_t MyPriority;
+static PulseChannelState_t Channels[NUM_PULSE_CHANNELS];
+// a bit for each channel with a pulse that hasn't been published
+static volatile uint8_t PendingChannels;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     InitPulseCaptureService
+
+ Parameters
+     uint8_t : the priority of this service
+
+ Returns
+     bool, false if error in initialization, true otherwise
+
+ Description
+     Sets up the pin, the PPS & the capture module of each channel & starts
+     them capturing on the shared time base
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool InitPulseCaptureService(uint8_t Priority)
+{
+  ES_Event_t ThisEvent;
+
+  MyPriority = Priority;
+  PendingChannels = 0;
+
+  CaptureTimebase_Init();
+
+  // the pin, the PPS & the module for each row
+#define PULSE_SETUP_ROW(Name, Ic, Port, Bit, Pps, ActiveHigh)                 \
+  TRIS##Port##SET = (1u << (Bit));                                            \
+  ANSEL##Port##CLR = (1u << (Bit));                                           \
+  IC##Ic##R = (Pps);                                                          \
+  IC##Ic##CONbits.ON = 0;                                                     \
+  IC##Ic##CONbits.ICTMR = 0;                                                  \
+  IC##Ic##CONbits.ICC32 = CAPTURE_TIMEBASE_ICC32;                             \
+  IC##Ic##CONbits.FEDGE = (ActiveHigh) ? 1 : 0;                               \
+  IC##Ic##CONbits.ICM = ICM_EVERY_EDGE;                                       \
+  IC##Ic##CONbits.ICI = 0b00;                                                 \
+  IFS0CLR = _IFS0_IC##Ic##IF_MASK;                                            \
+  IPC##Ic##bits.IC##Ic##IP = PULSE_CAPTURE_PRIORITY;                          \
+  IPC##Ic##bits.IC##Ic##IS = 2;                                               \
+  IEC0SET = _IEC0_IC##Ic##IE_MASK;                                            \
+  RestartChannel(PULSE_CHANNEL(Name));
+  PULSE_CAPTURE_TABLE(PULSE_SETUP_ROW)
+
+  ThisEvent.EventType = ES_INIT;
+  return ES_PostToService(MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+     PostPulseCaptureService
+
+ Parameters
+     ES_Event_t ThisEvent, the event to post to the queue
+
+ Returns
+     bool false if the Enqueue operation failed, true otherwise
+
+ Description
+     Posts an event to this service's queue
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool PostPulseCaptureService(ES_Event_t ThisEvent)
+{
+  return ES_PostToService(MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+    RunPulseCaptureService
+
+ Parameters
+   ES_Event_t : the event to process
+
+ Returns
+   ES_Event_t, ES_NO_EVENT if no error ES_ERROR otherwise
+
+ Description
+   Publishes ES_PULSE_MEASURED for each channel that has measured a pulse
+   since the last run
+
+ Author
+   Tianyu, 10/14/26
+****************************************************************************/
+ES_Event_t RunPulseCaptureService(ES_Event_t ThisEvent)
+{
+  ES_Event_t ReturnEvent;
+  ReturnEvent.EventType = ES_NO_EVENT; // assume no errors
+
+  switch (ThisEvent.EventType)
+  {
+    case ES_PULSE_CAPTURED:
+    {
+      ES_Event_t MeasuredEvent;
+      uint32_t   Width;
+      uint32_t   Period;
+      uint8_t    Pending;
+      uint8_t    i;
+
+      EnterCritical();
+      Pending = PendingChannels;
+      PendingChannels = 0;
+      ExitCritical();
+
+      MeasuredEvent.EventType = ES_PULSE_MEASURED;
+      for (i = 0; i < NUM_PULSE_CHANNELS; i++)
+      {
+        if ((Pending & (1u << i)) == 0)
+        {
+          continue;
+        }
+        (void)PulseCapture_GetWidth((PulseChannel_t)i, &Width, &Period);
+        MeasuredEvent.EventParam = i;
+        ES_EVENT_SET_DATA(MeasuredEvent, Width);
+        (void)ES_Publish(MeasuredEvent);
+      }
+    }
+    break;
+
+    default:
+      break;
+  }
+
+  return ReturnEvent;
+}
+
+/****************************************************************************
+ Function
+     PulseCapture_GetWidth
+
+ Parameters
+     PulseChannel_t Channel - PULSE_CHANNEL(Name)
+     uint32_t *pWidth - set to the latest pulse's width, time base ticks
+     uint32_t *pPeriod - & to its period, 0 if it was the first pulse
+
+ Returns
+     bool - false if the channel has no pulse yet, or isn't one
+
+ Description
+     The latest measurement, PULSE_TICKS_TO_US gives it in uS
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool PulseCapture_GetWidth(PulseChannel_t Channel, uint32_t *pWidth,
+                           uint32_t *pPeriod)
+{
+  PulseChannelState_t *pChannel;
+  uint32_t Count;
+
+  if (Channel >= NUM_PULSE_CHANNELS)
+  {
+    return false;
+  }
+  pChannel = &Channels[Channel];
+  // the capture ISR can interrupt these reads, go again if it did
+  do
+  {
+    Count = pChannel->Count;
+    *pWidth = pChannel->Width;
+    *pPeriod = pChannel->Period;
+  } while (Count != pChannel->Count);
+  return Count != 0;
+}
+
+/****************************************************************************
+ Function
+     PulseCapture_GetCount
+
+ Parameters
+     PulseChannel_t Channel - PULSE_CHANNEL(Name)
+
+ Returns
+     uint32_t - the pulses the channel has measured since it was set up
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint32_t PulseCapture_GetCount(PulseChannel_t Channel)
+{
+  if (Channel >= NUM_PULSE_CHANNELS)
+  {
+    return 0;
+  }
+  return Channels[Channel].Count;
+}
+
+/****************************************************************************
+ Function
+     PulseCapture<Ic>ISR
+
+ Description
+     One for each row of PULSE_CAPTURE_TABLE. Drains the module's FIFO,
+     each capture in order, & starts the module again if it overflowed
+
+ Notes
+     The IPL must match PULSE_CAPTURE_PRIORITY
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+#define PULSE_ISR_ROW(Name, Ic, Port, Bit, Pps, ActiveHigh)                   \
+  void __ISR(_INPUT_CAPTURE_##Ic##_VECTOR, IPL6SOFT)                          \
+  PulseCapture##Ic##ISR(void)                                                 \
+  {                                                                           \
+    ES_IsrStats_Enter(ES_ISR(PulseCapture##Ic), ES_ISR_LATENCY_UNKNOWN);      \
+    if (IC##Ic##CONbits.ICOV)                                                 \
+    {                                                                         \
+      volatile uint32_t Dummy;                                                \
+                                                                              \
+      IC##Ic##CONbits.ON = 0;                                                 \
+      while (IC##Ic##CONbits.ICBNE)                                           \
+      {                                                                       \
+        Dummy = IC##Ic##BUF;                                                  \
+      }                                                                       \
+      (void)Dummy;                                                            \
+      IFS0CLR = _IFS0_IC##Ic##IF_MASK;                                        \
+      RestartChannel(PULSE_CHANNEL(Name));                                    \
+    }                                                                         \
+    else                                                                      \
+    {                                                                         \
+      while (IC##Ic##CONbits.ICBNE)                                           \
+      {                                                                       \
+        NoteEdge(PULSE_CHANNEL(Name), (CaptureRaw_t)IC##Ic##BUF);             \
+      }                                                                       \
+      IFS0CLR = _IFS0_IC##Ic##IF_MASK;                                        \
+    }                                                                         \
+    ES_IsrStats_Exit(ES_ISR(PulseCapture##Ic));                               \
+  }
+
+PULSE_CAPTURE_TABLE(PULSE_ISR_ROW)
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+/****************************************************************************
+ Function
+     NoteEdge
+
+ Parameters
+     PulseChannel_t Channel - the channel that was captured
+     CaptureRaw_t Captured - the capture, as read from ICxBUF
+
+ Returns
+     None
+
+ Description
+     Extends the capture to 32 bits. A leading edge starts a pulse & times
+     the period, a trailing one ends it & tells the service
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static void NoteEdge(PulseChannel_t Channel, CaptureRaw_t Captured)
+{
+  PulseChannelState_t *pChannel = &Channels[Channel];
+  uint32_t Stamp = CaptureTimebase_Extend(Captured);
+
+  if (pChannel->NextIsLead)
+  {
+    pChannel->NextIsLead = false;
+    pChannel->LeadPeriod = pChannel->HaveLead ?
+        (Stamp - pChannel->LeadStamp) : 0;
+    pChannel->LeadStamp = Stamp;
+    pChannel->HaveLead = true;
+    return;
+  }
+  pChannel->NextIsLead = true;
+  // the width & period change together, the pulse is only done now
+  pChannel->Width = Stamp - pChannel->LeadStamp;
+  pChannel->Period = pChannel->LeadPeriod;
+  pChannel->Count++;
+  if ((PendingChannels & (1u << Channel)) == 0)
+  {
+    ES_Event_t ThisEvent;
+
+    PendingChannels |= (uint8_t)(1u << Channel);
+    ThisEvent.EventType = ES_PULSE_CAPTURED;
+    ThisEvent.EventParam = 0;
+    (void)ES_PostToServiceCoalesce(MyPriority, ThisEvent);
+  }
+}
+
+/****************************************************************************
+ Function
+     RestartChannel
+
+ Parameters
+     PulseChannel_t Channel - the channel whose module is off & empty
+
+ Returns
+     None
+
+ Description
+     Forgets the leading edge & switches the module back on, its next
+     capture is the FEDGE one again
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+#define PULSE_ON_ROW(Name, Ic, Port, Bit, Pps, ActiveHigh)                    \
+  case PULSE_CHANNEL(Name):                                                   \
+    IC##Ic##CONbits.ON = 1;                                                   \
+    break;
+
+static void RestartChannel(PulseChannel_t Channel)
+{
+  Channels[Channel].HaveLead = false;
+  Channels[Channel].NextIsLead = true;
+  switch (Channel)
+  {
+    PULSE_CAPTURE_TABLE(PULSE_ON_ROW)
+
+    default:
+      break;
+  }
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
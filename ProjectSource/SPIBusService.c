@@ -0,0 +1,514 @@
+/****************************************************************************
+ Module
+   SPIBusService.c
+
+ Revision
+   0.1
+
+ Description
+   Owns SPI_BUS_MODULE & runs the transactions of every follower on the
+   bus through SPIOperate_Transfer, each one with its device's chip select
+   low & the bus set up the way the device wants it (see SPIBusService.h).
+
+ Notes
+   The transactions waiting for the bus are in a ring, put in from task
+   context with the interrupts off & taken out by whoever starts the next
+   one: SPIBus_Queue when the bus is idle, or the DMA callback when the
+   transaction before is over. So once one starts, the rest follow back
+   to back from the ISR.
+
+   Each poll keeps the time it is next due. SPI_BUS_TIMER is only set for
+   the soonest of them, so a device polled slowly costs no dispatches in
+   between. A device's poll is not queued again until the last one is
+   over, so a slow bus delays a poll rather than piling them up.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  The timer runs to the next poll that is due rather
+                        than every tick
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Timers.h"
+#include "ES_Port.h"
+#include "SPIBusService.h"
+#include <xc.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+#if (SPI_BUS_QUEUE_DEPTH & (SPI_BUS_QUEUE_DEPTH - 1)) != 0
+#error "SPI_BUS_QUEUE_DEPTH must be a power of 2"
+#endif
+
+#define QUEUE_MASK (SPI_BUS_QUEUE_DEPTH - 1)
+#define NO_DEVICE NUM_SPI_BUS_DEVICES
+
+typedef struct
+{
+  SPI_PinMap_t      ChipSelect;
+  uint32_t          BitTime_ns;
+  SPI_Clock_t       ClockIdle;
+  SPI_ActiveEdge_t  ActiveEdge;
+  SPI_SamplePhase_t SamplePhase;
+  SPI_XferWidth_t   Width;
+} DeviceConfig_t;
+
+typedef struct
+{
+  SPIBus_Transaction_t Transaction;
+  uint8_t              TicksPerPoll;  // 0 when the device is not polled
+  uint16_t             NextDue;       // in ES_Timer_GetTime mS
+  bool                 IsPending;     // queued or running, not over yet
+} Poll_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void RunPolls(void);
+static void InitChipSelect(SPI_PinMap_t Pin);
+static void SetChipSelect(SPI_PinMap_t Pin, bool IsHigh);
+static void SelectDevice(SPIBus_Device_t Device);
+static bool IsLegal(const SPIBus_Transaction_t *pTransaction);
+static bool Put(const SPIBus_Transaction_t *pTransaction, bool IsPoll);
+static void StartNext(void);
+static void TransferDone(SPI_Module_t WhichModule);
+
+/*---------------------------- Module Variables ---------------------------*/
+#define SPI_BUS_CONFIG_ROW(Name, ChipSelect, BitTime_ns, ClockIdle,           \
+    ActiveEdge, SamplePhase, Width)                                           \
+  { ChipSelect, BitTime_ns, ClockIdle, ActiveEdge, SamplePhase, Width },
+static const DeviceConfig_t Devices[NUM_SPI_BUS_DEVICES] =
+{
+  SPI_BUS_DEVICE_TABLE(SPI_BUS_CONFIG_ROW)
+};
+
+static uint8_t MyPriority;
+static Poll_t  Polls[NUM_SPI_BUS_DEVICES];
+
+static SPIBus_Transaction_t Queue[SPI_BUS_QUEUE_DEPTH];
+static bool                 QueueIsPoll[SPI_BUS_QUEUE_DEPTH];
+static volatile uint8_t     Head;  // next to start
+static volatile uint8_t     Tail;  // next free
+static volatile uint16_t    Dropped;
+
+// the transaction that is running, copied out of the ring when it starts
+static SPIBus_Transaction_t Current;
+static bool                 CurrentIsPoll;
+static volatile bool        IsBusy;
+// the device the bus is set up for
+static SPIBus_Device_t      BusDevice;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     InitSPIBusService
+
+ Parameters
+     uint8_t : the priority of this service
+
+ Returns
+     bool, false if error in initialization, true otherwise
+
+ Description
+     Maps the data pins & drives every chip select high. The bus itself is
+     set up for the first device it is used for.
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool InitSPIBusService(uint8_t Priority)
+{
+  ES_Event_t      ThisEvent;
+  SPIBus_Device_t Device;
+
+  MyPriority = Priority;
+  Head = 0;
+  Tail = 0;
+  Dropped = 0;
+  IsBusy = false;
+  BusDevice = NO_DEVICE;
+  for (Device = 0; Device < NUM_SPI_BUS_DEVICES; Device++)
+  {
+    Polls[Device].TicksPerPoll = 0;
+    Polls[Device].IsPending = false;
+    InitChipSelect(Devices[Device].ChipSelect);
+  }
+
+  SPISetup_BasicConfig(SPI_BUS_MODULE);
+  SPISetup_SetLeader(SPI_BUS_MODULE, Devices[0].SamplePhase);
+  // the chip selects are driven here, one for each device
+  SPISetup_MapSSOutput(SPI_BUS_MODULE, SPI_NO_PIN);
+  SPISetup_MapSDOutput(SPI_BUS_MODULE, SPI_BUS_SDO_PIN);
+  // MapSDInput only maps in follower mode, so SDI1 goes on RPB8 by hand
+  SDI1R = 0b0100;
+  TRISBbits.TRISB8 = 1;
+  SPISetEnhancedBuffer(SPI_BUS_MODULE, true);
+
+  ThisEvent.EventType = ES_INIT;
+  return ES_PostToService(MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+     PostSPIBusService
+
+ Parameters
+     ES_Event_t ThisEvent, the event to post to the queue
+
+ Returns
+     bool false if the Enqueue operation failed, true otherwise
+
+ Description
+     Posts an event to this service's queue
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool PostSPIBusService(ES_Event_t ThisEvent)
+{
+  return ES_PostToService(MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+    RunSPIBusService
+
+ Parameters
+   ES_Event_t : the event to process
+
+ Returns
+   ES_Event_t, ES_NO_EVENT if no error ES_ERROR otherwise
+
+ Description
+   Queues each device's poll as it comes due, on SPI_BUS_TIMER
+
+ Author
+   Tianyu, 10/14/26
+****************************************************************************/
+ES_Event_t RunSPIBusService(ES_Event_t ThisEvent)
+{
+  ES_Event_t ReturnEvent;
+  ReturnEvent.EventType = ES_NO_EVENT; // assume no errors
+
+  switch (ThisEvent.EventType)
+  {
+    case ES_TIMEOUT:
+      if (ThisEvent.EventParam == SPI_BUS_TIMER)
+      {
+        RunPolls();
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  return ReturnEvent;
+}
+
+/****************************************************************************
+ Function
+     SPIBus_Queue
+
+ Parameters
+     const SPIBus_Transaction_t * - the transaction, copied
+
+ Returns
+     bool, false if it is illegal or the queue is full
+
+ Description
+     Queues a one-off transaction, which starts at once if the bus is idle.
+     Not for ISRs, it turns the interrupts off & on again.
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool SPIBus_Queue(const SPIBus_Transaction_t *pTransaction)
+{
+  bool ReturnVal;
+
+  if (!IsLegal(pTransaction))
+  {
+    return false;
+  }
+  EnterCritical();
+  ReturnVal = Put(pTransaction, false);
+  ExitCritical();
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+     SPIBus_SetPoll
+
+ Parameters
+     const SPIBus_Transaction_t * - the transaction, copied
+     uint8_t TicksPerPoll - SPI_BUS_TICK_MS ticks between polls, 0 to stop
+
+ Returns
+     bool, false if the transaction is illegal
+
+ Description
+     Sets up the poll of the transaction's device, replacing the one it had.
+     The first poll goes TicksPerPoll ticks from now. One that is already
+     queued still runs, with the transaction it was queued with. From task
+     context only, it sets SPI_BUS_TIMER
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool SPIBus_SetPoll(const SPIBus_Transaction_t *pTransaction,
+                    uint8_t TicksPerPoll)
+{
+  Poll_t *pPoll;
+
+  if (!IsLegal(pTransaction))
+  {
+    return false;
+  }
+  pPoll = &Polls[pTransaction->Device];
+  pPoll->Transaction = *pTransaction;
+  pPoll->TicksPerPoll = TicksPerPoll;
+  pPoll->NextDue = (uint16_t)(ES_Timer_GetTime() +
+      (uint16_t)TicksPerPoll * SPI_BUS_TICK_MS);
+  RunPolls();
+  return true;
+}
+
+/****************************************************************************
+ Function
+     SPIBus_StopPoll
+
+ Parameters
+     SPIBus_Device_t Device - the device to stop polling
+
+ Returns
+     None
+
+ Description
+     Stops the device's poll, one that is already queued still runs
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void SPIBus_StopPoll(SPIBus_Device_t Device)
+{
+  if (Device < NUM_SPI_BUS_DEVICES)
+  {
+    Polls[Device].TicksPerPoll = 0;
+    RunPolls();
+  }
+}
+
+/****************************************************************************
+ Function
+     SPIBus_GetDropped
+
+ Parameters
+     None
+
+ Returns
+     uint16_t, transactions turned away because the queue was full
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint16_t SPIBus_GetDropped(void)
+{
+  return Dropped;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+// queues the polls that are due & sets the timer for the next one
+static void RunPolls(void)
+{
+  uint16_t        Now = ES_Timer_GetTime();
+  uint16_t        Soonest = 0;
+  bool            AnyPolls = false;
+  SPIBus_Device_t Device;
+
+  for (Device = 0; Device < NUM_SPI_BUS_DEVICES; Device++)
+  {
+    Poll_t  *pPoll = &Polls[Device];
+    uint16_t Period = (uint16_t)pPoll->TicksPerPoll * SPI_BUS_TICK_MS;
+    uint16_t Wait;
+
+    if (Period == 0)
+    {
+      continue;
+    }
+    if ((int16_t)(pPoll->NextDue - Now) <= 0)
+    {
+      // the callback clears IsPending, so test & queue it as one step
+      EnterCritical();
+      if (!pPoll->IsPending && Put(&pPoll->Transaction, true))
+      {
+        pPoll->IsPending = true;
+      }
+      ExitCritical();
+      pPoll->NextDue = (uint16_t)(pPoll->NextDue + Period);
+      // a long way behind, start again from now rather than catch up
+      if ((int16_t)(pPoll->NextDue - Now) <= 0)
+      {
+        pPoll->NextDue = (uint16_t)(Now + Period);
+      }
+    }
+    Wait = (uint16_t)(pPoll->NextDue - Now);
+    if (!AnyPolls || (Wait < Soonest))
+    {
+      Soonest = Wait;
+    }
+    AnyPolls = true;
+  }
+  if (AnyPolls)
+  {
+    ES_Timer_InitTimer(SPI_BUS_TIMER, Soonest);
+  }
+  else
+  {
+    ES_Timer_StopTimer(SPI_BUS_TIMER);
+  }
+}
+
+// drives the pin high before making it a digital output, so the device
+// never sees a select
+static void InitChipSelect(SPI_PinMap_t Pin)
+{
+  SetChipSelect(Pin, true);
+  if (Pin <= SPI_RPA4)
+  {
+    TRISACLR = (1u << Pin);
+    ANSELACLR = (1u << Pin);
+  }
+  else
+  {
+    TRISBCLR = (1u << (Pin - SPI_RPB0));
+    ANSELBCLR = (1u << (Pin - SPI_RPB0));
+  }
+}
+
+static void SetChipSelect(SPI_PinMap_t Pin, bool IsHigh)
+{
+  if (Pin <= SPI_RPA4)
+  {
+    if (IsHigh)
+    {
+      LATASET = (1u << Pin);
+    }
+    else
+    {
+      LATACLR = (1u << Pin);
+    }
+  }
+  else
+  {
+    if (IsHigh)
+    {
+      LATBSET = (1u << (Pin - SPI_RPB0));
+    }
+    else
+    {
+      LATBCLR = (1u << (Pin - SPI_RPB0));
+    }
+  }
+}
+
+// only touches the module when the device is not the one it is set up for
+static void SelectDevice(SPIBus_Device_t Device)
+{
+  const DeviceConfig_t *pConfig = &Devices[Device];
+
+  if (Device == BusDevice)
+  {
+    return;
+  }
+  SPISetup_DisableSPI(SPI_BUS_MODULE);
+  SPISetup_SetLeader(SPI_BUS_MODULE, pConfig->SamplePhase);
+  SPISetup_SetBitTime(SPI_BUS_MODULE, pConfig->BitTime_ns);
+  SPISetup_SetClockIdleState(SPI_BUS_MODULE, pConfig->ClockIdle);
+  SPISetup_SetActiveEdge(SPI_BUS_MODULE, pConfig->ActiveEdge);
+  SPISetup_SetXferWidth(SPI_BUS_MODULE, pConfig->Width);
+  SPISetup_EnableSPI(SPI_BUS_MODULE);
+  BusDevice = Device;
+}
+
+static bool IsLegal(const SPIBus_Transaction_t *pTransaction)
+{
+  static const uint8_t WordBytes[] = { 1, 2, 4 };
+
+  return (pTransaction->Device < NUM_SPI_BUS_DEVICES) &&
+         (pTransaction->pRxData != NULL) &&
+         (pTransaction->Length != 0) &&
+         ((pTransaction->Length %
+           WordBytes[Devices[pTransaction->Device].Width]) == 0);
+}
+
+// with the interrupts off, or from the DMA ISR
+static bool Put(const SPIBus_Transaction_t *pTransaction, bool IsPoll)
+{
+  if ((uint8_t)(Tail - Head) >= SPI_BUS_QUEUE_DEPTH)
+  {
+    Dropped++;
+    return false;
+  }
+  Queue[Tail & QUEUE_MASK] = *pTransaction;
+  QueueIsPoll[Tail & QUEUE_MASK] = IsPoll;
+  Tail++;
+  if (!IsBusy)
+  {
+    StartNext();
+  }
+  return true;
+}
+
+// starts the oldest waiting transaction, if there is one
+static void StartNext(void)
+{
+  while (Head != Tail)
+  {
+    Current = Queue[Head & QUEUE_MASK];
+    CurrentIsPoll = QueueIsPoll[Head & QUEUE_MASK];
+    Head++;
+
+    SelectDevice(Current.Device);
+    SetChipSelect(Devices[Current.Device].ChipSelect, false);
+    IsBusy = true;
+    if (SPIOperate_Transfer(SPI_BUS_MODULE, Current.pTxData,
+        Current.pRxData, Current.Length, TransferDone))
+    {
+      return;
+    }
+    // the HAL turned it down, so let the next one have the bus
+    IsBusy = false;
+    SetChipSelect(Devices[Current.Device].ChipSelect, true);
+    Dropped++;
+    if (CurrentIsPoll)
+    {
+      Polls[Current.Device].IsPending = false;
+    }
+  }
+}
+
+// called from the DMA ISR when the last word of Current is in
+static void TransferDone(SPI_Module_t WhichModule)
+{
+  (void)WhichModule;
+
+  SetChipSelect(Devices[Current.Device].ChipSelect, true);
+  IsBusy = false;
+  if (CurrentIsPoll)
+  {
+    Polls[Current.Device].IsPending = false;
+  }
+  if (Current.pPostDone != NULL)
+  {
+    ES_Event_t DoneEvent;
+
+    DoneEvent.EventType = ES_SPI_TRANSFER_DONE;
+    DoneEvent.EventParam = Current.Tag;
+    Current.pPostDone(DoneEvent);
+  }
+  StartNext();
+}
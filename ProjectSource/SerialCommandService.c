@@ -0,0 +1,491 @@
+/****************************************************************************
+ Module
+   SerialCommandService.c
+
+ Revision
+   0.1
+
+ Description
+   Takes the console input that Terminal_RxISR has buffered, picks the
+   "$...<CR>" command lines out of it & runs them (see
+   SerialCommandService.h). Everything else goes out as ES_NEW_KEY.
+
+ Notes
+   The receive ISR calls NoteRxData for each batch of bytes. That posts
+   one ES_SERIAL_RX & no more until the service has run, so a burst of
+   input costs one event rather than one per byte. The service clears
+   RxEventPending before it empties the buffer, so a byte that comes in
+   while it works brings another ES_SERIAL_RX rather than being missed.
+
+   Stray keys are posted with ES_PostAll as they are found. A burst of
+   more of them than the smallest queue holds loses some, a typed key
+   comes far slower than that.
+
+   CMD puts its bytes in CommandPipeline from the run function, as
+   CommandRetrieveService does, so the two writers can't come in part way
+   through each other & all of a CMD line goes in together.
+
+   Without USE_UART_RX_ISR, Check4Keystroke posts the input as keys & this
+   service has nothing to do.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  SET takes the names from the parameter store, added
+                        SAVE & DEFAULTS
+ 10/14/26       Tianyu  CMD no longer turns the interrupts off, the other
+                        pipeline writer is a service
+ 10/14/26       Tianyu  SET TELEM sets the telemetry period
+ 10/14/26       Tianyu  Added BAUD
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_General.h"
+#include "SerialCommandService.h"
+#include "CommonDefinitions.h"
+#include "CommandPipeline.h"
+#include "MainLogicFSM.h"
+#include "ParamStore.h"
+#include "terminal.h"
+#include "dbprintf.h"
+#include <string.h>
+#include <stdlib.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+#define FRAME_START '$'
+#define CHECKSUM_MARK '*'
+
+// bytes taken from the receive buffer at a time
+#define RX_CHUNK 16
+
+// most command bytes on one CMD line
+#define MAX_CMD_BYTES COMMAND_PIPELINE_DEPTH
+
+/*---------------------------- Module Functions ---------------------------*/
+#ifdef USE_UART_RX_ISR
+static void NoteRxData(void);
+#endif
+static void TakeByte(uint8_t NewByte);
+static void RunLine(void);
+static const char *RunCmd(char *pArgs);
+static const char *RunSet(char *pArgs);
+static const char *RunBaud(char *pArgs);
+static const char *RunSave(char *pArgs);
+static const char *RunDefaults(char *pArgs);
+static bool ParseNumber(const char *pToken, int Base, uint32_t Max,
+                        uint32_t *pValue);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint8_t MyPriority;
+static volatile bool RxEventPending;
+
+// the line being put together, without the '$'
+static char    Line[SERIAL_LINE_MAX + 1];
+static uint8_t LineLength;
+static bool    InLine;
+static bool    LineTooLong;
+
+// a BAUD line's change, made once its $OK has gone out at the old rate.
+// BAUD_AUTO for the auto-baud
+#define BAUD_AUTO 0xFFFFFFFFu
+static uint32_t PendingBaud;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     InitSerialCommandService
+
+ Parameters
+     uint8_t : the priority of this service
+
+ Returns
+     bool, false if error in initialization, true otherwise
+
+ Description
+     Registers for the receive notifications & starts with no line
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool InitSerialCommandService(uint8_t Priority)
+{
+  ES_Event_t ThisEvent;
+
+  MyPriority = Priority;
+  InLine = false;
+  LineLength = 0;
+  LineTooLong = false;
+  PendingBaud = 0;
+  RxEventPending = false;
+#ifdef USE_UART_RX_ISR
+  Terminal_SetRxNotify(NoteRxData);
+#endif
+
+  ThisEvent.EventType = ES_INIT;
+  return ES_PostToService(MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+     PostSerialCommandService
+
+ Parameters
+     ES_Event_t ThisEvent, the event to post to the queue
+
+ Returns
+     bool false if the Enqueue operation failed, true otherwise
+
+ Description
+     Posts an event to this service's queue
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool PostSerialCommandService(ES_Event_t ThisEvent)
+{
+  return ES_PostToService(MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+    RunSerialCommandService
+
+ Parameters
+   ES_Event_t : the event to process
+
+ Returns
+   ES_Event_t, ES_NO_EVENT if no error ES_ERROR otherwise
+
+ Description
+   Empties the receive buffer on ES_SERIAL_RX, running each line as it is
+   completed
+
+ Author
+   Tianyu, 10/14/26
+****************************************************************************/
+ES_Event_t RunSerialCommandService(ES_Event_t ThisEvent)
+{
+  ES_Event_t ReturnEvent;
+  ReturnEvent.EventType = ES_NO_EVENT; // assume no errors
+
+  switch (ThisEvent.EventType)
+  {
+    case ES_SERIAL_RX:
+    {
+      uint8_t Chunk[RX_CHUNK];
+      size_t  NumRead;
+      size_t  i;
+
+      RxEventPending = false;
+      while ((NumRead = Terminal_ReadBytes(Chunk, sizeof(Chunk))) != 0)
+      {
+        for (i = 0; i < NumRead; i++)
+        {
+          TakeByte(Chunk[i]);
+        }
+      }
+    }
+    break;
+
+    default:  // ES_INIT, & the ES_NEW_KEYs this service posts to everyone
+      break;
+  }
+
+  return ReturnEvent;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+#ifdef USE_UART_RX_ISR
+// called from Terminal_RxISR
+static void NoteRxData(void)
+{
+  if (!RxEventPending)
+  {
+    ES_Event_t RxEvent;
+
+    RxEventPending = true;
+    RxEvent.EventType = ES_SERIAL_RX;
+    RxEvent.EventParam = 0;
+    if (!ES_PostToService(MyPriority, RxEvent))
+    {
+      RxEventPending = false;   // try again with the next byte
+    }
+  }
+}
+#endif
+
+static void TakeByte(uint8_t NewByte)
+{
+  if (NewByte == FRAME_START)
+  {
+    // a '$' always starts over, a line that was cut off is dropped
+    InLine = true;
+    LineLength = 0;
+    LineTooLong = false;
+  }
+  else if (InLine)
+  {
+    if ((NewByte == '\r') || (NewByte == '\n'))
+    {
+      InLine = false;
+      if (LineTooLong)
+      {
+        DB_printf("$ERR LONG\r\n");
+      }
+      else
+      {
+        Line[LineLength] = '\0';
+        RunLine();
+      }
+    }
+    else if (LineLength < SERIAL_LINE_MAX)
+    {
+      Line[LineLength++] = (char)NewByte;
+    }
+    else
+    {
+      LineTooLong = true;
+    }
+  }
+  else if ((NewByte != '\r') && (NewByte != '\n'))
+  {
+    // the line ends that follow a command aren't keys
+    ES_Event_t KeyEvent;
+
+    KeyEvent.EventType = ES_NEW_KEY;
+    KeyEvent.EventParam = NewByte;
+    ES_PostAll(KeyEvent);
+  }
+}
+
+// checks the checksum, if there is one, & runs the verb
+static void RunLine(void)
+{
+  char       *pMark = strchr(Line, CHECKSUM_MARK);
+  char       *pArgs;
+  const char *pError;
+
+  if (pMark != NULL)
+  {
+    uint8_t  Sum = 0;
+    uint32_t Given;
+    char    *pByte;
+
+    for (pByte = Line; pByte != pMark; pByte++)
+    {
+      Sum ^= (uint8_t)*pByte;
+    }
+    if ((strlen(pMark + 1) != 2) || !ParseNumber(pMark + 1, 16, 0xFF, &Given)
+        || (Given != Sum))
+    {
+      DB_printf("$ERR CSUM\r\n");
+      return;
+    }
+    *pMark = '\0';
+  }
+
+  pArgs = strchr(Line, ' ');
+  if (pArgs != NULL)
+  {
+    *pArgs++ = '\0';
+  }
+  else
+  {
+    pArgs = Line + strlen(Line);
+  }
+
+  if (strcmp(Line, "CMD") == 0)
+  {
+    pError = RunCmd(pArgs);
+  }
+  else if (strcmp(Line, "SET") == 0)
+  {
+    pError = RunSet(pArgs);
+  }
+  else if (strcmp(Line, "BAUD") == 0)
+  {
+    pError = RunBaud(pArgs);
+  }
+  else if (strcmp(Line, "SAVE") == 0)
+  {
+    pError = RunSave(pArgs);
+  }
+  else if (strcmp(Line, "DEFAULTS") == 0)
+  {
+    pError = RunDefaults(pArgs);
+  }
+  else
+  {
+    pError = "VERB";
+  }
+
+  if (pError == NULL)
+  {
+    DB_printf("$OK\r\n");
+  }
+  else
+  {
+    DB_printf("$ERR %s\r\n", pError);
+  }
+
+  if (PendingBaud == BAUD_AUTO)
+  {
+    // the other end sends 'U' at its new rate after it sees the $OK
+    while (!Terminal_IsXmitBufferEmpty())
+    {
+      Terminal_MoveBuffer2UART();
+    }
+    Terminal_StartAutoBaud();
+  }
+  else if (PendingBaud != 0)
+  {
+    (void)Terminal_SetBaud(PendingBaud);
+  }
+  PendingBaud = 0;
+}
+
+// CMD hh [hh ...], all of them are queued or none are
+static const char *RunCmd(char *pArgs)
+{
+  uint8_t  Commands[MAX_CMD_BYTES];
+  uint8_t  NumCommands = 0;
+  uint8_t  i;
+  uint32_t Value;
+  char    *pToken;
+
+  for (pToken = strtok(pArgs, " "); pToken != NULL;
+       pToken = strtok(NULL, " "))
+  {
+    if ((NumCommands == MAX_CMD_BYTES) ||
+        !ParseNumber(pToken, 16, 0xFF, &Value) ||
+        !COMMAND_IS_VALID(Value))
+    {
+      return "ARG";
+    }
+    Commands[NumCommands++] = (uint8_t)Value;
+  }
+  if (NumCommands == 0)
+  {
+    return "ARG";
+  }
+
+  if (NumCommands > (COMMAND_PIPELINE_DEPTH - CommandPipeline_Count()))
+  {
+    return "FULL";
+  }
+  for (i = 0; i < NumCommands; i++)
+  {
+    (void)CommandPipeline_Put(Commands[i]);
+  }
+
+  for (i = 0; i < NumCommands; i++)
+  {
+    ES_Event_t CommandEvent;
+
+    CommandEvent.EventType = ES_COMMAND_RETRIEVED;
+    CommandEvent.EventParam = Commands[i];
+    PostMainLogicFSM(CommandEvent);
+  }
+  return NULL;
+}
+
+// SET <name> <value>, the value in decimal or 0x hex
+static const char *RunSet(char *pArgs)
+{
+  char     *pName = strtok(pArgs, " ");
+  char     *pValue = strtok(NULL, " ");
+  uint32_t  Value;
+  ParamId_t Id;
+
+  if ((pName == NULL) || (pValue == NULL) || (strtok(NULL, " ") != NULL))
+  {
+    return "ARG";
+  }
+  if (!ParamStore_Find(pName, &Id))
+  {
+    return "NAME";
+  }
+  if (!ParseNumber(pValue, 0, 0xFFFF, &Value) ||
+      !ParamStore_Set(Id, (uint16_t)Value))
+  {
+    return "ARG";
+  }
+  return NULL;
+}
+
+// SAVE, only while stopped as the erase stalls everything for ~20mS
+static const char *RunSave(char *pArgs)
+{
+  if (strtok(pArgs, " ") != NULL)
+  {
+    return "ARG";
+  }
+  if (QueryMainLogicFSM() != Stopped)
+  {
+    return "BUSY";
+  }
+  if (!ParamStore_Save())
+  {
+    return "FLASH";
+  }
+  return NULL;
+}
+
+// DEFAULTS, back to the built in values until the next SAVE or reset
+static const char *RunDefaults(char *pArgs)
+{
+  if (strtok(pArgs, " ") != NULL)
+  {
+    return "ARG";
+  }
+  ParamStore_Defaults();
+  return NULL;
+}
+
+// BAUD <rate> or BAUD AUTO, the change waits for the reply to go out
+static const char *RunBaud(char *pArgs)
+{
+  char    *pRate = strtok(pArgs, " ");
+  uint32_t Rate;
+
+  if ((pRate == NULL) || (strtok(NULL, " ") != NULL))
+  {
+    return "ARG";
+  }
+  if (strcmp(pRate, "AUTO") == 0)
+  {
+    PendingBaud = BAUD_AUTO;
+    return NULL;
+  }
+  if (!ParseNumber(pRate, 10, BAUD_AUTO - 1, &Rate) ||
+      !Terminal_IsBaudSupported(Rate))
+  {
+    return "ARG";
+  }
+  PendingBaud = Rate;
+  return NULL;
+}
+
+// the whole token has to be a number no bigger than Max
+static bool ParseNumber(const char *pToken, int Base, uint32_t Max,
+                        uint32_t *pValue)
+{
+  char         *pEnd;
+  unsigned long Value;
+
+  if ((*pToken == '\0') || (*pToken == '-'))
+  {
+    return false;
+  }
+  Value = strtoul(pToken, &pEnd, Base);
+  if ((*pEnd != '\0') || (Value > Max))
+  {
+    return false;
+  }
+  *pValue = (uint32_t)Value;
+  return true;
+}
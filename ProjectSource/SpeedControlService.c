@@ -0,0 +1,886 @@
+/****************************************************************************
+ Module
+   SpeedControlService.c
+
+ Revision
+   0.1
+
+ Description
+   Closed loop speed control for the two drive wheels. Each wheel's encoder
+   is captured on its own Input Capture module, and a PI loop run from the
+   Timer4 interrupt at CONTROL_RATE_HZ sets both PWM duties through
+   DCMotor_RampTo, so a step in speed doesn't step the motor current. A
+   move can be given a distance, in which case each wheel slows as it
+   nears the end and stops when it gets there, and the service posts
+   ES_MOVE_COMPLETE to MainLogicFSM once both are done.
+   Each wheel's speed through a move comes from its trapezoidal profile
+   (MotionProfile.c), so it speeds up & brakes at a set rate.
+   On a straight move, both wheels at the same speed in the same direction,
+   a heading hold loop trims the two duties apart, so mismatched motors
+   don't curve the robot.
+   The control loop also steps the odometry (Odometry.c) at
+   ODOMETRY_RATE_HZ, from each wheel's odometer.
+
+ Notes
+   The captures are on Timer3, which CaptureTimebase extends to 32 bits,
+   so encoder periods of up to STALL_MS are measured from the captured
+   values themselves, with no ISR latency in them. The time base runs at
+   PBCLK/8 (PBCLK in the CAPTURE_TIMEBASE_32BIT build), shifting a period
+   right by ENCODER_STAMP_SHIFT gives ENCODER_TIMER_PRESCALE ticks for
+   FP_PeriodToRPM.
+
+   The capture ISRs are at a higher priority than the control loop, so the
+   loop reads the capture data with a retry rather than blocking them.
+
+   The encoders are single channel, measured speeds are magnitudes and the
+   direction is whatever was commanded.
+
+   The heading hold is a PI loop on the wheels' difference: the P term on
+   the difference in measured speed & the I term on the difference in
+   captures since the move started, which is the speed difference
+   integrated exactly, with no rounding to wind up. Its trim is taken off
+   the left duty & added to the right, on top of each wheel's own feed
+   forward & PI, & is limited to HEADING_TRIM_MAX.
+
+   A wheel's odometer is its captures since reset, counted down while it
+   is commanded in REVERSE. Unlike Captures it isn't cleared by a move.
+
+   Pins:
+     Left encoder  - IC2 on RB9
+     Right encoder - IC5 on RA2
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Odometers for the odometry, stepped from the loop
+ 10/14/26       Tianyu  Heading hold on straight moves
+ 10/14/26       Tianyu  Moves follow a trapezoidal profile, replacing the
+                        linear slow down over the last 16 captures
+ 10/14/26       Tianyu  The encoder & control loop ISRs report to ES_IsrStats
+ 10/14/26       Tianyu  32 bit captures in the CAPTURE_TIMEBASE_32BIT build
+ 10/14/26       Tianyu  Periods come from the captured Timer3 values, through
+                        CaptureTimebase, rather than core timer stamps
+ 10/14/26       Tianyu  Gains rescaled for 1:8 PWM ticks
+ 10/14/26       Tianyu  Loop output goes through the DCMotor ramp, stops don't
+ 10/14/26       Tianyu  Both wheels set at once through DCMotor_SetOutputs
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "SpeedControlService.h"
+#include "DCMotorService.h"
+#include "MainLogicFSM.h"
+#include "MotionProfile.h"
+#include "Odometry.h"
+#include "binlog.h"
+#include "CaptureTimebase.h"
+#include "ES_IsrStats.h"
+#include <xc.h>
+#include <sys/attribs.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// Control loop rate, Timer4 at 1:8 gives 2.5MHz
+#define CONTROL_RATE_HZ 1000
+#define CONTROL_TIMER_PRESCALE 8
+// core timer counts per Timer4 tick
+#define CONTROL_TICKS_TO_CORE \
+  (CORE_TIMER_FREQ / (PBCLK_FREQ / CONTROL_TIMER_PRESCALE))
+#define CONTROL_PERIOD_TICKS \
+  ((PBCLK_FREQ / CONTROL_TIMER_PRESCALE / CONTROL_RATE_HZ) - 1)
+
+#if CONTROL_RATE_HZ != PROFILE_RATE_HZ
+#error "The motion profiles are stepped at CONTROL_RATE_HZ"
+#endif
+
+// control loop passes per odometry step
+#define ODOMETRY_DIVIDER (CONTROL_RATE_HZ / ODOMETRY_RATE_HZ)
+
+#if (ODOMETRY_DIVIDER * ODOMETRY_RATE_HZ) != CONTROL_RATE_HZ
+#error "ODOMETRY_RATE_HZ must divide CONTROL_RATE_HZ"
+#endif
+
+// the shift that turns capture time base ticks into encoder timer ticks
+#ifdef CAPTURE_TIMEBASE_32BIT
+#define ENCODER_STAMP_SHIFT 8
+#else
+#define ENCODER_STAMP_SHIFT 5
+#endif
+
+#if (CAPTURE_TIMEBASE_HZ >> ENCODER_STAMP_SHIFT) != FP_ENCODER_TICK_HZ
+#error "ENCODER_STAMP_SHIFT doesn't match ENCODER_TIMER_PRESCALE"
+#endif
+
+// a wheel with no capture for this long is taken to be stopped
+#define STALL_MS 200
+#define STALL_COUNTS ((uint32_t)(CAPTURE_TIMEBASE_HZ / 1000) * STALL_MS)
+
+// Controller gains, in duty ticks per RPM (P) and per RPM-second (I).
+// The feed forward term is the duty that would give the speed open loop
+#define KP_TICKS_PER_RPM 10
+#define KI_TICKS_PER_RPM_S 100
+#define FF_DUTY_PER_RPM_Q8 ((DUTY_MAX_TICKS * 256) / MAX_RPM)
+#define KP_Q8 (KP_TICKS_PER_RPM * 256)
+#define KI_PER_TICK_Q16 \
+  ((int32_t)(((int64_t)KI_TICKS_PER_RPM_S << 16) / CONTROL_RATE_HZ))
+#define INTEGRAL_LIMIT ((int32_t)DUTY_MAX_TICKS << 16)
+
+// Heading hold gains, in duty ticks per RPM of speed difference (P) and
+// per capture of distance difference (I), & the most it trims each duty by
+#define HEADING_KP_TICKS_PER_RPM 4
+#define HEADING_KI_TICKS_PER_CAPTURE 8
+#define HEADING_KP_Q8 (HEADING_KP_TICKS_PER_RPM * 256)
+#define HEADING_TRIM_MAX 100
+
+#define NUM_WHEELS 2
+
+typedef struct
+{
+  // written by the capture ISR
+  volatile uint32_t LastStamp;  // time of the last capture
+  volatile uint32_t Period;     // time base ticks between the last two
+  volatile uint32_t Captures;   // captures since the move started
+  volatile int32_t  Odometer;   // captures since reset, down in REVERSE
+  volatile bool     HaveStamp;
+  // written by the control loop, or with it locked out
+  MotionProfile_t Profile;      // the commanded speed through the move
+  FP_Q16_t  Measured;
+  int32_t   Integral;           // Q16.16 duty ticks
+  uint32_t  Goal;               // captures for the move, 0 for no limit
+  uint8_t   Direction;
+  bool      Active;
+} Wheel_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void ConfigureEncoderCapture(void);
+static void ConfigureControlTimer(void);
+static void NoteCapture(Wheel_t *pWheel, uint8_t NumCaptures,
+                        CaptureRaw_t Captured);
+static FP_Q16_t MeasureSpeed(Wheel_t *pWheel, uint32_t Now,
+                             uint32_t *pCaptures);
+static uint16_t UpdateWheel(Wheel_t *pWheel, FP_Q16_t Measured,
+                            uint32_t Captures);
+static int32_t HeadingTrim(uint32_t CapturesLeft, uint32_t CapturesRight);
+static uint16_t TrimDuty(uint16_t Duty, int32_t Trim);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint8_t MyPriority;
+static Wheel_t Wheels[NUM_WHEELS];
+// true from SpeedControl_StartMove with a distance until the move is done
+static volatile bool MoveInProgress = false;
+// true while the move is straight, so the heading hold runs
+static volatile bool HoldHeading = false;
+// control loop passes since the last odometry step
+static uint8_t OdometryCount = 0;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     InitSpeedControlService
+
+ Parameters
+     uint8_t : the priority of this service
+
+ Returns
+     bool, false if error in initialization, true otherwise
+
+ Description
+     Sets up the encoder captures and starts the control loop timer with
+     both wheels stopped
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool InitSpeedControlService(uint8_t Priority)
+{
+  ES_Event_t ThisEvent;
+  uint8_t    i;
+
+  MyPriority = Priority;
+
+  for (i = 0; i < NUM_WHEELS; i++)
+  {
+    Wheels[i].HaveStamp = false;
+    Wheels[i].Period = 0;
+    Wheels[i].Captures = 0;
+    Wheels[i].Odometer = 0;
+    MotionProfile_Start(&Wheels[i].Profile, 0, SPEED_CONTROL_NO_LIMIT, 0);
+    Wheels[i].Measured = 0;
+    Wheels[i].Integral = 0;
+    Wheels[i].Goal = SPEED_CONTROL_NO_LIMIT;
+    Wheels[i].Direction = FORWARD;
+    Wheels[i].Active = false;
+  }
+  MoveInProgress = false;
+  HoldHeading = false;
+
+  OdometryCount = 0;
+  Odometry_Init(0, 0);
+  CaptureTimebase_Init();
+  ConfigureEncoderCapture();
+  ConfigureControlTimer();
+
+  ThisEvent.EventType = ES_INIT;
+  return ES_PostToService(MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+     PostSpeedControlService
+
+ Parameters
+     ES_Event_t ThisEvent, the event to post to the queue
+
+ Returns
+     bool false if the Enqueue operation failed, true otherwise
+
+ Description
+     Posts an event to this service's queue
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool PostSpeedControlService(ES_Event_t ThisEvent)
+{
+  return ES_PostToService(MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+    RunSpeedControlService
+
+ Parameters
+   ES_Event_t : the event to process
+
+ Returns
+   ES_Event_t, ES_NO_EVENT if no error ES_ERROR otherwise
+
+ Description
+   Passes move completions from the control loop on to MainLogicFSM
+
+ Author
+   Tianyu, 10/14/26
+****************************************************************************/
+ES_Event_t RunSpeedControlService(ES_Event_t ThisEvent)
+{
+  ES_Event_t ReturnEvent;
+  ReturnEvent.EventType = ES_NO_EVENT; // assume no errors
+
+  switch (ThisEvent.EventType)
+  {
+    case ES_INIT:
+      break;
+
+    case ES_MOVE_COMPLETE:
+      BINLOG2("Move complete L:%u R:%u\r\n", Wheels[LEFT_MOTOR].Captures,
+          Wheels[RIGHT_MOTOR].Captures);
+      PostMainLogicFSM(ThisEvent);
+      break;
+
+    default:
+      break;
+  }
+
+  return ReturnEvent;
+}
+
+/****************************************************************************
+ Function
+     SpeedControl_StartMove
+
+ Parameters
+     FP_Q16_t SpeedLeft, SpeedRight - wheel speeds in RPM, Q16.16
+     uint8_t DirLeft, DirRight - FORWARD or REVERSE
+     uint32_t Captures - distance for each wheel in encoder captures, or
+                         SPEED_CONTROL_NO_LIMIT
+
+ Returns
+     None
+
+ Description
+     Starts both wheels on a new move. With a distance, ES_MOVE_COMPLETE is
+     posted to MainLogicFSM when both wheels have covered it. When the two
+     speeds & directions are the same the heading is held
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void SpeedControl_StartMove(FP_Q16_t SpeedLeft, FP_Q16_t SpeedRight,
+                            uint8_t DirLeft, uint8_t DirRight,
+                            uint32_t Captures)
+{
+  FP_Q16_t Speed[NUM_WHEELS];
+  uint8_t  Dir[NUM_WHEELS];
+  uint8_t  i;
+
+  Speed[LEFT_MOTOR] = SpeedLeft;
+  Speed[RIGHT_MOTOR] = SpeedRight;
+  Dir[LEFT_MOTOR] = DirLeft;
+  Dir[RIGHT_MOTOR] = DirRight;
+
+  EnterCritical();
+  for (i = 0; i < NUM_WHEELS; i++)
+  {
+    // keep the integral & the speed across a change, but not a reversal
+    if (!Wheels[i].Active || (Wheels[i].Direction != Dir[i]))
+    {
+      Wheels[i].Integral = 0;
+      MotionProfile_Start(&Wheels[i].Profile, Speed[i], Captures, 0);
+    }
+    else
+    {
+      MotionProfile_Start(&Wheels[i].Profile, Speed[i], Captures,
+          Wheels[i].Profile.Setpoint);
+    }
+    Wheels[i].Direction = Dir[i];
+    Wheels[i].Goal = Captures;
+    Wheels[i].Captures = 0;
+    Wheels[i].Active = true;
+  }
+  MoveInProgress = (Captures != SPEED_CONTROL_NO_LIMIT);
+  // both distances start again from 0, so does the heading error
+  HoldHeading = (SpeedLeft == SpeedRight) && (DirLeft == DirRight) &&
+      (SpeedLeft != 0);
+  ExitCritical();
+
+  BINLOG4("StartMove L:%u R:%u Dir:%u%u\r\n", FP_Q16_ROUND(SpeedLeft),
+      FP_Q16_ROUND(SpeedRight), DirLeft, DirRight);
+}
+
+/****************************************************************************
+ Function
+     SpeedControl_Stop
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Stops both wheels at once and cancels any move, no ES_MOVE_COMPLETE
+     is posted for it
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void SpeedControl_Stop(void)
+{
+  uint8_t i;
+
+  EnterCritical();
+  for (i = 0; i < NUM_WHEELS; i++)
+  {
+    Wheels[i].Active = false;
+    MotionProfile_Start(&Wheels[i].Profile, 0, SPEED_CONTROL_NO_LIMIT, 0);
+    Wheels[i].Integral = 0;
+  }
+  MoveInProgress = false;
+  HoldHeading = false;
+  ExitCritical();
+  DCMotor_SetOutputs(0, 0, Wheels[LEFT_MOTOR].Direction,
+      Wheels[RIGHT_MOTOR].Direction);
+}
+
+/****************************************************************************
+ Function
+     SpeedControl_GetSpeed
+
+ Parameters
+     uint8_t Wheel - LEFT_MOTOR or RIGHT_MOTOR
+
+ Returns
+     FP_Q16_t - the wheel speed measured on the last control loop pass
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+FP_Q16_t SpeedControl_GetSpeed(uint8_t Wheel)
+{
+  return Wheels[Wheel].Measured;
+}
+
+/****************************************************************************
+ Function
+     SpeedControl_GetDistance
+
+ Parameters
+     uint8_t Wheel - LEFT_MOTOR or RIGHT_MOTOR
+
+ Returns
+     uint32_t - encoder captures since the current move started
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+uint32_t SpeedControl_GetDistance(uint8_t Wheel)
+{
+  return Wheels[Wheel].Captures;
+}
+
+/****************************************************************************
+ Function
+     LeftEncoderISR
+
+ Description
+     IC2 capture from the left encoder, every IC_PRESCALE encoder edges
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void __ISR(_INPUT_CAPTURE_2_VECTOR, IPL6SOFT) LeftEncoderISR(void)
+{
+  uint8_t      NumCaptures = 0;
+  CaptureRaw_t Captured = 0;
+
+  ES_IsrStats_Enter(ES_ISR(LeftEncoder), ES_ISR_LATENCY_UNKNOWN);
+  // the newest capture times the period, the count is the distance
+  while (IC2CONbits.ICBNE)
+  {
+    Captured = (CaptureRaw_t)IC2BUF;
+    NumCaptures++;
+  }
+  IFS0CLR = _IFS0_IC2IF_MASK;
+  if (NumCaptures != 0)
+  {
+    ES_IsrStats_NoteLatency(ES_ISR(LeftEncoder), CAPTURE_TIMEBASE_TO_CORE(
+        (CaptureRaw_t)(CAPTURE_TIMEBASE_NOW() - Captured)));
+  }
+  NoteCapture(&Wheels[LEFT_MOTOR], NumCaptures, Captured);
+  ES_IsrStats_Exit(ES_ISR(LeftEncoder));
+}
+
+/****************************************************************************
+ Function
+     RightEncoderISR
+
+ Description
+     IC5 capture from the right encoder, every IC_PRESCALE encoder edges
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void __ISR(_INPUT_CAPTURE_5_VECTOR, IPL6SOFT) RightEncoderISR(void)
+{
+  uint8_t      NumCaptures = 0;
+  CaptureRaw_t Captured = 0;
+
+  ES_IsrStats_Enter(ES_ISR(RightEncoder), ES_ISR_LATENCY_UNKNOWN);
+  while (IC5CONbits.ICBNE)
+  {
+    Captured = (CaptureRaw_t)IC5BUF;
+    NumCaptures++;
+  }
+  IFS0CLR = _IFS0_IC5IF_MASK;
+  if (NumCaptures != 0)
+  {
+    ES_IsrStats_NoteLatency(ES_ISR(RightEncoder), CAPTURE_TIMEBASE_TO_CORE(
+        (CaptureRaw_t)(CAPTURE_TIMEBASE_NOW() - Captured)));
+  }
+  NoteCapture(&Wheels[RIGHT_MOTOR], NumCaptures, Captured);
+  ES_IsrStats_Exit(ES_ISR(RightEncoder));
+}
+
+/****************************************************************************
+ Function
+     ControlLoopISR
+
+ Description
+     Timer4 interrupt at CONTROL_RATE_HZ. Measures both wheel speeds, runs
+     the PI loop for each active wheel, trims the duties for the heading on
+     a straight move and ends the move when both wheels have covered the
+     distance. Every ODOMETRY_DIVIDER passes it steps the odometry
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void __ISR(_TIMER_4_VECTOR, IPL5SOFT) ControlLoopISR(void)
+{
+  uint32_t Now;
+  uint32_t Captures[NUM_WHEELS];
+  uint16_t Duty[NUM_WHEELS];
+  uint8_t  i;
+  bool     AnyActive = false;
+  bool     AnyDriven = false;
+
+  // TMR4 has counted up from 0 since the period match
+  ES_IsrStats_Enter(ES_ISR(ControlLoop),
+      (uint32_t)TMR4 * CONTROL_TICKS_TO_CORE);
+  Now = CaptureTimebase_GetTime();
+  IFS0CLR = _IFS0_T4IF_MASK;
+
+  for (i = 0; i < NUM_WHEELS; i++)
+  {
+    Wheel_t *pWheel = &Wheels[i];
+
+    pWheel->Measured = MeasureSpeed(pWheel, Now, &Captures[i]);
+    Duty[i] = 0;
+    if (!pWheel->Active)
+    {
+      continue;
+    }
+    AnyDriven = true;
+    if ((pWheel->Goal != SPEED_CONTROL_NO_LIMIT) &&
+        (Captures[i] >= pWheel->Goal))
+    {
+      // this wheel is there, hold it until the other one catches up
+      pWheel->Active = false;
+      pWheel->Integral = 0;
+      continue;
+    }
+    AnyActive = true;
+    Duty[i] = UpdateWheel(pWheel, pWheel->Measured, Captures[i]);
+  }
+
+  // only while both are still going, one that has arrived is held at 0
+  if (HoldHeading && Wheels[LEFT_MOTOR].Active && Wheels[RIGHT_MOTOR].Active)
+  {
+    int32_t Trim = HeadingTrim(Captures[LEFT_MOTOR], Captures[RIGHT_MOTOR]);
+
+    Duty[LEFT_MOTOR] = TrimDuty(Duty[LEFT_MOTOR], -Trim);
+    Duty[RIGHT_MOTOR] = TrimDuty(Duty[RIGHT_MOTOR], Trim);
+  }
+
+  // both wheels change in the same PWM period
+  if (AnyDriven)
+  {
+    DCMotor_RampTo(Duty[LEFT_MOTOR], Duty[RIGHT_MOTOR],
+        Wheels[LEFT_MOTOR].Direction, Wheels[RIGHT_MOTOR].Direction);
+  }
+
+  if (++OdometryCount >= ODOMETRY_DIVIDER)
+  {
+    OdometryCount = 0;
+    Odometry_Step(Wheels[LEFT_MOTOR].Odometer, Wheels[RIGHT_MOTOR].Odometer);
+  }
+
+  if (MoveInProgress && !AnyActive)
+  {
+    ES_Event_t DoneEvent;
+
+    MoveInProgress = false;
+    DoneEvent.EventType = ES_MOVE_COMPLETE;
+    DoneEvent.EventParam = 0;
+    PostSpeedControlService(DoneEvent);
+  }
+  ES_IsrStats_Exit(ES_ISR(ControlLoop));
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+/****************************************************************************
+ Function
+     NoteCapture
+
+ Parameters
+     Wheel_t *pWheel - the wheel that was captured
+     uint8_t NumCaptures - the number of captures taken from the IC FIFO
+     CaptureRaw_t Captured - the newest of them, as read from ICxBUF
+
+ Returns
+     None
+
+ Description
+     Extends the newest capture to 32 bits and updates the wheel's period,
+     distance and odometer
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static void NoteCapture(Wheel_t *pWheel, uint8_t NumCaptures,
+                        CaptureRaw_t Captured)
+{
+  uint32_t Now;
+
+  if (NumCaptures == 0)
+  {
+    return;
+  }
+  Now = CaptureTimebase_Extend(Captured);
+  // a period spanning a stall isn't a speed, just restart the stamps
+  if (pWheel->HaveStamp && ((Now - pWheel->LastStamp) < STALL_COUNTS))
+  {
+    pWheel->Period = (Now - pWheel->LastStamp);
+  }
+  else
+  {
+    pWheel->Period = 0;
+  }
+  pWheel->LastStamp = Now;
+  pWheel->HaveStamp = true;
+  pWheel->Captures += NumCaptures;
+  if (pWheel->Direction == REVERSE)
+  {
+    pWheel->Odometer -= NumCaptures;
+  }
+  else
+  {
+    pWheel->Odometer += NumCaptures;
+  }
+}
+
+/****************************************************************************
+ Function
+     MeasureSpeed
+
+ Parameters
+     Wheel_t *pWheel - the wheel to measure
+     uint32_t Now - capture time base at the start of this loop pass
+     uint32_t *pCaptures - set to the wheel's distance so far
+
+ Returns
+     FP_Q16_t - wheel speed in RPM
+
+ Description
+     Converts the last capture period to RPM. When the wheel is slowing,
+     the time since the last capture is already longer than the last
+     period, so that is used instead to see the slow down right away
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static FP_Q16_t MeasureSpeed(Wheel_t *pWheel, uint32_t Now,
+                             uint32_t *pCaptures)
+{
+  uint32_t Captures;
+  uint32_t LastStamp;
+  uint32_t Period;
+  uint32_t SinceLast;
+
+  // the capture ISR can interrupt these reads, go again if it did
+  do
+  {
+    Captures = pWheel->Captures;
+    LastStamp = pWheel->LastStamp;
+    Period = pWheel->Period;
+  } while (Captures != pWheel->Captures);
+  *pCaptures = Captures;
+
+  SinceLast = Now - LastStamp;
+  if ((Period == 0) || (SinceLast >= STALL_COUNTS))
+  {
+    return 0;
+  }
+  if (SinceLast > Period)
+  {
+    Period = SinceLast;
+  }
+  return FP_PeriodToRPM(Period >> ENCODER_STAMP_SHIFT);
+}
+
+/****************************************************************************
+ Function
+     UpdateWheel
+
+ Parameters
+     Wheel_t *pWheel - the wheel to control
+     FP_Q16_t Measured - its speed
+     uint32_t Captures - its distance so far
+
+ Returns
+     uint16_t - the new duty in ticks (0 to DUTY_MAX_TICKS)
+
+ Description
+     Takes the next speed from the wheel's profile & runs one pass of the
+     feed forward + PI controller on it. The integral only runs while the
+     output isn't pinned at a limit in the direction of the error
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static uint16_t UpdateWheel(Wheel_t *pWheel, FP_Q16_t Measured,
+                            uint32_t Captures)
+{
+  FP_Q16_t Target = MotionProfile_Step(&pWheel->Profile, Captures);
+  int32_t  Error;
+  int32_t  NewIntegral;
+  int32_t  Output;
+
+  Error = (int32_t)Target - (int32_t)Measured;
+  NewIntegral = pWheel->Integral +
+      (int32_t)(((int64_t)Error * KI_PER_TICK_Q16) >> 16);
+  if (NewIntegral > INTEGRAL_LIMIT)
+  {
+    NewIntegral = INTEGRAL_LIMIT;
+  }
+  else if (NewIntegral < -INTEGRAL_LIMIT)
+  {
+    NewIntegral = -INTEGRAL_LIMIT;
+  }
+
+  Output = (int32_t)(((uint64_t)Target * FF_DUTY_PER_RPM_Q8) >> 24) +
+      (int32_t)(((int64_t)Error * KP_Q8) >> 24) + (NewIntegral >> 16);
+
+  // anti-windup, don't integrate further into a limit
+  if (!(((Output > DUTY_MAX_TICKS) && (Error > 0)) ||
+      ((Output < DUTY_MIN_TICKS) && (Error < 0))))
+  {
+    pWheel->Integral = NewIntegral;
+  }
+
+  if (Output > DUTY_MAX_TICKS)
+  {
+    Output = DUTY_MAX_TICKS;
+  }
+  else if (Output < DUTY_MIN_TICKS)
+  {
+    Output = DUTY_MIN_TICKS;
+  }
+  return (uint16_t)Output;
+}
+
+/****************************************************************************
+ Function
+     HeadingTrim
+
+ Parameters
+     uint32_t CapturesLeft, CapturesRight - each wheel's distance so far
+
+ Returns
+     int32_t - duty ticks to add to the right wheel & take off the left,
+               -HEADING_TRIM_MAX to HEADING_TRIM_MAX
+
+ Description
+     One pass of the heading hold PI, from the differences in speed &
+     distance, positive when the left wheel is ahead
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static int32_t HeadingTrim(uint32_t CapturesLeft, uint32_t CapturesRight)
+{
+  int32_t SpeedError;
+  int32_t DistanceError;
+  int32_t Trim;
+
+  SpeedError = (int32_t)Wheels[LEFT_MOTOR].Measured -
+      (int32_t)Wheels[RIGHT_MOTOR].Measured;
+  DistanceError = (int32_t)(CapturesLeft - CapturesRight);
+
+  Trim = (int32_t)(((int64_t)SpeedError * HEADING_KP_Q8) >> 24) +
+      (DistanceError * HEADING_KI_TICKS_PER_CAPTURE);
+  if (Trim > HEADING_TRIM_MAX)
+  {
+    Trim = HEADING_TRIM_MAX;
+  }
+  else if (Trim < -HEADING_TRIM_MAX)
+  {
+    Trim = -HEADING_TRIM_MAX;
+  }
+  return Trim;
+}
+
+// adds Trim to a duty, keeping it in DUTY_MIN_TICKS to DUTY_MAX_TICKS
+static uint16_t TrimDuty(uint16_t Duty, int32_t Trim)
+{
+  int32_t Trimmed = (int32_t)Duty + Trim;
+
+  if (Trimmed > DUTY_MAX_TICKS)
+  {
+    Trimmed = DUTY_MAX_TICKS;
+  }
+  else if (Trimmed < DUTY_MIN_TICKS)
+  {
+    Trimmed = DUTY_MIN_TICKS;
+  }
+  return (uint16_t)Trimmed;
+}
+
+/****************************************************************************
+ Function
+     ConfigureEncoderCapture
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Sets up IC2 (left) & IC5 (right) to capture every 16th rising edge and
+     interrupt on each capture
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static void ConfigureEncoderCapture(void)
+{
+  volatile uint32_t dummy;
+
+  // Encoder inputs, RB9 & RA2 have no analog function
+  TRISBbits.TRISB9 = 1;
+  TRISAbits.TRISA2 = 1;
+  IC2R = 0b0100;  // IC2 <- RB9
+  IC5R = 0b0000;  // IC5 <- RA2
+
+  IC2CONbits.ON = 0;
+  IC5CONbits.ON = 0;
+
+  // ICM = 101 captures every 16th rising edge (IC_PRESCALE), ICI = 00
+  // interrupts on every capture
+  IC2CONbits.ICTMR = 0;
+  IC2CONbits.ICC32 = CAPTURE_TIMEBASE_ICC32;
+  IC2CONbits.ICM = 0b101;
+  IC2CONbits.ICI = 0b00;
+  IC5CONbits.ICTMR = 0;
+  IC5CONbits.ICC32 = CAPTURE_TIMEBASE_ICC32;
+  IC5CONbits.ICM = 0b101;
+  IC5CONbits.ICI = 0b00;
+
+  while (IC2CONbits.ICBNE)
+  {
+    dummy = IC2BUF;
+  }
+  while (IC5CONbits.ICBNE)
+  {
+    dummy = IC5BUF;
+  }
+  IFS0CLR = _IFS0_IC2IF_MASK | _IFS0_IC5IF_MASK;
+
+  // above the control loop, below the beacon capture
+  IPC2bits.IC2IP = 6;
+  IPC2bits.IC2IS = 0;
+  IPC5bits.IC5IP = 6;
+  IPC5bits.IC5IS = 1;
+  IEC0SET = _IEC0_IC2IE_MASK | _IEC0_IC5IE_MASK;
+
+  IC2CONbits.ON = 1;
+  IC5CONbits.ON = 1;
+}
+
+/****************************************************************************
+ Function
+     ConfigureControlTimer
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     Sets up Timer4 to interrupt at CONTROL_RATE_HZ
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+static void ConfigureControlTimer(void)
+{
+  T4CONbits.ON = 0;
+  T4CONbits.TCS = 0;
+  T4CONbits.TCKPS = PrescaleLookup[PRESCALE_8];
+  TMR4 = 0;
+  PR4 = CONTROL_PERIOD_TICKS;
+
+  IFS0CLR = _IFS0_T4IF_MASK;
+  IPC4bits.T4IP = 5;
+  IPC4bits.T4IS = 0;
+  IEC0SET = _IEC0_T4IE_MASK;
+
+  T4CONbits.ON = 1;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,214 @@
+/****************************************************************************
+ Module
+   TapeArray.c
+
+ Revision
+   0.1
+
+ Description
+   Reads the analog tape sensor array and works out where the line is
+   under the robot, for line following.
+
+ Notes
+   The A/D streams the array (no block ready function, TapeArray_Update
+   polls for blocks from the tape event checker). Each block goes through
+   the filter bank, then every sensor's reading above the floor is its
+   weight, and the line position is the weighted centroid of the sensor
+   positions:
+
+     position = sum(weight * sensor position) / sum(weight)
+
+   That is one divide per block, done with FP_Divide.
+
+   Detecting and losing the line use two thresholds on the summed weight
+   so the edge of the tape doesn't chatter.
+
+   The pot in ADService streams from the same A/D, with a different scan
+   set. Only one of them can be running.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "TapeArray.h"
+#include "PIC32_AD_Lib.h"
+#include "ADFilterBank.h"
+#include "FixedPointUnits.h"
+#include <stddef.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// light filtering, a 4 sample average, the block does the rest
+#define TAPE_AVERAGE_SHIFT 2
+
+#if TAPE_NUM_SENSORS > AD_FILTER_MAX_CHANNELS
+#error "The A/D can only scan AD_FILTER_MAX_CHANNELS sensors"
+#endif
+
+/*---------------------------- Module Functions ---------------------------*/
+static void EstimatePosition(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static const int16_t SensorPosition[TAPE_NUM_SENSORS] = TAPE_SENSOR_POSITIONS;
+
+static const ADFilterConfig_t SensorFilter = {
+  TAPE_AVERAGE_SHIFT, 0, 0
+};
+
+static bool LineSeen;
+static int16_t LinePosition;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     TapeArray_Init
+
+ Parameters
+     None
+
+ Returns
+     bool, false if the A/D or the filters couldn't be set up
+
+ Description
+     Starts the A/D streaming the array. The pins are set up as analog
+     inputs by InitTapeSensorPin
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool TapeArray_Init(void)
+{
+  uint8_t i;
+
+  LineSeen = false;
+  LinePosition = 0;
+
+  if (!ADFilter_Init(TAPE_NUM_SENSORS))
+  {
+    return false;
+  }
+  for (i = 0; i < TAPE_NUM_SENSORS; i++)
+  {
+    if (!ADFilter_Configure(i, &SensorFilter))
+    {
+      return false;
+    }
+  }
+  return ADC_ConfigStreaming(TAPE_PIN_MASK, TAPE_SET_RATE_HZ, NULL);
+}
+
+/****************************************************************************
+ Function
+     TapeArray_Update
+
+ Parameters
+     None
+
+ Returns
+     bool, true if a block was waiting & there is a new estimate
+
+ Description
+     Filters the next block from the A/D, if there is one, and updates
+     LineSeen & the line position
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool TapeArray_Update(void)
+{
+  const uint16_t *pBlock = ADC_GetBlock();
+
+  if (pBlock == NULL)
+  {
+    return false;
+  }
+  ADFilter_AddBlock(pBlock, ADC_STREAM_BLOCK_SETS);
+  ADC_ReleaseBlock();
+  EstimatePosition();
+  return true;
+}
+
+/****************************************************************************
+ Function
+     TapeArray_LineSeen
+
+ Parameters
+     None
+
+ Returns
+     bool, true if the array is over the line
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool TapeArray_LineSeen(void)
+{
+  return LineSeen;
+}
+
+/****************************************************************************
+ Function
+     TapeArray_GetPosition
+
+ Parameters
+     None
+
+ Returns
+     int16_t, where the line is in 1/16 mm from the middle of the array,
+     positive to the right. Holds the last position once the line is lost
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+int16_t TapeArray_GetPosition(void)
+{
+  return LinePosition;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+static void EstimatePosition(void)
+{
+  uint8_t  i;
+  uint16_t reading;
+  uint32_t weight;
+  uint32_t sumWeight = 0;
+  int32_t  moment = 0;
+  uint32_t offset;
+
+  for (i = 0; i < TAPE_NUM_SENSORS; i++)
+  {
+    reading = ADFilter_GetFiltered(i);
+    weight = (reading > TAPE_FLOOR_COUNTS) ? (reading - TAPE_FLOOR_COUNTS) : 0;
+    sumWeight += weight;
+    moment += (int32_t)weight * SensorPosition[i];
+  }
+
+  if (LineSeen)
+  {
+    LineSeen = (sumWeight >= TAPE_LOST_COUNTS);
+  }
+  else
+  {
+    LineSeen = (sumWeight >= TAPE_DETECT_COUNTS);
+  }
+  if (!LineSeen)
+  {
+    return;
+  }
+
+  // FP_Divide is unsigned, so divide the size of the moment & put the
+  // sign back
+  if (moment < 0)
+  {
+    offset = FP_Divide((uint32_t)(-moment) << TAPE_POSITION_SHIFT, sumWeight);
+    LinePosition = -(int16_t)offset;
+  }
+  else
+  {
+    offset = FP_Divide((uint32_t)moment << TAPE_POSITION_SHIFT, sumWeight);
+    LinePosition = (int16_t)offset;
+  }
+}
@@ -0,0 +1,298 @@
+/****************************************************************************
+ Module
+   TelemetryService.c
+
+ Revision
+   0.1
+
+ Description
+   Every TELEMETRY_PERIOD_MS, takes a snapshot of the robot's state & sends
+   it as one packed frame with a CRC (see TelemetryService.h), so the host
+   gets a single stream at a known rate rather than each service's text.
+
+ Notes
+   A frame is only started if the whole of it fits in the transmit buffer,
+   otherwise it is skipped & counted, so a busy link loses whole frames and
+   never blocks this service. Binlog records are written from the idle
+   path, which can't come in part way through a frame.
+
+   The snapshot reads each module through its query functions, none of
+   which block.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/14/26       Tianyu  The odometry pose is in the frame
+ 10/14/26       Tianyu  The frame CRC is Crc_Ccitt16, the period starts
+                        from the parameter store
+ 10/14/26       Tianyu  Initial creation
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Timers.h"
+#include "TelemetryService.h"
+#include "CommonDefinitions.h"
+#include "MainLogicFSM.h"
+#include "DCMotorService.h"
+#include "SpeedControlService.h"
+#include "BeaconClassifier.h"
+#include "TapeArray.h"
+#include "ADFilterBank.h"
+#include "terminal.h"
+#include "Crc.h"
+#include "ParamStore.h"
+#include "Odometry.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// version through queue stats, see TelemetryService.h
+#define PAYLOAD_BYTES \
+  (31 + (2 * TAPE_NUM_SENSORS) + (3 * NUM_SERVICES))
+// mark, length, payload, CRC
+#define FRAME_BYTES (2 + PAYLOAD_BYTES + 2)
+
+#if PAYLOAD_BYTES > 255
+#error "the telemetry payload doesn't fit its 8 bit length"
+#endif
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint8_t BuildFrame(uint8_t *pFrame);
+static uint8_t *Put8(uint8_t *pDest, uint8_t Value);
+static uint8_t *Put16(uint8_t *pDest, uint16_t Value);
+static uint8_t *Put32(uint8_t *pDest, uint32_t Value);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint8_t  MyPriority;
+static uint16_t PeriodMs;
+static uint8_t  Sequence;
+static uint16_t SkippedFrames;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     InitTelemetryService
+
+ Parameters
+     uint8_t : the priority of this service
+
+ Returns
+     bool, false if error in initialization, true otherwise
+
+ Description
+     Starts the frame timer, unless the TELEM parameter is 0
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool InitTelemetryService(uint8_t Priority)
+{
+  ES_Event_t ThisEvent;
+
+  MyPriority = Priority;
+  Sequence = 0;
+  SkippedFrames = 0;
+  PeriodMs = ParamStore_Get(PARAM_ID(TELEM));
+  if (PeriodMs != 0)
+  {
+    ES_Timer_InitTimer(TELEMETRY_TIMER, PeriodMs);
+  }
+
+  ThisEvent.EventType = ES_INIT;
+  return ES_PostToService(MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+     PostTelemetryService
+
+ Parameters
+     ES_Event_t ThisEvent, the event to post to the queue
+
+ Returns
+     bool false if the Enqueue operation failed, true otherwise
+
+ Description
+     Posts an event to this service's queue
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+bool PostTelemetryService(ES_Event_t ThisEvent)
+{
+  return ES_PostToService(MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+    RunTelemetryService
+
+ Parameters
+   ES_Event_t : the event to process
+
+ Returns
+   ES_Event_t, ES_NO_EVENT if no error ES_ERROR otherwise
+
+ Description
+   Sends a frame each time the timer runs out, & restarts it
+
+ Author
+   Tianyu, 10/14/26
+****************************************************************************/
+ES_Event_t RunTelemetryService(ES_Event_t ThisEvent)
+{
+  ES_Event_t ReturnEvent;
+  ReturnEvent.EventType = ES_NO_EVENT; // assume no errors
+
+  switch (ThisEvent.EventType)
+  {
+    case ES_TIMEOUT:
+    {
+      uint8_t Frame[FRAME_BYTES];
+      uint8_t Length;
+      uint8_t i;
+
+      if (ThisEvent.EventParam != TELEMETRY_TIMER)
+      {
+        break;
+      }
+      // restart first so that the rate doesn't drift by the time taken here
+      if (PeriodMs != 0)
+      {
+        ES_Timer_InitTimer(TELEMETRY_TIMER, PeriodMs);
+      }
+      if (Terminal_GetXmitSpace() < FRAME_BYTES)
+      {
+        SkippedFrames++;
+        break;
+      }
+      Length = BuildFrame(Frame);
+      for (i = 0; i < Length; i++)
+      {
+        Terminal_WriteByte(Frame[i]);
+      }
+    }
+    break;
+
+    default:
+      break;
+  }
+
+  return ReturnEvent;
+}
+
+/****************************************************************************
+ Function
+     Telemetry_SetPeriod
+
+ Parameters
+     uint16_t NewPeriodMs - mS between frames, 0 to stop them
+
+ Returns
+     None
+
+ Description
+     Changes the frame rate, the next frame comes a whole period from now
+
+ Author
+     Tianyu, 10/14/26
+****************************************************************************/
+void Telemetry_SetPeriod(uint16_t NewPeriodMs)
+{
+  PeriodMs = NewPeriodMs;
+  if (PeriodMs != 0)
+  {
+    ES_Timer_InitTimer(TELEMETRY_TIMER, PeriodMs);
+  }
+  else
+  {
+    ES_Timer_StopTimer(TELEMETRY_TIMER);
+  }
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+// fills pFrame with a complete frame & returns its length
+static uint8_t BuildFrame(uint8_t *pFrame)
+{
+  uint8_t   *pNext = pFrame;
+  uint16_t   Duty[2];
+  uint8_t    Direction[2];
+  BeaconId_t BeaconId;
+  uint8_t    Confidence;
+  Pose_t     Pose;
+  uint8_t    i;
+  uint16_t   Crc;
+
+  DCMotor_GetOutput(LEFT_MOTOR, &Duty[LEFT_MOTOR], &Direction[LEFT_MOTOR]);
+  DCMotor_GetOutput(RIGHT_MOTOR, &Duty[RIGHT_MOTOR],
+      &Direction[RIGHT_MOTOR]);
+  (void)BeaconClassifier_GetResult(&BeaconId, &Confidence);
+  Odometry_GetPose(&Pose);
+
+  pNext = Put8(pNext, TELEMETRY_FRAME_MARK);
+  pNext = Put8(pNext, PAYLOAD_BYTES);
+  pNext = Put8(pNext, TELEMETRY_VERSION);
+  pNext = Put8(pNext, Sequence++);
+  pNext = Put32(pNext, _HW_GetCycleCount());
+  pNext = Put16(pNext, SkippedFrames);
+  pNext = Put8(pNext, (uint8_t)QueryMainLogicFSM());
+  pNext = Put8(pNext, (uint8_t)((Direction[LEFT_MOTOR] == REVERSE ? 1 : 0) |
+      (Direction[RIGHT_MOTOR] == REVERSE ? 2 : 0)));
+  pNext = Put16(pNext, Duty[LEFT_MOTOR]);
+  pNext = Put16(pNext, Duty[RIGHT_MOTOR]);
+  pNext = Put16(pNext,
+      (uint16_t)FP_Q16_ROUND(SpeedControl_GetSpeed(LEFT_MOTOR)));
+  pNext = Put16(pNext,
+      (uint16_t)FP_Q16_ROUND(SpeedControl_GetSpeed(RIGHT_MOTOR)));
+  pNext = Put8(pNext, (uint8_t)BeaconId);
+  pNext = Put8(pNext, Confidence);
+  pNext = Put16(pNext, (uint16_t)TapeArray_GetPosition());
+  pNext = Put8(pNext, TapeArray_LineSeen() ? 1 : 0);
+  pNext = Put16(pNext, (uint16_t)(Pose.X >> FP_Q16_SHIFT));
+  pNext = Put16(pNext, (uint16_t)(Pose.Y >> FP_Q16_SHIFT));
+  pNext = Put16(pNext, ODOMETRY_HEADING_TO_ANGLE(Pose.Heading));
+  pNext = Put8(pNext, TAPE_NUM_SENSORS);
+  for (i = 0; i < TAPE_NUM_SENSORS; i++)
+  {
+    pNext = Put16(pNext, ADFilter_GetFiltered(i));
+  }
+  pNext = Put8(pNext, NUM_SERVICES);
+  for (i = 0; i < NUM_SERVICES; i++)
+  {
+    ES_QueueStats_t Stats;
+
+    if (!ES_GetServiceQueueStats(i, &Stats))
+    {
+      Stats.HighWater = 0;
+      Stats.DropCount = 0;
+    }
+    pNext = Put8(pNext, Stats.HighWater);
+    pNext = Put16(pNext, Stats.DropCount);
+  }
+
+  // the CRC covers the length & the payload, not the mark
+  Crc = Crc_Ccitt16(CRC16_INITIAL, pFrame + 1,
+      (uint16_t)(pNext - (pFrame + 1)));
+  pNext = Put16(pNext, Crc);
+  return (uint8_t)(pNext - pFrame);
+}
+
+static uint8_t *Put8(uint8_t *pDest, uint8_t Value)
+{
+  *pDest = Value;
+  return pDest + 1;
+}
+
+static uint8_t *Put16(uint8_t *pDest, uint16_t Value)
+{
+  pDest[0] = (uint8_t)Value;
+  pDest[1] = (uint8_t)(Value >> 8);
+  return pDest + 2;
+}
+
+static uint8_t *Put32(uint8_t *pDest, uint32_t Value)
+{
+  pDest = Put16(pDest, (uint16_t)Value);
+  return Put16(pDest, (uint16_t)(Value >> 16));
+}
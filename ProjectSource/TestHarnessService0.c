@@ -14,6 +14,17 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/14/26 23:59 ty      'o' prints the odometry pose
+ 10/14/26 23:59 ty      'w' prints the pulse capture channels
+ 10/14/26 23:59 ty      'h' runs the HIL harness script, 'g' prints its log
+ 10/14/26 23:40 ty      'u' prints the startup times
+ 10/14/26 23:20 ty      the short timer test is timed with ES_Time_NowUs
+ 10/14/26 23:10 ty      's' times a SHORT_TEST_US short timer on TIMER_A
+ 10/14/26 21:30 ty      'i' prints & clears the ISR statistics
+ 10/14/26 21:20 ty      't' dumps the dispatch trace
+ 10/14/26 19:50 ty      'b' prints & clears the run function statistics
+ 10/14/26 16:50 ty      'q' prints the queue statistics
+ 10/14/26 16:10 ty      'p' prints the dispatch profile, 'r' resets it
  10/26/17 18:26 jec     moves definition of ALL_BITS to ES_Port.h
  10/19/17 21:28 jec     meaningless change to test updating
  10/19/17 18:42 jec     removed referennces to driverlib and programmed the
@@ -42,6 +53,14 @@
 #include "ES_Port.h"
 #include "terminal.h"
 #include "dbprintf.h"
+#include "ES_Profiler.h"
+#include "ES_Trace.h"
+#include "ES_IsrStats.h"
+#include "ES_ShortTimer.h"
+#include "ES_Time.h"
+#include "HilHarness.h"
+#include "PulseCaptureService.h"
+#include "Odometry.h"
 
 /*----------------------------- Module Defines ----------------------------*/
 // these times assume a 10.000mS/tick timing
@@ -50,6 +69,9 @@
 #define TWO_SEC (ONE_SEC * 2)
 #define FIVE_SEC (ONE_SEC * 5)
 
+// the short timer that 's' starts, in uS
+#define SHORT_TEST_US 500
+
 #define ENTER_POST     ((MyPriority<<3)|0)
 #define ENTER_RUN      ((MyPriority<<3)|1)
 #define ENTER_TIMEOUT  ((MyPriority<<3)|2)
@@ -72,6 +94,8 @@ static void StartTMR2(void);
 /*---------------------------- Module Variables ---------------------------*/
 // with the introduction of Gen2, we need a module level Priority variable
 static uint8_t MyPriority;
+// when 's' started the short timer
+static uint64_t ShortTestStart;
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -118,7 +142,7 @@ bool InitTestHarnessService0(uint8_t Priority)
   InitTMR2();
 #endif
   // initialize the Short timer system for channel A
-  //ES_ShortTimerInit(MyPriority, SHORT_TIMER_UNUSED);
+  ES_ShortTimerInit(MyPriority, SHORT_TIMER_UNUSED);
 
   // post the initial transition event
   ThisEvent.EventType = ES_INIT;
@@ -196,13 +220,108 @@ ES_Event_t RunTestHarnessService0(ES_Event_t ThisEvent)
     break;
     case ES_SHORT_TIMEOUT:   // lower the line & announce
     {
-      puts("\rES_SHORT_TIMEOUT received\r\n");
+#ifdef USE_HIL_HARNESS
+      if (HilHarness_IsRunning())
+      {
+        HilHarness_Step();
+        break;
+      }
+#endif
+      DB_printf("\rES_SHORT_TIMEOUT received after %duS\r\n",
+          (uint32_t)(ES_Time_NowUs() - ShortTestStart));
     }
     break;
     case ES_NEW_KEY:   // announce
     {
       DB_printf("ES_NEW_KEY received with -> %c <- in Service 0\r\n",
           (char)ThisEvent.EventParam);
+      if ('q' == ThisEvent.EventParam)
+      {
+        ES_ReportQueueStats();
+      }
+      if ('s' == ThisEvent.EventParam)
+      {
+        ShortTestStart = ES_Time_NowUs();
+        ES_ShortTimerStart(TIMER_A, SHORT_TEST_US);
+      }
+      if ('w' == ThisEvent.EventParam)
+      {
+        uint32_t Width;
+        uint32_t Period;
+        uint8_t  i;
+
+        for (i = 0; i < NUM_PULSE_CHANNELS; i++)
+        {
+          (void)PulseCapture_GetWidth((PulseChannel_t)i, &Width, &Period);
+          DB_printf("Pulse %d: %u pulses, %uuS wide, %uuS period\r\n", i,
+              PulseCapture_GetCount((PulseChannel_t)i),
+              PULSE_TICKS_TO_US(Width), PULSE_TICKS_TO_US(Period));
+        }
+      }
+      if ('o' == ThisEvent.EventParam)
+      {
+        Pose_t Pose;
+
+        Odometry_GetPose(&Pose);
+        DB_printf("Pose: %dmm, %dmm, %u degrees\r\n",
+            Pose.X >> FP_Q16_SHIFT, Pose.Y >> FP_Q16_SHIFT,
+            ODOMETRY_HEADING_TO_DEG(Pose.Heading));
+      }
+#ifdef USE_HIL_HARNESS
+      if ('h' == ThisEvent.EventParam)
+      {
+        HilHarness_Start();
+      }
+      else if ('g' == ThisEvent.EventParam)
+      {
+        HilHarness_DumpGolden();
+      }
+#endif
+#ifdef ES_RUN_BUDGET
+      if ('b' == ThisEvent.EventParam)
+      {
+        ES_ReportRunStats();
+        ES_ResetRunStats();
+      }
+#endif
+#ifdef ES_STARTUP_STATS
+      if ('u' == ThisEvent.EventParam)
+      {
+        ES_ReportStartup();
+      }
+#endif
+#ifdef ES_PROFILE_DISPATCH
+      if ('p' == ThisEvent.EventParam)
+      {
+        ES_Profile_Report();
+      }
+      else if ('r' == ThisEvent.EventParam)
+      {
+        ES_Profile_Reset();
+        DB_printf("Dispatch profile reset\r\n");
+      }
+#endif
+#ifdef ES_ISR_STATS
+      if ('i' == ThisEvent.EventParam)
+      {
+        ES_IsrStats_Report();
+        ES_IsrStats_Reset();
+      }
+#endif
+#ifdef ES_TRACE_DISPATCH
+      if ('t' == ThisEvent.EventParam)
+      {
+        // the frame has to go out whole for the decoder to find the next one
+        if (Terminal_GetXmitSpace() >= ES_TRACE_FRAME_BYTES)
+        {
+          ES_Trace_Dump(Terminal_WriteByte, ES_TRACE_DUMP_KEY);
+        }
+        else
+        {
+          DB_printf("No room for the trace, try again\r\n");
+        }
+      }
+#endif
     }
     break;
     default:
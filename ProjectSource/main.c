@@ -14,6 +14,8 @@
 #include "ES_Configure.h"
 #include "ES_Framework.h"
 #include "ES_Port.h"
+#include "ParamStore.h"
+#include "PowerManager.h"
 
 
 void main(void)
@@ -22,7 +24,10 @@ void main(void)
 
   _HW_PIC32Init(); // basic PIC hardware init
   // Your hardware initialization function calls go here
-
+  // the tuning from flash, before the services read theirs
+  (void)ParamStore_Init();
+  // the unused peripherals off, the rest on for the services to set up
+  PowerManager_Init();
 
   // now initialize the Events and Services Framework and start it running
   ErrorType = ES_Initialize(ES_Timer_RATE_1mS);
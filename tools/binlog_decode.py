@@ -0,0 +1,300 @@
+#!/usr/bin/env python3
+"""
+binlog_decode.py
+
+Rebuilds the text of the binary trace records written by binlog.c. The UART
+stream is a mix of normal printf text and binary frames; the text is passed
+through as is and each frame is formatted using the format string that its
+address points to in the .elf that is running on the board.
+
+Frame layout (see binlog.c):
+    0xB1, then little endian 32 bit words:
+    header = 0xB1 << 24 | NumArgs << 16 | sequence number
+    format = address of the format string (0 for a drop report)
+    time   = core timer count (20MHz)
+    NumArgs argument words
+
+The dispatch trace dumps (see ES_Trace.h) are printed as a table:
+    0xB2, then little endian 32 bit words:
+    header = 0xB2 << 24 | NumEntries << 16 | reason
+    total  = dispatches recorded since reset
+    now    = core timer count at the dump
+    NumEntries x (start, service << 24 | event << 16 | param, run counts)
+
+The telemetry frames (see TelemetryService.h) are printed one per line:
+    0xB3, payload length, payload, CRC-16 CCITT of the length & payload
+    a frame with a bad CRC is passed through as text
+
+usage:
+    binlog_decode.py dist/default/debug/ME218B_Lab8.debug.elf /dev/ttyUSB0
+    binlog_decode.py firmware.elf capture.bin       (a saved raw capture)
+
+needs pyelftools, and pyserial to read from a serial port
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+from elftools.elf.elffile import ELFFile
+
+FRAME_MARK = 0xB1
+MAX_ARGS = 4
+TRACE_MARK = 0xB2
+TRACE_REASONS = {0: 'key', 1: 'assert'}
+CORE_TIMER_HZ = 20000000
+TELEMETRY_MARK = 0xB3
+TELEMETRY_STATES = ['Stopped', 'SimpleMoving', 'SearchingForTape',
+                    'AligningWithBeacon', 'FollowingLine']
+BEACON_HZ = [1427, 909, 2000, 3333]
+
+
+class StringTable:
+    """reads NUL terminated strings out of the loaded sections of an .elf"""
+
+    def __init__(self, elf_path):
+        self.sections = []
+        with open(elf_path, 'rb') as f:
+            elf = ELFFile(f)
+            for sec in elf.iter_sections():
+                # only sections that occupy memory on the target
+                if sec['sh_addr'] and sec['sh_type'] == 'SHT_PROGBITS':
+                    self.sections.append((sec['sh_addr'], sec.data()))
+        self.cache = {}
+
+    def lookup(self, addr):
+        if addr in self.cache:
+            return self.cache[addr]
+        text = None
+        for base, data in self.sections:
+            if base <= addr < base + len(data):
+                end = data.find(b'\0', addr - base)
+                if end < 0:
+                    end = len(data)
+                text = data[addr - base:end].decode('latin-1')
+                break
+        self.cache[addr] = text
+        return text
+
+
+def format_record(strings, fmt, args):
+    """a python copy of the subset of conversions that DB_printf supports"""
+    out = []
+    arg_iter = iter(args)
+    i = 0
+    while i < len(fmt):
+        c = fmt[i]
+        if c != '%' or i + 1 == len(fmt):
+            out.append(c)
+            i += 1
+            continue
+        spec = fmt[i + 1]
+        i += 2
+        if spec == '%':
+            out.append('%')
+            continue
+        val = next(arg_iter, 0)
+        if spec == 'd':
+            out.append(str(struct.unpack('<i', struct.pack('<I', val))[0]))
+        elif spec == 'u':
+            out.append(str(val))
+        elif spec == 'x':
+            out.append('%x' % val)
+        elif spec == 'c':
+            out.append(chr(val & 0xFF))
+        elif spec == 's':
+            s = strings.lookup(val)
+            out.append(s if s is not None else '<str@0x%08x>' % val)
+        else:
+            out.append('BAD')
+    return ''.join(out)
+
+
+def first_mark(buf):
+    """where the next binlog, trace or telemetry frame might start, -1 if
+    nowhere"""
+    marks = [m for m in (buf.find(FRAME_MARK), buf.find(TRACE_MARK),
+                         buf.find(TELEMETRY_MARK)) if m >= 0]
+    return min(marks) if marks else -1
+
+
+def crc16(data):
+    """CRC-16 CCITT from 0xFFFF, as TelemetryService.c works it out"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def format_telemetry(payload):
+    """one line from a telemetry payload, None if it isn't version 2"""
+    if len(payload) < 31 or payload[0] != 2:
+        return None
+    (seq, stamp, skipped, state, dirs, duty_l, duty_r, rpm_l, rpm_r,
+     beacon, confidence, position, seen, x, y, heading,
+     num_sensors) = struct.unpack_from('<BIHBBHHHHBBhBhhHB', payload, 1)
+    at = 30
+    sensors = struct.unpack_from('<%dH' % num_sensors, payload, at)
+    at += 2 * num_sensors
+    num_services = payload[at]
+    at += 1
+    queues = [struct.unpack_from('<BH', payload, at + 3 * i)
+              for i in range(num_services)]
+    state_name = (TELEMETRY_STATES[state] if state < len(TELEMETRY_STATES)
+                  else str(state))
+    beacon_hz = BEACON_HZ[beacon] if beacon < len(BEACON_HZ) else 0
+    return ('<telem %3u %10.6f %s duty %s%u %s%u rpm %u %u beacon %uHz/%u '
+            'line %s%d pose %d,%d %.1fdeg tape %s queues %s '
+            'skipped %u>\n' % (
+                seq, stamp / CORE_TIMER_HZ, state_name,
+                '-' if dirs & 1 else '', duty_l,
+                '-' if dirs & 2 else '', duty_r, rpm_l, rpm_r,
+                beacon_hz, confidence, '' if seen else '(lost) ', position,
+                x, y, heading * 360.0 / 65536,
+                ','.join(str(v) for v in sensors),
+                ' '.join('%u/%u' % q for q in queues), skipped))
+
+
+def format_trace(words):
+    header, total, now = words[:3]
+    num_entries = (header >> 16) & 0xFF
+    reason = header & 0xFF
+    lines = ['<trace: %s dump, last %u of %u dispatches>' % (
+        TRACE_REASONS.get(reason, str(reason)), num_entries, total)]
+    lines.append('%12s %4s %6s %6s %10s' % ('age uS', 'svc', 'event',
+                                             'param', 'run uS'))
+    for i in range(num_entries):
+        start, what, run = words[3 + 3 * i:6 + 3 * i]
+        age = ((now - start) & 0xFFFFFFFF) * 1e6 / CORE_TIMER_HZ
+        lines.append('%12.1f %4u %6u %6u %10.1f' % (
+            age, what >> 24, (what >> 16) & 0xFF, what & 0xFFFF,
+            run * 1e6 / CORE_TIMER_HZ))
+    return '\n'.join(lines) + '\n'
+
+
+class Decoder:
+    def __init__(self, strings, show_time):
+        self.strings = strings
+        self.show_time = show_time
+        self.buf = bytearray()
+        self.last_seq = None
+
+    def feed(self, data, write):
+        self.buf.extend(data)
+        while self.buf:
+            mark = first_mark(self.buf)
+            if mark < 0:
+                write(self.buf.decode('latin-1'))
+                self.buf.clear()
+                return
+            if mark:
+                write(self.buf[:mark].decode('latin-1'))
+                del self.buf[:mark]
+            if self.buf[0] == TELEMETRY_MARK:
+                if len(self.buf) < 2 or len(self.buf) < 4 + self.buf[1]:
+                    return
+                length = self.buf[1]
+                crc, = struct.unpack_from('<H', self.buf, 2 + length)
+                text = None
+                if crc == crc16(self.buf[1:2 + length]):
+                    text = format_telemetry(self.buf[2:2 + length])
+                if text is None:
+                    write(chr(self.buf[0]))
+                    del self.buf[:1]
+                    continue
+                del self.buf[:4 + length]
+                write(text)
+                continue
+            # need the header to know how long the frame is
+            if len(self.buf) < 5:
+                return
+            header, = struct.unpack_from('<I', self.buf, 1)
+            if self.buf[0] == TRACE_MARK:
+                if (header >> 24) != TRACE_MARK:
+                    write(chr(self.buf[0]))
+                    del self.buf[:1]
+                    continue
+                num_words = 3 + 3 * ((header >> 16) & 0xFF)
+                if len(self.buf) < 1 + 4 * num_words:
+                    return
+                words = struct.unpack_from('<%dI' % num_words, self.buf, 1)
+                del self.buf[:1 + 4 * num_words]
+                write(format_trace(words))
+                continue
+            num_args = (header >> 16) & 0xFF
+            if (header >> 24) != FRAME_MARK or num_args > MAX_ARGS:
+                # not really a frame, pass the byte through as text
+                write(chr(self.buf[0]))
+                del self.buf[:1]
+                continue
+            frame_len = 1 + 4 * (3 + num_args)
+            if len(self.buf) < frame_len:
+                return
+            words = struct.unpack_from('<%dI' % (3 + num_args), self.buf, 1)
+            del self.buf[:frame_len]
+            write(self.format_frame(words))
+
+    def format_frame(self, words):
+        header, fmt_addr, stamp = words[:3]
+        args = words[3:]
+        prefix = ''
+        if self.show_time:
+            prefix = '[%10.6f] ' % (stamp / CORE_TIMER_HZ)
+        if fmt_addr == 0:
+            return '%s<binlog: %u records dropped so far>\n' % (
+                prefix, args[0] if args else 0)
+        seq = header & 0xFFFF
+        gap = ''
+        if self.last_seq is not None and seq != ((self.last_seq + 1) & 0xFFFF):
+            gap = '<binlog: sequence jumped %u -> %u>\n' % (self.last_seq, seq)
+        self.last_seq = seq
+        fmt = self.strings.lookup(fmt_addr)
+        if fmt is None:
+            return '%s%s<unknown format 0x%08x> %s\n' % (
+                gap, prefix, fmt_addr, ' '.join('0x%x' % a for a in args))
+        return gap + prefix + format_record(self.strings, fmt, args)
+
+
+def open_input(path, baud):
+    if os.path.isfile(path):
+        return open(path, 'rb'), False
+    import serial  # pyserial, only needed for a live port
+    return serial.Serial(path, baud, timeout=0.1), True
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[1],
+                                     formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument('elf', help='the .elf that is running on the board')
+    parser.add_argument('input', help='serial port or raw capture file')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--time', action='store_true',
+                        help='prefix each record with its time stamp (s)')
+    opts = parser.parse_args()
+
+    decoder = Decoder(StringTable(opts.elf), opts.time)
+    stream, live = open_input(opts.input, opts.baud)
+
+    def write(text):
+        sys.stdout.write(text.replace('\r\n', '\n'))
+        sys.stdout.flush()
+
+    try:
+        while True:
+            data = stream.read(4096)
+            if data:
+                decoder.feed(data, write)
+            elif not live:
+                break
+    except KeyboardInterrupt:
+        pass
+    finally:
+        stream.close()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,353 @@
+#!/usr/bin/env python3
+"""
+memory_report.py
+
+Reports where the RAM & flash go in a build and checks it against the
+committed budget in memory_budget.json, so a change that pushes a module,
+a buffer or a stack over its limit fails the build.
+
+Sources, all from the normal build:
+    <dist>/*.map        per module text/data/bss from the linker's
+                        "Memory-Usage Report By Module" & the totals
+    <dist>/*.elf        sizes of named objects (queues, buffers), read from
+                        the symbol table, static ones included
+    memoryfile.xml      program & data memory used, as MPLAB X shows them
+    <objdir>/**/*.su    stack frame of every function (-fstack-usage)
+    <objdir>/**/*.ci    call graph (-fcallgraph-info=su)
+
+The worst case stack of a root (an ISR, main, DB_printf) is its own frame
+plus the deepest chain of calls below it. A call that leaves the project
+(libc, an indirect call) has no frame to count, so that root is shown as
+at least its total. The nested worst case is main plus the deepest ISR at
+each interrupt priority, since only a higher priority ISR can interrupt
+another one.
+
+A flash figure for a module is its text plus its initialised data (the
+copy that data_init loads from), RAM is data plus bss.
+
+usage:
+    memory_report.py dist/default/production
+    memory_report.py --budget tools/memory_budget.json \\
+        --objdir build/default/production dist/default/production
+    memory_report.py --budget tools/memory_budget.json --update ...
+                        (rewrites the budget from this build)
+
+exits 1 if anything is over budget, 2 if the build outputs are missing
+"""
+
+import argparse
+import glob
+import json
+import os
+import re
+import struct
+import sys
+import xml.etree.ElementTree as ET
+
+# budget entries are rounded up to this by --update
+BUDGET_ROUNDING = 16
+
+ISR_PATTERN = re.compile(r'__ISR\s*\(\s*\w+\s*,\s*IPL(\d)\w*\s*\)\s*(\w+)')
+
+
+def round_up(value):
+    return (value + BUDGET_ROUNDING - 1) // BUDGET_ROUNDING * BUDGET_ROUNDING
+
+
+class LinkerMap:
+    """the module table & totals from the xc32-ld memory usage report"""
+
+    def __init__(self, path):
+        self.modules = {}
+        self.program_used = None
+        self.data_used = None
+        in_modules = False
+        with open(path, 'r', errors='replace') as f:
+            for line in f:
+                if 'Memory-Usage Report By Module' in line:
+                    in_modules = True
+                    continue
+                m = re.match(r'\s*Total Program Memory used\s*:\s*\S+\s+(\d+)',
+                             line)
+                if m:
+                    self.program_used = int(m.group(1))
+                m = re.match(r'\s*Total Data Memory used\s*:\s*\S+\s+(\d+)',
+                             line)
+                if m:
+                    self.data_used = int(m.group(1))
+                if not in_modules:
+                    continue
+                if self.modules and line.startswith('-----'):
+                    # the rule above the whole image's line
+                    in_modules = False
+                    continue
+                # text data bss dec hex basename filename, the basename and
+                # filename run together when the basename is long
+                m = re.match(r'\s*(\d+)\s+(\d+)\s+(\d+)\s+\d+\s+[0-9a-f]+\s+'
+                             r'(\S+)', line)
+                if m:
+                    text, data, bss = (int(m.group(i)) for i in (1, 2, 3))
+                    name = m.group(4).split('build/')[0]
+                    entry = self.modules.setdefault(name, [0, 0, 0])
+                    entry[0] += text
+                    entry[1] += data
+                    entry[2] += bss
+
+    def ram(self, name):
+        text, data, bss = self.modules[name]
+        return data + bss
+
+    def flash(self, name):
+        text, data, bss = self.modules[name]
+        return text + data
+
+
+class SymbolSizes:
+    """object symbols and their sizes from a little endian ELF32 file"""
+
+    def __init__(self, path):
+        self.sizes = {}
+        with open(path, 'rb') as f:
+            image = f.read()
+        if image[:4] != b'\x7fELF' or image[4] != 1 or image[5] != 1:
+            raise ValueError('%s is not a little endian ELF32 file' % path)
+        shoff, = struct.unpack_from('<I', image, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', image, 0x2e)
+        sections = [struct.unpack_from('<IIIIIIIIII', image,
+                                       shoff + i * shentsize)
+                    for i in range(shnum)]
+        for sec in sections:
+            if sec[1] != 2:         # SHT_SYMTAB
+                continue
+            strtab = sections[sec[6]]
+            for offset in range(sec[4], sec[4] + sec[5], sec[9]):
+                name, value, size, info = struct.unpack_from('<IIIB', image,
+                                                             offset)
+                if (info & 0xf) != 1 or size == 0:     # STT_OBJECT
+                    continue
+                start = strtab[4] + name
+                end = image.index(b'\0', start)
+                symbol = image[start:end].decode('latin-1')
+                # a static name can be in more than one module
+                self.sizes[symbol] = self.sizes.get(symbol, 0) + size
+
+
+class CallGraph:
+    """stack frames from the .su files & calls from the .ci files"""
+
+    def __init__(self, objdir):
+        self.frames = {}
+        self.dynamic = set()
+        self.calls = {}
+        for su in glob.glob(os.path.join(objdir, '**', '*.su'),
+                            recursive=True):
+            with open(su) as f:
+                for line in f:
+                    fields = line.rstrip('\n').split('\t')
+                    if len(fields) < 3:
+                        continue
+                    name = fields[0].rsplit(':', 1)[-1]
+                    self.frames[name] = max(self.frames.get(name, 0),
+                                            int(fields[1]))
+                    if 'dynamic' in fields[2]:
+                        self.dynamic.add(name)
+        edge = re.compile(r'edge:\s*\{\s*sourcename:\s*"([^"]+)"\s*'
+                          r'targetname:\s*"([^"]+)"')
+        for ci in glob.glob(os.path.join(objdir, '**', '*.ci'),
+                            recursive=True):
+            with open(ci) as f:
+                for m in edge.finditer(f.read()):
+                    # a static function is file:name, the .su files only
+                    # have the name
+                    caller, callee = (m.group(i).rsplit(':', 1)[-1]
+                                      for i in (1, 2))
+                    self.calls.setdefault(caller, set()).add(callee)
+
+    def worst_case(self, root):
+        """bytes, True if it is exact or False if it is only a lower bound"""
+        memo = {}
+
+        def depth(name, active):
+            if name in memo:
+                return memo[name]
+            if name not in self.frames or name in active:
+                # outside the project, or recursion
+                return 0, False
+            active.add(name)
+            deepest, exact = 0, name not in self.dynamic
+            for callee in self.calls.get(name, ()):
+                below, callee_exact = depth(callee, active)
+                deepest = max(deepest, below)
+                exact = exact and callee_exact
+            active.discard(name)
+            memo[name] = (self.frames[name] + deepest, exact)
+            return memo[name]
+
+        return depth(root, set())
+
+
+def find_isrs(source_dirs):
+    """{ISR name: priority} from the __ISR() definitions in the sources"""
+    isrs = {}
+    for source_dir in source_dirs:
+        for path in glob.glob(os.path.join(source_dir, '*.c')):
+            with open(path, errors='replace') as f:
+                for m in ISR_PATTERN.finditer(f.read()):
+                    isrs[m.group(2)] = int(m.group(1))
+    return isrs
+
+
+def read_memoryfile(path):
+    used = {}
+    root = ET.parse(path).getroot()
+    for memory in root.iter('memory'):
+        used[memory.get('name')] = (int(memory.findtext('used')),
+                                    int(memory.findtext('length')))
+    return used
+
+
+def find_output(dist, pattern):
+    matches = sorted(glob.glob(os.path.join(dist, pattern)))
+    return matches[0] if matches else None
+
+
+class Checker:
+    """prints a line per measurement & keeps track of what is over"""
+
+    def __init__(self, budget):
+        self.budget = budget
+        self.failures = []
+        self.measured = {}
+
+    def line(self, section, name, value, exact=True):
+        limit = self.budget.get(section, {}).get(name)
+        self.measured.setdefault(section, {})[name] = value
+        shown = ('%d' if exact else '>=%d') % value
+        if limit is None:
+            status = ''
+        elif value > limit:
+            status = 'OVER by %d' % (value - limit)
+            self.failures.append('%s %s: %d, budget %d'
+                                 % (section, name, value, limit))
+        else:
+            status = '%d left' % (limit - value)
+        print('  %-40s %8s %8s  %s' % (name, shown,
+                                       '-' if limit is None else limit,
+                                       status))
+
+    def heading(self, title):
+        print('\n%s\n  %-40s %8s %8s' % (title, '', 'bytes', 'budget'))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='RAM/flash/stack report & budget check for a build')
+    parser.add_argument('dist', help='directory holding the .map & .elf, '
+                        'e.g. dist/default/production')
+    parser.add_argument('--objdir', help='object directory with the .su & '
+                        '.ci files, e.g. build/default/production')
+    parser.add_argument('--budget', help='budget to check against')
+    parser.add_argument('--update', action='store_true',
+                        help='rewrite the budget file from this build')
+    parser.add_argument('--sources', nargs='*',
+                        default=['ProjectSource', 'FrameworkSource'],
+                        help='where to look for __ISR definitions')
+    args = parser.parse_args()
+
+    map_path = find_output(args.dist, '*.map')
+    if map_path is None:
+        print('memory_report: no .map in %s' % args.dist, file=sys.stderr)
+        return 2
+    budget = {}
+    if args.budget and os.path.exists(args.budget):
+        with open(args.budget) as f:
+            budget = json.load(f)
+    check = Checker(budget)
+    linker_map = LinkerMap(map_path)
+
+    check.heading('Totals (%s)' % os.path.basename(map_path))
+    if linker_map.program_used is not None:
+        check.line('totals', 'flash', linker_map.program_used)
+    if linker_map.data_used is not None:
+        check.line('totals', 'ram', linker_map.data_used)
+    memoryfile = os.path.join(args.dist, 'memoryfile.xml')
+    if os.path.exists(memoryfile):
+        for name, (used, length) in sorted(read_memoryfile(memoryfile).items()):
+            print('  %-40s %8d of %d (%.1f%%)' % ('memoryfile.xml ' + name,
+                                                 used, length,
+                                                 100.0 * used / length))
+
+    check.heading('RAM by module')
+    for name in sorted(linker_map.modules, key=linker_map.ram, reverse=True):
+        if linker_map.ram(name) or name in budget.get('module_ram', {}):
+            check.line('module_ram', name, linker_map.ram(name))
+
+    check.heading('Flash by module')
+    for name in sorted(linker_map.modules, key=linker_map.flash,
+                       reverse=True):
+        check.line('module_flash', name, linker_map.flash(name))
+
+    elf_path = find_output(args.dist, '*.elf')
+    if elf_path is not None:
+        symbols = SymbolSizes(elf_path)
+        check.heading('Named objects (%s)' % os.path.basename(elf_path))
+        for name in sorted(budget.get('objects', {})):
+            if name in symbols.sizes:
+                check.line('objects', name, symbols.sizes[name])
+            else:
+                print('  %-40s not in this build' % name)
+
+    if args.objdir:
+        graph = CallGraph(args.objdir)
+        if not graph.frames:
+            print('\nno .su files in %s, build with -fstack-usage '
+                  '-fcallgraph-info=su for the stack report' % args.objdir)
+        else:
+            isrs = find_isrs(args.sources)
+            check.heading('Worst case stack')
+            deepest_at = {}
+            roots = ['main'] + sorted(set(budget.get('stack', {})) - {'main'}
+                                      - set(isrs) - {'nested'})
+            for root in roots:
+                if root in graph.frames:
+                    check.line('stack', root, *graph.worst_case(root))
+            for isr in sorted(isrs, key=lambda n: (-isrs[n], n)):
+                if isr not in graph.frames:
+                    continue
+                used, exact = graph.worst_case(isr)
+                check.line('stack', isr, used, exact)
+                level = deepest_at.get(isrs[isr], (0, True))
+                if used > level[0]:
+                    deepest_at[isrs[isr]] = (used, exact and level[1])
+            if 'main' in graph.frames:
+                main_used, exact = graph.worst_case('main')
+                nested = main_used + sum(u for u, _ in deepest_at.values())
+                exact = exact and all(e for _, e in deepest_at.values())
+                check.line('stack', 'nested', nested, exact)
+
+    if args.update:
+        if not args.budget:
+            parser.error('--update needs --budget')
+        for section, values in check.measured.items():
+            # only the sections & names already budgeted, so the budget
+            # file stays the list of things worth watching
+            if section in budget:
+                for name in budget[section]:
+                    if name in values:
+                        budget[section][name] = round_up(values[name])
+        with open(args.budget, 'w') as f:
+            json.dump(budget, f, indent=2, sort_keys=True)
+            f.write('\n')
+        print('\nupdated %s' % args.budget)
+        return 0
+
+    if check.failures:
+        print('\nover budget:', file=sys.stderr)
+        for failure in check.failures:
+            print('  ' + failure, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())